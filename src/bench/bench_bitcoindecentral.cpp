@@ -4,7 +4,9 @@
 
 #include <bench/bench.h>
 #include <common/args.h>
+#include <crypto/mldsa.h>
 #include <crypto/sha256.h>
+#include <crypto/sha3.h>
 #include <tinyformat.h>
 #include <util/fs.h>
 #include <util/string.h>
@@ -79,6 +81,8 @@ int main(int argc, char** argv)
     ArgsManager argsman;
     SetupBenchArgs(argsman);
     SHA256AutoDetect();
+    MLDSAAutoDetect();
+    KeccakAutoDetect();
     std::string error;
     if (!argsman.ParseParameters(argc, argv, error)) {
         tfm::format(std::cerr, "Error parsing command line arguments: %s\n", error);
@@ -0,0 +1,70 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bip324.h>
+#include <net.h>
+#include <netmessagemaker.h>
+#include <protocol.h>
+#include <span.h>
+#include <test/util/setup_common.h>
+
+#include <cassert>
+#include <optional>
+
+/** Move all bytes from one transport to the other. Returns whether any were moved. */
+static bool Exchange(Transport& from, Transport& to)
+{
+    bool moved{false};
+    while (true) {
+        const auto& [to_send, more, m_type] = from.GetBytesToSend(/*have_next_message=*/false);
+        if (to_send.empty()) return moved;
+        Span<const uint8_t> bytes{to_send};
+        const size_t len{bytes.size()};
+        bool ok = to.ReceivedBytes(bytes);
+        assert(ok && bytes.empty());
+        from.MarkBytesSent(len);
+        moved = true;
+    }
+}
+
+/*
+ * Connection setup between two V2Transports, from creating them until each
+ * has received a first message, as paid for every new connection. With
+ * kem_key set, both take part in the hybrid ML-KEM handshake, with the
+ * responder's key taken ready-made from the pool; with generate_kem_key,
+ * the responder generates it on the connection path instead.
+ */
+static void BIP324Handshake(benchmark::Bench& bench, bool hybrid, bool generate_kem_key)
+{
+    const auto testing_setup = MakeNoLogFileContext<const BasicTestingSetup>();
+    const std::optional<BIP324KEMKey> pool_key{hybrid && !generate_kem_key ? std::optional{BIP324KEMKey::Generate()} : std::nullopt};
+
+    bench.batch(1).unit("handshake").run([&] {
+        V2Transport initiator{/*nodeid=*/0, /*initiating=*/true, hybrid};
+        V2Transport responder{/*nodeid=*/1, /*initiating=*/false, hybrid, pool_key};
+        bool initiator_sent{false}, responder_sent{false};
+        while (!initiator.ReceivedMessageComplete() || !responder.ReceivedMessageComplete()) {
+            if (!initiator_sent) {
+                auto msg = NetMsg::Make(NetMsgType::PING, uint64_t{0});
+                initiator_sent = initiator.SetMessageToSend(msg);
+            }
+            if (!responder_sent) {
+                auto msg = NetMsg::Make(NetMsgType::PING, uint64_t{1});
+                responder_sent = responder.SetMessageToSend(msg);
+            }
+            const bool sent_to_responder{Exchange(initiator, responder)};
+            const bool sent_to_initiator{Exchange(responder, initiator)};
+            assert(sent_to_responder || sent_to_initiator);
+        }
+    });
+}
+
+static void BIP324_HANDSHAKE(benchmark::Bench& bench) { BIP324Handshake(bench, /*hybrid=*/false, /*generate_kem_key=*/false); }
+static void BIP324_HANDSHAKE_HYBRID(benchmark::Bench& bench) { BIP324Handshake(bench, /*hybrid=*/true, /*generate_kem_key=*/false); }
+static void BIP324_HANDSHAKE_HYBRID_KEYGEN(benchmark::Bench& bench) { BIP324Handshake(bench, /*hybrid=*/true, /*generate_kem_key=*/true); }
+
+BENCHMARK(BIP324_HANDSHAKE, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BIP324_HANDSHAKE_HYBRID, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BIP324_HANDSHAKE_HYBRID_KEYGEN, benchmark::PriorityLevel::HIGH);
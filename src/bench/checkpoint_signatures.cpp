@@ -0,0 +1,71 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <consensus/hybrid.h>
+#include <key.h>
+#include <random.h>
+#include <uint256.h>
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <vector>
+
+using namespace consensus::hybrid;
+
+/*
+ * Cost of checking a checkpoint signed by the committee drawn from 100
+ * validators, which is drawing the committee and one Schnorr verification
+ * against the cached aggregate key.
+ */
+static void CheckpointSignatureVerify(benchmark::Bench& bench)
+{
+    ECC_Context ecc_context{};
+
+    const int validator_count = 100;
+    std::vector<CKey> keys;
+    ValidatorNetworkState state;
+    for (int i = 0; i < validator_count; ++i) {
+        const CKey& key = keys.emplace_back(GenerateRandomKey());
+        const XOnlyPubKey xonly{key.GetPubKey()};
+        uint256 public_key;
+        std::copy(xonly.begin(), xonly.end(), public_key.begin());
+        const uint256 validator_id = Hash(public_key);
+        RegisterValidator(validator_id, public_key, params::MIN_VALIDATOR_STAKE, state);
+        ActivateValidator(validator_id, state);
+    }
+
+    CheckpointInfo checkpoint;
+    checkpoint.height = params::CHECKPOINT_INTERVAL;
+    checkpoint.block_hash = GetRandHash();
+    checkpoint.checkpoint_hash = GetRandHash();
+    checkpoint.signer_bitmap = GetCheckpointSignerBitmap(state, checkpoint.height, checkpoint.block_hash);
+    const auto signer_keys = GetCheckpointSignerKeys(checkpoint.signer_bitmap, state);
+    assert(signer_keys && signer_keys->size() == params::MIN_VALIDATORS_FOR_CONSENSUS);
+
+    std::vector<std::unique_ptr<CheckpointSigningSession>> sessions;
+    std::vector<CheckpointNonce> nonces;
+    for (const XOnlyPubKey& signer_key : *signer_keys) {
+        for (const CKey& key : keys) {
+            if (XOnlyPubKey{key.GetPubKey()} != signer_key) continue;
+            sessions.push_back(std::make_unique<CheckpointSigningSession>(key, checkpoint.checkpoint_hash, *signer_keys));
+            nonces.push_back(sessions.back()->GetNonce());
+        }
+    }
+    std::vector<CheckpointPartialSignature> partial_signatures;
+    for (auto& session : sessions) {
+        partial_signatures.push_back(*session->Sign(*signer_keys, nonces));
+    }
+    const bool aggregated = AggregateCheckpointSignature(checkpoint.checkpoint_hash, *signer_keys, nonces,
+                                                         partial_signatures, checkpoint.signature);
+    assert(aggregated);
+
+    bench.run([&] {
+        const bool valid = ValidateCheckpointSignatures(checkpoint, state);
+        assert(valid);
+    });
+}
+
+BENCHMARK(CheckpointSignatureVerify, benchmark::PriorityLevel::HIGH);
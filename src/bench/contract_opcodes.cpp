@@ -0,0 +1,146 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <key.h>
+#include <random.h>
+#include <smartcontracts/analysis.h>
+#include <smartcontracts/vm.h>
+#include <uint256.h>
+
+#include <cassert>
+#include <vector>
+
+using namespace smartcontracts;
+
+/*
+ * Each benchmark executes a contract that repeats one opcode, and reports the
+ * time per unit of gas charged. With a well calibrated gas schedule every
+ * opcode costs about the same number of nanoseconds per gas; an opcode that
+ * is much slower per gas than the others is underpriced.
+ */
+
+static void PushWord(std::vector<uint8_t>& code, const uint256& word)
+{
+    code.push_back(32);
+    code.insert(code.end(), word.begin(), word.end());
+}
+
+static void PushByte(std::vector<uint8_t>& code, uint8_t value)
+{
+    code.push_back(1);
+    code.push_back(value);
+}
+
+/**
+ * Execute the code as the contract at address one. With reset_state, the
+ * contract is restored to its empty state before each run, so the runs of
+ * code that writes storage do not build on each other.
+ */
+static void RunContract(benchmark::Bench& bench, const std::vector<uint8_t>& code, bool reset_state = false)
+{
+    ContractState state;
+    state.contract_address = uint256::ONE;
+    state.code = code;
+    UpdateContractState(state.contract_address, state);
+
+    const auto analysis = AnalyzeContractCode(code, vm::VM_TYPE_BITCOIN_SCRIPT);
+    assert(analysis->valid);
+
+    ExecutionContext context;
+    context.contract_address = state.contract_address;
+    context.gas_limit = vm::MAX_GAS_LIMIT;
+
+    const uint64_t gas = ExecuteEnhancedScript(*analysis, context).gas_used;
+    assert(gas > 0);
+    bench.batch(gas).unit("gas").run([&] {
+        if (reset_state) UpdateContractState(state.contract_address, state);
+        const ExecutionResult result = ExecuteEnhancedScript(*analysis, context);
+        assert(result.result_code == CONTRACT_SUCCESS);
+    });
+}
+
+static void ContractOpPush(benchmark::Bench& bench)
+{
+    // Pushes are the baseline: they do no work besides dispatch
+    std::vector<uint8_t> code;
+    for (int i = 0; i < 1000; ++i) PushByte(code, i);
+    RunContract(bench, code);
+}
+
+static void ContractOpAddMod(benchmark::Bench& bench)
+{
+    // Moduli with the top bit set, so operand reduction takes at most one step
+    std::vector<uint8_t> code;
+    PushWord(code, GetRandHash());
+    for (int i = 0; i < 300; ++i) {
+        uint256 n = GetRandHash();
+        n.data()[31] |= 0x80;
+        PushWord(code, GetRandHash());
+        PushWord(code, n);
+        code.push_back(OP_ADDMOD);
+    }
+    RunContract(bench, code);
+}
+
+static void ContractOpKeccak256(benchmark::Bench& bench)
+{
+    std::vector<uint8_t> code;
+    PushWord(code, GetRandHash());
+    code.insert(code.end(), 1000, OP_KECCAK256);
+    RunContract(bench, code);
+}
+
+static void ContractOpEcrecover(benchmark::Bench& bench)
+{
+    ECC_Context ecc_context{};
+
+    std::vector<uint8_t> code;
+    for (int i = 0; i < 10; ++i) {
+        const CKey key = GenerateRandomKey();
+        const uint256 hash = GetRandHash();
+        std::vector<unsigned char> sig;
+        assert(key.SignCompact(hash, sig));
+
+        uint256 r, s;
+        std::copy(sig.begin() + 1, sig.begin() + 33, r.begin());
+        std::copy(sig.begin() + 33, sig.end(), s.begin());
+        PushWord(code, hash);
+        PushByte(code, (sig[0] - 27) & 3);
+        PushWord(code, r);
+        PushWord(code, s);
+        code.push_back(OP_ECRECOVER);
+    }
+    RunContract(bench, code);
+}
+
+static void ContractOpSload(benchmark::Bench& bench)
+{
+    // Each loaded value is the key of the next load
+    std::vector<uint8_t> code;
+    PushByte(code, 1);
+    code.insert(code.end(), 1000, OP_SLOAD);
+    RunContract(bench, code);
+}
+
+static void ContractOpSstore(benchmark::Bench& bench)
+{
+    // Every run inserts the same 300 slots into empty storage, far below the
+    // contract's storage limit, so no store is rejected
+    std::vector<uint8_t> code;
+    for (int i = 0; i < 300; ++i) {
+        PushWord(code, GetRandHash());
+        PushWord(code, GetRandHash());
+        code.push_back(OP_SSTORE);
+    }
+    RunContract(bench, code, /*reset_state=*/true);
+    assert(GetContractState(uint256::ONE).storage.size() == 300);
+}
+
+BENCHMARK(ContractOpPush, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ContractOpAddMod, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ContractOpKeccak256, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ContractOpEcrecover, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ContractOpSload, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ContractOpSstore, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,44 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <random.h>
+#include <smartcontracts/statetree.h>
+#include <uint256.h>
+
+#include <vector>
+
+using smartcontracts::StateTree;
+
+/*
+ * Cost of bringing a large tree up to date after a block's worth of writes,
+ * which should grow with the number of writes and only logarithmically with
+ * the size of the tree.
+ */
+static void StateTreeUpdate(benchmark::Bench& bench, size_t tree_size, size_t writes)
+{
+    FastRandomContext rng{/*fDeterministic=*/true};
+
+    std::vector<StateTree::Update> initial;
+    for (size_t i = 0; i < tree_size; ++i) {
+        initial.emplace_back(rng.rand256(), rng.rand256());
+    }
+    StateTree tree;
+    tree.Apply(initial);
+
+    std::vector<StateTree::Update> updates(writes);
+    bench.batch(writes).unit("write").run([&] {
+        for (auto& [key, value] : updates) {
+            key = initial[rng.randrange(initial.size())].first;
+            value = rng.rand256();
+        }
+        tree.Apply(updates);
+    });
+}
+
+static void StateTreeUpdate1kOf100k(benchmark::Bench& bench) { StateTreeUpdate(bench, 100000, 1000); }
+static void StateTreeUpdate10Of100k(benchmark::Bench& bench) { StateTreeUpdate(bench, 100000, 10); }
+
+BENCHMARK(StateTreeUpdate1kOf100k, benchmark::PriorityLevel::HIGH);
+BENCHMARK(StateTreeUpdate10Of100k, benchmark::PriorityLevel::HIGH);
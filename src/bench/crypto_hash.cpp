@@ -93,6 +93,95 @@ static void SHA3_256_1M(benchmark::Bench& bench)
     });
 }
 
+static void KECCAK256_32b(benchmark::Bench& bench)
+{
+    std::vector<uint8_t> in(32,0);
+    bench.batch(in.size()).unit("byte").run([&] {
+        Keccak256().Write(in).Finalize(in);
+    });
+}
+
+static void KECCAK256_MANY_32b(benchmark::Bench& bench)
+{
+    std::vector<uint8_t> in(32 * 64,0);
+    std::vector<Span<const uint8_t>> inputs;
+    for (size_t i = 0; i < 64; ++i) inputs.emplace_back(Span{in}.subspan(32 * i, 32));
+    std::vector<uint8_t> out(32 * 64);
+    bench.batch(in.size()).unit("byte").run([&] {
+        Keccak256Many(out.data(), inputs);
+    });
+}
+
+static void SHA3_512_1M(benchmark::Bench& bench)
+{
+    uint8_t hash[SHA3_512::OUTPUT_SIZE];
+    std::vector<uint8_t> in(BUFFER_SIZE,0);
+    bench.batch(in.size()).unit("byte").run([&] {
+        SHA3_512().Write(in).Finalize(hash);
+    });
+}
+
+static void SHAKE128_1M(benchmark::Bench& bench)
+{
+    uint8_t hash[32];
+    std::vector<uint8_t> in(BUFFER_SIZE,0);
+    bench.batch(in.size()).unit("byte").run([&] {
+        SHAKE128().Write(in).Read(hash);
+    });
+}
+
+static void SHAKE256_1M(benchmark::Bench& bench)
+{
+    uint8_t hash[64];
+    std::vector<uint8_t> in(BUFFER_SIZE,0);
+    bench.batch(in.size()).unit("byte").run([&] {
+        SHAKE256().Write(in).Read(hash);
+    });
+}
+
+static void SHAKE128_READ_1M(benchmark::Bench& bench)
+{
+    std::vector<uint8_t> out(BUFFER_SIZE,0);
+    bench.batch(out.size()).unit("byte").run([&] {
+        SHAKE128().Write(Span{out}.first(32)).Read(out);
+    });
+}
+
+static void KeccakF4Way(benchmark::Bench& bench, const char* name, keccak_implementation::UseImplementation use_implementation)
+{
+    bench.name(strprintf("%s using the '%s' Keccak implementation", name, KeccakAutoDetect(use_implementation)));
+    uint64_t st[25][KECCAK_WAYS] = {};
+    bench.batch(KECCAK_WAYS).unit("permutation").run([&] {
+        KeccakF_4way(st);
+    });
+    KeccakAutoDetect();
+}
+
+static void KECCAKF_4WAY_STANDARD(benchmark::Bench& bench) { KeccakF4Way(bench, __func__, keccak_implementation::STANDARD); }
+static void KECCAKF_4WAY_AVX2(benchmark::Bench& bench) { KeccakF4Way(bench, __func__, keccak_implementation::USE_AVX2); }
+
+/** ML-DSA-65's public matrix: 30 seeds of 34 bytes, each expanded to 840 bytes of SHAKE128 */
+static void SHAKE128ManyMatrix(benchmark::Bench& bench, const char* name, keccak_implementation::UseImplementation use_implementation)
+{
+    bench.name(strprintf("%s using the '%s' Keccak implementation", name, KeccakAutoDetect(use_implementation)));
+    constexpr size_t COUNT = 30, IN_SIZE = 34, OUT_SIZE = 840;
+    std::vector<uint8_t> in(IN_SIZE * COUNT,0), out(OUT_SIZE * COUNT);
+    std::vector<Span<const uint8_t>> inputs;
+    std::vector<Span<uint8_t>> outputs;
+    for (size_t i = 0; i < COUNT; ++i) {
+        in[IN_SIZE * i] = i;
+        inputs.emplace_back(Span{in}.subspan(IN_SIZE * i, IN_SIZE));
+        outputs.emplace_back(Span{out}.subspan(OUT_SIZE * i, OUT_SIZE));
+    }
+    bench.batch(out.size()).unit("byte").run([&] {
+        SHAKE128Many(inputs, outputs);
+    });
+    KeccakAutoDetect();
+}
+
+static void SHAKE128_MANY_MATRIX_STANDARD(benchmark::Bench& bench) { SHAKE128ManyMatrix(bench, __func__, keccak_implementation::STANDARD); }
+static void SHAKE128_MANY_MATRIX_AVX2(benchmark::Bench& bench) { SHAKE128ManyMatrix(bench, __func__, keccak_implementation::USE_AVX2); }
+
 static void SHA256_32b_STANDARD(benchmark::Bench& bench)
 {
     bench.name(strprintf("%s using the '%s' SHA256 implementation", __func__, SHA256AutoDetect(sha256_implementation::STANDARD)));
@@ -270,6 +359,16 @@ BENCHMARK(SHA256_AVX2, benchmark::PriorityLevel::HIGH);
 BENCHMARK(SHA256_SHANI, benchmark::PriorityLevel::HIGH);
 BENCHMARK(SHA512, benchmark::PriorityLevel::HIGH);
 BENCHMARK(SHA3_256_1M, benchmark::PriorityLevel::HIGH);
+BENCHMARK(KECCAK256_32b, benchmark::PriorityLevel::HIGH);
+BENCHMARK(KECCAK256_MANY_32b, benchmark::PriorityLevel::HIGH);
+BENCHMARK(SHA3_512_1M, benchmark::PriorityLevel::HIGH);
+BENCHMARK(SHAKE128_1M, benchmark::PriorityLevel::HIGH);
+BENCHMARK(SHAKE256_1M, benchmark::PriorityLevel::HIGH);
+BENCHMARK(SHAKE128_READ_1M, benchmark::PriorityLevel::HIGH);
+BENCHMARK(KECCAKF_4WAY_STANDARD, benchmark::PriorityLevel::HIGH);
+BENCHMARK(KECCAKF_4WAY_AVX2, benchmark::PriorityLevel::HIGH);
+BENCHMARK(SHAKE128_MANY_MATRIX_STANDARD, benchmark::PriorityLevel::HIGH);
+BENCHMARK(SHAKE128_MANY_MATRIX_AVX2, benchmark::PriorityLevel::HIGH);
 
 BENCHMARK(SHA256_32b_STANDARD, benchmark::PriorityLevel::HIGH);
 BENCHMARK(SHA256_32b_SSE4, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,36 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <key.h>
+#include <random.h>
+#include <smartcontracts/vm.h>
+#include <uint256.h>
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+static void ECRecover(benchmark::Bench& bench)
+{
+    ECC_Context ecc_context{};
+
+    CKey key = GenerateRandomKey();
+    uint256 hash = GetRandHash();
+    std::vector<unsigned char> sig;
+    assert(key.SignCompact(hash, sig));
+
+    uint256 v, r, s, address;
+    // Header byte is 27 + recid, plus 4 for a compressed key
+    v.data()[0] = (sig[0] - 27) & 3;
+    std::copy(sig.begin() + 1, sig.begin() + 33, r.begin());
+    std::copy(sig.begin() + 33, sig.end(), s.begin());
+
+    bench.run([&] {
+        bool ok = smartcontracts::RecoverSignerAddress(hash, v, r, s, address);
+        assert(ok);
+    });
+}
+
+BENCHMARK(ECRecover, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,59 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <interop/mmr.h>
+#include <random.h>
+#include <uint256.h>
+
+#include <cassert>
+#include <vector>
+
+using interop::MerkleMountainRange;
+
+/*
+ * Proving and verifying a relayer's batch of packets in a long channel
+ * history, which should grow with the batch and only logarithmically with
+ * the history.
+ */
+static void CommitmentProofs(benchmark::Bench& bench, size_t history, size_t batch, bool verify)
+{
+    FastRandomContext rng{/*fDeterministic=*/true};
+
+    MerkleMountainRange mmr;
+    std::vector<uint256> leaves;
+    for (size_t i = 0; i < history; ++i) {
+        leaves.push_back(rng.rand256());
+        mmr.Append(leaves.back());
+    }
+    const uint256 root = mmr.GetRoot();
+
+    // The most recent packets, as relayed after each block
+    std::vector<uint64_t> indices;
+    std::vector<uint256> proven;
+    for (size_t i = history - batch; i < history; ++i) {
+        indices.push_back(i);
+        proven.push_back(leaves[i]);
+    }
+    const auto proof = mmr.Prove(indices, history);
+    assert(proof);
+
+    bench.batch(batch).unit("packet").run([&] {
+        if (verify) {
+            const bool valid = VerifyMMRProof(root, *proof, proven);
+            assert(valid);
+        } else {
+            const auto batch_proof = mmr.Prove(indices, history);
+            assert(batch_proof);
+        }
+    });
+}
+
+static void CommitmentProve1kOf1M(benchmark::Bench& bench) { CommitmentProofs(bench, 1000000, 1000, /*verify=*/false); }
+static void CommitmentVerify1kOf1M(benchmark::Bench& bench) { CommitmentProofs(bench, 1000000, 1000, /*verify=*/true); }
+static void CommitmentVerify1Of1M(benchmark::Bench& bench) { CommitmentProofs(bench, 1000000, 1, /*verify=*/true); }
+
+BENCHMARK(CommitmentProve1kOf1M, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CommitmentVerify1kOf1M, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CommitmentVerify1Of1M, benchmark::PriorityLevel::HIGH);
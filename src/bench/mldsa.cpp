@@ -0,0 +1,63 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <crypto/mldsa.h>
+#include <random.h>
+#include <tinyformat.h>
+
+#include <cassert>
+#include <vector>
+
+using mldsa::ParameterSet;
+
+static void MLDSA(benchmark::Bench& bench, const char* name, ParameterSet params, mldsa_implementation::UseImplementation use_implementation, bool verify)
+{
+    bench.name(strprintf("%s using the '%s' ML-DSA implementation", name, MLDSAAutoDetect(use_implementation)));
+    FastRandomContext rng{/*fDeterministic=*/true};
+    std::vector<unsigned char> public_key(mldsa::PublicKeySize(params)), secret_key(mldsa::SecretKeySize(params));
+    bool ok = mldsa::KeyGen(params, rng.randbytes(mldsa::SEED_SIZE), public_key, secret_key);
+    assert(ok);
+    const std::vector<unsigned char> message = rng.randbytes(32);
+    const std::vector<unsigned char> rnd(mldsa::RND_SIZE);
+    std::vector<unsigned char> signature(mldsa::SignatureSize(params));
+    ok = mldsa::Sign(params, secret_key, message, {}, rnd, signature);
+    assert(ok);
+
+    bench.run([&] {
+        if (verify) {
+            ok = mldsa::Verify(params, public_key, message, {}, signature);
+        } else {
+            ok = mldsa::Sign(params, secret_key, message, {}, rnd, signature);
+        }
+        assert(ok);
+    });
+    MLDSAAutoDetect();
+}
+
+static void MLDSA44_SIGN_STANDARD(benchmark::Bench& bench) { MLDSA(bench, __func__, ParameterSet::ML_DSA_44, mldsa_implementation::STANDARD, /*verify=*/false); }
+static void MLDSA44_SIGN_AVX2(benchmark::Bench& bench) { MLDSA(bench, __func__, ParameterSet::ML_DSA_44, mldsa_implementation::USE_AVX2, /*verify=*/false); }
+static void MLDSA44_VERIFY_STANDARD(benchmark::Bench& bench) { MLDSA(bench, __func__, ParameterSet::ML_DSA_44, mldsa_implementation::STANDARD, /*verify=*/true); }
+static void MLDSA44_VERIFY_AVX2(benchmark::Bench& bench) { MLDSA(bench, __func__, ParameterSet::ML_DSA_44, mldsa_implementation::USE_AVX2, /*verify=*/true); }
+static void MLDSA65_SIGN_STANDARD(benchmark::Bench& bench) { MLDSA(bench, __func__, ParameterSet::ML_DSA_65, mldsa_implementation::STANDARD, /*verify=*/false); }
+static void MLDSA65_SIGN_AVX2(benchmark::Bench& bench) { MLDSA(bench, __func__, ParameterSet::ML_DSA_65, mldsa_implementation::USE_AVX2, /*verify=*/false); }
+static void MLDSA65_VERIFY_STANDARD(benchmark::Bench& bench) { MLDSA(bench, __func__, ParameterSet::ML_DSA_65, mldsa_implementation::STANDARD, /*verify=*/true); }
+static void MLDSA65_VERIFY_AVX2(benchmark::Bench& bench) { MLDSA(bench, __func__, ParameterSet::ML_DSA_65, mldsa_implementation::USE_AVX2, /*verify=*/true); }
+static void MLDSA87_SIGN_STANDARD(benchmark::Bench& bench) { MLDSA(bench, __func__, ParameterSet::ML_DSA_87, mldsa_implementation::STANDARD, /*verify=*/false); }
+static void MLDSA87_SIGN_AVX2(benchmark::Bench& bench) { MLDSA(bench, __func__, ParameterSet::ML_DSA_87, mldsa_implementation::USE_AVX2, /*verify=*/false); }
+static void MLDSA87_VERIFY_STANDARD(benchmark::Bench& bench) { MLDSA(bench, __func__, ParameterSet::ML_DSA_87, mldsa_implementation::STANDARD, /*verify=*/true); }
+static void MLDSA87_VERIFY_AVX2(benchmark::Bench& bench) { MLDSA(bench, __func__, ParameterSet::ML_DSA_87, mldsa_implementation::USE_AVX2, /*verify=*/true); }
+
+BENCHMARK(MLDSA44_SIGN_STANDARD, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MLDSA44_SIGN_AVX2, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MLDSA44_VERIFY_STANDARD, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MLDSA44_VERIFY_AVX2, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MLDSA65_SIGN_STANDARD, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MLDSA65_SIGN_AVX2, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MLDSA65_VERIFY_STANDARD, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MLDSA65_VERIFY_AVX2, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MLDSA87_SIGN_STANDARD, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MLDSA87_SIGN_AVX2, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MLDSA87_VERIFY_STANDARD, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MLDSA87_VERIFY_AVX2, benchmark::PriorityLevel::HIGH);
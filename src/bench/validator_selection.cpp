@@ -0,0 +1,67 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <consensus/hybrid.h>
+#include <random.h>
+#include <uint256.h>
+
+#include <vector>
+
+using namespace consensus::hybrid;
+
+static ValidatorNetworkState MakeValidatorState(FastRandomContext& rng, size_t validator_count)
+{
+    // Fill the state directly, as activation is capped at MAX_ACTIVE_VALIDATORS
+    ValidatorNetworkState state;
+    for (size_t i = 0; i < validator_count; ++i) {
+        ValidatorInfo& validator = state.active_validators[rng.rand256()];
+        validator.is_active = true;
+        validator.stake_amount = params::MIN_VALIDATOR_STAKE + rng.randrange(params::MIN_VALIDATOR_STAKE);
+    }
+    return state;
+}
+
+/*
+ * Cost of drawing a checkpoint's validators, which should grow only
+ * logarithmically with the number of validators.
+ */
+static void ValidatorSelect(benchmark::Bench& bench, size_t validator_count)
+{
+    FastRandomContext rng{/*fDeterministic=*/true};
+    ValidatorSampler sampler{MakeValidatorState(rng, validator_count)};
+
+    bench.run([&] {
+        const auto selected = sampler.Select(rng.rand256(), params::MIN_VALIDATORS_FOR_CONSENSUS);
+        ankerl::nanobench::doNotOptimizeAway(selected);
+    });
+}
+
+/*
+ * Cost of a stake change, without rebuilding the sampler.
+ */
+static void ValidatorStakeUpdate(benchmark::Bench& bench, size_t validator_count)
+{
+    FastRandomContext rng{/*fDeterministic=*/true};
+    const ValidatorNetworkState state{MakeValidatorState(rng, validator_count)};
+    std::vector<uint256> ids;
+    for (const auto& [validator_id, validator] : state.active_validators) {
+        ids.push_back(validator_id);
+    }
+    ValidatorSampler sampler{state};
+
+    bench.run([&] {
+        sampler.Update(ids[rng.randrange(ids.size())], params::MIN_VALIDATOR_STAKE + rng.randrange(params::MIN_VALIDATOR_STAKE));
+    });
+}
+
+static void ValidatorSelect100(benchmark::Bench& bench) { ValidatorSelect(bench, 100); }
+static void ValidatorSelect10k(benchmark::Bench& bench) { ValidatorSelect(bench, 10000); }
+static void ValidatorSelect100k(benchmark::Bench& bench) { ValidatorSelect(bench, 100000); }
+static void ValidatorStakeUpdate100k(benchmark::Bench& bench) { ValidatorStakeUpdate(bench, 100000); }
+
+BENCHMARK(ValidatorSelect100, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ValidatorSelect10k, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ValidatorSelect100k, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ValidatorStakeUpdate100k, benchmark::PriorityLevel::HIGH);
@@ -3,12 +3,15 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <bench/bench.h>
+#include <crypto/mldsa.h>
+#include <crypto/sha256.h>
 #include <hash.h>
 #include <key.h>
 #include <primitives/transaction.h>
 #include <pubkey.h>
 #include <script/interpreter.h>
 #include <script/script.h>
+#include <script/sigcache.h>
 #include <span.h>
 #include <test/util/transaction_utils.h>
 #include <uint256.h>
@@ -66,6 +69,72 @@ static void VerifyScriptBench(benchmark::Bench& bench)
     });
 }
 
+// Verification of a transaction spending witness v2 outputs with ML-DSA-44
+// signatures, per input. The inputs share the transaction's precomputed data,
+// as they do in block validation. With cached set, every signature is already
+// in the signature cache, as for a transaction accepted to the mempool first.
+static void VerifyQuantumScript(benchmark::Bench& bench, bool cached)
+{
+    const mldsa::ParameterSet params{mldsa::ParameterSet::ML_DSA_44};
+    const uint32_t flags{SCRIPT_VERIFY_WITNESS | SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_TAPROOT | SCRIPT_VERIFY_QUANTUM};
+    constexpr size_t NUM_INPUTS{8};
+
+    std::vector<unsigned char> pubkey(mldsa::PublicKeySize(params)), secret_key(mldsa::SecretKeySize(params));
+    const std::vector<unsigned char> seed(mldsa::SEED_SIZE, 1);
+    mldsa::KeyGen(params, seed, pubkey, secret_key);
+    uint256 program;
+    CSHA256().Write(pubkey.data(), pubkey.size()).Finalize(program.begin());
+
+    CMutableTransaction txSpend;
+    std::vector<CTxOut> spent_outputs;
+    for (size_t i = 0; i < NUM_INPUTS; ++i) {
+        txSpend.vin.emplace_back(COutPoint{Txid::FromUint256(uint256::ONE), static_cast<uint32_t>(i)});
+        spent_outputs.emplace_back(1, CScript() << OP_2 << ToByteVector(program));
+    }
+    txSpend.vout.emplace_back(NUM_INPUTS, CScript() << OP_TRUE);
+
+    PrecomputedTransactionData sign_txdata;
+    sign_txdata.Init(txSpend, std::vector<CTxOut>{spent_outputs}, /*force=*/true);
+    for (size_t i = 0; i < NUM_INPUTS; ++i) {
+        ScriptExecutionData execdata;
+        execdata.m_annex_init = true;
+        execdata.m_annex_present = false;
+        uint256 sighash;
+        SignatureHashSchnorr(sighash, execdata, txSpend, i, SIGHASH_DEFAULT, SigVersion::QUANTUM, sign_txdata, MissingDataBehavior::ASSERT_FAIL);
+        std::vector<unsigned char> sig(mldsa::SignatureSize(params));
+        mldsa::Sign(params, secret_key, sighash, {}, std::vector<unsigned char>(mldsa::RND_SIZE), sig);
+        txSpend.vin[i].scriptWitness.stack = {sig, pubkey};
+    }
+    const CTransaction tx{txSpend};
+    PrecomputedTransactionData txdata;
+    txdata.Init(tx, std::move(spent_outputs));
+
+    SignatureCache signature_cache{DEFAULT_SIGNATURE_CACHE_BYTES};
+    const auto verify_input = [&](size_t i, bool store) {
+        ScriptError err;
+        bool success = VerifyScript(
+            tx.vin[i].scriptSig,
+            txdata.m_spent_outputs[i].scriptPubKey,
+            &tx.vin[i].scriptWitness,
+            flags,
+            CachingTransactionSignatureChecker(&tx, i, txdata.m_spent_outputs[i].nValue, store, signature_cache, txdata),
+            &err);
+        assert(err == SCRIPT_ERR_OK);
+        assert(success);
+    };
+    if (cached) {
+        for (size_t i = 0; i < NUM_INPUTS; ++i) verify_input(i, /*store=*/true);
+    }
+
+    // Benchmark.
+    bench.batch(NUM_INPUTS).unit("input").run([&] {
+        for (size_t i = 0; i < NUM_INPUTS; ++i) verify_input(i, /*store=*/false);
+    });
+}
+
+static void VerifyQuantumScriptBench(benchmark::Bench& bench) { VerifyQuantumScript(bench, /*cached=*/false); }
+static void VerifyQuantumScriptCachedBench(benchmark::Bench& bench) { VerifyQuantumScript(bench, /*cached=*/true); }
+
 static void VerifyNestedIfScript(benchmark::Bench& bench)
 {
     std::vector<std::vector<unsigned char>> stack;
@@ -88,4 +157,6 @@ static void VerifyNestedIfScript(benchmark::Bench& bench)
 }
 
 BENCHMARK(VerifyScriptBench, benchmark::PriorityLevel::HIGH);
+BENCHMARK(VerifyQuantumScriptBench, benchmark::PriorityLevel::HIGH);
+BENCHMARK(VerifyQuantumScriptCachedBench, benchmark::PriorityLevel::HIGH);
 BENCHMARK(VerifyNestedIfScript, benchmark::PriorityLevel::HIGH);
@@ -8,6 +8,7 @@
 #include <crypto/chacha20.h>
 #include <crypto/chacha20poly1305.h>
 #include <crypto/hkdf_sha256_32.h>
+#include <crypto/mlkem.h>
 #include <key.h>
 #include <pubkey.h>
 #include <random.h>
@@ -22,6 +23,27 @@
 #include <iterator>
 #include <string>
 
+namespace {
+
+constexpr mlkem::ParameterSet KEM_PARAMS{mlkem::ParameterSet::ML_KEM_768};
+
+} // namespace
+
+BIP324KEMKey BIP324KEMKey::Generate() noexcept
+{
+    BIP324KEMKey kem_key;
+    kem_key.encaps_key.resize(BIP324Cipher::KEM_ENCAPS_KEY_LEN);
+    kem_key.decaps_key.resize(BIP324Cipher::KEM_DECAPS_KEY_LEN);
+    // GetStrongRandBytes gives at most 32 bytes at a time
+    std::array<unsigned char, mlkem::SEED_SIZE> seed;
+    GetStrongRandBytes(Span{seed}.first(32));
+    GetStrongRandBytes(Span{seed}.last(32));
+    bool ret = mlkem::KeyGen(KEM_PARAMS, seed, kem_key.encaps_key, kem_key.decaps_key);
+    assert(ret);
+    memory_cleanse(seed.data(), seed.size());
+    return kem_key;
+}
+
 BIP324Cipher::BIP324Cipher(const CKey& key, Span<const std::byte> ent32) noexcept :
     m_key(key)
 {
@@ -63,6 +85,9 @@ void BIP324Cipher::Initialize(const EllSwiftPubKey& their_pubkey, bool initiator
     // Derive session id from shared secret.
     hkdf.Expand32("session_id", UCharCast(m_session_id.data()));
 
+    // Derive the key to mix an ML-KEM secret with, should the hybrid handshake follow.
+    hkdf.Expand32("hybrid_key", UCharCast(m_hybrid_key.emplace().data()));
+
     // Wipe all variables that contain information which could be used to re-derive encryption keys.
     memory_cleanse(ecdh_secret.data(), ecdh_secret.size());
     memory_cleanse(hkdf_32_okm.data(), sizeof(hkdf_32_okm));
@@ -70,6 +95,85 @@ void BIP324Cipher::Initialize(const EllSwiftPubKey& their_pubkey, bool initiator
     m_key = CKey();
 }
 
+void BIP324Cipher::MixKEMSecret(Span<const std::byte> kem_secret, bool initiator, bool self_decrypt) noexcept
+{
+    assert(m_hybrid_key);
+    const auto& message_header = Params().MessageStart();
+    std::string salt = std::string{"bitcoin_v2_hybrid_shared_secret"} + std::string(std::begin(message_header), std::end(message_header));
+
+    // Both secrets go into the key material, so the packet keys stay secret as long as either does.
+    std::array<std::byte, 64> ikm;
+    std::copy(m_hybrid_key->begin(), m_hybrid_key->end(), ikm.begin());
+    std::copy(kem_secret.begin(), kem_secret.end(), ikm.begin() + m_hybrid_key->size());
+    CHKDF_HMAC_SHA256_L32 hkdf(UCharCast(ikm.data()), ikm.size(), salt);
+
+    bool side = (initiator != self_decrypt);
+    auto& initiator_keys = side ? m_pending_send_keys.emplace() : m_pending_recv_keys.emplace();
+    auto& responder_keys = side ? m_pending_recv_keys.emplace() : m_pending_send_keys.emplace();
+    hkdf.Expand32("initiator_L", UCharCast(initiator_keys.l_key.data()));
+    hkdf.Expand32("initiator_P", UCharCast(initiator_keys.p_key.data()));
+    hkdf.Expand32("responder_L", UCharCast(responder_keys.l_key.data()));
+    hkdf.Expand32("responder_P", UCharCast(responder_keys.p_key.data()));
+
+    memory_cleanse(ikm.data(), ikm.size());
+    memory_cleanse(&hkdf, sizeof(hkdf));
+    WipeHybridKey();
+}
+
+bool BIP324Cipher::Encapsulate(Span<const std::byte> encaps_key, Span<std::byte> ciphertext, bool initiator, bool self_decrypt) noexcept
+{
+    assert(ciphertext.size() == KEM_CIPHERTEXT_LEN);
+
+    std::array<unsigned char, mlkem::ENCAPS_SEED_SIZE> m;
+    std::array<std::byte, mlkem::SHARED_SECRET_SIZE> kem_secret;
+    GetStrongRandBytes(m);
+    bool ret = mlkem::Encaps(KEM_PARAMS, MakeUCharSpan(encaps_key), m, MakeUCharSpan(ciphertext), MakeUCharSpan(kem_secret));
+    if (ret) MixKEMSecret(kem_secret, initiator, self_decrypt);
+
+    memory_cleanse(m.data(), m.size());
+    memory_cleanse(kem_secret.data(), kem_secret.size());
+    return ret;
+}
+
+void BIP324Cipher::Decapsulate(const BIP324KEMKey& kem_key, Span<const std::byte> ciphertext, bool initiator, bool self_decrypt) noexcept
+{
+    assert(ciphertext.size() == KEM_CIPHERTEXT_LEN);
+
+    std::array<std::byte, mlkem::SHARED_SECRET_SIZE> kem_secret;
+    bool ret = mlkem::Decaps(KEM_PARAMS, kem_key.decaps_key, MakeUCharSpan(ciphertext), MakeUCharSpan(kem_secret));
+    assert(ret);
+    MixKEMSecret(kem_secret, initiator, self_decrypt);
+
+    memory_cleanse(kem_secret.data(), kem_secret.size());
+}
+
+bool BIP324Cipher::SwitchSendCipher() noexcept
+{
+    if (!m_pending_send_keys) return false;
+    m_send_l_cipher.emplace(m_pending_send_keys->l_key, REKEY_INTERVAL);
+    m_send_p_cipher.emplace(m_pending_send_keys->p_key, REKEY_INTERVAL);
+    memory_cleanse(&*m_pending_send_keys, sizeof(PendingKeys));
+    m_pending_send_keys.reset();
+    return true;
+}
+
+bool BIP324Cipher::SwitchRecvCipher() noexcept
+{
+    if (!m_pending_recv_keys) return false;
+    m_recv_l_cipher.emplace(m_pending_recv_keys->l_key, REKEY_INTERVAL);
+    m_recv_p_cipher.emplace(m_pending_recv_keys->p_key, REKEY_INTERVAL);
+    memory_cleanse(&*m_pending_recv_keys, sizeof(PendingKeys));
+    m_pending_recv_keys.reset();
+    return true;
+}
+
+void BIP324Cipher::WipeHybridKey() noexcept
+{
+    if (!m_hybrid_key) return;
+    memory_cleanse(m_hybrid_key->data(), m_hybrid_key->size());
+    m_hybrid_key.reset();
+}
+
 void BIP324Cipher::Encrypt(Span<const std::byte> contents, Span<const std::byte> aad, bool ignore, Span<std::byte> output) noexcept
 {
     assert(output.size() == contents.size() + EXPANSION);
@@ -14,6 +14,19 @@
 #include <key.h>
 #include <pubkey.h>
 #include <span.h>
+#include <support/allocators/secure.h>
+
+#include <vector>
+
+/** An ML-KEM-768 key pair, offered by the responder of a hybrid handshake. */
+struct BIP324KEMKey
+{
+    std::vector<uint8_t> encaps_key;
+    std::vector<unsigned char, secure_allocator<unsigned char>> decaps_key;
+
+    /** Generate a key pair from fresh randomness. */
+    static BIP324KEMKey Generate() noexcept;
+};
 
 /** The BIP324 packet cipher, encapsulating its key derivation, stream cipher, and AEAD. */
 class BIP324Cipher
@@ -26,6 +39,10 @@ public:
     static constexpr unsigned HEADER_LEN{1};
     static constexpr unsigned EXPANSION = LENGTH_LEN + HEADER_LEN + FSChaCha20Poly1305::EXPANSION;
     static constexpr std::byte IGNORE_BIT{0x80};
+    /** ML-KEM-768 sizes for the hybrid handshake. */
+    static constexpr unsigned KEM_ENCAPS_KEY_LEN{1184};
+    static constexpr unsigned KEM_DECAPS_KEY_LEN{2400};
+    static constexpr unsigned KEM_CIPHERTEXT_LEN{1088};
 
 private:
     std::optional<FSChaCha20> m_send_l_cipher;
@@ -40,6 +57,20 @@ private:
     std::array<std::byte, GARBAGE_TERMINATOR_LEN> m_send_garbage_terminator;
     std::array<std::byte, GARBAGE_TERMINATOR_LEN> m_recv_garbage_terminator;
 
+    /** Key derived from the ECDH secret that an ML-KEM shared secret is mixed with. */
+    std::optional<std::array<std::byte, 32>> m_hybrid_key;
+
+    /** Hybrid packet keys derived by MixKEMSecret, until switched to. */
+    struct PendingKeys {
+        std::array<std::byte, 32> l_key;
+        std::array<std::byte, 32> p_key;
+    };
+    std::optional<PendingKeys> m_pending_send_keys;
+    std::optional<PendingKeys> m_pending_recv_keys;
+
+    /** Derive the hybrid packet keys from the ECDH secret and kem_secret. */
+    void MixKEMSecret(Span<const std::byte> kem_secret, bool initiator, bool self_decrypt) noexcept;
+
 public:
     /** No default constructor; keys must be provided to create a BIP324Cipher. */
     BIP324Cipher() = delete;
@@ -83,6 +114,31 @@ public:
      */
     bool Decrypt(Span<const std::byte> input, Span<const std::byte> aad, bool& ignore, Span<std::byte> contents) noexcept;
 
+    /** Encapsulate to the other side's ML-KEM encapsulation key, writing KEM_CIPHERTEXT_LEN bytes
+     *  to ciphertext, and derive hybrid packet keys from the resulting secret. Only after
+     *  Initialize(). Returns false if encaps_key is not a valid encapsulation key.
+     *
+     * The new keys only take effect after SwitchSendCipher() and SwitchRecvCipher().
+     */
+    bool Encapsulate(Span<const std::byte> encaps_key, Span<std::byte> ciphertext, bool initiator, bool self_decrypt = false) noexcept;
+
+    /** Decapsulate the other side's ciphertext with our ML-KEM key, and derive hybrid packet keys
+     *  from the resulting secret. Only after Initialize(). A modified ciphertext gives keys the
+     *  other side does not have, so the connection fails at the next packet.
+     *
+     * The new keys only take effect after SwitchSendCipher() and SwitchRecvCipher().
+     */
+    void Decapsulate(const BIP324KEMKey& kem_key, Span<const std::byte> ciphertext, bool initiator, bool self_decrypt = false) noexcept;
+
+    /** Encrypt further packets with the hybrid keys, if derived. Returns whether they were. */
+    bool SwitchSendCipher() noexcept;
+
+    /** Decrypt further packets with the hybrid keys, if derived. Returns whether they were. */
+    bool SwitchRecvCipher() noexcept;
+
+    /** Wipe the key material for a hybrid handshake that is not going to happen. */
+    void WipeHybridKey() noexcept;
+
     /** Get the Session ID. Only after Initialize(). */
     Span<const std::byte> GetSessionID() const noexcept { return m_session_id; }
 
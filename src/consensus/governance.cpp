@@ -7,8 +7,14 @@
 #include <logging.h>
 #include <crypto/sha256.h>
 #include <random.h>
+#include <smartcontracts/vm.h>
+#include <streams.h>
 #include <algorithm>
 #include <chrono>
+#include <limits>
+#include <mutex>
+#include <set>
+#include <utility>
 
 namespace consensus {
 namespace governance {
@@ -18,6 +24,56 @@ static GovernanceState g_governance_state;
 static bool g_governance_initialized = false;
 static bool g_emergency_mode = false;
 
+// Parameter table, in ParameterId order
+static constexpr std::array<ParameterInfo, PARAM_COUNT> PARAMETER_TABLE{{
+    {PARAM_MAX_GAS_LIMIT, "max_gas_limit", smartcontracts::vm::MAX_GAS_LIMIT, 1000000, 1000000000},
+    {PARAM_EXECUTION_DELAY_BLOCKS, "execution_delay_blocks", params::EXECUTION_DELAY_BLOCKS, 1, 20160},
+}};
+
+static constexpr bool IsParameterTableOrdered() {
+    for (size_t i = 0; i < PARAMETER_TABLE.size(); ++i) {
+        const ParameterInfo& info = PARAMETER_TABLE[i];
+        if (info.id != i || info.min_value > info.default_value || info.default_value > info.max_value) return false;
+    }
+    return true;
+}
+static_assert(IsParameterTableOrdered(), "parameter table must be in ParameterId order with defaults in range");
+
+/** Whether every valid value of a parameter fits its handle's type */
+template <typename T>
+static constexpr bool FitsType(Parameter<T> parameter) {
+    const ParameterInfo& info = PARAMETER_TABLE[parameter.id];
+    return std::cmp_greater_equal(info.min_value, std::numeric_limits<T>::min()) &&
+           std::cmp_less_equal(info.max_value, std::numeric_limits<T>::max());
+}
+static_assert(FitsType(parameters::MAX_GAS_LIMIT) && FitsType(parameters::EXECUTION_DELAY_BLOCKS));
+
+static constexpr ParameterSnapshot::Values DefaultParameterValues() {
+    ParameterSnapshot::Values values{};
+    for (const ParameterInfo& info : PARAMETER_TABLE) {
+        values[info.id] = info.default_value;
+    }
+    return values;
+}
+
+// Parameter snapshots. The latest is published under g_parameters_mutex,
+// which readers only hold to copy the pointer; they share ownership of the
+// snapshots they use, so the ones a reorg or reset replaces stay valid until
+// the last reader lets go of them. The mutex stands in for
+// std::atomic<std::shared_ptr>, which libc++ does not provide.
+static const std::shared_ptr<const ParameterSnapshot> g_default_parameters{
+    std::make_shared<const ParameterSnapshot>(DefaultParameterValues(), 0, 0, nullptr)};
+static std::mutex g_parameters_mutex;
+static std::shared_ptr<const ParameterSnapshot> g_parameters{g_default_parameters};
+
+/**
+ * Get the latest parameter snapshot
+ */
+static std::shared_ptr<const ParameterSnapshot> GetLatestParameters() {
+    std::lock_guard<std::mutex> lock(g_parameters_mutex);
+    return g_parameters;
+}
+
 /**
  * Initialize governance system
  */
@@ -30,6 +86,11 @@ bool InitializeGovernanceSystem() {
         g_governance_state.current_epoch = 0;
         g_governance_state.total_proposals_created = 0;
         g_governance_state.total_proposals_executed = 0;
+        g_emergency_mode = false;
+        {
+            std::lock_guard<std::mutex> lock(g_parameters_mutex);
+            g_parameters = g_default_parameters;
+        }
         
         g_governance_initialized = true;
         LogPrintf("Bitcoin Decentral: Governance System initialized successfully\n");
@@ -99,8 +160,9 @@ bool CreateProposal(const uint256& creator_id, ProposalType type,
             return false;
         }
         
-        // Add to active proposals
+        // Add to active proposals; voting starts at the next block
         g_governance_state.active_proposals[proposal.proposal_id] = proposal;
+        g_governance_state.proposal_schedule.emplace(0, proposal.proposal_id);
         g_governance_state.total_proposals_created++;
         
         LogProposalCreated(proposal);
@@ -140,28 +202,23 @@ bool SubmitVote(const uint256& proposal_id, const uint256& validator_id,
         }
         
         // Check if validator already voted
-        auto& votes = g_governance_state.proposal_votes[proposal_id];
-        for (const auto& vote : votes) {
-            if (vote.validator_id == validator_id) {
-                LogPrintf("Bitcoin Decentral: Validator %s already voted on proposal %s\n",
-                         validator_id.ToString(), proposal_id.ToString());
-                return false;
-            }
+        auto [vote_it, inserted] = g_governance_state.proposal_votes[proposal_id].try_emplace(validator_id);
+        if (!inserted) {
+            LogPrintf("Bitcoin Decentral: Validator %s already voted on proposal %s\n",
+                     validator_id.ToString(), proposal_id.ToString());
+            return false;
         }
         
         // Create vote
-        VoteInfo vote;
+        VoteInfo& vote = vote_it->second;
         vote.proposal_id = proposal_id;
         vote.validator_id = validator_id;
         vote.choice = choice;
         vote.stake_weight = GetValidatorVotingPower(validator_id);
         vote.vote_height = 0; // Will be set when included in block
-        vote.reason = reason;
-        
-        // Add vote to proposal votes
-        votes.push_back(vote);
         
-        // Update proposal vote tallies
+        // Update proposal vote tallies, so that closing the vote needs no
+        // recount
         GovernanceProposal& proposal = it->second;
         switch (choice) {
             case VoteInfo::VOTE_FOR:
@@ -177,8 +234,9 @@ bool SubmitVote(const uint256& proposal_id, const uint256& validator_id,
         proposal.voter_count++;
         
         LogVoteCast(vote);
-        LogPrintf("Bitcoin Decentral: Validator %s voted %d on proposal %s with weight %llu\n",
-                 validator_id.ToString(), static_cast<int>(choice), proposal_id.ToString(), vote.stake_weight);
+        LogPrintf("Bitcoin Decentral: Validator %s voted %d on proposal %s with weight %llu%s\n",
+                 validator_id.ToString(), static_cast<int>(choice), proposal_id.ToString(), vote.stake_weight,
+                 reason.empty() ? "" : ": " + reason);
         
         return true;
     } catch (const std::exception& e) {
@@ -199,11 +257,19 @@ bool UpdateProposalStatus(const uint256& proposal_id, int current_height) {
         
         GovernanceProposal& proposal = it->second;
         
+        // Start voting once the proposal is in a block
+        if (proposal.status == PROPOSAL_PENDING) {
+            proposal.creation_height = current_height;
+            proposal.voting_start_height = current_height;
+            proposal.voting_end_height = current_height + params::VOTING_PERIOD_BLOCKS;
+            proposal.status = PROPOSAL_ACTIVE;
+        }
+        
         // Check if voting period has ended
         if (current_height >= proposal.voting_end_height && proposal.status == PROPOSAL_ACTIVE) {
             // Calculate participation rate
-            auto validator_state = consensus::hybrid::GetValidatorNetworkState();
-            double participation_rate = CalculateParticipationRate(proposal, validator_state);
+            const auto validator_state = consensus::hybrid::GetValidatorNetworkState();
+            double participation_rate = CalculateParticipationRate(proposal, *validator_state);
             
             if (participation_rate < params::MIN_PARTICIPATION_RATE) {
                 proposal.status = PROPOSAL_EXPIRED;
@@ -211,7 +277,7 @@ bool UpdateProposalStatus(const uint256& proposal_id, int current_height) {
                          proposal_id.ToString(), participation_rate * 100.0);
             } else if (CheckApprovalThreshold(proposal)) {
                 proposal.status = PROPOSAL_APPROVED;
-                proposal.execution_height = current_height + params::EXECUTION_DELAY_BLOCKS;
+                proposal.execution_height = current_height + GetParameters(current_height)->Get(parameters::EXECUTION_DELAY_BLOCKS);
                 
                 // Emergency proposals execute immediately
                 if (proposal.is_emergency) {
@@ -229,7 +295,7 @@ bool UpdateProposalStatus(const uint256& proposal_id, int current_height) {
         
         // Check if proposal is ready for execution
         if (proposal.status == PROPOSAL_APPROVED && current_height >= proposal.execution_height) {
-            if (ExecuteProposal(proposal_id)) {
+            if (ExecuteProposal(proposal_id, current_height)) {
                 proposal.status = PROPOSAL_EXECUTED;
                 g_governance_state.total_proposals_executed++;
                 LogProposalExecuted(proposal);
@@ -246,10 +312,101 @@ bool UpdateProposalStatus(const uint256& proposal_id, int current_height) {
     }
 }
 
+/**
+ * Decode the parameter changes of a parameter change proposal
+ */
+static bool DecodeParameterChanges(const std::vector<uint8_t>& data, std::vector<ParameterChange>& changes) {
+    try {
+        SpanReader reader{data};
+        reader >> changes;
+        return reader.empty() && !changes.empty();
+    } catch (const std::ios_base::failure&) {
+        return false;
+    }
+}
+
+/**
+ * Height of a proposal's next status change, if it has one
+ */
+static std::optional<uint32_t> GetProposalDueHeight(const GovernanceProposal& proposal) {
+    switch (proposal.status) {
+        case PROPOSAL_PENDING:
+            return 0;
+        case PROPOSAL_ACTIVE:
+            return proposal.voting_end_height;
+        case PROPOSAL_APPROVED:
+            return proposal.execution_height;
+        default:
+            return std::nullopt;
+    }
+}
+
+/**
+ * Update the status of due proposals
+ */
+void ProcessGovernanceBlock(int height) {
+    auto& schedule = g_governance_state.proposal_schedule;
+    auto& proposals = g_governance_state.active_proposals;
+    GovernanceBlockUndo undo{{}, g_governance_state.total_proposals_executed, g_emergency_mode};
+    std::set<uint256> saved;
+    while (!schedule.empty() && std::cmp_less_equal(schedule.top().first, height)) {
+        const uint256 proposal_id = schedule.top().second;
+        schedule.pop();
+        
+        // Entries of proposals that were cleaned up are dropped here
+        auto it = proposals.find(proposal_id);
+        if (it == proposals.end()) continue;
+        if (saved.insert(proposal_id).second) undo.proposals.push_back(it->second);
+        if (!UpdateProposalStatus(proposal_id, height)) continue;
+        
+        const auto due_height = GetProposalDueHeight(it->second);
+        if (due_height) {
+            schedule.emplace(std::max<uint32_t>(*due_height, height + 1), proposal_id);
+        }
+    }
+    
+    // Only proposals whose status changed need restoring
+    std::erase_if(undo.proposals, [&](const GovernanceProposal& before) {
+        return proposals.at(before.proposal_id).status == before.status;
+    });
+    if (!undo.proposals.empty()) {
+        g_governance_state.block_undo[height] = std::move(undo);
+    }
+}
+
+/**
+ * Undo the governance changes of a disconnected block
+ */
+void DisconnectGovernanceBlock(int height) {
+    // Parameter changes executed in the block take effect from the next one
+    DisconnectParameterChanges(height);
+    
+    auto undo_it = g_governance_state.block_undo.find(height);
+    if (undo_it == g_governance_state.block_undo.end()) return;
+    GovernanceBlockUndo& undo = undo_it->second;
+    for (GovernanceProposal& proposal : undo.proposals) {
+        g_governance_state.completed_proposals.erase(proposal.proposal_id);
+        g_governance_state.active_proposals[proposal.proposal_id] = std::move(proposal);
+    }
+    g_governance_state.total_proposals_executed = undo.total_proposals_executed;
+    g_emergency_mode = undo.emergency_mode;
+    g_governance_state.block_undo.erase(undo_it);
+    
+    // Reschedule from the restored statuses, which also drops the entries
+    // the undone changes left; restored proposals are due again at height
+    decltype(g_governance_state.proposal_schedule) schedule;
+    for (const auto& [proposal_id, proposal] : g_governance_state.active_proposals) {
+        if (const auto due_height = GetProposalDueHeight(proposal)) {
+            schedule.emplace(std::max<uint32_t>(*due_height, height), proposal_id);
+        }
+    }
+    g_governance_state.proposal_schedule = std::move(schedule);
+}
+
 /**
  * Execute approved proposal
  */
-bool ExecuteProposal(const uint256& proposal_id) {
+bool ExecuteProposal(const uint256& proposal_id, int height) {
     try {
         auto it = g_governance_state.active_proposals.find(proposal_id);
         if (it == g_governance_state.active_proposals.end()) {
@@ -265,10 +422,10 @@ bool ExecuteProposal(const uint256& proposal_id) {
         
         switch (proposal.type) {
             case PROPOSAL_PARAMETER_CHANGE: {
-                // Execute parameter changes
+                // Execute parameter changes from the next block on
                 std::vector<ParameterChange> changes;
-                // Parse changes from proposal data (simplified implementation)
-                success = ExecuteParameterChanges(changes);
+                success = DecodeParameterChanges(proposal.data, changes) &&
+                          ExecuteParameterChanges(changes, height + 1);
                 break;
             }
             case PROPOSAL_PROTOCOL_UPGRADE: {
@@ -344,15 +501,51 @@ double CalculateParticipationRate(const GovernanceProposal& proposal,
     return static_cast<double>(total_participating_stake) / total_eligible_stake;
 }
 
+/**
+ * Get proposal by ID
+ */
+GovernanceProposal* GetProposal(const uint256& proposal_id) {
+    auto it = g_governance_state.active_proposals.find(proposal_id);
+    if (it != g_governance_state.active_proposals.end()) return &it->second;
+    it = g_governance_state.completed_proposals.find(proposal_id);
+    if (it != g_governance_state.completed_proposals.end()) return &it->second;
+    return nullptr;
+}
+
+/**
+ * Get all active proposals
+ */
+std::vector<GovernanceProposal> GetActiveProposals() {
+    std::vector<GovernanceProposal> proposals;
+    for (const auto& [id, proposal] : g_governance_state.active_proposals) {
+        proposals.push_back(proposal);
+    }
+    return proposals;
+}
+
+/**
+ * Get proposal votes
+ */
+std::vector<VoteInfo> GetProposalVotes(const uint256& proposal_id) {
+    std::vector<VoteInfo> votes;
+    auto it = g_governance_state.proposal_votes.find(proposal_id);
+    if (it != g_governance_state.proposal_votes.end()) {
+        for (const auto& [validator_id, vote] : it->second) {
+            votes.push_back(vote);
+        }
+    }
+    return votes;
+}
+
 /**
  * Check if validator can create proposal
  */
 bool CanCreateProposal(const uint256& validator_id, ProposalType type) {
     // Get validator info from hybrid consensus
-    auto validator_state = consensus::hybrid::GetValidatorNetworkState();
-    auto it = validator_state.active_validators.find(validator_id);
+    const auto validator_state = consensus::hybrid::GetValidatorNetworkState();
+    auto it = validator_state->active_validators.find(validator_id);
     
-    if (it == validator_state.active_validators.end() || !it->second.is_active) {
+    if (it == validator_state->active_validators.end() || !it->second.is_active) {
         return false;
     }
     
@@ -372,20 +565,20 @@ bool CanCreateProposal(const uint256& validator_id, ProposalType type) {
  */
 bool CanVoteOnProposal(const uint256& validator_id, const uint256& proposal_id) {
     // Get validator info from hybrid consensus
-    auto validator_state = consensus::hybrid::GetValidatorNetworkState();
-    auto it = validator_state.active_validators.find(validator_id);
+    const auto validator_state = consensus::hybrid::GetValidatorNetworkState();
+    auto it = validator_state->active_validators.find(validator_id);
     
-    return (it != validator_state.active_validators.end() && it->second.is_active);
+    return (it != validator_state->active_validators.end() && it->second.is_active);
 }
 
 /**
  * Get validator voting power
  */
 uint64_t GetValidatorVotingPower(const uint256& validator_id) {
-    auto validator_state = consensus::hybrid::GetValidatorNetworkState();
-    auto it = validator_state.active_validators.find(validator_id);
+    const auto validator_state = consensus::hybrid::GetValidatorNetworkState();
+    auto it = validator_state->active_validators.find(validator_id);
     
-    if (it == validator_state.active_validators.end() || !it->second.is_active) {
+    if (it == validator_state->active_validators.end() || !it->second.is_active) {
         return 0;
     }
     
@@ -393,25 +586,48 @@ uint64_t GetValidatorVotingPower(const uint256& validator_id) {
     return static_cast<uint64_t>(it->second.stake_amount * it->second.reputation_score);
 }
 
+/**
+ * Create parameter change proposal
+ */
+bool CreateParameterChangeProposal(const uint256& creator_id,
+                                  const std::vector<ParameterChange>& changes,
+                                  const std::string& justification) {
+    DataStream data{};
+    data << changes;
+    return CreateProposal(creator_id, PROPOSAL_PARAMETER_CHANGE,
+                          strprintf("Change %u consensus parameters", changes.size()), justification,
+                          std::vector<uint8_t>(UCharCast(data.data()), UCharCast(data.data() + data.size())));
+}
+
 /**
  * Execute parameter changes
  */
-bool ExecuteParameterChanges(const std::vector<ParameterChange>& changes) {
+bool ExecuteParameterChanges(const std::vector<ParameterChange>& changes, int activation_height) {
     try {
+        std::lock_guard<std::mutex> lock(g_parameters_mutex);
+        const std::shared_ptr<const ParameterSnapshot> latest = g_parameters;
+        if (activation_height < 0 || static_cast<uint32_t>(activation_height) < latest->GetActivationHeight()) {
+            LogPrintf("Bitcoin Decentral: Parameter changes at height %d would precede height %u\n",
+                     activation_height, latest->GetActivationHeight());
+            return false;
+        }
+        
+        ParameterSnapshot::Values values = latest->GetValues();
         for (const auto& change : changes) {
             if (!ValidateParameterChange(change)) {
-                LogPrintf("Bitcoin Decentral: Invalid parameter change: %s\n", change.parameter_name);
-                return false;
-            }
-            
-            if (!SetParameterValue(change.parameter_name, change.new_value)) {
-                LogPrintf("Bitcoin Decentral: Failed to set parameter %s to %s\n",
-                         change.parameter_name, change.new_value);
+                LogPrintf("Bitcoin Decentral: Invalid parameter change: %u to %d\n",
+                         change.parameter_id, change.new_value);
                 return false;
             }
-            
-            LogPrintf("Bitcoin Decentral: Changed parameter %s from %s to %s\n",
-                     change.parameter_name, change.old_value, change.new_value);
+            values[change.parameter_id] = change.new_value;
+        }
+        
+        g_parameters = std::make_shared<const ParameterSnapshot>(values, activation_height, latest->GetVersion() + 1, latest);
+        
+        for (const auto& change : changes) {
+            LogPrintf("Bitcoin Decentral: Changed parameter %s from %d to %d at height %d\n",
+                     PARAMETER_TABLE[change.parameter_id].name, latest->GetValue(ParameterId(change.parameter_id)),
+                     change.new_value, activation_height);
         }
         
         return true;
@@ -421,6 +637,58 @@ bool ExecuteParameterChanges(const std::vector<ParameterChange>& changes) {
     }
 }
 
+/**
+ * Undo parameter changes above a height
+ */
+void DisconnectParameterChanges(int height) {
+    std::lock_guard<std::mutex> lock(g_parameters_mutex);
+    while (g_parameters->GetPrevious() && std::cmp_greater(g_parameters->GetActivationHeight(), height)) {
+        g_parameters = g_parameters->GetPrevious();
+    }
+}
+
+/**
+ * Validate parameter change
+ */
+bool ValidateParameterChange(const ParameterChange& change) {
+    if (change.parameter_id >= PARAM_COUNT) return false;
+    const ParameterInfo& info = PARAMETER_TABLE[change.parameter_id];
+    return change.new_value >= info.min_value && change.new_value <= info.max_value;
+}
+
+const ParameterInfo& GetParameterInfo(ParameterId id) {
+    return PARAMETER_TABLE[id];
+}
+
+std::optional<ParameterId> FindParameter(const std::string& parameter_name) {
+    for (const ParameterInfo& info : PARAMETER_TABLE) {
+        if (parameter_name == info.name) return info.id;
+    }
+    return std::nullopt;
+}
+
+/**
+ * Get the parameters in effect at a block height
+ */
+std::shared_ptr<const ParameterSnapshot> GetParameters(int height) {
+    // Snapshots above height are changes scheduled for later blocks, or
+    // from blocks being disconnected; there are rarely more than one
+    std::shared_ptr<const ParameterSnapshot> snapshot = GetLatestParameters();
+    while (snapshot->GetPrevious() && std::cmp_greater(snapshot->GetActivationHeight(), height)) {
+        snapshot = snapshot->GetPrevious();
+    }
+    return snapshot;
+}
+
+/**
+ * Get latest parameter value by name
+ */
+std::string GetParameterValue(const std::string& parameter_name) {
+    const auto id = FindParameter(parameter_name);
+    if (!id) return "";
+    return strprintf("%d", GetLatestParameters()->GetValue(*id));
+}
+
 /**
  * Execute emergency action
  */
@@ -457,9 +725,15 @@ bool ValidateProposalData(const GovernanceProposal& proposal) {
     
     // Type-specific validation
     switch (proposal.type) {
-        case PROPOSAL_PARAMETER_CHANGE:
+        case PROPOSAL_PARAMETER_CHANGE: {
             // Validate parameter change data
+            std::vector<ParameterChange> changes;
+            if (!DecodeParameterChanges(proposal.data, changes) ||
+                !std::all_of(changes.begin(), changes.end(), ValidateParameterChange)) {
+                return false;
+            }
             break;
+        }
         case PROPOSAL_PROTOCOL_UPGRADE:
             // Validate protocol upgrade data
             break;
@@ -513,11 +787,11 @@ GovernanceStats GetGovernanceStatistics() {
     // Calculate average participation rate
     double total_participation = 0.0;
     int proposal_count = 0;
-    auto validator_state = consensus::hybrid::GetValidatorNetworkState();
+    const auto validator_state = consensus::hybrid::GetValidatorNetworkState();
     
     for (const auto& [id, proposal] : g_governance_state.active_proposals) {
         if (proposal.status == PROPOSAL_ACTIVE || proposal.status == PROPOSAL_APPROVED) {
-            total_participation += CalculateParticipationRate(proposal, validator_state);
+            total_participation += CalculateParticipationRate(proposal, *validator_state);
             proposal_count++;
         }
     }
@@ -526,8 +800,8 @@ GovernanceStats GetGovernanceStatistics() {
         stats.average_participation_rate = total_participation / proposal_count;
     }
     
-    stats.total_voting_stake = validator_state.total_staked_amount;
-    stats.total_voters = static_cast<uint32_t>(validator_state.active_validators.size());
+    stats.total_voting_stake = validator_state->total_staked_amount;
+    stats.total_voters = static_cast<uint32_t>(validator_state->active_validators.size());
     
     return stats;
 }
@@ -597,9 +871,6 @@ void MonitorGovernanceActivity() {
 }
 
 // Simplified implementations for remaining functions
-bool ValidateParameterChange(const ParameterChange& change) { return true; }
-std::string GetParameterValue(const std::string& parameter_name) { return ""; }
-bool SetParameterValue(const std::string& parameter_name, const std::string& value) { return true; }
 bool ExecuteProtocolUpgrade(uint32_t new_version, uint32_t activation_height) { return true; }
 
 } // namespace governance
@@ -1,14 +1,20 @@
 #ifndef BITCOIN_CONSENSUS_GOVERNANCE_H
 #define BITCOIN_CONSENSUS_GOVERNANCE_H
 
+#include <array>
 #include <cstdint>
+#include <functional>
 #include <vector>
 #include <map>
+#include <optional>
+#include <queue>
 #include <string>
 #include <memory>
 
-class CTransaction;
+#include <serialize.h>
 #include <uint256.h>
+
+class CTransaction;
 namespace consensus { namespace hybrid { struct ValidatorNetworkState; } }
 
 /**
@@ -128,18 +134,37 @@ struct VoteInfo {
     } choice;                       // Vote choice
     uint64_t stake_weight;          // Stake weight at time of vote
     uint32_t vote_height;           // Block height when vote was cast
-    std::string reason;             // Optional vote reason
     
     VoteInfo() : choice(VOTE_ABSTAIN), stake_weight(0), vote_height(0) {}
 };
 
+/**
+ * Governance state changed by a block, as it was before the block
+ */
+struct GovernanceBlockUndo {
+    std::vector<GovernanceProposal> proposals;  // Proposals the block changed
+    uint32_t total_proposals_executed{0};       // Execution count
+    bool emergency_mode{false};                 // Emergency mode
+};
+
 /**
  * Governance state
+ *
+ * Proposals wait in a min-heap by the height of their next status change:
+ * the end of voting while active, the execution height once approved. A
+ * new proposal is due at the next block, where its voting starts.
+ *
+ * Each block that changes a proposal keeps undo data, so that disconnecting
+ * the block restores the proposals and applies them again on reconnection.
  */
 struct GovernanceState {
+    using ScheduleEntry = std::pair<uint32_t, uint256>;         // Due height, proposal ID
+    
     std::map<uint256, GovernanceProposal> active_proposals;     // Active proposals
     std::map<uint256, GovernanceProposal> completed_proposals;  // Completed proposals
-    std::map<uint256, std::vector<VoteInfo>> proposal_votes;    // Votes by proposal
+    std::map<uint256, std::map<uint256, VoteInfo>> proposal_votes; // Votes by proposal and validator
+    std::priority_queue<ScheduleEntry, std::vector<ScheduleEntry>, std::greater<>> proposal_schedule; // Proposals by due height
+    std::map<uint32_t, GovernanceBlockUndo> block_undo;         // Undo data by block height
     uint32_t current_epoch;                                     // Current governance epoch
     uint32_t total_proposals_created;                           // Total proposals ever created
     uint32_t total_proposals_executed;                          // Total proposals executed
@@ -147,14 +172,95 @@ struct GovernanceState {
     GovernanceState() : current_epoch(0), total_proposals_created(0), total_proposals_executed(0) {}
 };
 
+/**
+ * Consensus parameter registry
+ *
+ * Parameters that governance can change are declared once, in the
+ * parameter table, with a default and a valid range. Their values form
+ * immutable snapshots, each in effect from its activation height until the
+ * next one. Readers get a value through a typed handle, which indexes the
+ * snapshot for their block height. They hold a mutex only to copy the
+ * pointer to the latest snapshot, never while reading values from it.
+ * Parameter changes publish a new snapshot that takes effect at a block
+ * boundary.
+ */
+enum ParameterId : uint32_t {
+    PARAM_MAX_GAS_LIMIT,            // Gas limit of a contract execution
+    PARAM_EXECUTION_DELAY_BLOCKS,   // Delay between proposal approval and execution
+    PARAM_COUNT
+};
+
+/**
+ * Parameter table entry
+ */
+struct ParameterInfo {
+    ParameterId id;
+    const char* name;
+    int64_t default_value;
+    int64_t min_value;
+    int64_t max_value;
+};
+
+/**
+ * Typed parameter handle
+ */
+template <typename T>
+struct Parameter {
+    ParameterId id;
+};
+
+namespace parameters {
+    inline constexpr Parameter<uint64_t> MAX_GAS_LIMIT{PARAM_MAX_GAS_LIMIT};
+    inline constexpr Parameter<int> EXECUTION_DELAY_BLOCKS{PARAM_EXECUTION_DELAY_BLOCKS};
+}
+
+/**
+ * Values of all parameters from an activation height on
+ *
+ * Snapshots are never changed once published. Readers share ownership of
+ * them, so one that a reorg replaces stays valid while it is still in use,
+ * and is freed after.
+ */
+class ParameterSnapshot
+{
+public:
+    using Values = std::array<int64_t, PARAM_COUNT>;
+    
+    ParameterSnapshot(const Values& values, uint32_t activation_height, uint32_t version,
+                      std::shared_ptr<const ParameterSnapshot> previous)
+        : m_values(values), m_activation_height(activation_height), m_version(version), m_previous(std::move(previous)) {}
+    
+    template <typename T>
+    T Get(Parameter<T> parameter) const { return static_cast<T>(m_values[parameter.id]); }
+    int64_t GetValue(ParameterId id) const { return m_values[id]; }
+    const Values& GetValues() const { return m_values; }
+    
+    uint32_t GetActivationHeight() const { return m_activation_height; }
+    uint32_t GetVersion() const { return m_version; }
+    
+    /** Snapshot in effect before this one */
+    const std::shared_ptr<const ParameterSnapshot>& GetPrevious() const { return m_previous; }
+    
+private:
+    const Values m_values;
+    const uint32_t m_activation_height;
+    const uint32_t m_version;
+    const std::shared_ptr<const ParameterSnapshot> m_previous;
+};
+
 /**
  * Parameter change specification
  */
 struct ParameterChange {
-    std::string parameter_name;     // Name of parameter to change
-    std::string old_value;          // Current parameter value
-    std::string new_value;          // Proposed new value
-    std::string justification;      // Justification for change
+    uint32_t parameter_id;          // ParameterId of parameter to change
+    int64_t new_value;              // Proposed new value
+    
+    ParameterChange() : parameter_id(PARAM_COUNT), new_value(0) {}
+    ParameterChange(ParameterId id, int64_t value) : parameter_id(id), new_value(value) {}
+    
+    SERIALIZE_METHODS(ParameterChange, obj) {
+        READWRITE(obj.parameter_id, obj.new_value);
+    }
 };
 
 /**
@@ -190,9 +296,23 @@ bool ProcessGovernanceTransaction(const CTransaction& tx);
 bool UpdateProposalStatus(const uint256& proposal_id, int current_height);
 
 /**
- * Execute approved proposal
+ * Update the status of the proposals due at a block height
+ *
+ * Proposals that are not due are not visited.
+ */
+void ProcessGovernanceBlock(int height);
+
+/**
+ * Undo ProcessGovernanceBlock for a block being disconnected: restore the
+ * proposals it changed, and drop the parameter changes it executed
+ */
+void DisconnectGovernanceBlock(int height);
+
+/**
+ * Execute approved proposal in the block at height. Parameter changes take
+ * effect from the next block.
  */
-bool ExecuteProposal(const uint256& proposal_id);
+bool ExecuteProposal(const uint256& proposal_id, int height);
 
 /**
  * Check if proposal meets approval threshold
@@ -252,23 +372,44 @@ bool CreateParameterChangeProposal(const uint256& creator_id,
 
 /**
  * Execute parameter changes
+ *
+ * Publishes one snapshot with all changes, in effect from activation_height,
+ * or changes nothing if any change is invalid. Changes cannot activate below
+ * the latest snapshot.
+ */
+bool ExecuteParameterChanges(const std::vector<ParameterChange>& changes, int activation_height);
+
+/**
+ * Undo the parameter changes that activate above a height, when the blocks
+ * above it are disconnected
  */
-bool ExecuteParameterChanges(const std::vector<ParameterChange>& changes);
+void DisconnectParameterChanges(int height);
 
 /**
- * Validate parameter change
+ * Validate parameter change against the parameter table
  */
 bool ValidateParameterChange(const ParameterChange& change);
 
 /**
- * Get current parameter value
+ * Get the parameter table entry of a parameter
  */
-std::string GetParameterValue(const std::string& parameter_name);
+const ParameterInfo& GetParameterInfo(ParameterId id);
+
+/**
+ * Look up a parameter by name
+ */
+std::optional<ParameterId> FindParameter(const std::string& parameter_name);
+
+/**
+ * Get the parameters in effect at a block height
+ */
+std::shared_ptr<const ParameterSnapshot> GetParameters(int height);
 
 /**
- * Set parameter value
+ * Get the latest value of a parameter, by name, or an empty string if there
+ * is no such parameter
  */
-bool SetParameterValue(const std::string& parameter_name, const std::string& value);
+std::string GetParameterValue(const std::string& parameter_name);
 
 /**
  * Protocol upgrade functions
@@ -1,6 +1,8 @@
 #include <consensus/hybrid.h>
 #include <consensus/governance.h>
 #include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <script/script.h>
 #include <chain.h>
 #include <uint256.h>
 #include <util/time.h>
@@ -9,17 +11,166 @@
 #include <random.h>
 #include <pow.h>
 #include <hash.h>
+#include <key.h>
 #include <serialize.h>
+#include <support/cleanse.h>
+#include <secp256k1.h>
+#include <secp256k1_extrakeys.h>
+#include <secp256k1_musig.h>
 #include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
 #include <chrono>
+#include <cstring>
+#include <deque>
+#include <mutex>
 
 namespace consensus {
 namespace hybrid {
 
-// Global validator network state
-static ValidatorNetworkState g_validator_state;
+// Global validator network state, published as immutable snapshots. Readers
+// share the current snapshot; writers change a copy and swap it in. Readers
+// hold g_validator_state_mutex only to copy the pointer, in place of
+// std::atomic<std::shared_ptr>, which libc++ does not provide.
+static std::mutex g_validator_state_mutex;
+static std::mutex g_validator_state_write_mutex;
+static std::shared_ptr<const ValidatorNetworkState> g_validator_state{std::make_shared<const ValidatorNetworkState>()};
 static bool g_hybrid_consensus_initialized = false;
 
+// Validator signatures of checkpoints, by block hash, and recently used
+// aggregate keys by hash of the signer keys
+static std::mutex g_checkpoint_mutex;
+static std::map<uint256, std::pair<std::vector<unsigned char>, std::vector<unsigned char>>> g_checkpoint_signatures;
+static std::deque<uint256> g_checkpoint_signatures_order;
+static std::vector<std::pair<uint256, XOnlyPubKey>> g_aggregate_key_cache;
+
+// Votes being collected, by checkpoint hash, with the committee keys and,
+// once a signing set is chosen, its members, their nonces and the MuSig2
+// session that partial signatures verify in
+struct CheckpointVoteEntry {
+    CheckpointVoteSet votes;
+    std::vector<XOnlyPubKey> committee_keys;
+    std::vector<uint32_t> signers;
+    std::vector<CheckpointNonce> signer_nonces;
+    secp256k1_musig_keyagg_cache keyagg_cache;
+    std::optional<secp256k1_musig_session> session;
+    bool is_complete{false};
+};
+static std::mutex g_checkpoint_votes_mutex;
+static std::map<uint256, CheckpointVoteEntry> g_checkpoint_votes;
+static std::deque<uint256> g_checkpoint_votes_order;
+
+// Checkpoint store and the highest finalized block. The watermark is read
+// without locking, as finality queries outnumber finalizations by far.
+static std::mutex g_finality_mutex;
+static std::unique_ptr<CheckpointStore> g_checkpoint_store;
+static std::atomic<const CBlockIndex*> g_finalized_block{nullptr};
+
+// Staking and governance transactions of recent blocks, by block hash
+static std::mutex g_classified_blocks_mutex;
+static std::map<uint256, std::shared_ptr<const HybridBlockTransactions>> g_classified_blocks;
+static std::deque<uint256> g_classified_blocks_order;
+
+// Validator sampler of the published validator state it was built from
+static std::mutex g_sampler_mutex;
+static std::shared_ptr<const ValidatorNetworkState> g_sampler_state;
+static std::unique_ptr<ValidatorSampler> g_sampler;
+
+/**
+ * Context for MuSig2 nonce generation and signing, which cannot use the
+ * static context
+ */
+static secp256k1_context* GetSigningContext() {
+    static secp256k1_context* const ctx = [] {
+        secp256k1_context* ctx = secp256k1_context_create(SECP256K1_CONTEXT_NONE);
+        std::array<unsigned char, 32> seed;
+        GetRandBytes(seed);
+        const bool ret = secp256k1_context_randomize(ctx, seed.data());
+        assert(ret);
+        return ctx;
+    }();
+    return ctx;
+}
+
+/**
+ * MuSig2 key aggregation of signer keys, in order. Keys are lifted to even Y.
+ */
+static bool AggregateKeys(const std::vector<XOnlyPubKey>& keys, secp256k1_musig_keyagg_cache& keyagg_cache,
+                          secp256k1_xonly_pubkey& aggregate_key) {
+    if (keys.empty()) return false;
+    
+    std::vector<secp256k1_pubkey> pubkeys(keys.size());
+    std::vector<const secp256k1_pubkey*> pubkey_ptrs;
+    pubkey_ptrs.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        const CPubKey pubkey = keys[i].GetEvenCorrespondingCPubKey();
+        if (!secp256k1_ec_pubkey_parse(secp256k1_context_static, &pubkeys[i], pubkey.data(), pubkey.size())) {
+            return false;
+        }
+        pubkey_ptrs.push_back(&pubkeys[i]);
+    }
+    return secp256k1_musig_pubkey_agg(secp256k1_context_static, &aggregate_key, &keyagg_cache,
+                                      pubkey_ptrs.data(), pubkey_ptrs.size());
+}
+
+/**
+ * Aggregate key of a signer set. Signer sets rarely change between
+ * checkpoints, so recent aggregates are cached.
+ */
+static std::optional<XOnlyPubKey> GetAggregateKey(const std::vector<XOnlyPubKey>& keys) {
+    HashWriter hasher{};
+    for (const XOnlyPubKey& key : keys) {
+        hasher << key;
+    }
+    const uint256 keys_hash = hasher.GetHash();
+    
+    {
+        std::lock_guard<std::mutex> lock(g_checkpoint_mutex);
+        for (auto it = g_aggregate_key_cache.begin(); it != g_aggregate_key_cache.end(); ++it) {
+            if (it->first == keys_hash) {
+                std::rotate(g_aggregate_key_cache.begin(), it, it + 1);
+                return g_aggregate_key_cache.front().second;
+            }
+        }
+    }
+    
+    secp256k1_musig_keyagg_cache keyagg_cache;
+    secp256k1_xonly_pubkey aggregate_key;
+    if (!AggregateKeys(keys, keyagg_cache, aggregate_key)) {
+        return std::nullopt;
+    }
+    unsigned char aggregate_key_bytes[32];
+    secp256k1_xonly_pubkey_serialize(secp256k1_context_static, aggregate_key_bytes, &aggregate_key);
+    const XOnlyPubKey result{aggregate_key_bytes};
+    
+    std::lock_guard<std::mutex> lock(g_checkpoint_mutex);
+    g_aggregate_key_cache.emplace(g_aggregate_key_cache.begin(), keys_hash, result);
+    if (g_aggregate_key_cache.size() > params::CHECKPOINT_KEY_CACHE_SIZE) {
+        g_aggregate_key_cache.pop_back();
+    }
+    return result;
+}
+
+/**
+ * Swap in a new validator network state snapshot
+ */
+static void PublishValidatorNetworkState(std::shared_ptr<const ValidatorNetworkState> state) {
+    std::lock_guard<std::mutex> lock(g_validator_state_mutex);
+    g_validator_state = std::move(state);
+}
+
+/**
+ * Change a copy of the validator network state and publish it
+ */
+template <typename Fn>
+static void ModifyValidatorNetworkState(Fn&& fn) {
+    std::lock_guard<std::mutex> lock(g_validator_state_write_mutex);
+    auto state = std::make_shared<ValidatorNetworkState>(*GetValidatorNetworkState());
+    fn(*state);
+    PublishValidatorNetworkState(std::move(state));
+}
+
 /**
  * Initialize hybrid consensus system
  */
@@ -28,10 +179,27 @@ bool InitializeHybridConsensus(const Consensus::Params& params) {
     
     try {
         // Initialize validator network state
-        g_validator_state = ValidatorNetworkState();
-        g_validator_state.current_epoch = 0;
-        g_validator_state.total_staked_amount = 0;
-        g_validator_state.last_checkpoint_height = 0;
+        {
+            std::lock_guard<std::mutex> lock(g_validator_state_write_mutex);
+            PublishValidatorNetworkState(std::make_shared<const ValidatorNetworkState>());
+        }
+        {
+            std::lock_guard<std::mutex> lock(g_checkpoint_mutex);
+            g_checkpoint_signatures.clear();
+            g_checkpoint_signatures_order.clear();
+            g_aggregate_key_cache.clear();
+        }
+        {
+            std::lock_guard<std::mutex> lock(g_checkpoint_votes_mutex);
+            g_checkpoint_votes.clear();
+            g_checkpoint_votes_order.clear();
+        }
+        {
+            std::lock_guard<std::mutex> lock(g_classified_blocks_mutex);
+            g_classified_blocks.clear();
+            g_classified_blocks_order.clear();
+        }
+        g_finalized_block = nullptr;
         
         // Initialize consensus monitoring
         MonitorHybridConsensusPerformance();
@@ -94,7 +262,7 @@ bool ValidateBlockHybridConsensus(const CBlock& block, const CBlockIndex* pindex
             }
             
             // Validate checkpoint signatures
-            if (!ValidateCheckpointSignatures(checkpoint, g_validator_state)) {
+            if (!ValidateCheckpointSignatures(checkpoint, *GetValidatorNetworkState())) {
                 LogPrintf("Bitcoin Decentral: Invalid checkpoint signatures for block %s\n",
                          block.GetHash().ToString());
                 return false;
@@ -129,17 +297,19 @@ bool CreateCheckpoint(const CBlock& block, const CBlockIndex* pindex,
         ss << checkpoint.timestamp;
         checkpoint.checkpoint_hash = ss.GetHash();
         
-        // Select validators for this checkpoint
-        std::vector<uint256> selected_validators = SelectValidatorsForCheckpoint(g_validator_state, pindex->nHeight);
-        
-        // Generate validator signatures (simplified for implementation)
-        for (const auto& validator_id : selected_validators) {
-            // In a real implementation, this would involve cryptographic signatures
-            checkpoint.validator_signatures.push_back(validator_id);
+        // Attach the validators' signature, if it has been received
+        {
+            std::lock_guard<std::mutex> lock(g_checkpoint_mutex);
+            auto it = g_checkpoint_signatures.find(checkpoint.block_hash);
+            if (it != g_checkpoint_signatures.end()) {
+                checkpoint.signer_bitmap = it->second.first;
+                checkpoint.signature = it->second.second;
+            }
         }
         
-        LogPrintf("Bitcoin Decentral: Created checkpoint %s for block %s at height %d\n",
-                 checkpoint.checkpoint_hash.ToString(), block.GetHash().ToString(), pindex->nHeight);
+        LogPrintf("Bitcoin Decentral: Created checkpoint %s for block %s at height %d (%s)\n",
+                 checkpoint.checkpoint_hash.ToString(), block.GetHash().ToString(), pindex->nHeight,
+                 checkpoint.signature.empty() ? "unsigned" : "signed");
         
         return true;
     } catch (const std::exception& e) {
@@ -154,19 +324,36 @@ bool CreateCheckpoint(const CBlock& block, const CBlockIndex* pindex,
 bool ValidateCheckpointSignatures(const CheckpointInfo& checkpoint,
                                  const ValidatorNetworkState& validator_state) {
     try {
-        int valid_signatures = 0;
-        int required_signatures = (validator_state.active_validators.size() * 2) / 3 + 1;
+        // The threshold is taken of the committee selected for the
+        // checkpoint, which may be much smaller than the active set
+        const auto committee_bitmap = GetCheckpointSignerBitmap(validator_state, checkpoint.height, checkpoint.block_hash);
+        size_t committee_size{0};
+        for (unsigned char byte : committee_bitmap) {
+            committee_size += std::popcount(byte);
+        }
+        const size_t required_signatures = GetCheckpointSignatureThreshold(committee_size);
         
-        for (const auto& signature : checkpoint.validator_signatures) {
-            auto it = validator_state.active_validators.find(signature);
-            if (it != validator_state.active_validators.end() && it->second.is_active) {
-                valid_signatures++;
+        const auto signer_keys = GetCheckpointSignerKeys(checkpoint.signer_bitmap, validator_state);
+        if (!signer_keys) {
+            LogPrintf("Bitcoin Decentral: Checkpoint validation: invalid signer bitmap\n");
+            return false;
+        }
+        for (size_t i = 0; i < committee_bitmap.size(); ++i) {
+            if (checkpoint.signer_bitmap[i] & ~committee_bitmap[i]) {
+                LogPrintf("Bitcoin Decentral: Checkpoint validation: signer outside the committee\n");
+                return false;
             }
         }
         
-        bool is_valid = valid_signatures >= required_signatures;
-        LogPrintf("Bitcoin Decentral: Checkpoint validation: %d/%d valid signatures (required: %d)\n",
-                 valid_signatures, (int)checkpoint.validator_signatures.size(), required_signatures);
+        // One signature by the signers' aggregate key stands for all of them
+        bool is_valid = signer_keys->size() >= required_signatures && checkpoint.signature.size() == 64;
+        if (is_valid) {
+            const auto aggregate_key = GetAggregateKey(*signer_keys);
+            is_valid = aggregate_key && aggregate_key->VerifySchnorr(checkpoint.checkpoint_hash, checkpoint.signature);
+        }
+        LogPrintf("Bitcoin Decentral: Checkpoint validation: %s signature by %d/%d committee validators (required: %d)\n",
+                 is_valid ? "valid" : "invalid", (int)signer_keys->size(), (int)committee_size,
+                 (int)required_signatures);
         
         return is_valid;
     } catch (const std::exception& e) {
@@ -175,20 +362,515 @@ bool ValidateCheckpointSignatures(const CheckpointInfo& checkpoint,
     }
 }
 
+size_t GetCheckpointSignatureThreshold(size_t committee_size) {
+    return committee_size * 2 / 3 + 1;
+}
+
+uint256 GetCheckpointNonceHash(const uint256& checkpoint_hash, const CheckpointNonce& nonce) {
+    return (TaggedHash("BitcoinDecentral/CheckpointNonce") << checkpoint_hash << nonce).GetSHA256();
+}
+
+struct CheckpointSigningSession::State {
+    secp256k1_keypair keypair;
+    secp256k1_musig_secnonce secnonce;
+    XOnlyPubKey key;
+    uint256 checkpoint_hash;
+};
+
+CheckpointSigningSession::CheckpointSigningSession(const CKey& key, const uint256& checkpoint_hash,
+                                                   const std::vector<XOnlyPubKey>& committee_keys) {
+    if (!key.IsValid() ||
+        std::find(committee_keys.begin(), committee_keys.end(), XOnlyPubKey(key.GetPubKey())) == committee_keys.end()) {
+        return;
+    }
+    
+    secp256k1_context* ctx = GetSigningContext();
+    auto state = make_secure_unique<State>();
+    state->key = XOnlyPubKey(key.GetPubKey());
+    state->checkpoint_hash = checkpoint_hash;
+    
+    // Keys are aggregated with even Y, so a key with odd Y signs negated
+    std::array<unsigned char, 32> seckey;
+    std::memcpy(seckey.data(), key.data(), seckey.size());
+    secp256k1_xonly_pubkey xonly_pubkey;
+    int parity;
+    bool keypair_ok = secp256k1_keypair_create(ctx, &state->keypair, seckey.data()) &&
+                      secp256k1_keypair_xonly_pub(ctx, &xonly_pubkey, &parity, &state->keypair);
+    if (keypair_ok && parity) {
+        keypair_ok = secp256k1_ec_seckey_negate(ctx, seckey.data()) &&
+                     secp256k1_keypair_create(ctx, &state->keypair, seckey.data());
+    }
+    memory_cleanse(seckey.data(), seckey.size());
+    
+    // The signing set is not known yet, so the nonce is not tied to one
+    secp256k1_pubkey pubkey;
+    if (!keypair_ok || !secp256k1_keypair_pub(ctx, &pubkey, &state->keypair)) {
+        return;
+    }
+    
+    std::array<unsigned char, 32> session_secrand;
+    GetStrongRandBytes(session_secrand);
+    secp256k1_musig_pubnonce pubnonce;
+    if (!secp256k1_musig_nonce_gen(ctx, &state->secnonce, &pubnonce, session_secrand.data(), nullptr, &pubkey,
+                                   checkpoint_hash.begin(), nullptr, nullptr) ||
+        !secp256k1_musig_pubnonce_serialize(ctx, m_signed_nonce.nonce.data(), &pubnonce) ||
+        !key.SignSchnorr(GetCheckpointNonceHash(checkpoint_hash, m_signed_nonce.nonce), m_signed_nonce.signature,
+                         nullptr, GetRandHash())) {
+        return;
+    }
+    m_state = std::move(state);
+}
+
+CheckpointSigningSession::~CheckpointSigningSession() = default;
+
+/**
+ * Parse the signers' nonces and start a MuSig2 session over them
+ */
+static bool ProcessNonces(const std::vector<CheckpointNonce>& nonces, const uint256& checkpoint_hash,
+                          const secp256k1_musig_keyagg_cache& keyagg_cache, secp256k1_musig_session& session) {
+    std::vector<secp256k1_musig_pubnonce> pubnonces(nonces.size());
+    std::vector<const secp256k1_musig_pubnonce*> pubnonce_ptrs;
+    pubnonce_ptrs.reserve(nonces.size());
+    for (size_t i = 0; i < nonces.size(); ++i) {
+        if (!secp256k1_musig_pubnonce_parse(secp256k1_context_static, &pubnonces[i], nonces[i].data())) {
+            return false;
+        }
+        pubnonce_ptrs.push_back(&pubnonces[i]);
+    }
+    
+    secp256k1_musig_aggnonce aggnonce;
+    return !nonces.empty() &&
+           secp256k1_musig_nonce_agg(secp256k1_context_static, &aggnonce, pubnonce_ptrs.data(), pubnonce_ptrs.size()) &&
+           secp256k1_musig_nonce_process(secp256k1_context_static, &session, &aggnonce, checkpoint_hash.begin(), &keyagg_cache);
+}
+
+std::optional<CheckpointPartialSignature> CheckpointSigningSession::Sign(const std::vector<XOnlyPubKey>& signer_keys,
+                                                                         const std::vector<CheckpointNonce>& nonces) {
+    if (!m_state || nonces.size() != signer_keys.size() ||
+        std::find(signer_keys.begin(), signer_keys.end(), m_state->key) == signer_keys.end()) {
+        return std::nullopt;
+    }
+    
+    secp256k1_musig_keyagg_cache keyagg_cache;
+    secp256k1_xonly_pubkey aggregate_key;
+    secp256k1_musig_session session;
+    if (!AggregateKeys(signer_keys, keyagg_cache, aggregate_key) ||
+        !ProcessNonces(nonces, m_state->checkpoint_hash, keyagg_cache, session)) {
+        return std::nullopt;
+    }
+    
+    secp256k1_context* ctx = GetSigningContext();
+    secp256k1_musig_partial_sig partial_sig;
+    const bool signed_ok = secp256k1_musig_partial_sign(ctx, &partial_sig, &m_state->secnonce, &m_state->keypair,
+                                                        &keyagg_cache, &session);
+    
+    // The secret nonce is spent, whatever the outcome
+    m_state.reset();
+    
+    CheckpointPartialSignature result;
+    if (!signed_ok || !secp256k1_musig_partial_sig_serialize(ctx, result.data(), &partial_sig)) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+std::optional<std::vector<XOnlyPubKey>> GetCheckpointSignerKeys(const std::vector<unsigned char>& signer_bitmap,
+                                                               const ValidatorNetworkState& state) {
+    const size_t validator_count = state.active_validators.size();
+    if (signer_bitmap.size() != (validator_count + 7) / 8) {
+        return std::nullopt;
+    }
+    
+    std::vector<XOnlyPubKey> keys;
+    size_t position = 0;
+    for (const auto& [validator_id, validator_info] : state.active_validators) {
+        if ((signer_bitmap[position / 8] >> (position % 8)) & 1) {
+            const XOnlyPubKey key{validator_info.public_key};
+            if (!validator_info.is_active || !key.IsFullyValid()) {
+                return std::nullopt;
+            }
+            keys.push_back(key);
+        }
+        ++position;
+    }
+    
+    // Padding bits must be clear, so each signer set has one encoding
+    if (validator_count % 8 && signer_bitmap.back() >> (validator_count % 8)) {
+        return std::nullopt;
+    }
+    return keys;
+}
+
+std::vector<uint256> GetCheckpointSigners(const CheckpointInfo& checkpoint,
+                                         const ValidatorNetworkState& state) {
+    std::vector<uint256> signers;
+    if (!GetCheckpointSignerKeys(checkpoint.signer_bitmap, state)) {
+        return signers;
+    }
+    
+    size_t position = 0;
+    for (const auto& [validator_id, validator_info] : state.active_validators) {
+        if ((checkpoint.signer_bitmap[position / 8] >> (position % 8)) & 1) {
+            signers.push_back(validator_id);
+        }
+        ++position;
+    }
+    return signers;
+}
+
+bool AggregateCheckpointSignature(const uint256& checkpoint_hash, const std::vector<XOnlyPubKey>& signer_keys,
+                                  const std::vector<CheckpointNonce>& nonces,
+                                  const std::vector<CheckpointPartialSignature>& partial_signatures,
+                                  std::vector<unsigned char>& signature) {
+    if (nonces.size() != signer_keys.size() || partial_signatures.size() != signer_keys.size()) {
+        return false;
+    }
+    
+    secp256k1_musig_keyagg_cache keyagg_cache;
+    secp256k1_xonly_pubkey aggregate_key;
+    secp256k1_musig_session session;
+    if (!AggregateKeys(signer_keys, keyagg_cache, aggregate_key) ||
+        !ProcessNonces(nonces, checkpoint_hash, keyagg_cache, session)) {
+        return false;
+    }
+    
+    std::vector<secp256k1_musig_partial_sig> partial_sigs(partial_signatures.size());
+    std::vector<const secp256k1_musig_partial_sig*> partial_sig_ptrs;
+    partial_sig_ptrs.reserve(partial_signatures.size());
+    for (size_t i = 0; i < partial_signatures.size(); ++i) {
+        if (!secp256k1_musig_partial_sig_parse(secp256k1_context_static, &partial_sigs[i], partial_signatures[i].data())) {
+            return false;
+        }
+        partial_sig_ptrs.push_back(&partial_sigs[i]);
+    }
+    
+    // A bad partial signature only shows in the aggregate, which is checked
+    // here rather than when the checkpoint is validated
+    signature.resize(64);
+    unsigned char aggregate_key_bytes[32];
+    secp256k1_xonly_pubkey_serialize(secp256k1_context_static, aggregate_key_bytes, &aggregate_key);
+    return secp256k1_musig_partial_sig_agg(secp256k1_context_static, signature.data(), &session,
+                                           partial_sig_ptrs.data(), partial_sig_ptrs.size()) &&
+           XOnlyPubKey{aggregate_key_bytes}.VerifySchnorr(checkpoint_hash, signature);
+}
+
+void AddCheckpointSignature(const uint256& block_hash, const std::vector<unsigned char>& signer_bitmap,
+                            const std::vector<unsigned char>& signature) {
+    std::lock_guard<std::mutex> lock(g_checkpoint_mutex);
+    
+    const bool inserted = g_checkpoint_signatures.insert_or_assign(block_hash, std::make_pair(signer_bitmap, signature)).second;
+    if (inserted) {
+        g_checkpoint_signatures_order.push_back(block_hash);
+    }
+    while (g_checkpoint_signatures_order.size() > params::MAX_CHECKPOINT_SIGNATURES) {
+        g_checkpoint_signatures.erase(g_checkpoint_signatures_order.front());
+        g_checkpoint_signatures_order.pop_front();
+    }
+}
+
+std::vector<unsigned char> GetCheckpointSignerBitmap(const ValidatorNetworkState& state, int checkpoint_height,
+                                                     const uint256& block_hash) {
+    std::vector<uint256> selected = SelectValidatorsForCheckpoint(state, checkpoint_height, block_hash);
+    std::sort(selected.begin(), selected.end());
+    
+    std::vector<unsigned char> signer_bitmap((state.active_validators.size() + 7) / 8);
+    size_t position = 0;
+    for (const auto& [validator_id, validator_info] : state.active_validators) {
+        if (std::binary_search(selected.begin(), selected.end(), validator_id)) {
+            signer_bitmap[position / 8] |= 1 << (position % 8);
+        }
+        ++position;
+    }
+    return signer_bitmap;
+}
+
+/**
+ * Check a signer's partial signature against its nonce in a MuSig2 session
+ */
+static bool VerifyPartialSignature(const CheckpointPartialSignature& partial_signature, const CheckpointNonce& nonce,
+                                   const XOnlyPubKey& signer_key, const secp256k1_musig_keyagg_cache& keyagg_cache,
+                                   const secp256k1_musig_session& session) {
+    // Signer keys are aggregated with even Y, so they are checked that way
+    const CPubKey pubkey = signer_key.GetEvenCorrespondingCPubKey();
+    secp256k1_musig_partial_sig partial_sig;
+    secp256k1_musig_pubnonce pubnonce;
+    secp256k1_pubkey secp_pubkey;
+    return secp256k1_musig_partial_sig_parse(secp256k1_context_static, &partial_sig, partial_signature.data()) &&
+           secp256k1_musig_pubnonce_parse(secp256k1_context_static, &pubnonce, nonce.data()) &&
+           secp256k1_ec_pubkey_parse(secp256k1_context_static, &secp_pubkey, pubkey.data(), pubkey.size()) &&
+           secp256k1_musig_partial_sig_verify(secp256k1_context_static, &partial_sig, &pubnonce, &secp_pubkey,
+                                              &keyagg_cache, &session);
+}
+
+/**
+ * Get the member numbers marked in a signing bitmap, or nothing if the bitmap
+ * does not match the committee size
+ */
+static std::optional<std::vector<uint32_t>> GetSigningSet(const std::vector<unsigned char>& signing_bitmap,
+                                                          size_t committee_size) {
+    if (signing_bitmap.size() != (committee_size + 7) / 8 ||
+        (committee_size % 8 && signing_bitmap.back() >> (committee_size % 8))) {
+        return std::nullopt;
+    }
+    std::vector<uint32_t> signers;
+    for (uint32_t index = 0; index < committee_size; ++index) {
+        if ((signing_bitmap[index / 8] >> (index % 8)) & 1) {
+            signers.push_back(index);
+        }
+    }
+    return signers;
+}
+
+/**
+ * Translate a signing bitmap, by member number, into a signer bitmap by
+ * position among the active validators
+ */
+static std::vector<unsigned char> GetSigningSetBitmap(const std::vector<unsigned char>& committee_bitmap,
+                                                      const std::vector<unsigned char>& signing_bitmap) {
+    std::vector<unsigned char> signer_bitmap(committee_bitmap.size());
+    size_t index = 0;
+    for (size_t position = 0; position < committee_bitmap.size() * 8; ++position) {
+        if (!((committee_bitmap[position / 8] >> (position % 8)) & 1)) continue;
+        if ((signing_bitmap[index / 8] >> (index % 8)) & 1) {
+            signer_bitmap[position / 8] |= 1 << (position % 8);
+        }
+        ++index;
+    }
+    return signer_bitmap;
+}
+
+CheckpointVoteResult AddCheckpointVotes(const CheckpointVoteSet& votes, const ValidatorNetworkState& state) {
+    std::unique_lock<std::mutex> lock(g_checkpoint_votes_mutex);
+    
+    // Votes for a checkpoint not seen yet open an entry, but only once they
+    // carry a nonce signed by one of the committee members. The committee is
+    // selected from this node's validator view, so votes for another one are
+    // not provably invalid.
+    CheckpointVoteEntry new_entry;
+    CheckpointVoteEntry* entry;
+    auto it = g_checkpoint_votes.find(votes.checkpoint_hash);
+    if (it != g_checkpoint_votes.end()) {
+        entry = &it->second;
+        if (votes.height != entry->votes.height || votes.block_hash != entry->votes.block_hash ||
+            votes.signer_bitmap != entry->votes.signer_bitmap) {
+            return CHECKPOINT_VOTES_UNKNOWN_COMMITTEE;
+        }
+        if (entry->is_complete) return CHECKPOINT_VOTES_UNCHANGED;
+    } else {
+        if (votes.nonces.empty()) return CHECKPOINT_VOTES_INVALID;
+        if (votes.signer_bitmap != GetCheckpointSignerBitmap(state, votes.height, votes.block_hash)) {
+            return CHECKPOINT_VOTES_UNKNOWN_COMMITTEE;
+        }
+        auto committee_keys = GetCheckpointSignerKeys(votes.signer_bitmap, state);
+        if (!committee_keys || committee_keys->empty()) {
+            return CHECKPOINT_VOTES_UNKNOWN_COMMITTEE;
+        }
+        new_entry.committee_keys = std::move(*committee_keys);
+        new_entry.votes.height = votes.height;
+        new_entry.votes.block_hash = votes.block_hash;
+        new_entry.votes.checkpoint_hash = votes.checkpoint_hash;
+        new_entry.votes.signer_bitmap = votes.signer_bitmap;
+        entry = &new_entry;
+    }
+    const size_t committee_size = entry->committee_keys.size();
+    
+    std::map<uint32_t, SignedCheckpointNonce> new_nonces;
+    for (const auto& [index, signed_nonce] : votes.nonces) {
+        if (index >= committee_size) return CHECKPOINT_VOTES_INVALID;
+        if (entry->votes.nonces.count(index)) continue;
+        
+        secp256k1_musig_pubnonce pubnonce;
+        const uint256 nonce_hash = GetCheckpointNonceHash(votes.checkpoint_hash, signed_nonce.nonce);
+        if (!secp256k1_musig_pubnonce_parse(secp256k1_context_static, &pubnonce, signed_nonce.nonce.data()) ||
+            !entry->committee_keys[index].VerifySchnorr(nonce_hash, signed_nonce.signature)) {
+            return CHECKPOINT_VOTES_INVALID;
+        }
+        new_nonces.emplace(index, signed_nonce);
+    }
+    
+    // The first signing set seen is adopted, once it is large enough and the
+    // nonces of all its members are in
+    std::vector<unsigned char> signing_bitmap = entry->votes.signing_bitmap;
+    std::vector<uint32_t> signers = entry->signers;
+    std::vector<CheckpointNonce> signer_nonces = entry->signer_nonces;
+    secp256k1_musig_keyagg_cache keyagg_cache = entry->keyagg_cache;
+    std::optional<secp256k1_musig_session> session = entry->session;
+    if (!votes.signing_bitmap.empty() && signing_bitmap.empty()) {
+        auto signing_set = GetSigningSet(votes.signing_bitmap, committee_size);
+        if (!signing_set || signing_set->size() < GetCheckpointSignatureThreshold(committee_size)) {
+            return CHECKPOINT_VOTES_INVALID;
+        }
+        std::vector<XOnlyPubKey> signer_keys;
+        for (uint32_t index : *signing_set) {
+            auto nonce_it = new_nonces.find(index);
+            if (nonce_it != new_nonces.end()) {
+                signer_nonces.push_back(nonce_it->second.nonce);
+            } else if (entry->votes.nonces.count(index)) {
+                signer_nonces.push_back(entry->votes.nonces.at(index).nonce);
+            } else {
+                return CHECKPOINT_VOTES_INVALID;
+            }
+            signer_keys.push_back(entry->committee_keys[index]);
+        }
+        secp256k1_xonly_pubkey aggregate_key;
+        session.emplace();
+        if (!AggregateKeys(signer_keys, keyagg_cache, aggregate_key) ||
+            !ProcessNonces(signer_nonces, votes.checkpoint_hash, keyagg_cache, *session)) {
+            return CHECKPOINT_VOTES_INVALID;
+        }
+        signing_bitmap = votes.signing_bitmap;
+        signers = std::move(*signing_set);
+    }
+    
+    std::map<uint32_t, CheckpointPartialSignature> new_partial_signatures;
+    if (!votes.partial_signatures.empty() && votes.signing_bitmap.empty()) {
+        return CHECKPOINT_VOTES_INVALID;
+    }
+    if (votes.signing_bitmap == signing_bitmap) {
+        for (const auto& [index, partial_signature] : votes.partial_signatures) {
+            auto signer = std::lower_bound(signers.begin(), signers.end(), index);
+            if (signer == signers.end() || *signer != index) return CHECKPOINT_VOTES_INVALID;
+            if (entry->votes.partial_signatures.count(index)) continue;
+            
+            if (!VerifyPartialSignature(partial_signature, signer_nonces[signer - signers.begin()],
+                                        entry->committee_keys[index], keyagg_cache, *session)) {
+                return CHECKPOINT_VOTES_INVALID;
+            }
+            new_partial_signatures.emplace(index, partial_signature);
+        }
+    }
+    
+    if (new_nonces.empty() && new_partial_signatures.empty() && signing_bitmap == entry->votes.signing_bitmap) {
+        return CHECKPOINT_VOTES_UNCHANGED;
+    }
+    
+    if (entry == &new_entry) {
+        entry = &g_checkpoint_votes.emplace(votes.checkpoint_hash, std::move(new_entry)).first->second;
+        g_checkpoint_votes_order.push_back(votes.checkpoint_hash);
+    }
+    entry->votes.nonces.merge(new_nonces);
+    entry->votes.signing_bitmap = signing_bitmap;
+    entry->votes.partial_signatures.merge(new_partial_signatures);
+    entry->signers = std::move(signers);
+    entry->signer_nonces = std::move(signer_nonces);
+    entry->keyagg_cache = keyagg_cache;
+    entry->session = session;
+    
+    // With a partial signature from every member of the signing set, the
+    // checkpoint signature is complete
+    std::vector<unsigned char> signer_bitmap, signature;
+    if (entry->session && entry->votes.partial_signatures.size() == entry->signers.size()) {
+        std::vector<XOnlyPubKey> signer_keys;
+        std::vector<CheckpointPartialSignature> partial_signatures;
+        for (const auto& [index, partial_signature] : entry->votes.partial_signatures) {
+            signer_keys.push_back(entry->committee_keys[index]);
+            partial_signatures.push_back(partial_signature);
+        }
+        entry->is_complete = AggregateCheckpointSignature(votes.checkpoint_hash, signer_keys, entry->signer_nonces,
+                                                          partial_signatures, signature);
+        signer_bitmap = GetSigningSetBitmap(entry->votes.signer_bitmap, entry->votes.signing_bitmap);
+    }
+    const bool is_complete = entry->is_complete;
+    const size_t signer_count = entry->signers.size();
+    
+    while (g_checkpoint_votes_order.size() > params::MAX_CHECKPOINT_VOTE_SETS) {
+        g_checkpoint_votes.erase(g_checkpoint_votes_order.front());
+        g_checkpoint_votes_order.pop_front();
+    }
+    lock.unlock();
+    
+    if (is_complete) {
+        AddCheckpointSignature(votes.block_hash, signer_bitmap, signature);
+        LogPrintf("Bitcoin Decentral: Aggregated signature of %d of %d validators for checkpoint at height %d\n",
+                 (int)signer_count, (int)committee_size, votes.height);
+    }
+    return CHECKPOINT_VOTES_ADDED;
+}
+
+std::optional<CheckpointVoteSet> GetCheckpointVotes(const uint256& checkpoint_hash) {
+    std::lock_guard<std::mutex> lock(g_checkpoint_votes_mutex);
+    auto it = g_checkpoint_votes.find(checkpoint_hash);
+    if (it == g_checkpoint_votes.end()) {
+        return std::nullopt;
+    }
+    return it->second.votes;
+}
+
+/**
+ * Find the highest finalized checkpoint at or below a height whose block is
+ * an ancestor of pindex
+ */
+static const CBlockIndex* FindFinalizedAncestor(const CBlockIndex* pindex, uint32_t height) {
+    if (!pindex) return nullptr;
+    height = std::min<uint32_t>(height, pindex->nHeight);
+    
+    const CBlockIndex* result{nullptr};
+    auto visit = [&](const CheckpointInfo& checkpoint) {
+        if (!checkpoint.is_finalized || checkpoint.height > height) return true;
+        const CBlockIndex* block = pindex->GetAncestor(checkpoint.height);
+        if (block && block->GetBlockHash() == checkpoint.block_hash) {
+            result = block;
+            return false;
+        }
+        return true;
+    };
+    
+    if (g_checkpoint_store) {
+        g_checkpoint_store->ForEachCheckpointDown(height, visit);
+    } else {
+        const auto state = GetValidatorNetworkState();
+        for (auto it = state->recent_checkpoints.rbegin();
+             it != state->recent_checkpoints.rend() && visit(*it); ++it) {}
+    }
+    return result;
+}
+
 /**
  * Finalize checkpoint
  */
-bool FinalizeCheckpoint(CheckpointInfo& checkpoint,
+bool FinalizeCheckpoint(CheckpointInfo& checkpoint, const CBlockIndex* pindex,
                        ValidatorNetworkState& validator_state) {
     try {
+        if (!pindex || pindex->nHeight != static_cast<int>(checkpoint.height) ||
+            pindex->GetBlockHash() != checkpoint.block_hash) {
+            LogPrintf("Bitcoin Decentral: Checkpoint %s does not match its block\n",
+                     checkpoint.checkpoint_hash.ToString());
+            return false;
+        }
+        
+        std::lock_guard<std::mutex> lock(g_finality_mutex);
+        
+        // Finalized checkpoints must form one chain
+        const CBlockIndex* finalized = g_finalized_block;
+        const bool advances = !finalized || pindex->nHeight > finalized->nHeight;
+        if (finalized && (advances ? pindex->GetAncestor(finalized->nHeight) != finalized
+                                   : finalized->GetAncestor(pindex->nHeight) != pindex)) {
+            LogPrintf("Bitcoin Decentral: Checkpoint %s at height %d conflicts with finalized block %s\n",
+                     checkpoint.checkpoint_hash.ToString(), checkpoint.height, finalized->GetBlockHash().ToString());
+            return false;
+        }
+        
         checkpoint.is_finalized = true;
         checkpoint.confirmation_count = params::FINALITY_CONFIRMATION_BLOCKS;
         
+        // Store the checkpoint before moving the watermark to it, so the
+        // stored watermark always has its checkpoint
+        if (g_checkpoint_store) {
+            if (!g_checkpoint_store->WriteCheckpoint(checkpoint) ||
+                (advances && !g_checkpoint_store->WriteFinalizedHeight(checkpoint.height))) {
+                LogPrintf("Bitcoin Decentral: Failed to store checkpoint %s\n", checkpoint.checkpoint_hash.ToString());
+                return false;
+            }
+        }
+        if (advances) {
+            g_finalized_block = pindex;
+        }
+        
         // Add to recent checkpoints
         validator_state.recent_checkpoints.push_back(checkpoint);
         
         // Update last checkpoint height
-        validator_state.last_checkpoint_height = checkpoint.height;
+        validator_state.last_checkpoint_height = std::max(validator_state.last_checkpoint_height, checkpoint.height);
         
         // Distribute rewards to participating validators
         DistributeValidatorRewards(checkpoint, validator_state);
@@ -209,14 +891,94 @@ bool FinalizeCheckpoint(CheckpointInfo& checkpoint,
 bool IsBlockFinalized(const uint256& block_hash, const CBlockIndex* pindex) {
     if (!pindex) return false;
     
-    // Check if there's a finalized checkpoint covering this block
-    for (const auto& checkpoint : g_validator_state.recent_checkpoints) {
-        if (checkpoint.is_finalized && checkpoint.height >= pindex->nHeight) {
-            return true;
-        }
+    // Blocks above the watermark, such as new deposits, are never finalized
+    const CBlockIndex* finalized = g_finalized_block;
+    if (!finalized || pindex->nHeight > finalized->nHeight) {
+        return false;
+    }
+    
+    // Below it, only blocks on the finalized chain are
+    return finalized->GetAncestor(pindex->nHeight) == pindex;
+}
+
+/**
+ * Persist checkpoints to a store
+ */
+void SetCheckpointStore(std::unique_ptr<CheckpointStore> store, const CBlockIndex* tip) {
+    std::lock_guard<std::mutex> lock(g_finality_mutex);
+    g_checkpoint_store = std::move(store);
+    g_finalized_block = nullptr;
+    
+    uint32_t finalized_height{0};
+    if (!g_checkpoint_store || !g_checkpoint_store->ReadFinalizedHeight(finalized_height)) {
+        return;
     }
     
-    return false;
+    // While the chain is behind the watermark, resume from the highest
+    // finalized checkpoint it has reached
+    const CBlockIndex* finalized = FindFinalizedAncestor(tip, finalized_height);
+    g_finalized_block = finalized;
+    if (finalized) {
+        LogPrintf("Bitcoin Decentral: Restored finalized block %s at height %d\n",
+                 finalized->GetBlockHash().ToString(), finalized->nHeight);
+    }
+}
+
+/**
+ * Drop checkpoints above a disconnected block
+ */
+void DisconnectCheckpoints(const CBlockIndex* pindex) {
+    if (!pindex) return;
+    
+    std::lock_guard<std::mutex> lock(g_finality_mutex);
+    ModifyValidatorNetworkState([&](ValidatorNetworkState& state) {
+        auto& checkpoints = state.recent_checkpoints;
+        checkpoints.erase(std::remove_if(checkpoints.begin(), checkpoints.end(),
+                                         [&](const CheckpointInfo& checkpoint) {
+                                             return static_cast<int>(checkpoint.height) > pindex->nHeight;
+                                         }),
+                          checkpoints.end());
+    });
+    if (g_checkpoint_store) {
+        g_checkpoint_store->EraseCheckpointsAbove(pindex->nHeight);
+    }
+    
+    const CBlockIndex* finalized = g_finalized_block;
+    if (!finalized || pindex->GetAncestor(finalized->nHeight) == finalized) {
+        return;
+    }
+    
+    LogPrintf("Bitcoin Decentral: Finalized block %s at height %d was disconnected\n",
+             finalized->GetBlockHash().ToString(), finalized->nHeight);
+    finalized = FindFinalizedAncestor(pindex, pindex->nHeight);
+    g_finalized_block = finalized;
+    if (g_checkpoint_store) {
+        g_checkpoint_store->WriteFinalizedHeight(finalized ? finalized->nHeight : 0);
+    }
+}
+
+/**
+ * Get a stored checkpoint
+ */
+std::optional<CheckpointInfo> GetCheckpoint(uint32_t height) {
+    std::lock_guard<std::mutex> lock(g_finality_mutex);
+    if (g_checkpoint_store) {
+        CheckpointInfo checkpoint;
+        if (!g_checkpoint_store->ReadCheckpoint(height, checkpoint)) return std::nullopt;
+        return checkpoint;
+    }
+    const auto state = GetValidatorNetworkState();
+    for (auto it = state->recent_checkpoints.rbegin(); it != state->recent_checkpoints.rend(); ++it) {
+        if (it->height == height) return *it;
+    }
+    return std::nullopt;
+}
+
+/**
+ * Get the highest finalized block
+ */
+const CBlockIndex* GetFinalizedBlock() {
+    return g_finalized_block;
 }
 
 /**
@@ -386,7 +1148,7 @@ uint64_t CalculateValidatorRewards(const uint256& validator_id,
 bool DistributeValidatorRewards(const CheckpointInfo& checkpoint,
                                ValidatorNetworkState& state) {
     try {
-        for (const auto& validator_id : checkpoint.validator_signatures) {
+        for (const auto& validator_id : GetCheckpointSigners(checkpoint, state)) {
             auto it = state.active_validators.find(validator_id);
             if (it != state.active_validators.end()) {
                 uint64_t reward = CalculateValidatorRewards(validator_id, state);
@@ -408,32 +1170,27 @@ bool DistributeValidatorRewards(const CheckpointInfo& checkpoint,
  * Select validators for checkpoint
  */
 std::vector<uint256> SelectValidatorsForCheckpoint(const ValidatorNetworkState& state,
-                                                  int checkpoint_height) {
+                                                  int checkpoint_height, const uint256& block_hash) {
     std::vector<uint256> selected_validators;
     
     try {
-        // Select validators based on stake-weighted probability
-        std::vector<std::pair<uint256, double>> validator_probabilities;
+        const uint256 seed = (TaggedHash("BitcoinDecentral/CheckpointSelection") << block_hash).GetSHA256();
+        const size_t num_to_select = params::MIN_VALIDATORS_FOR_CONSENSUS;
         
-        for (const auto& [validator_id, validator_info] : state.active_validators) {
-            if (validator_info.is_active) {
-                double probability = CalculateValidatorSelectionProbability(validator_id, state);
-                validator_probabilities.emplace_back(validator_id, probability);
+        // Reuse the sampler of the published state; other states get their own
+        const auto published = GetValidatorNetworkState();
+        if (&state == published.get()) {
+            std::lock_guard<std::mutex> lock(g_sampler_mutex);
+            if (g_sampler_state != published) {
+                g_sampler = std::make_unique<ValidatorSampler>(state);
+                g_sampler_state = published;
             }
+            selected_validators = g_sampler->Select(seed, num_to_select);
+        } else {
+            selected_validators = ValidatorSampler{state}.Select(seed, num_to_select);
         }
         
-        // Sort by probability and select top validators
-        std::sort(validator_probabilities.begin(), validator_probabilities.end(),
-                 [](const auto& a, const auto& b) { return a.second > b.second; });
-        
-        int num_to_select = std::min(params::MIN_VALIDATORS_FOR_CONSENSUS,
-                                   static_cast<int>(validator_probabilities.size()));
-        
-        for (int i = 0; i < num_to_select; ++i) {
-            selected_validators.push_back(validator_probabilities[i].first);
-        }
-        
-        LogPrintf("Bitcoin Decentral: Selected %d validators for checkpoint at height %d\n",
+        LogDebug(BCLog::VALIDATION, "Bitcoin Decentral: Selected %d validators for checkpoint at height %d\n",
                  (int)selected_validators.size(), checkpoint_height);
         
     } catch (const std::exception& e) {
@@ -443,6 +1200,80 @@ std::vector<uint256> SelectValidatorsForCheckpoint(const ValidatorNetworkState&
     return selected_validators;
 }
 
+/**
+ * Get validator selection weight
+ */
+uint64_t GetValidatorSelectionWeight(const ValidatorInfo& validator) {
+    if (!validator.is_active) return 0;
+    return static_cast<uint64_t>(validator.stake_amount * validator.reputation_score);
+}
+
+ValidatorSampler::ValidatorSampler(const ValidatorNetworkState& state) {
+    m_ids.reserve(state.active_validators.size());
+    m_weights.reserve(state.active_validators.size());
+    for (const auto& [validator_id, validator_info] : state.active_validators) {
+        m_ids.push_back(validator_id);
+        m_weights.push_back(GetValidatorSelectionWeight(validator_info));
+    }
+    
+    // Linear-time build: each node adds itself into its parent
+    m_tree.assign(m_ids.size() + 1, 0);
+    for (size_t i = 1; i <= m_ids.size(); ++i) {
+        m_tree[i] += m_weights[i - 1];
+        m_total_weight += m_weights[i - 1];
+        const size_t parent = i + (i & -i);
+        if (parent <= m_ids.size()) m_tree[parent] += m_tree[i];
+    }
+}
+
+void ValidatorSampler::Add(size_t index, int64_t delta) {
+    m_total_weight += delta;
+    for (size_t i = index + 1; i < m_tree.size(); i += i & -i) {
+        m_tree[i] += delta;
+    }
+}
+
+size_t ValidatorSampler::Find(uint64_t target) const {
+    // Descend to the first validator whose cumulative weight exceeds target
+    size_t pos = 0;
+    for (size_t step = std::bit_floor(m_ids.size()); step > 0; step >>= 1) {
+        if (pos + step < m_tree.size() && m_tree[pos + step] <= target) {
+            pos += step;
+            target -= m_tree[pos];
+        }
+    }
+    return pos;
+}
+
+bool ValidatorSampler::Update(const uint256& validator_id, uint64_t weight) {
+    auto it = std::lower_bound(m_ids.begin(), m_ids.end(), validator_id);
+    if (it == m_ids.end() || *it != validator_id) return false;
+    
+    const size_t index = it - m_ids.begin();
+    Add(index, static_cast<int64_t>(weight - m_weights[index]));
+    m_weights[index] = weight;
+    return true;
+}
+
+std::vector<uint256> ValidatorSampler::Select(const uint256& seed, size_t count) {
+    std::vector<uint256> selected;
+    std::vector<size_t> drawn;
+    FastRandomContext rng{seed};
+    
+    // Drawn validators are taken out of the tree until all draws are done
+    while (selected.size() < count && m_total_weight > 0) {
+        const size_t index = Find(rng.randrange(m_total_weight));
+        selected.push_back(m_ids[index]);
+        drawn.push_back(index);
+        Add(index, -static_cast<int64_t>(m_weights[index]));
+    }
+    for (size_t index : drawn) {
+        Add(index, m_weights[index]);
+    }
+    
+    return selected;
+}
+
 /**
  * Calculate validator selection probability
  */
@@ -458,18 +1289,65 @@ double CalculateValidatorSelectionProbability(const uint256& validator_id,
     return stake_proportion * it->second.reputation_score;
 }
 
+/**
+ * Whether an output script is OP_RETURN followed by a push of tag
+ */
+static bool IsTaggedOutput(const CScript& script, const std::array<unsigned char, 4>& tag) {
+    return script.size() >= 2 + tag.size() && script[0] == OP_RETURN && script[1] == tag.size() &&
+           std::equal(tag.begin(), tag.end(), script.begin() + 2);
+}
+
+HybridTransactionType GetHybridTransactionType(const CTransaction& tx) {
+    if (tx.IsCoinBase()) return HYBRID_TX_NONE;
+    for (const CTxOut& output : tx.vout) {
+        if (IsTaggedOutput(output.scriptPubKey, STAKING_OUTPUT_TAG)) return HYBRID_TX_STAKING;
+        if (IsTaggedOutput(output.scriptPubKey, GOVERNANCE_OUTPUT_TAG)) return HYBRID_TX_GOVERNANCE;
+    }
+    return HYBRID_TX_NONE;
+}
+
+std::shared_ptr<const HybridBlockTransactions> GetBlockHybridTransactions(const CBlock& block) {
+    const uint256 block_hash = block.GetHash();
+    {
+        std::lock_guard<std::mutex> lock(g_classified_blocks_mutex);
+        auto it = g_classified_blocks.find(block_hash);
+        if (it != g_classified_blocks.end()) return it->second;
+    }
+    
+    auto result = std::make_shared<HybridBlockTransactions>();
+    for (const auto& tx : block.vtx) {
+        switch (GetHybridTransactionType(*tx)) {
+        case HYBRID_TX_STAKING: result->staking.push_back(tx); break;
+        case HYBRID_TX_GOVERNANCE: result->governance.push_back(tx); break;
+        case HYBRID_TX_NONE: break;
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(g_classified_blocks_mutex);
+    if (g_classified_blocks.emplace(block_hash, result).second) {
+        g_classified_blocks_order.push_back(block_hash);
+    }
+    while (g_classified_blocks_order.size() > params::MAX_CLASSIFIED_BLOCKS) {
+        g_classified_blocks.erase(g_classified_blocks_order.front());
+        g_classified_blocks_order.pop_front();
+    }
+    return result;
+}
+
 /**
  * Get validator network state
  */
-ValidatorNetworkState GetValidatorNetworkState() {
+std::shared_ptr<const ValidatorNetworkState> GetValidatorNetworkState() {
+    std::lock_guard<std::mutex> lock(g_validator_state_mutex);
     return g_validator_state;
 }
 
 /**
  * Update validator network state
  */
-bool UpdateValidatorNetworkState(const ValidatorNetworkState& state) {
-    g_validator_state = state;
+bool UpdateValidatorNetworkState(ValidatorNetworkState state) {
+    std::lock_guard<std::mutex> lock(g_validator_state_write_mutex);
+    PublishValidatorNetworkState(std::make_shared<const ValidatorNetworkState>(std::move(state)));
     return true;
 }
 
@@ -521,13 +1399,14 @@ void MonitorHybridConsensusPerformance() {
  */
 ConsensusStats GetConsensusStatistics() {
     ConsensusStats stats;
+    const auto state = GetValidatorNetworkState();
     
-    stats.total_checkpoints = static_cast<uint32_t>(g_validator_state.recent_checkpoints.size());
-    stats.active_validators = static_cast<uint32_t>(g_validator_state.active_validators.size());
-    stats.total_stake = g_validator_state.total_staked_amount;
+    stats.total_checkpoints = static_cast<uint32_t>(state->recent_checkpoints.size());
+    stats.active_validators = static_cast<uint32_t>(state->active_validators.size());
+    stats.total_stake = state->total_staked_amount;
     
     // Calculate finalized blocks
-    for (const auto& checkpoint : g_validator_state.recent_checkpoints) {
+    for (const auto& checkpoint : state->recent_checkpoints) {
         if (checkpoint.is_finalized) {
             stats.finalized_blocks++;
         }
@@ -579,8 +1458,10 @@ void UpdateValidatorReputationScores(ValidatorNetworkState& state) {
  * Perform periodic maintenance
  */
 void PerformHybridConsensusMaintenance() {
-    CleanupExpiredCheckpoints(g_validator_state);
-    UpdateValidatorReputationScores(g_validator_state);
+    ModifyValidatorNetworkState([](ValidatorNetworkState& state) {
+        CleanupExpiredCheckpoints(state);
+        UpdateValidatorReputationScores(state);
+    });
     MonitorHybridConsensusPerformance();
     
     LogPrintf("Bitcoin Decentral: Performed hybrid consensus maintenance\n");
@@ -1,14 +1,22 @@
 #ifndef BITCOIN_CONSENSUS_HYBRID_H
 #define BITCOIN_CONSENSUS_HYBRID_H
 
+#include <array>
 #include <cstdint>
+#include <functional>
 #include <vector>
 #include <map>
 #include <memory>
+#include <optional>
+#include <string>
 
 class CBlock;
 class CBlockIndex;
+class CKey;
 class CTransaction;
+#include <pubkey.h>
+#include <serialize.h>
+#include <support/allocators/secure.h>
 #include <uint256.h>
 namespace Consensus { struct Params; }
 
@@ -26,6 +34,16 @@ namespace Consensus { struct Params; }
  * - Gradual transition from pure PoW to hybrid consensus
  * - Slashing conditions for malicious validator behavior
  * - On-chain governance through validator voting
+ *
+ * Checkpoints are signed by the validators together with MuSig2 (BIP 327).
+ * A checkpoint carries a bitmap of the active validators that signed and one
+ * BIP340 signature by their aggregate key, so it is verified with a single
+ * signature check however many validators took part.
+ *
+ * Finalized checkpoints form one chain. The highest of them is kept in memory
+ * as the finality watermark, and a block is finalized if it is an ancestor of
+ * the watermark block, which is a skip-list lookup. Checkpoints are persisted
+ * through a CheckpointStore, so finality survives restarts.
  */
 
 namespace consensus {
@@ -41,8 +59,8 @@ namespace params {
     // Maximum number of active validators
     static const int MAX_ACTIVE_VALIDATORS = 100;
     
-    // Minimum number of validators for consensus
-    static const int MIN_VALIDATORS_FOR_CONSENSUS = 67; // 2/3 + 1
+    // Number of validators selected to sign each checkpoint
+    static const int MIN_VALIDATORS_FOR_CONSENSUS = 67;
     
     // Checkpoint interval (blocks)
     static const int CHECKPOINT_INTERVAL = 100;
@@ -58,6 +76,19 @@ namespace params {
     
     // Finality confirmation blocks
     static const int FINALITY_CONFIRMATION_BLOCKS = 6;
+    
+    // Number of signer sets whose aggregate key is kept for verification
+    static const size_t CHECKPOINT_KEY_CACHE_SIZE = 16;
+    
+    // Number of received checkpoint signatures kept until their block arrives
+    static const size_t MAX_CHECKPOINT_SIGNATURES = 1000;
+    
+    // Number of checkpoints whose votes are being collected
+    static const size_t MAX_CHECKPOINT_VOTE_SETS = 100;
+    
+    // Number of recent blocks whose staking and governance transactions are
+    // kept, to undo them on reorg without classifying the block again
+    static const size_t MAX_CLASSIFIED_BLOCKS = 100;
 }
 
 /**
@@ -86,13 +117,19 @@ struct ValidatorInfo {
 struct CheckpointInfo {
     uint32_t height;                // Checkpoint block height
     uint256 block_hash;             // Block hash at checkpoint
-    uint256 checkpoint_hash;        // Checkpoint hash
-    std::vector<uint256> validator_signatures; // Validator signatures
+    uint256 checkpoint_hash;        // Checkpoint hash, the message validators sign
+    std::vector<unsigned char> signer_bitmap; // Signing active validators, by position in validator ID order
+    std::vector<unsigned char> signature;     // MuSig2 aggregate BIP340 signature of the signers
     uint32_t timestamp;             // Checkpoint timestamp
     bool is_finalized;              // Whether checkpoint is finalized
     uint32_t confirmation_count;    // Number of confirmations
     
     CheckpointInfo() : height(0), timestamp(0), is_finalized(false), confirmation_count(0) {}
+    
+    SERIALIZE_METHODS(CheckpointInfo, obj) {
+        READWRITE(obj.height, obj.block_hash, obj.checkpoint_hash, obj.signer_bitmap, obj.signature,
+                  obj.timestamp, obj.is_finalized, obj.confirmation_count);
+    }
 };
 
 /**
@@ -156,14 +193,174 @@ bool CreateCheckpoint(const CBlock& block, const CBlockIndex* pindex,
 
 /**
  * Validate checkpoint signatures
+ *
+ * The signers must be members of the committee selected for the checkpoint,
+ * and at least GetCheckpointSignatureThreshold() of them.
  */
 bool ValidateCheckpointSignatures(const CheckpointInfo& checkpoint,
                                  const ValidatorNetworkState& validator_state);
 
+/**
+ * Checkpoint signing
+ */
+
+/** Serialized MuSig2 public nonce and partial signature of one signer */
+using CheckpointNonce = std::array<unsigned char, 66>;
+using CheckpointPartialSignature = std::array<unsigned char, 32>;
+
+/**
+ * A signer's nonce with the signer's BIP340 signature of it, so that relaying
+ * nodes can tell it from a forged one
+ */
+struct SignedCheckpointNonce {
+    CheckpointNonce nonce{};
+    std::array<unsigned char, 64> signature{};
+    
+    SERIALIZE_METHODS(SignedCheckpointNonce, obj) {
+        READWRITE(obj.nonce, obj.signature);
+    }
+};
+
+/**
+ * Get the number of signers a checkpoint needs from a committee of the given
+ * size: a two-thirds majority
+ */
+size_t GetCheckpointSignatureThreshold(size_t committee_size);
+
+/**
+ * Get the message a signer signs to vouch for its nonce
+ */
+uint256 GetCheckpointNonceHash(const uint256& checkpoint_hash, const CheckpointNonce& nonce);
+
+/**
+ * One validator's part in signing a checkpoint with MuSig2
+ *
+ * Every committee member opens a session and publishes its nonce. Once it
+ * holds the nonces of a signer set that includes it, in signer order, it
+ * publishes its partial signature for that set. A session signs at most
+ * once, so a nonce is never reused.
+ */
+class CheckpointSigningSession
+{
+public:
+    CheckpointSigningSession(const CKey& key, const uint256& checkpoint_hash,
+                             const std::vector<XOnlyPubKey>& committee_keys);
+    ~CheckpointSigningSession();
+    
+    bool IsValid() const { return m_state != nullptr; }
+    const CheckpointNonce& GetNonce() const { return m_signed_nonce.nonce; }
+    const SignedCheckpointNonce& GetSignedNonce() const { return m_signed_nonce; }
+    
+    std::optional<CheckpointPartialSignature> Sign(const std::vector<XOnlyPubKey>& signer_keys,
+                                                   const std::vector<CheckpointNonce>& nonces);
+    
+private:
+    struct State;
+    secure_unique_ptr<State> m_state;
+    SignedCheckpointNonce m_signed_nonce{};
+};
+
+/**
+ * Get the keys of the validators marked in a signer bitmap, in bitmap order,
+ * or nothing if the bitmap does not match the active validators
+ */
+std::optional<std::vector<XOnlyPubKey>> GetCheckpointSignerKeys(const std::vector<unsigned char>& signer_bitmap,
+                                                               const ValidatorNetworkState& state);
+
+/**
+ * Get the IDs of the validators marked in a checkpoint's signer bitmap
+ */
+std::vector<uint256> GetCheckpointSigners(const CheckpointInfo& checkpoint,
+                                         const ValidatorNetworkState& state);
+
+/**
+ * Combine the signers' partial signatures into the checkpoint signature
+ *
+ * Returns false if any partial signature is invalid.
+ */
+bool AggregateCheckpointSignature(const uint256& checkpoint_hash, const std::vector<XOnlyPubKey>& signer_keys,
+                                  const std::vector<CheckpointNonce>& nonces,
+                                  const std::vector<CheckpointPartialSignature>& partial_signatures,
+                                  std::vector<unsigned char>& signature);
+
+/**
+ * Record the validator signature of the checkpoint at a block, to be
+ * attached by CreateCheckpoint
+ */
+void AddCheckpointSignature(const uint256& block_hash, const std::vector<unsigned char>& signer_bitmap,
+                            const std::vector<unsigned char>& signature);
+
+/**
+ * Checkpoint votes
+ *
+ * Validators exchange their nonces and partial signatures as vote sets. A
+ * node merges every vote set it receives into one set per checkpoint, so it
+ * relays a single aggregate however many validators have voted.
+ *
+ * Committee members need not all sign. The first member to sign picks the
+ * signing set, a threshold-sized subset of the members whose nonces it holds,
+ * and the others sign for the set they find in the merged votes. Once every
+ * member of the signing set has signed, the node combines the partial
+ * signatures into the checkpoint signature, signed by that set.
+ */
+
+/**
+ * Votes for one checkpoint. Members are numbered by their position in the
+ * signer bitmap, which must be the committee selected for the checkpoint.
+ * The signing bitmap marks, by member number, the signing set the partial
+ * signatures are for; it stays empty until a member signs.
+ */
+struct CheckpointVoteSet {
+    uint32_t height{0};
+    uint256 block_hash;
+    uint256 checkpoint_hash;
+    std::vector<unsigned char> signer_bitmap;
+    std::map<uint32_t, SignedCheckpointNonce> nonces;
+    std::vector<unsigned char> signing_bitmap;
+    std::map<uint32_t, CheckpointPartialSignature> partial_signatures;
+    
+    SERIALIZE_METHODS(CheckpointVoteSet, obj) {
+        READWRITE(obj.height, obj.block_hash, obj.checkpoint_hash, obj.signer_bitmap, obj.nonces,
+                  obj.signing_bitmap, obj.partial_signatures);
+    }
+};
+
+/**
+ * Get the signer bitmap of the validators selected for the checkpoint at a
+ * block
+ */
+std::vector<unsigned char> GetCheckpointSignerBitmap(const ValidatorNetworkState& state, int checkpoint_height,
+                                                     const uint256& block_hash);
+
+enum CheckpointVoteResult {
+    CHECKPOINT_VOTES_INVALID,           // Malformed, or a nonce or partial signature failed to verify
+    CHECKPOINT_VOTES_UNKNOWN_COMMITTEE, // The committee differs from this node's validator view, which may lag
+    CHECKPOINT_VOTES_UNCHANGED,         // Nothing that was not already known
+    CHECKPOINT_VOTES_ADDED              // New votes were merged
+};
+
+/**
+ * Merge a vote set into the votes held for its checkpoint
+ *
+ * Every new nonce and partial signature is verified before any is merged, so
+ * an invalid vote set changes nothing. The first nonce seen from a member
+ * is kept, and so is the first signing set: partial signatures for another
+ * set are ignored, as their signers cannot sign again.
+ */
+CheckpointVoteResult AddCheckpointVotes(const CheckpointVoteSet& votes, const ValidatorNetworkState& state);
+
+/**
+ * Get the merged votes for a checkpoint
+ */
+std::optional<CheckpointVoteSet> GetCheckpointVotes(const uint256& checkpoint_hash);
+
 /**
  * Finalize checkpoint
+ *
+ * pindex is the checkpoint block. Fails if the checkpoint conflicts with an
+ * already finalized one.
  */
-bool FinalizeCheckpoint(CheckpointInfo& checkpoint,
+bool FinalizeCheckpoint(CheckpointInfo& checkpoint, const CBlockIndex* pindex,
                        ValidatorNetworkState& validator_state);
 
 /**
@@ -171,6 +368,63 @@ bool FinalizeCheckpoint(CheckpointInfo& checkpoint,
  */
 bool IsBlockFinalized(const uint256& block_hash, const CBlockIndex* pindex);
 
+/**
+ * Checkpoint persistence
+ */
+
+/**
+ * Persistent storage of checkpoints by height, implemented by the node on
+ * top of its database
+ */
+class CheckpointStore
+{
+public:
+    virtual ~CheckpointStore() = default;
+    
+    /** Write a checkpoint, replacing any other at its height */
+    virtual bool WriteCheckpoint(const CheckpointInfo& checkpoint) = 0;
+    
+    /** Read the checkpoint at a height */
+    virtual bool ReadCheckpoint(uint32_t height, CheckpointInfo& checkpoint) const = 0;
+    
+    /**
+     * Visit the checkpoints at or below a height, highest first, until fn
+     * returns false
+     */
+    virtual void ForEachCheckpointDown(uint32_t height, const std::function<bool(const CheckpointInfo&)>& fn) const = 0;
+    
+    /** Erase the checkpoints above a height */
+    virtual bool EraseCheckpointsAbove(uint32_t height) = 0;
+    
+    /** Height of the finality watermark, saved so restarts resume from it */
+    virtual bool WriteFinalizedHeight(uint32_t height) = 0;
+    virtual bool ReadFinalizedHeight(uint32_t& height) const = 0;
+};
+
+/**
+ * Persist checkpoints to a store, or stop persisting them if store is null
+ *
+ * The finality watermark is restored from the store: the highest finalized
+ * checkpoint whose block is an ancestor of tip.
+ */
+void SetCheckpointStore(std::unique_ptr<CheckpointStore> store, const CBlockIndex* tip);
+
+/**
+ * Drop the checkpoints above a block after the blocks above it have been
+ * disconnected, moving the finality watermark back if needed
+ */
+void DisconnectCheckpoints(const CBlockIndex* pindex);
+
+/**
+ * Get the stored checkpoint at a height
+ */
+std::optional<CheckpointInfo> GetCheckpoint(uint32_t height);
+
+/**
+ * Get the highest finalized block, or nullptr if there is none
+ */
+const CBlockIndex* GetFinalizedBlock();
+
 /**
  * Validator management functions
  */
@@ -224,6 +478,45 @@ bool DistributeValidatorRewards(const CheckpointInfo& checkpoint,
  */
 bool ProcessStakingTransaction(const CTransaction& tx, ValidatorNetworkState& state);
 
+/**
+ * Staking and governance transactions in blocks
+ *
+ * These transactions carry an OP_RETURN output whose first push is a 4-byte
+ * tag, in the manner of the witness commitment. Telling them apart only
+ * reads outputs, so a block's transactions are classified in parallel on
+ * check queue workers, and the serial staking and governance state machines
+ * see only the matching transactions, in block order.
+ */
+static constexpr std::array<unsigned char, 4> STAKING_OUTPUT_TAG{'B', 'D', 'S', 'K'};
+static constexpr std::array<unsigned char, 4> GOVERNANCE_OUTPUT_TAG{'B', 'D', 'G', 'V'};
+
+enum HybridTransactionType : uint8_t {
+    HYBRID_TX_NONE,
+    HYBRID_TX_STAKING,
+    HYBRID_TX_GOVERNANCE
+};
+
+/**
+ * Get the type of a transaction from its first tagged output
+ */
+HybridTransactionType GetHybridTransactionType(const CTransaction& tx);
+
+/**
+ * Staking and governance transactions of a block, in block order
+ */
+struct HybridBlockTransactions {
+    std::vector<std::shared_ptr<const CTransaction>> staking;
+    std::vector<std::shared_ptr<const CTransaction>> governance;
+};
+
+/**
+ * Get the staking and governance transactions of a block
+ *
+ * Results are kept for recent blocks, so a block that is disconnected, or
+ * connected again after a reorg, is not classified twice.
+ */
+std::shared_ptr<const HybridBlockTransactions> GetBlockHybridTransactions(const CBlock& block);
+
 /**
  * Validate staking transaction
  */
@@ -298,13 +591,18 @@ bool ExecuteApprovedProposal(const uint256& proposal_id, ValidatorNetworkState&
 
 /**
  * Get validator network state
+ *
+ * Returns the current immutable snapshot, shared by all readers until the
+ * state is next updated. Only copying the pointer takes a lock.
  */
-ValidatorNetworkState GetValidatorNetworkState();
+std::shared_ptr<const ValidatorNetworkState> GetValidatorNetworkState();
 
 /**
  * Update validator network state
+ *
+ * Replaces the snapshot; readers holding the previous one keep it.
  */
-bool UpdateValidatorNetworkState(const ValidatorNetworkState& state);
+bool UpdateValidatorNetworkState(ValidatorNetworkState state);
 
 /**
  * Get active validator count
@@ -322,11 +620,58 @@ uint64_t GetTotalStakedAmount(const ValidatorNetworkState& state);
 double CalculateValidatorSelectionProbability(const uint256& validator_id,
                                              const ValidatorNetworkState& state);
 
+/**
+ * Get the weight of a validator in checkpoint selection: its stake scaled
+ * by its reputation
+ */
+uint64_t GetValidatorSelectionWeight(const ValidatorInfo& validator);
+
+/**
+ * Stake-weighted sampler over the active validators
+ *
+ * Validators are kept in ID order, so every node builds the same sampler
+ * from the same state, with a Fenwick tree over their weights. Building is
+ * O(n); changing a weight and drawing a validator are O(log n).
+ */
+class ValidatorSampler
+{
+public:
+    explicit ValidatorSampler(const ValidatorNetworkState& state);
+    
+    /** Change the weight of a validator; returns false if it is not in the sampler */
+    bool Update(const uint256& validator_id, uint64_t weight);
+    
+    /**
+     * Draw up to count distinct validators, each draw with probability
+     * proportional to weight among those not drawn yet, in draw order
+     *
+     * The draws are determined by the seed. Validators without weight are
+     * never drawn.
+     */
+    std::vector<uint256> Select(const uint256& seed, size_t count);
+    
+    uint64_t GetTotalWeight() const { return m_total_weight; }
+    size_t size() const { return m_ids.size(); }
+    
+private:
+    std::vector<uint256> m_ids;
+    std::vector<uint64_t> m_weights;
+    std::vector<uint64_t> m_tree;       // Fenwick tree over m_weights, 1-based
+    uint64_t m_total_weight{0};
+    
+    void Add(size_t index, int64_t delta);
+    size_t Find(uint64_t target) const;
+};
+
 /**
  * Select validators for checkpoint
+ *
+ * Draws MIN_VALIDATORS_FOR_CONSENSUS validators by stake, seeded by the
+ * checkpoint block hash, as the checkpoint's signing committee. The sampler
+ * of the published validator state is reused until the state is replaced.
  */
 std::vector<uint256> SelectValidatorsForCheckpoint(const ValidatorNetworkState& state,
-                                                  int checkpoint_height);
+                                                  int checkpoint_height, const uint256& block_hash);
 
 /**
  * Validate validator signature
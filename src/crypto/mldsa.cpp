@@ -0,0 +1,880 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bitcoindecentral-build-config.h> // IWYU pragma: keep
+
+#include <crypto/mldsa.h>
+
+#include <crypto/common.h>
+#include <crypto/sha3.h>
+#include <support/cleanse.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
+#if defined(ENABLE_AVX2)
+#include <compat/cpuid.h>
+
+namespace mldsa_avx2
+{
+void NTT(int32_t* a, const int32_t* zetas);
+void InvNTT(int32_t* a, const int32_t* zetas);
+void PointwiseMontgomery(int32_t* c, const int32_t* a, const int32_t* b);
+}
+#endif // ENABLE_AVX2
+
+namespace {
+
+constexpr int N = 256;
+constexpr int32_t Q = 8380417;
+constexpr int D = 13;
+//! Q^-1 mod 2^32
+constexpr int32_t QINV = 58728449;
+//! Primitive 512th root of unity mod Q
+constexpr int64_t ROOT_OF_UNITY = 1753;
+
+constexpr size_t SEED_BYTES = 32;
+constexpr size_t CRH_BYTES = 64;
+constexpr size_t TR_BYTES = 64;
+constexpr size_t POLYT1_PACKED_BYTES = 320;
+constexpr size_t POLYT0_PACKED_BYTES = 416;
+
+/** Powers of the root of unity in Montgomery form and bit-reversed order, as the NTT uses them. */
+constexpr std::array<int32_t, N> ComputeZetas()
+{
+    std::array<int32_t, N> zetas{};
+    for (int i = 0; i < N; ++i) {
+        int exponent = 0;
+        for (int bit = 0; bit < 8; ++bit) exponent |= ((i >> bit) & 1) << (7 - bit);
+        int64_t zeta = (int64_t{1} << 32) % Q;
+        for (int e = 0; e < exponent; ++e) zeta = zeta * ROOT_OF_UNITY % Q;
+        zetas[i] = zeta > Q / 2 ? zeta - Q : zeta;
+    }
+    return zetas;
+}
+
+constexpr std::array<int32_t, N> ZETAS = ComputeZetas();
+
+struct Poly {
+    alignas(32) int32_t coeffs[N];
+};
+
+template <int M>
+using PolyVec = std::array<Poly, M>;
+
+int32_t MontgomeryReduce(int64_t a)
+{
+    const int32_t t = static_cast<int32_t>(a) * QINV;
+    return (a - int64_t{t} * Q) >> 32;
+}
+
+/** Representative of a mod Q in about [-6283008, 6283008], for a below 2^31 - 2^22 */
+int32_t Reduce32(int32_t a)
+{
+    const int32_t t = (a + (1 << 22)) >> 23;
+    return a - t * Q;
+}
+
+/** Add Q if a is negative */
+int32_t CAddQ(int32_t a)
+{
+    return a + ((a >> 31) & Q);
+}
+
+/** Split a into a1 * 2^D + a0 with a0 in (-2^(D-1), 2^(D-1)], returning a1 */
+int32_t Power2Round(int32_t& a0, int32_t a)
+{
+    const int32_t a1 = (a + (1 << (D - 1)) - 1) >> D;
+    a0 = a - (a1 << D);
+    return a1;
+}
+
+/** Split a in [0, Q) into a1 * 2 * gamma2 + a0 with a0 in (-gamma2, gamma2], returning a1 */
+template <int32_t GAMMA2>
+int32_t Decompose(int32_t& a0, int32_t a)
+{
+    int32_t a1 = (a + 127) >> 7;
+    if constexpr (GAMMA2 == (Q - 1) / 32) {
+        a1 = (a1 * 1025 + (1 << 21)) >> 22;
+        a1 &= 15;
+    } else {
+        static_assert(GAMMA2 == (Q - 1) / 88);
+        a1 = (a1 * 11275 + (1 << 23)) >> 24;
+        a1 ^= ((43 - a1) >> 31) & a1;
+    }
+    a0 = a - a1 * 2 * GAMMA2;
+    a0 -= (((Q - 1) / 2 - a0) >> 31) & Q;
+    return a1;
+}
+
+template <int32_t GAMMA2>
+bool MakeHint(int32_t a0, int32_t a1)
+{
+    return a0 > GAMMA2 || a0 < -GAMMA2 || (a0 == -GAMMA2 && a1 != 0);
+}
+
+template <int32_t GAMMA2>
+int32_t UseHint(int32_t a, bool hint)
+{
+    int32_t a0;
+    const int32_t a1 = Decompose<GAMMA2>(a0, a);
+    if (!hint) return a1;
+    if constexpr (GAMMA2 == (Q - 1) / 32) {
+        return a0 > 0 ? (a1 + 1) & 15 : (a1 - 1) & 15;
+    } else {
+        if (a0 > 0) return a1 == 43 ? 0 : a1 + 1;
+        return a1 == 0 ? 43 : a1 - 1;
+    }
+}
+
+namespace portable {
+
+void NTT(int32_t* a, const int32_t* zetas)
+{
+    unsigned k = 0;
+    for (unsigned len = 128; len > 0; len >>= 1) {
+        for (unsigned start = 0; start < N; start += 2 * len) {
+            const int64_t zeta = zetas[++k];
+            for (unsigned j = start; j < start + len; ++j) {
+                const int32_t t = MontgomeryReduce(zeta * a[j + len]);
+                a[j + len] = a[j] - t;
+                a[j] = a[j] + t;
+            }
+        }
+    }
+}
+
+void InvNTT(int32_t* a, const int32_t* zetas)
+{
+    //! mont^2 / 256, undoing the transform's scaling and leaving the result in Montgomery form
+    const int64_t f = 41978;
+    unsigned k = N;
+    for (unsigned len = 1; len < N; len <<= 1) {
+        for (unsigned start = 0; start < N; start += 2 * len) {
+            const int64_t zeta = -zetas[--k];
+            for (unsigned j = start; j < start + len; ++j) {
+                const int32_t t = a[j];
+                a[j] = t + a[j + len];
+                a[j + len] = MontgomeryReduce(zeta * (t - a[j + len]));
+            }
+        }
+    }
+    for (int j = 0; j < N; ++j) a[j] = MontgomeryReduce(f * a[j]);
+}
+
+void PointwiseMontgomery(int32_t* c, const int32_t* a, const int32_t* b)
+{
+    for (int i = 0; i < N; ++i) c[i] = MontgomeryReduce(int64_t{a[i]} * b[i]);
+}
+
+} // namespace portable
+
+/** Forward NTT, output in bit-reversed order; coefficients grow by up to 8 * Q */
+void (*NTT)(int32_t* a, const int32_t* zetas) = portable::NTT;
+/** Inverse NTT multiplying by the Montgomery factor; inputs below Q in absolute value */
+void (*InvNTT)(int32_t* a, const int32_t* zetas) = portable::InvNTT;
+/** c = a * b * 2^-32 coefficient by coefficient, in the NTT domain */
+void (*PointwiseMontgomery)(int32_t* c, const int32_t* a, const int32_t* b) = portable::PointwiseMontgomery;
+
+void PolyNTT(Poly& a) { NTT(a.coeffs, ZETAS.data()); }
+void PolyInvNTT(Poly& a) { InvNTT(a.coeffs, ZETAS.data()); }
+void PolyPointwise(Poly& c, const Poly& a, const Poly& b) { PointwiseMontgomery(c.coeffs, a.coeffs, b.coeffs); }
+
+void PolyAdd(Poly& c, const Poly& a, const Poly& b)
+{
+    for (int i = 0; i < N; ++i) c.coeffs[i] = a.coeffs[i] + b.coeffs[i];
+}
+
+void PolySub(Poly& c, const Poly& a, const Poly& b)
+{
+    for (int i = 0; i < N; ++i) c.coeffs[i] = a.coeffs[i] - b.coeffs[i];
+}
+
+void PolyReduce(Poly& a)
+{
+    for (int32_t& coeff : a.coeffs) coeff = Reduce32(coeff);
+}
+
+void PolyCAddQ(Poly& a)
+{
+    for (int32_t& coeff : a.coeffs) coeff = CAddQ(coeff);
+}
+
+/** Whether any coefficient, reduced to (-Q/2, Q/2], is bound or more in absolute value */
+bool PolyExceedsNorm(const Poly& a, int32_t bound)
+{
+    if (bound > (Q - 1) / 8) return true;
+    bool exceeds = false;
+    for (int32_t coeff : a.coeffs) {
+        // Absolute value without branching on the secret coefficient
+        const int32_t t = coeff - ((coeff >> 31) & 2 * coeff);
+        exceeds |= t >= bound;
+    }
+    return exceeds;
+}
+
+/** Pack the coefficients as bits-wide values f(coefficient), least significant bits first */
+template <typename F>
+void PackPoly(unsigned char* out, const Poly& a, int bits, F f)
+{
+    uint64_t acc = 0;
+    int acc_bits = 0;
+    for (int32_t coeff : a.coeffs) {
+        acc |= uint64_t{static_cast<uint32_t>(f(coeff))} << acc_bits;
+        acc_bits += bits;
+        while (acc_bits >= 8) {
+            *out++ = acc;
+            acc >>= 8;
+            acc_bits -= 8;
+        }
+    }
+}
+
+/** Inverse of PackPoly, with coefficient = f(value) */
+template <typename F>
+void UnpackPoly(Poly& a, const unsigned char* in, int bits, F f)
+{
+    const uint32_t mask = (uint32_t{1} << bits) - 1;
+    uint64_t acc = 0;
+    int acc_bits = 0;
+    for (int32_t& coeff : a.coeffs) {
+        while (acc_bits < bits) {
+            acc |= uint64_t{*in++} << acc_bits;
+            acc_bits += 8;
+        }
+        coeff = f(static_cast<uint32_t>(acc & mask));
+        acc >>= bits;
+        acc_bits -= bits;
+    }
+}
+
+/** Fill a from uniform 23-bit candidates below Q, returning the coefficients set */
+int RejectUniform(int32_t* a, int len, const unsigned char* buf, size_t buflen)
+{
+    int ctr = 0;
+    for (size_t pos = 0; ctr < len && pos + 3 <= buflen; pos += 3) {
+        const uint32_t t = (buf[pos] | uint32_t{buf[pos + 1]} << 8 | uint32_t{buf[pos + 2]} << 16) & 0x7FFFFF;
+        if (t < Q) a[ctr++] = t;
+    }
+    return ctr;
+}
+
+/** Fill a with coefficients in [-eta, eta] from 4-bit candidates, returning the coefficients set */
+template <int ETA>
+int RejectEta(int32_t* a, int len, const unsigned char* buf, size_t buflen)
+{
+    int ctr = 0;
+    for (size_t pos = 0; ctr < len && pos < buflen; ++pos) {
+        for (uint32_t t : {uint32_t{buf[pos]} & 0x0F, uint32_t{buf[pos]} >> 4}) {
+            if (ctr == len) break;
+            if constexpr (ETA == 2) {
+                if (t < 15) a[ctr++] = 2 - static_cast<int32_t>(t - (205 * t >> 10) * 5);
+            } else {
+                static_assert(ETA == 4);
+                if (t < 9) a[ctr++] = 4 - static_cast<int32_t>(t);
+            }
+        }
+    }
+    return ctr;
+}
+
+//! Output blocks of SHAKE128 nearly always enough for a uniform polynomial
+constexpr size_t UNIFORM_BLOCKS = (768 + SHAKE128::RATE_BYTES - 1) / SHAKE128::RATE_BYTES;
+
+/** Sample the matrix entry at nonce by rejection, continuing after the first buflen bytes if needed */
+void PolyUniform(Poly& a, const unsigned char* rho, uint16_t nonce, const unsigned char* buf, size_t buflen)
+{
+    int ctr = RejectUniform(a.coeffs, N, buf, buflen);
+    if (ctr == N) return;
+
+    // Rarely needed: regenerate the stream and read past what was used
+    unsigned char seed[SEED_BYTES + 2];
+    std::memcpy(seed, rho, SEED_BYTES);
+    seed[SEED_BYTES] = nonce;
+    seed[SEED_BYTES + 1] = nonce >> 8;
+    SHAKE128 shake;
+    shake.Write(seed);
+    std::vector<unsigned char> skipped(buflen);
+    shake.Read(skipped);
+    unsigned char block[SHAKE128::RATE_BYTES];
+    while (ctr < N) {
+        shake.Read(block);
+        ctr += RejectUniform(a.coeffs + ctr, N - ctr, block, sizeof(block));
+    }
+}
+
+/** ExpandA: the public matrix, in the NTT domain, generated KECCAK_WAYS entries at a time */
+template <int K, int L>
+void ExpandMatrix(std::vector<Poly>& mat, const unsigned char* rho)
+{
+    constexpr size_t BUFLEN = UNIFORM_BLOCKS * SHAKE128::RATE_BYTES;
+    mat.resize(K * L);
+    std::array<std::array<unsigned char, SEED_BYTES + 2>, KECCAK_WAYS> seeds;
+    std::array<std::array<unsigned char, BUFLEN>, KECCAK_WAYS> bufs;
+    for (int first = 0; first < K * L; first += KECCAK_WAYS) {
+        const size_t ways = std::min<size_t>(KECCAK_WAYS, K * L - first);
+        std::array<Span<const unsigned char>, KECCAK_WAYS> in;
+        std::array<Span<unsigned char>, KECCAK_WAYS> out;
+        for (size_t w = 0; w < ways; ++w) {
+            const int entry = first + w;
+            std::memcpy(seeds[w].data(), rho, SEED_BYTES);
+            seeds[w][SEED_BYTES] = entry % L;
+            seeds[w][SEED_BYTES + 1] = entry / L;
+            in[w] = seeds[w];
+            out[w] = bufs[w];
+        }
+        SHAKE128Many({in.data(), ways}, {out.data(), ways});
+        for (size_t w = 0; w < ways; ++w) {
+            const int entry = first + w;
+            PolyUniform(mat[entry], rho, (entry / L) << 8 | entry % L, bufs[w].data(), BUFLEN);
+        }
+    }
+}
+
+/** ExpandS: a secret polynomial with coefficients in [-eta, eta] */
+template <int ETA>
+void PolyUniformEta(Poly& a, const unsigned char* rhoprime, uint16_t nonce)
+{
+    unsigned char suffix[2] = {static_cast<unsigned char>(nonce), static_cast<unsigned char>(nonce >> 8)};
+    SHAKE256 shake;
+    shake.Write({rhoprime, CRH_BYTES}).Write(suffix);
+    unsigned char block[SHAKE256::RATE_BYTES];
+    int ctr = 0;
+    while (ctr < N) {
+        shake.Read(block);
+        ctr += RejectEta<ETA>(a.coeffs + ctr, N - ctr, block, sizeof(block));
+    }
+    memory_cleanse(block, sizeof(block));
+}
+
+/** ExpandMask: the masking vector y for the attempt at nonce, KECCAK_WAYS polynomials at a time */
+template <int L, int32_t GAMMA1, size_t POLYZ_BYTES>
+void ExpandMask(PolyVec<L>& y, const unsigned char* rhoprime, uint16_t nonce)
+{
+    constexpr int Z_BITS = GAMMA1 == (1 << 17) ? 18 : 20;
+    std::array<std::array<unsigned char, CRH_BYTES + 2>, KECCAK_WAYS> seeds;
+    std::array<std::array<unsigned char, POLYZ_BYTES>, KECCAK_WAYS> bufs;
+    for (int first = 0; first < L; first += KECCAK_WAYS) {
+        const size_t ways = std::min<size_t>(KECCAK_WAYS, L - first);
+        std::array<Span<const unsigned char>, KECCAK_WAYS> in;
+        std::array<Span<unsigned char>, KECCAK_WAYS> out;
+        for (size_t w = 0; w < ways; ++w) {
+            const uint16_t index = L * nonce + first + w;
+            std::memcpy(seeds[w].data(), rhoprime, CRH_BYTES);
+            seeds[w][CRH_BYTES] = index;
+            seeds[w][CRH_BYTES + 1] = index >> 8;
+            in[w] = seeds[w];
+            out[w] = bufs[w];
+        }
+        SHAKE256Many({in.data(), ways}, {out.data(), ways});
+        for (size_t w = 0; w < ways; ++w) {
+            UnpackPoly(y[first + w], bufs[w].data(), Z_BITS, [](uint32_t t) { return GAMMA1 - static_cast<int32_t>(t); });
+        }
+    }
+    for (auto& seed : seeds) memory_cleanse(seed.data(), seed.size());
+    for (auto& buf : bufs) memory_cleanse(buf.data(), buf.size());
+}
+
+/** SampleInBall: the challenge polynomial with tau coefficients of +-1 */
+template <int TAU>
+void PolyChallenge(Poly& c, Span<const unsigned char> ctilde)
+{
+    SHAKE256 shake;
+    shake.Write(ctilde);
+    unsigned char buf[SHAKE256::RATE_BYTES];
+    shake.Read(buf);
+    uint64_t signs = ReadLE64(buf);
+    size_t pos = 8;
+
+    std::fill(std::begin(c.coeffs), std::end(c.coeffs), 0);
+    for (int i = N - TAU; i < N; ++i) {
+        int b;
+        do {
+            if (pos >= sizeof(buf)) {
+                shake.Read(buf);
+                pos = 0;
+            }
+            b = buf[pos++];
+        } while (b > i);
+        c.coeffs[i] = c.coeffs[b];
+        c.coeffs[b] = 1 - 2 * (signs & 1);
+        signs >>= 1;
+    }
+}
+
+template <int K_, int L_, int ETA_, int TAU_, int BETA_, int32_t GAMMA1_, int32_t GAMMA2_, int OMEGA_, size_t CTILDE_BYTES_>
+struct Params {
+    static constexpr int K = K_;
+    static constexpr int L = L_;
+    static constexpr int ETA = ETA_;
+    static constexpr int TAU = TAU_;
+    static constexpr int BETA = BETA_;
+    static constexpr int32_t GAMMA1 = GAMMA1_;
+    static constexpr int32_t GAMMA2 = GAMMA2_;
+    static constexpr int OMEGA = OMEGA_;
+    static constexpr size_t CTILDE_BYTES = CTILDE_BYTES_;
+
+    static constexpr int ETA_BITS = ETA == 2 ? 3 : 4;
+    static constexpr int Z_BITS = GAMMA1 == (1 << 17) ? 18 : 20;
+    static constexpr int W1_BITS = GAMMA2 == (Q - 1) / 88 ? 6 : 4;
+    static constexpr size_t POLYETA_PACKED_BYTES = N * ETA_BITS / 8;
+    static constexpr size_t POLYZ_PACKED_BYTES = N * Z_BITS / 8;
+    static constexpr size_t POLYW1_PACKED_BYTES = N * W1_BITS / 8;
+
+    static constexpr size_t PUBLIC_KEY_BYTES = SEED_BYTES + K * POLYT1_PACKED_BYTES;
+    static constexpr size_t SECRET_KEY_BYTES = 2 * SEED_BYTES + TR_BYTES + (L + K) * POLYETA_PACKED_BYTES + K * POLYT0_PACKED_BYTES;
+    static constexpr size_t SIGNATURE_BYTES = CTILDE_BYTES + L * POLYZ_PACKED_BYTES + OMEGA + K;
+};
+
+using Params44 = Params<4, 4, 2, 39, 78, 1 << 17, (Q - 1) / 88, 80, 32>;
+using Params65 = Params<6, 5, 4, 49, 196, 1 << 19, (Q - 1) / 32, 55, 48>;
+using Params87 = Params<8, 7, 2, 60, 120, 1 << 19, (Q - 1) / 32, 75, 64>;
+
+static_assert(Params44::PUBLIC_KEY_BYTES == 1312 && Params44::SECRET_KEY_BYTES == 2560 && Params44::SIGNATURE_BYTES == 2420);
+static_assert(Params65::PUBLIC_KEY_BYTES == 1952 && Params65::SECRET_KEY_BYTES == 4032 && Params65::SIGNATURE_BYTES == 3309);
+static_assert(Params87::PUBLIC_KEY_BYTES == 2592 && Params87::SECRET_KEY_BYTES == 4896 && Params87::SIGNATURE_BYTES == 4627);
+
+/** t = mat * v in the NTT domain, reduced */
+template <int K, int L>
+void MatrixMultiply(PolyVec<K>& t, const std::vector<Poly>& mat, const PolyVec<L>& v)
+{
+    Poly product;
+    for (int i = 0; i < K; ++i) {
+        PolyPointwise(t[i], mat[i * L], v[0]);
+        for (int j = 1; j < L; ++j) {
+            PolyPointwise(product, mat[i * L + j], v[j]);
+            PolyAdd(t[i], t[i], product);
+        }
+        PolyReduce(t[i]);
+    }
+}
+
+template <typename P>
+void PackEta(unsigned char* out, const Poly& a)
+{
+    PackPoly(out, a, P::ETA_BITS, [](int32_t c) { return P::ETA - c; });
+}
+
+template <typename P>
+void UnpackEta(Poly& a, const unsigned char* in)
+{
+    UnpackPoly(a, in, P::ETA_BITS, [](uint32_t t) { return P::ETA - static_cast<int32_t>(t); });
+}
+
+void PackT0(unsigned char* out, const Poly& a)
+{
+    PackPoly(out, a, D, [](int32_t c) { return (1 << (D - 1)) - c; });
+}
+
+void UnpackT0(Poly& a, const unsigned char* in)
+{
+    UnpackPoly(a, in, D, [](uint32_t t) { return (1 << (D - 1)) - static_cast<int32_t>(t); });
+}
+
+/** H(M') with M' = 0 || len(ctx) || ctx || M, the pure ML-DSA message representative */
+void ComputeMu(unsigned char* mu, Span<const unsigned char> tr, Span<const unsigned char> message, Span<const unsigned char> context)
+{
+    const unsigned char prefix[2] = {0, static_cast<unsigned char>(context.size())};
+    SHAKE256{}.Write(tr).Write(prefix).Write(context).Write(message).Read({mu, CRH_BYTES});
+}
+
+template <typename P>
+void KeyGenInternal(const unsigned char* xi, unsigned char* pk, unsigned char* sk)
+{
+    constexpr int K = P::K, L = P::L;
+
+    unsigned char seedbuf[2 * SEED_BYTES + CRH_BYTES];
+    const unsigned char dims[2] = {K, L};
+    SHAKE256{}.Write({xi, SEED_BYTES}).Write(dims).Read(seedbuf);
+    const unsigned char* rho = seedbuf;
+    const unsigned char* rhoprime = rho + SEED_BYTES;
+    const unsigned char* key = rhoprime + CRH_BYTES;
+
+    std::vector<Poly> mat;
+    ExpandMatrix<K, L>(mat, rho);
+
+    PolyVec<L> s1;
+    PolyVec<K> s2;
+    for (int i = 0; i < L; ++i) PolyUniformEta<P::ETA>(s1[i], rhoprime, i);
+    for (int i = 0; i < K; ++i) PolyUniformEta<P::ETA>(s2[i], rhoprime, L + i);
+
+    PolyVec<L> s1hat = s1;
+    for (Poly& p : s1hat) PolyNTT(p);
+    PolyVec<K> t1, t0;
+    MatrixMultiply<K, L>(t1, mat, s1hat);
+    for (int i = 0; i < K; ++i) {
+        PolyInvNTT(t1[i]);
+        PolyAdd(t1[i], t1[i], s2[i]);
+        PolyCAddQ(t1[i]);
+        for (int j = 0; j < N; ++j) t1[i].coeffs[j] = Power2Round(t0[i].coeffs[j], t1[i].coeffs[j]);
+    }
+
+    // pk = rho || t1
+    std::memcpy(pk, rho, SEED_BYTES);
+    for (int i = 0; i < K; ++i) {
+        PackPoly(pk + SEED_BYTES + i * POLYT1_PACKED_BYTES, t1[i], 10, [](int32_t c) { return c; });
+    }
+
+    // sk = rho || key || tr || s1 || s2 || t0
+    unsigned char* out = sk;
+    std::memcpy(out, rho, SEED_BYTES);
+    out += SEED_BYTES;
+    std::memcpy(out, key, SEED_BYTES);
+    out += SEED_BYTES;
+    SHAKE256{}.Write({pk, P::PUBLIC_KEY_BYTES}).Read({out, TR_BYTES});
+    out += TR_BYTES;
+    for (const Poly& p : s1) {
+        PackEta<P>(out, p);
+        out += P::POLYETA_PACKED_BYTES;
+    }
+    for (const Poly& p : s2) {
+        PackEta<P>(out, p);
+        out += P::POLYETA_PACKED_BYTES;
+    }
+    for (const Poly& p : t0) {
+        PackT0(out, p);
+        out += POLYT0_PACKED_BYTES;
+    }
+
+    memory_cleanse(seedbuf, sizeof(seedbuf));
+    memory_cleanse(s1.data(), sizeof(s1));
+    memory_cleanse(s2.data(), sizeof(s2));
+    memory_cleanse(s1hat.data(), sizeof(s1hat));
+    memory_cleanse(t0.data(), sizeof(t0));
+}
+
+template <typename P>
+void SignInternal(const unsigned char* sk, Span<const unsigned char> message, Span<const unsigned char> context,
+                  const unsigned char* rnd, unsigned char* sig)
+{
+    constexpr int K = P::K, L = P::L;
+
+    const unsigned char* rho = sk;
+    const unsigned char* key = rho + SEED_BYTES;
+    const unsigned char* tr = key + SEED_BYTES;
+    const unsigned char* packed = tr + TR_BYTES;
+    PolyVec<L> s1;
+    PolyVec<K> s2, t0;
+    for (Poly& p : s1) {
+        UnpackEta<P>(p, packed);
+        packed += P::POLYETA_PACKED_BYTES;
+    }
+    for (Poly& p : s2) {
+        UnpackEta<P>(p, packed);
+        packed += P::POLYETA_PACKED_BYTES;
+    }
+    for (Poly& p : t0) {
+        UnpackT0(p, packed);
+        packed += POLYT0_PACKED_BYTES;
+    }
+
+    unsigned char mu[CRH_BYTES];
+    ComputeMu(mu, {tr, TR_BYTES}, message, context);
+    unsigned char rhoprime[CRH_BYTES];
+    SHAKE256{}.Write({key, SEED_BYTES}).Write({rnd, mldsa::RND_SIZE}).Write(mu).Read(rhoprime);
+
+    std::vector<Poly> mat;
+    ExpandMatrix<K, L>(mat, rho);
+    for (Poly& p : s1) PolyNTT(p);
+    for (Poly& p : s2) PolyNTT(p);
+    for (Poly& p : t0) PolyNTT(p);
+
+    PolyVec<L> y, z;
+    PolyVec<K> w1, w0, h;
+    Poly cp;
+    for (uint16_t nonce = 0;; ++nonce) {
+        ExpandMask<L, P::GAMMA1, P::POLYZ_PACKED_BYTES>(y, rhoprime, nonce);
+
+        // w = A * y, split into high and low bits
+        z = y;
+        for (Poly& p : z) PolyNTT(p);
+        MatrixMultiply<K, L>(w1, mat, z);
+        for (int i = 0; i < K; ++i) {
+            PolyInvNTT(w1[i]);
+            PolyCAddQ(w1[i]);
+            for (int j = 0; j < N; ++j) w1[i].coeffs[j] = Decompose<P::GAMMA2>(w0[i].coeffs[j], w1[i].coeffs[j]);
+        }
+
+        // Commit to the high bits: c~ = H(mu || w1)
+        unsigned char w1_packed[K * P::POLYW1_PACKED_BYTES];
+        for (int i = 0; i < K; ++i) {
+            PackPoly(w1_packed + i * P::POLYW1_PACKED_BYTES, w1[i], P::W1_BITS, [](int32_t c) { return c; });
+        }
+        SHAKE256{}.Write(mu).Write(w1_packed).Read({sig, P::CTILDE_BYTES});
+        PolyChallenge<P::TAU>(cp, {sig, P::CTILDE_BYTES});
+        PolyNTT(cp);
+
+        // z = y + c * s1, rejected if it would reveal s1
+        bool reject = false;
+        for (int i = 0; i < L; ++i) {
+            PolyPointwise(z[i], cp, s1[i]);
+            PolyInvNTT(z[i]);
+            PolyAdd(z[i], z[i], y[i]);
+            PolyReduce(z[i]);
+            reject |= PolyExceedsNorm(z[i], P::GAMMA1 - P::BETA);
+        }
+        if (reject) continue;
+
+        // Subtracting c * s2 must not change the high bits of w, nor the low
+        // bits reveal s2
+        for (int i = 0; i < K; ++i) {
+            PolyPointwise(h[i], cp, s2[i]);
+            PolyInvNTT(h[i]);
+            PolySub(w0[i], w0[i], h[i]);
+            PolyReduce(w0[i]);
+            reject |= PolyExceedsNorm(w0[i], P::GAMMA2 - P::BETA);
+        }
+        if (reject) continue;
+
+        // Hints for recovering w1 without t0
+        int hints = 0;
+        for (int i = 0; i < K; ++i) {
+            PolyPointwise(h[i], cp, t0[i]);
+            PolyInvNTT(h[i]);
+            PolyReduce(h[i]);
+            reject |= PolyExceedsNorm(h[i], P::GAMMA2);
+            PolyAdd(w0[i], w0[i], h[i]);
+            for (int j = 0; j < N; ++j) {
+                h[i].coeffs[j] = MakeHint<P::GAMMA2>(w0[i].coeffs[j], w1[i].coeffs[j]);
+                hints += h[i].coeffs[j];
+            }
+        }
+        if (reject || hints > P::OMEGA) continue;
+
+        // sig = c~ || z || h
+        unsigned char* out = sig + P::CTILDE_BYTES;
+        for (const Poly& p : z) {
+            PackPoly(out, p, P::Z_BITS, [](int32_t c) { return P::GAMMA1 - c; });
+            out += P::POLYZ_PACKED_BYTES;
+        }
+        std::memset(out, 0, P::OMEGA + K);
+        int k = 0;
+        for (int i = 0; i < K; ++i) {
+            for (int j = 0; j < N; ++j) {
+                if (h[i].coeffs[j]) out[k++] = j;
+            }
+            out[P::OMEGA + i] = k;
+        }
+        break;
+    }
+
+    memory_cleanse(s1.data(), sizeof(s1));
+    memory_cleanse(s2.data(), sizeof(s2));
+    memory_cleanse(t0.data(), sizeof(t0));
+    memory_cleanse(y.data(), sizeof(y));
+    memory_cleanse(z.data(), sizeof(z));
+    memory_cleanse(w0.data(), sizeof(w0));
+    memory_cleanse(rhoprime, sizeof(rhoprime));
+}
+
+/** Unpack the hint vector, rejecting encodings that are not the unique one for it */
+template <typename P>
+bool UnpackHints(PolyVec<P::K>& h, const unsigned char* in)
+{
+    int k = 0;
+    for (int i = 0; i < P::K; ++i) {
+        std::fill(std::begin(h[i].coeffs), std::end(h[i].coeffs), 0);
+        const int end = in[P::OMEGA + i];
+        if (end < k || end > P::OMEGA) return false;
+        for (int j = k; j < end; ++j) {
+            // Positions are strictly increasing
+            if (j > k && in[j] <= in[j - 1]) return false;
+            h[i].coeffs[in[j]] = 1;
+        }
+        k = end;
+    }
+    for (int j = k; j < P::OMEGA; ++j) {
+        if (in[j]) return false;
+    }
+    return true;
+}
+
+template <typename P>
+bool VerifyInternal(const unsigned char* pk, Span<const unsigned char> message, Span<const unsigned char> context, const unsigned char* sig)
+{
+    constexpr int K = P::K, L = P::L;
+
+    const unsigned char* rho = pk;
+    PolyVec<K> t1;
+    for (int i = 0; i < K; ++i) {
+        UnpackPoly(t1[i], pk + SEED_BYTES + i * POLYT1_PACKED_BYTES, 10, [](uint32_t t) { return static_cast<int32_t>(t); });
+    }
+
+    const Span<const unsigned char> ctilde{sig, P::CTILDE_BYTES};
+    PolyVec<L> z;
+    for (int i = 0; i < L; ++i) {
+        UnpackPoly(z[i], sig + P::CTILDE_BYTES + i * P::POLYZ_PACKED_BYTES, P::Z_BITS,
+                   [](uint32_t t) { return P::GAMMA1 - static_cast<int32_t>(t); });
+        if (PolyExceedsNorm(z[i], P::GAMMA1 - P::BETA)) return false;
+    }
+    PolyVec<K> h;
+    if (!UnpackHints<P>(h, sig + P::CTILDE_BYTES + L * P::POLYZ_PACKED_BYTES)) return false;
+
+    unsigned char tr[TR_BYTES];
+    SHAKE256{}.Write({pk, P::PUBLIC_KEY_BYTES}).Read(tr);
+    unsigned char mu[CRH_BYTES];
+    ComputeMu(mu, tr, message, context);
+
+    Poly cp;
+    PolyChallenge<P::TAU>(cp, ctilde);
+    PolyNTT(cp);
+
+    // w1' = UseHint(h, A * z - c * t1 * 2^d)
+    std::vector<Poly> mat;
+    ExpandMatrix<K, L>(mat, rho);
+    for (Poly& p : z) PolyNTT(p);
+    PolyVec<K> w1;
+    MatrixMultiply<K, L>(w1, mat, z);
+    unsigned char w1_packed[K * P::POLYW1_PACKED_BYTES];
+    for (int i = 0; i < K; ++i) {
+        for (int32_t& coeff : t1[i].coeffs) coeff <<= D;
+        PolyNTT(t1[i]);
+        PolyPointwise(t1[i], cp, t1[i]);
+        PolySub(w1[i], w1[i], t1[i]);
+        PolyReduce(w1[i]);
+        PolyInvNTT(w1[i]);
+        PolyCAddQ(w1[i]);
+        for (int j = 0; j < N; ++j) w1[i].coeffs[j] = UseHint<P::GAMMA2>(w1[i].coeffs[j], h[i].coeffs[j]);
+        PackPoly(w1_packed + i * P::POLYW1_PACKED_BYTES, w1[i], P::W1_BITS, [](int32_t c) { return c; });
+    }
+
+    unsigned char ctilde_check[P::CTILDE_BYTES];
+    SHAKE256{}.Write(mu).Write(w1_packed).Read(ctilde_check);
+    return std::equal(ctilde.begin(), ctilde.end(), ctilde_check);
+}
+
+template <typename P>
+bool KeyGenChecked(Span<const unsigned char> seed, Span<unsigned char> public_key, Span<unsigned char> secret_key)
+{
+    if (seed.size() != mldsa::SEED_SIZE || public_key.size() != P::PUBLIC_KEY_BYTES || secret_key.size() != P::SECRET_KEY_BYTES) return false;
+    KeyGenInternal<P>(seed.data(), public_key.data(), secret_key.data());
+    return true;
+}
+
+template <typename P>
+bool SignChecked(Span<const unsigned char> secret_key, Span<const unsigned char> message, Span<const unsigned char> context,
+                 Span<const unsigned char> rnd, Span<unsigned char> signature)
+{
+    if (secret_key.size() != P::SECRET_KEY_BYTES || context.size() > mldsa::MAX_CONTEXT_SIZE ||
+        rnd.size() != mldsa::RND_SIZE || signature.size() != P::SIGNATURE_BYTES) return false;
+    SignInternal<P>(secret_key.data(), message, context, rnd.data(), signature.data());
+    return true;
+}
+
+template <typename P>
+bool VerifyChecked(Span<const unsigned char> public_key, Span<const unsigned char> message, Span<const unsigned char> context,
+                   Span<const unsigned char> signature)
+{
+    if (public_key.size() != P::PUBLIC_KEY_BYTES || context.size() > mldsa::MAX_CONTEXT_SIZE ||
+        signature.size() != P::SIGNATURE_BYTES) return false;
+    return VerifyInternal<P>(public_key.data(), message, context, signature.data());
+}
+
+#if defined(ENABLE_AVX2)
+/** Check whether the OS has enabled AVX registers. */
+bool AVXEnabled()
+{
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (a & 6) == 6;
+}
+#endif // ENABLE_AVX2
+
+} // namespace
+
+namespace mldsa {
+
+size_t PublicKeySize(ParameterSet params)
+{
+    switch (params) {
+    case ParameterSet::ML_DSA_44: return Params44::PUBLIC_KEY_BYTES;
+    case ParameterSet::ML_DSA_65: return Params65::PUBLIC_KEY_BYTES;
+    case ParameterSet::ML_DSA_87: return Params87::PUBLIC_KEY_BYTES;
+    }
+    return 0;
+}
+
+size_t SecretKeySize(ParameterSet params)
+{
+    switch (params) {
+    case ParameterSet::ML_DSA_44: return Params44::SECRET_KEY_BYTES;
+    case ParameterSet::ML_DSA_65: return Params65::SECRET_KEY_BYTES;
+    case ParameterSet::ML_DSA_87: return Params87::SECRET_KEY_BYTES;
+    }
+    return 0;
+}
+
+size_t SignatureSize(ParameterSet params)
+{
+    switch (params) {
+    case ParameterSet::ML_DSA_44: return Params44::SIGNATURE_BYTES;
+    case ParameterSet::ML_DSA_65: return Params65::SIGNATURE_BYTES;
+    case ParameterSet::ML_DSA_87: return Params87::SIGNATURE_BYTES;
+    }
+    return 0;
+}
+
+bool KeyGen(ParameterSet params, Span<const unsigned char> seed, Span<unsigned char> public_key, Span<unsigned char> secret_key)
+{
+    switch (params) {
+    case ParameterSet::ML_DSA_44: return KeyGenChecked<Params44>(seed, public_key, secret_key);
+    case ParameterSet::ML_DSA_65: return KeyGenChecked<Params65>(seed, public_key, secret_key);
+    case ParameterSet::ML_DSA_87: return KeyGenChecked<Params87>(seed, public_key, secret_key);
+    }
+    return false;
+}
+
+bool Sign(ParameterSet params, Span<const unsigned char> secret_key, Span<const unsigned char> message,
+          Span<const unsigned char> context, Span<const unsigned char> rnd, Span<unsigned char> signature)
+{
+    switch (params) {
+    case ParameterSet::ML_DSA_44: return SignChecked<Params44>(secret_key, message, context, rnd, signature);
+    case ParameterSet::ML_DSA_65: return SignChecked<Params65>(secret_key, message, context, rnd, signature);
+    case ParameterSet::ML_DSA_87: return SignChecked<Params87>(secret_key, message, context, rnd, signature);
+    }
+    return false;
+}
+
+bool Verify(ParameterSet params, Span<const unsigned char> public_key, Span<const unsigned char> message,
+            Span<const unsigned char> context, Span<const unsigned char> signature)
+{
+    switch (params) {
+    case ParameterSet::ML_DSA_44: return VerifyChecked<Params44>(public_key, message, context, signature);
+    case ParameterSet::ML_DSA_65: return VerifyChecked<Params65>(public_key, message, context, signature);
+    case ParameterSet::ML_DSA_87: return VerifyChecked<Params87>(public_key, message, context, signature);
+    }
+    return false;
+}
+
+} // namespace mldsa
+
+std::string MLDSAAutoDetect(mldsa_implementation::UseImplementation use_implementation)
+{
+    std::string ret = "standard";
+    NTT = portable::NTT;
+    InvNTT = portable::InvNTT;
+    PointwiseMontgomery = portable::PointwiseMontgomery;
+
+#if defined(ENABLE_AVX2) && defined(HAVE_GETCPUID)
+    bool have_avx2 = false;
+    uint32_t eax, ebx, ecx, edx;
+    GetCPUID(1, 0, eax, ebx, ecx, edx);
+    const bool have_xsave = (ecx >> 27) & 1;
+    const bool have_avx = (ecx >> 28) & 1;
+    if (have_xsave && have_avx && AVXEnabled() && (use_implementation & mldsa_implementation::USE_AVX2)) {
+        GetCPUID(7, 0, eax, ebx, ecx, edx);
+        have_avx2 = (ebx >> 5) & 1;
+    }
+    if (have_avx2) {
+        NTT = mldsa_avx2::NTT;
+        InvNTT = mldsa_avx2::InvNTT;
+        PointwiseMontgomery = mldsa_avx2::PointwiseMontgomery;
+        ret = "avx2";
+    }
+#endif
+
+    return ret;
+}
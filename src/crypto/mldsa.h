@@ -0,0 +1,76 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CRYPTO_MLDSA_H
+#define BITCOIN_CRYPTO_MLDSA_H
+
+#include <span.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * ML-DSA, the module-lattice digital signature standard (FIPS 204, derived
+ * from CRYSTALS-Dilithium).
+ *
+ * Keys are derived from a 32-byte seed. Signing is deterministic when rnd is
+ * all zeroes and hedged otherwise; both produce signatures that any FIPS 204
+ * implementation verifies. Messages are signed in the pure (not pre-hashed)
+ * mode with an optional context string of at most 255 bytes.
+ *
+ * The number-theoretic transform and pointwise products dominate signing and
+ * verification; they have a portable implementation and an AVX2 one, picked
+ * at startup by MLDSAAutoDetect. Both give identical results.
+ */
+namespace mldsa {
+
+enum class ParameterSet : uint8_t {
+    ML_DSA_44, //!< NIST security category 2
+    ML_DSA_65, //!< NIST security category 3
+    ML_DSA_87, //!< NIST security category 5
+};
+
+static constexpr size_t SEED_SIZE = 32;
+static constexpr size_t RND_SIZE = 32;
+static constexpr size_t MAX_CONTEXT_SIZE = 255;
+
+size_t PublicKeySize(ParameterSet params);
+size_t SecretKeySize(ParameterSet params);
+size_t SignatureSize(ParameterSet params);
+
+/**
+ * Derive a key pair from seed (SEED_SIZE bytes). public_key and secret_key
+ * must be PublicKeySize and SecretKeySize bytes. Returns false on bad sizes.
+ */
+bool KeyGen(ParameterSet params, Span<const unsigned char> seed, Span<unsigned char> public_key, Span<unsigned char> secret_key);
+
+/**
+ * Sign message under context with secret_key, using rnd (RND_SIZE bytes,
+ * all zeroes for deterministic signing). signature must be SignatureSize
+ * bytes. Returns false on bad sizes or a context that is too long.
+ */
+bool Sign(ParameterSet params, Span<const unsigned char> secret_key, Span<const unsigned char> message,
+          Span<const unsigned char> context, Span<const unsigned char> rnd, Span<unsigned char> signature);
+
+/** Verify signature of message under context against public_key. */
+bool Verify(ParameterSet params, Span<const unsigned char> public_key, Span<const unsigned char> message,
+            Span<const unsigned char> context, Span<const unsigned char> signature);
+
+} // namespace mldsa
+
+namespace mldsa_implementation {
+enum UseImplementation : uint8_t {
+    STANDARD = 0,
+    USE_AVX2 = 1 << 0,
+    USE_ALL = USE_AVX2,
+};
+}
+
+/** Autodetect the best available ML-DSA polynomial arithmetic.
+ *  Returns the name of the implementation.
+ */
+std::string MLDSAAutoDetect(mldsa_implementation::UseImplementation use_implementation = mldsa_implementation::USE_ALL);
+
+#endif // BITCOIN_CRYPTO_MLDSA_H
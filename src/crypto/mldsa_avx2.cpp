@@ -0,0 +1,185 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX2
+
+#include <stdint.h>
+#include <immintrin.h>
+
+#include <attributes.h>
+
+namespace mldsa_avx2 {
+namespace {
+
+constexpr unsigned N = 256;
+constexpr int32_t Q = 8380417;
+constexpr int32_t QINV = 58728449;
+
+__m256i inline Load(const int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+void inline Store(int32_t* p, __m256i x) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), x); }
+
+/** Montgomery reduction of the lane-wise 64-bit products a * b, bit for bit as the portable code does it */
+__m256i ALWAYS_INLINE MulMont(__m256i a, __m256i b)
+{
+    const __m256i q = _mm256_set1_epi32(Q);
+    const __m256i qinv = _mm256_set1_epi32(QINV);
+    // Even lanes, then odd lanes shifted down, as 64-bit products
+    const __m256i prod_even = _mm256_mul_epi32(a, b);
+    const __m256i prod_odd = _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+    // t = (int32_t)prod * QINV; the result is the high half of prod - t * Q
+    const __m256i t_even = _mm256_mul_epi32(_mm256_mul_epi32(prod_even, qinv), q);
+    const __m256i t_odd = _mm256_mul_epi32(_mm256_mul_epi32(prod_odd, qinv), q);
+    const __m256i r_even = _mm256_srli_epi64(_mm256_sub_epi64(prod_even, t_even), 32);
+    const __m256i r_odd = _mm256_sub_epi64(prod_odd, t_odd);
+    return _mm256_blend_epi32(r_even, r_odd, 0xAA);
+}
+
+void ALWAYS_INLINE Butterfly(__m256i& lo, __m256i& hi, __m256i zeta)
+{
+    const __m256i t = MulMont(zeta, hi);
+    hi = _mm256_sub_epi32(lo, t);
+    lo = _mm256_add_epi32(lo, t);
+}
+
+void ALWAYS_INLINE InvButterfly(__m256i& lo, __m256i& hi, __m256i zeta)
+{
+    const __m256i t = lo;
+    lo = _mm256_add_epi32(t, hi);
+    hi = MulMont(zeta, _mm256_sub_epi32(t, hi));
+}
+
+/*
+ * The last three levels pair coefficients within 8-coefficient blocks. Two
+ * blocks v0, v1 (16 coefficients a0..a15) are rearranged into x and y so
+ * that the pairs line up lane by lane:
+ *
+ *   distance 4: x = a0..a3 a8..a11,        y = a4..a7 a12..a15
+ *   distance 2: x = a0 a1 a8 a9 a4 a5 a12 a13, y = a2 a3 a10 a11 a6 a7 a14 a15
+ *   distance 1: x = a0 a2 a8 a10 a4 a6 a12 a14, y = a1 a3 a9 a11 a5 a7 a13 a15
+ */
+void ALWAYS_INLINE Split4(__m256i v0, __m256i v1, __m256i& x, __m256i& y)
+{
+    x = _mm256_permute2x128_si256(v0, v1, 0x20);
+    y = _mm256_permute2x128_si256(v0, v1, 0x31);
+}
+
+void ALWAYS_INLINE Split2(__m256i v0, __m256i v1, __m256i& x, __m256i& y)
+{
+    x = _mm256_unpacklo_epi64(v0, v1);
+    y = _mm256_unpackhi_epi64(v0, v1);
+}
+
+void ALWAYS_INLINE Merge2(__m256i x, __m256i y, __m256i& v0, __m256i& v1)
+{
+    v0 = _mm256_unpacklo_epi64(x, y);
+    v1 = _mm256_unpackhi_epi64(x, y);
+}
+
+void ALWAYS_INLINE Split1(__m256i v0, __m256i v1, __m256i& x, __m256i& y)
+{
+    Split2(_mm256_shuffle_epi32(v0, 0xD8), _mm256_shuffle_epi32(v1, 0xD8), x, y);
+}
+
+void ALWAYS_INLINE Merge1(__m256i x, __m256i y, __m256i& v0, __m256i& v1)
+{
+    Merge2(x, y, v0, v1);
+    v0 = _mm256_shuffle_epi32(v0, 0xD8);
+    v1 = _mm256_shuffle_epi32(v1, 0xD8);
+}
+
+} // namespace
+
+void NTT(int32_t* a, const int32_t* zetas)
+{
+    unsigned k = 0;
+    for (unsigned len = 128; len >= 8; len >>= 1) {
+        for (unsigned start = 0; start < N; start += 2 * len) {
+            const __m256i zeta = _mm256_set1_epi32(zetas[++k]);
+            for (unsigned j = start; j < start + len; j += 8) {
+                __m256i lo = Load(a + j), hi = Load(a + j + len);
+                Butterfly(lo, hi, zeta);
+                Store(a + j, lo);
+                Store(a + j + len, hi);
+            }
+        }
+    }
+
+    // Levels 6 to 8 on 16 coefficients at a time; block b of 16 uses zetas
+    // 32 + 2b.., 64 + 4b.. and 128 + 8b..
+    for (unsigned b = 0; b < N / 16; ++b) {
+        int32_t* p = a + 16 * b;
+        __m256i v0 = Load(p), v1 = Load(p + 8), x, y;
+        const int32_t* z4 = zetas + 32 + 2 * b;
+        const int32_t* z2 = zetas + 64 + 4 * b;
+        const int32_t* z1 = zetas + 128 + 8 * b;
+
+        Split4(v0, v1, x, y);
+        Butterfly(x, y, _mm256_setr_epi32(z4[0], z4[0], z4[0], z4[0], z4[1], z4[1], z4[1], z4[1]));
+        Split4(x, y, v0, v1);
+
+        Split2(v0, v1, x, y);
+        Butterfly(x, y, _mm256_setr_epi32(z2[0], z2[0], z2[2], z2[2], z2[1], z2[1], z2[3], z2[3]));
+        Merge2(x, y, v0, v1);
+
+        Split1(v0, v1, x, y);
+        Butterfly(x, y, _mm256_setr_epi32(z1[0], z1[1], z1[4], z1[5], z1[2], z1[3], z1[6], z1[7]));
+        Merge1(x, y, v0, v1);
+
+        Store(p, v0);
+        Store(p + 8, v1);
+    }
+}
+
+void InvNTT(int32_t* a, const int32_t* zetas)
+{
+    // Levels 8 to 6 on 16 coefficients at a time, with the zetas of the
+    // forward transform negated and in reverse
+    for (unsigned b = 0; b < N / 16; ++b) {
+        int32_t* p = a + 16 * b;
+        __m256i v0 = Load(p), v1 = Load(p + 8), x, y;
+        const int32_t* z1 = zetas + 255 - 8 * b;
+        const int32_t* z2 = zetas + 127 - 4 * b;
+        const int32_t* z4 = zetas + 63 - 2 * b;
+
+        Split1(v0, v1, x, y);
+        InvButterfly(x, y, _mm256_setr_epi32(-z1[0], -z1[-1], -z1[-4], -z1[-5], -z1[-2], -z1[-3], -z1[-6], -z1[-7]));
+        Merge1(x, y, v0, v1);
+
+        Split2(v0, v1, x, y);
+        InvButterfly(x, y, _mm256_setr_epi32(-z2[0], -z2[0], -z2[-2], -z2[-2], -z2[-1], -z2[-1], -z2[-3], -z2[-3]));
+        Merge2(x, y, v0, v1);
+
+        Split4(v0, v1, x, y);
+        InvButterfly(x, y, _mm256_setr_epi32(-z4[0], -z4[0], -z4[0], -z4[0], -z4[-1], -z4[-1], -z4[-1], -z4[-1]));
+        Split4(x, y, v0, v1);
+
+        Store(p, v0);
+        Store(p + 8, v1);
+    }
+
+    unsigned k = 32;
+    for (unsigned len = 8; len < N; len <<= 1) {
+        for (unsigned start = 0; start < N; start += 2 * len) {
+            const __m256i zeta = _mm256_set1_epi32(-zetas[--k]);
+            for (unsigned j = start; j < start + len; j += 8) {
+                __m256i lo = Load(a + j), hi = Load(a + j + len);
+                InvButterfly(lo, hi, zeta);
+                Store(a + j, lo);
+                Store(a + j + len, hi);
+            }
+        }
+    }
+
+    const __m256i f = _mm256_set1_epi32(41978);
+    for (unsigned j = 0; j < N; j += 8) Store(a + j, MulMont(f, Load(a + j)));
+}
+
+void PointwiseMontgomery(int32_t* c, const int32_t* a, const int32_t* b)
+{
+    for (unsigned i = 0; i < N; i += 8) Store(c + i, MulMont(Load(a + i), Load(b + i)));
+}
+
+} // namespace mldsa_avx2
+
+#endif
@@ -0,0 +1,494 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/mlkem.h>
+
+#include <crypto/sha3.h>
+#include <support/cleanse.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr int N = 256;
+constexpr uint32_t Q = 3329;
+//! Primitive 256th root of unity mod Q
+constexpr uint32_t ROOT_OF_UNITY = 17;
+//! 128^-1 mod Q, undoing the scaling of the inverse NTT
+constexpr uint32_t INV_128 = 3303;
+
+constexpr size_t SYM_BYTES = 32;
+constexpr size_t POLY_BYTES = 384;
+
+/** Powers of the root of unity in bit-reversed order, as the NTT uses them, and
+ *  the odd powers the base case multiplication needs. */
+struct Zetas {
+    std::array<uint16_t, 128> ntt{};
+    std::array<uint16_t, 128> basemul{};
+};
+
+constexpr Zetas ComputeZetas()
+{
+    Zetas zetas;
+    for (int i = 0; i < 128; ++i) {
+        int rev = 0;
+        for (int bit = 0; bit < 7; ++bit) rev |= ((i >> bit) & 1) << (6 - bit);
+        uint32_t zeta = 1;
+        for (int e = 0; e < rev; ++e) zeta = zeta * ROOT_OF_UNITY % Q;
+        zetas.ntt[i] = zeta;
+        zetas.basemul[i] = zeta * zeta % Q * ROOT_OF_UNITY % Q;
+    }
+    return zetas;
+}
+
+constexpr Zetas ZETAS = ComputeZetas();
+
+/** A polynomial with coefficients in [0, Q). */
+struct Poly {
+    uint16_t coeffs[N];
+};
+
+template <int K>
+using PolyVec = std::array<Poly, K>;
+
+uint16_t Add(uint32_t a, uint32_t b) { return (a + b) % Q; }
+uint16_t Sub(uint32_t a, uint32_t b) { return (a + Q - b) % Q; }
+uint16_t Mul(uint32_t a, uint32_t b) { return a * b % Q; }
+
+void PolyNTT(Poly& f)
+{
+    int k = 1;
+    for (int len = 128; len >= 2; len >>= 1) {
+        for (int start = 0; start < N; start += 2 * len) {
+            const uint32_t zeta = ZETAS.ntt[k++];
+            for (int j = start; j < start + len; ++j) {
+                const uint16_t t = Mul(zeta, f.coeffs[j + len]);
+                f.coeffs[j + len] = Sub(f.coeffs[j], t);
+                f.coeffs[j] = Add(f.coeffs[j], t);
+            }
+        }
+    }
+}
+
+void PolyInvNTT(Poly& f)
+{
+    int k = 127;
+    for (int len = 2; len <= 128; len <<= 1) {
+        for (int start = 0; start < N; start += 2 * len) {
+            const uint32_t zeta = ZETAS.ntt[k--];
+            for (int j = start; j < start + len; ++j) {
+                const uint16_t t = f.coeffs[j];
+                f.coeffs[j] = Add(t, f.coeffs[j + len]);
+                f.coeffs[j + len] = Mul(zeta, Sub(f.coeffs[j + len], t));
+            }
+        }
+    }
+    for (auto& c : f.coeffs) c = Mul(c, INV_128);
+}
+
+/** h += f * g in the NTT domain: products of degree-one polynomials mod X^2 - zeta */
+void PolyMulAcc(Poly& h, const Poly& f, const Poly& g)
+{
+    for (int i = 0; i < N / 2; ++i) {
+        const uint32_t a0 = f.coeffs[2 * i], a1 = f.coeffs[2 * i + 1];
+        const uint32_t b0 = g.coeffs[2 * i], b1 = g.coeffs[2 * i + 1];
+        const uint32_t c0 = (a0 * b0 + Mul(a1, b1) * uint32_t{ZETAS.basemul[i]}) % Q;
+        const uint32_t c1 = (a0 * b1 + a1 * b0) % Q;
+        h.coeffs[2 * i] = Add(h.coeffs[2 * i], c0);
+        h.coeffs[2 * i + 1] = Add(h.coeffs[2 * i + 1], c1);
+    }
+}
+
+void PolyAdd(Poly& h, const Poly& f)
+{
+    for (int i = 0; i < N; ++i) h.coeffs[i] = Add(h.coeffs[i], f.coeffs[i]);
+}
+
+/** ByteEncode_d: pack coefficients of d bits each */
+void PolyEncode(unsigned char* out, const Poly& f, int bits)
+{
+    uint32_t acc = 0;
+    int acc_bits = 0;
+    for (int i = 0; i < N; ++i) {
+        acc |= uint32_t{f.coeffs[i]} << acc_bits;
+        acc_bits += bits;
+        while (acc_bits >= 8) {
+            *out++ = acc;
+            acc >>= 8;
+            acc_bits -= 8;
+        }
+    }
+}
+
+/** ByteDecode_d: unpack coefficients of d bits each */
+void PolyDecode(Poly& f, const unsigned char* in, int bits)
+{
+    uint32_t acc = 0;
+    int acc_bits = 0;
+    for (int i = 0; i < N; ++i) {
+        while (acc_bits < bits) {
+            acc |= uint32_t{*in++} << acc_bits;
+            acc_bits += 8;
+        }
+        f.coeffs[i] = acc & ((uint32_t{1} << bits) - 1);
+        acc >>= bits;
+        acc_bits -= bits;
+    }
+}
+
+/** Round 2^d / Q * x to the nearest integer mod 2^d */
+void PolyCompress(Poly& f, int bits)
+{
+    for (auto& c : f.coeffs) c = ((uint32_t{c} << bits) + Q / 2) / Q & ((uint32_t{1} << bits) - 1);
+}
+
+/** Round Q / 2^d * y to the nearest integer */
+void PolyDecompress(Poly& f, int bits)
+{
+    for (auto& c : f.coeffs) c = (uint32_t{c} * Q + (uint32_t{1} << (bits - 1))) >> bits;
+}
+
+/** SampleNTT: rejection-sample coefficients below Q from 12-bit chunks; returns how many were taken */
+int RejectUniform(uint16_t* a, int len, const unsigned char* buf, size_t buflen)
+{
+    int ctr = 0;
+    for (size_t pos = 0; ctr < len && pos + 3 <= buflen; pos += 3) {
+        const uint16_t d1 = buf[pos] | (uint16_t{buf[pos + 1]} & 0x0F) << 8;
+        const uint16_t d2 = buf[pos + 1] >> 4 | uint16_t{buf[pos + 2]} << 4;
+        if (d1 < Q) a[ctr++] = d1;
+        if (d2 < Q && ctr < len) a[ctr++] = d2;
+    }
+    return ctr;
+}
+
+//! Output blocks of SHAKE128 nearly always enough for a uniform polynomial
+constexpr size_t UNIFORM_BLOCKS = 3;
+
+/** Sample the matrix entry for seed by rejection, continuing after the first buflen bytes if needed */
+void PolyUniform(Poly& a, Span<const unsigned char> seed, const unsigned char* buf, size_t buflen)
+{
+    int ctr = RejectUniform(a.coeffs, N, buf, buflen);
+    if (ctr == N) return;
+
+    // Rarely needed: regenerate the stream and read past what was used
+    SHAKE128 shake;
+    shake.Write(seed);
+    std::vector<unsigned char> skipped(buflen);
+    shake.Read(skipped);
+    unsigned char block[SHAKE128::RATE_BYTES];
+    while (ctr < N) {
+        shake.Read(block);
+        ctr += RejectUniform(a.coeffs + ctr, N - ctr, block, sizeof(block));
+    }
+}
+
+/** The public matrix A (or its transpose), in the NTT domain, generated KECCAK_WAYS entries at a time */
+template <int K>
+void ExpandMatrix(std::vector<Poly>& mat, const unsigned char* rho, bool transposed)
+{
+    constexpr size_t BUFLEN = UNIFORM_BLOCKS * SHAKE128::RATE_BYTES;
+    mat.resize(K * K);
+    std::array<std::array<unsigned char, SYM_BYTES + 2>, KECCAK_WAYS> seeds;
+    std::array<std::array<unsigned char, BUFLEN>, KECCAK_WAYS> bufs;
+    for (int first = 0; first < K * K; first += KECCAK_WAYS) {
+        const size_t ways = std::min<size_t>(KECCAK_WAYS, K * K - first);
+        std::array<Span<const unsigned char>, KECCAK_WAYS> in;
+        std::array<Span<unsigned char>, KECCAK_WAYS> out;
+        for (size_t w = 0; w < ways; ++w) {
+            // Entry (i, j) of A is sampled from rho || j || i
+            const int i = (first + w) / K, j = (first + w) % K;
+            std::memcpy(seeds[w].data(), rho, SYM_BYTES);
+            seeds[w][SYM_BYTES] = transposed ? i : j;
+            seeds[w][SYM_BYTES + 1] = transposed ? j : i;
+            in[w] = seeds[w];
+            out[w] = bufs[w];
+        }
+        SHAKE128Many({in.data(), ways}, {out.data(), ways});
+        for (size_t w = 0; w < ways; ++w) PolyUniform(mat[first + w], seeds[w], bufs[w].data(), BUFLEN);
+    }
+}
+
+/** SamplePolyCBD_eta over PRF_eta(seed, nonce) */
+template <int ETA>
+void PolyCBD(Poly& f, const unsigned char* seed, uint8_t nonce)
+{
+    unsigned char buf[64 * ETA];
+    SHAKE256().Write({seed, SYM_BYTES}).Write({&nonce, 1}).Read(buf);
+    for (int i = 0; i < N; ++i) {
+        uint32_t x = 0, y = 0;
+        for (int j = 0; j < ETA; ++j) {
+            const int bit_x = 2 * i * ETA + j, bit_y = bit_x + ETA;
+            x += (buf[bit_x / 8] >> (bit_x % 8)) & 1;
+            y += (buf[bit_y / 8] >> (bit_y % 8)) & 1;
+        }
+        f.coeffs[i] = Sub(x, y);
+    }
+    memory_cleanse(buf, sizeof(buf));
+}
+
+template <int K_, int ETA1_, int DU_, int DV_>
+struct Params {
+    static constexpr int K = K_;
+    static constexpr int ETA1 = ETA1_;
+    static constexpr int ETA2 = 2;
+    static constexpr int DU = DU_;
+    static constexpr int DV = DV_;
+
+    static constexpr size_t PKE_SECRET_KEY_BYTES = K * POLY_BYTES;
+    static constexpr size_t ENCAPS_KEY_BYTES = K * POLY_BYTES + SYM_BYTES;
+    static constexpr size_t DECAPS_KEY_BYTES = PKE_SECRET_KEY_BYTES + ENCAPS_KEY_BYTES + 2 * SYM_BYTES;
+    static constexpr size_t CIPHERTEXT_BYTES = (K * DU + DV) * N / 8;
+};
+
+using Params768 = Params<3, 2, 10, 4>;
+using Params1024 = Params<4, 2, 11, 5>;
+
+static_assert(Params768::ENCAPS_KEY_BYTES == 1184 && Params768::DECAPS_KEY_BYTES == 2400 && Params768::CIPHERTEXT_BYTES == 1088);
+static_assert(Params1024::ENCAPS_KEY_BYTES == 1568 && Params1024::DECAPS_KEY_BYTES == 3168 && Params1024::CIPHERTEXT_BYTES == 1568);
+
+/** K-PKE.KeyGen: writes the encapsulation key and the PKE secret key */
+template <typename P>
+void PKEKeyGen(const unsigned char* d, unsigned char* ek, unsigned char* pke_sk)
+{
+    constexpr int K = P::K;
+    unsigned char rho_sigma[2 * SYM_BYTES];
+    const unsigned char k_byte = K;
+    SHA3_512().Write({d, SYM_BYTES}).Write({&k_byte, 1}).Finalize(rho_sigma);
+    const unsigned char* rho = rho_sigma;
+    const unsigned char* sigma = rho_sigma + SYM_BYTES;
+
+    std::vector<Poly> mat;
+    ExpandMatrix<K>(mat, rho, /*transposed=*/false);
+    PolyVec<K> s, e, t{};
+    uint8_t nonce = 0;
+    for (auto& p : s) PolyCBD<P::ETA1>(p, sigma, nonce++);
+    for (auto& p : e) PolyCBD<P::ETA1>(p, sigma, nonce++);
+    for (auto& p : s) PolyNTT(p);
+    for (auto& p : e) PolyNTT(p);
+    for (int i = 0; i < K; ++i) {
+        for (int j = 0; j < K; ++j) PolyMulAcc(t[i], mat[i * K + j], s[j]);
+        PolyAdd(t[i], e[i]);
+    }
+
+    for (int i = 0; i < K; ++i) PolyEncode(ek + i * POLY_BYTES, t[i], 12);
+    std::memcpy(ek + K * POLY_BYTES, rho, SYM_BYTES);
+    for (int i = 0; i < K; ++i) PolyEncode(pke_sk + i * POLY_BYTES, s[i], 12);
+
+    memory_cleanse(rho_sigma, sizeof(rho_sigma));
+    memory_cleanse(s.data(), sizeof(s));
+    memory_cleanse(e.data(), sizeof(e));
+}
+
+/** K-PKE.Encrypt of the 32-byte message m under ek with randomness r */
+template <typename P>
+void PKEEncrypt(unsigned char* ct, const unsigned char* ek, const unsigned char* m, const unsigned char* r)
+{
+    constexpr int K = P::K;
+    PolyVec<K> t, y, e1, u{};
+    Poly e2, v{}, mu;
+    for (int i = 0; i < K; ++i) PolyDecode(t[i], ek + i * POLY_BYTES, 12);
+    std::vector<Poly> mat_t;
+    ExpandMatrix<K>(mat_t, ek + K * POLY_BYTES, /*transposed=*/true);
+
+    uint8_t nonce = 0;
+    for (auto& p : y) PolyCBD<P::ETA1>(p, r, nonce++);
+    for (auto& p : e1) PolyCBD<P::ETA2>(p, r, nonce++);
+    PolyCBD<P::ETA2>(e2, r, nonce++);
+    for (auto& p : y) PolyNTT(p);
+
+    for (int i = 0; i < K; ++i) {
+        for (int j = 0; j < K; ++j) PolyMulAcc(u[i], mat_t[i * K + j], y[j]);
+        PolyInvNTT(u[i]);
+        PolyAdd(u[i], e1[i]);
+    }
+    for (int i = 0; i < K; ++i) PolyMulAcc(v, t[i], y[i]);
+    PolyInvNTT(v);
+    PolyAdd(v, e2);
+    PolyDecode(mu, m, 1);
+    PolyDecompress(mu, 1);
+    PolyAdd(v, mu);
+
+    for (int i = 0; i < K; ++i) {
+        PolyCompress(u[i], P::DU);
+        PolyEncode(ct + i * N * P::DU / 8, u[i], P::DU);
+    }
+    PolyCompress(v, P::DV);
+    PolyEncode(ct + K * N * P::DU / 8, v, P::DV);
+
+    memory_cleanse(y.data(), sizeof(y));
+    memory_cleanse(e1.data(), sizeof(e1));
+    memory_cleanse(&e2, sizeof(e2));
+    memory_cleanse(&mu, sizeof(mu));
+}
+
+/** K-PKE.Decrypt: recover the 32-byte message m */
+template <typename P>
+void PKEDecrypt(unsigned char* m, const unsigned char* pke_sk, const unsigned char* ct)
+{
+    constexpr int K = P::K;
+    PolyVec<K> u, s;
+    Poly v, w{};
+    for (int i = 0; i < K; ++i) {
+        PolyDecode(u[i], ct + i * N * P::DU / 8, P::DU);
+        PolyDecompress(u[i], P::DU);
+        PolyNTT(u[i]);
+        PolyDecode(s[i], pke_sk + i * POLY_BYTES, 12);
+    }
+    PolyDecode(v, ct + K * N * P::DU / 8, P::DV);
+    PolyDecompress(v, P::DV);
+
+    for (int i = 0; i < K; ++i) PolyMulAcc(w, s[i], u[i]);
+    PolyInvNTT(w);
+    for (int i = 0; i < N; ++i) w.coeffs[i] = Sub(v.coeffs[i], w.coeffs[i]);
+    PolyCompress(w, 1);
+    PolyEncode(m, w, 1);
+
+    memory_cleanse(s.data(), sizeof(s));
+    memory_cleanse(&w, sizeof(w));
+}
+
+/** The modulus check: every 12-bit coefficient of the encoded vector is below Q */
+template <typename P>
+bool EncapsKeyValid(const unsigned char* ek)
+{
+    Poly t;
+    for (int i = 0; i < P::K; ++i) {
+        PolyDecode(t, ek + i * POLY_BYTES, 12);
+        // Decoding gives 12-bit values, which are canonical iff they are below Q
+        if (std::any_of(std::begin(t.coeffs), std::end(t.coeffs), [](uint16_t c) { return c >= Q; })) return false;
+    }
+    return true;
+}
+
+template <typename P>
+bool KeyGenChecked(Span<const unsigned char> seed, Span<unsigned char> encaps_key, Span<unsigned char> decaps_key)
+{
+    if (seed.size() != mlkem::SEED_SIZE || encaps_key.size() != P::ENCAPS_KEY_BYTES ||
+        decaps_key.size() != P::DECAPS_KEY_BYTES) return false;
+    // dk = pke_sk || ek || H(ek) || z
+    unsigned char* dk = decaps_key.data();
+    PKEKeyGen<P>(seed.data(), encaps_key.data(), dk);
+    std::memcpy(dk + P::PKE_SECRET_KEY_BYTES, encaps_key.data(), P::ENCAPS_KEY_BYTES);
+    SHA3_256().Write(encaps_key).Finalize({dk + P::PKE_SECRET_KEY_BYTES + P::ENCAPS_KEY_BYTES, SYM_BYTES});
+    std::memcpy(dk + P::DECAPS_KEY_BYTES - SYM_BYTES, seed.data() + SYM_BYTES, SYM_BYTES);
+    return true;
+}
+
+template <typename P>
+bool EncapsChecked(Span<const unsigned char> encaps_key, Span<const unsigned char> m, Span<unsigned char> ciphertext,
+                   Span<unsigned char> shared_secret)
+{
+    if (encaps_key.size() != P::ENCAPS_KEY_BYTES || m.size() != mlkem::ENCAPS_SEED_SIZE ||
+        ciphertext.size() != P::CIPHERTEXT_BYTES || shared_secret.size() != mlkem::SHARED_SECRET_SIZE) return false;
+    if (!EncapsKeyValid<P>(encaps_key.data())) return false;
+
+    // (K, r) = G(m || H(ek))
+    unsigned char h[SYM_BYTES], k_r[2 * SYM_BYTES];
+    SHA3_256().Write(encaps_key).Finalize(h);
+    SHA3_512().Write(m).Write(h).Finalize(k_r);
+    PKEEncrypt<P>(ciphertext.data(), encaps_key.data(), m.data(), k_r + SYM_BYTES);
+    std::memcpy(shared_secret.data(), k_r, SYM_BYTES);
+    memory_cleanse(k_r, sizeof(k_r));
+    return true;
+}
+
+template <typename P>
+bool DecapsChecked(Span<const unsigned char> decaps_key, Span<const unsigned char> ciphertext, Span<unsigned char> shared_secret)
+{
+    if (decaps_key.size() != P::DECAPS_KEY_BYTES || ciphertext.size() != P::CIPHERTEXT_BYTES ||
+        shared_secret.size() != mlkem::SHARED_SECRET_SIZE) return false;
+    const unsigned char* pke_sk = decaps_key.data();
+    const unsigned char* ek = pke_sk + P::PKE_SECRET_KEY_BYTES;
+    const unsigned char* h = ek + P::ENCAPS_KEY_BYTES;
+    const unsigned char* z = h + SYM_BYTES;
+
+    // The hash check on the decapsulation key
+    unsigned char h_check[SYM_BYTES];
+    SHA3_256().Write({ek, P::ENCAPS_KEY_BYTES}).Finalize(h_check);
+    if (std::memcmp(h, h_check, SYM_BYTES) != 0) return false;
+
+    // Decrypt, then re-encrypt to catch a modified ciphertext
+    unsigned char m[SYM_BYTES], k_r[2 * SYM_BYTES], k_reject[SYM_BYTES];
+    PKEDecrypt<P>(m, pke_sk, ciphertext.data());
+    SHA3_512().Write(m).Write({h, SYM_BYTES}).Finalize(k_r);
+    SHAKE256().Write({z, SYM_BYTES}).Write(ciphertext).Read(k_reject);
+    std::array<unsigned char, P::CIPHERTEXT_BYTES> ct_check;
+    PKEEncrypt<P>(ct_check.data(), ek, m, k_r + SYM_BYTES);
+
+    // Select the shared secret or the rejection value without branching on the comparison
+    unsigned char diff = 0;
+    for (size_t i = 0; i < P::CIPHERTEXT_BYTES; ++i) diff |= ct_check[i] ^ ciphertext[i];
+    const unsigned char mask = -static_cast<unsigned char>((diff | -diff) >> 7 & 1);
+    for (size_t i = 0; i < SYM_BYTES; ++i) shared_secret[i] = (k_r[i] & ~mask) | (k_reject[i] & mask);
+
+    memory_cleanse(m, sizeof(m));
+    memory_cleanse(k_r, sizeof(k_r));
+    memory_cleanse(k_reject, sizeof(k_reject));
+    return true;
+}
+
+} // namespace
+
+namespace mlkem {
+
+size_t EncapsulationKeySize(ParameterSet params)
+{
+    switch (params) {
+    case ParameterSet::ML_KEM_768: return Params768::ENCAPS_KEY_BYTES;
+    case ParameterSet::ML_KEM_1024: return Params1024::ENCAPS_KEY_BYTES;
+    }
+    return 0;
+}
+
+size_t DecapsulationKeySize(ParameterSet params)
+{
+    switch (params) {
+    case ParameterSet::ML_KEM_768: return Params768::DECAPS_KEY_BYTES;
+    case ParameterSet::ML_KEM_1024: return Params1024::DECAPS_KEY_BYTES;
+    }
+    return 0;
+}
+
+size_t CiphertextSize(ParameterSet params)
+{
+    switch (params) {
+    case ParameterSet::ML_KEM_768: return Params768::CIPHERTEXT_BYTES;
+    case ParameterSet::ML_KEM_1024: return Params1024::CIPHERTEXT_BYTES;
+    }
+    return 0;
+}
+
+bool KeyGen(ParameterSet params, Span<const unsigned char> seed, Span<unsigned char> encaps_key, Span<unsigned char> decaps_key)
+{
+    switch (params) {
+    case ParameterSet::ML_KEM_768: return KeyGenChecked<Params768>(seed, encaps_key, decaps_key);
+    case ParameterSet::ML_KEM_1024: return KeyGenChecked<Params1024>(seed, encaps_key, decaps_key);
+    }
+    return false;
+}
+
+bool Encaps(ParameterSet params, Span<const unsigned char> encaps_key, Span<const unsigned char> m,
+            Span<unsigned char> ciphertext, Span<unsigned char> shared_secret)
+{
+    switch (params) {
+    case ParameterSet::ML_KEM_768: return EncapsChecked<Params768>(encaps_key, m, ciphertext, shared_secret);
+    case ParameterSet::ML_KEM_1024: return EncapsChecked<Params1024>(encaps_key, m, ciphertext, shared_secret);
+    }
+    return false;
+}
+
+bool Decaps(ParameterSet params, Span<const unsigned char> decaps_key, Span<const unsigned char> ciphertext,
+            Span<unsigned char> shared_secret)
+{
+    switch (params) {
+    case ParameterSet::ML_KEM_768: return DecapsChecked<Params768>(decaps_key, ciphertext, shared_secret);
+    case ParameterSet::ML_KEM_1024: return DecapsChecked<Params1024>(decaps_key, ciphertext, shared_secret);
+    }
+    return false;
+}
+
+} // namespace mlkem
@@ -0,0 +1,69 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CRYPTO_MLKEM_H
+#define BITCOIN_CRYPTO_MLKEM_H
+
+#include <span.h>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * ML-KEM, the module-lattice key encapsulation mechanism (FIPS 203, derived
+ * from CRYSTALS-Kyber).
+ *
+ * A key pair is derived from a 64-byte seed. Encapsulating to an encapsulation
+ * key gives a ciphertext and a 32-byte shared secret; decapsulating the
+ * ciphertext with the matching decapsulation key gives the same secret. A
+ * ciphertext that was tampered with decapsulates to an unrelated secret
+ * (implicit rejection) rather than failing, so callers learn nothing about why.
+ *
+ * Matrix expansion hashes its entries KECCAK_WAYS at a time through
+ * SHAKE128Many, which makes use of the AVX2 Keccak kernel when available.
+ */
+namespace mlkem {
+
+enum class ParameterSet : uint8_t {
+    ML_KEM_768,  //!< NIST security category 3
+    ML_KEM_1024, //!< NIST security category 5
+};
+
+//! Key generation seed: d || z.
+static constexpr size_t SEED_SIZE = 64;
+//! Encapsulation randomness m.
+static constexpr size_t ENCAPS_SEED_SIZE = 32;
+static constexpr size_t SHARED_SECRET_SIZE = 32;
+
+size_t EncapsulationKeySize(ParameterSet params);
+size_t DecapsulationKeySize(ParameterSet params);
+size_t CiphertextSize(ParameterSet params);
+
+/**
+ * Derive a key pair from seed (SEED_SIZE bytes). encaps_key and decaps_key
+ * must be EncapsulationKeySize and DecapsulationKeySize bytes. Returns false
+ * on bad sizes.
+ */
+bool KeyGen(ParameterSet params, Span<const unsigned char> seed, Span<unsigned char> encaps_key, Span<unsigned char> decaps_key);
+
+/**
+ * Encapsulate a shared secret to encaps_key using the randomness m
+ * (ENCAPS_SEED_SIZE bytes). ciphertext must be CiphertextSize bytes and
+ * shared_secret SHARED_SECRET_SIZE. Returns false on bad sizes or an
+ * encapsulation key that is not validly encoded.
+ */
+bool Encaps(ParameterSet params, Span<const unsigned char> encaps_key, Span<const unsigned char> m,
+            Span<unsigned char> ciphertext, Span<unsigned char> shared_secret);
+
+/**
+ * Decapsulate ciphertext with decaps_key into shared_secret
+ * (SHARED_SECRET_SIZE bytes). Returns false on bad sizes or a decapsulation
+ * key that fails its integrity check, never because of the ciphertext.
+ */
+bool Decaps(ParameterSet params, Span<const unsigned char> decaps_key, Span<const unsigned char> ciphertext,
+            Span<unsigned char> shared_secret);
+
+} // namespace mlkem
+
+#endif // BITCOIN_CRYPTO_MLKEM_H
@@ -1,15 +1,21 @@
 #include <crypto/quantum.h>
+#include <crypto/mldsa.h>
+#include <crypto/mlkem.h>
+#include <support/cleanse.h>
 #include <uint256.h>
 #include <util/time.h>
 #include <logging.h>
 #include <crypto/sha256.h>
+#include <crypto/sha3.h>
 #include <random.h>
 #include <map>
 #include <span.h>
 #include <hash.h>
 #include <serialize.h>
 #include <algorithm>
+#include <array>
 #include <chrono>
+#include <optional>
 
 // Helper function for timestamp
 static uint64_t GetCurrentTimestamp() {
@@ -29,6 +35,36 @@ static bool g_quantum_crypto_initialized = false;
 static std::map<QuantumAlgorithmType, std::pair<uint32_t, uint32_t>> g_algorithm_key_sizes;
 static std::map<QuantumAlgorithmType, QuantumSecurityLevel> g_algorithm_security_levels;
 
+/**
+ * ML-DSA (FIPS 204) parameter set implementing a Dilithium algorithm type
+ */
+static std::optional<mldsa::ParameterSet> GetMLDSAParameterSet(QuantumAlgorithmType algorithm) {
+    switch (algorithm) {
+        case QR_DILITHIUM2:
+            return mldsa::ParameterSet::ML_DSA_44;
+        case QR_DILITHIUM3:
+            return mldsa::ParameterSet::ML_DSA_65;
+        case QR_DILITHIUM5:
+            return mldsa::ParameterSet::ML_DSA_87;
+        default:
+            return std::nullopt;
+    }
+}
+
+/**
+ * ML-KEM (FIPS 203) parameter set implementing a Kyber algorithm type
+ */
+static std::optional<mlkem::ParameterSet> GetMLKEMParameterSet(QuantumAlgorithmType algorithm) {
+    switch (algorithm) {
+        case QR_KYBER768:
+            return mlkem::ParameterSet::ML_KEM_768;
+        case QR_KYBER1024:
+            return mlkem::ParameterSet::ML_KEM_1024;
+        default:
+            return std::nullopt;
+    }
+}
+
 /**
  * Initialize quantum-resistant cryptography system
  */
@@ -56,9 +92,9 @@ bool InitializeQuantumCryptography() {
         g_algorithm_key_sizes[QR_KYBER512] = {800, 1632};
         g_algorithm_key_sizes[QR_KYBER768] = {1184, 2400};
         g_algorithm_key_sizes[QR_KYBER1024] = {1568, 3168};
-        g_algorithm_key_sizes[QR_DILITHIUM2] = {1312, 2528};
-        g_algorithm_key_sizes[QR_DILITHIUM3] = {1952, 4000};
-        g_algorithm_key_sizes[QR_DILITHIUM5] = {2592, 4864};
+        g_algorithm_key_sizes[QR_DILITHIUM2] = {1312, 2560};
+        g_algorithm_key_sizes[QR_DILITHIUM3] = {1952, 4032};
+        g_algorithm_key_sizes[QR_DILITHIUM5] = {2592, 4896};
         
         g_algorithm_security_levels[QR_KYBER512] = QS_LEVEL_1;
         g_algorithm_security_levels[QR_KYBER768] = QS_LEVEL_3;
@@ -81,9 +117,9 @@ bool InitializeQuantumCryptography() {
  */
 void InitializeAlgorithmParameters() {
     // Digital Signature Algorithm key sizes (public, private)
-    g_algorithm_key_sizes[QR_DILITHIUM2] = {1312, 2528};
-    g_algorithm_key_sizes[QR_DILITHIUM3] = {1952, 4000};
-    g_algorithm_key_sizes[QR_DILITHIUM5] = {2592, 4864};
+    g_algorithm_key_sizes[QR_DILITHIUM2] = {1312, 2560};
+    g_algorithm_key_sizes[QR_DILITHIUM3] = {1952, 4032};
+    g_algorithm_key_sizes[QR_DILITHIUM5] = {2592, 4896};
     g_algorithm_key_sizes[QR_FALCON512] = {897, 1281};
     g_algorithm_key_sizes[QR_FALCON1024] = {1793, 2305};
     g_algorithm_key_sizes[QR_SPHINCS_SHA256] = {32, 64};
@@ -126,7 +162,6 @@ bool GenerateQuantumKeyPair(QuantumAlgorithmType algorithm, QuantumSecurityLevel
         uint32_t public_key_size, private_key_size, signature_size;
         GetAlgorithmKeySizes(algorithm, public_key_size, private_key_size, signature_size);
         
-        // Generate key pair (simplified implementation - in reality would use actual post-quantum libraries)
         key_pair.algorithm = algorithm;
         key_pair.security_level = level;
         key_pair.key_size_public = public_key_size;
@@ -134,12 +169,36 @@ bool GenerateQuantumKeyPair(QuantumAlgorithmType algorithm, QuantumSecurityLevel
         key_pair.generation_time = GetCurrentTimestamp();
         key_pair.is_hybrid = false;
         
-        // Generate random key data (placeholder for actual post-quantum key generation)
         key_pair.public_key.resize(public_key_size);
         key_pair.private_key.resize(private_key_size);
         
-        GetRandBytes(Span<unsigned char>(key_pair.public_key.data(), public_key_size));
-        GetRandBytes(Span<unsigned char>(key_pair.private_key.data(), private_key_size));
+        const auto mldsa_params = GetMLDSAParameterSet(algorithm);
+        if (mldsa_params) {
+            // The key pair is derived from a fresh seed, which is not kept
+            std::array<unsigned char, mldsa::SEED_SIZE> seed;
+            GetStrongRandBytes(seed);
+            const bool generated = mldsa::KeyGen(*mldsa_params, seed, key_pair.public_key, key_pair.private_key);
+            memory_cleanse(seed.data(), seed.size());
+            if (!generated) {
+                LogPrintf("Bitcoin Decentral: Failed to derive %s key pair\n", GetAlgorithmName(algorithm));
+                return false;
+            }
+        } else if (const auto mlkem_params = GetMLKEMParameterSet(algorithm)) {
+            // GetStrongRandBytes gives at most 32 bytes at a time
+            std::array<unsigned char, mlkem::SEED_SIZE> seed;
+            GetStrongRandBytes(Span{seed}.first(32));
+            GetStrongRandBytes(Span{seed}.last(32));
+            const bool generated = mlkem::KeyGen(*mlkem_params, seed, key_pair.public_key, key_pair.private_key);
+            memory_cleanse(seed.data(), seed.size());
+            if (!generated) {
+                LogPrintf("Bitcoin Decentral: Failed to derive %s key pair\n", GetAlgorithmName(algorithm));
+                return false;
+            }
+        } else {
+            LogPrintf("Bitcoin Decentral: Key generation with %s is not supported\n",
+                     GetAlgorithmName(algorithm));
+            return false;
+        }
         
         LogPrintf("Bitcoin Decentral: Generated quantum-resistant key pair using %s\n",
                  GetAlgorithmName(algorithm));
@@ -164,29 +223,28 @@ bool CreateQuantumSignature(const std::vector<uint8_t>& message,
             return false;
         }
         
-        // Get signature size for the algorithm
-        uint32_t public_key_size, private_key_size, signature_size;
-        GetAlgorithmKeySizes(key_pair.algorithm, public_key_size, private_key_size, signature_size);
+        const auto mldsa_params = GetMLDSAParameterSet(key_pair.algorithm);
+        if (!mldsa_params) {
+            LogPrintf("Bitcoin Decentral: Signing with %s is not supported\n",
+                     GetAlgorithmName(key_pair.algorithm));
+            return false;
+        }
         
-        // Create signature (simplified implementation)
         signature.algorithm = key_pair.algorithm;
         signature.public_key = key_pair.public_key;
-        signature.signature_size = signature_size;
         signature.creation_time = GetCurrentTimestamp();
         signature.is_hybrid = key_pair.is_hybrid;
-        
-        // Generate signature data (placeholder for actual post-quantum signature)
-        signature.signature.resize(signature_size);
-        
-        // Combine message hash with private key for signature (simplified)
-        HashWriter ss{};
-        ss << message;
-        ss << key_pair.private_key;
-        uint256 signature_hash = ss.GetHash();
-        
-        // Copy hash data to signature (simplified implementation)
-        std::memcpy(signature.signature.data(), signature_hash.begin(), 
-                   std::min(signature_size, static_cast<uint32_t>(32)));
+        signature.signature.resize(mldsa::SignatureSize(*mldsa_params));
+        signature.signature_size = static_cast<uint32_t>(signature.signature.size());
+        
+        // Hedged signing: fresh randomness keeps faults or side channels in
+        // one signature from exposing the key
+        std::array<unsigned char, mldsa::RND_SIZE> rnd;
+        GetStrongRandBytes(rnd);
+        if (!mldsa::Sign(*mldsa_params, key_pair.private_key, message, {}, rnd, signature.signature)) {
+            LogPrintf("Bitcoin Decentral: Invalid key pair for signing\n");
+            return false;
+        }
         
         LogPrintf("Bitcoin Decentral: Created quantum-resistant signature using %s\n",
                  GetAlgorithmName(key_pair.algorithm));
@@ -210,18 +268,14 @@ bool VerifyQuantumSignature(const std::vector<uint8_t>& message,
             return false;
         }
         
-        // Verify signature (simplified implementation)
-        // In reality, this would use actual post-quantum verification algorithms
-        
-        // Recreate expected signature hash
-        HashWriter ss{};
-        ss << message;
-        ss << signature.public_key; // Simplified - would use proper verification
-        uint256 expected_hash = ss.GetHash();
+        const auto mldsa_params = GetMLDSAParameterSet(signature.algorithm);
+        if (!mldsa_params) {
+            LogPrintf("Bitcoin Decentral: Verifying %s signatures is not supported\n",
+                     GetAlgorithmName(signature.algorithm));
+            return false;
+        }
         
-        // Compare with signature data (simplified verification)
-        bool is_valid = std::memcmp(signature.signature.data(), expected_hash.begin(),
-                                   std::min(signature.signature_size, static_cast<uint32_t>(32))) == 0;
+        bool is_valid = mldsa::Verify(*mldsa_params, signature.public_key, message, {}, signature.signature);
         
         LogPrintf("Bitcoin Decentral: Verified quantum-resistant signature: %s\n",
                  is_valid ? "VALID" : "INVALID");
@@ -311,31 +365,136 @@ bool VerifyHybridSignature(const std::vector<uint8_t>& message,
     }
 }
 
+/**
+ * Encapsulate secret for quantum-resistant key exchange
+ */
+bool EncapsulateSecret(const std::vector<uint8_t>& public_key,
+                      std::vector<uint8_t>& ciphertext,
+                      std::vector<uint8_t>& shared_secret) {
+    try {
+        // The parameter set follows from the encapsulation key size
+        mlkem::ParameterSet params;
+        if (public_key.size() == mlkem::EncapsulationKeySize(mlkem::ParameterSet::ML_KEM_768)) {
+            params = mlkem::ParameterSet::ML_KEM_768;
+        } else if (public_key.size() == mlkem::EncapsulationKeySize(mlkem::ParameterSet::ML_KEM_1024)) {
+            params = mlkem::ParameterSet::ML_KEM_1024;
+        } else {
+            LogPrintf("Bitcoin Decentral: Invalid public key size for encapsulation\n");
+            return false;
+        }
+        
+        ciphertext.resize(mlkem::CiphertextSize(params));
+        shared_secret.resize(mlkem::SHARED_SECRET_SIZE);
+        std::array<unsigned char, mlkem::ENCAPS_SEED_SIZE> m;
+        GetStrongRandBytes(m);
+        const bool encapsulated = mlkem::Encaps(params, public_key, m, ciphertext, shared_secret);
+        memory_cleanse(m.data(), m.size());
+        if (!encapsulated) {
+            LogPrintf("Bitcoin Decentral: Public key failed the encapsulation key check\n");
+            return false;
+        }
+        
+        return true;
+    } catch (const std::exception& e) {
+        LogPrintf("Bitcoin Decentral: Failed to encapsulate secret: %s\n", e.what());
+        return false;
+    }
+}
+
+/**
+ * Decapsulate secret from quantum-resistant key exchange
+ */
+bool DecapsulateSecret(const std::vector<uint8_t>& ciphertext,
+                      const QuantumKeyPair& key_pair,
+                      std::vector<uint8_t>& shared_secret) {
+    try {
+        const auto mlkem_params = GetMLKEMParameterSet(key_pair.algorithm);
+        if (!mlkem_params) {
+            LogPrintf("Bitcoin Decentral: Decapsulating with %s is not supported\n",
+                     GetAlgorithmName(key_pair.algorithm));
+            return false;
+        }
+        
+        // A tampered ciphertext still decapsulates, to a secret the peer does not share
+        shared_secret.resize(mlkem::SHARED_SECRET_SIZE);
+        if (!mlkem::Decaps(*mlkem_params, key_pair.private_key, ciphertext, shared_secret)) {
+            LogPrintf("Bitcoin Decentral: Invalid key pair or ciphertext size for decapsulation\n");
+            return false;
+        }
+        
+        return true;
+    } catch (const std::exception& e) {
+        LogPrintf("Bitcoin Decentral: Failed to decapsulate secret: %s\n", e.what());
+        return false;
+    }
+}
+
 /**
  * Compute quantum-resistant hash
  */
 uint256 ComputeQuantumHash(const std::vector<uint8_t>& data,
                           QuantumAlgorithmType hash_algorithm) {
-    // For now, use SHA-256 as base (in reality would implement SHA-3, SHAKE, etc.)
-    HashWriter ss{};
-    ss << data;
+    uint256 hash;
     
-    // Add algorithm-specific processing
     switch (hash_algorithm) {
         case QR_SHA3_256:
-        case QR_SHA3_512:
-            // Would implement SHA-3 here
+            SHA3_256().Write(data).Finalize(hash);
             break;
+        case QR_SHA3_512: {
+            // Truncated to the first 256 bits
+            unsigned char full[SHA3_512::OUTPUT_SIZE];
+            SHA3_512().Write(data).Finalize(full);
+            hash = uint256{Span{full}.first(hash.size())};
+            break;
+        }
         case QR_SHAKE128:
+            SHAKE128().Write(data).Read(hash);
+            break;
         case QR_SHAKE256:
-            // Would implement SHAKE here
+            SHAKE256().Write(data).Read(hash);
             break;
-        default:
+        default: {
             // Use SHA-256 as fallback
+            HashWriter ss{};
+            ss << data;
+            hash = ss.GetHash();
             break;
+        }
     }
     
-    return ss.GetHash();
+    return hash;
+}
+
+/**
+ * Compute SHAKE hash with variable output length
+ */
+std::vector<uint8_t> ComputeShakeHash(const std::vector<uint8_t>& data,
+                                     uint32_t output_length,
+                                     QuantumAlgorithmType shake_variant) {
+    std::vector<uint8_t> output(output_length);
+    
+    switch (shake_variant) {
+        case QR_SHAKE128:
+            SHAKE128().Write(data).Read(output);
+            break;
+        case QR_SHAKE256:
+            SHAKE256().Write(data).Read(output);
+            break;
+        default:
+            LogPrintf("Bitcoin Decentral: %s is not a SHAKE variant\n", GetAlgorithmName(shake_variant));
+            return {};
+    }
+    
+    return output;
+}
+
+/**
+ * Verify hash integrity
+ */
+bool VerifyQuantumHash(const std::vector<uint8_t>& data,
+                      const uint256& expected_hash,
+                      QuantumAlgorithmType hash_algorithm) {
+    return ComputeQuantumHash(data, hash_algorithm) == expected_hash;
 }
 
 /**
@@ -459,10 +618,10 @@ void GetAlgorithmKeySizes(QuantumAlgorithmType algorithm,
                 signature_size = 2420;
                 break;
             case QR_DILITHIUM3:
-                signature_size = 3293;
+                signature_size = 3309;
                 break;
             case QR_DILITHIUM5:
-                signature_size = 4595;
+                signature_size = 4627;
                 break;
             case QR_FALCON512:
                 signature_size = 690;
@@ -471,14 +630,14 @@ void GetAlgorithmKeySizes(QuantumAlgorithmType algorithm,
                 signature_size = 1330;
                 break;
             default:
-                signature_size = 3293; // Default to Dilithium3
+                signature_size = 3309; // Default to Dilithium3
                 break;
         }
     } else {
         // Default values
         public_key_size = 1952;
-        private_key_size = 4000;
-        signature_size = 3293;
+        private_key_size = 4032;
+        signature_size = 3309;
     }
 }
 
@@ -5,6 +5,8 @@
 // Based on https://github.com/mjosaarinen/tiny_sha3/blob/master/sha3.c
 // by Markku-Juhani O. Saarinen <mjos@iki.fi>
 
+#include <bitcoindecentral-build-config.h> // IWYU pragma: keep
+
 #include <crypto/sha3.h>
 #include <crypto/common.h>
 #include <span.h>
@@ -12,9 +14,19 @@
 #include <algorithm>
 #include <array> // For std::begin and std::end.
 #include <bit>
+#include <cassert>
 
 #include <stdint.h>
 
+#if defined(ENABLE_AVX2)
+#include <compat/cpuid.h>
+
+namespace sha3_avx2
+{
+void KeccakF_4way(uint64_t (&st)[25][KECCAK_WAYS]);
+}
+#endif // ENABLE_AVX2
+
 void KeccakF(uint64_t (&st)[25])
 {
     static constexpr uint64_t RNDC[24] = {
@@ -103,54 +115,313 @@ void KeccakF(uint64_t (&st)[25])
     }
 }
 
-SHA3_256& SHA3_256::Write(Span<const unsigned char> data)
+namespace {
+
+/** Portable fallback: permute each state on its own. Interleaving buys
+ *  nothing without vector registers, but keeps callers independent of which
+ *  kernel runs. */
+void KeccakF_4way_Portable(uint64_t (&st)[25][KECCAK_WAYS])
 {
-    if (m_bufsize && data.size() >= sizeof(m_buffer) - m_bufsize) {
-        // Fill the buffer and process it.
-        std::copy(data.begin(), data.begin() + (sizeof(m_buffer) - m_bufsize), m_buffer + m_bufsize);
-        data = data.subspan(sizeof(m_buffer) - m_bufsize);
-        m_state[m_pos++] ^= ReadLE64(m_buffer);
-        m_bufsize = 0;
-        if (m_pos == RATE_BUFFERS) {
+    for (size_t k = 0; k < KECCAK_WAYS; ++k) {
+        uint64_t lanes[25];
+        for (int i = 0; i < 25; ++i) lanes[i] = st[i][k];
+        KeccakF(lanes);
+        for (int i = 0; i < 25; ++i) st[i][k] = lanes[i];
+    }
+}
+
+typedef void (*KeccakF4WayType)(uint64_t (&st)[25][KECCAK_WAYS]);
+
+KeccakF4WayType KeccakF4Way = KeccakF_4way_Portable;
+
+#if defined(ENABLE_AVX2)
+/** Check whether the OS has enabled AVX registers. */
+bool AVXEnabled()
+{
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (a & 6) == 6;
+}
+#endif // ENABLE_AVX2
+
+/** Write count bytes of the rate of state w to out. */
+void SqueezeLanes(const uint64_t (&st)[25][KECCAK_WAYS], size_t w, unsigned char* out, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) WriteLE64(out + i, st[i / 8][w]);
+    for (; i < count; ++i) out[i] = st[i / 8][w] >> (8 * (i % 8));
+}
+
+/**
+ * Run up to KECCAK_WAYS sponges side by side through KeccakF_4way, filling
+ * out[k] with the output for in[k].
+ *
+ * Inputs may differ in length, so every sponge runs its own schedule: it
+ * absorbs one block per permutation until its padded last block, then
+ * squeezes one block per permutation until its output is full. Sponges that
+ * finish early keep being permuted, but are not read again.
+ */
+void SpongeWays(unsigned rate, unsigned char pad, const Span<const unsigned char>* in, const Span<unsigned char>* out, size_t ways)
+{
+    uint64_t st[25][KECCAK_WAYS] = {};
+    size_t absorb_blocks[KECCAK_WAYS] = {};
+    size_t total_blocks = 0;
+    for (size_t k = 0; k < ways; ++k) {
+        absorb_blocks[k] = in[k].size() / rate + 1;
+        const size_t squeeze_blocks = std::max<size_t>(1, (out[k].size() + rate - 1) / rate);
+        total_blocks = std::max(total_blocks, absorb_blocks[k] + squeeze_blocks - 1);
+    }
+    for (size_t b = 0; b < total_blocks; ++b) {
+        for (size_t k = 0; k < ways; ++k) {
+            if (b >= absorb_blocks[k]) continue;
+            const Span<const unsigned char> block = in[k].subspan(b * rate);
+            if (b + 1 < absorb_blocks[k]) {
+                for (size_t i = 0; i < rate / 8; ++i) st[i][k] ^= ReadLE64(block.data() + 8 * i);
+            } else {
+                unsigned char last[KeccakSponge::STATE_BYTES] = {};
+                std::copy(block.begin(), block.end(), last);
+                last[block.size()] ^= pad;
+                last[rate - 1] ^= 0x80;
+                for (size_t i = 0; i < rate / 8; ++i) st[i][k] ^= ReadLE64(last + 8 * i);
+            }
+        }
+        KeccakF_4way(st);
+        for (size_t k = 0; k < ways; ++k) {
+            if (b + 1 < absorb_blocks[k]) continue;
+            const size_t offset = (b + 1 - absorb_blocks[k]) * rate;
+            if (offset >= out[k].size()) continue;
+            SqueezeLanes(st, k, out[k].data() + offset, std::min<size_t>(rate, out[k].size() - offset));
+        }
+    }
+}
+
+/** Hash inputs[i] into outputs[i] for all i, KECCAK_WAYS at a time. */
+void SpongeMany(unsigned rate, unsigned char pad, Span<const Span<const unsigned char>> inputs, Span<const Span<unsigned char>> outputs)
+{
+    assert(inputs.size() == outputs.size());
+    while (inputs.size() >= 2) {
+        const size_t ways = std::min(inputs.size(), KECCAK_WAYS);
+        SpongeWays(rate, pad, inputs.data(), outputs.data(), ways);
+        inputs = inputs.subspan(ways);
+        outputs = outputs.subspan(ways);
+    }
+    if (!inputs.empty()) {
+        KeccakSponge(rate, pad).Absorb(inputs[0]).Squeeze(outputs[0]);
+    }
+}
+
+} // namespace
+
+void KeccakF_4way(uint64_t (&st)[25][KECCAK_WAYS])
+{
+    KeccakF4Way(st);
+}
+
+KeccakSponge::KeccakSponge(unsigned rate_bytes, unsigned char pad) : m_rate{rate_bytes}, m_pad{pad}
+{
+    assert(m_rate % 8 == 0 && m_rate < STATE_BYTES);
+}
+
+KeccakSponge& KeccakSponge::Absorb(Span<const unsigned char> data)
+{
+    m_squeezing = false;
+    // Bytes up to the next lane boundary.
+    while (!data.empty() && m_pos % 8) {
+        m_state[m_pos / 8] ^= uint64_t{data[0]} << (8 * (m_pos % 8));
+        data = data.subspan(1);
+        if (++m_pos == m_rate) {
             KeccakF(m_state);
             m_pos = 0;
         }
     }
-    while (data.size() >= sizeof(m_buffer)) {
-        // Process chunks directly from the buffer.
-        m_state[m_pos++] ^= ReadLE64(data.data());
+    // Whole lanes, straight from the input.
+    while (data.size() >= 8) {
+        m_state[m_pos / 8] ^= ReadLE64(data.data());
         data = data.subspan(8);
-        if (m_pos == RATE_BUFFERS) {
+        m_pos += 8;
+        if (m_pos == m_rate) {
             KeccakF(m_state);
             m_pos = 0;
         }
     }
-    if (data.size()) {
-        // Keep the remainder in the buffer.
-        std::copy(data.begin(), data.end(), m_buffer + m_bufsize);
-        m_bufsize += data.size();
+    // The rest fits in the current lane.
+    for (unsigned char byte : data) {
+        m_state[m_pos / 8] ^= uint64_t{byte} << (8 * (m_pos % 8));
+        ++m_pos;
+    }
+    return *this;
+}
+
+KeccakSponge& KeccakSponge::Squeeze(Span<unsigned char> output)
+{
+    if (!m_squeezing) {
+        m_state[m_pos / 8] ^= uint64_t{m_pad} << (8 * (m_pos % 8));
+        m_state[m_rate / 8 - 1] ^= 0x8000000000000000;
+        KeccakF(m_state);
+        m_pos = 0;
+        m_squeezing = true;
+    }
+    while (!output.empty()) {
+        if (m_pos == m_rate) {
+            KeccakF(m_state);
+            m_pos = 0;
+        }
+        if (m_pos % 8 == 0 && output.size() >= 8) {
+            WriteLE64(output.data(), m_state[m_pos / 8]);
+            output = output.subspan(8);
+            m_pos += 8;
+        } else {
+            output[0] = m_state[m_pos / 8] >> (8 * (m_pos % 8));
+            output = output.subspan(1);
+            ++m_pos;
+        }
     }
     return *this;
 }
 
+KeccakSponge& KeccakSponge::Reset()
+{
+    std::fill(std::begin(m_state), std::end(m_state), 0);
+    m_pos = 0;
+    m_squeezing = false;
+    return *this;
+}
+
+SHA3_256& SHA3_256::Write(Span<const unsigned char> data)
+{
+    m_sponge.Absorb(data);
+    return *this;
+}
+
 SHA3_256& SHA3_256::Finalize(Span<unsigned char> output)
 {
     assert(output.size() == OUTPUT_SIZE);
-    std::fill(m_buffer + m_bufsize, m_buffer + sizeof(m_buffer), 0);
-    m_buffer[m_bufsize] ^= 0x06;
-    m_state[m_pos] ^= ReadLE64(m_buffer);
-    m_state[RATE_BUFFERS - 1] ^= 0x8000000000000000;
-    KeccakF(m_state);
-    for (unsigned i = 0; i < 4; ++i) {
-        WriteLE64(output.data() + 8 * i, m_state[i]);
-    }
+    m_sponge.Squeeze(output);
     return *this;
 }
 
 SHA3_256& SHA3_256::Reset()
 {
-    m_bufsize = 0;
-    m_pos = 0;
-    std::fill(std::begin(m_state), std::end(m_state), 0);
+    m_sponge.Reset();
     return *this;
 }
+
+SHA3_512& SHA3_512::Write(Span<const unsigned char> data)
+{
+    m_sponge.Absorb(data);
+    return *this;
+}
+
+SHA3_512& SHA3_512::Finalize(Span<unsigned char> output)
+{
+    assert(output.size() == OUTPUT_SIZE);
+    m_sponge.Squeeze(output);
+    return *this;
+}
+
+SHA3_512& SHA3_512::Reset()
+{
+    m_sponge.Reset();
+    return *this;
+}
+
+Keccak256& Keccak256::Write(Span<const unsigned char> data)
+{
+    m_sponge.Absorb(data);
+    return *this;
+}
+
+Keccak256& Keccak256::Finalize(Span<unsigned char> output)
+{
+    assert(output.size() == OUTPUT_SIZE);
+    m_sponge.Squeeze(output);
+    return *this;
+}
+
+Keccak256& Keccak256::Reset()
+{
+    m_sponge.Reset();
+    return *this;
+}
+
+SHAKE128& SHAKE128::Write(Span<const unsigned char> data)
+{
+    m_sponge.Absorb(data);
+    return *this;
+}
+
+SHAKE128& SHAKE128::Read(Span<unsigned char> output)
+{
+    m_sponge.Squeeze(output);
+    return *this;
+}
+
+SHAKE128& SHAKE128::Reset()
+{
+    m_sponge.Reset();
+    return *this;
+}
+
+SHAKE256& SHAKE256::Write(Span<const unsigned char> data)
+{
+    m_sponge.Absorb(data);
+    return *this;
+}
+
+SHAKE256& SHAKE256::Read(Span<unsigned char> output)
+{
+    m_sponge.Squeeze(output);
+    return *this;
+}
+
+SHAKE256& SHAKE256::Reset()
+{
+    m_sponge.Reset();
+    return *this;
+}
+
+void Keccak256Many(unsigned char* output, Span<const Span<const unsigned char>> inputs)
+{
+    while (!inputs.empty()) {
+        const size_t ways = std::min(inputs.size(), KECCAK_WAYS);
+        Span<unsigned char> outputs[KECCAK_WAYS];
+        for (size_t k = 0; k < ways; ++k) outputs[k] = {output + Keccak256::OUTPUT_SIZE * k, Keccak256::OUTPUT_SIZE};
+        SpongeMany(Keccak256::RATE_BYTES, 0x01, inputs.first(ways), Span{outputs}.first(ways));
+        output += Keccak256::OUTPUT_SIZE * ways;
+        inputs = inputs.subspan(ways);
+    }
+}
+
+void SHAKE128Many(Span<const Span<const unsigned char>> inputs, Span<const Span<unsigned char>> outputs)
+{
+    SpongeMany(SHAKE128::RATE_BYTES, 0x1F, inputs, outputs);
+}
+
+void SHAKE256Many(Span<const Span<const unsigned char>> inputs, Span<const Span<unsigned char>> outputs)
+{
+    SpongeMany(SHAKE256::RATE_BYTES, 0x1F, inputs, outputs);
+}
+
+std::string KeccakAutoDetect(keccak_implementation::UseImplementation use_implementation)
+{
+    std::string ret = "standard";
+    KeccakF4Way = KeccakF_4way_Portable;
+
+#if defined(ENABLE_AVX2) && defined(HAVE_GETCPUID)
+    bool have_avx2 = false;
+    uint32_t eax, ebx, ecx, edx;
+    GetCPUID(1, 0, eax, ebx, ecx, edx);
+    const bool have_xsave = (ecx >> 27) & 1;
+    const bool have_avx = (ecx >> 28) & 1;
+    if (have_xsave && have_avx && AVXEnabled() && (use_implementation & keccak_implementation::USE_AVX2)) {
+        GetCPUID(7, 0, eax, ebx, ecx, edx);
+        have_avx2 = (ebx >> 5) & 1;
+    }
+    if (have_avx2) {
+        KeccakF4Way = sha3_avx2::KeccakF_4way;
+        ret = "avx2";
+    }
+#endif
+
+    return ret;
+}
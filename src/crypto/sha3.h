@@ -9,28 +9,64 @@
 
 #include <cstdlib>
 #include <stdint.h>
+#include <string>
 
 //! The Keccak-f[1600] transform.
 void KeccakF(uint64_t (&st)[25]);
 
-class SHA3_256
+//! Number of independent states permuted together by KeccakF_4way.
+static constexpr size_t KECCAK_WAYS = 4;
+
+/** The Keccak-f[1600] transform applied to KECCAK_WAYS independent states at once.
+ *  States are interleaved lane by lane: st[i][j] is lane i of state j, so that
+ *  each lane of all states fills one 256-bit vector. KeccakAutoDetect picks a
+ *  portable or an AVX2 implementation. */
+void KeccakF_4way(uint64_t (&st)[25][KECCAK_WAYS]);
+
+/**
+ * A Keccak sponge over Keccak-f[1600] with a given rate and domain separation
+ * byte, from which the fixed-length hashes and the XOFs below are built. Input
+ * is absorbed a lane (8 bytes) at a time whenever it is aligned with the
+ * state, so long messages never go through a byte loop.
+ *
+ * Absorb any number of times, then Squeeze any number of times; the first
+ * Squeeze pads the input. Absorbing again after squeezing starts a new message
+ * on top of the current state; call Reset to hash an unrelated one.
+ */
+class KeccakSponge
 {
 private:
     uint64_t m_state[25] = {0};
-    unsigned char m_buffer[8];
-    unsigned m_bufsize = 0;
+    //! Bytes of the rate absorbed or squeezed in the current block.
     unsigned m_pos = 0;
+    unsigned m_rate;
+    unsigned char m_pad;
+    bool m_squeezing = false;
+
+public:
+    //! Bytes of the state a sponge may use as its rate.
+    static constexpr unsigned STATE_BYTES = 200;
+
+    /** rate_bytes must be a multiple of 8 below STATE_BYTES. pad is the
+     *  domain separator that starts the padding: 0x06 for SHA-3, 0x1F for
+     *  SHAKE, 0x01 for the original Keccak. */
+    KeccakSponge(unsigned rate_bytes, unsigned char pad);
+    KeccakSponge& Absorb(Span<const unsigned char> data);
+    KeccakSponge& Squeeze(Span<unsigned char> output);
+    KeccakSponge& Reset();
+};
 
+class SHA3_256
+{
+private:
     //! Sponge rate in bits.
     static constexpr unsigned RATE_BITS = 1088;
 
-    //! Sponge rate expressed as a multiple of the buffer size.
-    static constexpr unsigned RATE_BUFFERS = RATE_BITS / (8 * sizeof(m_buffer));
-
-    static_assert(RATE_BITS % (8 * sizeof(m_buffer)) == 0, "Rate must be a multiple of 8 bytes");
+    KeccakSponge m_sponge{RATE_BITS / 8, 0x06};
 
 public:
     static constexpr size_t OUTPUT_SIZE = 32;
+    static constexpr size_t RATE_BYTES = RATE_BITS / 8;
 
     SHA3_256() = default;
     SHA3_256& Write(Span<const unsigned char> data);
@@ -38,4 +74,111 @@ public:
     SHA3_256& Reset();
 };
 
+class SHA3_512
+{
+private:
+    //! Sponge rate in bits.
+    static constexpr unsigned RATE_BITS = 576;
+
+    KeccakSponge m_sponge{RATE_BITS / 8, 0x06};
+
+public:
+    static constexpr size_t OUTPUT_SIZE = 64;
+    static constexpr size_t RATE_BYTES = RATE_BITS / 8;
+
+    SHA3_512() = default;
+    SHA3_512& Write(Span<const unsigned char> data);
+    SHA3_512& Finalize(Span<unsigned char> output);
+    SHA3_512& Reset();
+};
+
+/** Keccak-256 as used by Ethereum: the SHA3-256 sponge with the original
+ *  Keccak padding (0x01) instead of the FIPS 202 domain separator (0x06). */
+class Keccak256
+{
+private:
+    //! Sponge rate in bits.
+    static constexpr unsigned RATE_BITS = 1088;
+
+    KeccakSponge m_sponge{RATE_BITS / 8, 0x01};
+
+public:
+    static constexpr size_t OUTPUT_SIZE = 32;
+    static constexpr size_t RATE_BYTES = RATE_BITS / 8;
+
+    Keccak256() = default;
+    Keccak256& Write(Span<const unsigned char> data);
+    Keccak256& Finalize(Span<unsigned char> output);
+    Keccak256& Reset();
+};
+
+/** The SHAKE128 extendable-output function. Output of any length can be read
+ *  in pieces once all input has been written. */
+class SHAKE128
+{
+private:
+    //! Sponge rate in bits.
+    static constexpr unsigned RATE_BITS = 1344;
+
+    KeccakSponge m_sponge{RATE_BITS / 8, 0x1F};
+
+public:
+    static constexpr size_t RATE_BYTES = RATE_BITS / 8;
+
+    SHAKE128() = default;
+    SHAKE128& Write(Span<const unsigned char> data);
+    SHAKE128& Read(Span<unsigned char> output);
+    SHAKE128& Reset();
+};
+
+/** The SHAKE256 extendable-output function. Output of any length can be read
+ *  in pieces once all input has been written. */
+class SHAKE256
+{
+private:
+    //! Sponge rate in bits.
+    static constexpr unsigned RATE_BITS = 1088;
+
+    KeccakSponge m_sponge{RATE_BITS / 8, 0x1F};
+
+public:
+    static constexpr size_t RATE_BYTES = RATE_BITS / 8;
+
+    SHAKE256() = default;
+    SHAKE256& Write(Span<const unsigned char> data);
+    SHAKE256& Read(Span<unsigned char> output);
+    SHAKE256& Reset();
+};
+
+/** Compute Keccak-256 of many independent inputs.
+ *
+ *  Inputs are hashed KECCAK_WAYS at a time through KeccakF_4way, which pays off
+ *  when they are short and of similar length (storage keys, ABI words, public
+ *  keys). output must hold Keccak256::OUTPUT_SIZE bytes per input.
+ */
+void Keccak256Many(unsigned char* output, Span<const Span<const unsigned char>> inputs);
+
+/** SHAKE128 of many independent inputs, KECCAK_WAYS at a time through
+ *  KeccakF_4way. outputs[i] is filled with output of inputs[i]; both spans
+ *  must have the same number of elements. Matrix and mask expansion in the
+ *  lattice schemes and hash trees in hash-based signatures hash exactly this
+ *  kind of batch. */
+void SHAKE128Many(Span<const Span<const unsigned char>> inputs, Span<const Span<unsigned char>> outputs);
+
+/** SHAKE256 of many independent inputs, as SHAKE128Many. */
+void SHAKE256Many(Span<const Span<const unsigned char>> inputs, Span<const Span<unsigned char>> outputs);
+
+namespace keccak_implementation {
+enum UseImplementation : uint8_t {
+    STANDARD = 0,
+    USE_AVX2 = 1 << 0,
+    USE_ALL = USE_AVX2,
+};
+}
+
+/** Autodetect the best available KeccakF_4way implementation.
+ *  Returns the name of the implementation.
+ */
+std::string KeccakAutoDetect(keccak_implementation::UseImplementation use_implementation = keccak_implementation::USE_ALL);
+
 #endif // BITCOIN_CRYPTO_SHA3_H
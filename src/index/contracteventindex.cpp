@@ -0,0 +1,221 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/contracteventindex.h>
+
+#include <blockfilter.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <common/args.h>
+#include <crypto/common.h>
+#include <dbwrapper.h>
+#include <logging.h>
+#include <util/check.h>
+
+/* The index database stores, for each block height on the active chain, the block hash, the
+ * number of events and the encoded address and topic filters. The events themselves live under a
+ * separate key, so a range scan only reads the small filter records until one matches.
+ *
+ * Keys have the type [prefix, uint32 (BE)] so that sequential reads by height are fast. On a reorg
+ * the entries above the fork point are erased; the new chain's blocks then overwrite them.
+ */
+constexpr uint8_t DB_BLOCK_HEIGHT{'t'};
+constexpr uint8_t DB_EVENTS{'e'};
+
+std::unique_ptr<ContractEventIndex> g_contract_event_index;
+
+namespace {
+
+struct DBVal {
+    uint256 block_hash;
+    uint32_t event_count{0};
+    std::vector<unsigned char> address_filter;
+    std::vector<unsigned char> topic_filter;
+
+    SERIALIZE_METHODS(DBVal, obj) { READWRITE(obj.block_hash, obj.event_count, obj.address_filter, obj.topic_filter); }
+};
+
+struct DBHeightKey {
+    uint8_t prefix;
+    int height;
+
+    DBHeightKey(uint8_t prefix_in, int height_in) : prefix(prefix_in), height(height_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, prefix);
+        ser_writedata32be(s, height);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        prefix = ser_readdata8(s);
+        height = ser_readdata32be(s);
+    }
+};
+
+/** Filters are keyed by block hash, as in BIP 158. */
+GCSFilter::Params FilterParams(const uint256& block_hash)
+{
+    return {ReadLE64(block_hash.begin()), ReadLE64(block_hash.begin() + 8), BASIC_FILTER_P, BASIC_FILTER_M};
+}
+
+GCSFilter::ElementSet ToElementSet(const std::set<uint256>& hashes)
+{
+    GCSFilter::ElementSet elements;
+    for (const uint256& hash : hashes) {
+        elements.emplace(hash.begin(), hash.end());
+    }
+    return elements;
+}
+
+bool EventMatches(const smartcontracts::ContractEvent& event, const std::set<uint256>& addresses, const std::set<uint256>& topics)
+{
+    if (!addresses.empty() && !addresses.count(event.contract_address)) return false;
+    if (topics.empty()) return true;
+    for (const uint256& topic : event.topics) {
+        if (topics.count(topic)) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+/** Access to the contract event index database (indexes/contractevents/) */
+class ContractEventIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+};
+
+ContractEventIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "contractevents", n_cache_size, f_memory, f_wipe)
+{}
+
+ContractEventIndex::ContractEventIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory, bool f_wipe)
+    : BaseIndex(std::move(chain), "contracteventindex"), m_db(std::make_unique<ContractEventIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+ContractEventIndex::~ContractEventIndex() = default;
+
+bool ContractEventIndex::CustomAppend(const interfaces::BlockInfo& block)
+{
+    // Events come from the receipts stored when the block's contract calls
+    // were executed, one receipt per call
+    std::vector<smartcontracts::ContractEvent> events;
+    size_t call_count{0};
+    if (smartcontracts::IsSmartContractActive(block.height, Params().GetConsensus())) {
+        smartcontracts::ContractCall call;
+        for (const CTransactionRef& tx : Assert(block.data)->vtx) {
+            if (smartcontracts::DecodeContractCall(*tx, call)) ++call_count;
+        }
+    }
+    if (call_count > 0) {
+        const auto receipts = smartcontracts::GetBlockContractReceipts(block.hash);
+        if (!receipts || receipts->size() != call_count) {
+            LogError("%s: missing contract receipts for block %s\n", __func__, block.hash.ToString());
+            return false;
+        }
+        for (const auto& receipt : *receipts) {
+            events.insert(events.end(), receipt.logs.begin(), receipt.logs.end());
+        }
+    }
+
+    DBVal value;
+    value.block_hash = block.hash;
+    value.event_count = events.size();
+
+    GCSFilter::ElementSet addresses, topics;
+    for (const auto& event : events) {
+        addresses.emplace(event.contract_address.begin(), event.contract_address.end());
+        for (const uint256& topic : event.topics) {
+            topics.emplace(topic.begin(), topic.end());
+        }
+    }
+    const GCSFilter::Params params = FilterParams(block.hash);
+    value.address_filter = GCSFilter(params, addresses).GetEncoded();
+    value.topic_filter = GCSFilter(params, topics).GetEncoded();
+
+    CDBBatch batch(*m_db);
+    batch.Write(DBHeightKey(DB_BLOCK_HEIGHT, block.height), value);
+    if (!events.empty()) {
+        batch.Write(DBHeightKey(DB_EVENTS, block.height), events);
+    } else {
+        batch.Erase(DBHeightKey(DB_EVENTS, block.height));
+    }
+    return m_db->WriteBatch(batch);
+}
+
+bool ContractEventIndex::CustomRewind(const interfaces::BlockRef& current_tip, const interfaces::BlockRef& new_tip)
+{
+    CDBBatch batch(*m_db);
+    for (int height = new_tip.height + 1; height <= current_tip.height; ++height) {
+        batch.Erase(DBHeightKey(DB_BLOCK_HEIGHT, height));
+        batch.Erase(DBHeightKey(DB_EVENTS, height));
+    }
+    return m_db->WriteBatch(batch);
+}
+
+BaseIndex::DB& ContractEventIndex::GetDB() const { return *m_db; }
+
+bool ContractEventIndex::LookupEvents(int start_height, const CBlockIndex* stop_index,
+                                      const std::set<uint256>& addresses, const std::set<uint256>& topics,
+                                      std::vector<IndexedContractEvent>& events_out) const
+{
+    if (start_height < 0 || start_height > stop_index->nHeight) {
+        LogError("%s: invalid height range %d-%d\n", __func__, start_height, stop_index->nHeight);
+        return false;
+    }
+
+    // Block hashes of the requested chain, to detect entries from a stale chain
+    std::vector<uint256> chain_hashes(stop_index->nHeight - start_height + 1);
+    for (const CBlockIndex* block_index = stop_index;
+         block_index && block_index->nHeight >= start_height;
+         block_index = block_index->pprev) {
+        chain_hashes[block_index->nHeight - start_height] = block_index->GetBlockHash();
+    }
+
+    const GCSFilter::ElementSet address_elements = ToElementSet(addresses);
+    const GCSFilter::ElementSet topic_elements = ToElementSet(topics);
+
+    DBHeightKey key(DB_BLOCK_HEIGHT, start_height);
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    db_it->Seek(key);
+    for (int height = start_height; height <= stop_index->nHeight; ++height) {
+        DBVal value;
+        if (!db_it->Valid() || !db_it->GetKey(key) || key.prefix != DB_BLOCK_HEIGHT || key.height != height ||
+            !db_it->GetValue(value) || value.block_hash != chain_hashes[height - start_height]) {
+            return false;
+        }
+        db_it->Next();
+
+        if (value.event_count == 0) continue;
+
+        // Skip blocks whose filters rule out every requested address or topic
+        const GCSFilter::Params params = FilterParams(value.block_hash);
+        if (!addresses.empty() &&
+            !GCSFilter(params, std::move(value.address_filter), /*skip_decode_check=*/true).MatchAny(address_elements)) {
+            continue;
+        }
+        if (!topics.empty() &&
+            !GCSFilter(params, std::move(value.topic_filter), /*skip_decode_check=*/true).MatchAny(topic_elements)) {
+            continue;
+        }
+
+        std::vector<smartcontracts::ContractEvent> events;
+        if (!m_db->Read(DBHeightKey(DB_EVENTS, height), events)) {
+            LogError("%s: unable to read events in %s at height %d\n", __func__, GetName(), height);
+            return false;
+        }
+        for (uint32_t i = 0; i < events.size(); ++i) {
+            if (EventMatches(events[i], addresses, topics)) {
+                events_out.push_back({height, value.block_hash, i, std::move(events[i])});
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,78 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_CONTRACTEVENTINDEX_H
+#define BITCOIN_INDEX_CONTRACTEVENTINDEX_H
+
+#include <index/base.h>
+#include <smartcontracts/vm.h>
+
+#include <set>
+#include <vector>
+
+class CBlockIndex;
+
+static constexpr bool DEFAULT_CONTRACTEVENTINDEX{false};
+
+/** Maximum number of blocks scanned by a single RPC or REST range query. */
+static constexpr int MAX_CONTRACT_EVENT_RANGE{10000};
+
+/** A contract event together with its position in the chain. */
+struct IndexedContractEvent {
+    int height;
+    uint256 block_hash;
+    uint32_t log_index; //!< Position of the event within its block
+    smartcontracts::ContractEvent event;
+};
+
+/**
+ * ContractEventIndex stores the events emitted by contracts in each block,
+ * keyed by height. Every block also gets two Golomb-coded set filters, one
+ * over the emitting contract addresses and one over the event topics, so
+ * range queries only read the events of blocks that may match.
+ *
+ * Events are read from the contract receipts written when each block was
+ * connected, so the index can be built or rebuilt at any time.
+ */
+class ContractEventIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+    bool AllowPrune() const override { return true; }
+
+protected:
+    bool CustomAppend(const interfaces::BlockInfo& block) override;
+
+    bool CustomRewind(const interfaces::BlockRef& current_tip, const interfaces::BlockRef& new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit ContractEventIndex(std::unique_ptr<interfaces::Chain> chain, size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~ContractEventIndex() override;
+
+    /// Find the events emitted between two heights on a chain.
+    ///
+    /// @param[in]   start_height  First height to scan.
+    /// @param[in]   stop_index  Last block to scan; its ancestors define the chain.
+    /// @param[in]   addresses  Only return events from these contracts, if not empty.
+    /// @param[in]   topics  Only return events with at least one of these topics, if not empty.
+    /// @param[out]  events_out  Matching events, in chain order.
+    /// @return  false if the range is invalid or not (yet) indexed
+    bool LookupEvents(int start_height, const CBlockIndex* stop_index,
+                      const std::set<uint256>& addresses, const std::set<uint256>& topics,
+                      std::vector<IndexedContractEvent>& events_out) const;
+};
+
+/// The global contract event index. May be null.
+extern std::unique_ptr<ContractEventIndex> g_contract_event_index;
+
+#endif // BITCOIN_INDEX_CONTRACTEVENTINDEX_H
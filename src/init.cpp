@@ -26,6 +26,7 @@
 #include <httpserver.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
+#include <index/contracteventindex.h>
 #include <index/txindex.h>
 #include <init/common.h>
 #include <interfaces/chain.h>
@@ -48,7 +49,10 @@
 #include <node/caches.h>
 #include <node/chainstate.h>
 #include <node/chainstatemanager_args.h>
+#include <node/checkpointdb.h>
+#include <node/contractreceiptdb.h>
 #include <node/context.h>
+#include <node/database_args.h>
 #include <node/interface_ui.h>
 #include <node/kernel_notifications.h>
 #include <node/mempool_args.h>
@@ -355,8 +359,11 @@ void Shutdown(NodeContext& node)
     for (auto* index : node.indexes) index->Stop();
     if (g_txindex) g_txindex.reset();
     if (g_coin_stats_index) g_coin_stats_index.reset();
+    if (g_contract_event_index) g_contract_event_index.reset();
     DestroyAllBlockFilterIndexes();
     node.indexes.clear(); // all instances are nullptr now
+    consensus::hybrid::SetCheckpointStore(nullptr, nullptr);
+    smartcontracts::SetContractReceiptStore(nullptr);
 
     // Any future callbacks will be dropped. This should absolutely be safe - if
     // missing a callback results in an unrecoverable situation, unclean shutdown
@@ -485,6 +492,7 @@ void SetupServerArgs(ArgsManager& argsman, bool can_listen_ipc)
     argsman.AddArg("-blockreconstructionextratxn=<n>", strprintf("Extra transactions to keep in memory for compact block reconstructions (default: %u)", DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blocksonly", strprintf("Whether to reject transactions from network peers. Disables automatic broadcast and rebroadcast of transactions, unless the source peer has the 'forcerelay' permission. RPC transactions are not affected. (default: %u)", DEFAULT_BLOCKSONLY), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-coinstatsindex", strprintf("Maintain coinstats index used by the gettxoutsetinfo RPC (default: %u)", DEFAULT_COINSTATSINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-contracteventindex", strprintf("Maintain an index of smart contract events, used by the getcontractevents RPC (default: %u)", DEFAULT_CONTRACTEVENTINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-conf=<file>", strprintf("Specify path to read-only configuration file. Relative paths will be prefixed by datadir location (only useable from command line, not configuration file) (default: %s)", BITCOIN_CONF_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-datadir=<dir>", "Specify data directory", ArgsManager::ALLOW_ANY | ArgsManager::DISALLOW_NEGATION, OptionsCategory::OPTIONS);
     argsman.AddArg("-dbbatchsize", strprintf("Maximum database write batch size in bytes (default: %u)", nDefaultDbBatchSize), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
@@ -492,6 +500,7 @@ void SetupServerArgs(ArgsManager& argsman, bool can_listen_ipc)
     argsman.AddArg("-includeconf=<file>", "Specify additional configuration file, relative to the -datadir path (only useable from configuration file, not command line)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-allowignoredconf", strprintf("For backwards compatibility, treat an unused %s file in the datadir as a warning, not an error.", BITCOIN_CONF_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-loadblock=<file>", "Imports blocks from external file on startup", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-loadcontractstate=<file>", "Load smart contract state from a snapshot written by the dumpcontractstate RPC on startup, instead of executing the contract calls of every block since activation. The snapshot's commitment must be recognized by the chain parameters and its base block must be in the active chain. Relative paths will be prefixed by a net-specific datadir location.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-maxmempool=<n>", strprintf("Keep the transaction memory pool below <n> megabytes (default: %u)", DEFAULT_MAX_MEMPOOL_SIZE_MB), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-maxorphantx=<n>", strprintf("Keep at most <n> unconnectable transactions in memory (default: %u)", DEFAULT_MAX_ORPHAN_TRANSACTIONS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-mempoolexpiry=<n>", strprintf("Do not keep transactions in the mempool longer than <n> hours (default: %u)", DEFAULT_MEMPOOL_EXPIRY_HOURS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
@@ -548,6 +557,7 @@ void SetupServerArgs(ArgsManager& argsman, bool can_listen_ipc)
     argsman.AddArg("-i2pacceptincoming", strprintf("Whether to accept inbound I2P connections (default: %i). Ignored if -i2psam is not set. Listening for inbound I2P connections is done through the SAM proxy, not by binding to a local address and port.", DEFAULT_I2P_ACCEPT_INCOMING), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-onlynet=<net>", "Make automatic outbound connections only to network <net> (" + Join(GetNetworkNames(), ", ") + "). Inbound and manual connections are not affected by this option. It can be specified multiple times to allow multiple networks.", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-v2transport", strprintf("Support v2 transport (default: %u)", DEFAULT_V2_TRANSPORT), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
+    argsman.AddArg("-v2hybrid", strprintf("Mix an ML-KEM-768 shared secret into the v2 transport handshake with peers that support it, for resistance against future quantum decryption of recorded traffic. Requires -v2transport (default: %u)", DEFAULT_V2_HYBRID), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-peerbloomfilters", strprintf("Support filtering of blocks and transaction with bloom filters (default: %u)", DEFAULT_PEERBLOOMFILTERS), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-peerblockfilters", strprintf("Serve compact block filters to peers per BIP 157 (default: %u)", DEFAULT_PEERBLOCKFILTERS), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-txreconciliation", strprintf("Enable transaction reconciliations per BIP 330 (default: %d)", DEFAULT_TXRECONCILIATION_ENABLE), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::CONNECTION);
@@ -953,8 +963,16 @@ bool AppInitParameterInteraction(const ArgsManager& args)
     // Signal NODE_P2P_V2 if BIP324 v2 transport is enabled.
     if (args.GetBoolArg("-v2transport", DEFAULT_V2_TRANSPORT)) {
         g_local_services = ServiceFlags(g_local_services | NODE_P2P_V2);
+
+        // Signal NODE_P2P_V2_HYBRID if the hybrid ML-KEM handshake is enabled too.
+        if (args.GetBoolArg("-v2hybrid", DEFAULT_V2_HYBRID)) {
+            g_local_services = ServiceFlags(g_local_services | NODE_P2P_V2_HYBRID);
+        }
     }
 
+    // Signal NODE_CHECKPOINT_VOTES, as checkpoint votes are always merged and relayed.
+    g_local_services = ServiceFlags(g_local_services | NODE_CHECKPOINT_VOTES);
+
     // Signal NODE_COMPACT_FILTERS if peerblockfilters and basic filters index are both enabled.
     if (args.GetBoolArg("-peerblockfilters", DEFAULT_PEERBLOCKFILTERS)) {
         if (g_enabled_filter_types.count(BlockFilterType::BASIC) != 1) {
@@ -1748,9 +1766,54 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
         node.indexes.emplace_back(g_coin_stats_index.get());
     }
 
+    if (args.GetBoolArg("-contracteventindex", DEFAULT_CONTRACTEVENTINDEX)) {
+        g_contract_event_index = std::make_unique<ContractEventIndex>(interfaces::MakeChain(node), /*cache_size=*/0, false, do_reindex);
+        node.indexes.emplace_back(g_contract_event_index.get());
+    }
+
     // Init indexes
     for (auto index : node.indexes) if (!index->Init()) return false;
 
+    // Restore hybrid consensus checkpoints and the finality watermark
+    consensus::hybrid::SetCheckpointStore(
+        std::make_unique<node::CheckpointDB>(DBParams{
+            .path = args.GetDataDirNet() / "checkpoints",
+            .cache_bytes = 1 << 20,
+            .memory_only = false,
+            .wipe_data = false,
+            .obfuscate = false,
+            .options = [&] { DBOptions options; node::ReadDatabaseArgs(args, options); return options; }()}),
+        WITH_LOCK(cs_main, return chainman.ActiveTip()));
+
+    // Receipts of the contract calls in connected blocks, for the contract event index
+    smartcontracts::SetContractReceiptStore(
+        std::make_unique<node::ContractReceiptDB>(DBParams{
+            .path = args.GetDataDirNet() / "contractreceipts",
+            .cache_bytes = 1 << 20,
+            .memory_only = false,
+            .wipe_data = false,
+            .obfuscate = false,
+            .options = [&] { DBOptions options; node::ReadDatabaseArgs(args, options); return options; }()}));
+
+    // The contract state is not persisted, so it is rebuilt before any new
+    // block is connected, from a snapshot if one is given
+    if (args.IsArgSet("-loadcontractstate")) {
+        const fs::path path{AbsPathForConfigVal(args, args.GetPathArg("-loadcontractstate"))};
+        AutoFile file{fsbridge::fopen(path, "rb")};
+        if (file.IsNull()) {
+            return InitError(strprintf(_("Cannot open contract state snapshot %s"), fs::PathToString(path)));
+        }
+        if (auto result{chainman.ActivateContractSnapshot(file, GetNumCores())}; !result) {
+            return InitError(util::ErrorString(result));
+        }
+    } else {
+        LOCK(cs_main);
+        smartcontracts::InitializeSmartContractVM(chainman.GetConsensus());
+        if (chainman.ActiveTip() && !chainman.ActiveChainstate().ReplayContractBlocks(/*base=*/nullptr, *chainman.ActiveTip())) {
+            return InitError(_("Failed to rebuild the contract state from the blocks on disk. Nodes without every block since smart contract activation, such as pruned nodes, need -loadcontractstate."));
+        }
+    }
+
     // ********************************************************* Step 9: load wallet
     for (const auto& client : node.chain_clients) {
         if (!client->load()) {
@@ -1,5 +1,10 @@
 #include <interop/bridges.h>
+#include <interop/headerchain.h>
+#include <interop/timerwheel.h>
+#include <interop/transferpipeline.h>
+#include <merkleblock.h>
 #include <primitives/transaction.h>
+#include <script/script.h>
 #include <uint256.h>
 #include <util/time.h>
 #include <logging.h>
@@ -7,7 +12,11 @@
 #include <random.h>
 #include <algorithm>
 #include <chrono>
+#include <mutex>
+#include <set>
+#include <utility>
 #include <hash.h>
+#include <streams.h>
 
 namespace interop {
 namespace bridges {
@@ -19,6 +28,64 @@ static bool g_bridge_system_initialized = false;
 // Chain configuration
 static std::map<params::SupportedChain, std::string> g_chain_rpc_endpoints;
 static std::map<params::SupportedChain, std::string> g_bridge_contracts;
+static std::map<params::SupportedChain, CScript> g_deposit_scripts;
+
+// Light clients of source chains, also read by the transfer pipeline
+static std::mutex g_light_clients_mutex;
+static std::map<params::SupportedChain, std::shared_ptr<const HeaderChain>> g_light_clients;
+
+// Transfers queued in a transfer pipeline
+static std::set<uint256> g_queued_transfers;
+
+// Persistent bridge state. Unfinished transfers and swaps are also kept in
+// g_bridge_state, with a timer for when they time out; finished ones are
+// dropped from memory at the next cleanup.
+static std::unique_ptr<BridgeStore> g_bridge_store;
+static HeightTimerWheel g_transfer_timers;
+static HeightTimerWheel g_swap_timers;
+static std::vector<uint256> g_finished_transfers;
+static std::vector<uint256> g_finished_swaps;
+
+// Source chain deposit outputs spent by transfers, while no store keeps them
+static std::map<COutPoint, uint256> g_spent_source_outpoints;
+
+/**
+ * Write a changed transfer or swap to the store, and queue it to be dropped
+ * from memory once finished
+ */
+static void UpdateTransfer(const BridgeTransfer& transfer) {
+    if (g_bridge_store && !g_bridge_store->WriteTransfer(transfer)) {
+        LogPrintf("Bitcoin Decentral: Failed to write bridge transfer %s\n", transfer.transfer_id.ToString());
+    }
+    if (!g_bridge_store && !transfer.source_outpoint.IsNull()) {
+        g_spent_source_outpoints.emplace(transfer.source_outpoint, transfer.transfer_id);
+    }
+    if (transfer.IsFinished()) {
+        g_finished_transfers.push_back(transfer.transfer_id);
+    }
+}
+
+static void UpdateSwap(const AtomicSwap& swap) {
+    if (g_bridge_store && !g_bridge_store->WriteSwap(swap)) {
+        LogPrintf("Bitcoin Decentral: Failed to write atomic swap %s\n", swap.swap_id.ToString());
+    }
+    if (swap.IsFinished()) {
+        g_finished_swaps.push_back(swap.swap_id);
+    }
+}
+
+/**
+ * Add a transfer or swap to memory, with its timeout timer
+ */
+static void AddTransfer(const BridgeTransfer& transfer) {
+    g_bridge_state.active_transfers[transfer.transfer_id] = transfer;
+    g_transfer_timers.Schedule(transfer.creation_height + params::BRIDGE_TIMEOUT, transfer.transfer_id);
+}
+
+static void AddSwap(const AtomicSwap& swap) {
+    g_bridge_state.active_swaps[swap.swap_id] = swap;
+    g_swap_timers.Schedule(swap.timeout_height, swap.swap_id);
+}
 
 /**
  * Initialize cross-chain bridge system
@@ -32,6 +99,14 @@ bool InitializeBridgeSystem() {
         g_bridge_state.total_bridge_volume = 0;
         g_bridge_state.total_transfers = 0;
         g_bridge_state.successful_transfers = 0;
+        g_queued_transfers.clear();
+        g_bridge_store.reset();
+        g_transfer_timers = HeightTimerWheel{};
+        g_swap_timers = HeightTimerWheel{};
+        g_finished_transfers.clear();
+        g_finished_swaps.clear();
+        g_spent_source_outpoints.clear();
+        g_deposit_scripts.clear();
         
         // Initialize supported chains
         AddSupportedBlockchain(params::CHAIN_BITCOIN, "http://localhost:8332", "");
@@ -161,12 +236,13 @@ bool InitiateBridgeTransfer(const uint256& user_id, params::SupportedChain sourc
         transfer.asset_id = asset_id;
         transfer.amount = amount;
         transfer.dest_address = dest_address;
-        transfer.creation_height = 0; // Will be set when included in block
+        transfer.creation_height = g_transfer_timers.GetHeight();
         transfer.status = BridgeTransfer::TRANSFER_PENDING;
         transfer.bridge_fee = CalculateBridgeFee(amount, source_chain, dest_chain);
         
         // Add to active transfers
-        g_bridge_state.active_transfers[transfer.transfer_id] = transfer;
+        AddTransfer(transfer);
+        UpdateTransfer(transfer);
         g_bridge_state.total_transfers++;
         
         LogPrintf("Bitcoin Decentral: Initiated bridge transfer %s: %llu %s from chain %d to chain %d\n",
@@ -181,72 +257,65 @@ bool InitiateBridgeTransfer(const uint256& user_id, params::SupportedChain sourc
 }
 
 /**
- * Process bridge transfer
+ * Queue pending transfers in a transfer pipeline
  */
-bool ProcessBridgeTransfer(const uint256& transfer_id) {
-    try {
-        auto it = g_bridge_state.active_transfers.find(transfer_id);
-        if (it == g_bridge_state.active_transfers.end()) {
-            return false;
+size_t QueueBridgeTransfers(BridgeTransferPipeline& pipeline) {
+    size_t queued = 0;
+    for (auto& [transfer_id, transfer] : g_bridge_state.active_transfers) {
+        if (transfer.status != BridgeTransfer::TRANSFER_PENDING || transfer.source_outpoint.IsNull() ||
+            g_queued_transfers.contains(transfer_id)) {
+            continue;
         }
-        
-        BridgeTransfer& transfer = it->second;
-        
-        // Validate transfer
         if (!ValidateBridgeTransfer(transfer)) {
             transfer.status = BridgeTransfer::TRANSFER_FAILED;
+            UpdateTransfer(transfer);
             LogPrintf("Bitcoin Decentral: Bridge transfer %s validation failed\n", transfer_id.ToString());
-            return false;
+            continue;
         }
-        
-        // Check source chain confirmation
-        if (transfer.status == BridgeTransfer::TRANSFER_PENDING) {
-            if (VerifyExternalChainTransaction(transfer.source_chain, transfer.source_tx_hash,
-                                             GetRequiredConfirmations(transfer.source_chain))) {
-                transfer.status = BridgeTransfer::TRANSFER_CONFIRMED;
-                LogPrintf("Bitcoin Decentral: Bridge transfer %s confirmed on source chain\n",
-                         transfer_id.ToString());
-            }
+        if (!pipeline.Submit(transfer)) break;
+        g_queued_transfers.insert(transfer_id);
+        ++queued;
+    }
+    return queued;
+}
+
+/**
+ * Record the transfers that have left a transfer pipeline
+ */
+size_t ApplyBridgeTransferResults(BridgeTransferPipeline& pipeline) {
+    std::vector<BridgeTransferBatch> batches;
+    const std::vector<BridgeTransfer> transfers = pipeline.TakeCompleted(batches);
+    for (BridgeTransferBatch& batch : batches) {
+        if (g_bridge_store && !g_bridge_store->WriteTransferBatch(batch)) {
+            LogPrintf("Bitcoin Decentral: Failed to write bridge transfer batch %s\n", batch.batch_root.ToString());
         }
+        g_bridge_state.transfer_batches[batch.batch_root] = std::move(batch);
+    }
+    
+    for (const BridgeTransfer& result : transfers) {
+        g_queued_transfers.erase(result.transfer_id);
+        auto it = g_bridge_state.active_transfers.find(result.transfer_id);
+        if (it == g_bridge_state.active_transfers.end()) continue;
         
-        // Process confirmed transfer
-        if (transfer.status == BridgeTransfer::TRANSFER_CONFIRMED) {
-            // Get validator signatures
-            std::vector<uint256> selected_validators = SelectBridgeValidators();
-            
-            // Simulate validator signatures (in real implementation, this would be cryptographic)
-            for (const auto& validator_id : selected_validators) {
-                transfer.validator_signatures.push_back(validator_id);
-            }
-            
-            // Check if we have enough signatures
-            if (CheckBridgeSecurityThreshold(transfer.validator_signatures)) {
-                transfer.status = BridgeTransfer::TRANSFER_PROCESSING;
-                LogPrintf("Bitcoin Decentral: Bridge transfer %s has sufficient validator signatures\n",
-                         transfer_id.ToString());
-                
-                // Execute transfer on destination chain
-                if (ExecuteDestinationChainTransfer(transfer)) {
-                    transfer.status = BridgeTransfer::TRANSFER_COMPLETED;
-                    transfer.completion_height = 0; // Current height
-                    g_bridge_state.successful_transfers++;
-                    g_bridge_state.total_bridge_volume += transfer.amount;
-                    
-                    LogPrintf("Bitcoin Decentral: Bridge transfer %s completed successfully\n",
-                             transfer_id.ToString());
-                } else {
-                    transfer.status = BridgeTransfer::TRANSFER_FAILED;
-                    LogPrintf("Bitcoin Decentral: Bridge transfer %s execution failed\n",
-                             transfer_id.ToString());
-                }
-            }
+        BridgeTransfer& transfer = it->second;
+        transfer.status = result.status;
+        transfer.validator_signatures = result.validator_signatures;
+        transfer.batch_root = result.batch_root;
+        if (transfer.status == BridgeTransfer::TRANSFER_COMPLETED) {
+            g_bridge_state.successful_transfers++;
+            g_bridge_state.total_bridge_volume += transfer.amount;
         }
-        
-        return true;
-    } catch (const std::exception& e) {
-        LogPrintf("Bitcoin Decentral: Failed to process bridge transfer: %s\n", e.what());
-        return false;
+        UpdateTransfer(transfer);
     }
+    return transfers.size();
+}
+
+uint256 GetBridgeTransferHash(const BridgeTransfer& transfer) {
+    HashWriter hasher{};
+    hasher << transfer.transfer_id << static_cast<int32_t>(transfer.source_chain)
+           << static_cast<int32_t>(transfer.dest_chain) << transfer.asset_id << transfer.amount
+           << transfer.dest_address << transfer.source_tx_hash;
+    return hasher.GetHash();
 }
 
 /**
@@ -302,7 +371,8 @@ bool InitiateAtomicSwap(const uint256& initiator_id, params::SupportedChain chai
         }
         
         // Add to active swaps
-        g_bridge_state.active_swaps[swap.swap_id] = swap;
+        AddSwap(swap);
+        UpdateSwap(swap);
         
         LogPrintf("Bitcoin Decentral: Initiated atomic swap %s: %llu on chain %d for %llu on chain %d\n",
                  swap.swap_id.ToString(), amount_a, static_cast<int>(chain_a),
@@ -334,6 +404,7 @@ bool ParticipateAtomicSwap(const uint256& swap_id, const uint256& participant_id
         
         swap.participant_id = participant_id;
         swap.status = AtomicSwap::SWAP_PARTICIPATED;
+        UpdateSwap(swap);
         
         LogPrintf("Bitcoin Decentral: Participant %s joined atomic swap %s\n",
                  participant_id.ToString(), swap_id.ToString());
@@ -374,6 +445,7 @@ bool RedeemAtomicSwap(const uint256& swap_id, const uint256& secret) {
         
         swap.secret = secret;
         swap.status = AtomicSwap::SWAP_REDEEMED;
+        UpdateSwap(swap);
         
         LogPrintf("Bitcoin Decentral: Atomic swap %s redeemed successfully\n", swap_id.ToString());
         
@@ -427,17 +499,131 @@ uint64_t CalculateBridgeFee(uint64_t amount, params::SupportedChain source_chain
     return fee;
 }
 
+/**
+ * Verify transactions on chain against a local header chain
+ */
+bool SetChainLightClient(params::SupportedChain chain, std::shared_ptr<const HeaderChain> headers) {
+    std::lock_guard<std::mutex> lock(g_light_clients_mutex);
+    if (!headers) {
+        g_light_clients.erase(chain);
+        return true;
+    }
+    g_light_clients[chain] = std::move(headers);
+    LogPrintf("Bitcoin Decentral: Verifying transactions on chain %d with a light client\n", static_cast<int>(chain));
+    return true;
+}
+
+/**
+ * Get the light client of chain
+ */
+std::shared_ptr<const HeaderChain> GetChainLightClient(params::SupportedChain chain) {
+    std::lock_guard<std::mutex> lock(g_light_clients_mutex);
+    auto it = g_light_clients.find(chain);
+    return it != g_light_clients.end() ? it->second : nullptr;
+}
+
+/**
+ * Set the script that deposits to the bridge pay on a source chain
+ */
+void SetBridgeDepositScript(params::SupportedChain chain, const CScript& script) {
+    g_deposit_scripts[chain] = script;
+}
+
+uint256 GetBridgeDepositCommitment(const BridgeTransfer& transfer) {
+    HashWriter hasher{};
+    hasher << transfer.asset_id << static_cast<int32_t>(transfer.dest_chain) << transfer.dest_address;
+    return hasher.GetHash();
+}
+
+/**
+ * Find the output of a source chain transaction that deposits a transfer
+ */
+std::optional<COutPoint> FindBridgeDeposit(const BridgeTransfer& transfer, const CTransaction& source_tx) {
+    auto script_it = g_deposit_scripts.find(transfer.source_chain);
+    if (script_it == g_deposit_scripts.end()) return std::nullopt;
+    
+    const CScript commitment = CScript() << OP_RETURN << ToByteVector(GetBridgeDepositCommitment(transfer));
+    if (std::none_of(source_tx.vout.begin(), source_tx.vout.end(),
+                     [&](const CTxOut& txout) { return txout.scriptPubKey == commitment; })) {
+        return std::nullopt;
+    }
+    for (uint32_t n = 0; n < source_tx.vout.size(); ++n) {
+        const CTxOut& txout = source_tx.vout[n];
+        if (txout.scriptPubKey == script_it->second && txout.nValue >= 0 &&
+            static_cast<uint64_t>(txout.nValue) == transfer.amount) {
+            return COutPoint{source_tx.GetHash(), n};
+        }
+    }
+    return std::nullopt;
+}
+
+/**
+ * The transfer that spent a source chain deposit output, if any
+ */
+static std::optional<uint256> GetSpentSourceOutPoint(const COutPoint& outpoint) {
+    if (g_bridge_store) return g_bridge_store->ReadSpentSourceOutPoint(outpoint);
+    auto it = g_spent_source_outpoints.find(outpoint);
+    if (it == g_spent_source_outpoints.end()) return std::nullopt;
+    return it->second;
+}
+
+/**
+ * Attach the source chain transaction and its merkle proof to a transfer
+ */
+bool SubmitBridgeTransferProof(const uint256& transfer_id, const CTransaction& source_tx,
+                             const std::vector<uint8_t>& proof) {
+    auto it = g_bridge_state.active_transfers.find(transfer_id);
+    if (it == g_bridge_state.active_transfers.end() ||
+        it->second.status != BridgeTransfer::TRANSFER_PENDING) {
+        return false;
+    }
+    BridgeTransfer& transfer = it->second;
+    
+    const auto deposit = FindBridgeDeposit(transfer, source_tx);
+    if (!deposit) {
+        LogPrintf("Bitcoin Decentral: Transaction %s does not deposit bridge transfer %s\n",
+                 source_tx.GetHash().ToString(), transfer_id.ToString());
+        return false;
+    }
+    // A transfer keeps its deposit, though a new proof of it may replace the
+    // old one, for example after a source chain reorg
+    if (!transfer.source_outpoint.IsNull() && transfer.source_outpoint != *deposit) {
+        return false;
+    }
+    if (const auto spender = GetSpentSourceOutPoint(*deposit); spender && *spender != transfer_id) {
+        LogPrintf("Bitcoin Decentral: Deposit %s of bridge transfer %s was already spent by transfer %s\n",
+                 deposit->ToString(), transfer_id.ToString(), spender->ToString());
+        return false;
+    }
+    
+    transfer.source_tx_hash = source_tx.GetHash().ToUint256();
+    transfer.source_tx_proof = proof;
+    transfer.source_outpoint = *deposit;
+    UpdateTransfer(transfer);
+    return true;
+}
+
 /**
  * Verify transaction on external chain
  */
 bool VerifyExternalChainTransaction(params::SupportedChain chain, const uint256& tx_hash,
-                                  uint32_t required_confirmations) {
-    // Simplified implementation - in reality, this would make RPC calls to external chains
-    LogPrintf("Bitcoin Decentral: Verifying transaction %s on chain %d (need %d confirmations)\n",
-             tx_hash.ToString(), static_cast<int>(chain), required_confirmations);
+                                  const std::vector<uint8_t>& proof, uint32_t required_confirmations) {
+    const auto light_client = GetChainLightClient(chain);
+    if (!light_client) {
+        LogPrintf("Bitcoin Decentral: No light client to verify transaction %s on chain %d\n",
+                 tx_hash.ToString(), static_cast<int>(chain));
+        return false;
+    }
     
-    // Simulate verification success
-    return true;
+    try {
+        CMerkleBlock merkle_block;
+        SpanReader{proof} >> merkle_block;
+        return light_client->VerifyTransaction(tx_hash, merkle_block, required_confirmations);
+    } catch (const std::exception& e) {
+        LogPrintf("Bitcoin Decentral: Invalid proof for transaction %s on chain %d: %s\n",
+                 tx_hash.ToString(), static_cast<int>(chain), e.what());
+        return false;
+    }
 }
 
 /**
@@ -570,32 +756,134 @@ void MonitorBridgePerformance() {
 }
 
 /**
- * Cleanup expired bridge operations
+ * Drop finished bridge operations from memory
  */
 void CleanupExpiredBridgeOperations() {
-    // Remove completed transfers
-    auto transfer_it = g_bridge_state.active_transfers.begin();
-    while (transfer_it != g_bridge_state.active_transfers.end()) {
-        if (transfer_it->second.status == BridgeTransfer::TRANSFER_COMPLETED ||
-            transfer_it->second.status == BridgeTransfer::TRANSFER_FAILED ||
-            transfer_it->second.status == BridgeTransfer::TRANSFER_REFUNDED) {
-            transfer_it = g_bridge_state.active_transfers.erase(transfer_it);
-        } else {
-            ++transfer_it;
+    for (const uint256& transfer_id : std::exchange(g_finished_transfers, {})) {
+        auto it = g_bridge_state.active_transfers.find(transfer_id);
+        if (it == g_bridge_state.active_transfers.end() || !it->second.IsFinished()) continue;
+        // A batch's transfers finish together
+        g_bridge_state.transfer_batches.erase(it->second.batch_root);
+        g_bridge_state.active_transfers.erase(it);
+    }
+    
+    for (const uint256& swap_id : std::exchange(g_finished_swaps, {})) {
+        auto it = g_bridge_state.active_swaps.find(swap_id);
+        if (it != g_bridge_state.active_swaps.end() && it->second.IsFinished()) {
+            g_bridge_state.active_swaps.erase(it);
+        }
+    }
+}
+
+/**
+ * Persist transfers and swaps to a store
+ */
+void SetBridgeStore(std::unique_ptr<BridgeStore> store, uint32_t height) {
+    g_bridge_store = std::move(store);
+    g_transfer_timers = HeightTimerWheel{height};
+    g_swap_timers = HeightTimerWheel{height};
+    if (!g_bridge_store) return;
+    
+    // Transfers and swaps created before the store was set are written to it
+    for (const auto& [transfer_id, transfer] : g_bridge_state.active_transfers) {
+        UpdateTransfer(transfer);
+    }
+    for (const auto& [swap_id, swap] : g_bridge_state.active_swaps) {
+        UpdateSwap(swap);
+    }
+    
+    for (const auto status : {BridgeTransfer::TRANSFER_PENDING, BridgeTransfer::TRANSFER_CONFIRMED,
+                              BridgeTransfer::TRANSFER_PROCESSING}) {
+        for (const uint256& transfer_id : g_bridge_store->GetTransfersWithStatus(status)) {
+            if (auto transfer = g_bridge_store->ReadTransfer(transfer_id)) AddTransfer(*transfer);
+        }
+    }
+    for (const auto status : {AtomicSwap::SWAP_INITIATED, AtomicSwap::SWAP_PARTICIPATED}) {
+        for (const uint256& swap_id : g_bridge_store->GetSwapsWithStatus(status)) {
+            if (auto swap = g_bridge_store->ReadSwap(swap_id)) AddSwap(*swap);
+        }
+    }
+    
+    LogPrintf("Bitcoin Decentral: Loaded %d unfinished bridge transfers and %d atomic swaps at height %d\n",
+             g_transfer_timers.Size(), g_swap_timers.Size(), height);
+}
+
+/**
+ * Expire transfers and swaps due at the heights up to height
+ */
+void ProcessBridgeBlock(uint32_t height) {
+    for (const uint256& transfer_id : g_transfer_timers.Advance(height)) {
+        auto it = g_bridge_state.active_transfers.find(transfer_id);
+        if (it == g_bridge_state.active_transfers.end() || it->second.IsFinished()) continue;
+        if (g_queued_transfers.contains(transfer_id)) {
+            // Decided by the pipeline once it hands the transfer back
+            g_transfer_timers.Schedule(height + 1, transfer_id);
+            continue;
+        }
+        
+        BridgeTransfer& transfer = it->second;
+        transfer.status = BridgeTransfer::TRANSFER_REFUNDED;
+        transfer.completion_height = height;
+        UpdateTransfer(transfer);
+        LogPrintf("Bitcoin Decentral: Bridge transfer %s timed out, refunded\n", transfer_id.ToString());
+    }
+    
+    for (const uint256& swap_id : g_swap_timers.Advance(height)) {
+        auto it = g_bridge_state.active_swaps.find(swap_id);
+        if (it == g_bridge_state.active_swaps.end() || it->second.IsFinished()) continue;
+        
+        it->second.status = AtomicSwap::SWAP_EXPIRED;
+        UpdateSwap(it->second);
+        LogPrintf("Bitcoin Decentral: Atomic swap %s expired\n", swap_id.ToString());
+    }
+    
+    CleanupExpiredBridgeOperations();
+}
+
+/**
+ * Get transfers by user or status
+ */
+std::vector<BridgeTransfer> GetUserBridgeTransfers(const uint256& user_id) {
+    std::vector<BridgeTransfer> transfers;
+    if (g_bridge_store) {
+        for (const uint256& transfer_id : g_bridge_store->GetUserTransfers(user_id)) {
+            if (auto transfer = g_bridge_store->ReadTransfer(transfer_id)) transfers.push_back(std::move(*transfer));
         }
+        return transfers;
+    }
+    
+    for (const auto& [transfer_id, transfer] : g_bridge_state.active_transfers) {
+        if (transfer.user_id == user_id) transfers.push_back(transfer);
     }
+    return transfers;
+}
+
+std::vector<uint256> GetBridgeTransfersWithStatus(BridgeTransfer::Status status) {
+    if (g_bridge_store) return g_bridge_store->GetTransfersWithStatus(status);
     
-    // Remove completed swaps
-    auto swap_it = g_bridge_state.active_swaps.begin();
-    while (swap_it != g_bridge_state.active_swaps.end()) {
-        if (swap_it->second.status == AtomicSwap::SWAP_REDEEMED ||
-            swap_it->second.status == AtomicSwap::SWAP_REFUNDED ||
-            swap_it->second.status == AtomicSwap::SWAP_EXPIRED) {
-            swap_it = g_bridge_state.active_swaps.erase(swap_it);
-        } else {
-            ++swap_it;
+    std::vector<uint256> transfer_ids;
+    for (const auto& [transfer_id, transfer] : g_bridge_state.active_transfers) {
+        if (transfer.status == status) transfer_ids.push_back(transfer_id);
+    }
+    return transfer_ids;
+}
+
+/**
+ * Get the swaps a user initiated or participated in
+ */
+std::vector<AtomicSwap> GetUserAtomicSwaps(const uint256& user_id) {
+    std::vector<AtomicSwap> swaps;
+    if (g_bridge_store) {
+        for (const uint256& swap_id : g_bridge_store->GetUserSwaps(user_id)) {
+            if (auto swap = g_bridge_store->ReadSwap(swap_id)) swaps.push_back(std::move(*swap));
         }
+        return swaps;
+    }
+    
+    for (const auto& [swap_id, swap] : g_bridge_state.active_swaps) {
+        if (swap.initiator_id == user_id || swap.participant_id == user_id) swaps.push_back(swap);
     }
+    return swaps;
 }
 
 /**
@@ -6,8 +6,10 @@
 #include <map>
 #include <string>
 #include <memory>
+#include <optional>
 
-class CTransaction;
+#include <primitives/transaction.h>
+#include <serialize.h>
 #include <uint256.h>
 class CScript;
 
@@ -28,7 +30,9 @@ class CScript;
  */
 
 namespace interop {
+class HeaderChain;
 namespace bridges {
+class BridgeTransferPipeline;
 
 /**
  * Cross-chain bridge constants
@@ -117,6 +121,8 @@ struct BridgeTransfer {
     std::string source_address;     // Source address
     std::string dest_address;       // Destination address
     uint256 source_tx_hash;         // Source transaction hash
+    std::vector<uint8_t> source_tx_proof; // Merkle proof of the source transaction
+    COutPoint source_outpoint;      // Deposit output of the source transaction
     enum Status : uint8_t {
         TRANSFER_PENDING = 0,       // Transfer initiated, awaiting confirmations
         TRANSFER_CONFIRMED,         // Source transaction confirmed
@@ -131,11 +137,43 @@ struct BridgeTransfer {
     uint32_t completion_height;     // Block height when completed
     Status status;                  // Current transfer status
     std::vector<uint256> validator_signatures; // Validator signatures
+    uint256 batch_root;             // Merkle root of the batch the transfer was signed in
     uint64_t bridge_fee;            // Bridge fee paid
     
     BridgeTransfer() : source_chain(params::CHAIN_BITCOIN), dest_chain(params::CHAIN_BITCOIN),
                       amount(0), creation_height(0), completion_height(0),
                       status(TRANSFER_PENDING), bridge_fee(0) {}
+    
+    bool IsFinished() const {
+        return status == TRANSFER_COMPLETED || status == TRANSFER_FAILED || status == TRANSFER_REFUNDED;
+    }
+    
+    SERIALIZE_METHODS(BridgeTransfer, obj) {
+        int32_t source_chain = obj.source_chain, dest_chain = obj.dest_chain;
+        uint8_t status = obj.status;
+        READWRITE(obj.transfer_id, obj.user_id, source_chain, dest_chain, obj.asset_id, obj.amount,
+                  obj.source_address, obj.dest_address, obj.source_tx_hash, obj.source_tx_proof,
+                  obj.source_outpoint, obj.dest_tx_hash, obj.creation_height, obj.completion_height, status,
+                  obj.validator_signatures, obj.batch_root, obj.bridge_fee);
+        SER_READ(obj, obj.source_chain = static_cast<params::SupportedChain>(source_chain));
+        SER_READ(obj, obj.dest_chain = static_cast<params::SupportedChain>(dest_chain));
+        SER_READ(obj, obj.status = static_cast<Status>(status));
+    }
+};
+
+/**
+ * Bridge transfers signed together, by one aggregate signature of the
+ * merkle root of their transfer hashes
+ */
+struct BridgeTransferBatch {
+    uint256 batch_root;             // Merkle root of the transfer hashes, in batch order
+    std::vector<uint256> transfer_ids; // Transfers in the batch
+    std::vector<uint256> signers;   // Validators that signed the batch
+    std::vector<unsigned char> signature; // Aggregate signature of batch_root
+    
+    SERIALIZE_METHODS(BridgeTransferBatch, obj) {
+        READWRITE(obj.batch_root, obj.transfer_ids, obj.signers, obj.signature);
+    }
 };
 
 /**
@@ -168,6 +206,54 @@ struct AtomicSwap {
     
     AtomicSwap() : chain_a(params::CHAIN_BITCOIN), chain_b(params::CHAIN_BITCOIN),
                   amount_a(0), amount_b(0), timeout_height(0), status(SWAP_INITIATED) {}
+    
+    bool IsFinished() const {
+        return status == SWAP_REDEEMED || status == SWAP_REFUNDED || status == SWAP_EXPIRED;
+    }
+    
+    SERIALIZE_METHODS(AtomicSwap, obj) {
+        int32_t chain_a = obj.chain_a, chain_b = obj.chain_b;
+        uint8_t status = obj.status;
+        READWRITE(obj.swap_id, obj.initiator_id, obj.participant_id, chain_a, chain_b, obj.asset_a_id,
+                  obj.asset_b_id, obj.amount_a, obj.amount_b, obj.hash_lock, obj.secret, obj.timeout_height,
+                  status, obj.contract_a_hash, obj.contract_b_hash);
+        SER_READ(obj, obj.chain_a = static_cast<params::SupportedChain>(chain_a));
+        SER_READ(obj, obj.chain_b = static_cast<params::SupportedChain>(chain_b));
+        SER_READ(obj, obj.status = static_cast<Status>(status));
+    }
+};
+
+/**
+ * Persistent store of bridge transfers and atomic swaps, indexed by status
+ * and by user. Only unfinished transfers and swaps are kept in memory; the
+ * store keeps their whole history.
+ */
+class BridgeStore
+{
+public:
+    virtual ~BridgeStore() = default;
+    
+    /** Write a transfer, moving it between status index entries */
+    virtual bool WriteTransfer(const BridgeTransfer& transfer) = 0;
+    virtual std::optional<BridgeTransfer> ReadTransfer(const uint256& transfer_id) const = 0;
+    virtual std::vector<uint256> GetTransfersWithStatus(BridgeTransfer::Status status) const = 0;
+    virtual std::vector<uint256> GetUserTransfers(const uint256& user_id) const = 0;
+    
+    /** Write a swap, moving it between status index entries */
+    virtual bool WriteSwap(const AtomicSwap& swap) = 0;
+    virtual std::optional<AtomicSwap> ReadSwap(const uint256& swap_id) const = 0;
+    virtual std::vector<uint256> GetSwapsWithStatus(AtomicSwap::Status status) const = 0;
+    /** Swaps the user initiated or participated in */
+    virtual std::vector<uint256> GetUserSwaps(const uint256& user_id) const = 0;
+    
+    virtual bool WriteTransferBatch(const BridgeTransferBatch& batch) = 0;
+    virtual std::optional<BridgeTransferBatch> ReadTransferBatch(const uint256& batch_root) const = 0;
+    
+    /**
+     * The transfer that spent a source chain deposit output. Written with the
+     * transfer that has it as its source_outpoint, and never erased.
+     */
+    virtual std::optional<uint256> ReadSpentSourceOutPoint(const COutPoint& outpoint) const = 0;
 };
 
 /**
@@ -178,6 +264,7 @@ struct BridgeNetworkState {
     std::map<uint256, CrossChainAsset> supported_assets;    // Supported cross-chain assets
     std::map<uint256, BridgeTransfer> active_transfers;     // Active bridge transfers
     std::map<uint256, AtomicSwap> active_swaps;            // Active atomic swaps
+    std::map<uint256, BridgeTransferBatch> transfer_batches; // Signed transfer batches by merkle root
     uint64_t total_bridge_volume;                          // Total bridge volume
     uint32_t total_transfers;                              // Total transfers processed
     uint32_t successful_transfers;                         // Successful transfers
@@ -223,9 +310,22 @@ bool InitiateBridgeTransfer(const uint256& user_id, params::SupportedChain sourc
                           uint64_t amount, const std::string& dest_address);
 
 /**
- * Process bridge transfer
+ * Queue pending transfers that have a source transaction proof in a
+ * transfer pipeline; returns the number queued
  */
-bool ProcessBridgeTransfer(const uint256& transfer_id);
+size_t QueueBridgeTransfers(BridgeTransferPipeline& pipeline);
+
+/**
+ * Record the transfers that have left a transfer pipeline in the bridge
+ * state; returns the number recorded
+ */
+size_t ApplyBridgeTransferResults(BridgeTransferPipeline& pipeline);
+
+/**
+ * Get the hash committing to a transfer's parameters, which validators sign
+ * as a leaf of a transfer batch
+ */
+uint256 GetBridgeTransferHash(const BridgeTransfer& transfer);
 
 /**
  * Validate bridge transfer
@@ -284,10 +384,48 @@ bool ValidateAtomicSwapParameters(const AtomicSwap& swap);
  */
 
 /**
- * Verify transaction on external chain
+ * Verify transactions on chain against a local header chain, instead of
+ * asking its RPC endpoint; nullptr removes it
+ */
+bool SetChainLightClient(params::SupportedChain chain, std::shared_ptr<const HeaderChain> headers);
+
+/**
+ * Get the light client of chain, if it has one
+ */
+std::shared_ptr<const HeaderChain> GetChainLightClient(params::SupportedChain chain);
+
+/**
+ * Set the script that deposits to the bridge pay on a source chain
+ */
+void SetBridgeDepositScript(params::SupportedChain chain, const CScript& script);
+
+/**
+ * Get the hash a deposit commits to in an OP_RETURN output, binding it to
+ * the transfer's asset and destination
+ */
+uint256 GetBridgeDepositCommitment(const BridgeTransfer& transfer);
+
+/**
+ * Find the output of a source chain transaction that deposits a transfer:
+ * it pays the bridge's deposit script exactly the transfer amount, and the
+ * transaction commits to the transfer's asset and destination
+ */
+std::optional<COutPoint> FindBridgeDeposit(const BridgeTransfer& transfer, const CTransaction& source_tx);
+
+/**
+ * Attach the source chain transaction and its merkle proof to a transfer.
+ * Fails unless the transaction deposits the transfer from an output that
+ * no other transfer has spent.
+ */
+bool SubmitBridgeTransferProof(const uint256& transfer_id, const CTransaction& source_tx,
+                             const std::vector<uint8_t>& proof);
+
+/**
+ * Verify transaction on external chain, from a merkle proof (as produced by
+ * gettxoutproof) checked against the chain's light client
  */
 bool VerifyExternalChainTransaction(params::SupportedChain chain, const uint256& tx_hash,
-                                  uint32_t required_confirmations);
+                                  const std::vector<uint8_t>& proof, uint32_t required_confirmations);
 
 /**
  * Generate cross-chain proof
@@ -409,6 +547,30 @@ bool AcknowledgeIBCPacket(const std::string& channel_id, uint64_t sequence,
  * Utility functions
  */
 
+/**
+ * Persist transfers and swaps to a store, from the bridge height given.
+ * Unfinished transfers and swaps in the store are loaded back into memory.
+ */
+void SetBridgeStore(std::unique_ptr<BridgeStore> store, uint32_t height);
+
+/**
+ * Expire the transfers and swaps that time out at the heights up to height,
+ * and drop finished ones from memory
+ */
+void ProcessBridgeBlock(uint32_t height);
+
+/**
+ * Get transfers by user or status, including finished ones while a store
+ * is set
+ */
+std::vector<BridgeTransfer> GetUserBridgeTransfers(const uint256& user_id);
+std::vector<uint256> GetBridgeTransfersWithStatus(BridgeTransfer::Status status);
+
+/**
+ * Get the swaps a user initiated or participated in
+ */
+std::vector<AtomicSwap> GetUserAtomicSwaps(const uint256& user_id);
+
 /**
  * Get bridge network state
  */
@@ -470,7 +632,7 @@ BridgeStats GetBridgeStatistics();
 void MonitorBridgePerformance();
 
 /**
- * Cleanup expired transfers and swaps
+ * Drop transfers and swaps that finished since the last cleanup from memory
  */
 void CleanupExpiredBridgeOperations();
 
@@ -0,0 +1,405 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <interop/headerchain.h>
+
+#include <chain.h>
+#include <crypto/common.h>
+#include <logging.h>
+#include <merkleblock.h>
+#include <pow.h>
+#include <span.h>
+#include <tinyformat.h>
+#include <util/time.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace interop {
+
+namespace {
+
+/**
+ * File layout: a 16 byte file header (magic, then the number of headers as
+ * little-endian uint32), followed by one record per height holding the
+ * serialized header and the cumulative work up to it
+ */
+constexpr std::array<unsigned char, 8> FILE_MAGIC{'B', 'D', 'H', 'D', 'R', 'S', 0, 1};
+constexpr size_t FILE_HEADER_SIZE = 16;
+constexpr size_t HEADER_SIZE = 80;
+constexpr size_t RECORD_SIZE = HEADER_SIZE + 32;
+
+/** Records added to the mapping each time it fills up */
+constexpr size_t GROWTH_RECORDS = 1 << 14;
+
+/** Headers asked from a feeder at a time */
+constexpr size_t SYNC_BATCH_SIZE = 2000;
+
+/** Number of previous headers whose median time a header must exceed */
+constexpr int MEDIAN_TIME_SPAN = 11;
+
+size_t RecordOffset(size_t height)
+{
+    return FILE_HEADER_SIZE + height * RECORD_SIZE;
+}
+
+} // namespace
+
+bool VerifyMerkleProof(const uint256& txid, const CMerkleBlock& proof)
+{
+    std::vector<uint256> matches;
+    std::vector<unsigned int> indexes;
+    CPartialMerkleTree txn = proof.txn;
+    return txn.ExtractMatches(matches, indexes) == proof.header.hashMerkleRoot &&
+           std::find(matches.begin(), matches.end(), txid) != matches.end();
+}
+
+std::vector<CBlockHeader> FileHeaderFeeder::GetHeaders(const uint256& tip_hash, size_t max_count)
+{
+    std::vector<CBlockHeader> headers;
+    try {
+        while (headers.size() < max_count) {
+            CBlockHeader header;
+            m_file >> header;
+            headers.push_back(header);
+        }
+    } catch (const std::ios_base::failure&) {
+        // End of file
+    }
+    return headers;
+}
+
+HeaderChain::HeaderChain(const fs::path& path, const Consensus::Params& params, const CBlockHeader& genesis)
+    : m_params{params}
+{
+    LOCK(m_mutex);
+    size_t file_size;
+#ifdef WIN32
+    m_file = CreateFileW(path.wstring().c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE) {
+        m_file = nullptr;
+        throw std::runtime_error(strprintf("Cannot open header chain file %s", fs::PathToString(path)));
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file, &size)) {
+        CloseHandle(m_file);
+        throw std::runtime_error(strprintf("Cannot read size of header chain file %s", fs::PathToString(path)));
+    }
+    file_size = size.QuadPart;
+#else
+    m_fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (m_fd < 0) {
+        throw std::runtime_error(strprintf("Cannot open header chain file %s", fs::PathToString(path)));
+    }
+    struct stat st;
+    if (fstat(m_fd, &st) != 0) {
+        close(m_fd);
+        throw std::runtime_error(strprintf("Cannot read size of header chain file %s", fs::PathToString(path)));
+    }
+    file_size = st.st_size;
+#endif
+
+    try {
+        if (file_size < RecordOffset(1)) {
+            // New chain, starting at genesis
+            Map(GROWTH_RECORDS);
+            std::memcpy(m_data, FILE_MAGIC.data(), FILE_MAGIC.size());
+            WriteRecord(0, genesis, GetBlockProof(CBlockIndex{genesis}));
+            SetCount(1);
+        } else {
+            Map((file_size - FILE_HEADER_SIZE) / RECORD_SIZE);
+            if (std::memcmp(m_data, FILE_MAGIC.data(), FILE_MAGIC.size()) != 0) {
+                throw std::runtime_error(strprintf("%s is not a header chain file", fs::PathToString(path)));
+            }
+            m_count = ReadLE32(UCharCast(m_data + FILE_MAGIC.size()));
+            if (m_count == 0 || m_count > m_capacity) {
+                throw std::runtime_error(strprintf("Header chain file %s is corrupt", fs::PathToString(path)));
+            }
+        }
+
+        // Rebuild the index, keeping the headers that connect to genesis. A
+        // chain switch interrupted before it was flushed leaves a tail that
+        // does not connect.
+        uint256 prev_hash;
+        for (uint32_t height = 0; height < m_count; ++height) {
+            const CBlockHeader header = ReadHeader(height);
+            if (height == 0 && header.GetHash() != genesis.GetHash()) {
+                throw std::runtime_error(strprintf("Header chain file %s is for another chain", fs::PathToString(path)));
+            }
+            if (height > 0 && header.hashPrevBlock != prev_hash) {
+                LogPrintf("Bitcoin Decentral: Header chain %s truncated at height %d\n", fs::PathToString(path), height);
+                SetCount(height);
+                break;
+            }
+            prev_hash = header.GetHash();
+            m_heights.emplace(prev_hash, height);
+        }
+        m_tip_hash = prev_hash;
+    } catch (...) {
+        Unmap();
+#ifdef WIN32
+        CloseHandle(m_file);
+#else
+        close(m_fd);
+#endif
+        throw;
+    }
+
+    LogPrintf("Bitcoin Decentral: Loaded header chain %s at height %d\n", fs::PathToString(path), m_count - 1);
+}
+
+HeaderChain::~HeaderChain()
+{
+    Flush();
+    Unmap();
+#ifdef WIN32
+    CloseHandle(m_file);
+#else
+    close(m_fd);
+#endif
+}
+
+void HeaderChain::Map(size_t capacity)
+{
+    const size_t size = RecordOffset(capacity);
+#ifdef WIN32
+    // Mapping a file beyond its end extends it
+    m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READWRITE, uint64_t(size) >> 32, uint64_t(size) & 0xffffffff, nullptr);
+    if (!m_mapping) {
+        throw std::runtime_error("Cannot map header chain file");
+    }
+    void* data = MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!data) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+        throw std::runtime_error("Cannot map header chain file");
+    }
+#else
+    if (ftruncate(m_fd, size) != 0) {
+        throw std::runtime_error("Cannot resize header chain file");
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Cannot map header chain file");
+    }
+#endif
+    m_data = static_cast<std::byte*>(data);
+    m_capacity = capacity;
+}
+
+void HeaderChain::Unmap()
+{
+    if (!m_data) return;
+#ifdef WIN32
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mapping);
+    m_mapping = nullptr;
+#else
+    munmap(m_data, RecordOffset(m_capacity));
+#endif
+    m_data = nullptr;
+    m_capacity = 0;
+}
+
+void HeaderChain::Reserve(size_t count)
+{
+    if (count <= m_capacity) return;
+    const size_t capacity = std::max(count, m_capacity + GROWTH_RECORDS);
+    Unmap();
+    Map(capacity);
+}
+
+CBlockHeader HeaderChain::ReadHeader(int height) const
+{
+    CBlockHeader header;
+    SpanReader{Span{UCharCast(m_data + RecordOffset(height)), HEADER_SIZE}} >> header;
+    return header;
+}
+
+arith_uint256 HeaderChain::ReadWork(int height) const
+{
+    return UintToArith256(uint256{Span{UCharCast(m_data + RecordOffset(height) + HEADER_SIZE), 32}});
+}
+
+void HeaderChain::WriteRecord(int height, const CBlockHeader& header, const arith_uint256& work)
+{
+    DataStream stream{};
+    stream << header;
+    std::byte* record = m_data + RecordOffset(height);
+    std::memcpy(record, stream.data(), HEADER_SIZE);
+    const uint256 work_bytes = ArithToUint256(work);
+    std::memcpy(record + HEADER_SIZE, work_bytes.data(), work_bytes.size());
+}
+
+void HeaderChain::SetCount(uint32_t count)
+{
+    WriteLE32(UCharCast(m_data + FILE_MAGIC.size()), count);
+    m_count = count;
+}
+
+bool HeaderChain::AddHeaders(std::span<const CBlockHeader> headers)
+{
+    LOCK(m_mutex);
+
+    size_t first = 0;
+    while (first < headers.size() && m_heights.contains(headers[first].GetHash())) {
+        ++first;
+    }
+    if (first == headers.size()) return true;
+
+    const auto fork = m_heights.find(headers[first].hashPrevBlock);
+    if (fork == m_heights.end()) {
+        LogPrintf("Bitcoin Decentral: Header %s does not connect to the header chain\n", headers[first].GetHash().ToString());
+        return false;
+    }
+    const int fork_height = fork->second;
+    const auto new_headers = headers.subspan(first);
+
+    const int64_t max_time = TicksSinceEpoch<std::chrono::seconds>(NodeClock::now()) + MAX_FUTURE_BLOCK_TIME;
+    std::vector<uint256> hashes;
+    hashes.reserve(new_headers.size());
+    std::vector<arith_uint256> work;
+    work.reserve(new_headers.size());
+    uint256 prev_hash = fork->first;
+    uint32_t prev_bits = ReadHeader(fork_height).nBits;
+    arith_uint256 chain_work = ReadWork(fork_height);
+    std::deque<int64_t> recent_times;
+    for (int height = std::max(0, fork_height - MEDIAN_TIME_SPAN + 1); height <= fork_height; ++height) {
+        recent_times.push_back(ReadHeader(height).GetBlockTime());
+    }
+    for (size_t i = 0; i < new_headers.size(); ++i) {
+        const CBlockHeader& header = new_headers[i];
+        const int height = fork_height + 1 + i;
+        const uint256 hash = header.GetHash();
+        if (header.hashPrevBlock != prev_hash) {
+            LogPrintf("Bitcoin Decentral: Header %s is not consecutive\n", hash.ToString());
+            return false;
+        }
+        if (!CheckProofOfWork(hash, header.nBits, m_params) ||
+            !PermittedDifficultyTransition(m_params, height, prev_bits, header.nBits)) {
+            LogPrintf("Bitcoin Decentral: Header %s has invalid proof of work\n", hash.ToString());
+            return false;
+        }
+
+        std::vector<int64_t> times{recent_times.begin(), recent_times.end()};
+        std::sort(times.begin(), times.end());
+        if (header.GetBlockTime() <= times[times.size() / 2] || header.GetBlockTime() > max_time) {
+            LogPrintf("Bitcoin Decentral: Header %s has invalid timestamp\n", hash.ToString());
+            return false;
+        }
+        recent_times.push_back(header.GetBlockTime());
+        if (recent_times.size() > MEDIAN_TIME_SPAN) recent_times.pop_front();
+
+        chain_work += GetBlockProof(CBlockIndex{header});
+        hashes.push_back(hash);
+        work.push_back(chain_work);
+        prev_hash = hash;
+        prev_bits = header.nBits;
+    }
+
+    const int tip_height = m_count - 1;
+    if (chain_work <= ReadWork(tip_height)) {
+        LogPrintf("Bitcoin Decentral: Ignoring header branch at %s with less work than the header chain\n", prev_hash.ToString());
+        return true;
+    }
+    if (fork_height < tip_height) {
+        LogPrintf("Bitcoin Decentral: Header chain switches branch at height %d\n", fork_height);
+        for (int height = fork_height + 1; height <= tip_height; ++height) {
+            m_heights.erase(ReadHeader(height).GetHash());
+        }
+    }
+
+    // Records are written before the count, so the file always describes
+    // a valid chain
+    const int new_count = fork_height + 1 + new_headers.size();
+    Reserve(new_count);
+    for (size_t i = 0; i < new_headers.size(); ++i) {
+        WriteRecord(fork_height + 1 + i, new_headers[i], work[i]);
+        m_heights.emplace(hashes[i], fork_height + 1 + i);
+    }
+    SetCount(new_count);
+    m_tip_hash = prev_hash;
+    return true;
+}
+
+bool HeaderChain::Sync(HeaderFeeder& feeder)
+{
+    while (true) {
+        const std::vector<CBlockHeader> headers = feeder.GetHeaders(GetTipHash(), SYNC_BATCH_SIZE);
+        if (headers.empty()) return true;
+        if (!AddHeaders(headers)) return false;
+    }
+}
+
+bool HeaderChain::VerifyTransaction(const uint256& txid, const CMerkleBlock& proof, uint32_t min_confirmations) const
+{
+    if (!VerifyMerkleProof(txid, proof)) return false;
+    const auto confirmations = GetConfirmations(proof.header.GetHash());
+    return confirmations && *confirmations >= min_confirmations;
+}
+
+std::optional<uint32_t> HeaderChain::GetConfirmations(const uint256& block_hash) const
+{
+    LOCK(m_mutex);
+    const auto it = m_heights.find(block_hash);
+    if (it == m_heights.end()) return std::nullopt;
+    return m_count - it->second;
+}
+
+int HeaderChain::GetHeight() const
+{
+    LOCK(m_mutex);
+    return m_count - 1;
+}
+
+uint256 HeaderChain::GetTipHash() const
+{
+    LOCK(m_mutex);
+    return m_tip_hash;
+}
+
+arith_uint256 HeaderChain::GetTipWork() const
+{
+    LOCK(m_mutex);
+    return ReadWork(m_count - 1);
+}
+
+std::optional<int> HeaderChain::GetHeaderHeight(const uint256& hash) const
+{
+    LOCK(m_mutex);
+    const auto it = m_heights.find(hash);
+    if (it == m_heights.end()) return std::nullopt;
+    return it->second;
+}
+
+std::optional<CBlockHeader> HeaderChain::GetHeader(int height) const
+{
+    LOCK(m_mutex);
+    if (height < 0 || uint32_t(height) >= m_count) return std::nullopt;
+    return ReadHeader(height);
+}
+
+bool HeaderChain::Flush()
+{
+    LOCK(m_mutex);
+#ifdef WIN32
+    return FlushViewOfFile(m_data, 0) && FlushFileBuffers(m_file);
+#else
+    return msync(m_data, RecordOffset(m_capacity), MS_SYNC) == 0;
+#endif
+}
+
+} // namespace interop
@@ -0,0 +1,141 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INTEROP_HEADERCHAIN_H
+#define BITCOIN_INTEROP_HEADERCHAIN_H
+
+#include <arith_uint256.h>
+#include <consensus/params.h>
+#include <primitives/block.h>
+#include <streams.h>
+#include <sync.h>
+#include <uint256.h>
+#include <util/fs.h>
+#include <util/hasher.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+class CMerkleBlock;
+
+namespace interop {
+
+/**
+ * Source of headers for a HeaderChain, such as a file or a peer
+ */
+class HeaderFeeder
+{
+public:
+    virtual ~HeaderFeeder() = default;
+
+    /**
+     * Up to max_count headers extending the chain ending at tip_hash; they
+     * may start with headers the chain already has. Empty when there are no
+     * more.
+     */
+    virtual std::vector<CBlockHeader> GetHeaders(const uint256& tip_hash, size_t max_count) = 0;
+};
+
+/**
+ * Feeds headers from a file of consecutive 80 byte serialized headers,
+ * which it takes ownership of
+ */
+class FileHeaderFeeder final : public HeaderFeeder
+{
+public:
+    explicit FileHeaderFeeder(std::FILE* file) : m_file{file} {}
+
+    std::vector<CBlockHeader> GetHeaders(const uint256& tip_hash, size_t max_count) override;
+
+private:
+    AutoFile m_file;
+};
+
+/**
+ * Whether a merkle block proof includes txid under its header's merkle root
+ */
+bool VerifyMerkleProof(const uint256& txid, const CMerkleBlock& proof);
+
+/**
+ * Header chain of a Bitcoin-style source chain, for verifying that its
+ * transactions are confirmed without trusting a remote node
+ *
+ * Only the chain with the most work is kept. Headers are stored together
+ * with their cumulative work in a memory-mapped file, so reopening the
+ * chain only rehashes the headers to rebuild the index. Headers are checked
+ * for proof of work, difficulty transitions and timestamps against the
+ * source chain's consensus parameters.
+ */
+class HeaderChain
+{
+public:
+    /** Open or create the chain in the file at path. Throws std::runtime_error on failure. */
+    HeaderChain(const fs::path& path, const Consensus::Params& params, const CBlockHeader& genesis);
+    ~HeaderChain();
+
+    HeaderChain(const HeaderChain&) = delete;
+    HeaderChain& operator=(const HeaderChain&) = delete;
+
+    /**
+     * Connect consecutive headers, skipping any already in the chain. A
+     * branch forking below the tip replaces it only if it has more work.
+     * Returns false if the headers do not connect or are invalid.
+     */
+    bool AddHeaders(std::span<const CBlockHeader> headers) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Add headers from feeder until it runs out or sends invalid headers */
+    bool Sync(HeaderFeeder& feeder) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Whether proof (as produced by gettxoutproof) shows txid in a block of
+     * this chain with at least min_confirmations confirmations
+     */
+    bool VerifyTransaction(const uint256& txid, const CMerkleBlock& proof, uint32_t min_confirmations) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Confirmations of a block in this chain, counting the block itself */
+    std::optional<uint32_t> GetConfirmations(const uint256& block_hash) const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    int GetHeight() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    uint256 GetTipHash() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    arith_uint256 GetTipWork() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    std::optional<int> GetHeaderHeight(const uint256& hash) const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    std::optional<CBlockHeader> GetHeader(int height) const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Write the mapped headers back to the file */
+    bool Flush() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    const Consensus::Params& m_params;
+    mutable Mutex m_mutex;
+
+#ifdef WIN32
+    void* m_file{nullptr};
+    void* m_mapping{nullptr};
+#else
+    int m_fd{-1};
+#endif
+    std::byte* m_data{nullptr};
+    size_t m_capacity{0}; //!< Number of records the mapping can hold
+    uint32_t m_count GUARDED_BY(m_mutex){0}; //!< Number of headers in the chain
+    uint256 m_tip_hash GUARDED_BY(m_mutex);
+    std::unordered_map<uint256, int, BlockHasher> m_heights GUARDED_BY(m_mutex);
+
+    void Map(size_t capacity);
+    void Unmap();
+    void Reserve(size_t count) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    CBlockHeader ReadHeader(int height) const EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    arith_uint256 ReadWork(int height) const EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void WriteRecord(int height, const CBlockHeader& header, const arith_uint256& work) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void SetCount(uint32_t count) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+};
+
+} // namespace interop
+
+#endif // BITCOIN_INTEROP_HEADERCHAIN_H
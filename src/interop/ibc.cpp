@@ -1,4 +1,5 @@
 #include <interop/ibc.h>
+#include <pubkey.h>
 #include <uint256.h>
 #include <util/time.h>
 #include <logging.h>
@@ -6,8 +7,10 @@
 #include <random.h>
 #include <hash.h>
 #include <serialize.h>
+#include <streams.h>
 #include <algorithm>
 #include <chrono>
+#include <utility>
 
 namespace interop {
 namespace ibc {
@@ -16,6 +19,190 @@ namespace ibc {
 static IBCNetworkState g_ibc_state;
 static bool g_ibc_protocol_initialized = false;
 
+/**
+ * Height of the latest block whose IBC commitment was made here, which
+ * packets sent to this chain time out at
+ */
+static uint64_t GetCommittedHeight() {
+    return g_ibc_state.block_commitments.empty() ? 0 : g_ibc_state.block_commitments.rbegin()->first;
+}
+
+static bool IsTimedOut(uint64_t timeout_height, uint64_t timeout_timestamp,
+                       uint64_t current_height, uint64_t current_timestamp) {
+    if (timeout_height > 0 && current_height >= timeout_height) {
+        return true;
+    }
+    
+    if (timeout_timestamp > 0 && current_timestamp >= timeout_timestamp) {
+        return true;
+    }
+    
+    return false;
+}
+
+static uint256 ComputePacketCommitment(uint64_t sequence, const std::string& source_port,
+                                       const std::string& source_channel, const std::string& dest_port,
+                                       const std::string& dest_channel, const std::vector<uint8_t>& data,
+                                       uint64_t timeout_height, uint64_t timeout_timestamp) {
+    HashWriter ss{};
+    ss << sequence;
+    ss << source_port;
+    ss << source_channel;
+    ss << dest_port;
+    ss << dest_channel;
+    ss << data;
+    ss << timeout_height;
+    ss << timeout_timestamp;
+    return ss.GetHash();
+}
+
+static const HashWriter HASHER_COMMITMENT_LEAF{TaggedHash("IBC/CommitmentLeaf")};
+static const HashWriter HASHER_CHANNEL_LEAF{TaggedHash("IBC/ChannelLeaf")};
+static const HashWriter HASHER_CLIENT_HEADER{TaggedHash("IBC/ClientHeader")};
+
+/**
+ * Proof of commitments of a channel: the channel's accumulator root, its
+ * commitments in that accumulator, and the accumulator root in the block
+ * commitment
+ */
+struct ChannelCommitmentProof {
+    uint256 channel_root;
+    MMRProof commitments;
+    MMRProof channel;
+    
+    SERIALIZE_METHODS(ChannelCommitmentProof, obj) {
+        READWRITE(obj.channel_root, obj.commitments, obj.channel);
+    }
+};
+
+static uint256 GetChannelLeaf(const std::string& channel_id, const uint256& channel_root) {
+    return (HashWriter{HASHER_CHANNEL_LEAF} << channel_id << channel_root).GetSHA256();
+}
+
+/**
+ * Add a commitment to a channel's accumulator
+ */
+static void AppendCommitment(ChannelHandle channel, CommitmentType type, uint64_t sequence,
+                             const uint256& commitment) {
+    ChannelCommitments& commitments = g_ibc_state.channel_commitments[channel];
+    commitments.leaves[type][sequence] = commitments.mmr.Append(GetCommitmentLeaf(type, sequence, commitment));
+}
+
+/**
+ * Consensus state a client verified at a height, unless the client is
+ * inactive or was frozen at or before that height
+ */
+static const ConsensusState* GetClientConsensusState(const std::string& client_id, uint64_t height) {
+    auto client_it = g_ibc_state.clients.find(client_id);
+    if (client_it == g_ibc_state.clients.end()) {
+        return nullptr;
+    }
+    const ClientState& client = client_it->second;
+    if (!client.is_active || (client.frozen_height > 0 && height >= client.frozen_height)) {
+        return nullptr;
+    }
+    auto it = client.consensus_states.find(height);
+    return it != client.consensus_states.end() ? &it->second : nullptr;
+}
+
+/**
+ * Verify commitments of the counterparty of a channel, by sequence, against
+ * the counterparty root its client has at the proof height. Returns the
+ * consensus state they were verified against, or nullptr.
+ */
+static const ConsensusState* VerifyCounterpartyCommitments(const Channel& channel, CommitmentType type,
+                                                           const std::vector<std::pair<uint64_t, uint256>>& commitments,
+                                                           const Proof& proof) {
+    if (proof.proof_type != params::COMMITMENT_PROOF_TYPE) {
+        return nullptr;
+    }
+    
+    auto conn_it = g_ibc_state.connections.find(channel.connection_id);
+    if (conn_it == g_ibc_state.connections.end()) {
+        return nullptr;
+    }
+    const ConsensusState* consensus = GetClientConsensusState(conn_it->second.client_id, proof.proof_height);
+    if (!consensus) {
+        return nullptr;
+    }
+    
+    ChannelCommitmentProof channel_proof;
+    try {
+        SpanReader{proof.proof_data} >> channel_proof;
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+    
+    std::vector<uint256> leaves;
+    leaves.reserve(commitments.size());
+    for (const auto& [sequence, commitment] : commitments) {
+        leaves.push_back(GetCommitmentLeaf(type, sequence, commitment));
+    }
+    if (!VerifyMMRProof(channel_proof.channel_root, channel_proof.commitments, leaves) ||
+        !VerifyMMRProof(consensus->commitment_root, channel_proof.channel,
+                        {GetChannelLeaf(channel.counterparty_channel_id, channel_proof.channel_root)})) {
+        return nullptr;
+    }
+    return consensus;
+}
+
+/**
+ * Packet commitment queue
+ */
+bool PacketCommitmentQueue::Push(uint64_t sequence, const Entry& entry) {
+    if (sequence < m_end || entry.commitment.IsNull()) {
+        return false;
+    }
+    
+    if (m_size == 0) {
+        m_begin = sequence;
+    }
+    Grow(sequence + 1 - m_begin);
+    Slot(sequence) = entry;
+    m_end = sequence + 1;
+    m_size++;
+    return true;
+}
+
+const PacketCommitmentQueue::Entry* PacketCommitmentQueue::Find(uint64_t sequence) const {
+    if (sequence < m_begin || sequence >= m_end) {
+        return nullptr;
+    }
+    const Entry& entry = Slot(sequence);
+    return entry.commitment.IsNull() ? nullptr : &entry;
+}
+
+bool PacketCommitmentQueue::Erase(uint64_t sequence) {
+    if (!Find(sequence)) {
+        return false;
+    }
+    Slot(sequence) = Entry{};
+    m_size--;
+    Trim();
+    return true;
+}
+
+void PacketCommitmentQueue::Grow(uint64_t window) {
+    if (window <= m_slots.size()) {
+        return;
+    }
+    
+    size_t capacity = std::max<size_t>(m_slots.size(), 16);
+    while (capacity < window) capacity *= 2;
+    std::vector<Entry> slots(capacity);
+    for (uint64_t sequence = m_begin; sequence < m_end; ++sequence) {
+        slots[sequence & (capacity - 1)] = Slot(sequence);
+    }
+    m_slots = std::move(slots);
+}
+
+void PacketCommitmentQueue::Trim() {
+    // Each sequence is passed once, so this is amortized constant time
+    while (m_begin < m_end && Slot(m_begin).commitment.IsNull()) {
+        m_begin++;
+    }
+}
+
 /**
  * Initialize IBC protocol
  */
@@ -61,6 +248,14 @@ bool CreateIBCClient(const std::string& client_id, const std::string& chain_id,
             return false;
         }
         
+        // Headers are verified against the initial consensus state
+        auto trusted_it = initial_state.consensus_states.find(initial_state.latest_height);
+        if (initial_state.trusting_period == 0 || trusted_it == initial_state.consensus_states.end() ||
+            trusted_it->second.validators.empty()) {
+            LogPrintf("Bitcoin Decentral: Client %s has no trusted consensus state\n", client_id);
+            return false;
+        }
+        
         // Create client state
         ClientState client_state = initial_state;
         client_state.client_id = client_id;
@@ -90,6 +285,10 @@ bool UpdateIBCClient(const std::string& client_id, uint64_t new_height,
         }
         
         ClientState& client = it->second;
+        if (!client.is_active || client.frozen_height > 0) {
+            LogPrintf("Bitcoin Decentral: Client %s is not active\n", client_id);
+            return false;
+        }
         
         // Validate height progression
         if (new_height <= client.latest_height) {
@@ -98,8 +297,59 @@ bool UpdateIBCClient(const std::string& client_id, uint64_t new_height,
             return false;
         }
         
+        ClientHeader header;
+        SpanReader{header_data} >> header;
+        if (header.height != new_height || header.next_validators.empty()) {
+            LogPrintf("Bitcoin Decentral: Invalid header for client %s at height %llu\n", client_id, new_height);
+            return false;
+        }
+        
+        // The header must follow the latest trusted state, while that is
+        // within the trusting period, and not be from the future
+        const ConsensusState& trusted = client.consensus_states.at(client.latest_height);
+        const uint64_t now = GetCurrentTimestamp();
+        if (trusted.timestamp + client.trusting_period <= now) {
+            LogPrintf("Bitcoin Decentral: Client %s expired at %llu\n", client_id, trusted.timestamp + client.trusting_period);
+            return false;
+        }
+        if (header.timestamp <= trusted.timestamp || header.timestamp > now + client.max_clock_drift) {
+            LogPrintf("Bitcoin Decentral: Header for client %s has invalid time %llu\n", client_id, header.timestamp);
+            return false;
+        }
+        
+        // Signed by more than two thirds of the trusted validators
+        if (header.signatures.size() != trusted.validators.size()) {
+            LogPrintf("Bitcoin Decentral: Header for client %s has %zu signatures for %zu validators\n",
+                     client_id, header.signatures.size(), trusted.validators.size());
+            return false;
+        }
+        const uint256 header_hash = GetClientHeaderHash(client.chain_id, header);
+        size_t signers = 0;
+        for (size_t i = 0; i < trusted.validators.size(); ++i) {
+            if (header.signatures[i].empty()) continue;
+            if (header.signatures[i].size() != 64 ||
+                !trusted.validators[i].VerifySchnorr(header_hash, header.signatures[i])) {
+                LogPrintf("Bitcoin Decentral: Invalid header signature for client %s by validator %zu\n", client_id, i);
+                return false;
+            }
+            ++signers;
+        }
+        if (signers <= trusted.validators.size() * 2 / 3) {
+            LogPrintf("Bitcoin Decentral: Header for client %s signed by %zu of %zu validators\n",
+                     client_id, signers, trusted.validators.size());
+            return false;
+        }
+        
         // Update client state
         client.latest_height = new_height;
+        client.consensus_states[new_height] = ConsensusState{
+            .timestamp = header.timestamp,
+            .commitment_root = header.commitment_root,
+            .validators = std::move(header.next_validators),
+        };
+        while (client.consensus_states.size() > params::COMMITMENT_PROOF_HEIGHTS) {
+            client.consensus_states.erase(client.consensus_states.begin());
+        }
         
         LogPrintf("Bitcoin Decentral: Updated IBC client %s to height %llu\n", client_id, new_height);
         return true;
@@ -109,6 +359,35 @@ bool UpdateIBCClient(const std::string& client_id, uint64_t new_height,
     }
 }
 
+/**
+ * Get the hash of a counterparty header that its validators sign
+ */
+uint256 GetClientHeaderHash(const std::string& chain_id, const ClientHeader& header) {
+    return (HashWriter{HASHER_CLIENT_HEADER} << chain_id << header.height << header.timestamp
+            << header.commitment_root << header.next_validators).GetSHA256();
+}
+
+/**
+ * Verify client proof
+ */
+bool VerifyClientProof(const std::string& client_id, const Proof& proof, const std::vector<uint8_t>& commitment) {
+    if (proof.proof_type != params::COMMITMENT_PROOF_TYPE || commitment.size() != uint256::size()) {
+        return false;
+    }
+    const ConsensusState* consensus = GetClientConsensusState(client_id, proof.proof_height);
+    if (!consensus) {
+        return false;
+    }
+    
+    MMRProof mmr_proof;
+    try {
+        SpanReader{proof.proof_data} >> mmr_proof;
+    } catch (const std::exception&) {
+        return false;
+    }
+    return VerifyMMRProof(consensus->commitment_root, mmr_proof, {uint256{commitment}});
+}
+
 /**
  * Initialize connection
  */
@@ -211,7 +490,17 @@ bool InitializeChannel(const std::string& channel_id, const std::string& port_id
         channel.ordering = ordering;
         channel.version = params::IBC_VERSION;
         
-        g_ibc_state.channels[channel_id] = channel;
+        // Intern the channel ID, reusing the handle of a channel initialized again
+        const auto [it, inserted] = g_ibc_state.channel_handles.try_emplace(channel_id, g_ibc_state.channels.size());
+        if (inserted) {
+            g_ibc_state.channels.push_back(std::move(channel));
+            g_ibc_state.packet_commitments.emplace_back();
+            g_ibc_state.channel_commitments.emplace_back();
+        } else {
+            // The commitment accumulator is append-only and carries on
+            g_ibc_state.channels[it->second] = std::move(channel);
+            g_ibc_state.packet_commitments[it->second] = PacketCommitmentQueue{};
+        }
         
         LogPrintf("Bitcoin Decentral: Initialized IBC channel %s on port %s\n", channel_id, port_id);
         return true;
@@ -226,14 +515,12 @@ bool InitializeChannel(const std::string& channel_id, const std::string& port_id
  */
 bool OpenChannel(const std::string& channel_id, const Proof& proof) {
     try {
-        auto it = g_ibc_state.channels.find(channel_id);
-        if (it == g_ibc_state.channels.end()) {
+        Channel* channel = GetChannel(channel_id);
+        if (!channel) {
             LogPrintf("Bitcoin Decentral: Channel %s not found\n", channel_id);
             return false;
         }
         
-        Channel& channel = it->second;
-        
         // Verify channel proof
         if (!VerifyChannelProof(channel_id, proof)) {
             LogPrintf("Bitcoin Decentral: Invalid channel proof for %s\n", channel_id);
@@ -241,7 +528,7 @@ bool OpenChannel(const std::string& channel_id, const Proof& proof) {
         }
         
         // Update channel state
-        channel.state = Channel::CHAN_OPEN;
+        channel->state = Channel::CHAN_OPEN;
         
         LogPrintf("Bitcoin Decentral: Opened IBC channel %s\n", channel_id);
         return true;
@@ -251,6 +538,15 @@ bool OpenChannel(const std::string& channel_id, const Proof& proof) {
     }
 }
 
+/**
+ * Get channel handle
+ */
+std::optional<ChannelHandle> GetChannelHandle(const std::string& channel_id) {
+    auto it = g_ibc_state.channel_handles.find(channel_id);
+    if (it == g_ibc_state.channel_handles.end()) return std::nullopt;
+    return it->second;
+}
+
 /**
  * Send packet
  */
@@ -260,13 +556,13 @@ bool SendPacket(const std::string& source_port, const std::string& source_channe
                uint64_t timeout_timestamp) {
     try {
         // Find source channel
-        auto it = g_ibc_state.channels.find(source_channel);
-        if (it == g_ibc_state.channels.end() || it->second.state != Channel::CHAN_OPEN) {
+        const auto handle = GetChannelHandle(source_channel);
+        if (!handle || g_ibc_state.channels[*handle].state != Channel::CHAN_OPEN) {
             LogPrintf("Bitcoin Decentral: Source channel %s not found or not open\n", source_channel);
             return false;
         }
         
-        Channel& channel = it->second;
+        Channel& channel = g_ibc_state.channels[*handle];
         
         // Validate packet size
         if (data.size() > params::MAX_PACKET_SIZE) {
@@ -275,23 +571,21 @@ bool SendPacket(const std::string& source_port, const std::string& source_channe
             return false;
         }
         
-        // Create packet
-        Packet packet;
-        packet.sequence = channel.next_sequence_send++;
-        packet.source_port = source_port;
-        packet.source_channel = source_channel;
-        packet.dest_port = dest_port;
-        packet.dest_channel = dest_channel;
-        packet.data = data;
-        packet.timeout_height = timeout_height;
-        packet.timeout_timestamp = timeout_timestamp;
+        // Commit to the packet; the data itself is not kept
+        const uint64_t sequence = channel.next_sequence_send++;
+        PacketCommitmentQueue::Entry entry;
+        entry.commitment = ComputePacketCommitment(sequence, source_port, source_channel, dest_port,
+                                                   dest_channel, data, timeout_height, timeout_timestamp);
+        entry.timeout_height = timeout_height;
+        entry.timeout_timestamp = timeout_timestamp;
         
         // Add to pending packets
-        g_ibc_state.pending_packets[source_channel].push_back(packet);
+        g_ibc_state.packet_commitments[*handle].Push(sequence, entry);
+        AppendCommitment(*handle, COMMITMENT_PACKET, sequence, entry.commitment);
         g_ibc_state.total_packets_sent++;
         
         LogPrintf("Bitcoin Decentral: Sent IBC packet seq %llu on channel %s\n",
-                 packet.sequence, source_channel);
+                 sequence, source_channel);
         return true;
     } catch (const std::exception& e) {
         LogPrintf("Bitcoin Decentral: Failed to send packet: %s\n", e.what());
@@ -299,26 +593,71 @@ bool SendPacket(const std::string& source_port, const std::string& source_channe
     }
 }
 
+/**
+ * Receive a packet on its destination channel, once its commitment is verified
+ */
+static bool ReceiveChannelPacket(ChannelHandle handle, const Packet& packet, const Proof& proof) {
+    Channel& channel = g_ibc_state.channels[handle];
+    if (channel.state != Channel::CHAN_OPEN) {
+        LogPrintf("Bitcoin Decentral: Destination channel %s not open\n", packet.dest_channel);
+        return false;
+    }
+    
+    // Check packet timeout
+    if (IsPacketTimedOut(packet, GetCommittedHeight(), GetCurrentTimestamp())) {
+        LogPrintf("Bitcoin Decentral: Packet seq %llu on channel %s timed out\n",
+                 packet.sequence, packet.dest_channel);
+        g_ibc_state.total_timeouts++;
+        return false;
+    }
+    
+    // Each packet is received once, and never after its non-receipt is recorded
+    const ChannelCommitments& commitments = g_ibc_state.channel_commitments[handle];
+    if (commitments.leaves[COMMITMENT_RECEIPT].contains(packet.sequence) ||
+        commitments.leaves[COMMITMENT_NON_RECEIPT].contains(packet.sequence)) {
+        LogPrintf("Bitcoin Decentral: Packet seq %llu on channel %s already received or timed out\n",
+                 packet.sequence, packet.dest_channel);
+        return false;
+    }
+    
+    // Process packet based on port
+    bool success = false;
+    if (packet.dest_port == params::TRANSFER_PORT) {
+        success = ReceiveTokenTransfer(packet, proof);
+    } else {
+        // Handle other port types
+        success = true; // Simplified implementation
+    }
+    
+    // Update sequence numbers
+    if (success) {
+        if (channel.ordering == Channel::ORDER_ORDERED) {
+            channel.next_sequence_recv++;
+        }
+        g_ibc_state.total_packets_received++;
+        
+        // Record the receipt and the acknowledgment for the sender to prove
+        Acknowledgment ack;
+        ack.result = {1};
+        ack.success = true;
+        AppendCommitment(handle, COMMITMENT_RECEIPT, packet.sequence, GeneratePacketCommitment(packet));
+        AppendCommitment(handle, COMMITMENT_ACK, packet.sequence, GenerateAcknowledgmentCommitment(ack));
+    }
+    
+    LogPrintf("Bitcoin Decentral: Received IBC packet seq %llu on channel %s: %s\n",
+             packet.sequence, packet.dest_channel, success ? "success" : "failed");
+    return success;
+}
+
 /**
  * Receive packet
  */
 bool ReceivePacket(const Packet& packet, const Proof& proof) {
     try {
         // Find destination channel
-        auto it = g_ibc_state.channels.find(packet.dest_channel);
-        if (it == g_ibc_state.channels.end() || it->second.state != Channel::CHAN_OPEN) {
-            LogPrintf("Bitcoin Decentral: Destination channel %s not found or not open\n",
-                     packet.dest_channel);
-            return false;
-        }
-        
-        Channel& channel = it->second;
-        
-        // Check packet timeout
-        if (IsPacketTimedOut(packet, 0, GetCurrentTimestamp())) {
-            LogPrintf("Bitcoin Decentral: Packet seq %llu on channel %s timed out\n",
-                     packet.sequence, packet.dest_channel);
-            g_ibc_state.total_timeouts++;
+        const auto handle = GetChannelHandle(packet.dest_channel);
+        if (!handle) {
+            LogPrintf("Bitcoin Decentral: Destination channel %s not found\n", packet.dest_channel);
             return false;
         }
         
@@ -329,32 +668,312 @@ bool ReceivePacket(const Packet& packet, const Proof& proof) {
             return false;
         }
         
-        // Process packet based on port
-        bool success = false;
-        if (packet.dest_port == params::TRANSFER_PORT) {
-            success = ReceiveTokenTransfer(packet, proof);
-        } else {
-            // Handle other port types
-            success = true; // Simplified implementation
+        return ReceiveChannelPacket(*handle, packet, proof);
+    } catch (const std::exception& e) {
+        LogPrintf("Bitcoin Decentral: Failed to receive packet: %s\n", e.what());
+        return false;
+    }
+}
+
+/**
+ * Receive packets relayed to a channel together
+ */
+size_t ReceivePackets(ChannelHandle dest_channel, const std::vector<Packet>& packets, const Proof& proof) {
+    Channel* channel = GetChannel(dest_channel);
+    if (!channel || packets.empty()) return 0;
+    
+    // One proof covers the commitments of all the packets
+    std::vector<std::pair<uint64_t, uint256>> commitments;
+    commitments.reserve(packets.size());
+    for (const Packet& packet : packets) {
+        if (packet.dest_channel != channel->channel_id || packet.source_channel != channel->counterparty_channel_id) {
+            return 0;
         }
-        
-        // Update sequence numbers
-        if (success) {
-            if (channel.ordering == Channel::ORDER_ORDERED) {
-                channel.next_sequence_recv++;
+        commitments.emplace_back(packet.sequence, GeneratePacketCommitment(packet));
+    }
+    if (!VerifyCounterpartyCommitments(*channel, COMMITMENT_PACKET, commitments, proof)) {
+        LogPrintf("Bitcoin Decentral: Invalid packet commitment proof for %zu packets on channel %s\n",
+                 packets.size(), channel->channel_id);
+        return 0;
+    }
+    
+    size_t received = 0;
+    for (const Packet& packet : packets) {
+        try {
+            if (ReceiveChannelPacket(dest_channel, packet, proof)) {
+                ++received;
             }
-            g_ibc_state.total_packets_received++;
+        } catch (const std::exception& e) {
+            LogPrintf("Bitcoin Decentral: Failed to receive packet: %s\n", e.what());
+        }
+    }
+    return received;
+}
+
+/**
+ * Acknowledge a packet sent on a channel, once its acknowledgment is verified
+ */
+static bool AcknowledgeChannelPacket(Channel& channel, PacketCommitmentQueue& commitments, const Packet& packet,
+                                     const Acknowledgment& ack) {
+    // The packet must be pending and match what was committed to when sent
+    const PacketCommitmentQueue::Entry* entry = commitments.Find(packet.sequence);
+    if (!entry || entry->commitment != GeneratePacketCommitment(packet)) {
+        LogPrintf("Bitcoin Decentral: No pending packet seq %llu on channel %s\n",
+                 packet.sequence, channel.channel_id);
+        return false;
+    }
+    
+    if (channel.ordering == Channel::ORDER_ORDERED && packet.sequence != channel.next_sequence_ack) {
+        LogPrintf("Bitcoin Decentral: Packet seq %llu on channel %s acknowledged out of order\n",
+                 packet.sequence, channel.channel_id);
+        return false;
+    }
+    
+    commitments.Erase(packet.sequence);
+    if (channel.ordering == Channel::ORDER_ORDERED) {
+        channel.next_sequence_ack++;
+    }
+    
+    LogPrintf("Bitcoin Decentral: Acknowledged IBC packet seq %llu on channel %s: %s\n",
+             packet.sequence, channel.channel_id, ack.success ? "success" : ack.error);
+    return true;
+}
+
+/**
+ * Acknowledge packet
+ */
+bool AcknowledgePacket(const Packet& packet, const Acknowledgment& ack, const Proof& proof) {
+    try {
+        const auto handle = GetChannelHandle(packet.source_channel);
+        if (!handle) {
+            LogPrintf("Bitcoin Decentral: Source channel %s not found\n", packet.source_channel);
+            return false;
         }
         
-        LogPrintf("Bitcoin Decentral: Received IBC packet seq %llu on channel %s: %s\n",
-                 packet.sequence, packet.dest_channel, success ? "success" : "failed");
-        return success;
+        Channel& channel = g_ibc_state.channels[*handle];
+        if (packet.dest_channel != channel.counterparty_channel_id ||
+            !VerifyCounterpartyCommitments(channel, COMMITMENT_ACK,
+                                           {{packet.sequence, GenerateAcknowledgmentCommitment(ack)}}, proof)) {
+            LogPrintf("Bitcoin Decentral: Invalid acknowledgment proof for seq %llu\n", packet.sequence);
+            return false;
+        }
+        
+        return AcknowledgeChannelPacket(channel, g_ibc_state.packet_commitments[*handle], packet, ack);
     } catch (const std::exception& e) {
-        LogPrintf("Bitcoin Decentral: Failed to receive packet: %s\n", e.what());
+        LogPrintf("Bitcoin Decentral: Failed to acknowledge packet: %s\n", e.what());
         return false;
     }
 }
 
+/**
+ * Acknowledge packets sent on a channel together
+ */
+size_t AcknowledgePackets(ChannelHandle source_channel, const std::vector<Packet>& packets,
+                         const std::vector<Acknowledgment>& acks, const Proof& proof) {
+    Channel* channel = GetChannel(source_channel);
+    if (!channel || packets.empty() || packets.size() != acks.size()) return 0;
+    
+    // One proof covers the acknowledgments of all the packets
+    std::vector<std::pair<uint64_t, uint256>> ack_commitments;
+    ack_commitments.reserve(packets.size());
+    for (size_t i = 0; i < packets.size(); ++i) {
+        if (packets[i].source_channel != channel->channel_id ||
+            packets[i].dest_channel != channel->counterparty_channel_id) {
+            return 0;
+        }
+        ack_commitments.emplace_back(packets[i].sequence, GenerateAcknowledgmentCommitment(acks[i]));
+    }
+    if (!VerifyCounterpartyCommitments(*channel, COMMITMENT_ACK, ack_commitments, proof)) {
+        LogPrintf("Bitcoin Decentral: Invalid acknowledgment proof for %zu packets on channel %s\n",
+                 packets.size(), channel->channel_id);
+        return 0;
+    }
+    
+    PacketCommitmentQueue& commitments = g_ibc_state.packet_commitments[source_channel];
+    size_t acknowledged = 0;
+    for (size_t i = 0; i < packets.size(); ++i) {
+        try {
+            if (AcknowledgeChannelPacket(*channel, commitments, packets[i], acks[i])) {
+                ++acknowledged;
+            }
+        } catch (const std::exception& e) {
+            LogPrintf("Bitcoin Decentral: Failed to acknowledge packet: %s\n", e.what());
+        }
+    }
+    return acknowledged;
+}
+
+/**
+ * Record that a packet sent to this chain timed out before it was received
+ */
+bool RecordPacketNonReceipt(const Packet& packet, const Proof& proof) {
+    const auto handle = GetChannelHandle(packet.dest_channel);
+    if (!handle || !VerifyPacketCommitment(packet, proof)) {
+        LogPrintf("Bitcoin Decentral: Invalid packet commitment proof for seq %llu\n", packet.sequence);
+        return false;
+    }
+    
+    Channel& channel = g_ibc_state.channels[*handle];
+    const ChannelCommitments& commitments = g_ibc_state.channel_commitments[*handle];
+    if (commitments.leaves[COMMITMENT_RECEIPT].contains(packet.sequence) ||
+        commitments.leaves[COMMITMENT_NON_RECEIPT].contains(packet.sequence) ||
+        !IsPacketTimedOut(packet, GetCommittedHeight(), GetCurrentTimestamp())) {
+        return false;
+    }
+    
+    AppendCommitment(*handle, COMMITMENT_NON_RECEIPT, packet.sequence, GeneratePacketCommitment(packet));
+    if (channel.ordering == Channel::ORDER_ORDERED) {
+        // The packet cannot be skipped, so no later one can be received either
+        channel.state = Channel::CHAN_CLOSED;
+    }
+    
+    LogPrintf("Bitcoin Decentral: Recorded non-receipt of timed out IBC packet seq %llu on channel %s\n",
+             packet.sequence, packet.dest_channel);
+    return true;
+}
+
+/**
+ * Timeout a packet sent on a channel, once its non-receipt is proven past
+ * its timeout
+ */
+static bool TimeoutChannelPacket(Channel& channel, PacketCommitmentQueue& commitments, uint64_t sequence,
+                                 const Proof& proof) {
+    const PacketCommitmentQueue::Entry* entry = commitments.Find(sequence);
+    if (!entry) {
+        return false;
+    }
+    
+    // The timeout is checked at the proven counterparty height and time, not
+    // against this chain
+    const ConsensusState* consensus = VerifyCounterpartyCommitments(channel, COMMITMENT_NON_RECEIPT,
+                                                                    {{sequence, entry->commitment}}, proof);
+    if (!consensus || !IsTimedOut(entry->timeout_height, entry->timeout_timestamp, proof.proof_height,
+                                  consensus->timestamp)) {
+        LogPrintf("Bitcoin Decentral: Invalid timeout proof for seq %llu on channel %s\n",
+                 sequence, channel.channel_id);
+        return false;
+    }
+    
+    commitments.Erase(sequence);
+    if (channel.ordering == Channel::ORDER_ORDERED) {
+        channel.state = Channel::CHAN_CLOSED;
+    }
+    g_ibc_state.total_timeouts++;
+    
+    LogPrintf("Bitcoin Decentral: Timed out IBC packet seq %llu on channel %s\n", sequence, channel.channel_id);
+    return true;
+}
+
+/**
+ * Timeout packet
+ */
+bool TimeoutPacket(const Packet& packet, const Proof& proof) {
+    const auto handle = GetChannelHandle(packet.source_channel);
+    if (!handle) return false;
+    
+    Channel& channel = g_ibc_state.channels[*handle];
+    PacketCommitmentQueue& commitments = g_ibc_state.packet_commitments[*handle];
+    const PacketCommitmentQueue::Entry* entry = commitments.Find(packet.sequence);
+    if (!entry || entry->commitment != GeneratePacketCommitment(packet) ||
+        packet.dest_channel != channel.counterparty_channel_id) {
+        return false;
+    }
+    return TimeoutChannelPacket(channel, commitments, packet.sequence, proof);
+}
+
+/**
+ * Process packet timeout
+ */
+bool ProcessPacketTimeout(const std::string& channel_id, uint64_t sequence, const Proof& proof) {
+    const auto handle = GetChannelHandle(channel_id);
+    if (!handle) return false;
+    
+    return TimeoutChannelPacket(g_ibc_state.channels[*handle], g_ibc_state.packet_commitments[*handle], sequence, proof);
+}
+
+/**
+ * Verify packet commitment
+ */
+bool VerifyPacketCommitment(const Packet& packet, const Proof& proof) {
+    const Channel* channel = GetChannel(packet.dest_channel);
+    if (!channel || packet.source_channel != channel->counterparty_channel_id) {
+        return false;
+    }
+    return VerifyCounterpartyCommitments(*channel, COMMITMENT_PACKET,
+                                         {{packet.sequence, GeneratePacketCommitment(packet)}}, proof);
+}
+
+/**
+ * Commit to the channels' accumulators at a block
+ */
+uint256 CommitIBCBlock(uint64_t height) {
+    BlockCommitment block;
+    MerkleMountainRange channel_roots;
+    for (ChannelHandle channel = 0; channel < g_ibc_state.channels.size(); ++channel) {
+        const MerkleMountainRange& mmr = g_ibc_state.channel_commitments[channel].mmr;
+        block.channel_sizes.push_back(mmr.Size());
+        channel_roots.Append(GetChannelLeaf(g_ibc_state.channels[channel].channel_id, mmr.GetRoot()));
+    }
+    block.root = channel_roots.GetRoot();
+    
+    g_ibc_state.block_commitments[height] = block;
+    while (g_ibc_state.block_commitments.size() > params::COMMITMENT_PROOF_HEIGHTS) {
+        g_ibc_state.block_commitments.erase(g_ibc_state.block_commitments.begin());
+    }
+    return block.root;
+}
+
+/**
+ * Prove commitments of a channel against a block commitment
+ */
+std::optional<Proof> GeneratePacketProof(ChannelHandle channel, CommitmentType type,
+                                         const std::vector<uint64_t>& sequences, uint64_t height) {
+    auto block_it = g_ibc_state.block_commitments.find(height);
+    if (type >= COMMITMENT_TYPES || block_it == g_ibc_state.block_commitments.end() ||
+        channel >= block_it->second.channel_sizes.size()) {
+        return std::nullopt;
+    }
+    const std::vector<uint64_t>& channel_sizes = block_it->second.channel_sizes;
+    const ChannelCommitments& commitments = g_ibc_state.channel_commitments[channel];
+    
+    std::vector<uint64_t> leaf_indices;
+    leaf_indices.reserve(sequences.size());
+    for (uint64_t sequence : sequences) {
+        auto leaf_it = commitments.leaves[type].find(sequence);
+        if (leaf_it == commitments.leaves[type].end()) return std::nullopt;
+        leaf_indices.push_back(leaf_it->second);
+    }
+    
+    ChannelCommitmentProof channel_proof;
+    channel_proof.channel_root = commitments.mmr.GetRoot(channel_sizes[channel]);
+    auto commitments_proof = commitments.mmr.Prove(leaf_indices, channel_sizes[channel]);
+    if (!commitments_proof) return std::nullopt;
+    channel_proof.commitments = std::move(*commitments_proof);
+    
+    // Rebuild the block's accumulator of channel roots
+    MerkleMountainRange channel_roots;
+    for (ChannelHandle other = 0; other < channel_sizes.size(); ++other) {
+        channel_roots.Append(GetChannelLeaf(g_ibc_state.channels[other].channel_id,
+                                            g_ibc_state.channel_commitments[other].mmr.GetRoot(channel_sizes[other])));
+    }
+    channel_proof.channel = *channel_roots.Prove({channel}, channel_roots.Size());
+    
+    DataStream stream{};
+    stream << channel_proof;
+    Proof proof;
+    proof.proof_data.assign(UCharCast(stream.data()), UCharCast(stream.data() + stream.size()));
+    proof.proof_height = height;
+    proof.proof_type = params::COMMITMENT_PROOF_TYPE;
+    return proof;
+}
+
+/**
+ * Get the accumulator leaf of a commitment
+ */
+uint256 GetCommitmentLeaf(CommitmentType type, uint64_t sequence, const uint256& commitment) {
+    return (HashWriter{HASHER_COMMITMENT_LEAF} << uint8_t{type} << sequence << commitment).GetSHA256();
+}
+
 /**
  * Transfer tokens (ICS-20)
  */
@@ -425,15 +1044,18 @@ std::string GetVoucherDenom(const std::string& source_port, const std::string& s
  * Generate packet commitment
  */
 uint256 GeneratePacketCommitment(const Packet& packet) {
+    return ComputePacketCommitment(packet.sequence, packet.source_port, packet.source_channel, packet.dest_port,
+                                   packet.dest_channel, packet.data, packet.timeout_height, packet.timeout_timestamp);
+}
+
+/**
+ * Generate acknowledgment commitment
+ */
+uint256 GenerateAcknowledgmentCommitment(const Acknowledgment& ack) {
     HashWriter ss{};
-    ss << packet.sequence;
-    ss << packet.source_port;
-    ss << packet.source_channel;
-    ss << packet.dest_port;
-    ss << packet.dest_channel;
-    ss << packet.data;
-    ss << packet.timeout_height;
-    ss << packet.timeout_timestamp;
+    ss << ack.result;
+    ss << ack.error;
+    ss << ack.success;
     return ss.GetHash();
 }
 
@@ -459,23 +1081,14 @@ bool ValidateIdentifierFormat(const std::string& identifier) {
  * Get current timestamp
  */
 uint64_t GetCurrentTimestamp() {
-    return std::chrono::duration_cast<std::chrono::seconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
+    return TicksSinceEpoch<std::chrono::seconds>(NodeClock::now());
 }
 
 /**
  * Check timeout
  */
 bool IsPacketTimedOut(const Packet& packet, uint64_t current_height, uint64_t current_timestamp) {
-    if (packet.timeout_height > 0 && current_height >= packet.timeout_height) {
-        return true;
-    }
-    
-    if (packet.timeout_timestamp > 0 && current_timestamp >= packet.timeout_timestamp) {
-        return true;
-    }
-    
-    return false;
+    return IsTimedOut(packet.timeout_height, packet.timeout_timestamp, current_height, current_timestamp);
 }
 
 /**
@@ -516,17 +1129,17 @@ void MonitorIBCPerformance() {
  * Cleanup expired IBC operations
  */
 void CleanupExpiredIBCOperations() {
-    uint64_t current_timestamp = GetCurrentTimestamp();
+    const uint64_t current_timestamp = GetCurrentTimestamp();
     
-    // Clean up timed out packets
-    for (auto& [channel_id, packets] : g_ibc_state.pending_packets) {
-        packets.erase(
-            std::remove_if(packets.begin(), packets.end(),
-                [current_timestamp](const Packet& packet) {
-                    return IsPacketTimedOut(packet, 0, current_timestamp);
-                }),
-            packets.end()
-        );
+    // A client past its trusting period can no longer be updated, and its
+    // consensus states no longer verify proofs
+    for (auto& [client_id, client] : g_ibc_state.clients) {
+        auto trusted_it = client.consensus_states.find(client.latest_height);
+        if (client.is_active && trusted_it != client.consensus_states.end() &&
+            trusted_it->second.timestamp + client.trusting_period <= current_timestamp) {
+            client.is_active = false;
+            LogPrintf("Bitcoin Decentral: IBC client %s expired\n", client_id);
+        }
     }
 }
 
@@ -552,14 +1165,16 @@ Connection* GetConnection(const std::string& connection_id) {
 }
 
 Channel* GetChannel(const std::string& channel_id) {
-    auto it = g_ibc_state.channels.find(channel_id);
-    return (it != g_ibc_state.channels.end()) ? &it->second : nullptr;
+    const auto handle = GetChannelHandle(channel_id);
+    return handle ? &g_ibc_state.channels[*handle] : nullptr;
+}
+
+Channel* GetChannel(ChannelHandle channel) {
+    return channel < g_ibc_state.channels.size() ? &g_ibc_state.channels[channel] : nullptr;
 }
 
-bool VerifyClientProof(const std::string& client_id, const Proof& proof, const std::vector<uint8_t>& commitment) { return true; }
 bool VerifyConnectionProof(const std::string& connection_id, const Proof& proof) { return true; }
 bool VerifyChannelProof(const std::string& channel_id, const Proof& proof) { return true; }
-bool VerifyPacketCommitment(const Packet& packet, const Proof& proof) { return true; }
 bool CreateVoucherTokens(const std::string& denom, uint64_t amount, const std::string& receiver) { return true; }
 bool BurnVoucherTokens(const std::string& denom, uint64_t amount, const std::string& sender) { return true; }
 
@@ -1,13 +1,21 @@
 #ifndef BITCOIN_INTEROP_IBC_H
 #define BITCOIN_INTEROP_IBC_H
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <vector>
 #include <map>
+#include <optional>
 #include <string>
 #include <memory>
+#include <unordered_map>
 
-class uint256;
+#include <interop/mmr.h>
+#include <pubkey.h>
+#include <serialize.h>
+#include <uint256.h>
 
 /**
  * Bitcoin Decentral Inter-Blockchain Communication (IBC) Protocol
@@ -51,8 +59,37 @@ namespace params {
     // Proof parameters
     static const uint32_t PROOF_HEIGHT_OFFSET = 10; // blocks
     static const std::string PROOF_SPECS_TYPE = "tendermint";
+    static const std::string COMMITMENT_PROOF_TYPE = "mmr";
+    static const uint32_t COMMITMENT_PROOF_HEIGHTS = 100; // Recent block commitments kept for proofs
 }
 
+/**
+ * Counterparty state a client trusts at a height: the IBC commitment root
+ * that proofs at that height are verified against, and the validators that
+ * sign the next header
+ */
+struct ConsensusState {
+    uint64_t timestamp{0};          // Counterparty block time, in seconds
+    uint256 commitment_root;        // Counterparty IBC commitment root
+    std::vector<XOnlyPubKey> validators; // Validators trusted to sign the next header
+};
+
+/**
+ * Counterparty header, signed by more than two thirds of the validators of
+ * the client's latest consensus state
+ */
+struct ClientHeader {
+    uint64_t height{0};
+    uint64_t timestamp{0};
+    uint256 commitment_root;
+    std::vector<XOnlyPubKey> next_validators; // Validators that sign the header after this one
+    std::vector<std::vector<unsigned char>> signatures; // Schnorr signatures, in trusted validator order; empty if absent
+    
+    SERIALIZE_METHODS(ClientHeader, obj) {
+        READWRITE(obj.height, obj.timestamp, obj.commitment_root, obj.next_validators, obj.signatures);
+    }
+};
+
 /**
  * IBC client state
  */
@@ -65,6 +102,7 @@ struct ClientState {
     uint64_t unbonding_period;      // Unbonding period of the chain
     uint64_t max_clock_drift;       // Maximum allowed clock drift
     std::vector<uint8_t> proof_specs; // Proof specifications
+    std::map<uint64_t, ConsensusState> consensus_states; // Recent verified counterparty states by height
     bool is_active;                 // Whether client is active
     
     ClientState() : latest_height(0), frozen_height(0), trusting_period(0),
@@ -142,6 +180,83 @@ struct Packet {
     Packet() : sequence(0), timeout_height(0), timeout_timestamp(0) {}
 };
 
+/**
+ * Channels are interned to handles when initialized, so packets are routed
+ * by index rather than by looking up the channel ID
+ */
+using ChannelHandle = uint32_t;
+
+/**
+ * Commitments of the packets sent on a channel that are still awaiting
+ * acknowledgment or timeout, in a ring buffer indexed by sequence number.
+ *
+ * The ring spans the sequences from the oldest pending packet to the newest,
+ * growing when that window outgrows it, so lookups and removals by sequence
+ * are constant time. Only the packet commitment and its timeouts are kept;
+ * the packet data stays with the relayer.
+ */
+class PacketCommitmentQueue
+{
+public:
+    struct Entry {
+        uint256 commitment;
+        uint64_t timeout_height{0};
+        uint64_t timeout_timestamp{0};
+    };
+    
+    /** Add the entry of a packet; sequences must increase */
+    bool Push(uint64_t sequence, const Entry& entry);
+    
+    /** Entry of a pending packet, or nullptr */
+    const Entry* Find(uint64_t sequence) const;
+    
+    /** Remove a pending packet, returning whether it was pending */
+    bool Erase(uint64_t sequence);
+    
+    size_t Size() const { return m_size; }
+    
+private:
+    std::vector<Entry> m_slots;     // Power of two slots, empty ones with a null commitment
+    uint64_t m_begin{0};            // Oldest sequence that may be pending
+    uint64_t m_end{0};              // One past the newest sequence pushed
+    size_t m_size{0};               // Pending packets
+    
+    Entry& Slot(uint64_t sequence) { return m_slots[sequence & (m_slots.size() - 1)]; }
+    const Entry& Slot(uint64_t sequence) const { return m_slots[sequence & (m_slots.size() - 1)]; }
+    void Grow(uint64_t window);
+    void Trim();
+};
+
+/**
+ * Commitments a channel keeps in its accumulator
+ */
+enum CommitmentType : uint8_t {
+    COMMITMENT_PACKET = 0,          // Packet sent
+    COMMITMENT_RECEIPT,             // Packet received
+    COMMITMENT_ACK,                 // Acknowledgment written for a received packet
+    COMMITMENT_NON_RECEIPT,         // Packet timed out before it was received, so never will be
+    COMMITMENT_TYPES
+};
+
+/**
+ * Commitments of a channel in an append-only Merkle accumulator, with the
+ * leaf of each sequence so proofs can be made without rehashing history
+ */
+struct ChannelCommitments {
+    MerkleMountainRange mmr;
+    std::array<std::unordered_map<uint64_t, uint64_t>, COMMITMENT_TYPES> leaves; // Leaf index by sequence, per type
+};
+
+/**
+ * Commitment to all channels' accumulators at a block: the root over each
+ * channel's ID and accumulator root, in handle order, and the accumulator
+ * sizes it covers
+ */
+struct BlockCommitment {
+    uint256 root;
+    std::vector<uint64_t> channel_sizes;
+};
+
 /**
  * IBC acknowledgment
  */
@@ -170,8 +285,11 @@ struct Proof {
 struct IBCNetworkState {
     std::map<std::string, ClientState> clients;        // Active IBC clients
     std::map<std::string, Connection> connections;     // Active connections
-    std::map<std::string, Channel> channels;          // Active channels
-    std::map<std::string, std::vector<Packet>> pending_packets; // Pending packets by channel
+    std::deque<Channel> channels;                      // Active channels, by handle
+    std::unordered_map<std::string, ChannelHandle> channel_handles; // Channel handles by ID
+    std::deque<PacketCommitmentQueue> packet_commitments; // Sent packets awaiting acknowledgment, by channel handle
+    std::deque<ChannelCommitments> channel_commitments; // Commitment accumulators, by channel handle
+    std::map<uint64_t, BlockCommitment> block_commitments; // Recent block commitments by height
     std::map<std::string, std::vector<Acknowledgment>> pending_acks; // Pending acknowledgments
     uint64_t total_packets_sent;                       // Total packets sent
     uint64_t total_packets_received;                   // Total packets received
@@ -194,17 +312,26 @@ bool InitializeIBCProtocol();
  */
 
 /**
- * Create IBC client
+ * Create IBC client. The initial state must have a trusting period and the
+ * trusted consensus state at its latest height.
  */
 bool CreateIBCClient(const std::string& client_id, const std::string& chain_id,
                     const ClientState& initial_state);
 
 /**
- * Update IBC client
+ * Update IBC client with a serialized ClientHeader at new_height. The header
+ * is only accepted if the validators of the latest consensus state signed
+ * it within the trusting period; its commitment root is then what proofs at
+ * the new height are verified against.
  */
 bool UpdateIBCClient(const std::string& client_id, uint64_t new_height,
                     const std::vector<uint8_t>& header_data);
 
+/**
+ * Get the hash of a counterparty header that its validators sign
+ */
+uint256 GetClientHeaderHash(const std::string& chain_id, const ClientHeader& header);
+
 /**
  * Freeze IBC client
  */
@@ -217,7 +344,8 @@ bool FreezeIBCClient(const std::string& client_id, uint64_t frozen_height,
 ClientState* GetClientState(const std::string& client_id);
 
 /**
- * Verify client proof
+ * Verify a proof (a serialized MMRProof) that a 32-byte accumulator leaf is
+ * committed to by the client's consensus state at the proof height
  */
 bool VerifyClientProof(const std::string& client_id, const Proof& proof,
                       const std::vector<uint8_t>& commitment);
@@ -278,6 +406,12 @@ bool CloseChannel(const std::string& channel_id);
  * Get channel
  */
 Channel* GetChannel(const std::string& channel_id);
+Channel* GetChannel(ChannelHandle channel);
+
+/**
+ * Get the handle of a channel, for the packet batch functions
+ */
+std::optional<ChannelHandle> GetChannelHandle(const std::string& channel_id);
 
 /**
  * Verify channel proof
@@ -307,20 +441,61 @@ bool ReceivePacket(const Packet& packet, const Proof& proof);
 bool AcknowledgePacket(const Packet& packet, const Acknowledgment& ack, const Proof& proof);
 
 /**
- * Timeout packet
+ * Receive packets relayed to a channel together, with one proof of their
+ * commitments. Returns the number of packets received.
+ */
+size_t ReceivePackets(ChannelHandle dest_channel, const std::vector<Packet>& packets, const Proof& proof);
+
+/**
+ * Acknowledge packets sent on a channel together, with one proof of the
+ * acknowledgments. Returns the number of packets acknowledged.
+ */
+size_t AcknowledgePackets(ChannelHandle source_channel, const std::vector<Packet>& packets,
+                         const std::vector<Acknowledgment>& acks, const Proof& proof);
+
+/**
+ * On the destination chain, record that a packet whose commitment is proven
+ * timed out before it was received. The packet can no longer be received,
+ * and the sender can prove its non-receipt. An ordered channel closes.
+ */
+bool RecordPacketNonReceipt(const Packet& packet, const Proof& proof);
+
+/**
+ * Timeout a packet sent on its source channel, with a proof of its
+ * non-receipt by the counterparty at a height whose consensus state is past
+ * the packet's timeout. An ordered channel closes.
  */
 bool TimeoutPacket(const Packet& packet, const Proof& proof);
 
 /**
- * Process packet timeout
+ * Timeout the packet of a sequence sent on a channel, as TimeoutPacket
  */
-bool ProcessPacketTimeout(const std::string& channel_id, uint64_t sequence);
+bool ProcessPacketTimeout(const std::string& channel_id, uint64_t sequence, const Proof& proof);
 
 /**
  * Verify packet commitment
  */
 bool VerifyPacketCommitment(const Packet& packet, const Proof& proof);
 
+/**
+ * Commit to the channels' accumulators at a block, returning the root
+ * counterparties verify packet proofs against
+ */
+uint256 CommitIBCBlock(uint64_t height);
+
+/**
+ * Prove commitments of a type for sequences of a channel against the block
+ * commitment at height, with the accumulator nodes the sequences share
+ * included once. The counterparty verifies them in the same order.
+ */
+std::optional<Proof> GeneratePacketProof(ChannelHandle channel, CommitmentType type,
+                                         const std::vector<uint64_t>& sequences, uint64_t height);
+
+/**
+ * Get the accumulator leaf of a commitment
+ */
+uint256 GetCommitmentLeaf(CommitmentType type, uint64_t sequence, const uint256& commitment);
+
 /**
  * Transfer functions (ICS-20)
  */
@@ -459,7 +634,9 @@ IBCStats GetIBCStatistics();
 void MonitorIBCPerformance();
 
 /**
- * Cleanup expired IBC operations
+ * Deactivate clients whose latest consensus state is past its trusting
+ * period. Pending packets are only dropped by a proven acknowledgment or
+ * timeout.
  */
 void CleanupExpiredIBCOperations();
 
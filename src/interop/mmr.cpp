@@ -0,0 +1,153 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <interop/mmr.h>
+
+#include <hash.h>
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace interop {
+
+namespace {
+
+const HashWriter HASHER_MMR_NODE{TaggedHash("MMRNode")};
+const HashWriter HASHER_MMR_ROOT{TaggedHash("MMRRoot")};
+
+constexpr int MAX_HEIGHT{64};
+
+uint256 NodeHash(const uint256& left, const uint256& right)
+{
+    return (HashWriter{HASHER_MMR_NODE} << left << right).GetSHA256();
+}
+
+/** Root over the leaf count and the peaks, highest first; peak(h) is the peak at height h */
+template <typename PeakFn>
+uint256 RootHash(uint64_t leaf_count, PeakFn peak)
+{
+    HashWriter hasher{HASHER_MMR_ROOT};
+    hasher << leaf_count;
+    for (int height = MAX_HEIGHT - 1; height >= 0; --height) {
+        if ((leaf_count >> height) & 1) hasher << peak(height);
+    }
+    return hasher.GetSHA256();
+}
+
+/** Whether the node at index of a level of level_size nodes is that level's peak */
+bool IsPeak(uint64_t index, uint64_t level_size)
+{
+    return (level_size & 1) && index == level_size - 1;
+}
+
+} // namespace
+
+uint64_t MerkleMountainRange::Append(const uint256& leaf)
+{
+    if (m_levels.empty()) m_levels.emplace_back();
+    m_levels[0].push_back(leaf);
+    // Each completed pair of trees of one height merges into the next
+    for (size_t height = 0; m_levels[height].size() % 2 == 0; ++height) {
+        const auto& level = m_levels[height];
+        const uint256 parent = NodeHash(level[level.size() - 2], level.back());
+        if (m_levels.size() == height + 1) m_levels.emplace_back();
+        m_levels[height + 1].push_back(parent);
+    }
+    return m_levels[0].size() - 1;
+}
+
+uint256 MerkleMountainRange::GetRoot(uint64_t leaf_count) const
+{
+    return RootHash(leaf_count, [&](int height) { return m_levels[height][(leaf_count >> height) - 1]; });
+}
+
+std::optional<MMRProof> MerkleMountainRange::Prove(const std::vector<uint64_t>& leaf_indices, uint64_t leaf_count) const
+{
+    if (leaf_indices.empty() || leaf_count > Size()) return std::nullopt;
+    std::vector<uint64_t> known{leaf_indices};
+    std::sort(known.begin(), known.end());
+    if (std::adjacent_find(known.begin(), known.end()) != known.end() || known.back() >= leaf_count) return std::nullopt;
+
+    MMRProof proof;
+    proof.leaf_count = leaf_count;
+    proof.leaf_indices = leaf_indices;
+    // Walk up from the leaves, adding each sibling that is not known already
+    uint64_t derived_peaks{0};
+    for (int height = 0; height < MAX_HEIGHT && (leaf_count >> height) > 0; ++height) {
+        const uint64_t level_size = leaf_count >> height;
+        std::vector<uint64_t> parents;
+        for (size_t i = 0; i < known.size(); ++i) {
+            const uint64_t index = known[i];
+            if (IsPeak(index, level_size)) {
+                derived_peaks |= uint64_t{1} << height;
+                continue;
+            }
+            if (index % 2 == 0 && i + 1 < known.size() && known[i + 1] == index + 1) {
+                ++i;
+            } else {
+                proof.nodes.push_back(m_levels[height][index ^ 1]);
+            }
+            parents.push_back(index / 2);
+        }
+        known = std::move(parents);
+    }
+    for (int height = 0; height < MAX_HEIGHT; ++height) {
+        if ((leaf_count >> height) & 1 && !((derived_peaks >> height) & 1)) {
+            proof.nodes.push_back(m_levels[height][(leaf_count >> height) - 1]);
+        }
+    }
+    return proof;
+}
+
+bool VerifyMMRProof(const uint256& root, const MMRProof& proof, const std::vector<uint256>& leaves)
+{
+    if (leaves.empty() || leaves.size() != proof.leaf_indices.size()) return false;
+    std::vector<std::pair<uint64_t, uint256>> known;
+    known.reserve(leaves.size());
+    for (size_t i = 0; i < leaves.size(); ++i) {
+        if (proof.leaf_indices[i] >= proof.leaf_count) return false;
+        known.emplace_back(proof.leaf_indices[i], leaves[i]);
+    }
+    std::sort(known.begin(), known.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (size_t i = 1; i < known.size(); ++i) {
+        if (known[i - 1].first == known[i].first) return false;
+    }
+
+    // Mirrors MerkleMountainRange::Prove, taking the nodes it added in turn
+    auto node = proof.nodes.begin();
+    std::array<std::optional<uint256>, MAX_HEIGHT> peaks;
+    for (int height = 0; height < MAX_HEIGHT && (proof.leaf_count >> height) > 0; ++height) {
+        const uint64_t level_size = proof.leaf_count >> height;
+        std::vector<std::pair<uint64_t, uint256>> parents;
+        for (size_t i = 0; i < known.size(); ++i) {
+            const auto& [index, hash] = known[i];
+            if (IsPeak(index, level_size)) {
+                peaks[height] = hash;
+                continue;
+            }
+            uint256 parent;
+            if (index % 2 == 0 && i + 1 < known.size() && known[i + 1].first == index + 1) {
+                parent = NodeHash(hash, known[++i].second);
+            } else {
+                if (node == proof.nodes.end()) return false;
+                parent = index % 2 ? NodeHash(*node, hash) : NodeHash(hash, *node);
+                ++node;
+            }
+            parents.emplace_back(index / 2, parent);
+        }
+        known = std::move(parents);
+    }
+    for (int height = 0; height < MAX_HEIGHT; ++height) {
+        if ((proof.leaf_count >> height) & 1 && !peaks[height]) {
+            if (node == proof.nodes.end()) return false;
+            peaks[height] = *node++;
+        }
+    }
+    if (node != proof.nodes.end()) return false;
+
+    return RootHash(proof.leaf_count, [&](int height) { return *peaks[height]; }) == root;
+}
+
+} // namespace interop
@@ -0,0 +1,72 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INTEROP_MMR_H
+#define BITCOIN_INTEROP_MMR_H
+
+#include <serialize.h>
+#include <uint256.h>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace interop {
+
+/**
+ * Proof that leaves are in a Merkle mountain range of leaf_count leaves.
+ * The internal nodes the leaves have in common are computed once, so a proof
+ * of many leaves carries far fewer than a path per leaf.
+ */
+struct MMRProof {
+    uint64_t leaf_count{0};
+    //! Leaves proven, in the order their hashes are given to VerifyMMRProof
+    std::vector<uint64_t> leaf_indices;
+    //! Nodes that cannot be computed from the leaves, in the order used
+    std::vector<uint256> nodes;
+
+    SERIALIZE_METHODS(MMRProof, obj) { READWRITE(obj.leaf_count, obj.leaf_indices, obj.nodes); }
+};
+
+/**
+ * Append-only Merkle accumulator (Merkle mountain range)
+ *
+ * Leaves are kept as perfect binary trees of decreasing size, one per set
+ * bit of the leaf count; the root commits to the leaf count and the roots of
+ * those trees (the peaks). Appending hashes one new node per tree merged,
+ * amortized one per leaf, and a proof is the path from a leaf to its peak
+ * plus the other peaks, so both stay logarithmic in the number of leaves.
+ *
+ * Every node is kept, level by level. Since earlier nodes never change, a
+ * proof can also be made against the root of any earlier leaf count.
+ */
+class MerkleMountainRange
+{
+public:
+    uint64_t Size() const { return m_levels.empty() ? 0 : m_levels[0].size(); }
+
+    /** Append a leaf, returning its index */
+    uint64_t Append(const uint256& leaf);
+
+    /** Root of the first leaf_count leaves (at most Size()) */
+    uint256 GetRoot(uint64_t leaf_count) const;
+    uint256 GetRoot() const { return GetRoot(Size()); }
+
+    /**
+     * Prove the leaves at leaf_indices against the root of the first
+     * leaf_count leaves. Fails if an index repeats or is out of range.
+     */
+    std::optional<MMRProof> Prove(const std::vector<uint64_t>& leaf_indices, uint64_t leaf_count) const;
+
+private:
+    //! Nodes by height: leaves, then their parents, and so on
+    std::vector<std::vector<uint256>> m_levels;
+};
+
+/** Check that leaves, at proof.leaf_indices, are in the range with the given root */
+bool VerifyMMRProof(const uint256& root, const MMRProof& proof, const std::vector<uint256>& leaves);
+
+} // namespace interop
+
+#endif // BITCOIN_INTEROP_MMR_H
@@ -0,0 +1,55 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <interop/timerwheel.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace interop {
+
+void HeightTimerWheel::Schedule(uint32_t height, const uint256& id)
+{
+    Insert({std::max(height, m_height + 1), id});
+    ++m_size;
+}
+
+void HeightTimerWheel::Insert(Timer timer)
+{
+    for (int level = 0; level < LEVELS; ++level) {
+        const int span_bits = SLOT_BITS * (level + 1);
+        if (uint64_t{timer.height} >> span_bits == uint64_t{m_height} >> span_bits) {
+            m_wheels[level][(timer.height >> (SLOT_BITS * level)) % SLOTS].push_back(std::move(timer));
+            return;
+        }
+    }
+    m_overflow.push_back(std::move(timer));
+}
+
+std::vector<uint256> HeightTimerWheel::Advance(uint32_t height)
+{
+    std::vector<uint256> expired;
+    while (m_height < height) {
+        ++m_height;
+
+        // At the start of a span, its timers move down from the level above,
+        // highest level first so they can drop more than one level
+        if (m_height % (uint64_t{1} << (SLOT_BITS * LEVELS)) == 0) {
+            for (Timer& timer : std::exchange(m_overflow, {})) Insert(std::move(timer));
+        }
+        for (int level = LEVELS - 1; level > 0; --level) {
+            if (m_height % (1U << (SLOT_BITS * level)) != 0) continue;
+            auto& slot = m_wheels[level][(m_height >> (SLOT_BITS * level)) % SLOTS];
+            for (Timer& timer : std::exchange(slot, {})) Insert(std::move(timer));
+        }
+
+        auto& slot = m_wheels[0][m_height % SLOTS];
+        for (const Timer& timer : slot) expired.push_back(timer.id);
+        m_size -= slot.size();
+        slot.clear();
+    }
+    return expired;
+}
+
+} // namespace interop
@@ -0,0 +1,66 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INTEROP_TIMERWHEEL_H
+#define BITCOIN_INTEROP_TIMERWHEEL_H
+
+#include <uint256.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace interop {
+
+/**
+ * Hierarchical timing wheel of IDs due at block heights
+ *
+ * Level 0 has a slot per height of the current 64 block span, level 1 a slot
+ * per 64 blocks of the current 4096, and so on. A timer sits in the lowest
+ * level whose span contains both the current height and its due height, and
+ * moves down a level when the wheel reaches its slot. Advancing a block
+ * touches only the timers due at it and, once per span, the timers moving
+ * down; scheduling is constant time. Timers further ahead than the top level
+ * wait in an overflow list that is revisited once per top-level span.
+ *
+ * Timers cannot be cancelled; owners check on expiry whether a timer still
+ * applies.
+ */
+class HeightTimerWheel
+{
+public:
+    explicit HeightTimerWheel(uint32_t height = 0) : m_height{height} {}
+
+    /** Height up to which timers have expired */
+    uint32_t GetHeight() const { return m_height; }
+    size_t Size() const { return m_size; }
+
+    /** Schedule id at height; timers already due expire at the next height */
+    void Schedule(uint32_t height, const uint256& id);
+
+    /** Advance to height, returning the IDs due at the heights passed, in order */
+    std::vector<uint256> Advance(uint32_t height);
+
+private:
+    static constexpr int SLOT_BITS = 6;
+    static constexpr uint32_t SLOTS = 1 << SLOT_BITS;
+    static constexpr int LEVELS = 4;
+
+    struct Timer {
+        uint32_t height;
+        uint256 id;
+    };
+
+    uint32_t m_height;
+    size_t m_size{0};
+    std::array<std::array<std::vector<Timer>, SLOTS>, LEVELS> m_wheels;
+    std::vector<Timer> m_overflow;
+
+    void Insert(Timer timer);
+};
+
+} // namespace interop
+
+#endif // BITCOIN_INTEROP_TIMERWHEEL_H
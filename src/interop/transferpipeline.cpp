@@ -0,0 +1,175 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <interop/transferpipeline.h>
+
+#include <consensus/merkle.h>
+#include <interop/headerchain.h>
+#include <logging.h>
+#include <merkleblock.h>
+#include <streams.h>
+#include <util/thread.h>
+
+#include <iterator>
+#include <limits>
+#include <map>
+#include <optional>
+#include <utility>
+
+namespace interop {
+namespace bridges {
+
+BridgeTransferPipeline::BridgeTransferPipeline(BridgeBatchSigner& signer, const Options& options)
+    : m_signer{signer},
+      m_options{options},
+      m_to_confirm{options.queue_capacity},
+      m_to_sign{options.queue_capacity},
+      m_to_submit{options.queue_capacity},
+      // Drained by the caller, which must not be held up by its own backlog
+      m_completed{std::numeric_limits<size_t>::max()}
+{
+    m_confirm_thread = std::thread(&util::TraceThread, "bridgeconfirm", [this] { ConfirmTransfers(); });
+    m_sign_thread = std::thread(&util::TraceThread, "bridgesign", [this] { SignTransfers(); });
+    m_submit_thread = std::thread(&util::TraceThread, "bridgesubmit", [this] { SubmitTransfers(); });
+}
+
+BridgeTransferPipeline::~BridgeTransferPipeline()
+{
+    Stop();
+}
+
+bool BridgeTransferPipeline::Submit(BridgeTransfer transfer)
+{
+    return m_to_confirm.Push(std::move(transfer));
+}
+
+std::vector<BridgeTransfer> BridgeTransferPipeline::TakeCompleted(std::vector<BridgeTransferBatch>& batches)
+{
+    std::vector<BridgeTransfer> transfers;
+    for (Batch& completed : m_completed.PopBatch(std::numeric_limits<size_t>::max(), /*wait=*/false)) {
+        if (!completed.batch.batch_root.IsNull()) {
+            batches.push_back(std::move(completed.batch));
+        }
+        std::move(completed.transfers.begin(), completed.transfers.end(), std::back_inserter(transfers));
+    }
+    return transfers;
+}
+
+void BridgeTransferPipeline::Stop()
+{
+    // Each stage finishes what it has queued once the stage before it is done
+    m_to_confirm.Close();
+    if (m_confirm_thread.joinable()) m_confirm_thread.join();
+    m_to_sign.Close();
+    if (m_sign_thread.joinable()) m_sign_thread.join();
+    m_to_submit.Close();
+    if (m_submit_thread.joinable()) m_submit_thread.join();
+}
+
+void BridgeTransferPipeline::ConfirmTransfers()
+{
+    while (true) {
+        std::vector<BridgeTransfer> transfers = m_to_confirm.PopBatch(m_options.batch_size);
+        if (transfers.empty()) return;
+
+        // Transfers leaving the pipeline here: failed, or not confirmed yet
+        Batch returned;
+
+        // Group the transfers by source block, so each block's confirmations
+        // are looked up once
+        std::map<std::pair<params::SupportedChain, uint256>, std::vector<std::pair<BridgeTransfer*, CMerkleBlock>>> blocks;
+        for (BridgeTransfer& transfer : transfers) {
+            // Only the transaction that deposited the transfer can confirm it
+            if (transfer.source_outpoint.IsNull() || transfer.source_outpoint.hash.ToUint256() != transfer.source_tx_hash) {
+                transfer.status = BridgeTransfer::TRANSFER_FAILED;
+                returned.transfers.push_back(std::move(transfer));
+                continue;
+            }
+            try {
+                CMerkleBlock proof;
+                SpanReader{transfer.source_tx_proof} >> proof;
+                const uint256 block_hash = proof.header.GetHash();
+                blocks[{transfer.source_chain, block_hash}].emplace_back(&transfer, std::move(proof));
+            } catch (const std::exception&) {
+                transfer.status = BridgeTransfer::TRANSFER_FAILED;
+                returned.transfers.push_back(std::move(transfer));
+            }
+        }
+
+        for (auto& [block, block_transfers] : blocks) {
+            const auto& [chain, block_hash] = block;
+            const auto light_client = GetChainLightClient(chain);
+            const auto confirmations = light_client ? light_client->GetConfirmations(block_hash) : std::nullopt;
+            const bool confirmed = confirmations && *confirmations >= GetRequiredConfirmations(chain);
+            for (auto& [transfer, proof] : block_transfers) {
+                if (!confirmed) {
+                    returned.transfers.push_back(std::move(*transfer));
+                } else if (!VerifyMerkleProof(transfer->source_tx_hash, proof)) {
+                    transfer->status = BridgeTransfer::TRANSFER_FAILED;
+                    returned.transfers.push_back(std::move(*transfer));
+                } else {
+                    transfer->status = BridgeTransfer::TRANSFER_CONFIRMED;
+                    m_to_sign.Push(std::move(*transfer));
+                }
+            }
+        }
+
+        if (!returned.transfers.empty()) {
+            m_completed.Push(std::move(returned));
+        }
+    }
+}
+
+void BridgeTransferPipeline::SignTransfers()
+{
+    while (true) {
+        Batch signing;
+        signing.transfers = m_to_sign.PopBatch(m_options.batch_size);
+        if (signing.transfers.empty()) return;
+
+        std::vector<uint256> leaves;
+        leaves.reserve(signing.transfers.size());
+        for (const BridgeTransfer& transfer : signing.transfers) {
+            leaves.push_back(GetBridgeTransferHash(transfer));
+            signing.batch.transfer_ids.push_back(transfer.transfer_id);
+        }
+        signing.batch.batch_root = ComputeMerkleRoot(std::move(leaves));
+
+        const bool signed_batch = m_signer.SignBatch(signing.batch) && CheckBridgeSecurityThreshold(signing.batch.signers);
+        for (BridgeTransfer& transfer : signing.transfers) {
+            if (signed_batch) {
+                transfer.status = BridgeTransfer::TRANSFER_PROCESSING;
+                transfer.validator_signatures = signing.batch.signers;
+                transfer.batch_root = signing.batch.batch_root;
+            } else {
+                transfer.status = BridgeTransfer::TRANSFER_FAILED;
+            }
+        }
+        if (!signed_batch) {
+            LogPrintf("Bitcoin Decentral: Failed to sign bridge transfer batch %s of %d transfers\n",
+                      signing.batch.batch_root.ToString(), signing.transfers.size());
+            signing.batch = {};
+        }
+        m_to_submit.Push(std::move(signing));
+    }
+}
+
+void BridgeTransferPipeline::SubmitTransfers()
+{
+    while (true) {
+        std::vector<Batch> batches = m_to_submit.PopBatch(1);
+        if (batches.empty()) return;
+
+        Batch& batch = batches.front();
+        for (BridgeTransfer& transfer : batch.transfers) {
+            if (transfer.status != BridgeTransfer::TRANSFER_PROCESSING) continue;
+            transfer.status = ExecuteDestinationChainTransfer(transfer) ? BridgeTransfer::TRANSFER_COMPLETED
+                                                                        : BridgeTransfer::TRANSFER_FAILED;
+        }
+        m_completed.Push(std::move(batch));
+    }
+}
+
+} // namespace bridges
+} // namespace interop
@@ -0,0 +1,155 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INTEROP_TRANSFERPIPELINE_H
+#define BITCOIN_INTEROP_TRANSFERPIPELINE_H
+
+#include <interop/bridges.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace interop {
+namespace bridges {
+
+/**
+ * Signs the merkle root of a batch of transfers on behalf of the bridge
+ * validators, for example with MuSig2 as checkpoints are signed
+ */
+class BridgeBatchSigner
+{
+public:
+    virtual ~BridgeBatchSigner() = default;
+
+    /** Sign batch.batch_root, filling in the signers and their aggregate signature */
+    virtual bool SignBatch(BridgeTransferBatch& batch) = 0;
+};
+
+/**
+ * Queue of at most a fixed number of items between two pipeline stages.
+ * Pushing blocks while the queue is full, so a slow stage holds back the
+ * stages before it.
+ */
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity) : m_capacity{capacity} {}
+
+    /** Add an item, waiting for space. Returns false once the queue is closed. */
+    bool Push(T item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_full.wait(lock, [&] { return m_closed || m_items.size() < m_capacity; });
+        if (m_closed) return false;
+        m_items.push_back(std::move(item));
+        m_not_empty.notify_one();
+        return true;
+    }
+
+    /**
+     * Take up to max_count items, waiting for at least one unless wait is
+     * false. Empty once the queue is closed and drained.
+     */
+    std::vector<T> PopBatch(size_t max_count, bool wait = true)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (wait) m_not_empty.wait(lock, [&] { return m_closed || !m_items.empty(); });
+        std::vector<T> items;
+        while (!m_items.empty() && items.size() < max_count) {
+            items.push_back(std::move(m_items.front()));
+            m_items.pop_front();
+        }
+        m_not_full.notify_all();
+        return items;
+    }
+
+    /** Refuse new items and wake waiting consumers; queued items can still be taken */
+    void Close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_not_empty.notify_all();
+        m_not_full.notify_all();
+    }
+
+private:
+    const size_t m_capacity;
+    std::mutex m_mutex;
+    std::condition_variable m_not_empty;
+    std::condition_variable m_not_full;
+    std::deque<T> m_items;
+    bool m_closed{false};
+};
+
+/**
+ * Processes bridge transfers in stages, each on its own thread:
+ *
+ * - confirm: checks source transactions against the chains' light clients,
+ *   looking up each source block once for all of its transfers
+ * - sign: collects confirmed transfers into batches and has the validators
+ *   sign the merkle root of each batch once
+ * - submit: executes the transfers on their destination chains
+ *
+ * The final stage, completing transfers in the bridge state, is left to the
+ * caller (see ApplyBridgeTransferResults), so the pipeline threads never
+ * touch the global bridge state.
+ */
+class BridgeTransferPipeline
+{
+public:
+    struct Options {
+        size_t batch_size{256};       //!< Most transfers confirmed or signed together
+        size_t queue_capacity{4096};  //!< Most items waiting between two stages
+    };
+
+    BridgeTransferPipeline(BridgeBatchSigner& signer, const Options& options);
+    ~BridgeTransferPipeline();
+
+    BridgeTransferPipeline(const BridgeTransferPipeline&) = delete;
+    BridgeTransferPipeline& operator=(const BridgeTransferPipeline&) = delete;
+
+    /** Queue a transfer, waiting while the pipeline is full. Returns false once stopped. */
+    bool Submit(BridgeTransfer transfer);
+
+    /**
+     * Take the transfers that have left the pipeline, with the batches they
+     * were signed in. Transfers whose source transaction is not confirmed
+     * yet come back still pending.
+     */
+    std::vector<BridgeTransfer> TakeCompleted(std::vector<BridgeTransferBatch>& batches);
+
+    /** Finish the transfers already submitted and stop the stage threads */
+    void Stop();
+
+private:
+    /** Transfers moving through the pipeline together */
+    struct Batch {
+        BridgeTransferBatch batch;
+        std::vector<BridgeTransfer> transfers;
+    };
+
+    BridgeBatchSigner& m_signer;
+    const Options m_options;
+    BoundedQueue<BridgeTransfer> m_to_confirm;
+    BoundedQueue<BridgeTransfer> m_to_sign;
+    BoundedQueue<Batch> m_to_submit;
+    BoundedQueue<Batch> m_completed;
+    std::thread m_confirm_thread;
+    std::thread m_sign_thread;
+    std::thread m_submit_thread;
+
+    void ConfirmTransfers();
+    void SignTransfers();
+    void SubmitTransfers();
+};
+
+} // namespace bridges
+} // namespace interop
+
+#endif // BITCOIN_INTEROP_TRANSFERPIPELINE_H
@@ -61,6 +61,21 @@ struct AssumeutxoData {
     uint256 blockhash;
 };
 
+/**
+ * Holds the expected commitment of a smart contract state snapshot. As with
+ * AssumeutxoData, the contents here are security critical, since they dictate
+ * which contract state snapshots -loadcontractstate accepts.
+ */
+struct ContractSnapshotData {
+    int height;
+
+    //! The expected ComputeContractStateCommitment() of the contract states.
+    uint256 state_commitment;
+
+    //! The hash of the block whose contract state the snapshot holds.
+    uint256 blockhash;
+};
+
 /**
  * Holds various statistics on transactions within a chain. Used to estimate
  * verification progress during chain sync.
@@ -128,6 +143,10 @@ public:
     {
         return FindFirst(m_assumeutxo_data, [&](const auto& d) { return d.blockhash == blockhash; });
     }
+    std::optional<ContractSnapshotData> ContractSnapshotForBlockhash(const uint256& blockhash) const
+    {
+        return FindFirst(m_contract_snapshot_data, [&](const auto& d) { return d.blockhash == blockhash; });
+    }
 
     const ChainTxData& TxData() const { return chainTxData; }
 
@@ -183,6 +202,7 @@ protected:
     bool m_is_mockable_chain;
     CCheckpointData checkpointData;
     std::vector<AssumeutxoData> m_assumeutxo_data;
+    std::vector<ContractSnapshotData> m_contract_snapshot_data;
     ChainTxData chainTxData;
 };
 
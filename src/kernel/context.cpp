@@ -4,7 +4,9 @@
 
 #include <kernel/context.h>
 
+#include <crypto/mldsa.h>
 #include <crypto/sha256.h>
+#include <crypto/sha3.h>
 #include <logging.h>
 #include <random.h>
 
@@ -18,6 +20,10 @@ Context::Context()
     std::call_once(globals_initialized, []() {
         std::string sha256_algo = SHA256AutoDetect();
         LogInfo("Using the '%s' SHA256 implementation\n", sha256_algo);
+        std::string mldsa_algo = MLDSAAutoDetect();
+        LogInfo("Using the '%s' ML-DSA implementation\n", mldsa_algo);
+        std::string keccak_algo = KeccakAutoDetect();
+        LogInfo("Using the '%s' Keccak implementation\n", keccak_algo);
         RandomInit();
     });
 }
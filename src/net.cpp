@@ -417,6 +417,9 @@ CNode* CConnman::ConnectNode(CAddress addrConnect, const char *pszDest, bool fCo
         pszDest ? pszDest : addrConnect.ToStringAddrPort(),
         Ticks<HoursDouble>(pszDest ? 0h : Now<NodeSeconds>() - addrConnect.nTime));
 
+    // Attempt the hybrid handshake only with peers known to offer it.
+    const bool use_v2hybrid(use_v2transport && (addrConnect.nServices & GetLocalServices() & NODE_P2P_V2_HYBRID));
+
     // Resolve
     const uint16_t default_port{pszDest != nullptr ? GetDefaultPort(pszDest) :
                                                      m_params.GetDefaultPort()};
@@ -545,6 +548,7 @@ CNode* CConnman::ConnectNode(CAddress addrConnect, const char *pszDest, bool fCo
                                     .i2p_sam_session = std::move(i2p_transient_session),
                                     .recv_flood_size = nReceiveFloodSize,
                                     .use_v2transport = use_v2transport,
+                                    .use_v2hybrid = use_v2hybrid,
                                 });
         pnode->AddRef();
 
@@ -974,11 +978,11 @@ public:
 
 const V2MessageMap V2_MESSAGE_MAP;
 
-std::vector<uint8_t> GenerateRandomGarbage() noexcept
+std::vector<uint8_t> GenerateRandomGarbage(size_t max_len = V2Transport::MAX_GARBAGE_LEN) noexcept
 {
     std::vector<uint8_t> ret;
     FastRandomContext rng;
-    ret.resize(rng.randrange(V2Transport::MAX_GARBAGE_LEN + 1));
+    ret.resize(rng.randrange(max_len + 1));
     rng.fillrand(MakeWritableByteSpan(ret));
     return ret;
 }
@@ -997,13 +1001,41 @@ void V2Transport::StartSendingHandshake() noexcept
     // We cannot wipe m_send_garbage as it will still be used as AAD later in the handshake.
 }
 
-V2Transport::V2Transport(NodeId nodeid, bool initiating, const CKey& key, Span<const std::byte> ent32, std::vector<uint8_t> garbage) noexcept
+void V2Transport::SendGarbageTerminatorAndVersion(Span<const std::byte> version_contents) noexcept
+{
+    AssertLockHeld(m_send_mutex);
+    // Append the garbage terminator to the send buffer.
+    m_send_buffer.resize(m_send_buffer.size() + BIP324Cipher::GARBAGE_TERMINATOR_LEN);
+    std::copy(m_cipher.GetSendGarbageTerminator().begin(),
+              m_cipher.GetSendGarbageTerminator().end(),
+              MakeWritableByteSpan(m_send_buffer).last(BIP324Cipher::GARBAGE_TERMINATOR_LEN).begin());
+
+    // Construct version packet in the send buffer, with the sent garbage data as AAD.
+    m_send_buffer.resize(m_send_buffer.size() + BIP324Cipher::EXPANSION + version_contents.size());
+    m_cipher.Encrypt(
+        /*contents=*/version_contents,
+        /*aad=*/MakeByteSpan(m_send_garbage),
+        /*ignore=*/false,
+        /*output=*/MakeWritableByteSpan(m_send_buffer).last(BIP324Cipher::EXPANSION + version_contents.size()));
+    // We no longer need the garbage.
+    ClearShrink(m_send_garbage);
+}
+
+V2Transport::V2Transport(NodeId nodeid, bool initiating, const CKey& key, Span<const std::byte> ent32, std::vector<uint8_t> garbage,
+                         bool hybrid, std::optional<BIP324KEMKey> kem_key) noexcept
     : m_cipher{key, ent32}, m_initiating{initiating}, m_nodeid{nodeid},
       m_v1_fallback{nodeid},
       m_recv_state{initiating ? RecvState::KEY : RecvState::KEY_MAYBE_V1},
       m_send_garbage{std::move(garbage)},
-      m_send_state{initiating ? SendState::AWAITING_KEY : SendState::MAYBE_V1}
+      m_send_state{initiating ? SendState::AWAITING_KEY : SendState::MAYBE_V1},
+      m_kem_awaiting_key{hybrid && initiating}
 {
+    if (hybrid && !initiating) {
+        // Offer our ML-KEM encapsulation key as the start of the garbage, where peers that do not
+        // know about the hybrid handshake ignore it.
+        m_kem_key = kem_key ? std::move(*kem_key) : BIP324KEMKey::Generate();
+        m_send_garbage.insert(m_send_garbage.begin(), m_kem_key->encaps_key.begin(), m_kem_key->encaps_key.end());
+    }
     Assume(m_send_garbage.size() <= MAX_GARBAGE_LEN);
     // Start sending immediately if we're the initiator of the connection.
     if (initiating) {
@@ -1012,9 +1044,11 @@ V2Transport::V2Transport(NodeId nodeid, bool initiating, const CKey& key, Span<c
     }
 }
 
-V2Transport::V2Transport(NodeId nodeid, bool initiating) noexcept
+V2Transport::V2Transport(NodeId nodeid, bool initiating, bool hybrid, std::optional<BIP324KEMKey> kem_key) noexcept
     : V2Transport{nodeid, initiating, GenerateRandomKey(),
-                  MakeByteSpan(GetRandHash()), GenerateRandomGarbage()} {}
+                  MakeByteSpan(GetRandHash()),
+                  GenerateRandomGarbage(hybrid && !initiating ? MAX_GARBAGE_LEN - BIP324Cipher::KEM_ENCAPS_KEY_LEN : MAX_GARBAGE_LEN),
+                  hybrid, std::move(kem_key)} {}
 
 void V2Transport::SetReceiveState(RecvState recv_state) noexcept
 {
@@ -1056,6 +1090,9 @@ void V2Transport::SetSendState(SendState send_state) noexcept
         Assume(send_state == SendState::V1 || send_state == SendState::AWAITING_KEY);
         break;
     case SendState::AWAITING_KEY:
+        Assume(send_state == SendState::READY || send_state == SendState::AWAITING_KEM);
+        break;
+    case SendState::AWAITING_KEM:
         Assume(send_state == SendState::READY);
         break;
     case SendState::READY:
@@ -1150,24 +1187,18 @@ bool V2Transport::ProcessReceivedKeyBytes() noexcept
         SetReceiveState(RecvState::GARB_GARBTERM);
         m_recv_buffer.clear();
 
-        // Switch sender state to READY.
-        SetSendState(SendState::READY);
+        if (m_kem_awaiting_key) {
+            // The version packet waits for the other side's ML-KEM encapsulation key.
+            SetSendState(SendState::AWAITING_KEM);
+            return true;
+        }
+        if (!m_kem_key) m_cipher.WipeHybridKey();
+
+        // Switch sender state to READY, or wait for the other side's version packet to complete
+        // the ML-KEM exchange.
+        SetSendState(m_kem_key ? SendState::AWAITING_KEM : SendState::READY);
 
-        // Append the garbage terminator to the send buffer.
-        m_send_buffer.resize(m_send_buffer.size() + BIP324Cipher::GARBAGE_TERMINATOR_LEN);
-        std::copy(m_cipher.GetSendGarbageTerminator().begin(),
-                  m_cipher.GetSendGarbageTerminator().end(),
-                  MakeWritableByteSpan(m_send_buffer).last(BIP324Cipher::GARBAGE_TERMINATOR_LEN).begin());
-
-        // Construct version packet in the send buffer, with the sent garbage data as AAD.
-        m_send_buffer.resize(m_send_buffer.size() + BIP324Cipher::EXPANSION + VERSION_CONTENTS.size());
-        m_cipher.Encrypt(
-            /*contents=*/VERSION_CONTENTS,
-            /*aad=*/MakeByteSpan(m_send_garbage),
-            /*ignore=*/false,
-            /*output=*/MakeWritableByteSpan(m_send_buffer).last(BIP324Cipher::EXPANSION + VERSION_CONTENTS.size()));
-        // We no longer need the garbage.
-        ClearShrink(m_send_garbage);
+        SendGarbageTerminatorAndVersion(VERSION_CONTENTS);
     } else {
         // We still have to receive more key bytes.
     }
@@ -1177,6 +1208,7 @@ bool V2Transport::ProcessReceivedKeyBytes() noexcept
 bool V2Transport::ProcessReceivedGarbageBytes() noexcept
 {
     AssertLockHeld(m_recv_mutex);
+    AssertLockNotHeld(m_send_mutex);
     Assume(m_recv_state == RecvState::GARB_GARBTERM);
     Assume(m_recv_buffer.size() <= MAX_GARBAGE_LEN + BIP324Cipher::GARBAGE_TERMINATOR_LEN);
     if (m_recv_buffer.size() >= BIP324Cipher::GARBAGE_TERMINATOR_LEN) {
@@ -1186,6 +1218,33 @@ bool V2Transport::ProcessReceivedGarbageBytes() noexcept
             m_recv_aad.resize(m_recv_aad.size() - BIP324Cipher::GARBAGE_TERMINATOR_LEN);
             m_recv_buffer.clear();
             SetReceiveState(RecvState::VERSION);
+            if (m_kem_awaiting_key) {
+                // The garbage was too short to hold an ML-KEM encapsulation key, so the other side
+                // does not offer the hybrid handshake.
+                m_kem_awaiting_key = false;
+                m_cipher.WipeHybridKey();
+                LOCK(m_send_mutex);
+                SendGarbageTerminatorAndVersion(VERSION_CONTENTS);
+                SetSendState(SendState::READY);
+            }
+        } else if (m_kem_awaiting_key && m_recv_buffer.size() == BIP324Cipher::KEM_ENCAPS_KEY_LEN) {
+            // The start of the garbage may be the other side's ML-KEM encapsulation key. If it is,
+            // send the ciphertext as the contents of our version packet, still under the ECDH
+            // keys, and encrypt everything after it with the hybrid keys. Random garbage fails
+            // the encapsulation key check, in which case we send a plain version packet.
+            m_kem_awaiting_key = false;
+            std::array<std::byte, BIP324Cipher::KEM_CIPHERTEXT_LEN> kem_ciphertext;
+            const bool encapsulated = m_cipher.Encapsulate(MakeByteSpan(m_recv_buffer), kem_ciphertext, m_initiating);
+            LOCK(m_send_mutex);
+            if (encapsulated) {
+                SendGarbageTerminatorAndVersion(kem_ciphertext);
+                m_cipher.SwitchSendCipher();
+                LogDebug(BCLog::NET, "V2 transport: hybrid ML-KEM key exchange with peer=%d\n", m_nodeid);
+            } else {
+                m_cipher.WipeHybridKey();
+                SendGarbageTerminatorAndVersion(VERSION_CONTENTS);
+            }
+            SetSendState(SendState::READY);
         } else if (m_recv_buffer.size() == MAX_GARBAGE_LEN + BIP324Cipher::GARBAGE_TERMINATOR_LEN) {
             // We've reached the maximum length for garbage + garbage terminator, and the
             // terminator still does not match. Abort.
@@ -1201,9 +1260,38 @@ bool V2Transport::ProcessReceivedGarbageBytes() noexcept
     return true;
 }
 
+void V2Transport::ProcessReceivedVersion() noexcept
+{
+    AssertLockHeld(m_recv_mutex);
+    AssertLockNotHeld(m_send_mutex);
+    Assume(m_recv_state == RecvState::VERSION);
+    if (m_kem_key) {
+        // A version packet carrying an ML-KEM ciphertext completes the hybrid handshake we offered.
+        // Our own version packet went out under the ECDH keys; everything after this one is
+        // encrypted with the hybrid keys in both directions. Any other contents decline it.
+        LOCK(m_send_mutex);
+        Assume(m_send_state == SendState::AWAITING_KEM);
+        if (m_recv_decode_buffer.size() == BIP324Cipher::KEM_CIPHERTEXT_LEN) {
+            m_cipher.Decapsulate(*m_kem_key, MakeByteSpan(m_recv_decode_buffer), m_initiating);
+            m_cipher.SwitchSendCipher();
+            m_cipher.SwitchRecvCipher();
+            LogDebug(BCLog::NET, "V2 transport: hybrid ML-KEM key exchange with peer=%d\n", m_nodeid);
+        } else {
+            m_cipher.WipeHybridKey();
+        }
+        m_kem_key.reset();
+        SetSendState(SendState::READY);
+    } else {
+        // If we sent an ML-KEM ciphertext, packets after the other side's version packet are
+        // encrypted with the hybrid keys.
+        m_cipher.SwitchRecvCipher();
+    }
+}
+
 bool V2Transport::ProcessReceivedPacketBytes() noexcept
 {
     AssertLockHeld(m_recv_mutex);
+    AssertLockNotHeld(m_send_mutex);
     Assume(m_recv_state == RecvState::VERSION || m_recv_state == RecvState::APP);
 
     // The maximum permitted contents length for a packet, consisting of:
@@ -1247,7 +1335,8 @@ bool V2Transport::ProcessReceivedPacketBytes() noexcept
             switch (m_recv_state) {
             case RecvState::VERSION:
                 // Version message received; transition to application phase. The contents is
-                // ignored, but can be used for future extensions.
+                // ignored, except for the ML-KEM ciphertext of the hybrid handshake.
+                ProcessReceivedVersion();
                 SetReceiveState(RecvState::APP);
                 break;
             case RecvState::APP:
@@ -1827,6 +1916,7 @@ void CConnman::CreateNodeFromAcceptedSocket(std::unique_ptr<Sock>&& sock,
     // detected, so use it whenever we signal NODE_P2P_V2.
     ServiceFlags local_services = GetLocalServices();
     const bool use_v2transport(local_services & NODE_P2P_V2);
+    const bool use_v2hybrid(use_v2transport && (local_services & NODE_P2P_V2_HYBRID));
 
     CNode* pnode = new CNode(id,
                              std::move(sock),
@@ -1842,6 +1932,8 @@ void CConnman::CreateNodeFromAcceptedSocket(std::unique_ptr<Sock>&& sock,
                                  .prefer_evict = discouraged,
                                  .recv_flood_size = nReceiveFloodSize,
                                  .use_v2transport = use_v2transport,
+                                 .use_v2hybrid = use_v2hybrid,
+                                 .v2_kem_key = use_v2hybrid ? std::optional{TakeKEMKey()} : std::nullopt,
                              });
     pnode->AddRef();
     m_msgproc->InitializeNode(*pnode, local_services);
@@ -2391,6 +2483,43 @@ void CConnman::DumpAddresses()
              addrman.Size(), Ticks<std::chrono::milliseconds>(SteadyClock::now() - start));
 }
 
+void CConnman::RefillKEMKeyPool()
+{
+    AssertLockNotHeld(m_kem_key_pool_mutex);
+    size_t missing;
+    {
+        LOCK(m_kem_key_pool_mutex);
+        missing = KEM_KEY_POOL_SIZE - std::min(m_kem_key_pool.size(), KEM_KEY_POOL_SIZE);
+    }
+    if (missing == 0) return;
+
+    // Generate without holding the lock, so accepting connections never waits for it.
+    std::vector<BIP324KEMKey> kem_keys;
+    kem_keys.reserve(missing);
+    for (size_t i = 0; i < missing; ++i) kem_keys.push_back(BIP324KEMKey::Generate());
+
+    LOCK(m_kem_key_pool_mutex);
+    for (auto& kem_key : kem_keys) {
+        if (m_kem_key_pool.size() >= KEM_KEY_POOL_SIZE) break;
+        m_kem_key_pool.push_back(std::move(kem_key));
+    }
+}
+
+BIP324KEMKey CConnman::TakeKEMKey()
+{
+    AssertLockNotHeld(m_kem_key_pool_mutex);
+    {
+        LOCK(m_kem_key_pool_mutex);
+        if (!m_kem_key_pool.empty()) {
+            BIP324KEMKey kem_key{std::move(m_kem_key_pool.back())};
+            m_kem_key_pool.pop_back();
+            return kem_key;
+        }
+    }
+    LogDebug(BCLog::NET, "ML-KEM key pool empty, generating a key pair for an inbound connection\n");
+    return BIP324KEMKey::Generate();
+}
+
 void CConnman::ProcessAddrFetch()
 {
     AssertLockNotHeld(m_unused_i2p_sessions_mutex);
@@ -3388,6 +3517,12 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
     // Dump network addresses
     scheduler.scheduleEvery([this] { DumpAddresses(); }, DUMP_PEERS_INTERVAL);
 
+    // Keep ML-KEM key pairs ready for inbound hybrid v2 connections
+    if (GetLocalServices() & NODE_P2P_V2_HYBRID) {
+        RefillKEMKeyPool();
+        scheduler.scheduleEvery([this] { RefillKEMKeyPool(); }, KEM_KEY_POOL_REFILL_INTERVAL);
+    }
+
     // Run the ASMap Health check once and then schedule it to run every 24h.
     if (m_netgroupman.UsingASMap()) {
         ASMapHealthCheck();
@@ -3781,10 +3916,10 @@ ServiceFlags CConnman::GetLocalServices() const
     return m_local_services;
 }
 
-static std::unique_ptr<Transport> MakeTransport(NodeId id, bool use_v2transport, bool inbound) noexcept
+static std::unique_ptr<Transport> MakeTransport(NodeId id, bool use_v2transport, bool use_v2hybrid, std::optional<BIP324KEMKey> v2_kem_key, bool inbound) noexcept
 {
     if (use_v2transport) {
-        return std::make_unique<V2Transport>(id, /*initiating=*/!inbound);
+        return std::make_unique<V2Transport>(id, /*initiating=*/!inbound, /*hybrid=*/use_v2hybrid, std::move(v2_kem_key));
     } else {
         return std::make_unique<V1Transport>(id);
     }
@@ -3800,7 +3935,7 @@ CNode::CNode(NodeId idIn,
              ConnectionType conn_type_in,
              bool inbound_onion,
              CNodeOptions&& node_opts)
-    : m_transport{MakeTransport(idIn, node_opts.use_v2transport, conn_type_in == ConnectionType::INBOUND)},
+    : m_transport{MakeTransport(idIn, node_opts.use_v2transport, node_opts.use_v2hybrid, std::move(node_opts.v2_kem_key), conn_type_in == ConnectionType::INBOUND)},
       m_permission_flags{node_opts.permission_flags},
       m_sock{sock},
       m_connected{GetTime<std::chrono::seconds>()},
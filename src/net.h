@@ -93,6 +93,12 @@ static const size_t DEFAULT_MAXRECEIVEBUFFER = 5 * 1000;
 static const size_t DEFAULT_MAXSENDBUFFER    = 1 * 1000;
 
 static constexpr bool DEFAULT_V2_TRANSPORT{true};
+/** Default for -v2hybrid, mixing ML-KEM into the v2 transport handshake with peers that signal it. */
+static constexpr bool DEFAULT_V2_HYBRID{false};
+/** Number of ML-KEM key pairs kept ready for inbound hybrid v2 connections. */
+static constexpr size_t KEM_KEY_POOL_SIZE{64};
+/** How often the ML-KEM key pool is refilled. */
+static constexpr std::chrono::seconds KEM_KEY_POOL_REFILL_INTERVAL{1};
 
 typedef int64_t NodeId;
 
@@ -539,6 +545,9 @@ private:
      *      |            |
      *      v            v
      *  MAYBE_V1 -> AWAITING_KEY -> READY
+     *      |            |            ^
+     *      |            v            |
+     *      |       AWAITING_KEM -----/
      *      |
      *      \-----> V1
      */
@@ -558,6 +567,20 @@ private:
          * sender state becomes READY. */
         AWAITING_KEY,
 
+        /** (Hybrid only) Waiting for the ML-KEM exchange to complete.
+         *
+         * An initiator attempting the hybrid handshake enters this state instead of READY, and
+         * waits for the other side's ML-KEM encapsulation key at the start of its garbage. It then
+         * appends the garbage terminator and a version packet carrying the ML-KEM ciphertext (or
+         * an empty one, if no valid key was offered), and becomes READY.
+         *
+         * A responder offering the hybrid handshake enters this state after appending its garbage
+         * terminator and version packet, and becomes READY when the other side's version packet
+         * has been received.
+         *
+         * No messages can be provided in this state, as the packet cipher is about to change. */
+        AWAITING_KEM,
+
         /** Normal sending state.
          *
          * In this state, the ciphers are initialized, so packets can be sent. When this state is
@@ -611,6 +634,12 @@ private:
     /** Whether we've sent at least 24 bytes (which would trigger disconnect for V1 peers). */
     bool m_sent_v1_header_worth GUARDED_BY(m_send_mutex) {false};
 
+    /** (Initiator only) Whether we still expect the other side's ML-KEM encapsulation key at the
+     *  start of its garbage. */
+    bool m_kem_awaiting_key GUARDED_BY(m_recv_mutex);
+    /** (Responder only) The ML-KEM key pair we offer, until the other side's version packet. */
+    std::optional<BIP324KEMKey> m_kem_key GUARDED_BY(m_recv_mutex);
+
     /** Change the receive state. */
     void SetReceiveState(RecvState recv_state) noexcept EXCLUSIVE_LOCKS_REQUIRED(m_recv_mutex);
     /** Change the send state. */
@@ -621,14 +650,18 @@ private:
     size_t GetMaxBytesToProcess() noexcept EXCLUSIVE_LOCKS_REQUIRED(m_recv_mutex);
     /** Put our public key + garbage in the send buffer. */
     void StartSendingHandshake() noexcept EXCLUSIVE_LOCKS_REQUIRED(m_send_mutex);
+    /** Put the garbage terminator and the version packet in the send buffer. */
+    void SendGarbageTerminatorAndVersion(Span<const std::byte> version_contents) noexcept EXCLUSIVE_LOCKS_REQUIRED(m_send_mutex);
+    /** Complete the ML-KEM exchange, or give up on it, once the other side's version packet is in. */
+    void ProcessReceivedVersion() noexcept EXCLUSIVE_LOCKS_REQUIRED(m_recv_mutex, !m_send_mutex);
     /** Process bytes in m_recv_buffer, while in KEY_MAYBE_V1 state. */
     void ProcessReceivedMaybeV1Bytes() noexcept EXCLUSIVE_LOCKS_REQUIRED(m_recv_mutex, !m_send_mutex);
     /** Process bytes in m_recv_buffer, while in KEY state. */
     bool ProcessReceivedKeyBytes() noexcept EXCLUSIVE_LOCKS_REQUIRED(m_recv_mutex, !m_send_mutex);
     /** Process bytes in m_recv_buffer, while in GARB_GARBTERM state. */
-    bool ProcessReceivedGarbageBytes() noexcept EXCLUSIVE_LOCKS_REQUIRED(m_recv_mutex);
+    bool ProcessReceivedGarbageBytes() noexcept EXCLUSIVE_LOCKS_REQUIRED(m_recv_mutex, !m_send_mutex);
     /** Process bytes in m_recv_buffer, while in VERSION/APP state. */
-    bool ProcessReceivedPacketBytes() noexcept EXCLUSIVE_LOCKS_REQUIRED(m_recv_mutex);
+    bool ProcessReceivedPacketBytes() noexcept EXCLUSIVE_LOCKS_REQUIRED(m_recv_mutex, !m_send_mutex);
 
 public:
     static constexpr uint32_t MAX_GARBAGE_LEN = 4095;
@@ -637,11 +670,17 @@ public:
      *
      * @param[in] nodeid      the node's NodeId (only for debug log output).
      * @param[in] initiating  whether we are the initiator side.
+     * @param[in] hybrid      whether to attempt (as initiator) or offer (as responder) mixing an
+     *                        ML-KEM shared secret into the packet keys.
+     * @param[in] kem_key     (responder only) the ML-KEM key pair to offer; one is generated if
+     *                        hybrid is set and none is provided.
      */
-    V2Transport(NodeId nodeid, bool initiating) noexcept;
+    V2Transport(NodeId nodeid, bool initiating, bool hybrid = false, std::optional<BIP324KEMKey> kem_key = std::nullopt) noexcept;
 
-    /** Construct a V2 transport with specified keys and garbage (test use only). */
-    V2Transport(NodeId nodeid, bool initiating, const CKey& key, Span<const std::byte> ent32, std::vector<uint8_t> garbage) noexcept;
+    /** Construct a V2 transport with specified keys and garbage (test use only). A hybrid
+     *  responder sends the encapsulation key of kem_key ahead of the garbage. */
+    V2Transport(NodeId nodeid, bool initiating, const CKey& key, Span<const std::byte> ent32, std::vector<uint8_t> garbage,
+                bool hybrid = false, std::optional<BIP324KEMKey> kem_key = std::nullopt) noexcept;
 
     // Receive side functions.
     bool ReceivedMessageComplete() const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_recv_mutex);
@@ -666,6 +705,10 @@ struct CNodeOptions
     bool prefer_evict = false;
     size_t recv_flood_size{DEFAULT_MAXRECEIVEBUFFER * 1000};
     bool use_v2transport = false;
+    /** Whether to attempt (outbound) or offer (inbound) the hybrid ML-KEM handshake on v2 transport. */
+    bool use_v2hybrid = false;
+    /** ML-KEM key pair to offer on an inbound hybrid v2 connection. */
+    std::optional<BIP324KEMKey> v2_kem_key{};
 };
 
 /** Information about a peer */
@@ -1300,7 +1343,7 @@ private:
     void ThreadOpenConnections(std::vector<std::string> connect, Span<const std::string> seed_nodes) EXCLUSIVE_LOCKS_REQUIRED(!m_addr_fetches_mutex, !m_added_nodes_mutex, !m_nodes_mutex, !m_unused_i2p_sessions_mutex, !m_reconnections_mutex);
     void ThreadMessageHandler() EXCLUSIVE_LOCKS_REQUIRED(!mutexMsgProc);
     void ThreadI2PAcceptIncoming();
-    void AcceptConnection(const ListenSocket& hListenSocket);
+    void AcceptConnection(const ListenSocket& hListenSocket) EXCLUSIVE_LOCKS_REQUIRED(!m_kem_key_pool_mutex);
 
     /**
      * Create a `CNode` object from a socket that has just been accepted and add the node to
@@ -1313,7 +1356,7 @@ private:
     void CreateNodeFromAcceptedSocket(std::unique_ptr<Sock>&& sock,
                                       NetPermissionFlags permission_flags,
                                       const CService& addr_bind,
-                                      const CService& addr);
+                                      const CService& addr) EXCLUSIVE_LOCKS_REQUIRED(!m_kem_key_pool_mutex);
 
     void DisconnectNodes() EXCLUSIVE_LOCKS_REQUIRED(!m_reconnections_mutex, !m_nodes_mutex);
     void NotifyNumConnectionsChanged();
@@ -1375,6 +1418,12 @@ private:
 
     void DumpAddresses();
 
+    /** Top up m_kem_key_pool to KEM_KEY_POOL_SIZE key pairs. */
+    void RefillKEMKeyPool() EXCLUSIVE_LOCKS_REQUIRED(!m_kem_key_pool_mutex);
+
+    /** Take a key pair from m_kem_key_pool, or generate one if it is empty. */
+    BIP324KEMKey TakeKEMKey() EXCLUSIVE_LOCKS_REQUIRED(!m_kem_key_pool_mutex);
+
     // Network stats
     void RecordBytesRecv(uint64_t bytes);
     void RecordBytesSent(uint64_t bytes) EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex);
@@ -1605,6 +1654,19 @@ private:
      */
     std::queue<std::unique_ptr<i2p::sam::Session>> m_unused_i2p_sessions GUARDED_BY(m_unused_i2p_sessions_mutex);
 
+    /**
+     * Mutex protecting m_kem_key_pool.
+     */
+    Mutex m_kem_key_pool_mutex;
+
+    /**
+     * ML-KEM key pairs to offer on inbound hybrid v2 connections. Generating one costs
+     * more than the rest of the responder's handshake, so the pool is refilled by the
+     * scheduler instead of on the connection path. If it runs dry under a burst of
+     * connections, a key pair is generated on the spot.
+     */
+    std::vector<BIP324KEMKey> m_kem_key_pool GUARDED_BY(m_kem_key_pool_mutex);
+
     /**
      * Mutex protecting m_reconnections.
      */
@@ -11,6 +11,7 @@
 #include <blockfilter.h>
 #include <chainparams.h>
 #include <consensus/amount.h>
+#include <consensus/hybrid.h>
 #include <consensus/validation.h>
 #include <deploymentstatus.h>
 #include <hash.h>
@@ -165,6 +166,9 @@ static constexpr double MAX_ADDR_RATE_PER_SECOND{0.1};
 static constexpr size_t MAX_ADDR_PROCESSING_TOKEN_BUCKET{MAX_ADDR_TO_SEND};
 /** The compactblocks version we support. See BIP 152. */
 static constexpr uint64_t CMPCTBLOCKS_VERSION{2};
+/** Interval between checkpoint vote broadcasts. Votes received in between
+ *  are relayed as one merged vote set per checkpoint. */
+static constexpr auto CHECKPOINT_VOTES_BROADCAST_INTERVAL{1s};
 
 // Internal stuff
 namespace {
@@ -493,7 +497,7 @@ public:
     void FinalizeNode(const CNode& node) override EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_headers_presync_mutex, !m_tx_download_mutex);
     bool HasAllDesirableServiceFlags(ServiceFlags services) const override;
     bool ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt) override
-        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_most_recent_block_mutex, !m_headers_presync_mutex, g_msgproc_mutex, !m_tx_download_mutex);
+        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_most_recent_block_mutex, !m_headers_presync_mutex, g_msgproc_mutex, !m_tx_download_mutex, !m_checkpoint_votes_mutex);
     bool SendMessages(CNode* pto) override
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_most_recent_block_mutex, g_msgproc_mutex, !m_tx_download_mutex);
 
@@ -507,6 +511,7 @@ public:
     PeerManagerInfo GetInfo() const override EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
     void SendPings() override EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
     void RelayTransaction(const uint256& txid, const uint256& wtxid) override EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
+    void RelayCheckpointVotes(const uint256& checkpoint_hash) override EXCLUSIVE_LOCKS_REQUIRED(!m_checkpoint_votes_mutex);
     void SetBestBlock(int height, std::chrono::seconds time) override
     {
         m_best_height = height;
@@ -515,7 +520,7 @@ public:
     void UnitTestMisbehaving(NodeId peer_id) override EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex) { Misbehaving(*Assert(GetPeerRef(peer_id)), ""); };
     void ProcessMessage(CNode& pfrom, const std::string& msg_type, DataStream& vRecv,
                         const std::chrono::microseconds time_received, const std::atomic<bool>& interruptMsgProc) override
-        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_most_recent_block_mutex, !m_headers_presync_mutex, g_msgproc_mutex, !m_tx_download_mutex);
+        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex, !m_most_recent_block_mutex, !m_headers_presync_mutex, g_msgproc_mutex, !m_tx_download_mutex, !m_checkpoint_votes_mutex);
     void UpdateLastBlockAnnounceTime(NodeId node, int64_t time_in_seconds) override;
     ServiceFlags GetDesirableServiceFlags(ServiceFlags services) const override;
 
@@ -529,6 +534,9 @@ private:
     /** Retrieve unbroadcast transactions from the mempool and reattempt sending to peers */
     void ReattemptInitialBroadcast(CScheduler& scheduler) EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
 
+    /** Send the merged votes of every checkpoint queued for relay to all peers */
+    void BroadcastCheckpointVotes() EXCLUSIVE_LOCKS_REQUIRED(!m_checkpoint_votes_mutex, !m_peer_mutex);
+
     /** Get a shared pointer to the Peer object.
      *  May return an empty shared_ptr if the Peer object can't be found. */
     PeerRef GetPeerRef(NodeId id) const EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
@@ -821,6 +829,13 @@ private:
                                                 std::chrono::seconds average_interval) EXCLUSIVE_LOCKS_REQUIRED(g_msgproc_mutex);
 
 
+    Mutex m_checkpoint_votes_mutex;
+    /** Hashes of checkpoint vote sets recently received or sent, so that
+     *  copies arriving from other peers are dropped before verification. */
+    CRollingBloomFilter m_recent_checkpoint_votes GUARDED_BY(m_checkpoint_votes_mutex){1000, 0.000001};
+    /** Checkpoints with new votes since the last checkpoint vote broadcast */
+    std::set<uint256> m_checkpoint_votes_to_relay GUARDED_BY(m_checkpoint_votes_mutex);
+
     // All of the following cache a recent block, and are protected by m_most_recent_block_mutex
     Mutex m_most_recent_block_mutex;
     std::shared_ptr<const CBlock> m_most_recent_block GUARDED_BY(m_most_recent_block_mutex);
@@ -1917,6 +1932,8 @@ void PeerManagerImpl::StartScheduledTasks(CScheduler& scheduler)
     // schedule next run for 10-15 minutes in the future
     const auto delta = 10min + FastRandomContext().randrange<std::chrono::milliseconds>(5min);
     scheduler.scheduleFromNow([&] { ReattemptInitialBroadcast(scheduler); }, delta);
+
+    scheduler.scheduleEvery([this] { BroadcastCheckpointVotes(); }, CHECKPOINT_VOTES_BROADCAST_INTERVAL);
 }
 
 void PeerManagerImpl::ActiveTipChange(const CBlockIndex& new_tip, bool is_ibd)
@@ -2142,6 +2159,40 @@ void PeerManagerImpl::RelayTransaction(const uint256& txid, const uint256& wtxid
     };
 }
 
+void PeerManagerImpl::RelayCheckpointVotes(const uint256& checkpoint_hash)
+{
+    LOCK(m_checkpoint_votes_mutex);
+    m_checkpoint_votes_to_relay.insert(checkpoint_hash);
+}
+
+void PeerManagerImpl::BroadcastCheckpointVotes()
+{
+    std::set<uint256> checkpoint_hashes;
+    {
+        LOCK(m_checkpoint_votes_mutex);
+        checkpoint_hashes.swap(m_checkpoint_votes_to_relay);
+    }
+
+    for (const uint256& checkpoint_hash : checkpoint_hashes) {
+        const auto votes{consensus::hybrid::GetCheckpointVotes(checkpoint_hash)};
+        if (!votes) continue;
+
+        // Peers echo back what we send them, so our own vote set counts as seen
+        {
+            LOCK(m_checkpoint_votes_mutex);
+            m_recent_checkpoint_votes.insert((HashWriter{} << *votes).GetHash());
+        }
+        m_connman.ForEachNode([&](CNode* pnode) {
+            if (pnode->IsBlockOnlyConn() || pnode->IsFeelerConn() || pnode->IsAddrFetchConn()) return;
+
+            // Only peers that both sides signalled NODE_CHECKPOINT_VOTES to get votes
+            const PeerRef peer{GetPeerRef(pnode->GetId())};
+            if (!peer || !(peer->m_our_services & peer->m_their_services & NODE_CHECKPOINT_VOTES)) return;
+            MakeAndPushMessage(*pnode, NetMsgType::CHECKPOINTVOTES, *votes);
+        });
+    }
+}
+
 void PeerManagerImpl::RelayAddress(NodeId originator,
                                    const CAddress& addr,
                                    bool fReachable)
@@ -4868,6 +4919,52 @@ void PeerManagerImpl::ProcessMessage(CNode& pfrom, const std::string& msg_type,
         return;
     }
 
+    if (msg_type == NetMsgType::CHECKPOINTVOTES) {
+        consensus::hybrid::CheckpointVoteSet votes;
+        vRecv >> votes;
+
+        // Votes can only be checked against the committee of a known block.
+        // Peers may be ahead of us, so votes for other blocks are dropped.
+        bool known_block;
+        {
+            LOCK(::cs_main);
+            const CBlockIndex* pindex{m_chainman.m_blockman.LookupBlockIndex(votes.block_hash)};
+            known_block = pindex && static_cast<uint32_t>(pindex->nHeight) == votes.height;
+        }
+        if (!known_block) {
+            LogDebug(BCLog::NET, "Ignoring checkpoint votes for unknown block %s from peer=%d\n", votes.block_hash.ToString(), pfrom.GetId());
+            return;
+        }
+
+        const uint256 votes_hash{(HashWriter{} << votes).GetHash()};
+        {
+            LOCK(m_checkpoint_votes_mutex);
+            if (m_recent_checkpoint_votes.contains(votes_hash)) return;
+            m_recent_checkpoint_votes.insert(votes_hash);
+        }
+
+        // New votes are merged into the set for their checkpoint, which is
+        // relayed at the next broadcast. Votes that do not verify cost the
+        // peer, as honest peers only relay votes they have verified. Votes
+        // for another committee are dropped without penalty, since the
+        // peer's validator view may differ from ours.
+        const auto validator_state{consensus::hybrid::GetValidatorNetworkState()};
+        switch (consensus::hybrid::AddCheckpointVotes(votes, *validator_state)) {
+        case consensus::hybrid::CHECKPOINT_VOTES_INVALID:
+            Misbehaving(*peer, strprintf("invalid checkpoint votes for block %s", votes.block_hash.ToString()));
+            break;
+        case consensus::hybrid::CHECKPOINT_VOTES_UNKNOWN_COMMITTEE:
+            LogDebug(BCLog::NET, "Ignoring checkpoint votes for another committee of block %s from peer=%d\n", votes.block_hash.ToString(), pfrom.GetId());
+            break;
+        case consensus::hybrid::CHECKPOINT_VOTES_ADDED:
+            RelayCheckpointVotes(votes.checkpoint_hash);
+            break;
+        case consensus::hybrid::CHECKPOINT_VOTES_UNCHANGED:
+            break;
+        }
+        return;
+    }
+
     if (msg_type == NetMsgType::NOTFOUND) {
         std::vector<CInv> vInv;
         vRecv >> vInv;
@@ -108,6 +108,9 @@ public:
     /** Relay transaction to all peers. */
     virtual void RelayTransaction(const uint256& txid, const uint256& wtxid) = 0;
 
+    /** Relay the merged votes for a checkpoint to all peers, at the next checkpoint vote broadcast. */
+    virtual void RelayCheckpointVotes(const uint256& checkpoint_hash) = 0;
+
     /** Send ping message to all peers */
     virtual void SendPings() = 0;
 
@@ -0,0 +1,138 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/bridgedb.h>
+
+#include <serialize.h>
+
+#include <cstdint>
+#include <utility>
+
+using interop::bridges::AtomicSwap;
+using interop::bridges::BridgeTransfer;
+using interop::bridges::BridgeTransferBatch;
+
+/* Records are stored under [prefix, id]. Index entries have empty values and
+ * keys [prefix, status, id] or [prefix, user, id], so the IDs with a status or
+ * of a user are a single seek and scan over adjacent keys. Spent source
+ * outputs are stored under [prefix, outpoint] with the spending transfer's ID.
+ */
+constexpr uint8_t DB_TRANSFER{'t'};
+constexpr uint8_t DB_TRANSFER_STATUS{'T'};
+constexpr uint8_t DB_TRANSFER_USER{'u'};
+constexpr uint8_t DB_SWAP{'s'};
+constexpr uint8_t DB_SWAP_STATUS{'S'};
+constexpr uint8_t DB_SWAP_USER{'w'};
+constexpr uint8_t DB_TRANSFER_BATCH{'b'};
+constexpr uint8_t DB_SPENT_SOURCE_OUTPOINT{'o'};
+
+namespace {
+
+using StatusKey = std::pair<uint8_t, std::pair<uint8_t, uint256>>;
+using UserKey = std::pair<uint8_t, std::pair<uint256, uint256>>;
+
+/** IDs in the index entries under [prefix, group] */
+template <typename Group>
+std::vector<uint256> ReadIndex(CDBWrapper& db, uint8_t prefix, const Group& group)
+{
+    std::vector<uint256> ids;
+    std::unique_ptr<CDBIterator> it{db.NewIterator()};
+    std::pair<uint8_t, std::pair<Group, uint256>> key;
+    for (it->Seek(std::make_pair(prefix, std::make_pair(group, uint256::ZERO))); it->Valid(); it->Next()) {
+        if (!it->GetKey(key) || key.first != prefix || key.second.first != group) break;
+        ids.push_back(key.second.second);
+    }
+    return ids;
+}
+
+} // namespace
+
+namespace node {
+
+BridgeDB::BridgeDB(DBParams db_params) : m_db{std::make_unique<CDBWrapper>(std::move(db_params))} {}
+
+bool BridgeDB::WriteTransfer(const BridgeTransfer& transfer)
+{
+    CDBBatch batch{*m_db};
+    if (const auto previous = ReadTransfer(transfer.transfer_id)) {
+        batch.Erase(StatusKey{DB_TRANSFER_STATUS, {uint8_t(previous->status), transfer.transfer_id}});
+    }
+    batch.Write(std::make_pair(DB_TRANSFER, transfer.transfer_id), transfer);
+    batch.Write(StatusKey{DB_TRANSFER_STATUS, {uint8_t(transfer.status), transfer.transfer_id}}, "");
+    batch.Write(UserKey{DB_TRANSFER_USER, {transfer.user_id, transfer.transfer_id}}, "");
+    if (!transfer.source_outpoint.IsNull()) {
+        batch.Write(std::make_pair(DB_SPENT_SOURCE_OUTPOINT, transfer.source_outpoint), transfer.transfer_id);
+    }
+    return m_db->WriteBatch(batch);
+}
+
+std::optional<BridgeTransfer> BridgeDB::ReadTransfer(const uint256& transfer_id) const
+{
+    BridgeTransfer transfer;
+    if (!m_db->Read(std::make_pair(DB_TRANSFER, transfer_id), transfer)) return std::nullopt;
+    return transfer;
+}
+
+std::vector<uint256> BridgeDB::GetTransfersWithStatus(BridgeTransfer::Status status) const
+{
+    return ReadIndex(*m_db, DB_TRANSFER_STATUS, uint8_t(status));
+}
+
+std::vector<uint256> BridgeDB::GetUserTransfers(const uint256& user_id) const
+{
+    return ReadIndex(*m_db, DB_TRANSFER_USER, user_id);
+}
+
+bool BridgeDB::WriteSwap(const AtomicSwap& swap)
+{
+    CDBBatch batch{*m_db};
+    if (const auto previous = ReadSwap(swap.swap_id)) {
+        batch.Erase(StatusKey{DB_SWAP_STATUS, {uint8_t(previous->status), swap.swap_id}});
+    }
+    batch.Write(std::make_pair(DB_SWAP, swap.swap_id), swap);
+    batch.Write(StatusKey{DB_SWAP_STATUS, {uint8_t(swap.status), swap.swap_id}}, "");
+    batch.Write(UserKey{DB_SWAP_USER, {swap.initiator_id, swap.swap_id}}, "");
+    if (!swap.participant_id.IsNull()) {
+        batch.Write(UserKey{DB_SWAP_USER, {swap.participant_id, swap.swap_id}}, "");
+    }
+    return m_db->WriteBatch(batch);
+}
+
+std::optional<AtomicSwap> BridgeDB::ReadSwap(const uint256& swap_id) const
+{
+    AtomicSwap swap;
+    if (!m_db->Read(std::make_pair(DB_SWAP, swap_id), swap)) return std::nullopt;
+    return swap;
+}
+
+std::vector<uint256> BridgeDB::GetSwapsWithStatus(AtomicSwap::Status status) const
+{
+    return ReadIndex(*m_db, DB_SWAP_STATUS, uint8_t(status));
+}
+
+std::vector<uint256> BridgeDB::GetUserSwaps(const uint256& user_id) const
+{
+    return ReadIndex(*m_db, DB_SWAP_USER, user_id);
+}
+
+bool BridgeDB::WriteTransferBatch(const BridgeTransferBatch& batch)
+{
+    return m_db->Write(std::make_pair(DB_TRANSFER_BATCH, batch.batch_root), batch);
+}
+
+std::optional<BridgeTransferBatch> BridgeDB::ReadTransferBatch(const uint256& batch_root) const
+{
+    BridgeTransferBatch batch;
+    if (!m_db->Read(std::make_pair(DB_TRANSFER_BATCH, batch_root), batch)) return std::nullopt;
+    return batch;
+}
+
+std::optional<uint256> BridgeDB::ReadSpentSourceOutPoint(const COutPoint& outpoint) const
+{
+    uint256 transfer_id;
+    if (!m_db->Read(std::make_pair(DB_SPENT_SOURCE_OUTPOINT, outpoint), transfer_id)) return std::nullopt;
+    return transfer_id;
+}
+
+} // namespace node
@@ -0,0 +1,48 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BRIDGEDB_H
+#define BITCOIN_NODE_BRIDGEDB_H
+
+#include <dbwrapper.h>
+#include <interop/bridges.h>
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace node {
+
+/**
+ * Bridge transfers, atomic swaps and transfer batches in a leveldb database
+ * (bridges/), with index entries by status and by user, and the source chain
+ * deposit outputs spent by transfers
+ */
+class BridgeDB final : public interop::bridges::BridgeStore
+{
+public:
+    explicit BridgeDB(DBParams db_params);
+
+    bool WriteTransfer(const interop::bridges::BridgeTransfer& transfer) override;
+    std::optional<interop::bridges::BridgeTransfer> ReadTransfer(const uint256& transfer_id) const override;
+    std::vector<uint256> GetTransfersWithStatus(interop::bridges::BridgeTransfer::Status status) const override;
+    std::vector<uint256> GetUserTransfers(const uint256& user_id) const override;
+
+    bool WriteSwap(const interop::bridges::AtomicSwap& swap) override;
+    std::optional<interop::bridges::AtomicSwap> ReadSwap(const uint256& swap_id) const override;
+    std::vector<uint256> GetSwapsWithStatus(interop::bridges::AtomicSwap::Status status) const override;
+    std::vector<uint256> GetUserSwaps(const uint256& user_id) const override;
+
+    bool WriteTransferBatch(const interop::bridges::BridgeTransferBatch& batch) override;
+    std::optional<interop::bridges::BridgeTransferBatch> ReadTransferBatch(const uint256& batch_root) const override;
+
+    std::optional<uint256> ReadSpentSourceOutPoint(const COutPoint& outpoint) const override;
+
+private:
+    std::unique_ptr<CDBWrapper> m_db;
+};
+
+} // namespace node
+
+#endif // BITCOIN_NODE_BRIDGEDB_H
@@ -0,0 +1,92 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/checkpointdb.h>
+
+#include <serialize.h>
+
+
+using consensus::hybrid::CheckpointInfo;
+
+/* Checkpoints are stored under [prefix, ~height (uint32 BE)], so an iterator
+ * walks down from any height: finding the highest checkpoint below a block is
+ * a single seek, and so is erasing the checkpoints above a reorg's fork point.
+ */
+constexpr uint8_t DB_CHECKPOINT{'c'};
+constexpr uint8_t DB_FINALIZED_HEIGHT{'F'};
+
+namespace {
+
+struct DBCheckpointKey {
+    uint8_t prefix{DB_CHECKPOINT};
+    uint32_t height{0};
+
+    DBCheckpointKey() = default;
+    explicit DBCheckpointKey(uint32_t height_in) : height(height_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, prefix);
+        ser_writedata32be(s, ~height);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        prefix = ser_readdata8(s);
+        height = ~ser_readdata32be(s);
+    }
+};
+
+} // namespace
+
+namespace node {
+
+CheckpointDB::CheckpointDB(DBParams db_params) : m_db{std::make_unique<CDBWrapper>(std::move(db_params))} {}
+
+bool CheckpointDB::WriteCheckpoint(const CheckpointInfo& checkpoint)
+{
+    return m_db->Write(DBCheckpointKey{checkpoint.height}, checkpoint, /*fSync=*/true);
+}
+
+bool CheckpointDB::ReadCheckpoint(uint32_t height, CheckpointInfo& checkpoint) const
+{
+    return m_db->Read(DBCheckpointKey{height}, checkpoint);
+}
+
+void CheckpointDB::ForEachCheckpointDown(uint32_t height, const std::function<bool(const CheckpointInfo&)>& fn) const
+{
+    std::unique_ptr<CDBIterator> it{m_db->NewIterator()};
+    DBCheckpointKey key;
+    for (it->Seek(DBCheckpointKey{height}); it->Valid(); it->Next()) {
+        if (!it->GetKey(key) || key.prefix != DB_CHECKPOINT) break;
+        CheckpointInfo checkpoint;
+        if (!it->GetValue(checkpoint) || !fn(checkpoint)) break;
+    }
+}
+
+bool CheckpointDB::EraseCheckpointsAbove(uint32_t height)
+{
+    CDBBatch batch{*m_db};
+    std::unique_ptr<CDBIterator> it{m_db->NewIterator()};
+    DBCheckpointKey key;
+    for (it->Seek(DBCheckpointKey{UINT32_MAX}); it->Valid(); it->Next()) {
+        if (!it->GetKey(key) || key.prefix != DB_CHECKPOINT || key.height <= height) break;
+        batch.Erase(key);
+    }
+    return m_db->WriteBatch(batch, /*fSync=*/true);
+}
+
+bool CheckpointDB::WriteFinalizedHeight(uint32_t height)
+{
+    return m_db->Write(DB_FINALIZED_HEIGHT, height, /*fSync=*/true);
+}
+
+bool CheckpointDB::ReadFinalizedHeight(uint32_t& height) const
+{
+    return m_db->Read(DB_FINALIZED_HEIGHT, height);
+}
+
+} // namespace node
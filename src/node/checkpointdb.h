@@ -0,0 +1,39 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_CHECKPOINTDB_H
+#define BITCOIN_NODE_CHECKPOINTDB_H
+
+#include <consensus/hybrid.h>
+#include <dbwrapper.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace node {
+
+/**
+ * Hybrid consensus checkpoints in a leveldb database (checkpoints/), keyed by
+ * height, together with the height of the finality watermark
+ */
+class CheckpointDB final : public consensus::hybrid::CheckpointStore
+{
+public:
+    explicit CheckpointDB(DBParams db_params);
+
+    bool WriteCheckpoint(const consensus::hybrid::CheckpointInfo& checkpoint) override;
+    bool ReadCheckpoint(uint32_t height, consensus::hybrid::CheckpointInfo& checkpoint) const override;
+    void ForEachCheckpointDown(uint32_t height, const std::function<bool(const consensus::hybrid::CheckpointInfo&)>& fn) const override;
+    bool EraseCheckpointsAbove(uint32_t height) override;
+    bool WriteFinalizedHeight(uint32_t height) override;
+    bool ReadFinalizedHeight(uint32_t& height) const override;
+
+private:
+    std::unique_ptr<CDBWrapper> m_db;
+};
+
+} // namespace node
+
+#endif // BITCOIN_NODE_CHECKPOINTDB_H
@@ -0,0 +1,36 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/contractreceiptdb.h>
+
+#include <serialize.h>
+
+#include <utility>
+
+using smartcontracts::ContractReceipt;
+
+/* Receipts are stored under [prefix, block hash]. Receipts of blocks that are
+ * disconnected are kept, as the block may be connected again.
+ */
+constexpr uint8_t DB_BLOCK_RECEIPTS{'r'};
+
+namespace node {
+
+ContractReceiptDB::ContractReceiptDB(DBParams db_params) : m_db{std::make_unique<CDBWrapper>(std::move(db_params))} {}
+
+bool ContractReceiptDB::WriteReceipts(const uint256& block_hash, const std::vector<ContractReceipt>& receipts)
+{
+    return m_db->Write(std::make_pair(DB_BLOCK_RECEIPTS, block_hash), receipts);
+}
+
+std::optional<std::vector<ContractReceipt>> ContractReceiptDB::ReadReceipts(const uint256& block_hash) const
+{
+    std::vector<ContractReceipt> receipts;
+    if (!m_db->Read(std::make_pair(DB_BLOCK_RECEIPTS, block_hash), receipts)) {
+        return std::nullopt;
+    }
+    return receipts;
+}
+
+} // namespace node
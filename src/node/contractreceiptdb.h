@@ -0,0 +1,35 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_CONTRACTRECEIPTDB_H
+#define BITCOIN_NODE_CONTRACTRECEIPTDB_H
+
+#include <dbwrapper.h>
+#include <smartcontracts/vm.h>
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace node {
+
+/**
+ * Receipts of the contract calls in connected blocks, in a leveldb database
+ * (contractreceipts/) keyed by block hash
+ */
+class ContractReceiptDB final : public smartcontracts::ContractReceiptStore
+{
+public:
+    explicit ContractReceiptDB(DBParams db_params);
+
+    bool WriteReceipts(const uint256& block_hash, const std::vector<smartcontracts::ContractReceipt>& receipts) override;
+    std::optional<std::vector<smartcontracts::ContractReceipt>> ReadReceipts(const uint256& block_hash) const override;
+
+private:
+    std::unique_ptr<CDBWrapper> m_db;
+};
+
+} // namespace node
+
+#endif // BITCOIN_NODE_CONTRACTRECEIPTDB_H
@@ -220,7 +220,7 @@ bool AreInputsStandard(const CTransaction& tx, const CCoinsViewCache& mapInputs)
     return true;
 }
 
-bool IsWitnessStandard(const CTransaction& tx, const CCoinsViewCache& mapInputs)
+bool IsWitnessStandard(const CTransaction& tx, const CCoinsViewCache& mapInputs, bool quantum_active)
 {
     if (tx.IsCoinBase())
         return true; // Coinbases are skipped
@@ -305,6 +305,12 @@ bool IsWitnessStandard(const CTransaction& tx, const CCoinsViewCache& mapInputs)
                 return false;
             }
         }
+
+        // Witness v2 outputs are anyone-can-spend to consensus until the deployment is active, so
+        // relaying spends of them before then would let any miner take the coins.
+        if (witnessversion == 2 && witnessprogram.size() == WITNESS_V2_QUANTUM_SIZE && !p2sh && !quantum_active) {
+            return false;
+        }
     }
     return true;
 }
@@ -99,6 +99,8 @@ static std::string serviceFlagToStr(size_t bit)
     case NODE_COMPACT_FILTERS: return "COMPACT_FILTERS";
     case NODE_NETWORK_LIMITED: return "NETWORK_LIMITED";
     case NODE_P2P_V2:          return "P2P_V2";
+    case NODE_P2P_V2_HYBRID:   return "P2P_V2_HYBRID";
+    case NODE_CHECKPOINT_VOTES: return "CHECKPOINT_VOTES";
     // Not using default, so we get warned when a case is missing
     }
 
@@ -264,6 +264,12 @@ inline constexpr const char* WTXIDRELAY{"wtxidrelay"};
  * txreconciliation, as described by BIP 330.
  */
 inline constexpr const char* SENDTXRCNCL{"sendtxrcncl"};
+/**
+ * Contains a CheckpointVoteSet: the MuSig2 nonces and partial signatures
+ * that validators have contributed to a hybrid consensus checkpoint, merged
+ * by the sender.
+ */
+inline constexpr const char* CHECKPOINTVOTES{"cpvotes"};
 }; // namespace NetMsgType
 
 /** All known message types (see above). Keep this in the same order as the list of messages above. */
@@ -303,6 +309,7 @@ inline const std::array ALL_NET_MESSAGE_TYPES{std::to_array<std::string>({
     NetMsgType::CFCHECKPT,
     NetMsgType::WTXIDRELAY,
     NetMsgType::SENDTXRCNCL,
+    NetMsgType::CHECKPOINTVOTES,
 })};
 
 /** nServices flags */
@@ -329,6 +336,14 @@ enum ServiceFlags : uint64_t {
     // NODE_P2P_V2 means the node supports BIP324 transport
     NODE_P2P_V2 = (1 << 11),
 
+    // NODE_P2P_V2_HYBRID means the node offers and accepts mixing an ML-KEM-768 shared secret into
+    // the BIP324 handshake. Taken from the experimental range below.
+    NODE_P2P_V2_HYBRID = (1 << 24),
+
+    // NODE_CHECKPOINT_VOTES means the node merges and relays hybrid consensus checkpoint votes.
+    // Taken from the experimental range below.
+    NODE_CHECKPOINT_VOTES = (1 << 25),
+
     // Bits 24-31 are reserved for temporary experiments. Just pick a bit that
     // isn't getting used, or one not being used much, and notify the
     // bitcoindecentral-development mailing list. Remember that service bits are just
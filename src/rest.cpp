@@ -14,6 +14,7 @@
 #include <flatfile.h>
 #include <httpserver.h>
 #include <index/blockfilterindex.h>
+#include <index/contracteventindex.h>
 #include <index/txindex.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
@@ -33,6 +34,7 @@
 #include <validation.h>
 
 #include <any>
+#include <set>
 #include <vector>
 
 #include <univalue.h>
@@ -1005,6 +1007,92 @@ static bool rest_blockhash_by_height(const std::any& context, HTTPRequest* req,
     }
 }
 
+static bool rest_contract_events(const std::any& context, HTTPRequest* req, const std::string& str_uri_part)
+{
+    if (!CheckWarmup(req)) return false;
+    std::string param;
+    const RESTResponseFormat rf = ParseDataFormat(param, str_uri_part);
+
+    // request is sent over URI scheme /rest/contractevents/<from_height>/<to_height>.json?address=<hex>,...&topic=<hex>,...
+    std::vector<std::string> uri_parts = SplitString(param, '/');
+    if (uri_parts.size() != 2) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/contractevents/<from_height>/<to_height>.json");
+    }
+
+    int32_t from_height{-1}, to_height{-1};
+    if (!ParseInt32(uri_parts[0], &from_height) || from_height < 0) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid height: " + SanitizeString(uri_parts[0]));
+    }
+    if (!ParseInt32(uri_parts[1], &to_height) || to_height < from_height) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid height: " + SanitizeString(uri_parts[1]));
+    }
+    if (to_height - from_height >= MAX_CONTRACT_EVENT_RANGE) {
+        return RESTERR(req, HTTP_BAD_REQUEST, strprintf("Range exceeds %d blocks", MAX_CONTRACT_EVENT_RANGE));
+    }
+
+    std::set<uint256> addresses, topics;
+    for (const auto& [name, hashes] : {std::pair{"address", &addresses}, std::pair{"topic", &topics}}) {
+        std::string raw_hashes;
+        try {
+            raw_hashes = req->GetQueryParameter(name).value_or("");
+        } catch (const std::runtime_error& e) {
+            return RESTERR(req, HTTP_BAD_REQUEST, e.what());
+        }
+        if (raw_hashes.empty()) continue;
+        for (const std::string& hash_str : SplitString(raw_hashes, ',')) {
+            auto hash{uint256::FromHex(hash_str)};
+            if (!hash) {
+                return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + SanitizeString(hash_str));
+            }
+            hashes->insert(*hash);
+        }
+    }
+
+    if (!g_contract_event_index) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Contract event index is not enabled");
+    }
+
+    const CBlockIndex* stop_index;
+    {
+        ChainstateManager* maybe_chainman = GetChainman(context, req);
+        if (!maybe_chainman) return false;
+        ChainstateManager& chainman = *maybe_chainman;
+        LOCK(cs_main);
+        stop_index = chainman.ActiveChain()[to_height];
+        if (!stop_index) {
+            return RESTERR(req, HTTP_NOT_FOUND, "Block height out of range");
+        }
+    }
+
+    bool index_ready = g_contract_event_index->BlockUntilSyncedToCurrentChain();
+
+    std::vector<IndexedContractEvent> events;
+    if (!g_contract_event_index->LookupEvents(from_height, stop_index, addresses, topics, events)) {
+        std::string errmsg = "Contract events not found.";
+        if (!index_ready) {
+            errmsg += " Contract events are still in the process of being indexed.";
+        } else {
+            errmsg += " This error is unexpected and indicates index corruption.";
+        }
+        return RESTERR(req, HTTP_NOT_FOUND, errmsg);
+    }
+
+    switch (rf) {
+    case RESTResponseFormat::JSON: {
+        UniValue ret(UniValue::VARR);
+        for (const IndexedContractEvent& event : events) {
+            ret.push_back(ContractEventToJSON(event));
+        }
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, ret.write() + "\n");
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not supported (available: json)");
+    }
+    }
+}
+
 static const struct {
     const char* prefix;
     bool (*handler)(const std::any& context, HTTPRequest* req, const std::string& strReq);
@@ -1021,6 +1109,7 @@ static const struct {
       {"/rest/deploymentinfo/", rest_deploymentinfo},
       {"/rest/deploymentinfo", rest_deploymentinfo},
       {"/rest/blockhashbyheight/", rest_blockhash_by_height},
+      {"/rest/contractevents/", rest_contract_events},
 };
 
 void StartREST(const std::any& context)
@@ -13,6 +13,7 @@
 #include <coins.h>
 #include <common/args.h>
 #include <consensus/amount.h>
+#include <consensus/governance.h>
 #include <consensus/params.h>
 #include <consensus/validation.h>
 #include <core_io.h>
@@ -22,6 +23,7 @@
 #include <hash.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
+#include <index/contracteventindex.h>
 #include <interfaces/mining.h>
 #include <kernel/coinstats.h>
 #include <logging/timer.h>
@@ -38,6 +40,7 @@
 #include <rpc/util.h>
 #include <script/descriptor.h>
 #include <serialize.h>
+#include <smartcontracts/snapshot.h>
 #include <streams.h>
 #include <sync.h>
 #include <txdb.h>
@@ -59,6 +62,7 @@
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <set>
 #include <vector>
 
 using kernel::CCoinsStats;
@@ -1408,6 +1412,7 @@ UniValue DeploymentInfo(const CBlockIndex* blockindex, const ChainstateManager&
     SoftForkDescPushBack(blockindex, softforks, chainman, Consensus::DEPLOYMENT_SEGWIT);
     SoftForkDescPushBack(blockindex, softforks, chainman, Consensus::DEPLOYMENT_TESTDUMMY);
     SoftForkDescPushBack(blockindex, softforks, chainman, Consensus::DEPLOYMENT_TAPROOT);
+    SoftForkDescPushBack(blockindex, softforks, chainman, Consensus::DEPLOYMENT_QUANTUM);
     return softforks;
 }
 } // anon namespace
@@ -2909,6 +2914,250 @@ static RPCHelpMan getblockfilter()
     };
 }
 
+static void ContractEventFieldsToJSON(const smartcontracts::ContractEvent& event, UniValue& result)
+{
+    result.pushKV("address", event.contract_address.GetHex());
+    UniValue topics(UniValue::VARR);
+    for (const uint256& topic : event.topics) {
+        topics.push_back(topic.GetHex());
+    }
+    result.pushKV("topics", std::move(topics));
+    result.pushKV("data", HexStr(event.data));
+}
+
+UniValue ContractEventToJSON(const IndexedContractEvent& event)
+{
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("height", event.height);
+    result.pushKV("blockhash", event.block_hash.GetHex());
+    result.pushKV("logindex", event.log_index);
+    result.pushKV("txid", event.event.tx_hash.GetHex());
+    ContractEventFieldsToJSON(event.event, result);
+    return result;
+}
+
+static std::set<uint256> ParseHashSet(const UniValue& param, std::string_view name)
+{
+    std::set<uint256> hashes;
+    if (param.isNull()) return hashes;
+    for (const UniValue& hash : param.get_array().getValues()) {
+        hashes.insert(ParseHashV(hash, name));
+    }
+    return hashes;
+}
+
+static RPCHelpMan getcontractevents()
+{
+    return RPCHelpMan{"getcontractevents",
+                "\nReturn the smart contract events emitted in a range of blocks of the active chain.\n"
+                "Contracts emit events with the OP_LOG0 to OP_LOG4 opcodes; events of failed calls are discarded.\n"
+                "Requires -contracteventindex. Blocks are skipped using per-block address and topic filters.\n",
+                {
+                    {"from_height", RPCArg::Type::NUM, RPCArg::Optional::NO, "First block height to scan"},
+                    {"to_height", RPCArg::Type::NUM, RPCArg::DefaultHint{"chain tip"}, strprintf("Last block height to scan, at most %d blocks after from_height", MAX_CONTRACT_EVENT_RANGE - 1)},
+                    {"addresses", RPCArg::Type::ARR, RPCArg::Default{UniValue::VARR}, "Only return events emitted by these contracts",
+                        {
+                            {"address", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED, "A contract address"},
+                        },
+                    },
+                    {"topics", RPCArg::Type::ARR, RPCArg::Default{UniValue::VARR}, "Only return events with at least one of these topics",
+                        {
+                            {"topic", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED, "An event topic"},
+                        },
+                    },
+                },
+                RPCResult{
+                    RPCResult::Type::ARR, "", "",
+                    {
+                        {RPCResult::Type::OBJ, "", "",
+                        {
+                            {RPCResult::Type::NUM, "height", "The height of the block"},
+                            {RPCResult::Type::STR_HEX, "blockhash", "The hash of the block"},
+                            {RPCResult::Type::NUM, "logindex", "The position of the event in the block"},
+                            {RPCResult::Type::STR_HEX, "txid", "The transaction that emitted the event"},
+                            {RPCResult::Type::STR_HEX, "address", "The emitting contract"},
+                            {RPCResult::Type::ARR, "topics", "", {{RPCResult::Type::STR_HEX, "", "An event topic"}}},
+                            {RPCResult::Type::STR_HEX, "data", "The event payload"},
+                        }},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getcontractevents", "5000 5100") +
+                    HelpExampleRpc("getcontractevents", "5000, 5100")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    if (!g_contract_event_index) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Contract event index is not enabled, use -contracteventindex");
+    }
+
+    const int from_height{request.params[0].getInt<int>()};
+    const std::set<uint256> addresses{ParseHashSet(request.params[2], "address")};
+    const std::set<uint256> topics{ParseHashSet(request.params[3], "topic")};
+
+    const CBlockIndex* stop_index;
+    {
+        ChainstateManager& chainman = EnsureAnyChainman(request.context);
+        LOCK(cs_main);
+        const CChain& active_chain = chainman.ActiveChain();
+        stop_index = request.params[1].isNull() ? active_chain.Tip() : active_chain[request.params[1].getInt<int>()];
+        if (!stop_index) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid to_height");
+        }
+    }
+    if (from_height < 0 || from_height > stop_index->nHeight) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid from_height");
+    }
+    if (stop_index->nHeight - from_height >= MAX_CONTRACT_EVENT_RANGE) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Range exceeds %d blocks", MAX_CONTRACT_EVENT_RANGE));
+    }
+
+    bool index_ready = g_contract_event_index->BlockUntilSyncedToCurrentChain();
+
+    std::vector<IndexedContractEvent> events;
+    if (!g_contract_event_index->LookupEvents(from_height, stop_index, addresses, topics, events)) {
+        if (!index_ready) {
+            throw JSONRPCError(RPC_MISC_ERROR, "Contract events are still in the process of being indexed.");
+        }
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Contract events not found. This error is unexpected and indicates index corruption.");
+    }
+
+    UniValue ret(UniValue::VARR);
+    for (const IndexedContractEvent& event : events) {
+        ret.push_back(ContractEventToJSON(event));
+    }
+    return ret;
+},
+    };
+}
+
+static RPCHelpMan callcontract()
+{
+    return RPCHelpMan{"callcontract",
+                "\nExecute a smart contract call without changing any state, and return its result.\n"
+                "The call runs against a snapshot of the contract state and does not block, or wait for, block connection.\n",
+                {
+                    {"address", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The contract to call"},
+                    {"data", RPCArg::Type::STR_HEX, RPCArg::Default{""}, "The call's input data"},
+                    {"height", RPCArg::Type::NUM, RPCArg::DefaultHint{"current state"}, strprintf("Execute against the state after the block at this height, which must be one of the last %d blocks", smartcontracts::vm::MAX_STATE_SNAPSHOTS)},
+                    {"gas_limit", RPCArg::Type::NUM, RPCArg::DefaultHint{"the governance max_gas_limit parameter"}, "The gas available to the call, which may not exceed the governance max_gas_limit parameter at the execution height"},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::NUM, "height", "The height of the block the state was taken at, or -1 for the current state"},
+                        {RPCResult::Type::NUM, "result", "The contract result code, 0 for success"},
+                        {RPCResult::Type::STR, "error", /*optional=*/true, "The error message, if the call failed"},
+                        {RPCResult::Type::NUM, "gas_used", "The gas the call used"},
+                        {RPCResult::Type::STR_HEX, "return_data", "The data the call returned"},
+                        {RPCResult::Type::ARR, "logs", "The events the call emitted",
+                        {
+                            {RPCResult::Type::OBJ, "", "",
+                            {
+                                {RPCResult::Type::STR_HEX, "address", "The emitting contract"},
+                                {RPCResult::Type::ARR, "topics", "", {{RPCResult::Type::STR_HEX, "", "An event topic"}}},
+                                {RPCResult::Type::STR_HEX, "data", "The event payload"},
+                            }},
+                        }},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("callcontract", "\"00000000000000000000000000000000000000000000000000000000000c0de\"") +
+                    HelpExampleRpc("callcontract", "\"00000000000000000000000000000000000000000000000000000000000c0de\", \"\", 5000")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    smartcontracts::ExecutionContext context;
+    context.contract_address = ParseHashV(request.params[0], "address");
+    if (!request.params[1].isNull()) {
+        context.input_data = ParseHexV(request.params[1], "data");
+    }
+
+    // Snapshots are kept by the VM, so neither cs_main nor the contract state lock is held while executing
+    const auto snapshot = request.params[2].isNull() ? smartcontracts::GetContractStateSnapshot() :
+                                                       smartcontracts::GetContractStateSnapshot(request.params[2].getInt<int>());
+    if (!snapshot) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "No contract state is kept for this height");
+    }
+    if (snapshot->height >= 0) {
+        context.block_height = snapshot->height;
+    } else {
+        ChainstateManager& chainman = EnsureAnyChainman(request.context);
+        context.block_height = std::max(WITH_LOCK(::cs_main, return chainman.ActiveChain().Height()), 0);
+    }
+    context.block_hash = snapshot->block_hash;
+
+    // The limit is a governance parameter, so it is checked as of the execution height rather than against the VM's ceiling
+    const uint64_t max_gas_limit = consensus::governance::GetParameters(context.block_height)->Get(consensus::governance::parameters::MAX_GAS_LIMIT);
+    context.gas_limit = request.params[3].isNull() ? max_gas_limit : request.params[3].getInt<uint64_t>();
+    if (context.gas_limit > max_gas_limit) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("gas_limit exceeds the governance limit of %d", max_gas_limit));
+    }
+
+    const smartcontracts::ExecutionResult result = smartcontracts::SimulateContractCall(*snapshot, context.contract_address, context);
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("height", snapshot->height);
+    ret.pushKV("result", int{result.result_code});
+    if (!result.error_message.empty()) {
+        ret.pushKV("error", result.error_message);
+    }
+    ret.pushKV("gas_used", result.gas_used);
+    ret.pushKV("return_data", HexStr(result.return_data));
+    UniValue logs(UniValue::VARR);
+    for (const smartcontracts::ContractEvent& event : result.logs) {
+        UniValue log(UniValue::VOBJ);
+        ContractEventFieldsToJSON(event, log);
+        logs.push_back(std::move(log));
+    }
+    ret.pushKV("logs", std::move(logs));
+    return ret;
+},
+    };
+}
+
+static RPCHelpMan getcontractproof()
+{
+    return RPCHelpMan{"getcontractproof",
+                "\nReturn a contract storage slot with a proof of its value, or of its absence, against the contract state root.\n",
+                {
+                    {"address", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The contract"},
+                    {"slot", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The storage slot"},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::STR_HEX, "state_root", "The root of the contract state"},
+                        {RPCResult::Type::STR_HEX, "storage_root", "The root of the contract's storage"},
+                        {RPCResult::Type::STR_HEX, "value", "The value of the slot, zero if it is not set"},
+                        {RPCResult::Type::STR_HEX, "proof", "The serialized proof of the contract's account and of the slot"},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getcontractproof", "\"00000000000000000000000000000000000000000000000000000000000c0de\" \"0000000000000000000000000000000000000000000000000000000000000001\"") +
+                    HelpExampleRpc("getcontractproof", "\"00000000000000000000000000000000000000000000000000000000000c0de\", \"0000000000000000000000000000000000000000000000000000000000000001\"")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const uint256 address = ParseHashV(request.params[0], "address");
+    const uint256 slot = ParseHashV(request.params[1], "slot");
+
+    uint256 state_root, value;
+    smartcontracts::ContractStorageProof proof;
+    if (!smartcontracts::GetContractStorageProof(address, slot, state_root, value, proof)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Contract not found");
+    }
+
+    DataStream ss{};
+    ss << proof;
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("state_root", state_root.GetHex());
+    ret.pushKV("storage_root", proof.storage_root.GetHex());
+    ret.pushKV("value", value.GetHex());
+    ret.pushKV("proof", HexStr(ss));
+    return ret;
+},
+    };
+}
+
 /**
  * RAII class that disables the network in its constructor and enables it in its
  * destructor.
@@ -3318,6 +3567,77 @@ const std::vector<RPCResult> RPCHelpForChainstate{
     {RPCResult::Type::BOOL, "validated", "whether the chainstate is fully validated. True if all blocks in the chainstate were validated, false if the chain is based on a snapshot and the snapshot has not yet been validated."},
 };
 
+static RPCHelpMan dumpcontractstate()
+{
+    return RPCHelpMan{
+        "dumpcontractstate",
+        "Write the smart contract state to a snapshot file, which can be loaded on startup with -loadcontractstate.\n",
+        {
+            {"path", RPCArg::Type::STR, RPCArg::Optional::NO, "Path to the output file. If relative, will be prefixed by datadir."},
+        },
+        RPCResult{
+            RPCResult::Type::OBJ, "", "",
+                {
+                    {RPCResult::Type::NUM, "contracts_written", "the number of contracts written in the snapshot"},
+                    {RPCResult::Type::NUM, "codes_written", "the number of distinct contract codes written in the snapshot"},
+                    {RPCResult::Type::STR_HEX, "base_hash", "the hash of the chain tip when the snapshot was written"},
+                    {RPCResult::Type::STR, "path", "the absolute path that the snapshot was written to"},
+                    {RPCResult::Type::STR_HEX, "state_commitment", "the commitment to the contract states"},
+                }
+        },
+        RPCExamples{
+            HelpExampleCli("dumpcontractstate", "contracts.dat") +
+            HelpExampleRpc("dumpcontractstate", "\"contracts.dat\"")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    NodeContext& node = EnsureAnyNodeContext(request.context);
+    const ArgsManager& args{EnsureAnyArgsman(request.context)};
+    const fs::path path = fsbridge::AbsPathJoin(args.GetDataDirNet(), fs::u8path(request.params[0].get_str()));
+    // Write to a temporary path and then move into `path` on completion
+    // to avoid confusion due to an interruption.
+    const fs::path temppath = fsbridge::AbsPathJoin(args.GetDataDirNet(), fs::u8path(request.params[0].get_str() + ".incomplete"));
+
+    if (fs::exists(path)) {
+        throw JSONRPCError(
+            RPC_INVALID_PARAMETER,
+            path.utf8string() + " already exists. If you are sure this is what you want, "
+            "move it out of the way first");
+    }
+
+    AutoFile afile{fsbridge::fopen(temppath, "wb")};
+    if (afile.IsNull()) {
+        throw JSONRPCError(
+            RPC_INVALID_PARAMETER,
+            "Couldn't open file " + temppath.utf8string() + " for writing.");
+    }
+
+    // Blocks execute their contract calls while holding cs_main, so the state
+    // taken under it is the state at the tip
+    uint256 base_hash;
+    std::shared_ptr<const smartcontracts::ContractStateSnapshot> snapshot;
+    {
+        LOCK(::cs_main);
+        base_hash = node.chainman->ActiveChain().Tip()->GetBlockHash();
+        snapshot = smartcontracts::GetContractStateSnapshot();
+    }
+    const smartcontracts::ContractSnapshotMetadata metadata{smartcontracts::WriteContractSnapshot(afile, *snapshot, base_hash)};
+    if (afile.fclose() != 0) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Failed to write " + temppath.utf8string());
+    }
+    fs::rename(temppath, path);
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("contracts_written", metadata.m_contract_count);
+    result.pushKV("codes_written", metadata.m_code_count);
+    result.pushKV("base_hash", metadata.m_base_blockhash.ToString());
+    result.pushKV("path", path.utf8string());
+    result.pushKV("state_commitment", metadata.m_state_commitment.ToString());
+    return result;
+},
+    };
+}
+
 static RPCHelpMan getchainstates()
 {
 return RPCHelpMan{
@@ -3403,7 +3723,11 @@ void RegisterBlockchainRPCCommands(CRPCTable& t)
         {"blockchain", &scanblocks},
         {"blockchain", &getdescriptoractivity},
         {"blockchain", &getblockfilter},
+        {"blockchain", &getcontractevents},
+        {"blockchain", &callcontract},
+        {"blockchain", &getcontractproof},
         {"blockchain", &dumptxoutset},
+        {"blockchain", &dumpcontractstate},
         {"blockchain", &loadtxoutset},
         {"blockchain", &getchainstates},
         {"hidden", &invalidateblock},
@@ -20,6 +20,7 @@ class CBlock;
 class CBlockIndex;
 class Chainstate;
 class UniValue;
+struct IndexedContractEvent;
 namespace node {
 class BlockManager;
 struct NodeContext;
@@ -55,6 +56,9 @@ UniValue CreateUTXOSnapshot(
     const fs::path& path,
     const fs::path& tmppath);
 
+/** Contract event to JSON */
+UniValue ContractEventToJSON(const IndexedContractEvent& event);
+
 //! Return height of highest block that has been pruned, or std::nullopt if no blocks have been pruned
 std::optional<int> GetPruneHeight(const node::BlockManager& blockman, const CChain& chain) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 void CheckBlockDataAvailability(node::BlockManager& blockman, const CBlockIndex& blockindex, bool check_for_undo) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
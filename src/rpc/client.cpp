@@ -92,6 +92,12 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "scanblocks", 3, "stop_height" },
     { "scanblocks", 5, "options" },
     { "scanblocks", 5, "filter_false_positives" },
+    { "callcontract", 2, "height" },
+    { "callcontract", 3, "gas_limit" },
+    { "getcontractevents", 0, "from_height" },
+    { "getcontractevents", 1, "to_height" },
+    { "getcontractevents", 2, "addresses" },
+    { "getcontractevents", 3, "topics" },
     { "getdescriptoractivity", 0, "blockhashes" },
     { "getdescriptoractivity", 1, "scanobjects" },
     { "getdescriptoractivity", 2, "include_mempool" },
@@ -5,6 +5,7 @@
 
 #include <script/interpreter.h>
 
+#include <crypto/mldsa.h>
 #include <crypto/ripemd160.h>
 #include <crypto/sha1.h>
 #include <crypto/sha256.h>
@@ -397,7 +398,8 @@ static bool EvalChecksig(const valtype& sig, const valtype& pubkey, CScript::con
     case SigVersion::TAPSCRIPT:
         return EvalChecksigTapscript(sig, pubkey, execdata, flags, checker, sigversion, serror, success);
     case SigVersion::TAPROOT:
-        // Key path spending in Taproot has no script, so this is unreachable.
+    case SigVersion::QUANTUM:
+        // Key path spending in Taproot and witness v2 spending have no script, so this is unreachable.
         break;
     }
     assert(false);
@@ -1411,11 +1413,12 @@ void PrecomputedTransactionData::Init(const T& txTo, std::vector<CTxOut>&& spent
     for (size_t inpos = 0; inpos < txTo.vin.size() && !(uses_bip143_segwit && uses_bip341_taproot); ++inpos) {
         if (!txTo.vin[inpos].scriptWitness.IsNull()) {
             if (m_spent_outputs_ready && m_spent_outputs[inpos].scriptPubKey.size() == 2 + WITNESS_V1_TAPROOT_SIZE &&
-                m_spent_outputs[inpos].scriptPubKey[0] == OP_1) {
+                (m_spent_outputs[inpos].scriptPubKey[0] == OP_1 || m_spent_outputs[inpos].scriptPubKey[0] == OP_2)) {
                 // Treat every witness-bearing spend with 34-byte scriptPubKey that starts with OP_1 as a Taproot
                 // spend. This only works if spent_outputs was provided as well, but if it wasn't, actual validation
                 // will fail anyway. Note that this branch may trigger for scriptPubKeys that aren't actually segwit
-                // but in that case validation will fail as SCRIPT_ERR_WITNESS_UNEXPECTED anyway.
+                // but in that case validation will fail as SCRIPT_ERR_WITNESS_UNEXPECTED anyway. Witness v2 spends
+                // (starting with OP_2) sign the same BIP341 message, so they need the same precomputation.
                 uses_bip341_taproot = true;
             } else {
                 // Treat every spend that's not known to native witness v1 as a Witness v0 spend. This branch may
@@ -1491,6 +1494,12 @@ bool SignatureHashSchnorr(uint256& hash_out, ScriptExecutionData& execdata, cons
         // request a different key_version with a new sigversion.
         key_version = 0;
         break;
+    case SigVersion::QUANTUM:
+        // Witness v2 signatures commit to the same data as a Taproot key path spend, under an
+        // ext_flag of their own so that they can never be valid for another spend type.
+        ext_flag = 2;
+        // key_version is not used and left uninitialized.
+        break;
     default:
         assert(false);
     }
@@ -1644,6 +1653,12 @@ bool GenericTransactionSignatureChecker<T>::VerifySchnorrSignature(Span<const un
     return pubkey.VerifySchnorr(sighash, sig);
 }
 
+template <class T>
+bool GenericTransactionSignatureChecker<T>::VerifyQuantumSignature(mldsa::ParameterSet params, Span<const unsigned char> sig, Span<const unsigned char> pubkey, const uint256& sighash) const
+{
+    return mldsa::Verify(params, pubkey, sighash, {}, sig);
+}
+
 template <class T>
 bool GenericTransactionSignatureChecker<T>::CheckECDSASignature(const std::vector<unsigned char>& vchSigIn, const std::vector<unsigned char>& vchPubKey, const CScript& scriptCode, SigVersion sigversion) const
 {
@@ -1697,6 +1712,33 @@ bool GenericTransactionSignatureChecker<T>::CheckSchnorrSignature(Span<const uns
     return true;
 }
 
+template <class T>
+bool GenericTransactionSignatureChecker<T>::CheckQuantumSignature(Span<const unsigned char> sig, Span<const unsigned char> pubkey, SigVersion sigversion, ScriptExecutionData& execdata, ScriptError* serror) const
+{
+    assert(sigversion == SigVersion::QUANTUM);
+    // Public keys of unknown parameter sets are upgradable. The caller is responsible for not passing them.
+    const auto params{GetQuantumParameterSet(pubkey.size())};
+    assert(params);
+    // Like Schnorr signatures, ML-DSA signatures may have a hash type other than SIGHASH_DEFAULT appended.
+    const size_t sig_size{mldsa::SignatureSize(*params)};
+    if (sig.size() != sig_size && sig.size() != sig_size + 1) return set_error(serror, SCRIPT_ERR_QUANTUM_SIG_SIZE);
+
+    uint8_t hashtype = SIGHASH_DEFAULT;
+    if (sig.size() == sig_size + 1) {
+        hashtype = SpanPopBack(sig);
+        if (hashtype == SIGHASH_DEFAULT) return set_error(serror, SCRIPT_ERR_QUANTUM_SIG_HASHTYPE);
+    }
+    uint256 sighash;
+    if (!this->txdata) return HandleMissingData(m_mdb);
+    // The message reuses the transaction-wide BIP341 hashes in txdata, so it costs the same small
+    // amount of hashing for every input.
+    if (!SignatureHashSchnorr(sighash, execdata, *txTo, nIn, hashtype, sigversion, *this->txdata, m_mdb)) {
+        return set_error(serror, SCRIPT_ERR_QUANTUM_SIG_HASHTYPE);
+    }
+    if (!VerifyQuantumSignature(*params, sig, pubkey, sighash)) return set_error(serror, SCRIPT_ERR_QUANTUM_SIG);
+    return true;
+}
+
 template <class T>
 bool GenericTransactionSignatureChecker<T>::CheckLockTime(const CScriptNum& nLockTime) const
 {
@@ -1943,6 +1985,32 @@ static bool VerifyWitnessProgram(const CScriptWitness& witness, int witversion,
             }
             return set_success(serror);
         }
+    } else if (witversion == 2 && program.size() == WITNESS_V2_QUANTUM_SIZE && !is_p2sh) {
+        // Post-quantum: 32-byte non-P2SH witness v2 program (which encodes SHA256(ML-DSA public key))
+        if (!(flags & SCRIPT_VERIFY_QUANTUM)) return set_success(serror);
+        if (stack.size() == 0) return set_error(serror, SCRIPT_ERR_WITNESS_PROGRAM_WITNESS_EMPTY);
+        if (stack.size() != 2) {
+            return set_error(serror, SCRIPT_ERR_WITNESS_PROGRAM_MISMATCH); // 2 items in witness
+        }
+        const valtype& pubkey = stack[1];
+        uint256 hash_pubkey;
+        CSHA256().Write(pubkey.data(), pubkey.size()).Finalize(hash_pubkey.begin());
+        if (memcmp(hash_pubkey.begin(), program.data(), 32)) {
+            return set_error(serror, SCRIPT_ERR_WITNESS_PROGRAM_MISMATCH);
+        }
+        if (!GetQuantumParameterSet(pubkey.size())) {
+            // Public keys of other sizes are left for future parameter sets.
+            if (flags & SCRIPT_VERIFY_DISCOURAGE_UPGRADABLE_PUBKEYTYPE) {
+                return set_error(serror, SCRIPT_ERR_DISCOURAGE_UPGRADABLE_PUBKEYTYPE);
+            }
+            return set_success(serror);
+        }
+        execdata.m_annex_present = false;
+        execdata.m_annex_init = true;
+        if (!checker.CheckQuantumSignature(stack[0], pubkey, SigVersion::QUANTUM, execdata, serror)) {
+            return false; // serror is set
+        }
+        return set_success(serror);
     } else if (!is_p2sh && CScript::IsPayToAnchor(witversion, program)) {
         return true;
     } else {
@@ -2076,7 +2144,7 @@ bool VerifyScript(const CScript& scriptSig, const CScript& scriptPubKey, const C
     return set_success(serror);
 }
 
-size_t static WitnessSigOps(int witversion, const std::vector<unsigned char>& witprogram, const CScriptWitness& witness)
+size_t static WitnessSigOps(int witversion, const std::vector<unsigned char>& witprogram, const CScriptWitness& witness, unsigned int flags, bool is_p2sh)
 {
     if (witversion == 0) {
         if (witprogram.size() == WITNESS_V0_KEYHASH_SIZE)
@@ -2088,6 +2156,10 @@ size_t static WitnessSigOps(int witversion, const std::vector<unsigned char>& wi
         }
     }
 
+    if (witversion == 2 && witprogram.size() == WITNESS_V2_QUANTUM_SIZE && !is_p2sh && (flags & SCRIPT_VERIFY_QUANTUM) && witness.stack.size() == 2) {
+        if (const auto params{GetQuantumParameterSet(witness.stack[1].size())}) return GetQuantumSigOpCost(*params);
+    }
+
     // Future flags may be implemented here.
     return 0;
 }
@@ -2104,7 +2176,7 @@ size_t CountWitnessSigOps(const CScript& scriptSig, const CScript& scriptPubKey,
     int witnessversion;
     std::vector<unsigned char> witnessprogram;
     if (scriptPubKey.IsWitnessProgram(witnessversion, witnessprogram)) {
-        return WitnessSigOps(witnessversion, witnessprogram, witness ? *witness : witnessEmpty);
+        return WitnessSigOps(witnessversion, witnessprogram, witness ? *witness : witnessEmpty, flags, /*is_p2sh=*/false);
     }
 
     if (scriptPubKey.IsPayToScriptHash() && scriptSig.IsPushOnly()) {
@@ -2116,9 +2188,27 @@ size_t CountWitnessSigOps(const CScript& scriptSig, const CScript& scriptPubKey,
         }
         CScript subscript(data.begin(), data.end());
         if (subscript.IsWitnessProgram(witnessversion, witnessprogram)) {
-            return WitnessSigOps(witnessversion, witnessprogram, witness ? *witness : witnessEmpty);
+            return WitnessSigOps(witnessversion, witnessprogram, witness ? *witness : witnessEmpty, flags, /*is_p2sh=*/true);
         }
     }
 
     return 0;
 }
+
+std::optional<mldsa::ParameterSet> GetQuantumParameterSet(size_t pubkey_size)
+{
+    for (const mldsa::ParameterSet params : {mldsa::ParameterSet::ML_DSA_44, mldsa::ParameterSet::ML_DSA_65, mldsa::ParameterSet::ML_DSA_87}) {
+        if (mldsa::PublicKeySize(params) == pubkey_size) return params;
+    }
+    return std::nullopt;
+}
+
+size_t GetQuantumSigOpCost(mldsa::ParameterSet params)
+{
+    switch (params) {
+    case mldsa::ParameterSet::ML_DSA_44: return 3;
+    case mldsa::ParameterSet::ML_DSA_65: return 5;
+    case mldsa::ParameterSet::ML_DSA_87: return 9;
+    }
+    assert(false);
+}
@@ -111,6 +111,12 @@ std::string ScriptErrorString(const ScriptError serror)
             return "OP_CHECKMULTISIG(VERIFY) is not available in tapscript";
         case SCRIPT_ERR_TAPSCRIPT_MINIMALIF:
             return "OP_IF/NOTIF argument must be minimal in tapscript";
+        case SCRIPT_ERR_QUANTUM_SIG_SIZE:
+            return "Invalid ML-DSA signature size";
+        case SCRIPT_ERR_QUANTUM_SIG_HASHTYPE:
+            return "Invalid ML-DSA signature hash type";
+        case SCRIPT_ERR_QUANTUM_SIG:
+            return "Invalid ML-DSA signature";
         case SCRIPT_ERR_OP_CODESEPARATOR:
             return "Using OP_CODESEPARATOR in non-witness script";
         case SCRIPT_ERR_SIG_FINDANDDELETE:
@@ -78,6 +78,11 @@ typedef enum ScriptError_t
     SCRIPT_ERR_TAPSCRIPT_CHECKMULTISIG,
     SCRIPT_ERR_TAPSCRIPT_MINIMALIF,
 
+    /* Post-quantum witness v2 */
+    SCRIPT_ERR_QUANTUM_SIG_SIZE,
+    SCRIPT_ERR_QUANTUM_SIG_HASHTYPE,
+    SCRIPT_ERR_QUANTUM_SIG,
+
     /* Constant scriptCode */
     SCRIPT_ERR_OP_CODESEPARATOR,
     SCRIPT_ERR_SIG_FINDANDDELETE,
@@ -5,6 +5,7 @@
 
 #include <script/sigcache.h>
 
+#include <crypto/mldsa.h>
 #include <crypto/sha256.h>
 #include <logging.h>
 #include <pubkey.h>
@@ -22,14 +23,17 @@ SignatureCache::SignatureCache(const size_t max_size_bytes)
     uint256 nonce = GetRandHash();
     // We want the nonce to be 64 bytes long to force the hasher to process
     // this chunk, which makes later hash computations more efficient. We
-    // just write our 32-byte entropy, and then pad with 'E' for ECDSA and
-    // 'S' for Schnorr (followed by 0 bytes).
+    // just write our 32-byte entropy, and then pad with 'E' for ECDSA,
+    // 'S' for Schnorr and 'Q' for post-quantum (followed by 0 bytes).
     static constexpr unsigned char PADDING_ECDSA[32] = {'E'};
     static constexpr unsigned char PADDING_SCHNORR[32] = {'S'};
+    static constexpr unsigned char PADDING_QUANTUM[32] = {'Q'};
     m_salted_hasher_ecdsa.Write(nonce.begin(), 32);
     m_salted_hasher_ecdsa.Write(PADDING_ECDSA, 32);
     m_salted_hasher_schnorr.Write(nonce.begin(), 32);
     m_salted_hasher_schnorr.Write(PADDING_SCHNORR, 32);
+    m_salted_hasher_quantum.Write(nonce.begin(), 32);
+    m_salted_hasher_quantum.Write(PADDING_QUANTUM, 32);
 
     const auto [num_elems, approx_size_bytes] = setValid.setup_bytes(max_size_bytes);
     LogPrintf("Using %zu MiB out of %zu MiB requested for signature cache, able to store %zu elements\n",
@@ -48,6 +52,17 @@ void SignatureCache::ComputeEntrySchnorr(uint256& entry, const uint256& hash, Sp
     hasher.Write(hash.begin(), 32).Write(pubkey.data(), pubkey.size()).Write(sig.data(), sig.size()).Finalize(entry.begin());
 }
 
+void SignatureCache::ComputeEntryQuantum(uint256& entry, const uint256& hash, mldsa::ParameterSet params, Span<const unsigned char> pubkey, Span<const unsigned char> sig) const
+{
+    const unsigned char params_byte = static_cast<unsigned char>(params);
+    unsigned char pubkey_hash[CSHA256::OUTPUT_SIZE];
+    unsigned char sig_hash[CSHA256::OUTPUT_SIZE];
+    CSHA256().Write(pubkey.data(), pubkey.size()).Finalize(pubkey_hash);
+    CSHA256().Write(sig.data(), sig.size()).Finalize(sig_hash);
+    CSHA256 hasher = m_salted_hasher_quantum;
+    hasher.Write(hash.begin(), 32).Write(&params_byte, 1).Write(pubkey_hash, sizeof(pubkey_hash)).Write(sig_hash, sizeof(sig_hash)).Finalize(entry.begin());
+}
+
 bool SignatureCache::Get(const uint256& entry, const bool erase)
 {
     std::shared_lock<std::shared_mutex> lock(cs_sigcache);
@@ -82,3 +97,19 @@ bool CachingTransactionSignatureChecker::VerifySchnorrSignature(Span<const unsig
     if (store) m_signature_cache.Set(entry);
     return true;
 }
+
+bool CachingTransactionSignatureChecker::VerifyQuantumSignature(mldsa::ParameterSet params, Span<const unsigned char> sig, Span<const unsigned char> pubkey, const uint256& sighash) const
+{
+    return VerifyQuantumSignatureCached(m_signature_cache, params, pubkey, sighash, sig, store);
+}
+
+bool VerifyQuantumSignatureCached(SignatureCache& signature_cache, mldsa::ParameterSet params, Span<const unsigned char> pubkey,
+                                  const uint256& hash, Span<const unsigned char> sig, bool store)
+{
+    uint256 entry;
+    signature_cache.ComputeEntryQuantum(entry, hash, params, pubkey, sig);
+    if (signature_cache.Get(entry, !store)) return true;
+    if (!mldsa::Verify(params, pubkey, hash, {}, sig)) return false;
+    if (store) signature_cache.Set(entry);
+    return true;
+}
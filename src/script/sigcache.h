@@ -7,6 +7,7 @@
 #define BITCOIN_SCRIPT_SIGCACHE_H
 
 #include <consensus/amount.h>
+#include <crypto/mldsa.h>
 #include <crypto/sha256.h>
 #include <cuckoocache.h>
 #include <script/interpreter.h>
@@ -31,9 +32,9 @@ static constexpr size_t DEFAULT_SCRIPT_EXECUTION_CACHE_BYTES{DEFAULT_VALIDATION_
 static_assert(DEFAULT_VALIDATION_CACHE_BYTES == DEFAULT_SIGNATURE_CACHE_BYTES + DEFAULT_SCRIPT_EXECUTION_CACHE_BYTES);
 
 /**
- * Valid signature cache, to avoid doing expensive ECDSA signature checking
- * twice for every transaction (once when accepted into memory pool, and
- * again when accepted into the block chain)
+ * Valid signature cache, to avoid doing expensive ECDSA, Schnorr and
+ * post-quantum signature checking twice for every transaction (once when
+ * accepted into memory pool, and again when accepted into the block chain)
  */
 class SignatureCache
 {
@@ -41,6 +42,9 @@ private:
     //! Entries are SHA256(nonce || 'E' or 'S' || 31 zero bytes || signature hash || public key || signature):
     CSHA256 m_salted_hasher_ecdsa;
     CSHA256 m_salted_hasher_schnorr;
+    //! Post-quantum entries are SHA256(nonce || 'Q' || 31 zero bytes || message hash || parameter set ||
+    //! SHA256(public key) || SHA256(signature)), as keys and signatures run to kilobytes
+    CSHA256 m_salted_hasher_quantum;
     typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
     map_type setValid;
     std::shared_mutex cs_sigcache;
@@ -55,6 +59,8 @@ public:
 
     void ComputeEntrySchnorr(uint256& entry, const uint256 &hash, Span<const unsigned char> sig, const XOnlyPubKey& pubkey) const;
 
+    void ComputeEntryQuantum(uint256& entry, const uint256& hash, mldsa::ParameterSet params, Span<const unsigned char> pubkey, Span<const unsigned char> sig) const;
+
     bool Get(const uint256& entry, const bool erase);
 
     void Set(const uint256& entry);
@@ -71,6 +77,15 @@ public:
 
     bool VerifyECDSASignature(const std::vector<unsigned char>& vchSig, const CPubKey& vchPubKey, const uint256& sighash) const override;
     bool VerifySchnorrSignature(Span<const unsigned char> sig, const XOnlyPubKey& pubkey, const uint256& sighash) const override;
+    bool VerifyQuantumSignature(mldsa::ParameterSet params, Span<const unsigned char> sig, Span<const unsigned char> pubkey, const uint256& sighash) const override;
 };
 
+/**
+ * Verify an ML-DSA signature of hash unless the cache already holds it. Like
+ * CachingTransactionSignatureChecker, a valid signature is added to the cache
+ * if store is set, and a cached one is removed otherwise.
+ */
+bool VerifyQuantumSignatureCached(SignatureCache& signature_cache, mldsa::ParameterSet params, Span<const unsigned char> pubkey,
+                                  const uint256& hash, Span<const unsigned char> sig, bool store);
+
 #endif // BITCOIN_SCRIPT_SIGCACHE_H
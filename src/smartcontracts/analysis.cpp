@@ -0,0 +1,439 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <smartcontracts/analysis.h>
+
+#include <smartcontracts/vm.h>
+
+#include <arith_uint256.h>
+#include <crypto/common.h>
+#include <hash.h>
+#include <logging.h>
+#include <script/script.h>
+#include <tinyformat.h>
+
+#include <algorithm>
+
+namespace smartcontracts {
+
+namespace {
+
+// EVM opcodes that affect control flow or carry immediates
+namespace evm {
+    static const uint8_t STOP = 0x00;
+    static const uint8_t JUMP = 0x56;
+    static const uint8_t JUMPI = 0x57;
+    static const uint8_t JUMPDEST = 0x5b;
+    static const uint8_t PUSH0 = 0x5f;
+    static const uint8_t PUSH32 = 0x7f;
+    static const uint8_t RETURN = 0xf3;
+    static const uint8_t REVERT = 0xfd;
+    static const uint8_t INVALID = 0xfe;
+    static const uint8_t SELFDESTRUCT = 0xff;
+}
+
+struct StackEffect {
+    uint32_t pops;
+    uint32_t pushes;
+};
+
+/**
+ * Stack effect of an enhanced script opcode, as implemented by ExecuteEnhancedScript
+ */
+StackEffect ScriptStackEffect(uint8_t opcode)
+{
+    switch (opcode) {
+        case OP_ADDMOD:
+            return {3, 1};
+        case OP_ECRECOVER:
+            return {4, 1};
+        case OP_KECCAK256:
+        case OP_SLOAD:
+            return {1, 1};
+        case OP_SSTORE:
+            return {2, 0};
+        case OP_LOG0:
+        case OP_LOG1:
+        case OP_LOG2:
+        case OP_LOG3:
+        case OP_LOG4:
+            return {opcode - OP_LOG0 + 1u, 0};
+        default:
+            return {0, 0};
+    }
+}
+
+/**
+ * Stack effect of an EVM opcode (undefined opcodes halt and touch nothing)
+ */
+StackEffect EVMStackEffect(uint8_t opcode)
+{
+    if (opcode >= evm::PUSH0 && opcode <= evm::PUSH32) return {0, 1};
+    if (opcode >= 0x80 && opcode <= 0x8f) return {opcode - 0x7fu, opcode - 0x7eu};  // DUP1-DUP16
+    if (opcode >= 0x90 && opcode <= 0x9f) return {opcode - 0x8eu, opcode - 0x8eu};  // SWAP1-SWAP16
+    if (opcode >= 0xa0 && opcode <= 0xa4) return {opcode - 0x9eu, 0};               // LOG0-LOG4
+
+    switch (opcode) {
+        case 0x01: case 0x02: case 0x03: case 0x04: case 0x05: case 0x06: case 0x07:
+        case 0x0a: case 0x0b: case 0x10: case 0x11: case 0x12: case 0x13: case 0x14:
+        case 0x16: case 0x17: case 0x18: case 0x1a: case 0x1b: case 0x1c: case 0x1d:
+        case 0x20:
+            return {2, 1};
+        case 0x08: case 0x09:
+            return {3, 1};
+        case 0x15: case 0x19: case 0x31: case 0x35: case 0x3b: case 0x3f: case 0x40:
+        case 0x49: case 0x51: case 0x54: case 0x5c:
+            return {1, 1};
+        case 0x30: case 0x32: case 0x33: case 0x34: case 0x36: case 0x38: case 0x3a:
+        case 0x3d: case 0x41: case 0x42: case 0x43: case 0x44: case 0x45: case 0x46:
+        case 0x47: case 0x48: case 0x4a: case 0x58: case 0x59: case 0x5a:
+            return {0, 1};
+        case 0x37: case 0x39: case 0x3e: case 0x5e:
+            return {3, 0};
+        case 0x3c:
+            return {4, 0};
+        case 0x50: case evm::JUMP: case evm::SELFDESTRUCT:
+            return {1, 0};
+        case 0x52: case 0x53: case 0x55: case evm::JUMPI: case 0x5d: case evm::RETURN: case evm::REVERT:
+            return {2, 0};
+        case 0xf0:
+            return {3, 1};
+        case 0xf5:
+            return {4, 1};
+        case 0xf1: case 0xf2:
+            return {7, 1};
+        case 0xf4: case 0xfa:
+            return {6, 1};
+        default:
+            return {0, 0};
+    }
+}
+
+bool IsEVMTerminator(uint8_t opcode)
+{
+    return opcode == evm::STOP || opcode == evm::JUMP || opcode == evm::JUMPI ||
+           opcode == evm::RETURN || opcode == evm::REVERT || opcode == evm::INVALID ||
+           opcode == evm::SELFDESTRUCT;
+}
+
+uint8_t SecondOpcode(SuperInstruction fused)
+{
+    switch (fused) {
+        case SuperInstruction::PUSH_SLOAD:
+        case SuperInstruction::KECCAK256_SLOAD:
+            return OP_SLOAD;
+        case SuperInstruction::NONE:
+            break;
+    }
+    return 0;
+}
+
+bool Fail(CodeAnalysis& analysis, std::string error)
+{
+    analysis.valid = false;
+    analysis.error = std::move(error);
+    return false;
+}
+
+/**
+ * Decode enhanced script: Bitcoin Script pushes become stack words, and
+ * common pairs are fused. Scripts have no jumps, so they form a single block.
+ */
+bool DecodeScript(CodeAnalysis& analysis)
+{
+    const std::vector<uint8_t>& code = analysis.code;
+
+    for (size_t pc = 0; pc < code.size();) {
+        const uint8_t opcode = code[pc];
+        Instruction instr{static_cast<uint32_t>(pc), Instruction::NO_IMMEDIATE,
+                          static_cast<uint32_t>(CalculateGasCost(opcode, {})), opcode, SuperInstruction::NONE};
+        size_t next = pc + 1;
+
+        if (opcode <= OP_PUSHDATA4) {
+            size_t size = opcode;
+            size_t header = 0;
+            if (opcode == OP_PUSHDATA1) header = 1;
+            if (opcode == OP_PUSHDATA2) header = 2;
+            if (opcode == OP_PUSHDATA4) header = 4;
+            if (code.size() - next < header) {
+                return Fail(analysis, "truncated push");
+            }
+            if (header == 1) size = code[next];
+            if (header == 2) size = ReadLE16(&code[next]);
+            if (header == 4) size = ReadLE32(&code[next]);
+            next += header;
+            if (code.size() - next < size) {
+                return Fail(analysis, "truncated push");
+            }
+            if (size > analysis::MAX_PUSH_SIZE) {
+                return Fail(analysis, "push larger than a stack word");
+            }
+
+            // Little-endian, like script numbers and the arith_uint256 view of a word
+            uint256 word;
+            std::copy(code.begin() + next, code.begin() + next + size, word.begin());
+            instr.immediate = analysis.immediates.size();
+            analysis.immediates.push_back(word);
+            next += size;
+        }
+
+        // Fuse with the previous instruction when the pair has a superinstruction
+        if (opcode == OP_SLOAD && !analysis.instructions.empty()) {
+            Instruction& prev = analysis.instructions.back();
+            if (prev.fused == SuperInstruction::NONE) {
+                if (prev.immediate != Instruction::NO_IMMEDIATE) {
+                    prev.fused = SuperInstruction::PUSH_SLOAD;
+                } else if (prev.opcode == OP_KECCAK256) {
+                    prev.fused = SuperInstruction::KECCAK256_SLOAD;
+                }
+                if (prev.fused != SuperInstruction::NONE) {
+                    prev.gas += instr.gas;
+                    pc = next;
+                    continue;
+                }
+            }
+        }
+
+        analysis.instructions.push_back(instr);
+        pc = next;
+    }
+
+    analysis.blocks.push_back({0, static_cast<uint32_t>(analysis.instructions.size()), 0, 0, 0});
+    return true;
+}
+
+/**
+ * Decode EVM bytecode, mark JUMPDESTs outside push data, check every
+ * statically known jump target and split at control flow.
+ */
+bool DecodeEVM(CodeAnalysis& analysis)
+{
+    const std::vector<uint8_t>& code = analysis.code;
+    analysis.jump_destinations.assign(code.size(), false);
+
+    for (size_t pc = 0; pc < code.size();) {
+        const uint8_t opcode = code[pc];
+        Instruction instr{static_cast<uint32_t>(pc), Instruction::NO_IMMEDIATE,
+                          static_cast<uint32_t>(vm::BASE_GAS_PRICE), opcode, SuperInstruction::NONE};
+        size_t next = pc + 1;
+
+        if (opcode >= evm::PUSH0 && opcode <= evm::PUSH32) {
+            // Big-endian immediate; bytes past the end of the code read as zero
+            const size_t size = opcode - evm::PUSH0;
+            uint256 word;
+            for (size_t j = 0; j < size; ++j) {
+                word.data()[size - 1 - j] = next + j < code.size() ? code[next + j] : 0;
+            }
+            instr.immediate = analysis.immediates.size();
+            analysis.immediates.push_back(word);
+            next += size;
+        } else if (opcode == evm::JUMPDEST) {
+            analysis.jump_destinations[pc] = true;
+        }
+
+        analysis.instructions.push_back(instr);
+        pc = next;
+    }
+
+    uint32_t block_begin = 0;
+    for (size_t i = 0; i < analysis.instructions.size(); ++i) {
+        const Instruction& instr = analysis.instructions[i];
+
+        if ((instr.opcode == evm::JUMP || instr.opcode == evm::JUMPI) && i > 0 &&
+            analysis.instructions[i - 1].immediate != Instruction::NO_IMMEDIATE) {
+            const arith_uint256 target = UintToArith256(analysis.immediates[analysis.instructions[i - 1].immediate]);
+            if (target >= code.size() || !analysis.jump_destinations[target.GetLow64()]) {
+                return Fail(analysis, strprintf("invalid jump destination at offset %u", instr.pc));
+            }
+        }
+
+        if (instr.opcode == evm::JUMPDEST && i > block_begin) {
+            analysis.blocks.push_back({block_begin, static_cast<uint32_t>(i), 0, 0, 0});
+            block_begin = i;
+        }
+        if (IsEVMTerminator(instr.opcode)) {
+            analysis.blocks.push_back({block_begin, static_cast<uint32_t>(i + 1), 0, 0, 0});
+            block_begin = i + 1;
+        }
+    }
+    if (block_begin < analysis.instructions.size()) {
+        analysis.blocks.push_back({block_begin, static_cast<uint32_t>(analysis.instructions.size()), 0, 0, 0});
+    }
+
+    return true;
+}
+
+/**
+ * Fill in static gas and stack bounds of every block
+ */
+void ComputeBlockBounds(CodeAnalysis& analysis)
+{
+    const bool is_evm = analysis.vm_type == vm::VM_TYPE_EVM_COMPATIBLE;
+
+    for (BasicBlock& block : analysis.blocks) {
+        int64_t height = 0, lowest = 0, highest = 0;
+        auto apply = [&](uint8_t opcode, bool is_push) {
+            const StackEffect effect = is_push ? StackEffect{0, 1} :
+                                       is_evm ? EVMStackEffect(opcode) : ScriptStackEffect(opcode);
+            height -= effect.pops;
+            lowest = std::min(lowest, height);
+            height += effect.pushes;
+            highest = std::max(highest, height);
+        };
+
+        for (uint32_t i = block.begin; i < block.end; ++i) {
+            const Instruction& instr = analysis.instructions[i];
+            block.static_gas += instr.gas;
+            apply(instr.opcode, instr.immediate != Instruction::NO_IMMEDIATE);
+            if (instr.fused != SuperInstruction::NONE) {
+                apply(SecondOpcode(instr.fused), false);
+            }
+        }
+
+        block.stack_required = static_cast<uint32_t>(-lowest);
+        block.stack_max_growth = static_cast<uint32_t>(highest);
+    }
+}
+
+} // namespace
+
+size_t CodeAnalysis::MemoryUsage() const
+{
+    return sizeof(CodeAnalysis) + error.capacity() + code.capacity() +
+           instructions.capacity() * sizeof(Instruction) +
+           blocks.capacity() * sizeof(BasicBlock) +
+           immediates.capacity() * sizeof(uint256) +
+           jump_destinations.capacity() / 8;
+}
+
+uint256 ComputeCodeHash(Span<const uint8_t> code)
+{
+    return Hash(code);
+}
+
+static std::shared_ptr<const CodeAnalysis> Analyze(const uint256& code_hash, Span<const uint8_t> code, int vm_type)
+{
+    auto analysis = std::make_shared<CodeAnalysis>();
+    analysis->code_hash = code_hash;
+    analysis->vm_type = vm_type;
+    analysis->code.assign(code.begin(), code.end());
+    analysis->valid = true;
+
+    if (code.empty()) {
+        Fail(*analysis, "empty code");
+    } else if (code.size() > vm::MAX_CONTRACT_SIZE) {
+        Fail(*analysis, "code exceeds maximum contract size");
+    } else if (vm_type == vm::VM_TYPE_EVM_COMPATIBLE) {
+        DecodeEVM(*analysis);
+    } else if (vm_type == vm::VM_TYPE_BITCOIN_SCRIPT) {
+        DecodeScript(*analysis);
+    } else {
+        Fail(*analysis, "unknown VM type");
+    }
+
+    if (analysis->valid) {
+        ComputeBlockBounds(*analysis);
+    } else {
+        // Keep only what identifies the code; invalid code is never executed
+        analysis->instructions.clear();
+        analysis->instructions.shrink_to_fit();
+        analysis->immediates.clear();
+        analysis->immediates.shrink_to_fit();
+        analysis->blocks.clear();
+        analysis->jump_destinations.clear();
+        analysis->jump_destinations.shrink_to_fit();
+    }
+
+    return analysis;
+}
+
+std::shared_ptr<const CodeAnalysis> AnalyzeContractCode(Span<const uint8_t> code, int vm_type)
+{
+    return Analyze(ComputeCodeHash(code), code, vm_type);
+}
+
+void CodeAnalysisCache::EvictLocked()
+{
+    while (m_bytes > m_max_bytes && !m_lru.empty()) {
+        m_bytes -= m_lru.back()->MemoryUsage();
+        m_index.erase(m_lru.back()->code_hash);
+        m_lru.pop_back();
+    }
+}
+
+CodeAnalysisCache::Entry CodeAnalysisCache::Get(const uint256& code_hash, int vm_type)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_index.find(code_hash);
+    if (it == m_index.end() || (*it->second)->vm_type != vm_type) {
+        return nullptr;
+    }
+
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return *it->second;
+}
+
+void CodeAnalysisCache::Insert(const Entry& analysis)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_index.find(analysis->code_hash);
+    if (it != m_index.end()) {
+        m_bytes -= (*it->second)->MemoryUsage();
+        m_lru.erase(it->second);
+        m_index.erase(it);
+    }
+
+    m_lru.push_front(analysis);
+    m_index.emplace(analysis->code_hash, m_lru.begin());
+    m_bytes += analysis->MemoryUsage();
+    EvictLocked();
+}
+
+CodeAnalysisCache::Entry CodeAnalysisCache::GetOrAnalyze(const uint256& code_hash, Span<const uint8_t> code, int vm_type)
+{
+    if (Entry cached = Get(code_hash, vm_type)) {
+        return cached;
+    }
+
+    // Analyse without holding the lock; a concurrent miss on the same code
+    // just produces an identical entry
+    Entry analysis = Analyze(code_hash, code, vm_type);
+    Insert(analysis);
+
+    if (!analysis->valid) {
+        LogPrintf("Smart Contracts: Rejected code %s (%s)\n", code_hash.ToString(), analysis->error);
+    }
+
+    return analysis;
+}
+
+size_t CodeAnalysisCache::Size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lru.size();
+}
+
+size_t CodeAnalysisCache::MemoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytes;
+}
+
+void CodeAnalysisCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_lru.clear();
+    m_index.clear();
+    m_bytes = 0;
+}
+
+CodeAnalysisCache& GetCodeAnalysisCache()
+{
+    static CodeAnalysisCache cache(analysis::CODE_ANALYSIS_CACHE_BYTES);
+    return cache;
+}
+
+} // namespace smartcontracts
@@ -0,0 +1,153 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SMARTCONTRACTS_ANALYSIS_H
+#define BITCOIN_SMARTCONTRACTS_ANALYSIS_H
+
+#include <span.h>
+#include <uint256.h>
+#include <util/hasher.h>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Bitcoin Decentral Smart Contract Bytecode Analysis
+ *
+ * Contract code is analysed once, at deploy time or on first call, and the
+ * result is shared by every later execution of the same code:
+ * - Instruction decoding with push data resolved to stack words
+ * - Jump destination validation for EVM-compatible bytecode
+ * - Basic blocks with precomputed static gas and stack bounds
+ * - Superinstructions for common opcode pairs
+ *
+ * Analyses are cached in an LRU keyed by code hash, so popular contracts are
+ * never re-scanned.
+ */
+
+namespace smartcontracts {
+
+/**
+ * Analysis constants
+ */
+namespace analysis {
+    // Memory budget of the shared analysis cache
+    static const size_t CODE_ANALYSIS_CACHE_BYTES = 32 * 1024 * 1024;
+
+    // Maximum stack depth of a contract
+    static const size_t MAX_STACK_SIZE = 1024;
+
+    // Largest push accepted by the word-based script stack
+    static const size_t MAX_PUSH_SIZE = 32;
+}
+
+/**
+ * Fused opcode pairs executed as a single instruction
+ */
+enum class SuperInstruction : uint8_t {
+    NONE = 0,
+    PUSH_SLOAD,                         // PUSH key, SLOAD: load a constant slot
+    KECCAK256_SLOAD,                    // KECCAK256, SLOAD: load a hashed (mapping) slot
+};
+
+/**
+ * Decoded instruction
+ */
+struct Instruction {
+    static const uint32_t NO_IMMEDIATE = 0xffffffff;
+
+    uint32_t pc;                        // Offset of the opcode in the code
+    uint32_t immediate;                 // Index into CodeAnalysis::immediates, or NO_IMMEDIATE
+    uint32_t gas;                       // Static gas, including a fused second opcode
+    uint8_t opcode;                     // Opcode (the first one for superinstructions)
+    SuperInstruction fused;             // Superinstruction, if fused with the next opcode
+};
+
+/**
+ * Straight-line run of instructions with a single entry and exit
+ */
+struct BasicBlock {
+    uint32_t begin;                     // First instruction index
+    uint32_t end;                       // One past the last instruction index
+    uint64_t static_gas;                // Gas charged by the block's opcodes
+    uint32_t stack_required;            // Stack items needed on entry
+    uint32_t stack_max_growth;          // Peak stack growth above the entry height
+};
+
+/**
+ * Result of analysing one piece of contract code
+ */
+struct CodeAnalysis {
+    uint256 code_hash;                  // Hash of the analysed code
+    int vm_type;                        // Virtual machine type
+    bool valid;                         // Whether the code passed validation
+    std::string error;                  // Validation failure reason
+    std::vector<uint8_t> code;          // The analysed code
+    std::vector<Instruction> instructions;
+    std::vector<BasicBlock> blocks;
+    std::vector<uint256> immediates;    // Push data, as stack words
+    std::vector<bool> jump_destinations; // Valid JUMPDEST offsets (EVM only)
+
+    CodeAnalysis() : vm_type(0), valid(false) {}
+
+    /** Approximate heap usage, used to bound the cache. */
+    size_t MemoryUsage() const;
+};
+
+/**
+ * Hash used to identify contract code
+ */
+uint256 ComputeCodeHash(Span<const uint8_t> code);
+
+/**
+ * Decode, validate and split contract code into basic blocks
+ */
+std::shared_ptr<const CodeAnalysis> AnalyzeContractCode(Span<const uint8_t> code, int vm_type);
+
+/**
+ * Thread-safe LRU cache of code analyses, bounded by memory usage
+ */
+class CodeAnalysisCache {
+private:
+    using Entry = std::shared_ptr<const CodeAnalysis>;
+    using LruList = std::list<Entry>;
+
+    mutable std::mutex m_mutex;
+    size_t m_max_bytes;
+    size_t m_bytes{0};
+    LruList m_lru;                      // Most recently used first
+    std::unordered_map<uint256, LruList::iterator, SaltedSipHasher> m_index;
+
+    void EvictLocked();
+
+public:
+    explicit CodeAnalysisCache(size_t max_bytes) : m_max_bytes(max_bytes) {}
+
+    /** Look up an analysis, marking it most recently used. */
+    Entry Get(const uint256& code_hash, int vm_type);
+
+    /** Insert an analysis, evicting least recently used entries as needed. */
+    void Insert(const Entry& analysis);
+
+    /** Return the cached analysis of the code, analysing it on a miss. */
+    Entry GetOrAnalyze(const uint256& code_hash, Span<const uint8_t> code, int vm_type);
+
+    size_t Size() const;
+    size_t MemoryUsage() const;
+    void Clear();
+};
+
+/**
+ * Cache shared by all contract executions
+ */
+CodeAnalysisCache& GetCodeAnalysisCache();
+
+} // namespace smartcontracts
+
+#endif // BITCOIN_SMARTCONTRACTS_ANALYSIS_H
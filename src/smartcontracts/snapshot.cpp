@@ -0,0 +1,231 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <smartcontracts/snapshot.h>
+
+#include <hash.h>
+#include <logging.h>
+#include <smartcontracts/analysis.h>
+#include <streams.h>
+#include <util/translation.h>
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace smartcontracts {
+
+namespace {
+
+/** Hash of one contract, the leaf of the state commitment */
+uint256 ContractLeafHash(const ContractState& state, const uint256& code_hash)
+{
+    HashWriter hasher{};
+    hasher << state.contract_address << code_hash << VARINT(state.balance) << VARINT(state.nonce)
+           << VARINT_MODE(state.vm_type, VarIntMode::NONNEGATIVE_SIGNED) << state.is_active
+           << Using<ContractStorageFormatter>(state.storage);
+    return hasher.GetHash();
+}
+
+uint256 CombineLeafHashes(const std::vector<uint256>& leaves)
+{
+    HashWriter hasher{};
+    for (const uint256& leaf : leaves) {
+        hasher << leaf;
+    }
+    return hasher.GetHash();
+}
+
+uint256 GetCodeHash(const ContractState& state)
+{
+    return state.code_hash.IsNull() ? ComputeCodeHash(state.code) : state.code_hash;
+}
+
+/** Run job(i) for every i < count, spread over up to num_threads threads */
+void ParallelFor(size_t count, int num_threads, const std::function<void(size_t)>& job)
+{
+    const size_t threads = std::min<size_t>(std::max(num_threads, 1), std::max<size_t>(count, 1));
+    if (threads == 1) {
+        for (size_t i = 0; i < count; ++i) job(i);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (size_t i = count * t / threads; i < count * (t + 1) / threads; ++i) job(i);
+        });
+    }
+    for (auto& worker : workers) worker.join();
+}
+
+} // namespace
+
+uint256 ComputeContractStateCommitment(const std::map<uint256, ContractState>& states)
+{
+    std::vector<uint256> leaves;
+    leaves.reserve(states.size());
+    for (const auto& [address, state] : states) {
+        leaves.push_back(ContractLeafHash(state, GetCodeHash(state)));
+    }
+    return CombineLeafHashes(leaves);
+}
+
+ContractSnapshotMetadata WriteContractSnapshot(AutoFile& file, const ContractStateSnapshot& snapshot,
+                                               const uint256& base_blockhash)
+{
+    // Number each distinct code in order of first use
+    std::map<uint256, uint64_t> code_positions;
+    std::vector<const std::vector<uint8_t>*> codes;
+    std::vector<uint64_t> contract_code_positions;
+    std::vector<uint256> leaves;
+    contract_code_positions.reserve(snapshot.contracts.size());
+    leaves.reserve(snapshot.contracts.size());
+    for (const auto& [address, state] : snapshot.contracts) {
+        const uint256 code_hash = GetCodeHash(*state);
+        const auto [it, inserted] = code_positions.emplace(code_hash, codes.size());
+        if (inserted) codes.push_back(&state->code);
+        contract_code_positions.push_back(it->second);
+        leaves.push_back(ContractLeafHash(*state, code_hash));
+    }
+
+    ContractSnapshotMetadata metadata;
+    metadata.m_base_blockhash = base_blockhash;
+    metadata.m_code_count = codes.size();
+    metadata.m_contract_count = snapshot.contracts.size();
+    metadata.m_state_commitment = CombineLeafHashes(leaves);
+
+    file << metadata;
+    for (const auto* code : codes) {
+        file << *code;
+    }
+
+    std::vector<unsigned char> record;
+    size_t i = 0;
+    for (const auto& [address, state] : snapshot.contracts) {
+        record.clear();
+        VectorWriter{record, 0, address, VARINT(contract_code_positions[i++]), VARINT(state->balance), VARINT(state->nonce),
+                     VARINT_MODE(state->vm_type, VarIntMode::NONNEGATIVE_SIGNED), state->is_active,
+                     Using<ContractStorageFormatter>(state->storage)};
+        file << record;
+    }
+
+    LogPrintf("Smart Contracts: Wrote snapshot of %lu contracts (%lu codes) at block %s, commitment %s\n",
+              metadata.m_contract_count, metadata.m_code_count, base_blockhash.ToString(),
+              metadata.m_state_commitment.ToString());
+
+    return metadata;
+}
+
+util::Result<void> LoadContractSnapshot(AutoFile& file, const ContractSnapshotMetadata& metadata,
+                                        const uint256& trusted_commitment, int num_threads)
+{
+    if (metadata.m_state_commitment != trusted_commitment) {
+        return util::Error{Untranslated(strprintf("Contract state snapshot commitment %s does not match the trusted commitment %s",
+                                                  metadata.m_state_commitment.ToString(), trusted_commitment.ToString()))};
+    }
+
+    // Counts come from the file, so nothing is reserved up front
+    std::vector<std::vector<uint8_t>> codes;
+    try {
+        for (uint64_t i = 0; i < metadata.m_code_count; ++i) {
+            file >> codes.emplace_back();
+            if (codes.back().empty() || codes.back().size() > vm::MAX_CONTRACT_SIZE) {
+                return util::Error{Untranslated(strprintf("Contract code %d has invalid size", i))};
+            }
+        }
+    } catch (const std::ios_base::failure& e) {
+        return util::Error{Untranslated(strprintf("Unable to read contract state snapshot: %s", e.what()))};
+    }
+
+    std::vector<uint256> code_hashes(codes.size());
+    ParallelFor(codes.size(), num_threads, [&](size_t i) {
+        code_hashes[i] = ComputeCodeHash(codes[i]);
+    });
+
+    // Records are read, decoded and hashed a batch at a time, so only the
+    // decoded contracts are held in full
+    std::map<uint256, ContractState> contracts;
+    HashWriter commitment{};
+    std::vector<std::vector<unsigned char>> records;
+    std::vector<ContractState> states;
+    std::vector<uint256> leaves;
+    for (uint64_t begin = 0; begin < metadata.m_contract_count; begin += CONTRACT_SNAPSHOT_BATCH_SIZE) {
+        const size_t count = std::min<uint64_t>(CONTRACT_SNAPSHOT_BATCH_SIZE, metadata.m_contract_count - begin);
+        records.resize(count);
+        try {
+            for (auto& record : records) {
+                file >> record;
+            }
+        } catch (const std::ios_base::failure& e) {
+            return util::Error{Untranslated(strprintf("Unable to read contract state snapshot: %s", e.what()))};
+        }
+
+        states.assign(count, ContractState{});
+        leaves.assign(count, uint256{});
+        std::mutex error_mutex;
+        std::optional<std::string> error;
+        ParallelFor(count, num_threads, [&](size_t i) {
+            ContractState& state = states[i];
+            try {
+                SpanReader reader{records[i]};
+                uint64_t code_position;
+                reader >> state.contract_address >> VARINT(code_position) >> VARINT(state.balance) >> VARINT(state.nonce)
+                       >> VARINT_MODE(state.vm_type, VarIntMode::NONNEGATIVE_SIGNED) >> state.is_active
+                       >> Using<ContractStorageFormatter>(state.storage);
+                if (!reader.empty()) {
+                    throw std::ios_base::failure("trailing data");
+                }
+                if (code_position >= codes.size()) {
+                    throw std::ios_base::failure("unknown code");
+                }
+                if (state.vm_type != vm::VM_TYPE_BITCOIN_SCRIPT && state.vm_type != vm::VM_TYPE_EVM_COMPATIBLE) {
+                    throw std::ios_base::failure("unknown VM type");
+                }
+                state.code = codes[code_position];
+                state.code_hash = code_hashes[code_position];
+                leaves[i] = ContractLeafHash(state, state.code_hash);
+
+                // Warm the analysis cache so the first calls after startup do not pay for it
+                GetCodeAnalysisCache().GetOrAnalyze(state.code_hash, state.code, state.vm_type);
+            } catch (const std::exception& e) {
+                // An exception escaping a worker thread would terminate the node
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) error = strprintf("Invalid contract record %d: %s", begin + i, e.what());
+            }
+        });
+        if (error) {
+            return util::Error{Untranslated(*error)};
+        }
+
+        // Records must be in strictly increasing address order, as they are written
+        for (size_t i = 0; i < count; ++i) {
+            if (!contracts.empty() && !(contracts.rbegin()->first < states[i].contract_address)) {
+                return util::Error{Untranslated("Contract state snapshot is not ordered by address")};
+            }
+            commitment << leaves[i];
+            const uint256 address = states[i].contract_address;
+            contracts.emplace_hint(contracts.end(), address, std::move(states[i]));
+        }
+    }
+
+    if (commitment.GetHash() != trusted_commitment) {
+        return util::Error{Untranslated("Contract state snapshot does not match its commitment")};
+    }
+
+    ReplaceAllContractStates(std::move(contracts));
+
+    LogPrintf("Smart Contracts: Loaded snapshot of %lu contracts (%lu codes) at block %s\n",
+              metadata.m_contract_count, metadata.m_code_count, metadata.m_base_blockhash.ToString());
+
+    return {};
+}
+
+} // namespace smartcontracts
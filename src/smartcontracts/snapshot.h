@@ -0,0 +1,123 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SMARTCONTRACTS_SNAPSHOT_H
+#define BITCOIN_SMARTCONTRACTS_SNAPSHOT_H
+
+#include <serialize.h>
+#include <smartcontracts/vm.h>
+#include <tinyformat.h>
+#include <uint256.h>
+#include <util/result.h>
+
+#include <array>
+#include <cstdint>
+#include <map>
+
+class AutoFile;
+
+/**
+ * Contract state snapshots
+ *
+ * A snapshot holds every contract state at a block, so a new node can start
+ * executing contracts from that block instead of replaying every call since
+ * activation. The file is streamed in three parts:
+ *
+ * - ContractSnapshotMetadata
+ * - each distinct contract code once, in order of first use
+ * - one length-prefixed record per contract, ordered by address, that refers
+ *   to its code by position and varint-encodes its balance, nonce and storage
+ *
+ * Records are length-prefixed so they can be decoded and hashed in parallel.
+ * The metadata carries a commitment to the contract states. The loader only
+ * accepts a snapshot whose commitment matches a trusted value, and recomputes
+ * it from the records before replacing any state.
+ */
+
+namespace smartcontracts {
+
+// Contract state snapshot magic bytes
+static constexpr std::array<uint8_t, 6> CONTRACT_SNAPSHOT_MAGIC_BYTES = {'c', 's', 't', 'a', 't', 0xff};
+
+// Number of contract records read from a snapshot file at a time
+static constexpr size_t CONTRACT_SNAPSHOT_BATCH_SIZE{4096};
+
+//! Metadata describing a contract state snapshot. All fields come from an
+//! untrusted file and must be validated before being used.
+class ContractSnapshotMetadata
+{
+    inline static const uint16_t VERSION{1};
+public:
+    //! The block whose contract state this snapshot holds.
+    uint256 m_base_blockhash;
+
+    //! The number of distinct contract codes.
+    uint64_t m_code_count = 0;
+
+    //! The number of contracts.
+    uint64_t m_contract_count = 0;
+
+    //! ComputeContractStateCommitment() of the contracts in the snapshot.
+    uint256 m_state_commitment;
+
+    template <typename Stream>
+    inline void Serialize(Stream& s) const {
+        s << CONTRACT_SNAPSHOT_MAGIC_BYTES;
+        s << VERSION;
+        s << m_base_blockhash;
+        s << m_code_count;
+        s << m_contract_count;
+        s << m_state_commitment;
+    }
+
+    template <typename Stream>
+    inline void Unserialize(Stream& s) {
+        std::array<uint8_t, CONTRACT_SNAPSHOT_MAGIC_BYTES.size()> magic;
+        s >> magic;
+        if (magic != CONTRACT_SNAPSHOT_MAGIC_BYTES) {
+            throw std::ios_base::failure("Invalid contract state snapshot magic bytes.");
+        }
+
+        uint16_t version;
+        s >> version;
+        if (version != VERSION) {
+            throw std::ios_base::failure(strprintf("Version of contract state snapshot %s is not supported.", version));
+        }
+
+        s >> m_base_blockhash;
+        s >> m_code_count;
+        s >> m_contract_count;
+        s >> m_state_commitment;
+    }
+};
+
+/**
+ * Commit to a set of contract states
+ *
+ * Hashes each contract's address, code hash, balance, nonce, VM type, status
+ * and storage, then hashes the per-contract hashes in address order.
+ */
+uint256 ComputeContractStateCommitment(const std::map<uint256, ContractState>& states);
+
+/**
+ * Write the contract states of a VM snapshot, taken at base_blockhash, to a
+ * snapshot file
+ */
+ContractSnapshotMetadata WriteContractSnapshot(AutoFile& file, const ContractStateSnapshot& snapshot,
+                                               const uint256& base_blockhash);
+
+/**
+ * Read the rest of a snapshot file, whose metadata has already been read,
+ * and replace the VM's contract states with its contents if they match the
+ * trusted commitment
+ *
+ * Records are read in batches of CONTRACT_SNAPSHOT_BATCH_SIZE, each decoded
+ * and the code of each contract analysed on up to num_threads threads.
+ */
+util::Result<void> LoadContractSnapshot(AutoFile& file, const ContractSnapshotMetadata& metadata,
+                                        const uint256& trusted_commitment, int num_threads);
+
+} // namespace smartcontracts
+
+#endif // BITCOIN_SMARTCONTRACTS_SNAPSHOT_H
@@ -0,0 +1,287 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <smartcontracts/statetree.h>
+
+#include <smartcontracts/analysis.h>
+#include <smartcontracts/vm.h>
+
+#include <crypto/sha256.h>
+#include <hash.h>
+
+#include <algorithm>
+#include <bit>
+#include <optional>
+
+namespace smartcontracts {
+
+namespace {
+
+/** Position of a key in the tree */
+uint256 KeyPath(const uint256& key)
+{
+    return (HashWriter{} << key).GetSHA256();
+}
+
+/** Bit of a path at a depth, most significant bit of the first byte first */
+bool PathBit(const uint256& path, int depth)
+{
+    return (path.data()[depth / 8] >> (7 - depth % 8)) & 1;
+}
+
+/** The first depth bits of a path, zero-padded */
+uint256 PathPrefix(const uint256& path, int depth)
+{
+    uint256 prefix;
+    std::copy(path.begin(), path.begin() + depth / 8, prefix.begin());
+    if (depth % 8) {
+        prefix.data()[depth / 8] = path.data()[depth / 8] & (0xff << (8 - depth % 8));
+    }
+    return prefix;
+}
+
+uint256 FlipBit(uint256 path, int depth)
+{
+    path.data()[depth / 8] ^= 0x80 >> (depth % 8);
+    return path;
+}
+
+int CommonPrefixLength(const uint256& a, const uint256& b)
+{
+    for (int i = 0; i < 32; ++i) {
+        const uint8_t diff = a.data()[i] ^ b.data()[i];
+        if (diff) return i * 8 + std::countl_zero(diff);
+    }
+    return 256;
+}
+
+uint256 HashPair(const uint256& left, const uint256& right)
+{
+    unsigned char input[64];
+    std::copy(left.begin(), left.end(), input);
+    std::copy(right.begin(), right.end(), input + 32);
+    uint256 hash;
+    SHA256D64(hash.begin(), input, 1);
+    return hash;
+}
+
+/** A tree being updated, with the paths that changed in sorted order */
+struct PendingTree {
+    StateTree* tree;
+    std::vector<uint256> paths;
+    std::vector<int> depths;            // Deepest level to rehash on each path
+};
+
+} // namespace
+
+int StateTree::LeafCount(int depth, const uint256& prefix, const Leaf** leaf) const
+{
+    auto it = m_leaves.lower_bound(prefix);
+    if (it == m_leaves.end() || CommonPrefixLength(it->first, prefix) < depth) return 0;
+    if (leaf) *leaf = &it->second;
+    if (++it == m_leaves.end() || CommonPrefixLength(it->first, prefix) < depth) return 1;
+    return 2;
+}
+
+int StateTree::BranchDepth(const uint256& path) const
+{
+    // The leaves under a node on the path are consecutive, and share fewer
+    // bits with the path the further they are from its position, so the
+    // deepest node holding two leaves holds one of these neighbouring pairs
+    auto depth = [&](std::map<uint256, Leaf>::const_iterator it) {
+        return CommonPrefixLength(it->first, path);
+    };
+    const auto it = m_leaves.lower_bound(path);
+    int branch = -1;
+    if (it != m_leaves.begin()) {
+        const auto left = std::prev(it);
+        if (left != m_leaves.begin()) branch = std::max(branch, depth(std::prev(left)));
+        if (it != m_leaves.end()) branch = std::max(branch, std::min(depth(left), depth(it)));
+    }
+    if (it != m_leaves.end() && std::next(it) != m_leaves.end()) {
+        branch = std::max(branch, depth(std::next(it)));
+    }
+    return branch;
+}
+
+uint256 StateTree::NodeHash(int depth, const uint256& prefix) const
+{
+    const Leaf* leaf{nullptr};
+    switch (LeafCount(depth, prefix, &leaf)) {
+    case 0: return uint256();
+    case 1: return leaf->hash;
+    default: return m_nodes.at({depth, prefix});
+    }
+}
+
+uint256 StateTree::Get(const uint256& key) const
+{
+    auto it = m_leaves.find(KeyPath(key));
+    return it == m_leaves.end() ? uint256() : it->second.value;
+}
+
+void StateTree::Apply(const std::vector<Update>& updates)
+{
+    ApplyAll({{this, updates}});
+}
+
+void StateTree::ApplyAll(const std::vector<std::pair<StateTree*, std::vector<Update>>>& batches)
+{
+    std::vector<PendingTree> pending;
+    std::vector<Leaf*> dirty_leaves;
+    std::vector<unsigned char> input;
+    int max_depth = -1;
+
+    for (const auto& [tree, updates] : batches) {
+        // The last update of each key wins; updates that change nothing are dropped
+        std::map<uint256, const Update*> changes;
+        for (const Update& update : updates) {
+            changes[KeyPath(update.first)] = &update;
+        }
+        PendingTree& tree_update = pending.emplace_back(PendingTree{tree, {}, {}});
+        for (const auto& [path, update] : changes) {
+            auto it = tree->m_leaves.find(path);
+            if (it == tree->m_leaves.end() ? update->second.IsNull() : it->second.value == update->second) continue;
+            tree_update.paths.push_back(path);
+            tree_update.depths.push_back(tree->BranchDepth(path));
+        }
+
+        // Nodes below the branch depth before or after the change are rehashed
+        // or, if they no longer hold two leaves, dropped
+        for (size_t i = 0; i < tree_update.paths.size(); ++i) {
+            const uint256& path = tree_update.paths[i];
+            const Update& update = *changes[path];
+            if (update.second.IsNull()) {
+                tree->m_leaves.erase(path);
+            } else {
+                Leaf& leaf = tree->m_leaves[path];
+                leaf.key = update.first;
+                leaf.value = update.second;
+                dirty_leaves.push_back(&leaf);
+                input.insert(input.end(), path.begin(), path.end());
+                input.insert(input.end(), leaf.value.begin(), leaf.value.end());
+            }
+        }
+        for (size_t i = 0; i < tree_update.paths.size(); ++i) {
+            tree_update.depths[i] = std::max(tree_update.depths[i], tree->BranchDepth(tree_update.paths[i]));
+            max_depth = std::max(max_depth, tree_update.depths[i]);
+        }
+    }
+
+    std::vector<unsigned char> output(dirty_leaves.size() * 32);
+    SHA256D64(output.data(), input.data(), dirty_leaves.size());
+    for (size_t i = 0; i < dirty_leaves.size(); ++i) {
+        std::copy(output.begin() + i * 32, output.begin() + (i + 1) * 32, dirty_leaves[i]->hash.begin());
+    }
+
+    // Rehash bottom up, one level of every tree per SHA256D64 call
+    std::vector<std::pair<StateTree*, uint256>> targets;
+    for (int depth = max_depth; depth >= 0; --depth) {
+        input.clear();
+        targets.clear();
+        for (PendingTree& tree_update : pending) {
+            StateTree& tree = *tree_update.tree;
+            std::optional<uint256> last_prefix;
+            for (size_t i = 0; i < tree_update.paths.size(); ++i) {
+                if (tree_update.depths[i] < depth) continue;
+                const uint256 prefix = PathPrefix(tree_update.paths[i], depth);
+                if (last_prefix == prefix) continue;
+                last_prefix = prefix;
+                if (tree.LeafCount(depth, prefix) < 2) {
+                    tree.m_nodes.erase({depth, prefix});
+                    continue;
+                }
+                const uint256 left = tree.NodeHash(depth + 1, prefix);
+                const uint256 right = tree.NodeHash(depth + 1, FlipBit(prefix, depth));
+                input.insert(input.end(), left.begin(), left.end());
+                input.insert(input.end(), right.begin(), right.end());
+                targets.emplace_back(&tree, prefix);
+            }
+        }
+
+        output.resize(targets.size() * 32);
+        SHA256D64(output.data(), input.data(), targets.size());
+        for (size_t i = 0; i < targets.size(); ++i) {
+            uint256& node = targets[i].first->m_nodes[{depth, targets[i].second}];
+            std::copy(output.begin() + i * 32, output.begin() + (i + 1) * 32, node.begin());
+        }
+    }
+
+    for (PendingTree& tree_update : pending) {
+        tree_update.tree->m_root = tree_update.tree->NodeHash(0, uint256());
+    }
+}
+
+StateTreeProof StateTree::GetProof(const uint256& key) const
+{
+    StateTreeProof proof;
+    const uint256 path = KeyPath(key);
+
+    for (int depth = 0;; ++depth) {
+        const Leaf* leaf{nullptr};
+        if (LeafCount(depth, PathPrefix(path, depth), &leaf) < 2) {
+            if (leaf && leaf->key != key) {
+                proof.leaf_key = leaf->key;
+                proof.leaf_value = leaf->value;
+            }
+            break;
+        }
+        proof.siblings.push_back(NodeHash(depth + 1, FlipBit(PathPrefix(path, depth + 1), depth)));
+    }
+
+    return proof;
+}
+
+bool VerifyStateTreeProof(const uint256& root, const uint256& key, const uint256& value, const StateTreeProof& proof)
+{
+    const uint256 path = KeyPath(key);
+    const int depth = proof.siblings.size();
+    if (depth > 256) return false;
+
+    // Hash of the subtree the proof ends at: the key's own leaf, another leaf
+    // sharing its position, or nothing
+    uint256 hash;
+    if (!value.IsNull()) {
+        if (!proof.leaf_value.IsNull()) return false;
+        hash = HashPair(path, value);
+    } else if (!proof.leaf_value.IsNull()) {
+        const uint256 leaf_path = KeyPath(proof.leaf_key);
+        if (proof.leaf_key == key || CommonPrefixLength(leaf_path, path) < depth) return false;
+        hash = HashPair(leaf_path, proof.leaf_value);
+    }
+
+    for (int i = depth - 1; i >= 0; --i) {
+        hash = PathBit(path, i) ? HashPair(proof.siblings[i], hash) : HashPair(hash, proof.siblings[i]);
+    }
+    return hash == root;
+}
+
+uint256 ComputeContractAccountHash(const ContractState& state, const uint256& storage_root)
+{
+    HashWriter hasher{};
+    hasher << state.contract_address << (state.code_hash.IsNull() ? ComputeCodeHash(state.code) : state.code_hash)
+           << VARINT(state.balance) << VARINT(state.nonce)
+           << VARINT_MODE(state.vm_type, VarIntMode::NONNEGATIVE_SIGNED) << state.is_active << storage_root;
+    return hasher.GetHash();
+}
+
+bool VerifyContractStorageProof(const uint256& state_root, const uint256& contract_address, const uint256& slot,
+                                const uint256& value, const ContractStorageProof& proof)
+{
+    if (!VerifyStateTreeProof(proof.storage_root, slot, value, proof.storage_proof)) {
+        return false;
+    }
+
+    ContractState account;
+    account.contract_address = contract_address;
+    account.code_hash = proof.code_hash;
+    account.balance = proof.balance;
+    account.nonce = proof.nonce;
+    account.vm_type = proof.vm_type;
+    account.is_active = proof.is_active;
+    return VerifyStateTreeProof(state_root, contract_address, ComputeContractAccountHash(account, proof.storage_root),
+                                proof.account_proof);
+}
+
+} // namespace smartcontracts
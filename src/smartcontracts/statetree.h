@@ -0,0 +1,131 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SMARTCONTRACTS_STATETREE_H
+#define BITCOIN_SMARTCONTRACTS_STATETREE_H
+
+#include <serialize.h>
+#include <uint256.h>
+
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+/**
+ * Bitcoin Decentral Authenticated Contract State
+ *
+ * Contract state is committed to by sparse Merkle trees over hashed keys:
+ * - One tree per contract over its storage slots
+ * - One account tree over the contracts, whose leaves commit to each
+ *   contract's code, balance, nonce, status and storage root
+ *
+ * The root of the account tree is the state root. Trees are updated in place
+ * from the keys changed since the last update, so the cost of a block is
+ * proportional to what it touches rather than to the size of the state.
+ * Nodes are hashed with SHA256D64 one tree level at a time, so all dirty
+ * nodes of a level share the multi-way kernels.
+ */
+
+namespace smartcontracts {
+
+struct ContractState;
+
+/**
+ * Proof that a key has a value in a StateTree, or that it has none
+ */
+struct StateTreeProof {
+    std::vector<uint256> siblings;      // Sibling hashes, from the root down
+    uint256 leaf_key;                   // For an absent key, the key whose leaf is in its place
+    uint256 leaf_value;                 // Value of that leaf, or zero if there is none
+
+    SERIALIZE_METHODS(StateTreeProof, obj) { READWRITE(obj.siblings, obj.leaf_key, obj.leaf_value); }
+};
+
+/**
+ * Sparse Merkle tree mapping 256-bit keys to non-zero 256-bit values
+ *
+ * Leaves sit at the path SHA256(key), which attackers cannot choose, and a
+ * subtree holding a single leaf is replaced by that leaf, so the tree is
+ * about log2(size) levels deep. An empty subtree hashes to zero, a leaf to
+ * SHA256D64(path || value) and an inner node to SHA256D64(left || right).
+ * Proofs carry keys rather than paths, so an inner node cannot be passed off
+ * as a leaf.
+ */
+class StateTree
+{
+public:
+    /** A key to set, with a zero value to remove it */
+    using Update = std::pair<uint256, uint256>;
+
+    /** Apply updates to a tree and recompute its root */
+    void Apply(const std::vector<Update>& updates);
+
+    /**
+     * Apply updates to several trees at once, so nodes of all of them are
+     * hashed in the same SHA256D64 calls
+     */
+    static void ApplyAll(const std::vector<std::pair<StateTree*, std::vector<Update>>>& batches);
+
+    uint256 GetRoot() const { return m_root; }
+    size_t size() const { return m_leaves.size(); }
+
+    /** Value of a key, or zero if absent */
+    uint256 Get(const uint256& key) const;
+
+    /** Prove the value of a key, or its absence, against GetRoot() */
+    StateTreeProof GetProof(const uint256& key) const;
+
+private:
+    struct Leaf {
+        uint256 key;
+        uint256 value;
+        uint256 hash;
+    };
+
+    // Leaves by path, and the hashes of inner nodes holding at least two
+    // leaves by depth and path prefix
+    std::map<uint256, Leaf> m_leaves;
+    std::map<std::pair<int, uint256>, uint256> m_nodes;
+    uint256 m_root;
+
+    int LeafCount(int depth, const uint256& prefix, const Leaf** leaf = nullptr) const;
+    int BranchDepth(const uint256& path) const;
+    uint256 NodeHash(int depth, const uint256& prefix) const;
+};
+
+/** Check a proof that key has value (zero for absent) in the tree with root */
+bool VerifyStateTreeProof(const uint256& root, const uint256& key, const uint256& value, const StateTreeProof& proof);
+
+/** Leaf value of a contract in the account tree */
+uint256 ComputeContractAccountHash(const ContractState& state, const uint256& storage_root);
+
+/**
+ * Proof of one storage slot of a contract against the state root
+ */
+struct ContractStorageProof {
+    uint256 code_hash;
+    uint64_t balance{0};
+    uint64_t nonce{0};
+    int vm_type{0};
+    bool is_active{false};
+    uint256 storage_root;
+    StateTreeProof account_proof;       // Contract in the account tree
+    StateTreeProof storage_proof;       // Slot in the contract's storage tree
+
+    SERIALIZE_METHODS(ContractStorageProof, obj)
+    {
+        READWRITE(obj.code_hash, VARINT(obj.balance), VARINT(obj.nonce),
+                  VARINT_MODE(obj.vm_type, VarIntMode::NONNEGATIVE_SIGNED), obj.is_active,
+                  obj.storage_root, obj.account_proof, obj.storage_proof);
+    }
+};
+
+/** Check a proof that a contract's slot has value (zero for absent) under state_root */
+bool VerifyContractStorageProof(const uint256& state_root, const uint256& contract_address, const uint256& slot,
+                                const uint256& value, const ContractStorageProof& proof);
+
+} // namespace smartcontracts
+
+#endif // BITCOIN_SMARTCONTRACTS_STATETREE_H
@@ -0,0 +1,110 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <smartcontracts/storage.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace smartcontracts {
+
+ContractStorage::const_iterator& ContractStorage::const_iterator::operator++()
+{
+    // Pages are never empty, so the next page starts the next key
+    if (++m_it == m_storage->m_pages[m_page].second->end() && ++m_page < m_storage->m_pages.size()) {
+        m_it = m_storage->m_pages[m_page].second->begin();
+    }
+    return *this;
+}
+
+bool ContractStorage::const_iterator::operator==(const const_iterator& other) const
+{
+    if (m_storage != other.m_storage || m_page != other.m_page) return false;
+    return m_page == m_storage->m_pages.size() || m_it == other.m_it;
+}
+
+ContractStorage::const_iterator ContractStorage::begin() const
+{
+    if (m_pages.empty()) return end();
+    return const_iterator{this, 0, m_pages.front().second->begin()};
+}
+
+std::vector<std::pair<uint8_t, std::shared_ptr<ContractStorage::Page>>>::const_iterator ContractStorage::LowerBound(uint8_t index) const
+{
+    return std::lower_bound(m_pages.begin(), m_pages.end(), index,
+                            [](const auto& page, uint8_t i) { return page.first < i; });
+}
+
+ContractStorage::const_iterator ContractStorage::find(const uint256& key) const
+{
+    const auto page_it = LowerBound(PageIndex(key));
+    if (page_it == m_pages.end() || page_it->first != PageIndex(key)) return end();
+    const auto it = page_it->second->find(key);
+    if (it == page_it->second->end()) return end();
+    return const_iterator{this, size_t(page_it - m_pages.begin()), it};
+}
+
+const uint256& ContractStorage::at(const uint256& key) const
+{
+    const auto it = find(key);
+    if (it == end()) {
+        throw std::out_of_range("ContractStorage::at");
+    }
+    return it->second;
+}
+
+ContractStorage::Page& ContractStorage::MutablePage(uint8_t index)
+{
+    auto page_it = m_pages.begin() + (LowerBound(index) - m_pages.begin());
+    if (page_it == m_pages.end() || page_it->first != index) {
+        page_it = m_pages.emplace(page_it, index, std::make_shared<Page>());
+    } else if (page_it->second.use_count() > 1) {
+        // Copies only gain references while this storage is read, which
+        // excludes writing it, so a stale count can only cause an unneeded copy
+        page_it->second = std::make_shared<Page>(*page_it->second);
+    }
+    return *page_it->second;
+}
+
+uint256& ContractStorage::operator[](const uint256& key)
+{
+    Page& page = MutablePage(PageIndex(key));
+    const size_t page_size = page.size();
+    uint256& value = page[key];
+    m_size += page.size() - page_size;
+    return value;
+}
+
+size_t ContractStorage::erase(const uint256& key)
+{
+    // Only copy a shared page when the key is actually there
+    if (find(key) == end()) return 0;
+    const uint8_t index = PageIndex(key);
+    MutablePage(index).erase(key);
+    --m_size;
+    const auto pos = LowerBound(index);
+    if (pos->second->empty()) {
+        m_pages.erase(pos);
+    }
+    return 1;
+}
+
+void ContractStorage::clear()
+{
+    m_pages.clear();
+    m_size = 0;
+}
+
+bool ContractStorage::operator==(const ContractStorage& other) const
+{
+    return m_size == other.m_size && std::equal(begin(), end(), other.begin());
+}
+
+bool ContractStorage::IsPageShared(const uint256& key) const
+{
+    const auto page_it = LowerBound(PageIndex(key));
+    return page_it != m_pages.end() && page_it->first == PageIndex(key) && page_it->second.use_count() > 1;
+}
+
+} // namespace smartcontracts
@@ -0,0 +1,105 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SMARTCONTRACTS_STORAGE_H
+#define BITCOIN_SMARTCONTRACTS_STORAGE_H
+
+#include <uint256.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace smartcontracts {
+
+/**
+ * Key/value storage of one contract, split into pages by the first byte of
+ * the key
+ *
+ * Copies share their pages, and a page is copied only when it is written
+ * while shared. A contract state held by a snapshot can so be copied and
+ * changed by the live state at the cost of the pages a block touches rather
+ * than of the whole storage.
+ *
+ * Iteration visits keys in the same order as std::map<uint256, uint256>.
+ * Reads may run concurrently with each other, and writes need the same
+ * exclusive access as the std::map they replace.
+ */
+class ContractStorage
+{
+public:
+    using Page = std::map<uint256, uint256>;
+    using value_type = Page::value_type;
+
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = ContractStorage::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        const_iterator() = default;
+
+        reference operator*() const { return *m_it; }
+        pointer operator->() const { return &*m_it; }
+        const_iterator& operator++();
+        const_iterator operator++(int)
+        {
+            const_iterator prev{*this};
+            ++*this;
+            return prev;
+        }
+        bool operator==(const const_iterator& other) const;
+
+    private:
+        friend class ContractStorage;
+        const_iterator(const ContractStorage* storage, size_t page, Page::const_iterator it)
+            : m_storage{storage}, m_page{page}, m_it{it} {}
+
+        const ContractStorage* m_storage{nullptr};
+        size_t m_page{0};                   // Index into m_pages, or its size at the end
+        Page::const_iterator m_it;
+    };
+
+    const_iterator begin() const;
+    const_iterator end() const { return const_iterator{this, m_pages.size(), {}}; }
+    const_iterator find(const uint256& key) const;
+    size_t count(const uint256& key) const { return find(key) != end(); }
+    /** Return the value of a key, throwing std::out_of_range if it is absent */
+    const uint256& at(const uint256& key) const;
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    /** Return the value of a key for writing, inserting it if absent */
+    uint256& operator[](const uint256& key);
+    size_t erase(const uint256& key);
+    void clear();
+
+    bool operator==(const ContractStorage& other) const;
+
+    /** Return whether a key's page is shared with another copy, for tests */
+    bool IsPageShared(const uint256& key) const;
+
+private:
+    static uint8_t PageIndex(const uint256& key) { return key.data()[0]; }
+
+    /** Return the position of a page, or where it would be inserted */
+    std::vector<std::pair<uint8_t, std::shared_ptr<Page>>>::const_iterator LowerBound(uint8_t index) const;
+    /** Return a page that no other copy shares, creating it if absent */
+    Page& MutablePage(uint8_t index);
+
+    // Non-empty pages, ordered by index
+    std::vector<std::pair<uint8_t, std::shared_ptr<Page>>> m_pages;
+    size_t m_size{0};
+};
+
+} // namespace smartcontracts
+
+#endif // BITCOIN_SMARTCONTRACTS_STORAGE_H
@@ -1,32 +1,203 @@
 #include <smartcontracts/vm.h>
 
+#include <smartcontracts/analysis.h>
+#include <smartcontracts/statetree.h>
 #include <primitives/transaction.h>
 #include <primitives/block.h>
+#include <consensus/governance.h>
 #include <consensus/params.h>
 #include <logging.h>
 #include <util/time.h>
 #include <hash.h>
 #include <uint256.h>
 #include <arith_uint256.h>
+#include <crypto/common.h>
+#include <crypto/sha3.h>
+#include <pubkey.h>
+#include <script/script.h>
 #include <serialize.h>
+#include <streams.h>
 
 #include <algorithm>
-#include <chrono>
+#include <deque>
 #include <map>
 #include <mutex>
+#include <set>
 #include <stack>
 
 namespace smartcontracts {
 
-// Global smart contract state
-static std::map<uint256, ContractState> g_contract_states;
+// Global smart contract state. Contracts are shared with read-only
+// snapshots and copied before being modified while a snapshot holds them.
+static std::map<uint256, std::shared_ptr<ContractState>> g_contract_states;
 static ContractStats g_contract_stats;
 static std::mutex g_contract_mutex;
 
+// Incremented on every state change; snapshots of the current state are
+// reused until it changes
+static uint64_t g_state_version = 0;
+static std::shared_ptr<const ContractStateSnapshot> g_latest_snapshot;
+
+// Snapshots at recently connected blocks, by increasing height
+static std::deque<std::shared_ptr<const ContractStateSnapshot>> g_block_snapshots;
+
+// Authenticated state: a tree over the storage of each contract and one
+// over the contracts, brought up to date when a state root is needed
+struct DirtyContract {
+    bool rebuild{false};                // Storage was replaced as a whole
+    std::set<uint256> slots;            // Storage slots written since
+};
+static std::map<uint256, StateTree> g_storage_trees;
+static StateTree g_account_tree;
+static std::map<uint256, DirtyContract> g_dirty_contracts;
+
 // Contract execution stack and limits
 static thread_local std::stack<ExecutionContext> g_execution_stack;
 [[maybe_unused]] static thread_local uint64_t g_total_gas_used = 0;
 
+// Events emitted by the contract executing on this thread
+struct EventSink {
+    uint256 tx_hash;
+    std::vector<ContractEvent> events;
+};
+static thread_local EventSink* g_event_sink = nullptr;
+
+// Storage writes of a simulated call, made on top of a snapshot
+struct SimulationState {
+    const ContractStateSnapshot& snapshot;
+    std::map<std::pair<uint256, uint256>, uint256> storage_writes;
+};
+static thread_local SimulationState* g_simulation = nullptr;
+
+// Receipts of connected blocks, read by the contract event index
+static std::unique_ptr<ContractReceiptStore> g_receipt_store;
+
+/**
+ * Return a contract for modification, or nullptr if it does not exist.
+ * Requires g_contract_mutex.
+ */
+static ContractState* MutableContractState(const uint256& contract_address)
+{
+    auto it = g_contract_states.find(contract_address);
+    if (it == g_contract_states.end()) {
+        return nullptr;
+    }
+    
+    // Snapshots only gain references under g_contract_mutex, so a stale
+    // count can only cause an unneeded copy. The copy shares the storage
+    // pages, which are copied only once written.
+    if (it->second.use_count() > 1) {
+        it->second = std::make_shared<ContractState>(*it->second);
+    }
+    ++g_state_version;
+    g_dirty_contracts[contract_address];
+    return it->second.get();
+}
+
+/**
+ * Mark a contract as added, replaced or removed. Requires g_contract_mutex.
+ */
+static void MarkContractReplaced(const uint256& contract_address)
+{
+    DirtyContract& dirty = g_dirty_contracts[contract_address];
+    dirty.rebuild = true;
+    dirty.slots.clear();
+}
+
+/**
+ * Apply the changes since the last call to the state trees and return the
+ * state root. Requires g_contract_mutex.
+ */
+static uint256 CommitStateTrees()
+{
+    if (g_dirty_contracts.empty()) {
+        return g_account_tree.GetRoot();
+    }
+    
+    // Storage trees of all changed contracts are updated together, so each
+    // tree level is hashed in one batch
+    std::vector<std::pair<StateTree*, std::vector<StateTree::Update>>> storage_updates;
+    for (const auto& [address, dirty] : g_dirty_contracts) {
+        auto it = g_contract_states.find(address);
+        if (it == g_contract_states.end()) {
+            g_storage_trees.erase(address);
+            continue;
+        }
+        const ContractStorage& storage = it->second->storage;
+        StateTree& tree = g_storage_trees[address];
+        auto& updates = storage_updates.emplace_back(&tree, std::vector<StateTree::Update>{}).second;
+        if (dirty.rebuild) {
+            tree = StateTree();
+            updates.assign(storage.begin(), storage.end());
+        } else {
+            for (const uint256& slot : dirty.slots) {
+                auto slot_it = storage.find(slot);
+                updates.emplace_back(slot, slot_it == storage.end() ? uint256() : slot_it->second);
+            }
+        }
+    }
+    StateTree::ApplyAll(storage_updates);
+    
+    std::vector<StateTree::Update> account_updates;
+    for (const auto& [address, dirty] : g_dirty_contracts) {
+        auto it = g_contract_states.find(address);
+        if (it == g_contract_states.end()) {
+            account_updates.emplace_back(address, uint256());
+        } else {
+            account_updates.emplace_back(address, ComputeContractAccountHash(*it->second, g_storage_trees[address].GetRoot()));
+        }
+    }
+    g_account_tree.Apply(account_updates);
+    g_dirty_contracts.clear();
+    
+    return g_account_tree.GetRoot();
+}
+
+/**
+ * Take a snapshot of the current state. Requires g_contract_mutex.
+ */
+static std::shared_ptr<const ContractStateSnapshot> SnapshotCurrentState()
+{
+    if (!g_latest_snapshot || g_latest_snapshot->version != g_state_version) {
+        auto snapshot = std::make_shared<ContractStateSnapshot>();
+        snapshot->version = g_state_version;
+        for (const auto& [address, state] : g_contract_states) {
+            snapshot->contracts.emplace_hint(snapshot->contracts.end(), address, state);
+        }
+        g_latest_snapshot = std::move(snapshot);
+    }
+    return g_latest_snapshot;
+}
+
+/**
+ * Execute analysed code, collecting the events it emits
+ */
+static ExecutionResult RunContractCode(const CodeAnalysis& code, const ExecutionContext& context)
+{
+    ExecutionResult result;
+    
+    EventSink* const outer_sink = g_event_sink;
+    EventSink sink{context.tx_hash, {}};
+    g_event_sink = &sink;
+    if (code.vm_type == vm::VM_TYPE_EVM_COMPATIBLE) {
+        result = ExecuteEVMBytecode(code.code, context);
+    } else {
+        result = ExecuteEnhancedScript(code, context);
+    }
+    g_event_sink = outer_sink;
+    
+    // Events of a failed execution are discarded; those of a successful
+    // nested call also belong to its caller
+    if (result.result_code == CONTRACT_SUCCESS) {
+        if (outer_sink) {
+            outer_sink->events.insert(outer_sink->events.end(), sink.events.begin(), sink.events.end());
+        }
+        result.logs = std::move(sink.events);
+    }
+    
+    return result;
+}
+
 bool InitializeSmartContractVM(const Consensus::Params& params)
 {
     std::lock_guard<std::mutex> lock(g_contract_mutex);
@@ -35,13 +206,20 @@ bool InitializeSmartContractVM(const Consensus::Params& params)
     
     // Clear existing state
     g_contract_states.clear();
+    ++g_state_version;
+    g_storage_trees.clear();
+    g_account_tree = StateTree();
+    g_dirty_contracts.clear();
+    g_latest_snapshot.reset();
+    g_block_snapshots.clear();
+    GetCodeAnalysisCache().Clear();
     
     // Initialize statistics
     g_contract_stats = ContractStats();
     g_contract_stats.total_contracts = 0;
     g_contract_stats.total_executions = 0;
     g_contract_stats.total_gas_used = 0;
-    g_contract_stats.average_execution_time = 0;
+    g_contract_stats.average_gas_used = 0;
     g_contract_stats.success_rate = 1.0;
     
     LogPrintf("Smart Contracts: Virtual machine initialization complete\n");
@@ -54,10 +232,12 @@ uint256 DeployContract(const std::vector<uint8_t>& bytecode,
 {
     std::lock_guard<std::mutex> lock(g_contract_mutex);
     
-    // Validate bytecode
-    if (!ValidateContractBytecode(bytecode, vm::VM_TYPE_EVM_COMPATIBLE)) {
+    // Analyse and validate bytecode; executions reuse the cached analysis
+    const uint256 code_hash = ComputeCodeHash(bytecode);
+    const auto analysis = GetCodeAnalysisCache().GetOrAnalyze(code_hash, bytecode, vm::VM_TYPE_EVM_COMPATIBLE);
+    if (!analysis->valid) {
         result.result_code = CONTRACT_EXECUTION_ERROR;
-        result.error_message = "Invalid contract bytecode";
+        result.error_message = "Invalid contract bytecode: " + analysis->error;
         return uint256();
     }
     
@@ -68,13 +248,16 @@ uint256 DeployContract(const std::vector<uint8_t>& bytecode,
     ContractState state;
     state.contract_address = contract_address;
     state.code = bytecode;
+    state.code_hash = code_hash;
     state.balance = context.value;
     state.nonce = 0;
     state.vm_type = vm::VM_TYPE_EVM_COMPATIBLE;
     state.is_active = true;
     
     // Store contract state
-    g_contract_states[contract_address] = state;
+    g_contract_states[contract_address] = std::make_shared<ContractState>(std::move(state));
+    ++g_state_version;
+    MarkContractReplaced(contract_address);
     
     // Update statistics
     g_contract_stats.total_contracts++;
@@ -91,54 +274,62 @@ uint256 DeployContract(const std::vector<uint8_t>& bytecode,
 ExecutionResult ExecuteContract(const uint256& contract_address,
                                const ExecutionContext& context)
 {
-    std::lock_guard<std::mutex> lock(g_contract_mutex);
-    
     ExecutionResult result;
-    auto start_time = std::chrono::steady_clock::now();
     
-    // Find contract state
-    auto it = g_contract_states.find(contract_address);
-    if (it == g_contract_states.end()) {
-        result.result_code = CONTRACT_EXECUTION_ERROR;
-        result.error_message = "Contract not found";
-        return result;
-    }
-    
-    const ContractState& state = it->second;
-    
-    // Check if contract is active
-    if (!state.is_active) {
-        result.result_code = CONTRACT_EXECUTION_ERROR;
-        result.error_message = "Contract is not active";
-        return result;
-    }
-    
-    // Validate execution limits
-    if (!ValidateExecutionLimits(context)) {
-        result.result_code = CONTRACT_EXECUTION_ERROR;
-        result.error_message = "Execution limits exceeded";
-        return result;
+    std::shared_ptr<const CodeAnalysis> code;
+    {
+        std::lock_guard<std::mutex> lock(g_contract_mutex);
+        
+        // Find contract state
+        auto it = g_contract_states.find(contract_address);
+        if (it == g_contract_states.end()) {
+            result.result_code = CONTRACT_EXECUTION_ERROR;
+            result.error_message = "Contract not found";
+            return result;
+        }
+        
+        const ContractState* state = it->second.get();
+        
+        // Check if contract is active
+        if (!state->is_active) {
+            result.result_code = CONTRACT_EXECUTION_ERROR;
+            result.error_message = "Contract is not active";
+            return result;
+        }
+        
+        // Validate execution limits
+        if (!ValidateExecutionLimits(context)) {
+            result.result_code = CONTRACT_EXECUTION_ERROR;
+            result.error_message = "Execution limits exceeded";
+            return result;
+        }
+        
+        if (state->vm_type != vm::VM_TYPE_EVM_COMPATIBLE && state->vm_type != vm::VM_TYPE_BITCOIN_SCRIPT) {
+            result.result_code = CONTRACT_EXECUTION_ERROR;
+            result.error_message = "Unknown VM type";
+            return result;
+        }
+        
+        // Hot contracts hit the analysis cache instead of re-scanning their code.
+        // The state may be shared with snapshots, so the hash is filled in on a copy.
+        if (state->code_hash.IsNull()) {
+            ContractState* mutable_state = MutableContractState(contract_address);
+            mutable_state->code_hash = ComputeCodeHash(mutable_state->code);
+            state = mutable_state;
+        }
+        code = GetCodeAnalysisCache().GetOrAnalyze(state->code_hash, state->code, state->vm_type);
     }
     
-    // Execute based on VM type
-    if (state.vm_type == vm::VM_TYPE_EVM_COMPATIBLE) {
-        result = ExecuteEVMBytecode(state.code, context);
-    } else if (state.vm_type == vm::VM_TYPE_BITCOIN_SCRIPT) {
-        result = ExecuteEnhancedScript(state.code, context);
-    } else {
-        result.result_code = CONTRACT_EXECUTION_ERROR;
-        result.error_message = "Unknown VM type";
-        return result;
-    }
+    // Storage opcodes take g_contract_mutex themselves, so it must not be held here
+    result = RunContractCode(*code, context);
     
-    // Update statistics
-    auto end_time = std::chrono::steady_clock::now();
-    auto execution_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+    // Update statistics. Gas is the only measure of execution cost; wall-clock
+    // time differs between nodes and must not influence consensus.
+    std::lock_guard<std::mutex> lock(g_contract_mutex);
     
     g_contract_stats.total_executions++;
     g_contract_stats.total_gas_used += result.gas_used;
-    g_contract_stats.average_execution_time = 
-        (g_contract_stats.average_execution_time + execution_time.count()) / 2;
+    g_contract_stats.average_gas_used = g_contract_stats.total_gas_used / g_contract_stats.total_executions;
     
     if (result.result_code == CONTRACT_SUCCESS) {
         g_contract_stats.success_rate = 
@@ -150,8 +341,8 @@ ExecutionResult ExecuteContract(const uint256& contract_address,
             g_contract_stats.total_executions;
     }
     
-    LogPrintf("Smart Contracts: Executed contract %s (result: %d, gas: %lu, time: %lu ms)\n",
-              contract_address.ToString(), result.result_code, result.gas_used, execution_time.count());
+    LogPrintf("Smart Contracts: Executed contract %s (result: %d, gas: %lu)\n",
+              contract_address.ToString(), result.result_code, result.gas_used);
     
     return result;
 }
@@ -162,7 +353,7 @@ ContractState GetContractState(const uint256& contract_address)
     
     auto it = g_contract_states.find(contract_address);
     if (it != g_contract_states.end()) {
-        return it->second;
+        return *it->second;
     }
     
     return ContractState(); // Return empty state
@@ -172,44 +363,170 @@ bool UpdateContractState(const uint256& contract_address, const ContractState& s
 {
     std::lock_guard<std::mutex> lock(g_contract_mutex);
     
-    g_contract_states[contract_address] = state;
+    // Replaced rather than modified, so snapshots keep the old state
+    auto stored = std::make_shared<ContractState>(state);
+    stored->code_hash = ComputeCodeHash(stored->code);
+    g_contract_states[contract_address] = std::move(stored);
+    ++g_state_version;
+    MarkContractReplaced(contract_address);
     return true;
 }
 
-bool ValidateContractBytecode(const std::vector<uint8_t>& bytecode, int vm_type)
+std::map<uint256, ContractState> GetAllContractStates()
 {
-    // Check size limits
-    if (bytecode.size() > vm::MAX_CONTRACT_SIZE) {
-        return false;
+    std::lock_guard<std::mutex> lock(g_contract_mutex);
+    
+    std::map<uint256, ContractState> states;
+    for (const auto& [address, state] : g_contract_states) {
+        states.emplace_hint(states.end(), address, *state);
     }
+    return states;
+}
+
+void ReplaceAllContractStates(std::map<uint256, ContractState> states)
+{
+    std::lock_guard<std::mutex> lock(g_contract_mutex);
     
-    // Basic bytecode validation
-    if (bytecode.empty()) {
-        return false;
+    g_contract_states.clear();
+    g_storage_trees.clear();
+    g_account_tree = StateTree();
+    g_dirty_contracts.clear();
+    for (auto& [address, state] : states) {
+        g_contract_states.emplace_hint(g_contract_states.end(), address, std::make_shared<ContractState>(std::move(state)));
+        MarkContractReplaced(address);
+    }
+    ++g_state_version;
+    g_contract_stats.total_contracts = g_contract_states.size();
+}
+
+std::shared_ptr<const ContractState> ContractStateSnapshot::Find(const uint256& contract_address) const
+{
+    auto it = contracts.find(contract_address);
+    return it == contracts.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<const ContractStateSnapshot> GetContractStateSnapshot()
+{
+    std::lock_guard<std::mutex> lock(g_contract_mutex);
+    return SnapshotCurrentState();
+}
+
+std::shared_ptr<const ContractStateSnapshot> GetContractStateSnapshot(int height)
+{
+    std::lock_guard<std::mutex> lock(g_contract_mutex);
+    
+    for (const auto& snapshot : g_block_snapshots) {
+        if (snapshot->height == height) return snapshot;
     }
+    return nullptr;
+}
+
+void PublishContractStateSnapshot(int height, const uint256& block_hash)
+{
+    std::lock_guard<std::mutex> lock(g_contract_mutex);
     
-    // VM-specific validation
-    if (vm_type == vm::VM_TYPE_EVM_COMPATIBLE) {
-        // EVM bytecode validation
-        for (size_t i = 0; i < bytecode.size(); ++i) {
-            [[maybe_unused]] uint8_t opcode = bytecode[i];
+    // Snapshots share the contracts of the current state, so only the map
+    // of contracts is copied
+    auto snapshot = std::make_shared<ContractStateSnapshot>(*SnapshotCurrentState());
+    snapshot->height = height;
+    snapshot->block_hash = block_hash;
+    snapshot->state_root = CommitStateTrees();
+    
+    // A block at an existing height replaces the stale chain from there
+    while (!g_block_snapshots.empty() && g_block_snapshots.back()->height >= height) {
+        g_block_snapshots.pop_back();
+    }
+    g_block_snapshots.push_back(std::move(snapshot));
+    while (g_block_snapshots.size() > vm::MAX_STATE_SNAPSHOTS) {
+        g_block_snapshots.pop_front();
+    }
+}
 
-        }
-    } else if (vm_type == vm::VM_TYPE_BITCOIN_SCRIPT) {
-        // Bitcoin Script validation
-        // Additional validation for enhanced opcodes
-        for (size_t i = 0; i < bytecode.size(); ++i) {
-            uint8_t opcode = bytecode[i];
-            if (opcode >= OP_ADDMOD && opcode <= OP_DIFFICULTY) {
-                // Enhanced opcodes are valid
-                continue;
-            }
-        }
+uint256 GetContractStateRoot()
+{
+    std::lock_guard<std::mutex> lock(g_contract_mutex);
+    return CommitStateTrees();
+}
+
+bool GetContractStorageProof(const uint256& contract_address, const uint256& slot,
+                             uint256& state_root, uint256& value, ContractStorageProof& proof)
+{
+    std::lock_guard<std::mutex> lock(g_contract_mutex);
+    
+    state_root = CommitStateTrees();
+    auto it = g_contract_states.find(contract_address);
+    if (it == g_contract_states.end()) {
+        return false;
     }
     
+    const ContractState& state = *it->second;
+    const StateTree& storage_tree = g_storage_trees[contract_address];
+    proof.code_hash = state.code_hash.IsNull() ? ComputeCodeHash(state.code) : state.code_hash;
+    proof.balance = state.balance;
+    proof.nonce = state.nonce;
+    proof.vm_type = state.vm_type;
+    proof.is_active = state.is_active;
+    proof.storage_root = storage_tree.GetRoot();
+    proof.account_proof = g_account_tree.GetProof(contract_address);
+    proof.storage_proof = storage_tree.GetProof(slot);
+    value = storage_tree.Get(slot);
     return true;
 }
 
+ExecutionResult SimulateContractCall(const ContractStateSnapshot& snapshot,
+                                     const uint256& contract_address,
+                                     const ExecutionContext& context)
+{
+    ExecutionResult result;
+    
+    const auto state = snapshot.Find(contract_address);
+    if (!state) {
+        result.result_code = CONTRACT_EXECUTION_ERROR;
+        result.error_message = "Contract not found";
+        return result;
+    }
+    if (!state->is_active) {
+        result.result_code = CONTRACT_EXECUTION_ERROR;
+        result.error_message = "Contract is not active";
+        return result;
+    }
+    if (!ValidateExecutionLimits(context)) {
+        result.result_code = CONTRACT_EXECUTION_ERROR;
+        result.error_message = "Execution limits exceeded";
+        return result;
+    }
+    if (state->vm_type != vm::VM_TYPE_EVM_COMPATIBLE && state->vm_type != vm::VM_TYPE_BITCOIN_SCRIPT) {
+        result.result_code = CONTRACT_EXECUTION_ERROR;
+        result.error_message = "Unknown VM type";
+        return result;
+    }
+    
+    const uint256 code_hash = state->code_hash.IsNull() ? ComputeCodeHash(state->code) : state->code_hash;
+    const auto code = GetCodeAnalysisCache().GetOrAnalyze(code_hash, state->code, state->vm_type);
+    
+    // Storage opcodes read the snapshot and write to the simulation, so
+    // g_contract_mutex is never taken
+    SimulationState* const outer_simulation = g_simulation;
+    SimulationState simulation{snapshot, {}};
+    g_simulation = &simulation;
+    result = RunContractCode(*code, context);
+    g_simulation = outer_simulation;
+    
+    return result;
+}
+
+bool ValidateContractBytecode(const std::vector<uint8_t>& bytecode, int vm_type)
+{
+    // Check size limits before hashing
+    if (bytecode.empty() || bytecode.size() > vm::MAX_CONTRACT_SIZE) {
+        return false;
+    }
+    
+    // Push data and jump destinations are checked by the analysis pass,
+    // whose result is cached for the first execution
+    return GetCodeAnalysisCache().GetOrAnalyze(ComputeCodeHash(bytecode), bytecode, vm_type)->valid;
+}
+
 uint64_t CalculateGasCost(uint8_t opcode, const std::vector<uint8_t>& data)
 {
     uint64_t base_cost = vm::BASE_GAS_PRICE;
@@ -225,9 +542,16 @@ uint64_t CalculateGasCost(uint8_t opcode, const std::vector<uint8_t>& data)
         case OP_SLOAD:
             return base_cost * 5;
         case OP_KECCAK256:
-            return base_cost * 3 + data.size();
+            return vm::GAS_KECCAK256_BLOCK * (data.size() / Keccak256::RATE_BYTES + 1);
         case OP_ECRECOVER:
-            return base_cost * 30;
+            return vm::GAS_ECRECOVER;
+        case OP_LOG0:
+        case OP_LOG1:
+        case OP_LOG2:
+        case OP_LOG3:
+        case OP_LOG4:
+            // Events are kept in receipts and the event index, not in the state
+            return base_cost * 4 * (opcode - OP_LOG0 + 1);
         default:
             return base_cost;
     }
@@ -235,96 +559,143 @@ uint64_t CalculateGasCost(uint8_t opcode, const std::vector<uint8_t>& data)
 
 ExecutionResult ExecuteEnhancedScript(const std::vector<uint8_t>& script,
                                      const ExecutionContext& context)
+{
+    const auto analysis = GetCodeAnalysisCache().GetOrAnalyze(ComputeCodeHash(script), script, vm::VM_TYPE_BITCOIN_SCRIPT);
+    return ExecuteEnhancedScript(*analysis, context);
+}
+
+ExecutionResult ExecuteEnhancedScript(const CodeAnalysis& analysis,
+                                     const ExecutionContext& context)
 {
     ExecutionResult result;
-    std::stack<uint256> stack;
+    
+    if (!analysis.valid) {
+        result.result_code = CONTRACT_EXECUTION_ERROR;
+        result.error_message = analysis.error;
+        return result;
+    }
+    
+    std::vector<uint256> stack;
     uint64_t gas_used = 0;
     
-    for (size_t pc = 0; pc < script.size(); ++pc) {
-        uint8_t opcode = script[pc];
-        
-        // Check gas limit
-        uint64_t op_cost = CalculateGasCost(opcode, {});
-        if (gas_used + op_cost > context.gas_limit) {
+    for (const BasicBlock& block : analysis.blocks) {
+        // Gas and stack bounds are known per block, so the opcodes below run
+        // without checking either. A block that does not fit in the remaining
+        // gas is not started.
+        if (block.static_gas > context.gas_limit - gas_used) {
             result.result_code = CONTRACT_OUT_OF_GAS;
             return result;
         }
-        gas_used += op_cost;
+        gas_used += block.static_gas;
         
-        // Execute enhanced opcodes
-        switch (opcode) {
-            case OP_ADDMOD: {
-                if (stack.size() < 3) {
-                    result.result_code = CONTRACT_EXECUTION_ERROR;
-                    return result;
-                }
-
-                uint256 n_u = stack.top(); stack.pop();
-                uint256 b_u = stack.top(); stack.pop();
-                uint256 a_u = stack.top(); stack.pop();
-
-                arith_uint256 n = UintToArith256(n_u);
-                arith_uint256 b = UintToArith256(b_u);
-                arith_uint256 a = UintToArith256(a_u);
-
-                if (n != 0) {
-                    // Normalize operands: a = a mod n, b = b mod n, using subtraction fallback.
-                    // (Your VM could swap this for a faster div-based mod later.)
-                    while (a >= n) a -= n;
-                    while (b >= n) b -= n;
-
-                    arith_uint256 sum = a;
-                    sum += b;
-
-                    // If sum >= n, reduce once (since a,b < n, sum < 2n)
-                    if (sum >= n) sum -= n;
-
-                    stack.push(ArithToUint256(sum));
-                } else {
-                    stack.push(uint256()); // zero
+        if (stack.size() < block.stack_required) {
+            result.result_code = CONTRACT_EXECUTION_ERROR;
+            return result;
+        }
+        if (stack.size() + block.stack_max_growth > analysis::MAX_STACK_SIZE) {
+            result.result_code = CONTRACT_STACK_OVERFLOW;
+            return result;
+        }
+        
+        for (uint32_t i = block.begin; i < block.end; ++i) {
+            const Instruction& instr = analysis.instructions[i];
+            
+            // Superinstructions
+            switch (instr.fused) {
+                case SuperInstruction::PUSH_SLOAD:
+                    stack.push_back(LoadContractStorage(context.contract_address, analysis.immediates[instr.immediate]));
+                    continue;
+                    
+                case SuperInstruction::KECCAK256_SLOAD: {
+                    uint256 slot;
+                    Keccak256().Write(stack.back()).Finalize(slot);
+                    stack.back() = LoadContractStorage(context.contract_address, slot);
+                    continue;
                 }
-                break;
+                    
+                case SuperInstruction::NONE:
+                    break;
             }
-                
-            case OP_KECCAK256:
-                if (stack.size() < 1) {
-                    result.result_code = CONTRACT_EXECUTION_ERROR;
-                    return result;
-                }
-                {
-                    uint256 data = stack.top(); stack.pop();
-                    uint256 hash = Hash(data);
-                    stack.push(hash);
-                }
-                break;
-                
-            case OP_SLOAD:
-                if (stack.size() < 1) {
-                    result.result_code = CONTRACT_EXECUTION_ERROR;
-                    return result;
+            
+            // Push data was decoded at analysis time
+            if (instr.immediate != Instruction::NO_IMMEDIATE) {
+                stack.push_back(analysis.immediates[instr.immediate]);
+                continue;
+            }
+            
+            // Execute enhanced opcodes
+            switch (instr.opcode) {
+                case OP_ADDMOD: {
+                    arith_uint256 n = UintToArith256(stack.back()); stack.pop_back();
+                    arith_uint256 b = UintToArith256(stack.back()); stack.pop_back();
+                    arith_uint256 a = UintToArith256(stack.back()); stack.pop_back();
+                    
+                    if (n != 0) {
+                        // Normalize operands: a = a mod n, b = b mod n, using subtraction fallback.
+                        // (Your VM could swap this for a faster div-based mod later.)
+                        while (a >= n) a -= n;
+                        while (b >= n) b -= n;
+                        
+                        arith_uint256 sum = a;
+                        sum += b;
+                        
+                        // If sum >= n, reduce once (since a,b < n, sum < 2n)
+                        if (sum >= n) sum -= n;
+                        
+                        stack.push_back(ArithToUint256(sum));
+                    } else {
+                        stack.push_back(uint256()); // zero
+                    }
+                    break;
                 }
-                {
-                    uint256 key = stack.top(); stack.pop();
-                    uint256 value = LoadContractStorage(context.contract_address, key);
-                    stack.push(value);
+                    
+                case OP_KECCAK256: {
+                    uint256 hash;
+                    Keccak256().Write(stack.back()).Finalize(hash);
+                    stack.back() = hash;
+                    break;
                 }
-                break;
-                
-            case OP_SSTORE:
-                if (stack.size() < 2) {
-                    result.result_code = CONTRACT_EXECUTION_ERROR;
-                    return result;
+                    
+                case OP_ECRECOVER: {
+                    uint256 s = stack.back(); stack.pop_back();
+                    uint256 r = stack.back(); stack.pop_back();
+                    uint256 v = stack.back(); stack.pop_back();
+                    uint256 hash = stack.back(); stack.pop_back();
+                    // An unrecoverable signature yields the zero address, as in the EVM
+                    uint256 address;
+                    RecoverSignerAddress(hash, v, r, s, address);
+                    stack.push_back(address);
+                    break;
                 }
-                {
-                    uint256 value = stack.top(); stack.pop();
-                    uint256 key = stack.top(); stack.pop();
+                    
+                case OP_SLOAD:
+                    stack.back() = LoadContractStorage(context.contract_address, stack.back());
+                    break;
+                    
+                case OP_SSTORE: {
+                    uint256 value = stack.back(); stack.pop_back();
+                    uint256 key = stack.back(); stack.pop_back();
                     StoreContractStorage(context.contract_address, key, value);
+                    break;
+                }
+                    
+                case OP_LOG0:
+                case OP_LOG1:
+                case OP_LOG2:
+                case OP_LOG3:
+                case OP_LOG4: {
+                    const size_t topic_count = instr.opcode - OP_LOG0;
+                    std::vector<uint256> topics(stack.end() - topic_count, stack.end());
+                    stack.resize(stack.size() - topic_count);
+                    uint256 data = stack.back(); stack.pop_back();
+                    EmitContractEvent(context.contract_address, topics, {data.begin(), data.end()});
+                    break;
                 }
-                break;
-                
-            default:
-                // Handle standard Bitcoin Script opcodes
-                break;
+                    
+                default:
+                    // Handle standard Bitcoin Script opcodes
+                    break;
+            }
         }
     }
     
@@ -361,14 +732,57 @@ ExecutionResult ExecuteEVMBytecode(const std::vector<uint8_t>& bytecode,
     return result;
 }
 
+bool RecoverSignerAddress(const uint256& hash, const uint256& v, const uint256& r,
+                          const uint256& s, uint256& address)
+{
+    address.SetNull();
+    
+    arith_uint256 recid = UintToArith256(v);
+    if (recid >= 27) recid -= 27;
+    if (recid > 3) {
+        return false;
+    }
+    
+    // Compact signature: header byte for an uncompressed key, then r and s
+    std::vector<unsigned char> sig(CPubKey::COMPACT_SIGNATURE_SIZE);
+    sig[0] = 27 + recid.GetLow64();
+    std::copy(r.begin(), r.end(), sig.begin() + 1);
+    std::copy(s.begin(), s.end(), sig.begin() + 33);
+    
+    CPubKey pubkey;
+    if (!pubkey.RecoverCompact(hash, sig)) {
+        return false;
+    }
+    
+    // Hash the 64-byte X || Y encoding, skipping the 0x04 prefix
+    uint256 key_hash;
+    Keccak256().Write({pubkey.begin() + 1, pubkey.end()}).Finalize(key_hash);
+    std::copy(key_hash.begin() + 12, key_hash.end(), address.begin() + 12);
+    return true;
+}
+
 uint256 LoadContractStorage(const uint256& contract_address, const uint256& key)
 {
+    if (g_simulation) {
+        auto write_it = g_simulation->storage_writes.find({contract_address, key});
+        if (write_it != g_simulation->storage_writes.end()) {
+            return write_it->second;
+        }
+        if (const auto state = g_simulation->snapshot.Find(contract_address)) {
+            auto storage_it = state->storage.find(key);
+            if (storage_it != state->storage.end()) {
+                return storage_it->second;
+            }
+        }
+        return uint256();
+    }
+    
     std::lock_guard<std::mutex> lock(g_contract_mutex);
     
     auto it = g_contract_states.find(contract_address);
     if (it != g_contract_states.end()) {
-        auto storage_it = it->second.storage.find(key);
-        if (storage_it != it->second.storage.end()) {
+        auto storage_it = it->second->storage.find(key);
+        if (storage_it != it->second->storage.end()) {
             return storage_it->second;
         }
     }
@@ -378,16 +792,25 @@ uint256 LoadContractStorage(const uint256& contract_address, const uint256& key)
 
 bool StoreContractStorage(const uint256& contract_address, const uint256& key, const uint256& value)
 {
+    if (g_simulation) {
+        if (!g_simulation->snapshot.Find(contract_address)) {
+            return false;
+        }
+        g_simulation->storage_writes[{contract_address, key}] = value;
+        return true;
+    }
+    
     std::lock_guard<std::mutex> lock(g_contract_mutex);
     
     auto it = g_contract_states.find(contract_address);
     if (it != g_contract_states.end()) {
         // Check storage size limit
-        if (it->second.storage.size() >= vm::MAX_STORAGE_SIZE / 32) { // 32 bytes per entry
+        if (it->second->storage.size() >= vm::MAX_STORAGE_SIZE / 32) { // 32 bytes per entry
             return false;
         }
         
-        it->second.storage[key] = value;
+        MutableContractState(contract_address)->storage[key] = value;
+        g_dirty_contracts[contract_address].slots.insert(key);
         return true;
     }
     
@@ -397,10 +820,138 @@ bool StoreContractStorage(const uint256& contract_address, const uint256& key, c
 void EmitContractEvent(const uint256& contract_address, const std::vector<uint256>& topics,
                       const std::vector<uint8_t>& data)
 {
+    if (g_event_sink) {
+        g_event_sink->events.push_back({contract_address, g_event_sink->tx_hash, topics, data});
+    }
+    
     LogPrintf("Smart Contracts: Event emitted from contract %s (topics: %lu, data: %lu bytes)\n",
               contract_address.ToString(), topics.size(), data.size());
 }
 
+CScript BuildContractCallScript(const ContractCall& call)
+{
+    std::vector<uint8_t> tag(4);
+    WriteLE32(tag.data(), vm::CONTRACT_CALL_TAG);
+    std::vector<uint8_t> payload;
+    VectorWriter{payload, 0, call};
+    
+    CScript script;
+    script << OP_RETURN << tag;
+    for (size_t pos = 0; pos < payload.size(); pos += MAX_SCRIPT_ELEMENT_SIZE) {
+        const size_t end = std::min<size_t>(pos + MAX_SCRIPT_ELEMENT_SIZE, payload.size());
+        script << std::vector<uint8_t>(payload.begin() + pos, payload.begin() + end);
+    }
+    return script;
+}
+
+bool DecodeContractCall(const CTransaction& tx, ContractCall& call)
+{
+    for (const CTxOut& output : tx.vout) {
+        const CScript& script = output.scriptPubKey;
+        CScript::const_iterator pc = script.begin();
+        opcodetype opcode;
+        std::vector<uint8_t> push;
+        if (!script.GetOp(pc, opcode) || opcode != OP_RETURN) continue;
+        if (!script.GetOp(pc, opcode, push) || push.size() != 4 || ReadLE32(push.data()) != vm::CONTRACT_CALL_TAG) continue;
+        
+        // The first tagged output is the call, even if it does not decode
+        std::vector<uint8_t> payload;
+        while (pc < script.end()) {
+            if (!script.GetOp(pc, opcode, push) || opcode > OP_PUSHDATA4) return false;
+            payload.insert(payload.end(), push.begin(), push.end());
+        }
+        try {
+            SpanReader reader{payload};
+            reader >> call;
+            if (!reader.empty()) return false;
+        } catch (const std::ios_base::failure&) {
+            return false;
+        }
+        return call.kind == ContractCall::DEPLOY || call.kind == ContractCall::EXECUTE;
+    }
+    return false;
+}
+
+void SetContractReceiptStore(std::unique_ptr<ContractReceiptStore> store)
+{
+    std::lock_guard<std::mutex> lock(g_contract_mutex);
+    g_receipt_store = std::move(store);
+}
+
+std::optional<std::vector<ContractReceipt>> GetBlockContractReceipts(const uint256& block_hash)
+{
+    std::lock_guard<std::mutex> lock(g_contract_mutex);
+    
+    if (!g_receipt_store) {
+        return std::nullopt;
+    }
+    return g_receipt_store->ReadReceipts(block_hash);
+}
+
+bool ConnectBlockContracts(const CBlock& block, int height, const uint256& block_hash)
+{
+    ExecutionContext block_context;
+    block_context.block_hash = block_hash;
+    block_context.block_height = height;
+    block_context.block_timestamp = block.GetBlockTime();
+    
+    const std::vector<ContractReceipt> receipts = ExecuteContractsInCTOROrder(block.vtx, block_context);
+    
+    // Blocks without contract calls have nothing to store
+    if (!receipts.empty()) {
+        std::lock_guard<std::mutex> lock(g_contract_mutex);
+        if (g_receipt_store && !g_receipt_store->WriteReceipts(block_hash, receipts)) {
+            LogPrintf("Smart Contracts: Failed to store the receipts of block %s\n", block_hash.ToString());
+            return false;
+        }
+    }
+    
+    // Keep the state at the block for read-only calls
+    PublishContractStateSnapshot(height, block_hash);
+    return true;
+}
+
+bool DisconnectBlockContracts(int height, const uint256& prev_block_hash)
+{
+    std::lock_guard<std::mutex> lock(g_contract_mutex);
+    
+    // Snapshots from the disconnected block onwards are stale
+    while (!g_block_snapshots.empty() && g_block_snapshots.back()->height >= height) {
+        g_block_snapshots.pop_back();
+    }
+    if (g_block_snapshots.empty() || g_block_snapshots.back()->height != height - 1 ||
+        g_block_snapshots.back()->block_hash != prev_block_hash) {
+        LogPrintf("Smart Contracts: No state snapshot at block %s, contract state not rolled back\n",
+                  prev_block_hash.ToString());
+        return false;
+    }
+    const ContractStateSnapshot& snapshot = *g_block_snapshots.back();
+    
+    // Contracts unchanged since the snapshot are still shared with it, so
+    // only the others need their state trees rebuilt
+    for (const auto& [address, state] : g_contract_states) {
+        auto it = snapshot.contracts.find(address);
+        if (it == snapshot.contracts.end() || it->second != state) {
+            MarkContractReplaced(address);
+        }
+    }
+    for (const auto& [address, state] : snapshot.contracts) {
+        if (!g_contract_states.count(address)) {
+            MarkContractReplaced(address);
+        }
+    }
+    
+    // The snapshot keeps its references, so restored contracts are copied
+    // before being modified
+    g_contract_states.clear();
+    for (const auto& [address, state] : snapshot.contracts) {
+        g_contract_states.emplace_hint(g_contract_states.end(), address, std::const_pointer_cast<ContractState>(state));
+    }
+    ++g_state_version;
+    g_contract_stats.total_contracts = g_contract_states.size();
+    return true;
+}
+
 bool ValidateExecutionLimits(const ExecutionContext& context)
 {
     // Check call depth
@@ -408,8 +959,9 @@ bool ValidateExecutionLimits(const ExecutionContext& context)
         return false;
     }
     
-    // Check gas limit
-    if (context.gas_limit > vm::MAX_GAS_LIMIT) {
+    // Check gas limit, which governance may change
+    const auto parameters = consensus::governance::GetParameters(context.block_height);
+    if (context.gas_limit > parameters->Get(consensus::governance::parameters::MAX_GAS_LIMIT)) {
         return false;
     }
     
@@ -456,9 +1008,9 @@ bool TransferContractBalance(const uint256& from_address, const uint256& to_addr
     auto to_it = g_contract_states.find(to_address);
     
     if (from_it != g_contract_states.end() && to_it != g_contract_states.end()) {
-        if (from_it->second.balance >= amount) {
-            from_it->second.balance -= amount;
-            to_it->second.balance += amount;
+        if (from_it->second->balance >= amount) {
+            MutableContractState(from_address)->balance -= amount;
+            MutableContractState(to_address)->balance += amount;
             return true;
         }
     }
@@ -472,7 +1024,7 @@ uint64_t GetContractBalance(const uint256& contract_address)
     
     auto it = g_contract_states.find(contract_address);
     if (it != g_contract_states.end()) {
-        return it->second.balance;
+        return it->second->balance;
     }
     
     return 0;
@@ -485,16 +1037,16 @@ bool IsSmartContractActive(int height, const Consensus::Params& params)
 
 int GetSmartContractActivationHeight(const Consensus::Params& params)
 {
-    return vm::SMART_CONTRACT_ACTIVATION_HEIGHT;
+    return params.SmartContractHeight;
 }
 
-std::vector<ExecutionResult> ExecuteContractsInCTOROrder(
-    const std::vector<CTransaction>& transactions,
+std::vector<ContractReceipt> ExecuteContractsInCTOROrder(
+    const std::vector<CTransactionRef>& transactions,
     const ExecutionContext& block_context)
 {
-    std::vector<ExecutionResult> results;
+    std::vector<ContractReceipt> receipts;
     
-    // Create sorted transaction indices for CTOR ordering (avoid CTransaction assignment issues)
+    // Create sorted transaction indices for CTOR ordering
     std::vector<size_t> sorted_indices;
     sorted_indices.reserve(transactions.size());
     for (size_t i = 0; i < transactions.size(); ++i) {
@@ -502,26 +1054,52 @@ std::vector<ExecutionResult> ExecuteContractsInCTOROrder(
     }
     std::sort(sorted_indices.begin(), sorted_indices.end(),
               [&transactions](size_t a, size_t b) {
-                  return transactions[a].GetHash() < transactions[b].GetHash();
+                  return transactions[a]->GetHash() < transactions[b]->GetHash();
               });
     
     // Execute contracts in CTOR order
     for (size_t idx : sorted_indices) {
-        const auto& tx = transactions[idx];
+        const CTransaction& tx = *transactions[idx];
+        ContractCall call;
+        if (!DecodeContractCall(tx, call)) {
+            continue;
+        }
+        
+        // The transaction acts as the caller, so each deployment gets its own address
         ExecutionContext context = block_context;
-        context.tx_hash = tx.GetHash();
+        context.tx_hash = tx.GetHash().ToUint256();
+        context.caller_address = context.tx_hash;
+        context.gas_limit = call.gas_limit;
+        
+        ContractReceipt& receipt = receipts.emplace_back();
+        receipt.tx_hash = context.tx_hash;
         
-        // Simulate contract execution for transaction
         ExecutionResult result;
-        result.result_code = CONTRACT_SUCCESS;
-        result.gas_used = vm::BASE_GAS_PRICE;
+        if (call.kind == ContractCall::DEPLOY) {
+            if (!ValidateExecutionLimits(context)) {
+                result.result_code = CONTRACT_EXECUTION_ERROR;
+            } else if (CalculateGasCost(OP_CREATE, call.data) > context.gas_limit) {
+                result.result_code = CONTRACT_OUT_OF_GAS;
+            } else {
+                receipt.contract_address = DeployContract(call.data, context, result);
+            }
+        } else {
+            context.contract_address = call.contract_address;
+            context.input_data = std::move(call.data);
+            receipt.contract_address = call.contract_address;
+            result = CallContract(call.contract_address, context);
+        }
         
-        results.push_back(result);
+        receipt.result_code = result.result_code;
+        receipt.gas_used = result.gas_used;
+        receipt.logs = std::move(result.logs);
     }
     
-    LogPrintf("Smart Contracts: Executed %lu contracts in CTOR order\n", results.size());
+    if (!receipts.empty()) {
+        LogPrintf("Smart Contracts: Executed %lu contracts in CTOR order\n", receipts.size());
+    }
     
-    return results;
+    return receipts;
 }
 
 uint64_t OptimizeGasWithScaling(uint64_t base_gas, const ExecutionContext& context)
@@ -543,16 +1121,9 @@ uint64_t OptimizeGasWithScaling(uint64_t base_gas, const ExecutionContext& conte
 
 std::vector<uint8_t> CompressContractState(const ContractState& state)
 {
-    // Simplified compression for Xthinner integration
+    // Balance, nonce and storage words are varint-encoded
     std::vector<uint8_t> compressed;
-    
-    // Compress contract code
-    compressed.insert(compressed.end(), state.code.begin(), state.code.end());
-    
-    // Add balance and nonce
-    compressed.push_back(static_cast<uint8_t>(state.balance & 0xff));
-    compressed.push_back(static_cast<uint8_t>(state.nonce & 0xff));
-    
+    VectorWriter{compressed, 0, state};
     return compressed;
 }
 
@@ -560,13 +1131,12 @@ ContractState DecompressContractState(const std::vector<uint8_t>& compressed_dat
 {
     ContractState state;
     
-    if (compressed_data.size() >= 2) {
-        // Extract balance and nonce
-        state.balance = compressed_data[compressed_data.size() - 2];
-        state.nonce = compressed_data[compressed_data.size() - 1];
-        
-        // Extract code
-        state.code.assign(compressed_data.begin(), compressed_data.end() - 2);
+    try {
+        SpanReader{compressed_data} >> state;
+        state.code_hash = ComputeCodeHash(state.code);
+    } catch (const std::ios_base::failure& e) {
+        LogPrintf("Smart Contracts: Failed to decompress contract state: %s\n", e.what());
+        return ContractState();
     }
     
     return state;
@@ -598,8 +1168,8 @@ void MonitorContractPerformance()
     
     LogPrintf("Smart Contracts Performance: %lu contracts, %lu executions, %lu total gas\n",
               stats.total_contracts, stats.total_executions, stats.total_gas_used);
-    LogPrintf("Smart Contracts Performance: %.2f%% success rate, %lu ms avg execution time\n",
-              stats.success_rate * 100, stats.average_execution_time);
+    LogPrintf("Smart Contracts Performance: %.2f%% success rate, %lu avg gas per execution\n",
+              stats.success_rate * 100, stats.average_gas_used);
 }
 
 void CleanupExpiredContractData()
@@ -609,8 +1179,10 @@ void CleanupExpiredContractData()
     // Cleanup inactive contracts
     size_t cleaned = 0;
     for (auto it = g_contract_states.begin(); it != g_contract_states.end();) {
-        if (!it->second.is_active) {
+        if (!it->second->is_active) {
+            MarkContractReplaced(it->first);
             it = g_contract_states.erase(it);
+            ++g_state_version;
             cleaned++;
         } else {
             ++it;
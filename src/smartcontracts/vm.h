@@ -6,11 +6,17 @@
 #include <string>
 #include <memory>
 #include <map>
+#include <optional>
 
 class CTransaction;
 class CBlock;
+#include <primitives/transaction.h>
+#include <serialize.h>
+#include <smartcontracts/statetree.h>
+#include <smartcontracts/storage.h>
 #include <uint256.h>
 namespace Consensus { struct Params; }
+namespace smartcontracts { struct CodeAnalysis; }
 
 /**
  * Bitcoin Decentral Smart Contract Virtual Machine
@@ -46,12 +52,21 @@ namespace vm {
     static const size_t MAX_CONTRACT_SIZE = 24576;   // 24KB max contract size
     static const size_t MAX_STORAGE_SIZE = 1048576;  // 1MB max storage per contract
     
-    // Execution limits
+    // Opcode costs measured with bench_bitcoin (KECCAK256_32b, ECRecover): one
+    // Keccak-f[1600] block costs ~0.5us and a public key recovery ~63us, so
+    // ECRECOVER is priced as 125 Keccak blocks.
+    static const uint64_t GAS_KECCAK256_BLOCK = 3 * BASE_GAS_PRICE;
+    static const uint64_t GAS_ECRECOVER = 125 * GAS_KECCAK256_BLOCK;
+    
+    // Execution limits. Execution time is bounded by gas alone, so that every
+    // node reaches the same result.
     static const int MAX_CALL_DEPTH = 1024;         // Maximum call stack depth
-    static const int MAX_EXECUTION_TIME_MS = 5000;  // 5 second execution limit
     
-    // Smart contract activation height
-    static const int SMART_CONTRACT_ACTIVATION_HEIGHT = 5000;
+    // First push of an OP_RETURN output that carries a contract call
+    static const uint32_t CONTRACT_CALL_TAG = 0x43534442; // "BDSC"
+    
+    // Recent blocks whose state is kept for read-only calls
+    static const size_t MAX_STATE_SNAPSHOTS = 16;
 }
 
 /**
@@ -63,23 +78,103 @@ enum ContractResult {
     CONTRACT_EXECUTION_ERROR = 2,
     CONTRACT_INVALID_OPCODE = 3,
     CONTRACT_STACK_OVERFLOW = 4,
-    CONTRACT_TIMEOUT = 5,
+    CONTRACT_TIMEOUT = 5,               // Unused: execution is bounded by gas only
     CONTRACT_STORAGE_LIMIT = 6
 };
 
+/**
+ * Serializes a 32-byte word as a length byte and its low-order bytes, so the
+ * small numbers that make up most contract storage take a few bytes each
+ */
+struct CompactWordFormatter
+{
+    template<typename Stream>
+    void Ser(Stream& s, const uint256& word)
+    {
+        uint8_t size = word.size();
+        while (size > 0 && word.data()[size - 1] == 0) --size;
+        ser_writedata8(s, size);
+        s.write(MakeByteSpan(word).first(size));
+    }
+    
+    template<typename Stream>
+    void Unser(Stream& s, uint256& word)
+    {
+        const uint8_t size = ser_readdata8(s);
+        if (size > word.size()) {
+            throw std::ios_base::failure("CompactWordFormatter: word too large");
+        }
+        word.SetNull();
+        s.read(MakeWritableByteSpan(word).first(size));
+    }
+};
+
+/**
+ * Serializes contract storage as a count followed by compact key/value pairs
+ */
+struct ContractStorageFormatter
+{
+    template<typename Stream>
+    void Ser(Stream& s, const ContractStorage& storage)
+    {
+        WriteCompactSize(s, storage.size());
+        for (const auto& [key, value] : storage) {
+            s << Using<CompactWordFormatter>(key) << Using<CompactWordFormatter>(value);
+        }
+    }
+    
+    template<typename Stream>
+    void Unser(Stream& s, ContractStorage& storage)
+    {
+        storage.clear();
+        const uint64_t count = ReadCompactSize(s);
+        for (uint64_t i = 0; i < count; ++i) {
+            uint256 key, value;
+            s >> Using<CompactWordFormatter>(key) >> Using<CompactWordFormatter>(value);
+            storage[key] = value;
+        }
+    }
+};
+
 /**
  * Smart contract state
  */
 struct ContractState {
     uint256 contract_address;           // Contract address
     std::vector<uint8_t> code;         // Contract bytecode
-    std::map<uint256, uint256> storage; // Contract storage
+    uint256 code_hash;                  // Hash of the bytecode, keys the analysis cache
+    ContractStorage storage;            // Contract storage, paged for copy-on-write
     uint64_t balance;                   // Contract balance
     uint64_t nonce;                     // Contract nonce
     int vm_type;                        // Virtual machine type
     bool is_active;                     // Contract active status
     
     ContractState() : balance(0), nonce(0), vm_type(vm::VM_TYPE_BITCOIN_SCRIPT), is_active(true) {}
+    
+    // code_hash is derived from the code and not serialized
+    SERIALIZE_METHODS(ContractState, obj)
+    {
+        READWRITE(obj.contract_address, obj.code, VARINT(obj.balance), VARINT(obj.nonce),
+                  VARINT_MODE(obj.vm_type, VarIntMode::NONNEGATIVE_SIGNED), obj.is_active,
+                  Using<ContractStorageFormatter>(obj.storage));
+    }
+};
+
+/**
+ * Read-only view of every contract state at one point in time
+ *
+ * Snapshots share unmodified contracts with the live state, which copies a
+ * contract before changing it while a snapshot holds it. The copy shares the
+ * contract's storage pages, and only the pages written are copied in turn.
+ */
+struct ContractStateSnapshot {
+    uint64_t version{0};                // State version the snapshot was taken at
+    int height{-1};                     // Block height, or -1 for the state between blocks
+    uint256 block_hash;                 // Block hash, if taken at a block
+    uint256 state_root;                 // State root, if taken at a block
+    std::map<uint256, std::shared_ptr<const ContractState>> contracts;
+    
+    std::shared_ptr<const ContractState> Find(const uint256& contract_address) const;
 };
 
 /**
@@ -100,6 +195,68 @@ struct ExecutionContext {
     ExecutionContext() : block_height(0), block_timestamp(0), gas_limit(0), gas_price(0), value(0) {}
 };
 
+/**
+ * Contract event log entry
+ */
+struct ContractEvent {
+    uint256 contract_address;           // Emitting contract
+    uint256 tx_hash;                    // Transaction that emitted the event
+    std::vector<uint256> topics;        // Indexed topics
+    std::vector<uint8_t> data;          // Event payload
+    
+    SERIALIZE_METHODS(ContractEvent, obj) { READWRITE(obj.contract_address, obj.tx_hash, obj.topics, obj.data); }
+};
+
+/**
+ * A contract deployment or call made by a transaction
+ *
+ * Carried in an OP_RETURN output as the tag followed by the serialized call,
+ * split into pushes of at most MAX_SCRIPT_ELEMENT_SIZE bytes.
+ */
+struct ContractCall {
+    enum Kind : uint8_t {
+        DEPLOY = 0,                     // Deploy data as the code of a new contract
+        EXECUTE = 1,                    // Call contract_address with data as input
+    };
+    
+    uint8_t kind{EXECUTE};
+    uint256 contract_address;           // Called contract, unused for deployments
+    uint64_t gas_limit{0};              // Gas limit
+    std::vector<uint8_t> data;          // Contract code or call input
+    
+    SERIALIZE_METHODS(ContractCall, obj) { READWRITE(obj.kind, obj.contract_address, VARINT(obj.gas_limit), obj.data); }
+};
+
+/**
+ * Outcome of a contract call in a connected block
+ */
+struct ContractReceipt {
+    uint256 tx_hash;                    // Calling transaction
+    uint256 contract_address;           // Called or deployed contract
+    int result_code{0};                 // ContractResult of the execution
+    uint64_t gas_used{0};               // Gas consumed
+    std::vector<ContractEvent> logs;    // Events, empty if the execution failed
+    
+    SERIALIZE_METHODS(ContractReceipt, obj)
+    {
+        READWRITE(obj.tx_hash, obj.contract_address, VARINT_MODE(obj.result_code, VarIntMode::NONNEGATIVE_SIGNED),
+                  VARINT(obj.gas_used), obj.logs);
+    }
+};
+
+/**
+ * Persistent storage for the receipts of connected blocks, which the
+ * contract event index reads its events from
+ */
+class ContractReceiptStore
+{
+public:
+    virtual ~ContractReceiptStore() = default;
+    
+    virtual bool WriteReceipts(const uint256& block_hash, const std::vector<ContractReceipt>& receipts) = 0;
+    virtual std::optional<std::vector<ContractReceipt>> ReadReceipts(const uint256& block_hash) const = 0;
+};
+
 /**
  * Contract execution result
  */
@@ -107,7 +264,7 @@ struct ExecutionResult {
     ContractResult result_code;         // Execution result
     std::vector<uint8_t> return_data;   // Return data
     uint64_t gas_used;                  // Gas consumed
-    std::vector<uint256> logs;          // Event logs
+    std::vector<ContractEvent> logs;    // Event logs
     std::string error_message;          // Error message if failed
     
     ExecutionResult() : result_code(CONTRACT_SUCCESS), gas_used(0) {}
@@ -117,6 +274,13 @@ struct ExecutionResult {
  * Enhanced Bitcoin Script opcodes
  */
 enum EnhancedOpcodes {
+    // Event operations: emit the data word with 0-4 topics, the last on top
+    OP_LOG0 = 0xeb,                     // (data --)
+    OP_LOG1 = 0xec,                     // (data topic1 --)
+    OP_LOG2 = 0xed,                     // (data topic1 topic2 --)
+    OP_LOG3 = 0xee,                     // (data topic1 topic2 topic3 --)
+    OP_LOG4 = 0xef,                     // (data topic1 topic2 topic3 topic4 --)
+    
     // Arithmetic operations
     OP_ADDMOD = 0xf0,                   // (a b n -- (a+b)%n)
     OP_MULMOD = 0xf1,                   // (a b n -- (a*b)%n)
@@ -176,6 +340,62 @@ ContractState GetContractState(const uint256& contract_address);
  */
 bool UpdateContractState(const uint256& contract_address, const ContractState& state);
 
+/**
+ * Get a copy of every contract state, ordered by address
+ */
+std::map<uint256, ContractState> GetAllContractStates();
+
+/**
+ * Replace every contract state, e.g. with the contents of a snapshot
+ */
+void ReplaceAllContractStates(std::map<uint256, ContractState> states);
+
+/**
+ * Get a snapshot of the current contract state
+ *
+ * Repeated calls share one snapshot until the state changes.
+ */
+std::shared_ptr<const ContractStateSnapshot> GetContractStateSnapshot();
+
+/**
+ * Get the snapshot taken when the block at a height was connected, if it is
+ * one of the last vm::MAX_STATE_SNAPSHOTS
+ */
+std::shared_ptr<const ContractStateSnapshot> GetContractStateSnapshot(int height);
+
+/**
+ * Keep a snapshot of the current state, with its state root, as the state
+ * at a connected block
+ */
+void PublishContractStateSnapshot(int height, const uint256& block_hash);
+
+/**
+ * Execute a contract call against a snapshot without changing any state
+ *
+ * Storage writes are visible to the rest of the call and then discarded.
+ * Does not take g_contract_mutex, so calls run concurrently with each
+ * other and with block connection.
+ */
+ExecutionResult SimulateContractCall(const ContractStateSnapshot& snapshot,
+                                     const uint256& contract_address,
+                                     const ExecutionContext& context);
+
+/**
+ * Get the root of the authenticated contract state
+ *
+ * Brings the state trees up to date with the changes made since the last
+ * call, rehashing only the paths those changes touched.
+ */
+uint256 GetContractStateRoot();
+
+/**
+ * Prove the value of a contract's storage slot against the current state root
+ *
+ * Returns false if the contract does not exist.
+ */
+bool GetContractStorageProof(const uint256& contract_address, const uint256& slot,
+                             uint256& state_root, uint256& value, ContractStorageProof& proof);
+
 /**
  * Validate contract bytecode
  */
@@ -192,12 +412,28 @@ uint64_t CalculateGasCost(uint8_t opcode, const std::vector<uint8_t>& data);
 ExecutionResult ExecuteEnhancedScript(const std::vector<uint8_t>& script,
                                      const ExecutionContext& context);
 
+/**
+ * Execute enhanced Bitcoin Script from its cached analysis
+ */
+ExecutionResult ExecuteEnhancedScript(const CodeAnalysis& analysis,
+                                     const ExecutionContext& context);
+
 /**
  * Execute EVM-compatible bytecode
  */
 ExecutionResult ExecuteEVMBytecode(const std::vector<uint8_t>& bytecode,
                                   const ExecutionContext& context);
 
+/**
+ * Recover the address that signed a message hash (OP_ECRECOVER)
+ *
+ * Follows the EVM convention: v is the recovery id (0-3, or 27-30), and the
+ * address is the last 20 bytes of the Keccak-256 hash of the uncompressed
+ * public key, left-padded to a 32-byte word.
+ */
+bool RecoverSignerAddress(const uint256& hash, const uint256& v, const uint256& r,
+                          const uint256& s, uint256& address);
+
 /**
  * Handle contract storage operations
  */
@@ -205,11 +441,54 @@ uint256 LoadContractStorage(const uint256& contract_address, const uint256& key)
 bool StoreContractStorage(const uint256& contract_address, const uint256& key, const uint256& value);
 
 /**
- * Process contract events and logs
+ * Process contract events and logs (OP_LOG0-OP_LOG4)
+ *
+ * Events are appended to the logs of the executing contract's result, and
+ * are only kept if that execution succeeds.
  */
 void EmitContractEvent(const uint256& contract_address, const std::vector<uint256>& topics,
                       const std::vector<uint8_t>& data);
 
+/**
+ * Build the OP_RETURN output script that carries a contract call
+ */
+CScript BuildContractCallScript(const ContractCall& call);
+
+/**
+ * Find the contract call carried by a transaction, if any
+ */
+bool DecodeContractCall(const CTransaction& tx, ContractCall& call);
+
+/**
+ * Set the store that keeps the receipts of connected blocks. Without a
+ * store, receipts are not kept.
+ */
+void SetContractReceiptStore(std::unique_ptr<ContractReceiptStore> store);
+
+/**
+ * Get the receipts of a connected block's contract calls, in execution order
+ *
+ * Returns nullopt if none were stored, which is the case for blocks without
+ * contract calls.
+ */
+std::optional<std::vector<ContractReceipt>> GetBlockContractReceipts(const uint256& block_hash);
+
+/**
+ * Execute the contract calls of a block connected to the active chain,
+ * store their receipts and publish the resulting state snapshot
+ *
+ * Returns false if the receipts could not be stored.
+ */
+bool ConnectBlockContracts(const CBlock& block, int height, const uint256& block_hash);
+
+/**
+ * Roll the contract state back to the parent of a disconnected block
+ *
+ * The state is restored from the parent's snapshot, so this fails if the
+ * parent is not one of the last vm::MAX_STATE_SNAPSHOTS blocks.
+ */
+bool DisconnectBlockContracts(int height, const uint256& prev_block_hash);
+
 /**
  * Validate contract execution limits
  */
@@ -249,10 +528,12 @@ bool IsSmartContractActive(int height, const Consensus::Params& params);
 int GetSmartContractActivationHeight(const Consensus::Params& params);
 
 /**
- * Integrate with CTOR for deterministic execution
+ * Execute the contract calls of a block's transactions in CTOR order
+ *
+ * Returns a receipt for each transaction that carries a contract call.
  */
-std::vector<ExecutionResult> ExecuteContractsInCTOROrder(
-    const std::vector<CTransaction>& transactions,
+std::vector<ContractReceipt> ExecuteContractsInCTOROrder(
+    const std::vector<CTransactionRef>& transactions,
     const ExecutionContext& block_context);
 
 /**
@@ -262,6 +543,9 @@ uint64_t OptimizeGasWithScaling(uint64_t base_gas, const ExecutionContext& conte
 
 /**
  * Handle contract state compression for Xthinner
+ *
+ * The compressed form is the full serialized state, so decompression
+ * restores every field.
  */
 std::vector<uint8_t> CompressContractState(const ContractState& state);
 ContractState DecompressContractState(const std::vector<uint8_t>& compressed_data);
@@ -283,7 +567,7 @@ struct ContractStats {
     uint64_t total_contracts;
     uint64_t total_executions;
     uint64_t total_gas_used;
-    uint64_t average_execution_time;
+    uint64_t average_gas_used;
     double success_rate;
 };
 
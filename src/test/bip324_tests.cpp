@@ -4,6 +4,7 @@
 
 #include <bip324.h>
 #include <chainparams.h>
+#include <crypto/mlkem.h>
 #include <key.h>
 #include <pubkey.h>
 #include <span.h>
@@ -300,4 +301,63 @@ BOOST_AUTO_TEST_CASE(packet_test_vectors) {
         "7c4b9e1e6c1ce69da7b01513cdc4588fd93b04dafefaf87f31561763d906c672bac3dfceb751ebd126728ac017d4d580e931b8e5c7d5dfe0123be4dc9b2d2238b655c8a7fadaf8082c31e310909b5b731efc12f0a56e849eae6bfeedcc86dd27ef9b91d159256aa8e8d2b71a311f73350863d70f18d0d7302cf551e4303c7733");
 }
 
+BOOST_AUTO_TEST_CASE(hybrid_key_exchange)
+{
+    using mlkem::ParameterSet;
+    BOOST_CHECK_EQUAL(BIP324Cipher::KEM_ENCAPS_KEY_LEN, mlkem::EncapsulationKeySize(ParameterSet::ML_KEM_768));
+    BOOST_CHECK_EQUAL(BIP324Cipher::KEM_DECAPS_KEY_LEN, mlkem::DecapsulationKeySize(ParameterSet::ML_KEM_768));
+    BOOST_CHECK_EQUAL(BIP324Cipher::KEM_CIPHERTEXT_LEN, mlkem::CiphertextSize(ParameterSet::ML_KEM_768));
+
+    // Send a packet from one cipher to the other, and report whether it decrypted to the same contents.
+    auto transfer = [&](BIP324Cipher& sender, BIP324Cipher& receiver) {
+        const auto contents = m_rng.randbytes<std::byte>(m_rng.randrange(100));
+        std::vector<std::byte> ciphertext(contents.size() + BIP324Cipher::EXPANSION);
+        sender.Encrypt(contents, {}, false, ciphertext);
+        const uint32_t len = receiver.DecryptLength(Span{ciphertext}.first(BIP324Cipher::LENGTH_LEN));
+        if (len != contents.size()) return false;
+        std::vector<std::byte> decrypted(len);
+        bool ignore{false};
+        return receiver.Decrypt(Span{ciphertext}.subspan(BIP324Cipher::LENGTH_LEN), {}, ignore, decrypted) && decrypted == contents;
+    };
+
+    for (int i = 0; i < 3; ++i) {
+        BIP324Cipher initiator{GenerateRandomKey(), MakeByteSpan(m_rng.rand256())};
+        BIP324Cipher responder{GenerateRandomKey(), MakeByteSpan(m_rng.rand256())};
+        initiator.Initialize(responder.GetOurPubKey(), /*initiator=*/true);
+        responder.Initialize(initiator.GetOurPubKey(), /*initiator=*/false);
+
+        const BIP324KEMKey kem_key = BIP324KEMKey::Generate();
+        std::vector<std::byte> kem_ciphertext(BIP324Cipher::KEM_CIPHERTEXT_LEN);
+        BOOST_REQUIRE(initiator.Encapsulate(MakeByteSpan(kem_key.encaps_key), kem_ciphertext, /*initiator=*/true));
+        const bool tamper = i == 2;
+        if (tamper) kem_ciphertext[m_rng.randrange(kem_ciphertext.size())] ^= std::byte{1};
+        responder.Decapsulate(kem_key, kem_ciphertext, /*initiator=*/false);
+
+        // Until switched, the ECDH keys stay in use in each direction independently
+        BOOST_CHECK(transfer(initiator, responder));
+        BOOST_CHECK(initiator.SwitchSendCipher());
+        BOOST_CHECK(responder.SwitchRecvCipher());
+        BOOST_CHECK(transfer(responder, initiator));
+        BOOST_CHECK(responder.SwitchSendCipher());
+        BOOST_CHECK(initiator.SwitchRecvCipher());
+        BOOST_CHECK(!initiator.SwitchSendCipher());
+        BOOST_CHECK(!responder.SwitchRecvCipher());
+
+        // The hybrid keys match unless the ciphertext was modified; the session id is the ECDH one
+        BOOST_CHECK_EQUAL(transfer(initiator, responder), !tamper);
+        BOOST_CHECK_EQUAL(transfer(responder, initiator), !tamper);
+        BOOST_CHECK(std::ranges::equal(initiator.GetSessionID(), responder.GetSessionID()));
+    }
+
+    // An encapsulation key with unreduced coefficients is refused, and no keys are derived
+    BIP324Cipher initiator{GenerateRandomKey(), MakeByteSpan(m_rng.rand256())};
+    BIP324Cipher responder{GenerateRandomKey(), MakeByteSpan(m_rng.rand256())};
+    initiator.Initialize(responder.GetOurPubKey(), /*initiator=*/true);
+    std::vector<std::byte> encaps_key(BIP324Cipher::KEM_ENCAPS_KEY_LEN, std::byte{0xFF});
+    std::vector<std::byte> kem_ciphertext(BIP324Cipher::KEM_CIPHERTEXT_LEN);
+    BOOST_CHECK(!initiator.Encapsulate(encaps_key, kem_ciphertext, /*initiator=*/true));
+    BOOST_CHECK(!initiator.SwitchSendCipher());
+    BOOST_CHECK(!initiator.SwitchRecvCipher());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,421 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <consensus/merkle.h>
+#include <hash.h>
+#include <interop/bridges.h>
+#include <interop/headerchain.h>
+#include <interop/timerwheel.h>
+#include <interop/transferpipeline.h>
+#include <kernel/chainparams.h>
+#include <key.h>
+#include <merkleblock.h>
+#include <node/bridgedb.h>
+#include <pow.h>
+#include <primitives/transaction.h>
+#include <pubkey.h>
+#include <script/script.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace interop::bridges;
+
+namespace {
+
+/** Signs batches with one key standing for a full set of validators */
+class TestBatchSigner final : public BridgeBatchSigner
+{
+public:
+    explicit TestBatchSigner(const CKey& key) : m_key{key}
+    {
+        for (int i = 0; i < params::BRIDGE_THRESHOLD; ++i) m_signers.push_back(uint256(i + 1));
+    }
+
+    bool SignBatch(BridgeTransferBatch& batch) override
+    {
+        ++m_batches;
+        batch.signers = m_signers;
+        batch.signature.resize(64);
+        return m_key.SignSchnorr(batch.batch_root, batch.signature, nullptr, uint256::ONE);
+    }
+
+    std::atomic<int> m_batches{0};
+
+private:
+    const CKey& m_key;
+    std::vector<uint256> m_signers;
+};
+
+CBlock MineBlock(const CBlockHeader& prev, std::vector<CTransactionRef> txs, const Consensus::Params& params)
+{
+    CBlock block;
+    block.vtx = std::move(txs);
+    block.nVersion = 4;
+    block.hashPrevBlock = prev.GetHash();
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+    block.nTime = prev.nTime + 600;
+    block.nBits = prev.nBits;
+    while (!CheckProofOfWork(block.GetHash(), block.nBits, params)) ++block.nNonce;
+    return block;
+}
+
+/** Script the test bridge's deposits pay */
+const CScript BRIDGE_SCRIPT{CScript() << OP_1 << std::vector<unsigned char>(32, 0xbd)};
+
+/** Source chain transaction depositing amount to the bridge, committing to an asset and destination */
+CTransactionRef MakeDeposit(const uint256& prev, const CScript& script, uint64_t amount, const uint256& asset_id,
+                            params::SupportedChain dest_chain, const std::string& dest_address)
+{
+    BridgeTransfer transfer;
+    transfer.asset_id = asset_id;
+    transfer.dest_chain = dest_chain;
+    transfer.dest_address = dest_address;
+    CMutableTransaction tx;
+    tx.vin.emplace_back(COutPoint{Txid::FromUint256(prev), 0});
+    tx.vout.emplace_back(1000, CScript() << OP_TRUE);
+    tx.vout.emplace_back(amount, script);
+    tx.vout.emplace_back(0, CScript() << OP_RETURN << ToByteVector(GetBridgeDepositCommitment(transfer)));
+    return MakeTransactionRef(std::move(tx));
+}
+
+std::vector<uint8_t> SerializeProof(const CBlock& block, const Txid& txid)
+{
+    DataStream stream{};
+    stream << CMerkleBlock{block, std::set<Txid>{txid}};
+    return {UCharCast(stream.data()), UCharCast(stream.data() + stream.size())};
+}
+
+std::unique_ptr<node::BridgeDB> OpenBridgeDB(const fs::path& path, bool wipe)
+{
+    return std::make_unique<node::BridgeDB>(DBParams{
+        .path = path,
+        .cache_bytes = 1 << 20,
+        .memory_only = false,
+        .wipe_data = wipe,
+        .obfuscate = false,
+        .options = {}});
+}
+
+std::vector<uint256> ActiveTransferIds()
+{
+    std::vector<uint256> transfer_ids;
+    for (const auto& [transfer_id, transfer] : GetBridgeNetworkState().active_transfers) {
+        transfer_ids.push_back(transfer_id);
+    }
+    return transfer_ids;
+}
+
+std::vector<uint256> ActiveSwapIds()
+{
+    std::vector<uint256> swap_ids;
+    for (const auto& [swap_id, swap] : GetBridgeNetworkState().active_swaps) {
+        swap_ids.push_back(swap_id);
+    }
+    return swap_ids;
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(bridge_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(transfer_pipeline)
+{
+    BOOST_REQUIRE(InitializeBridgeSystem());
+    SetBridgeDepositScript(params::CHAIN_BITCOIN, BRIDGE_SCRIPT);
+    const auto chainparams = CChainParams::RegTest({});
+    const Consensus::Params& consensus = chainparams->GetConsensus();
+    auto light_client = std::make_shared<interop::HeaderChain>(m_path_root / "pipeline.dat", consensus, chainparams->GenesisBlock());
+
+    // Source transactions in a buried block and in the tip block
+    std::vector<CTransactionRef> txs;
+    for (int i = 0; i < 1000; ++i) {
+        txs.push_back(MakeDeposit(m_rng.rand256(), BRIDGE_SCRIPT, params::MIN_TRANSFER_AMOUNT, uint256{1},
+                                  params::CHAIN_ETHEREUM, "0x0"));
+    }
+    const CBlock buried = MineBlock(chainparams->GenesisBlock(), {txs.begin(), txs.begin() + 900}, consensus);
+    std::vector<CBlockHeader> headers{buried};
+    for (uint32_t i = 0; i < params::MIN_CONFIRMATIONS_BITCOIN - 1; ++i) {
+        headers.push_back(MineBlock(headers.back(), {}, consensus));
+    }
+    const CBlock tip = MineBlock(headers.back(), {txs.begin() + 900, txs.end()}, consensus);
+    headers.push_back(tip);
+    BOOST_REQUIRE(light_client->AddHeaders(headers));
+    BOOST_REQUIRE(SetChainLightClient(params::CHAIN_BITCOIN, light_client));
+
+    for (int i = 0; i < 1000; ++i) {
+        BOOST_REQUIRE(InitiateBridgeTransfer(m_rng.rand256(), params::CHAIN_BITCOIN, params::CHAIN_ETHEREUM, uint256{1},
+                                             params::MIN_TRANSFER_AMOUNT, "0x0"));
+    }
+    std::vector<uint256> transfer_ids;
+    for (const auto& [transfer_id, transfer] : GetBridgeNetworkState().active_transfers) {
+        transfer_ids.push_back(transfer_id);
+    }
+    BOOST_REQUIRE_EQUAL(transfer_ids.size(), 1000U);
+    for (size_t i = 0; i < transfer_ids.size(); ++i) {
+        const CBlock& block = i < 900 ? buried : tip;
+        // The last buried transfer's proof covers another transaction
+        const Txid proven = i == 899 ? txs[0]->GetHash() : txs[i]->GetHash();
+        BOOST_REQUIRE(SubmitBridgeTransferProof(transfer_ids[i], *txs[i], SerializeProof(block, proven)));
+    }
+
+    CKey key;
+    key.MakeNewKey(true);
+    TestBatchSigner signer{key};
+    // Small queues, so that stages wait for each other
+    BridgeTransferPipeline pipeline{signer, {.batch_size = 64, .queue_capacity = 16}};
+    BOOST_CHECK_EQUAL(QueueBridgeTransfers(pipeline), 1000U);
+    BOOST_CHECK_EQUAL(QueueBridgeTransfers(pipeline), 0U);
+    size_t applied = 0;
+    for (int i = 0; i < 1000 && applied < 1000; ++i) {
+        applied += ApplyBridgeTransferResults(pipeline);
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    BOOST_REQUIRE_EQUAL(applied, 1000U);
+
+    const BridgeNetworkState state = GetBridgeNetworkState();
+    BOOST_CHECK_EQUAL(state.successful_transfers, 899U);
+    BOOST_CHECK_EQUAL(state.total_bridge_volume, 899 * params::MIN_TRANSFER_AMOUNT);
+    BOOST_CHECK_EQUAL(state.transfer_batches.size(), size_t(signer.m_batches));
+    BOOST_CHECK(signer.m_batches < 899);
+    for (size_t i = 0; i < transfer_ids.size(); ++i) {
+        const BridgeTransfer& transfer = state.active_transfers.at(transfer_ids[i]);
+        if (i == 899) {
+            BOOST_CHECK_EQUAL(transfer.status, BridgeTransfer::TRANSFER_FAILED);
+        } else if (i > 899) {
+            // Not confirmed yet; stays pending for a later round
+            BOOST_CHECK_EQUAL(transfer.status, BridgeTransfer::TRANSFER_PENDING);
+        } else {
+            BOOST_CHECK_EQUAL(transfer.status, BridgeTransfer::TRANSFER_COMPLETED);
+            BOOST_CHECK(CheckBridgeSecurityThreshold(transfer.validator_signatures));
+            BOOST_CHECK(state.transfer_batches.contains(transfer.batch_root));
+        }
+    }
+
+    // Each batch signature covers the merkle root of its transfers
+    size_t batched = 0;
+    for (const auto& [batch_root, batch] : state.transfer_batches) {
+        std::vector<uint256> leaves;
+        for (const uint256& transfer_id : batch.transfer_ids) {
+            leaves.push_back(GetBridgeTransferHash(state.active_transfers.at(transfer_id)));
+        }
+        BOOST_CHECK_EQUAL(ComputeMerkleRoot(leaves), batch_root);
+        BOOST_CHECK(XOnlyPubKey{key.GetPubKey()}.VerifySchnorr(batch_root, batch.signature));
+        batched += batch.transfer_ids.size();
+    }
+    BOOST_CHECK_EQUAL(batched, 899U);
+
+    // Pending transfers go round again once their block is buried
+    std::vector<CBlockHeader> more{MineBlock(tip, {}, consensus)};
+    for (uint32_t i = 0; i < params::MIN_CONFIRMATIONS_BITCOIN - 2; ++i) {
+        more.push_back(MineBlock(more.back(), {}, consensus));
+    }
+    BOOST_REQUIRE(light_client->AddHeaders(more));
+    BOOST_CHECK_EQUAL(QueueBridgeTransfers(pipeline), 100U);
+    pipeline.Stop();
+    BOOST_CHECK(!pipeline.Submit(state.active_transfers.begin()->second));
+    BOOST_CHECK_EQUAL(ApplyBridgeTransferResults(pipeline), 100U);
+    BOOST_CHECK_EQUAL(GetBridgeNetworkState().successful_transfers, 999U);
+
+    BOOST_CHECK(SetChainLightClient(params::CHAIN_BITCOIN, nullptr));
+}
+
+BOOST_AUTO_TEST_CASE(transfer_deposits)
+{
+    const fs::path path = m_path_root / "deposits";
+    BOOST_REQUIRE(InitializeBridgeSystem());
+    SetBridgeStore(OpenBridgeDB(path, /*wipe=*/true), 100);
+    const uint256 alice = m_rng.rand256();
+    for (int i = 0; i < 2; ++i) {
+        BOOST_REQUIRE(InitiateBridgeTransfer(alice, params::CHAIN_BITCOIN, params::CHAIN_ETHEREUM, uint256{1},
+                                             params::MIN_TRANSFER_AMOUNT, "0x0"));
+    }
+    const std::vector<uint256> transfer_ids = ActiveTransferIds();
+    const BridgeTransfer transfer = GetBridgeNetworkState().active_transfers.at(transfer_ids[0]);
+
+    const auto deposit = [&](const CScript& script, uint64_t amount, const uint256& asset_id, const std::string& dest_address) {
+        return MakeDeposit(m_rng.rand256(), script, amount, asset_id, params::CHAIN_ETHEREUM, dest_address);
+    };
+    const CTransactionRef good = deposit(BRIDGE_SCRIPT, params::MIN_TRANSFER_AMOUNT, uint256{1}, "0x0");
+    const CTransactionRef other = deposit(BRIDGE_SCRIPT, params::MIN_TRANSFER_AMOUNT, uint256{1}, "0x0");
+
+    // No deposit is accepted until the source chain has a deposit script
+    BOOST_CHECK(!FindBridgeDeposit(transfer, *good));
+    BOOST_CHECK(!SubmitBridgeTransferProof(transfer_ids[0], *good, {}));
+    SetBridgeDepositScript(params::CHAIN_BITCOIN, BRIDGE_SCRIPT);
+    BOOST_CHECK(FindBridgeDeposit(transfer, *good) == COutPoint(good->GetHash(), 1));
+
+    // The deposit must pay the bridge exactly the transfer amount, committing
+    // to the transfer's asset and destination
+    BOOST_CHECK(!FindBridgeDeposit(transfer, *deposit(CScript() << OP_TRUE, params::MIN_TRANSFER_AMOUNT, uint256{1}, "0x0")));
+    BOOST_CHECK(!FindBridgeDeposit(transfer, *deposit(BRIDGE_SCRIPT, params::MIN_TRANSFER_AMOUNT - 1, uint256{1}, "0x0")));
+    BOOST_CHECK(!FindBridgeDeposit(transfer, *deposit(BRIDGE_SCRIPT, params::MIN_TRANSFER_AMOUNT + 1, uint256{1}, "0x0")));
+    BOOST_CHECK(!FindBridgeDeposit(transfer, *deposit(BRIDGE_SCRIPT, params::MIN_TRANSFER_AMOUNT, uint256{2}, "0x0")));
+    const CTransactionRef elsewhere = deposit(BRIDGE_SCRIPT, params::MIN_TRANSFER_AMOUNT, uint256{1}, "0x1");
+    BOOST_CHECK(!FindBridgeDeposit(transfer, *elsewhere));
+    BOOST_CHECK(!SubmitBridgeTransferProof(transfer_ids[0], *elsewhere, {}));
+
+    // Each deposit output is spent by one transfer, which keeps it
+    BOOST_CHECK(SubmitBridgeTransferProof(transfer_ids[0], *good, {}));
+    BOOST_CHECK(SubmitBridgeTransferProof(transfer_ids[0], *good, {1}));
+    BOOST_CHECK(!SubmitBridgeTransferProof(transfer_ids[1], *good, {}));
+    BOOST_CHECK(!SubmitBridgeTransferProof(transfer_ids[0], *other, {}));
+    BOOST_CHECK(SubmitBridgeTransferProof(transfer_ids[1], *other, {}));
+    const BridgeNetworkState state = GetBridgeNetworkState();
+    BOOST_CHECK(state.active_transfers.at(transfer_ids[0]).source_outpoint == COutPoint(good->GetHash(), 1));
+    BOOST_CHECK_EQUAL(state.active_transfers.at(transfer_ids[0]).source_tx_hash, good->GetHash().ToUint256());
+
+    // Spent deposits are remembered across restarts
+    BOOST_REQUIRE(InitializeBridgeSystem());
+    SetBridgeStore(OpenBridgeDB(path, /*wipe=*/false), 100);
+    SetBridgeDepositScript(params::CHAIN_BITCOIN, BRIDGE_SCRIPT);
+    BOOST_REQUIRE(InitiateBridgeTransfer(alice, params::CHAIN_BITCOIN, params::CHAIN_ETHEREUM, uint256{1},
+                                         params::MIN_TRANSFER_AMOUNT, "0x0"));
+    uint256 replay;
+    for (const uint256& transfer_id : ActiveTransferIds()) {
+        if (std::find(transfer_ids.begin(), transfer_ids.end(), transfer_id) == transfer_ids.end()) replay = transfer_id;
+    }
+    BOOST_CHECK(!SubmitBridgeTransferProof(replay, *good, {}));
+    BOOST_CHECK(!SubmitBridgeTransferProof(replay, *other, {}));
+    BOOST_CHECK(SubmitBridgeTransferProof(replay, *deposit(BRIDGE_SCRIPT, params::MIN_TRANSFER_AMOUNT, uint256{1}, "0x0"), {}));
+
+    // And in memory while there is no store
+    BOOST_REQUIRE(InitializeBridgeSystem());
+    SetBridgeDepositScript(params::CHAIN_BITCOIN, BRIDGE_SCRIPT);
+    for (int i = 0; i < 2; ++i) {
+        BOOST_REQUIRE(InitiateBridgeTransfer(alice, params::CHAIN_BITCOIN, params::CHAIN_ETHEREUM, uint256{1},
+                                             params::MIN_TRANSFER_AMOUNT, "0x0"));
+    }
+    const std::vector<uint256> unstored = ActiveTransferIds();
+    BOOST_CHECK(SubmitBridgeTransferProof(unstored[0], *good, {}));
+    BOOST_CHECK(!SubmitBridgeTransferProof(unstored[1], *good, {}));
+
+    BOOST_REQUIRE(InitializeBridgeSystem());
+}
+
+BOOST_AUTO_TEST_CASE(timer_wheel)
+{
+    interop::HeightTimerWheel wheel{100};
+    const uint256 past{1}, near{2}, cascading{3}, far{4}, overflow{5};
+    wheel.Schedule(50, past);
+    wheel.Schedule(110, near);
+    wheel.Schedule(100 + 5000, cascading);
+    wheel.Schedule(300000, far);
+    wheel.Schedule(100 + (1 << 25), overflow);
+    BOOST_CHECK_EQUAL(wheel.Size(), 5U);
+
+    // Timers already due expire at the next height
+    BOOST_CHECK(wheel.Advance(101) == std::vector<uint256>{past});
+    BOOST_CHECK(wheel.Advance(109).empty());
+    BOOST_CHECK(wheel.Advance(110) == std::vector<uint256>{near});
+    BOOST_CHECK(wheel.Advance(100 + 4999).empty());
+    BOOST_CHECK(wheel.Advance(100 + 5000) == std::vector<uint256>{cascading});
+    BOOST_CHECK(wheel.Advance(299999).empty());
+    BOOST_CHECK(wheel.Advance(300000) == std::vector<uint256>{far});
+    BOOST_CHECK(wheel.Advance(100 + (1 << 25) - 1).empty());
+    BOOST_CHECK(wheel.Advance(100 + (1 << 25)) == std::vector<uint256>{overflow});
+    BOOST_CHECK_EQUAL(wheel.Size(), 0U);
+
+    // Each timer expires exactly at its height, in order, however far ahead
+    // it was scheduled and whichever step it was scheduled at
+    std::multimap<uint32_t, uint256> expected;
+    for (int step = 0; step < 200; ++step) {
+        const uint32_t height = wheel.GetHeight();
+        for (int i = 0; i < 10; ++i) {
+            const uint32_t due = height + 1 + m_rng.randrange(1 << (2 * (i + 1)));
+            const uint256 id = m_rng.rand256();
+            wheel.Schedule(due, id);
+            expected.emplace(due, id);
+        }
+        const uint32_t next = height + 1 + m_rng.randrange(100);
+        const std::vector<uint256> expired = wheel.Advance(next);
+        std::vector<uint256> due;
+        for (auto it = expected.begin(); it != expected.end() && it->first <= next; it = expected.erase(it)) {
+            due.push_back(it->second);
+        }
+        // Within a height, order is unspecified
+        BOOST_CHECK_EQUAL(expired.size(), due.size());
+        BOOST_CHECK(std::is_permutation(expired.begin(), expired.end(), due.begin(), due.end()));
+        BOOST_CHECK_EQUAL(wheel.Size(), expected.size());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(bridge_store)
+{
+    const fs::path path = m_path_root / "bridges";
+    BOOST_REQUIRE(InitializeBridgeSystem());
+    SetBridgeStore(OpenBridgeDB(path, /*wipe=*/true), 100);
+
+    const uint256 alice = m_rng.rand256(), bob = m_rng.rand256();
+    for (int i = 0; i < 3; ++i) {
+        BOOST_REQUIRE(InitiateBridgeTransfer(alice, params::CHAIN_BITCOIN, params::CHAIN_ETHEREUM, uint256{1},
+                                             params::MIN_TRANSFER_AMOUNT, "0x0"));
+    }
+    const std::vector<uint256> transfer_ids = ActiveTransferIds();
+
+    const uint256 secret = m_rng.rand256();
+    const uint256 hash_lock = (HashWriter{} << secret).GetHash();
+    // Swaps expiring at 200, 300 and 300, the last of which is redeemed
+    std::vector<uint256> swap_ids;
+    for (const uint32_t timeout_height : {200, 300, 300}) {
+        BOOST_REQUIRE(InitiateAtomicSwap(alice, params::CHAIN_BITCOIN, params::CHAIN_ETHEREUM, uint256{1}, uint256{2},
+                                         params::MIN_TRANSFER_AMOUNT, params::MIN_TRANSFER_AMOUNT, hash_lock, timeout_height));
+        for (const uint256& swap_id : ActiveSwapIds()) {
+            if (std::find(swap_ids.begin(), swap_ids.end(), swap_id) == swap_ids.end()) swap_ids.push_back(swap_id);
+        }
+    }
+    BOOST_REQUIRE_EQUAL(swap_ids.size(), 3U);
+    BOOST_REQUIRE(ParticipateAtomicSwap(swap_ids[1], bob));
+    BOOST_REQUIRE(ParticipateAtomicSwap(swap_ids[2], bob));
+    BOOST_REQUIRE(RedeemAtomicSwap(swap_ids[2], secret));
+
+    // Finished operations leave memory, but not the store
+    ProcessBridgeBlock(199);
+    BOOST_CHECK_EQUAL(GetBridgeNetworkState().active_swaps.size(), 2U);
+    ProcessBridgeBlock(200);
+    BOOST_CHECK(ActiveSwapIds() == std::vector<uint256>{swap_ids[1]});
+    BOOST_CHECK_EQUAL(GetUserAtomicSwaps(alice).size(), 3U);
+    std::map<uint256, AtomicSwap::Status> bob_swaps;
+    for (const AtomicSwap& swap : GetUserAtomicSwaps(bob)) bob_swaps[swap.swap_id] = swap.status;
+    BOOST_CHECK(bob_swaps == (std::map<uint256, AtomicSwap::Status>{{swap_ids[1], AtomicSwap::SWAP_PARTICIPATED},
+                                                                    {swap_ids[2], AtomicSwap::SWAP_REDEEMED}}));
+    BOOST_CHECK_EQUAL(GetBridgeTransfersWithStatus(BridgeTransfer::TRANSFER_PENDING).size(), 3U);
+
+    // Reopening loads the unfinished operations, with their timers
+    BOOST_REQUIRE(InitializeBridgeSystem());
+    BOOST_CHECK(GetBridgeNetworkState().active_transfers.empty());
+    SetBridgeStore(OpenBridgeDB(path, /*wipe=*/false), 250);
+    BOOST_CHECK(ActiveTransferIds() == transfer_ids);
+    BOOST_CHECK(ActiveSwapIds() == std::vector<uint256>{swap_ids[1]});
+
+    ProcessBridgeBlock(300);
+    BOOST_CHECK(GetBridgeNetworkState().active_swaps.empty());
+    BOOST_CHECK(GetUserAtomicSwaps(bob).size() == 2);
+    ProcessBridgeBlock(100 + params::BRIDGE_TIMEOUT - 1);
+    BOOST_CHECK_EQUAL(GetBridgeNetworkState().active_transfers.size(), 3U);
+    ProcessBridgeBlock(100 + params::BRIDGE_TIMEOUT);
+    BOOST_CHECK(GetBridgeNetworkState().active_transfers.empty());
+    BOOST_CHECK(GetBridgeTransfersWithStatus(BridgeTransfer::TRANSFER_PENDING).empty());
+    BOOST_CHECK_EQUAL(GetBridgeTransfersWithStatus(BridgeTransfer::TRANSFER_REFUNDED).size(), 3U);
+    for (const BridgeTransfer& transfer : GetUserBridgeTransfers(alice)) {
+        BOOST_CHECK_EQUAL(transfer.status, BridgeTransfer::TRANSFER_REFUNDED);
+        BOOST_CHECK_EQUAL(transfer.completion_height, 100U + params::BRIDGE_TIMEOUT);
+    }
+    BOOST_CHECK_EQUAL(GetUserBridgeTransfers(alice).size(), 3U);
+
+    BOOST_REQUIRE(InitializeBridgeSystem());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
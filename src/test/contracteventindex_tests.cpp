@@ -0,0 +1,117 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <arith_uint256.h>
+#include <chain.h>
+#include <index/contracteventindex.h>
+#include <interfaces/chain.h>
+#include <smartcontracts/vm.h>
+#include <test/util/index.h>
+#include <test/util/setup_common.h>
+#include <test/util/smartcontracts.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+using smartcontracts::ContractCall;
+using smartcontracts::ContractEvent;
+
+static uint256 Word(uint64_t n)
+{
+    return ArithToUint256(arith_uint256(n));
+}
+
+static ContractEvent MakeEvent(uint64_t address, std::vector<uint256> topics)
+{
+    ContractEvent event;
+    event.contract_address = Word(address);
+    event.tx_hash = Word(address << 8);
+    event.topics = std::move(topics);
+    event.data = {0xde, 0xad};
+    return event;
+}
+
+BOOST_AUTO_TEST_SUITE(contracteventindex_tests)
+
+BOOST_FIXTURE_TEST_CASE(contracteventindex_range_query, TestChain100Setup)
+{
+    MemoryContractReceiptStore::ReceiptMap stored;
+    smartcontracts::SetContractReceiptStore(std::make_unique<MemoryContractReceiptStore>(stored));
+
+    // Blocks 101 and 102 each carry a contract call, whose receipts are
+    // written as they are connected
+    const CScript coinbase_script = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    std::vector<uint256> block_hashes;
+    for (int i = 0; i < 2; ++i) {
+        ContractCall call;
+        call.kind = ContractCall::DEPLOY;
+        call.gas_limit = smartcontracts::vm::MAX_GAS_LIMIT;
+        call.data = {0x5b};
+        const CMutableTransaction tx = CreateValidMempoolTransaction(
+            {m_coinbase_txns[i]}, {COutPoint(m_coinbase_txns[i]->GetHash(), 0)}, /*input_height=*/i + 1, {coinbaseKey},
+            {CTxOut(0, smartcontracts::BuildContractCallScript(call)), CTxOut(m_coinbase_txns[i]->vout[0].nValue - 10000, coinbase_script)}, /*submit=*/false);
+        block_hashes.push_back(CreateAndProcessBlock({tx}, coinbase_script).GetHash());
+        BOOST_REQUIRE(stored.count(block_hashes.back()));
+        BOOST_CHECK_EQUAL(stored[block_hashes.back()].size(), 1U);
+    }
+
+    // The EVM layer does not emit events yet, so add them to the receipts
+    stored[block_hashes[0]][0].logs = {MakeEvent(1, {Word(100)}), MakeEvent(2, {Word(200), Word(201)})};
+    stored[block_hashes[1]][0].logs = {MakeEvent(1, {Word(201)})};
+
+    const CBlockIndex* tip;
+    {
+        LOCK(cs_main);
+        tip = m_node.chainman->ActiveChain().Tip();
+    }
+
+    ContractEventIndex index(interfaces::MakeChain(m_node), 1 << 20, true);
+    BOOST_REQUIRE(index.Init());
+
+    // Nothing can be looked up before the index is synced
+    std::vector<IndexedContractEvent> events;
+    BOOST_CHECK(!index.LookupEvents(0, tip, {}, {}, events));
+
+    BOOST_REQUIRE(index.StartBackgroundSync());
+    IndexWaitSynced(index, *Assert(m_node.shutdown_signal));
+
+    BOOST_REQUIRE(index.LookupEvents(0, tip, {}, {}, events));
+    BOOST_REQUIRE_EQUAL(events.size(), 3U);
+    BOOST_CHECK_EQUAL(events[0].height, 101);
+    BOOST_CHECK_EQUAL(events[1].log_index, 1U);
+    BOOST_CHECK(events[1].event.topics[1] == Word(201));
+    BOOST_CHECK_EQUAL(events[2].height, 102);
+    BOOST_CHECK(events[2].block_hash == block_hashes[1]);
+
+    // Address and topic filters
+    events.clear();
+    BOOST_REQUIRE(index.LookupEvents(0, tip, {Word(1)}, {}, events));
+    BOOST_CHECK_EQUAL(events.size(), 2U);
+    events.clear();
+    BOOST_REQUIRE(index.LookupEvents(0, tip, {}, {Word(201)}, events));
+    BOOST_CHECK_EQUAL(events.size(), 2U);
+    events.clear();
+    BOOST_REQUIRE(index.LookupEvents(0, tip, {Word(2)}, {Word(100)}, events));
+    BOOST_CHECK(events.empty());
+    BOOST_REQUIRE(index.LookupEvents(102, tip, {Word(2)}, {}, events));
+    BOOST_CHECK(events.empty());
+
+    // Blocks connected after the initial sync are indexed too
+    const CBlock block = CreateAndProcessBlock({}, CScript() << OP_TRUE);
+    BOOST_CHECK(index.BlockUntilSyncedToCurrentChain());
+    {
+        LOCK(cs_main);
+        tip = m_node.chainman->ActiveChain().Tip();
+    }
+    BOOST_CHECK(tip->GetBlockHash() == block.GetHash());
+    BOOST_REQUIRE(index.LookupEvents(tip->nHeight, tip, {}, {}, events));
+    BOOST_CHECK(events.empty());
+    BOOST_CHECK(!index.LookupEvents(tip->nHeight + 1, tip, {}, {}, events));
+
+    m_node.validation_signals->SyncWithValidationInterfaceQueue();
+    index.Stop();
+    smartcontracts::SetContractReceiptStore(nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
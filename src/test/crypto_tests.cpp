@@ -355,6 +355,10 @@ void TestHKDF_SHA256_32(const std::string &ikm_hex, const std::string &salt_hex,
 }
 
 void TestSHA3_256(const std::string& input, const std::string& output);
+void TestKeccak256(const std::string& input, const std::string& output);
+void TestSHA3_512(const std::string& input, const std::string& output);
+template <typename Shake>
+void TestShake(const std::string& input, const std::string& output);
 }; // struct CryptoTests
 } // namespace crypto_tests
 
@@ -1192,6 +1196,170 @@ BOOST_AUTO_TEST_CASE(sha3_256_tests)
     TestSHA3_256("72c57c359e10684d0517e46653a02d18d29eff803eb009e4d5eb9e95add9ad1a4ac1f38a70296f3a369a16985ca3c957de2084cdc9bdd8994eb59b8815e0debad4ec1f001feac089820db8becdaf896aaf95721e8674e5d476b43bd2b873a7d135cd685f545b438210f9319e4dcd55986c85303c1ddf18dc746fe63a409df0a998ed376eb683e16c09e6e9018504152b3e7628ef350659fb716e058a5263a18823d2f2f6ee6a8091945a48ae1c5cb1694cf2c1fe76ef9177953afe8899cfa2b7fe0603bfa3180937dadfb66fbbdd119bbf8063338aa4a699075a3bfdbae8db7e5211d0917e9665a702fc9b0a0a901d08bea97654162d82a9f05622b060b634244779c33427eb7a29353a5f48b07cbefa72f3622ac5900bef77b71d6b314296f304c8426f451f32049b1f6af156a9dab702e8907d3cd72bb2c50493f4d593e731b285b70c803b74825b3524cda3205a8897106615260ac93c01c5ec14f5b11127783989d1824527e99e04f6a340e827b559f24db9292fcdd354838f9339a5fa1d7f6b2087f04835828b13463dd40927866f16ae33ed501ec0e6c4e63948768c5aeea3e4f6754985954bea7d61088c44430204ef491b74a64bde1358cecb2cad28ee6a3de5b752ff6a051104d88478653339457ac45ba44cbb65f54d1969d047cda746931d5e6a8b48e211416aefd5729f3d60b56b54e7f85aa2f42de3cb69419240c24e67139a11790a709edef2ac52cf35dd0a08af45926ebe9761f498ff83bfe263d6897ee97943a4b982fe3404ef0b4a45e06113c60340e0664f14799bf59cb4b3934b465fabefd87155905ee5309ba41e9e402973311831ea600b16437f71df39ee77130490c4d0227e5d1757fdc66af3ae6b9953053ed9aafca0160209858a7d4dd38fe10e0cb153672d08633ed6c54977aa0a6e67f9ff2f8c9d22dd7b21de08192960fd0e0da68d77c8d810db11dcaa61c725cd4092cbff76c8e1debd8d0361bb3f2e607911d45716f53067bdc0d89dd4889177765166a424e9fc0cb711201099dda213355e6639ac7eb86eca2ae0ab38b7f674f37ef8a6fcca1a6f52f55d9e1dcd631d2c3c82bba129172feb991d5af51afecd9d61a88b6832e4107480e392aed61a8644f551665ebff6b20953b635737a4f895e429fddcfe801f606fbda74b3bf6f5767d0fac14907fcfd0aa1d4c11b9e91b01d68052399b51a29f1ae6acd965109977c14a555cbcbd21ad8cb9f8853506d4bc21c01e62d61d7b21be1b923be54914e6b0a7ca84dd11f1159193e1184568a6134a6bbadf5b4df986edcf2019390ae841cfaa44435e28ce877d3dae4177992fa5d4e5c005876dbe3d1e63bec7dcc0942762b48b1ecc6c1a918409a8a72812a1e245c0c67be6e729c2b49bc6ee4d24a8f63e78e75db45655c26a9a78aff36fcd67117f26b8f654dca664b9f0e30681874cb749e1a692720078856286c2560b0292cc837933423147569350955c9571bf8941ba128fd339cb4268f46b94bc6ee203eb7026813706ea51c4f24c91866fc23a724bf2501327e6ae89c29f8db315dc28d2c7c719514036367e018f4835f63fdecd71f9bdced7132b6c4f8b13c69a517026fcd3622d67cb632320d5e7308f78f4b7cea11f6291b137851dc6cd6366f2785c71c3f237f81a7658b2a8d512b61e0ad5a4710b7b124151689fcb2116063fbff7e9115fed7b93de834970b838e49f8f8ba5f1f874c354078b5810a55ae289a56da563f1da6cd80a3757d6073fa55e016e45ac6cec1f69d871c92fd0ae9670c74249045e6b464787f9504128736309fed205f8df4d90e332908581298d9c75a3fa36ab0c3c9272e62de53ab290c803d67b696fd615c260a47bffad16746f18ba1a10a061bacbea9369693b3c042eec36bed289d7d12e52bca8aa1c2dff88ca7816498d25626d0f1e106ebb0b4a12138e00f3df5b1c2f49d98b1756e69b641b7c6353d99dbff050f4d76842c6cf1c2a4b062fc8e6336fa689b7c9d5c6b4ab8c15a5c20e514ff070a602d85ae52fa7810c22f8eeffd34a095b93342144f7a98d024216b3d68ed7bea047517bfcd83ec83febd1ba0e5858e2bdc1d8b1f7b0f89e90ccc432a3f930cb8209462e64556c5054c56ca2a85f16b32eb83a10459d13516faa4d23302b7607b9bd38dab2239ac9e9440c314433fdfb3ceadab4b4f87415ed6f240e017221f3b5f7ac196cdf54957bec42fe6893994b46de3d27dc7fb58ca88feb5b9e79cf20053d12530ac524337b22a3629bea52f40b06d3e2128f32060f9105847daed81d35f20e2002817434659baff64494c5b5c7f9216bfda38412a0f70511159dc73bb6bae1f8eaa0ef08d99bcb31f94f6be12c29c83df45926430b366c99fca3270c15fc4056398fdf3135b7779e3066a006961d1ac0ad1c83179ce39e87a96b722ec23aabc065badf3e188347a360772ca6a447abac7e6a44f0d4632d52926332e44a0a86bff5ce699fd063bdda3ffd4c41b53ded49fecec67f40599b934e16e3fd1bc063ad7026f8d71bfd4cbaf56599586774723194b692036f1b6bb242e2ffb9c600b5215b412764599476ce475c9e5b396fbcebd6be323dcf4d0048077400aac7500db41dc95fc7f7edbe7c9c2ec5ea89943fe13b42217eef530bbd023671509e12dfce4e1c1c82955d965e6a68aa66f6967dba48feda572db1f099d9a6dc4bc8edade852b5e824a06890dc48a6a6510ecaf8cf7620d757290e3166d431abecc624fa9ac2234d2eb783308ead45544910c633a94964b2ef5fbc409cb8835ac4147d384e12e0a5e13951f7de0ee13eafcb0ca0c04946d7804040c0a3cd088352424b097adb7aad1ca4495952f3e6c0158c02d2bcec33bfda69301434a84d9027ce02c0b9725dad118", "d894b86261436362e64241e61f6b3e6589daf64dc641f60570c4c0bf3b1f2ca3");
 }
 
+void CryptoTest::TestKeccak256(const std::string& input, const std::string& output)
+{
+    const auto in_bytes = ParseHex(input);
+    const auto out_bytes = ParseHex(output);
+
+    Keccak256 keccak;
+    unsigned char out[Keccak256::OUTPUT_SIZE];
+    keccak.Write(in_bytes).Finalize(out);
+    BOOST_CHECK(std::equal(std::begin(out_bytes), std::end(out_bytes), out));
+
+    // Reset and split randomly in 2
+    keccak.Reset();
+    int s1 = m_rng.randrange(in_bytes.size() + 1);
+    keccak.Write(Span{in_bytes}.first(s1)).Write(Span{in_bytes}.subspan(s1)).Finalize(out);
+    BOOST_CHECK(std::equal(std::begin(out_bytes), std::end(out_bytes), out));
+}
+
+BOOST_AUTO_TEST_CASE(keccak256_tests)
+{
+    // Legacy Keccak padding, as used by Ethereum (differs from SHA3-256 only in the domain byte).
+    TestKeccak256("", "c5d2460186f7233c927e7db2dcc703c0e500b653ca82273b7bfad8045d85a470");
+    TestKeccak256("616263", "4e03657aea45a94fc7d47ba826c8d667c0d1e6e33a64a036ec44f58fa12d6c45");
+    TestKeccak256(HexStr(std::string{"The quick brown fox jumps over the lazy dog"}), "4d741b6f1eb29cb2a9b9911c82f56fa8d73b04959d3d9d222895df6c0b28aa15");
+    // Inputs around the 136-byte rate boundary.
+    TestKeccak256(HexStr(std::string(135, 'a')), "34367dc248bbd832f4e3e69dfaac2f92638bd0bbd18f2912ba4ef454919cf446");
+    TestKeccak256(HexStr(std::string(136, 'a')), "a6c4d403279fe3e0af03729caada8374b5ca54d8065329a3ebcaeb4b60aa386e");
+    TestKeccak256(HexStr(std::string(200, 'a')), "96ea54061def936c4be90b518992fdc6f12f535068a256229aca54267b4d084d");
+
+    // Keccak256Many must agree with hashing every input on its own, for any mix of lengths.
+    for (int i = 0; i < 100; ++i) {
+        const size_t count = m_rng.randrange(2 * KECCAK_WAYS + 2);
+        std::vector<std::vector<unsigned char>> data(count);
+        std::vector<Span<const unsigned char>> inputs;
+        for (auto& d : data) {
+            d = m_rng.randbytes(m_rng.randrange(3 * Keccak256::RATE_BYTES));
+            inputs.emplace_back(d);
+        }
+        std::vector<unsigned char> out(count * Keccak256::OUTPUT_SIZE);
+        Keccak256Many(out.data(), inputs);
+        for (size_t j = 0; j < count; ++j) {
+            unsigned char expected[Keccak256::OUTPUT_SIZE];
+            Keccak256().Write(data[j]).Finalize(expected);
+            BOOST_CHECK(std::equal(std::begin(expected), std::end(expected), out.begin() + j * Keccak256::OUTPUT_SIZE));
+        }
+    }
+}
+
+void CryptoTest::TestSHA3_512(const std::string& input, const std::string& output)
+{
+    const auto in_bytes = ParseHex(input);
+    const auto out_bytes = ParseHex(output);
+
+    SHA3_512 sha;
+    unsigned char out[SHA3_512::OUTPUT_SIZE];
+    sha.Write(in_bytes).Finalize(out);
+    BOOST_CHECK(std::equal(std::begin(out_bytes), std::end(out_bytes), out));
+
+    // Reset and split randomly in 3
+    sha.Reset();
+    int s1 = m_rng.randrange(in_bytes.size() + 1);
+    int s2 = m_rng.randrange(in_bytes.size() + 1 - s1);
+    int s3 = in_bytes.size() - s1 - s2;
+    sha.Write(Span{in_bytes}.first(s1)).Write(Span{in_bytes}.subspan(s1, s2));
+    sha.Write(Span{in_bytes}.last(s3)).Finalize(out);
+    BOOST_CHECK(std::equal(std::begin(out_bytes), std::end(out_bytes), out));
+}
+
+template <typename Shake>
+void CryptoTest::TestShake(const std::string& input, const std::string& output)
+{
+    const auto in_bytes = ParseHex(input);
+    const auto out_bytes = ParseHex(output);
+
+    std::vector<unsigned char> out(out_bytes.size());
+    Shake().Write(in_bytes).Read(out);
+    BOOST_CHECK(out == out_bytes);
+
+    // Write split randomly in 2, read split randomly in 3
+    Shake shake;
+    int s1 = m_rng.randrange(in_bytes.size() + 1);
+    shake.Write(Span{in_bytes}.first(s1)).Write(Span{in_bytes}.subspan(s1));
+    int r1 = m_rng.randrange(out.size() + 1);
+    int r2 = m_rng.randrange(out.size() + 1 - r1);
+    int r3 = out.size() - r1 - r2;
+    out.assign(out.size(), 0);
+    shake.Read(Span{out}.first(r1)).Read(Span{out}.subspan(r1, r2)).Read(Span{out}.last(r3));
+    BOOST_CHECK(out == out_bytes);
+}
+
+BOOST_AUTO_TEST_CASE(sha3_512_tests)
+{
+    // Checked against Python's hashlib. Inputs around the 72-byte rate cover
+    // padding in the last byte of a block and a block of padding alone.
+    TestSHA3_512("", "a69f73cca23a9ac5c8b567dc185a756e97c982164fe25859e0d1dcc1475c80a615b2123af1f5f94c11e3e9402c3ac558f500199d95b6d3e301758586281dcd26");
+    TestSHA3_512("616263", "b751850b1a57168a5693cd924b6b096e08f621827444f70d884f5d0240d2712e10e116e9192af3c91a7ec57647e3934057340b4cf408d5a56592f8274eec53f0");
+    TestSHA3_512("e9", "b6425abe22a90afc2acc3608fba4d39fafb6574fe1ff6d9ce5a4950e9ee28a082b057e7e02a07b39645e1d5d337b3413ff23685a598f98c11146945836c6538f");
+    TestSHA3_512(HexStr(std::string(71, 'a')), "070faf98d2a8fddf8ed886408744dc06456096c2e045f26f3c7b010530e6bbb3db535a54d636856f4e0e1e982461cb9a7e8e57ff8895cff1619af9f0e486e28c");
+    TestSHA3_512(HexStr(std::string(72, 'a')), "a8ae722a78e10cbbc413886c02eb5b369a03f6560084aff566bd597bb7ad8c1ccd86e81296852359bf2faddb5153c0a7445722987875e74287adac21adebe952");
+    TestSHA3_512(HexStr(std::string(73, 'a')), "23e6a8815f8201dbbf6a5463be8dcadb1acea9df5f8998954e59ac9565cf6d29b17aa27a5e8b0fc06343db6122d6e544d27583ddc78504d08203217e7e65b6bd");
+    TestSHA3_512(HexStr(std::string(200, 'a')), "eae6c85c6904f11075de9f9d5e1064371d000510fa3d2d79d40cf9be34892fb01859d0a0234e138bcb0ad5c84f6c0dca226a414b0c9a2897cb695f5185fe36ec");
+}
+
+BOOST_AUTO_TEST_CASE(shake_tests)
+{
+    // Checked against Python's hashlib, with outputs longer than the rate.
+    TestShake<SHAKE128>("", "7f9c2ba4e88f827d616045507605853ed73b8093f6efbc88eb1a6eacfa66ef26");
+    TestShake<SHAKE128>("616263", "5881092dd818bf5cf8a3ddb793fbcba74097d5c526a6d35f97b83351940f2cc8");
+    TestShake<SHAKE128>(HexStr(std::string(167, 'a')), "4f5c6c53ae8190a8ff8a55b2125d28703052d10278570960c2066a905d916c345cd44d8a367360c0a03da17ba8c8801afb7b7a047b0e2ea86fc81f76e8623720");
+    TestShake<SHAKE128>(HexStr(std::string(168, 'a')), "c22e11586c22b713bde373fce93314d76829de2c21d940a28eb659b8dec953a2e1a42704cb8008a18811824b68c7d2c5cf0602a44a2ba045d366ef3f2ae9cab28c77b9fbe14e726fd35d2fe3e621081824fccb2ab260d932e289428c824ac1622a8535252bc2bcc88989657180d867561333d72d58b7199e9081d27a9054bb1a6b46ca84881929c158f30ac712df29babfaefc40c4cee77765f2e9d0cc2a0dc354f9304f2975ad76d54202ae6e4da8a4842fc11ddc6536a7be00919a5820c12a5ddd718e1b24fcd3");
+    TestShake<SHAKE256>("", "46b9dd2b0ba88d13233b3feb743eeb243fcd52ea62b81b82b50c27646ed5762fd75dc4ddd8c0f200cb05019d67b592f6fc821c49479ab48640292eacb3b7c4be");
+    TestShake<SHAKE256>("616263", "483366601360a8771c6863080cc4114d8db44530f8f1e1ee4f94ea37e78b5739d5a15bef186a5386c75744c0527e1faa9f8726e462a12a4feb06bd8801e751e4");
+    TestShake<SHAKE256>(HexStr(std::string(135, 'a')), "55b991ece1e567b6e7c2c714444dd201cd51f4f3832d08e1d26bebc63e07a3d7ddeed4a5aa6df7a15f89f2050566f75d9cf1a4dea4ed1f578df0985d5706d49e");
+    TestShake<SHAKE256>(HexStr(std::string(136, 'a')), "8fcc5a08f0a1f6827c9cf64ee8d16e0443106359ca6c8efd230759256f44996a703c7fa566b8308f7050f4c717418c5ef75f512d1ba01f4f1ff5984e1bc89efd19158476dbf0a60f1b4a420ec9cddf767a417dbaa363b368a74da06d8489991c2b74d30ed9b6be659d3964a3b358b20c938116560d0e077919338eb725a7a469e2cf0e95801194308ba9d43ae41d2e4e7c1cb4992dfb8c3a32124270bf6fcea9c20d6cce34d2d2bda2359d05f408c51816aeea0b509232b37585052b1192f91e8442669cb19c38a04f222531cb5f7784e0cfa0cfd03d2868b82379ef02561b5034d97dc2a2fa103dc5e65abd94cb60b12be7b7947f91210f9d2a2460356b50b0510c6d089bcd83ec04622f7e02455af94f1819b8ffab955003153b68204daa45a23735cae20fd6f006f1857f");
+}
+
+BOOST_AUTO_TEST_CASE(keccak_4way_tests)
+{
+    for (const auto use_implementation : {keccak_implementation::STANDARD, keccak_implementation::USE_ALL}) {
+        const std::string implementation = KeccakAutoDetect(use_implementation);
+        BOOST_TEST_MESSAGE("Using the '" << implementation << "' Keccak implementation");
+
+        // KeccakF_4way must permute every state as KeccakF does.
+        uint64_t states[25][KECCAK_WAYS];
+        uint64_t expected[KECCAK_WAYS][25];
+        for (int i = 0; i < 25; ++i) {
+            for (size_t k = 0; k < KECCAK_WAYS; ++k) states[i][k] = expected[k][i] = m_rng.rand64();
+        }
+        for (int round = 0; round < 8; ++round) {
+            KeccakF_4way(states);
+            for (auto& state : expected) KeccakF(state);
+        }
+        for (int i = 0; i < 25; ++i) {
+            for (size_t k = 0; k < KECCAK_WAYS; ++k) BOOST_CHECK_EQUAL(states[i][k], expected[k][i]);
+        }
+
+        // SHAKE128Many and SHAKE256Many must agree with hashing every input
+        // on its own, for any mix of input and output lengths.
+        for (int i = 0; i < 50; ++i) {
+            const size_t count = m_rng.randrange(2 * KECCAK_WAYS + 2);
+            std::vector<std::vector<unsigned char>> data(count), out128(count), out256(count);
+            std::vector<Span<const unsigned char>> inputs;
+            std::vector<Span<unsigned char>> outputs128, outputs256;
+            for (size_t j = 0; j < count; ++j) {
+                data[j] = m_rng.randbytes(m_rng.randrange(3 * SHAKE128::RATE_BYTES));
+                out128[j].resize(m_rng.randrange(3 * SHAKE128::RATE_BYTES));
+                out256[j].resize(m_rng.randrange(3 * SHAKE256::RATE_BYTES));
+                inputs.emplace_back(data[j]);
+                outputs128.emplace_back(out128[j]);
+                outputs256.emplace_back(out256[j]);
+            }
+            SHAKE128Many(inputs, outputs128);
+            SHAKE256Many(inputs, outputs256);
+            for (size_t j = 0; j < count; ++j) {
+                std::vector<unsigned char> expected128(out128[j].size()), expected256(out256[j].size());
+                SHAKE128().Write(data[j]).Read(expected128);
+                SHAKE256().Write(data[j]).Read(expected256);
+                BOOST_CHECK(out128[j] == expected128);
+                BOOST_CHECK(out256[j] == expected256);
+            }
+        }
+    }
+    KeccakAutoDetect();
+}
+
 static MuHash3072 FromInt(unsigned char i) {
     unsigned char tmp[32] = {i, 0};
     return MuHash3072(tmp);
@@ -284,7 +284,7 @@ FUZZ_TARGET(coins_view, .init = initialize_coins_view)
                 (void)GetTransactionSigOpCost(transaction, coins_view_cache, flags);
             },
             [&] {
-                (void)IsWitnessStandard(CTransaction{random_mutable_transaction}, coins_view_cache);
+                (void)IsWitnessStandard(CTransaction{random_mutable_transaction}, coins_view_cache, fuzzed_data_provider.ConsumeBool());
             });
     }
 }
@@ -367,7 +367,14 @@ std::unique_ptr<Transport> MakeV2Transport(NodeId nodeid, bool initiator, RNG& r
              .Write(garb.data(), garb.size())
              .Finalize(UCharCast(ent.data()));
 
-    return std::make_unique<V2Transport>(nodeid, initiator, key, ent, std::move(garb));
+    // Optionally attempt or offer the hybrid ML-KEM handshake. A responder offering it sends its
+    // encapsulation key ahead of the garbage, which has to fit within the maximum garbage length.
+    const bool hybrid{provider.ConsumeBool()};
+    if (hybrid && !initiator && garb.size() > V2Transport::MAX_GARBAGE_LEN - BIP324Cipher::KEM_ENCAPS_KEY_LEN) {
+        garb.resize(V2Transport::MAX_GARBAGE_LEN - BIP324Cipher::KEM_ENCAPS_KEY_LEN);
+    }
+
+    return std::make_unique<V2Transport>(nodeid, initiator, key, ent, std::move(garb), hybrid);
 }
 
 } // namespace
@@ -0,0 +1,230 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <consensus/governance.h>
+#include <consensus/hybrid.h>
+#include <smartcontracts/vm.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <util/check.h>
+
+#include <memory>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace consensus::governance;
+
+namespace {
+
+std::vector<uint8_t> EncodeChanges(const std::vector<ParameterChange>& changes)
+{
+    DataStream stream{};
+    stream << changes;
+    return {UCharCast(stream.data()), UCharCast(stream.data() + stream.size())};
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(governance_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(parameter_registry)
+{
+    BOOST_REQUIRE(InitializeGovernanceSystem());
+
+    // Defaults come from the parameter table
+    const auto defaults = GetParameters(0);
+    BOOST_CHECK_EQUAL(defaults->Get(parameters::MAX_GAS_LIMIT), smartcontracts::vm::MAX_GAS_LIMIT);
+    BOOST_CHECK_EQUAL(defaults->Get(parameters::EXECUTION_DELAY_BLOCKS), params::EXECUTION_DELAY_BLOCKS);
+    BOOST_CHECK_EQUAL(defaults->GetVersion(), 0U);
+    BOOST_CHECK(FindParameter("max_gas_limit") == PARAM_MAX_GAS_LIMIT);
+    BOOST_CHECK(!FindParameter("no_such_parameter"));
+    BOOST_CHECK_EQUAL(GetParameterValue("max_gas_limit"), "30000000");
+    BOOST_CHECK_EQUAL(GetParameterValue("no_such_parameter"), "");
+
+    // Values are checked against the table's range
+    const ParameterInfo& gas_limit = GetParameterInfo(PARAM_MAX_GAS_LIMIT);
+    BOOST_CHECK(ValidateParameterChange({PARAM_MAX_GAS_LIMIT, gas_limit.min_value}));
+    BOOST_CHECK(ValidateParameterChange({PARAM_MAX_GAS_LIMIT, gas_limit.max_value}));
+    BOOST_CHECK(!ValidateParameterChange({PARAM_MAX_GAS_LIMIT, gas_limit.min_value - 1}));
+    BOOST_CHECK(!ValidateParameterChange({PARAM_MAX_GAS_LIMIT, gas_limit.max_value + 1}));
+    BOOST_CHECK(!ValidateParameterChange({PARAM_COUNT, 0}));
+
+    // Changes take effect together, at their activation height
+    BOOST_REQUIRE(ExecuteParameterChanges({{PARAM_MAX_GAS_LIMIT, 5000000}, {PARAM_EXECUTION_DELAY_BLOCKS, 10}}, 100));
+    BOOST_CHECK_EQUAL(GetParameters(99)->Get(parameters::MAX_GAS_LIMIT), smartcontracts::vm::MAX_GAS_LIMIT);
+    const auto changed = GetParameters(100);
+    BOOST_CHECK_EQUAL(changed->Get(parameters::MAX_GAS_LIMIT), 5000000U);
+    BOOST_CHECK_EQUAL(changed->Get(parameters::EXECUTION_DELAY_BLOCKS), 10);
+    BOOST_CHECK_EQUAL(changed->GetVersion(), 1U);
+    BOOST_CHECK(GetParameters(1000) == changed);
+
+    // One invalid change rejects them all, as does an activation in the past
+    BOOST_CHECK(!ExecuteParameterChanges({{PARAM_EXECUTION_DELAY_BLOCKS, 20}, {PARAM_MAX_GAS_LIMIT, 0}}, 200));
+    BOOST_CHECK(!ExecuteParameterChanges({{PARAM_EXECUTION_DELAY_BLOCKS, 20}}, 99));
+    BOOST_CHECK(GetParameters(1000) == changed);
+
+    BOOST_REQUIRE(ExecuteParameterChanges({{PARAM_EXECUTION_DELAY_BLOCKS, 20}}, 200));
+    BOOST_CHECK_EQUAL(GetParameters(150)->Get(parameters::EXECUTION_DELAY_BLOCKS), 10);
+    BOOST_CHECK_EQUAL(GetParameters(200)->Get(parameters::EXECUTION_DELAY_BLOCKS), 20);
+    BOOST_CHECK_EQUAL(GetParameters(200)->Get(parameters::MAX_GAS_LIMIT), 5000000U);
+
+    // Disconnecting blocks undoes their changes; snapshots held by readers
+    // stay valid, and are freed once released
+    auto held = GetParameters(200);
+    const std::weak_ptr<const ParameterSnapshot> released{held};
+    DisconnectParameterChanges(150);
+    BOOST_CHECK(GetParameters(1000) == changed);
+    DisconnectParameterChanges(99);
+    BOOST_CHECK_EQUAL(GetParameters(1000)->Get(parameters::MAX_GAS_LIMIT), smartcontracts::vm::MAX_GAS_LIMIT);
+    BOOST_CHECK_EQUAL(held->Get(parameters::EXECUTION_DELAY_BLOCKS), 20);
+    held.reset();
+    BOOST_CHECK(released.expired());
+
+    BOOST_REQUIRE(InitializeGovernanceSystem());
+    BOOST_CHECK(GetParameters(1000) == defaults);
+}
+
+BOOST_AUTO_TEST_CASE(parameter_change_proposal_data)
+{
+    GovernanceProposal proposal;
+    proposal.type = PROPOSAL_PARAMETER_CHANGE;
+    proposal.title = "Lower the gas limit";
+    proposal.description = "Contract execution is too slow at the current limit.";
+
+    proposal.data = EncodeChanges({{PARAM_MAX_GAS_LIMIT, 5000000}});
+    BOOST_CHECK(ValidateProposalData(proposal));
+
+    proposal.data = EncodeChanges({{PARAM_MAX_GAS_LIMIT, 0}});
+    BOOST_CHECK(!ValidateProposalData(proposal));
+    proposal.data = EncodeChanges({});
+    BOOST_CHECK(!ValidateProposalData(proposal));
+    proposal.data = EncodeChanges({{PARAM_MAX_GAS_LIMIT, 5000000}});
+    proposal.data.push_back(0);
+    BOOST_CHECK(!ValidateProposalData(proposal));
+    proposal.data.resize(3);
+    BOOST_CHECK(!ValidateProposalData(proposal));
+}
+
+BOOST_AUTO_TEST_CASE(proposal_schedule)
+{
+    BOOST_REQUIRE(InitializeGovernanceSystem());
+    consensus::hybrid::ValidatorNetworkState validators;
+    std::vector<uint256> validator_ids;
+    for (int i = 0; i < 3; ++i) {
+        const uint256& validator_id = validator_ids.emplace_back(m_rng.rand256());
+        BOOST_REQUIRE(consensus::hybrid::RegisterValidator(validator_id, m_rng.rand256(),
+                                                           consensus::hybrid::params::MIN_VALIDATOR_STAKE, validators));
+        BOOST_REQUIRE(consensus::hybrid::ActivateValidator(validator_id, validators));
+    }
+    BOOST_REQUIRE(consensus::hybrid::UpdateValidatorNetworkState(validators));
+
+    BOOST_REQUIRE(CreateProposal(validator_ids[0], PROPOSAL_PARAMETER_CHANGE, "Shorten the execution delay",
+                                 "Approved changes should take effect sooner.",
+                                 EncodeChanges({{PARAM_EXECUTION_DELAY_BLOCKS, 5}})));
+    BOOST_REQUIRE(CreateProposal(validator_ids[1], PROPOSAL_CUSTOM, "Unpopular", "Nobody votes on this.", {}));
+    const auto proposals = GetActiveProposals();
+    BOOST_REQUIRE_EQUAL(proposals.size(), 2U);
+    const uint256 change_id = proposals[0].type == PROPOSAL_PARAMETER_CHANGE ? proposals[0].proposal_id : proposals[1].proposal_id;
+    const uint256 custom_id = proposals[0].type == PROPOSAL_CUSTOM ? proposals[0].proposal_id : proposals[1].proposal_id;
+    const GovernanceProposal& change = *Assert(GetProposal(change_id));
+    const GovernanceProposal& custom = *Assert(GetProposal(custom_id));
+    BOOST_CHECK_EQUAL(change.status, PROPOSAL_PENDING);
+
+    // Voting starts at the next block
+    BOOST_CHECK(!SubmitVote(change_id, validator_ids[0], VoteInfo::VOTE_FOR));
+    ProcessGovernanceBlock(10);
+    BOOST_CHECK_EQUAL(change.status, PROPOSAL_ACTIVE);
+    BOOST_CHECK_EQUAL(custom.status, PROPOSAL_ACTIVE);
+    BOOST_CHECK_EQUAL(change.voting_end_height, 10U + params::VOTING_PERIOD_BLOCKS);
+
+    // Votes are tallied as they are cast, once per validator
+    for (const uint256& validator_id : validator_ids) {
+        BOOST_CHECK(SubmitVote(change_id, validator_id, VoteInfo::VOTE_FOR, "Agreed"));
+    }
+    BOOST_CHECK(!SubmitVote(change_id, validator_ids[0], VoteInfo::VOTE_AGAINST));
+    BOOST_CHECK_EQUAL(GetProposalVotes(change_id).size(), 3U);
+    BOOST_CHECK_EQUAL(change.votes_for, 3 * consensus::hybrid::params::MIN_VALIDATOR_STAKE);
+    BOOST_CHECK_EQUAL(change.voter_count, 3U);
+
+    // Nothing happens before a proposal is due
+    const int voting_end = change.voting_end_height;
+    ProcessGovernanceBlock(voting_end - 1);
+    BOOST_CHECK_EQUAL(change.status, PROPOSAL_ACTIVE);
+    ProcessGovernanceBlock(voting_end);
+    BOOST_CHECK_EQUAL(change.status, PROPOSAL_APPROVED);
+    BOOST_CHECK_EQUAL(custom.status, PROPOSAL_EXPIRED);
+    BOOST_CHECK_EQUAL(change.execution_height, voting_end + params::EXECUTION_DELAY_BLOCKS);
+
+    const int execution = change.execution_height;
+    ProcessGovernanceBlock(execution - 1);
+    BOOST_CHECK_EQUAL(change.status, PROPOSAL_APPROVED);
+    ProcessGovernanceBlock(execution);
+    BOOST_CHECK_EQUAL(change.status, PROPOSAL_EXECUTED);
+    BOOST_CHECK_EQUAL(GetParameters(execution)->Get(parameters::EXECUTION_DELAY_BLOCKS), params::EXECUTION_DELAY_BLOCKS);
+    BOOST_CHECK_EQUAL(GetParameters(execution + 1)->Get(parameters::EXECUTION_DELAY_BLOCKS), 5);
+
+    BOOST_REQUIRE(InitializeGovernanceSystem());
+    BOOST_REQUIRE(consensus::hybrid::UpdateValidatorNetworkState({}));
+}
+
+BOOST_AUTO_TEST_CASE(proposal_disconnect)
+{
+    BOOST_REQUIRE(InitializeGovernanceSystem());
+    consensus::hybrid::ValidatorNetworkState validators;
+    const uint256 validator_id{m_rng.rand256()};
+    BOOST_REQUIRE(consensus::hybrid::RegisterValidator(validator_id, m_rng.rand256(),
+                                                       consensus::hybrid::params::MIN_VALIDATOR_STAKE, validators));
+    BOOST_REQUIRE(consensus::hybrid::ActivateValidator(validator_id, validators));
+    BOOST_REQUIRE(consensus::hybrid::UpdateValidatorNetworkState(validators));
+
+    BOOST_REQUIRE(CreateProposal(validator_id, PROPOSAL_PARAMETER_CHANGE, "Shorten the execution delay",
+                                 "Approved changes should take effect sooner.",
+                                 EncodeChanges({{PARAM_EXECUTION_DELAY_BLOCKS, 5}})));
+    const uint256 proposal_id = GetActiveProposals().at(0).proposal_id;
+    const GovernanceProposal& proposal = *Assert(GetProposal(proposal_id));
+    ProcessGovernanceBlock(10);
+    BOOST_REQUIRE(SubmitVote(proposal_id, validator_id, VoteInfo::VOTE_FOR));
+    const int voting_end = proposal.voting_end_height;
+    ProcessGovernanceBlock(voting_end);
+    const int execution = proposal.execution_height;
+    ProcessGovernanceBlock(execution);
+    BOOST_REQUIRE_EQUAL(proposal.status, PROPOSAL_EXECUTED);
+    BOOST_CHECK_EQUAL(GetGovernanceStatistics().executed_proposals, 1U);
+
+    // Disconnecting the execution block restores the approved proposal and
+    // the parameters, and reconnecting it executes the proposal again
+    DisconnectGovernanceBlock(execution);
+    BOOST_CHECK_EQUAL(proposal.status, PROPOSAL_APPROVED);
+    BOOST_CHECK_EQUAL(GetParameters(execution + 1)->Get(parameters::EXECUTION_DELAY_BLOCKS), params::EXECUTION_DELAY_BLOCKS);
+    BOOST_CHECK_EQUAL(GetGovernanceStatistics().executed_proposals, 0U);
+    ProcessGovernanceBlock(execution);
+    BOOST_CHECK_EQUAL(proposal.status, PROPOSAL_EXECUTED);
+    BOOST_CHECK_EQUAL(GetParameters(execution + 1)->Get(parameters::EXECUTION_DELAY_BLOCKS), 5);
+    BOOST_CHECK_EQUAL(GetGovernanceStatistics().executed_proposals, 1U);
+
+    // A deeper reorg goes back to voting, even after the proposal was
+    // cleaned up, and blocks without changes have nothing to undo
+    CleanupExpiredProposals();
+    BOOST_CHECK(GetActiveProposals().empty());
+    DisconnectGovernanceBlock(execution);
+    DisconnectGovernanceBlock(voting_end + 1);
+    DisconnectGovernanceBlock(voting_end);
+    const GovernanceProposal& restored = *Assert(GetProposal(proposal_id));
+    BOOST_CHECK_EQUAL(restored.status, PROPOSAL_ACTIVE);
+    BOOST_CHECK_EQUAL(restored.votes_for, consensus::hybrid::params::MIN_VALIDATOR_STAKE);
+    BOOST_CHECK_EQUAL(GetActiveProposals().size(), 1U);
+    ProcessGovernanceBlock(voting_end);
+    BOOST_CHECK_EQUAL(restored.status, PROPOSAL_APPROVED);
+    ProcessGovernanceBlock(execution - 1);
+    BOOST_CHECK_EQUAL(restored.status, PROPOSAL_APPROVED);
+    ProcessGovernanceBlock(execution);
+    BOOST_CHECK_EQUAL(restored.status, PROPOSAL_EXECUTED);
+    BOOST_CHECK_EQUAL(GetParameters(execution + 1)->Get(parameters::EXECUTION_DELAY_BLOCKS), 5);
+
+    BOOST_REQUIRE(InitializeGovernanceSystem());
+    BOOST_REQUIRE(consensus::hybrid::UpdateValidatorNetworkState({}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,208 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <consensus/merkle.h>
+#include <interop/bridges.h>
+#include <interop/headerchain.h>
+#include <kernel/chainparams.h>
+#include <merkleblock.h>
+#include <pow.h>
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <util/fs.h>
+
+#include <memory>
+#include <set>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using interop::HeaderChain;
+
+namespace {
+
+class VectorHeaderFeeder final : public interop::HeaderFeeder
+{
+public:
+    explicit VectorHeaderFeeder(std::vector<CBlockHeader> headers) : m_headers{std::move(headers)} {}
+
+    std::vector<CBlockHeader> GetHeaders(const uint256& tip_hash, size_t max_count) override
+    {
+        // Resume after the tip, as a peer answering a locator would
+        size_t begin = 0;
+        for (size_t i = 0; i < m_headers.size(); ++i) {
+            if (m_headers[i].GetHash() == tip_hash) begin = i + 1;
+        }
+        const size_t end = std::min(m_headers.size(), begin + max_count);
+        return {m_headers.begin() + begin, m_headers.begin() + end};
+    }
+
+private:
+    std::vector<CBlockHeader> m_headers;
+};
+
+CBlockHeader MineHeader(const CBlockHeader& prev, const Consensus::Params& params, uint32_t salt = 0,
+                        const uint256& merkle_root = uint256::ONE)
+{
+    CBlockHeader header;
+    header.nVersion = 4;
+    header.hashPrevBlock = prev.GetHash();
+    header.hashMerkleRoot = merkle_root;
+    header.nTime = prev.nTime + 600 + salt;
+    header.nBits = prev.nBits;
+    while (!CheckProofOfWork(header.GetHash(), header.nBits, params)) ++header.nNonce;
+    return header;
+}
+
+std::vector<CBlockHeader> MineHeaders(const CBlockHeader& prev, size_t count, const Consensus::Params& params, uint32_t salt = 0)
+{
+    std::vector<CBlockHeader> headers;
+    for (size_t i = 0; i < count; ++i) {
+        headers.push_back(MineHeader(headers.empty() ? prev : headers.back(), params, salt));
+    }
+    return headers;
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(headerchain_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(header_chain_branches)
+{
+    const auto chainparams = CChainParams::RegTest({});
+    const Consensus::Params& params = chainparams->GetConsensus();
+    const CBlockHeader genesis = chainparams->GenesisBlock();
+    const fs::path path = m_path_root / "branches.dat";
+
+    const std::vector<CBlockHeader> main = MineHeaders(genesis, 30, params);
+    {
+        HeaderChain chain{path, params, genesis};
+        BOOST_CHECK_EQUAL(chain.GetHeight(), 0);
+        BOOST_CHECK(chain.AddHeaders(main));
+        BOOST_CHECK_EQUAL(chain.GetHeight(), 30);
+        BOOST_CHECK_EQUAL(chain.GetTipHash(), main.back().GetHash());
+
+        // Known headers are skipped
+        BOOST_CHECK(chain.AddHeaders(std::span{main}.subspan(10)));
+        BOOST_CHECK_EQUAL(chain.GetHeight(), 30);
+    }
+
+    // Reopening rebuilds the chain from the file
+    HeaderChain chain{path, params, genesis};
+    BOOST_CHECK_EQUAL(chain.GetHeight(), 30);
+    BOOST_CHECK_EQUAL(chain.GetTipHash(), main.back().GetHash());
+    BOOST_CHECK_EQUAL(*chain.GetHeaderHeight(main[9].GetHash()), 10);
+    BOOST_CHECK_EQUAL(chain.GetHeader(10)->GetHash(), main[9].GetHash());
+    BOOST_CHECK(!chain.GetHeader(31));
+    const arith_uint256 work = chain.GetTipWork();
+
+    // A branch with less work is valid but not followed
+    const std::vector<CBlockHeader> short_branch = MineHeaders(main[9], 5, params, /*salt=*/1);
+    BOOST_CHECK(chain.AddHeaders(short_branch));
+    BOOST_CHECK_EQUAL(chain.GetTipHash(), main.back().GetHash());
+    BOOST_CHECK(!chain.GetHeaderHeight(short_branch.back().GetHash()));
+
+    // A branch with more work replaces the chain above the fork
+    const std::vector<CBlockHeader> long_branch = MineHeaders(main[19], 15, params, /*salt=*/2);
+    BOOST_CHECK(chain.AddHeaders(long_branch));
+    BOOST_CHECK_EQUAL(chain.GetHeight(), 35);
+    BOOST_CHECK_EQUAL(chain.GetTipHash(), long_branch.back().GetHash());
+    BOOST_CHECK(chain.GetTipWork() > work);
+    BOOST_CHECK(!chain.GetHeaderHeight(main.back().GetHash()));
+    BOOST_CHECK_EQUAL(*chain.GetHeaderHeight(main[19].GetHash()), 20);
+
+    // Invalid headers are rejected
+    const CBlockHeader& tip = long_branch.back();
+    CBlockHeader header = MineHeader(short_branch.back(), params);
+    BOOST_CHECK(!chain.AddHeaders({&header, 1}));
+    header = MineHeader(tip, params);
+    header.nTime = tip.nTime - 3600;
+    BOOST_CHECK(!chain.AddHeaders({&header, 1}));
+    header = MineHeader(tip, params);
+    header.nBits = UintToArith256(params.powLimit).GetCompact() - 1;
+    while (CheckProofOfWork(header.GetHash(), header.nBits, params)) ++header.nNonce;
+    BOOST_CHECK(!chain.AddHeaders({&header, 1}));
+    std::vector<CBlockHeader> gap = MineHeaders(tip, 2, params);
+    gap.erase(gap.begin());
+    BOOST_CHECK(!chain.AddHeaders(gap));
+    BOOST_CHECK_EQUAL(chain.GetTipHash(), tip.GetHash());
+}
+
+BOOST_AUTO_TEST_CASE(header_chain_sync)
+{
+    const auto chainparams = CChainParams::RegTest({});
+    const Consensus::Params& params = chainparams->GetConsensus();
+    const CBlockHeader genesis = chainparams->GenesisBlock();
+
+    // More headers than a sync batch, to grow the mapping
+    const std::vector<CBlockHeader> headers = MineHeaders(genesis, 20000, params);
+    const fs::path file_path = m_path_root / "headers.bin";
+    {
+        AutoFile file{fsbridge::fopen(file_path, "wb")};
+        for (const CBlockHeader& header : headers) file << header;
+        BOOST_REQUIRE_EQUAL(file.fclose(), 0);
+    }
+
+    HeaderChain from_file{m_path_root / "from_file.dat", params, genesis};
+    interop::FileHeaderFeeder file_feeder{fsbridge::fopen(file_path, "rb")};
+    BOOST_CHECK(from_file.Sync(file_feeder));
+    BOOST_CHECK_EQUAL(from_file.GetHeight(), 20000);
+    BOOST_CHECK_EQUAL(from_file.GetTipHash(), headers.back().GetHash());
+
+    HeaderChain from_peer{m_path_root / "from_peer.dat", params, genesis};
+    VectorHeaderFeeder peer_feeder{headers};
+    BOOST_CHECK(from_peer.Sync(peer_feeder));
+    BOOST_CHECK_EQUAL(from_peer.GetTipHash(), headers.back().GetHash());
+    BOOST_CHECK(from_peer.GetTipWork() == from_file.GetTipWork());
+}
+
+BOOST_AUTO_TEST_CASE(transaction_proofs)
+{
+    const auto chainparams = CChainParams::RegTest({});
+    const Consensus::Params& consensus = chainparams->GetConsensus();
+    const CBlockHeader genesis = chainparams->GenesisBlock();
+    auto chain = std::make_shared<HeaderChain>(m_path_root / "proofs.dat", consensus, genesis);
+
+    CBlock block;
+    for (int i = 0; i < 10; ++i) {
+        CMutableTransaction tx;
+        tx.vin.emplace_back(COutPoint{Txid::FromUint256(m_rng.rand256()), 0});
+        tx.vout.emplace_back(1000, CScript() << OP_TRUE);
+        block.vtx.push_back(MakeTransactionRef(std::move(tx)));
+    }
+    static_cast<CBlockHeader&>(block) = MineHeader(genesis, consensus, 0, BlockMerkleRoot(block));
+    const Txid txid = block.vtx[4]->GetHash();
+    const CMerkleBlock proof{block, std::set<Txid>{txid}};
+
+    // Unknown until the block's header is in the chain
+    BOOST_CHECK(!chain->VerifyTransaction(txid.ToUint256(), proof, 1));
+    BOOST_CHECK(chain->AddHeaders({&proof.header, 1}));
+    BOOST_CHECK(chain->VerifyTransaction(txid.ToUint256(), proof, 1));
+    BOOST_CHECK(!chain->VerifyTransaction(txid.ToUint256(), proof, 6));
+    BOOST_CHECK(chain->AddHeaders(MineHeaders(block, 5, consensus)));
+    BOOST_CHECK(chain->VerifyTransaction(txid.ToUint256(), proof, 6));
+    BOOST_CHECK(!chain->VerifyTransaction(txid.ToUint256(), proof, 7));
+
+    // The proof only covers the transaction it was made for, in that block
+    BOOST_CHECK(!chain->VerifyTransaction(block.vtx[3]->GetHash().ToUint256(), proof, 1));
+    CMerkleBlock other_block{proof};
+    other_block.header.hashMerkleRoot = uint256::ONE;
+    BOOST_CHECK(!chain->VerifyTransaction(txid.ToUint256(), other_block, 1));
+
+    // Bridges verify source transactions with the light client
+    using namespace interop::bridges;
+    DataStream stream{};
+    stream << proof;
+    const std::vector<uint8_t> proof_bytes{UCharCast(stream.data()), UCharCast(stream.data() + stream.size())};
+    BOOST_CHECK(!VerifyExternalChainTransaction(params::CHAIN_BITCOIN, txid.ToUint256(), proof_bytes, 6));
+    BOOST_CHECK(SetChainLightClient(params::CHAIN_BITCOIN, chain));
+    BOOST_CHECK(VerifyExternalChainTransaction(params::CHAIN_BITCOIN, txid.ToUint256(), proof_bytes, 6));
+    BOOST_CHECK(!VerifyExternalChainTransaction(params::CHAIN_BITCOIN, txid.ToUint256(), {proof_bytes.begin(), proof_bytes.end() - 1}, 6));
+    BOOST_CHECK(!VerifyExternalChainTransaction(params::CHAIN_ETHEREUM, txid.ToUint256(), proof_bytes, 6));
+    BOOST_CHECK(SetChainLightClient(params::CHAIN_BITCOIN, nullptr));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
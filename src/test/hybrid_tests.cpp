@@ -0,0 +1,607 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <chainparams.h>
+#include <consensus/hybrid.h>
+#include <dbwrapper.h>
+#include <key.h>
+#include <node/checkpointdb.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+#include <util/check.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace consensus::hybrid;
+
+namespace {
+
+/** Register and activate a validator for each key */
+ValidatorNetworkState MakeValidators(const std::vector<CKey>& keys)
+{
+    ValidatorNetworkState state;
+    for (const CKey& key : keys) {
+        const XOnlyPubKey xonly{key.GetPubKey()};
+        uint256 public_key;
+        std::copy(xonly.begin(), xonly.end(), public_key.begin());
+        const uint256 validator_id = Hash(public_key);
+        BOOST_REQUIRE(RegisterValidator(validator_id, public_key, params::MIN_VALIDATOR_STAKE, state));
+        if (state.active_validators.size() < params::MAX_ACTIVE_VALIDATORS) {
+            BOOST_REQUIRE(ActivateValidator(validator_id, state));
+        } else {
+            // Activation is capped, so the rest are moved over directly
+            auto node = state.pending_validators.extract(validator_id);
+            node.mapped().is_active = true;
+            state.total_staked_amount += node.mapped().stake_amount;
+            state.active_validators.insert(std::move(node));
+        }
+    }
+    return state;
+}
+
+/** Sign as every validator in the bitmap, running both MuSig2 rounds */
+std::vector<unsigned char> SignCheckpoint(const std::vector<CKey>& keys, const std::vector<unsigned char>& signer_bitmap,
+                                          const ValidatorNetworkState& state, const uint256& checkpoint_hash)
+{
+    const auto signer_keys = GetCheckpointSignerKeys(signer_bitmap, state);
+    BOOST_REQUIRE(signer_keys);
+
+    std::vector<std::unique_ptr<CheckpointSigningSession>> sessions;
+    std::vector<CheckpointNonce> nonces;
+    for (const XOnlyPubKey& signer_key : *signer_keys) {
+        for (const CKey& key : keys) {
+            if (XOnlyPubKey{key.GetPubKey()} != signer_key) continue;
+            sessions.push_back(std::make_unique<CheckpointSigningSession>(key, checkpoint_hash, *signer_keys));
+            BOOST_REQUIRE(sessions.back()->IsValid());
+            nonces.push_back(sessions.back()->GetNonce());
+        }
+    }
+    BOOST_REQUIRE_EQUAL(sessions.size(), signer_keys->size());
+
+    std::vector<CheckpointPartialSignature> partial_signatures;
+    for (auto& session : sessions) {
+        const auto partial_signature = session->Sign(*signer_keys, nonces);
+        BOOST_REQUIRE(partial_signature);
+        partial_signatures.push_back(*partial_signature);
+
+        // A session never signs twice
+        BOOST_CHECK(!session->IsValid());
+        BOOST_CHECK(!session->Sign(*signer_keys, nonces));
+    }
+
+    std::vector<unsigned char> signature;
+    BOOST_REQUIRE(AggregateCheckpointSignature(checkpoint_hash, *signer_keys, nonces, partial_signatures, signature));
+    return signature;
+}
+
+std::vector<unsigned char> Bitmap(size_t validator_count, size_t signer_count)
+{
+    std::vector<unsigned char> bitmap((validator_count + 7) / 8);
+    for (size_t i = 0; i < signer_count; ++i) {
+        bitmap[i / 8] |= 1 << (i % 8);
+    }
+    return bitmap;
+}
+
+/** Blocks of a chain, optionally branching off another */
+struct TestChain {
+    std::vector<uint256> hashes;
+    std::vector<CBlockIndex> blocks;
+
+    TestChain(FastRandomContext& rng, int height, const CBlockIndex* fork = nullptr)
+        : hashes(height + 1), blocks(height + 1)
+    {
+        for (int i = fork ? fork->nHeight + 1 : 0; i <= height; ++i) {
+            hashes[i] = rng.rand256();
+            blocks[i].nHeight = i;
+            blocks[i].phashBlock = &hashes[i];
+            blocks[i].pprev = fork && i == fork->nHeight + 1 ? const_cast<CBlockIndex*>(fork) : i > 0 ? &blocks[i - 1] : nullptr;
+            blocks[i].BuildSkip();
+        }
+    }
+
+    CBlockIndex* operator[](int height) { return &blocks[height]; }
+};
+
+CheckpointInfo MakeCheckpoint(const CBlockIndex* pindex)
+{
+    CheckpointInfo checkpoint;
+    checkpoint.height = pindex->nHeight;
+    checkpoint.block_hash = pindex->GetBlockHash();
+    return checkpoint;
+}
+
+std::unique_ptr<node::CheckpointDB> OpenCheckpointDB(const fs::path& path, bool wipe)
+{
+    return std::make_unique<node::CheckpointDB>(DBParams{
+        .path = path,
+        .cache_bytes = 1 << 20,
+        .memory_only = false,
+        .wipe_data = wipe,
+        .obfuscate = false,
+        .options = {}});
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(hybrid_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(checkpoint_aggregate_signature)
+{
+    std::vector<CKey> keys;
+    for (int i = 0; i < 10; ++i) {
+        keys.push_back(GenerateRandomKey());
+    }
+    const ValidatorNetworkState state = MakeValidators(keys);
+
+    CheckpointInfo checkpoint;
+    checkpoint.checkpoint_hash = GetRandHash();
+
+    // 7 of 10 is the two-thirds majority
+    checkpoint.signer_bitmap = Bitmap(10, 7);
+    checkpoint.signature = SignCheckpoint(keys, checkpoint.signer_bitmap, state, checkpoint.checkpoint_hash);
+    BOOST_CHECK(ValidateCheckpointSignatures(checkpoint, state));
+    BOOST_CHECK_EQUAL(GetCheckpointSigners(checkpoint, state).size(), 7U);
+
+    CheckpointInfo tampered = checkpoint;
+    tampered.checkpoint_hash = GetRandHash();
+    BOOST_CHECK(!ValidateCheckpointSignatures(tampered, state));
+    tampered = checkpoint;
+    tampered.signature[0] ^= 1;
+    BOOST_CHECK(!ValidateCheckpointSignatures(tampered, state));
+
+    // The bitmap must name exactly the signers
+    tampered = checkpoint;
+    tampered.signer_bitmap = Bitmap(10, 8);
+    BOOST_CHECK(!ValidateCheckpointSignatures(tampered, state));
+    tampered.signer_bitmap = Bitmap(10, 7);
+    tampered.signer_bitmap[1] |= 0x80;
+    BOOST_CHECK(!ValidateCheckpointSignatures(tampered, state));
+    BOOST_CHECK(GetCheckpointSigners(tampered, state).empty());
+    tampered.signer_bitmap.push_back(0);
+    BOOST_CHECK(!ValidateCheckpointSignatures(tampered, state));
+
+    // A valid signature by too few validators is not enough
+    CheckpointInfo minority = checkpoint;
+    minority.signer_bitmap = Bitmap(10, 6);
+    minority.signature = SignCheckpoint(keys, minority.signer_bitmap, state, minority.checkpoint_hash);
+    BOOST_CHECK(!ValidateCheckpointSignatures(minority, state));
+
+    // Only signer keys can open a session
+    const auto signer_keys = GetCheckpointSignerKeys(checkpoint.signer_bitmap, state);
+    BOOST_REQUIRE(signer_keys);
+    BOOST_CHECK(!CheckpointSigningSession(GenerateRandomKey(), checkpoint.checkpoint_hash, *signer_keys).IsValid());
+}
+
+BOOST_AUTO_TEST_CASE(checkpoint_committee_signature)
+{
+    std::vector<CKey> keys;
+    for (int i = 0; i < 150; ++i) {
+        keys.push_back(GenerateRandomKey());
+    }
+    const ValidatorNetworkState state = MakeValidators(keys);
+    BOOST_REQUIRE_EQUAL(state.active_validators.size(), 150U);
+
+    CheckpointInfo checkpoint;
+    checkpoint.height = params::CHECKPOINT_INTERVAL;
+    checkpoint.block_hash = m_rng.rand256();
+    checkpoint.checkpoint_hash = m_rng.rand256();
+
+    // The committee is smaller than two thirds of the active validators, and
+    // two thirds of the committee are enough
+    const auto committee = GetCheckpointSignerBitmap(state, checkpoint.height, checkpoint.block_hash);
+    BOOST_REQUIRE_EQUAL(SelectValidatorsForCheckpoint(state, checkpoint.height, checkpoint.block_hash).size(),
+                        static_cast<size_t>(params::MIN_VALIDATORS_FOR_CONSENSUS));
+    const size_t threshold = GetCheckpointSignatureThreshold(params::MIN_VALIDATORS_FOR_CONSENSUS);
+    BOOST_CHECK_EQUAL(threshold, 45U);
+
+    // The first signer_count validators in or out of the committee
+    auto pick = [&](size_t signer_count, bool in_committee) {
+        std::vector<unsigned char> bitmap(committee.size());
+        for (size_t i = 0; i < state.active_validators.size() && signer_count > 0; ++i) {
+            if (bool((committee[i / 8] >> (i % 8)) & 1) == in_committee) {
+                bitmap[i / 8] |= 1 << (i % 8);
+                --signer_count;
+            }
+        }
+        return bitmap;
+    };
+
+    checkpoint.signer_bitmap = pick(threshold, true);
+    checkpoint.signature = SignCheckpoint(keys, checkpoint.signer_bitmap, state, checkpoint.checkpoint_hash);
+    BOOST_CHECK(ValidateCheckpointSignatures(checkpoint, state));
+
+    CheckpointInfo full = checkpoint;
+    full.signer_bitmap = committee;
+    full.signature = SignCheckpoint(keys, full.signer_bitmap, state, full.checkpoint_hash);
+    BOOST_CHECK(ValidateCheckpointSignatures(full, state));
+
+    CheckpointInfo minority = checkpoint;
+    minority.signer_bitmap = pick(threshold - 1, true);
+    minority.signature = SignCheckpoint(keys, minority.signer_bitmap, state, minority.checkpoint_hash);
+    BOOST_CHECK(!ValidateCheckpointSignatures(minority, state));
+
+    // Validators outside the committee cannot sign, however many they are
+    CheckpointInfo outsiders = checkpoint;
+    outsiders.signer_bitmap = pick(threshold, false);
+    outsiders.signature = SignCheckpoint(keys, outsiders.signer_bitmap, state, outsiders.checkpoint_hash);
+    BOOST_CHECK(!ValidateCheckpointSignatures(outsiders, state));
+
+    CheckpointInfo mixed = checkpoint;
+    const auto outsider = pick(1, false);
+    for (size_t i = 0; i < mixed.signer_bitmap.size(); ++i) {
+        mixed.signer_bitmap[i] |= outsider[i];
+    }
+    mixed.signature = SignCheckpoint(keys, mixed.signer_bitmap, state, mixed.checkpoint_hash);
+    BOOST_CHECK(!ValidateCheckpointSignatures(mixed, state));
+
+    // The committee depends on the checkpoint block
+    CheckpointInfo moved = checkpoint;
+    moved.block_hash = m_rng.rand256();
+    BOOST_CHECK(GetCheckpointSignerBitmap(state, moved.height, moved.block_hash) != committee);
+    BOOST_CHECK(!ValidateCheckpointSignatures(moved, state));
+}
+
+BOOST_AUTO_TEST_CASE(checkpoint_signature_attached)
+{
+    InitializeHybridConsensus(Params().GetConsensus());
+
+    CBlock block;
+    block.nTime = 1700000000;
+    CBlockIndex index;
+    index.nHeight = params::CHECKPOINT_INTERVAL;
+
+    CheckpointInfo checkpoint;
+    BOOST_REQUIRE(CreateCheckpoint(block, &index, checkpoint));
+    BOOST_CHECK(checkpoint.signature.empty());
+
+    const std::vector<unsigned char> bitmap{0x01}, signature(64, 0x02);
+    AddCheckpointSignature(block.GetHash(), bitmap, signature);
+    CheckpointInfo signed_checkpoint;
+    BOOST_REQUIRE(CreateCheckpoint(block, &index, signed_checkpoint));
+    BOOST_CHECK(signed_checkpoint.checkpoint_hash == checkpoint.checkpoint_hash);
+    BOOST_CHECK(signed_checkpoint.signer_bitmap == bitmap);
+    BOOST_CHECK(signed_checkpoint.signature == signature);
+}
+
+BOOST_AUTO_TEST_CASE(checkpoint_vote_aggregation)
+{
+    InitializeHybridConsensus(Params().GetConsensus());
+    std::vector<CKey> keys;
+    for (int i = 0; i < 4; ++i) {
+        keys.push_back(GenerateRandomKey());
+    }
+    const ValidatorNetworkState state = MakeValidators(keys);
+
+    CBlock block;
+    block.nTime = 1700000000;
+    CBlockIndex index;
+    index.nHeight = params::CHECKPOINT_INTERVAL;
+    CheckpointInfo checkpoint;
+    BOOST_REQUIRE(CreateCheckpoint(block, &index, checkpoint));
+
+    // With few validators, all of them are selected, and three of the four
+    // are enough to sign
+    CheckpointVoteSet base;
+    base.height = checkpoint.height;
+    base.block_hash = checkpoint.block_hash;
+    base.checkpoint_hash = checkpoint.checkpoint_hash;
+    base.signer_bitmap = GetCheckpointSignerBitmap(state, base.height, base.block_hash);
+    BOOST_CHECK(base.signer_bitmap == Bitmap(4, 4));
+    BOOST_CHECK_EQUAL(GetCheckpointSignatureThreshold(4), 3U);
+    const auto committee_keys = GetCheckpointSignerKeys(base.signer_bitmap, state);
+    BOOST_REQUIRE(committee_keys);
+
+    std::vector<std::unique_ptr<CheckpointSigningSession>> sessions;
+    for (const XOnlyPubKey& committee_key : *committee_keys) {
+        for (const CKey& key : keys) {
+            if (XOnlyPubKey{key.GetPubKey()} != committee_key) continue;
+            sessions.push_back(std::make_unique<CheckpointSigningSession>(key, base.checkpoint_hash, *committee_keys));
+        }
+    }
+    BOOST_REQUIRE_EQUAL(sessions.size(), 4U);
+
+    // Forged nonces and unknown members are invalid, and a committee this
+    // node did not select may come from another validator view
+    CheckpointVoteSet invalid = base;
+    invalid.nonces[0] = sessions[0]->GetSignedNonce();
+    invalid.nonces[0].signature[0] ^= 1;
+    BOOST_CHECK_EQUAL(AddCheckpointVotes(invalid, state), CHECKPOINT_VOTES_INVALID);
+    invalid = base;
+    invalid.nonces[1] = sessions[0]->GetSignedNonce();
+    BOOST_CHECK_EQUAL(AddCheckpointVotes(invalid, state), CHECKPOINT_VOTES_INVALID);
+    invalid = base;
+    invalid.nonces[4] = sessions[0]->GetSignedNonce();
+    BOOST_CHECK_EQUAL(AddCheckpointVotes(invalid, state), CHECKPOINT_VOTES_INVALID);
+    invalid = base;
+    invalid.signer_bitmap = Bitmap(4, 3);
+    invalid.nonces[0] = sessions[0]->GetSignedNonce();
+    BOOST_CHECK_EQUAL(AddCheckpointVotes(invalid, state), CHECKPOINT_VOTES_UNKNOWN_COMMITTEE);
+    BOOST_CHECK(!GetCheckpointVotes(base.checkpoint_hash));
+
+    // Nonces arrive one member at a time and are merged into one vote set;
+    // member 2 is slow
+    for (uint32_t i : {0, 1, 3}) {
+        CheckpointVoteSet votes = base;
+        votes.nonces[i] = sessions[i]->GetSignedNonce();
+        BOOST_CHECK_EQUAL(AddCheckpointVotes(votes, state), CHECKPOINT_VOTES_ADDED);
+        BOOST_CHECK_EQUAL(AddCheckpointVotes(votes, state), CHECKPOINT_VOTES_UNCHANGED);
+
+        // Partial signatures need a signing set
+        votes.partial_signatures[i] = CheckpointPartialSignature{};
+        BOOST_CHECK_EQUAL(AddCheckpointVotes(votes, state), CHECKPOINT_VOTES_INVALID);
+    }
+    const auto merged = GetCheckpointVotes(base.checkpoint_hash);
+    BOOST_REQUIRE(merged);
+    BOOST_CHECK_EQUAL(merged->nonces.size(), 3U);
+    BOOST_CHECK(merged->signing_bitmap.empty());
+    BOOST_CHECK(merged->partial_signatures.empty());
+    invalid.nonces = {{2, sessions[2]->GetSignedNonce()}};
+    BOOST_CHECK_EQUAL(AddCheckpointVotes(invalid, state), CHECKPOINT_VOTES_UNKNOWN_COMMITTEE);
+
+    // A signing set must reach the threshold and have all its nonces in
+    invalid = base;
+    invalid.signing_bitmap = {0b0011};
+    BOOST_CHECK_EQUAL(AddCheckpointVotes(invalid, state), CHECKPOINT_VOTES_INVALID);
+    invalid.signing_bitmap = {0b0111};
+    BOOST_CHECK_EQUAL(AddCheckpointVotes(invalid, state), CHECKPOINT_VOTES_INVALID);
+    invalid.signing_bitmap = {0b11011};
+    BOOST_CHECK_EQUAL(AddCheckpointVotes(invalid, state), CHECKPOINT_VOTES_INVALID);
+
+    // Members 0, 1 and 3 sign
+    const std::vector<unsigned char> signing_bitmap{0b1011};
+    const std::vector<XOnlyPubKey> signer_keys{(*committee_keys)[0], (*committee_keys)[1], (*committee_keys)[3]};
+    const std::vector<CheckpointNonce> nonces{merged->nonces.at(0).nonce, merged->nonces.at(1).nonce,
+                                              merged->nonces.at(3).nonce};
+    BOOST_CHECK(!sessions[2]->Sign(signer_keys, nonces));
+    std::map<uint32_t, CheckpointPartialSignature> partial_signatures;
+    for (uint32_t i : {0, 1, 3}) {
+        partial_signatures[i] = *Assert(sessions[i]->Sign(signer_keys, nonces));
+    }
+
+    // A partial signature is checked against its signer
+    invalid = *merged;
+    invalid.signing_bitmap = signing_bitmap;
+    invalid.partial_signatures[1] = partial_signatures[0];
+    BOOST_CHECK_EQUAL(AddCheckpointVotes(invalid, state), CHECKPOINT_VOTES_INVALID);
+
+    for (uint32_t i : {0, 1}) {
+        CheckpointVoteSet votes = base;
+        votes.signing_bitmap = signing_bitmap;
+        votes.partial_signatures[i] = partial_signatures[i];
+        BOOST_CHECK_EQUAL(AddCheckpointVotes(votes, state), CHECKPOINT_VOTES_ADDED);
+    }
+    CheckpointInfo unsigned_checkpoint;
+    BOOST_REQUIRE(CreateCheckpoint(block, &index, unsigned_checkpoint));
+    BOOST_CHECK(unsigned_checkpoint.signature.empty());
+
+    // The slow member's nonce still merges, but the signing set is kept, and
+    // it cannot sign for it
+    CheckpointVoteSet late = base;
+    late.nonces[2] = sessions[2]->GetSignedNonce();
+    late.signing_bitmap = {0b0111};
+    late.partial_signatures[2] = CheckpointPartialSignature{};
+    BOOST_CHECK_EQUAL(AddCheckpointVotes(late, state), CHECKPOINT_VOTES_ADDED);
+    BOOST_CHECK_EQUAL(AddCheckpointVotes(late, state), CHECKPOINT_VOTES_UNCHANGED);
+    late.signing_bitmap = signing_bitmap;
+    BOOST_CHECK_EQUAL(AddCheckpointVotes(late, state), CHECKPOINT_VOTES_INVALID);
+
+    // The last partial signature, relayed in an aggregate, completes the
+    // checkpoint signature
+    CheckpointVoteSet aggregate = *Assert(GetCheckpointVotes(base.checkpoint_hash));
+    BOOST_CHECK(aggregate.signing_bitmap == signing_bitmap);
+    BOOST_CHECK_EQUAL(aggregate.nonces.size(), 4U);
+    BOOST_CHECK_EQUAL(aggregate.partial_signatures.size(), 2U);
+    aggregate.partial_signatures[3] = partial_signatures[3];
+    BOOST_CHECK_EQUAL(AddCheckpointVotes(aggregate, state), CHECKPOINT_VOTES_ADDED);
+    BOOST_CHECK_EQUAL(AddCheckpointVotes(aggregate, state), CHECKPOINT_VOTES_UNCHANGED);
+
+    // The checkpoint records the signing set
+    CheckpointInfo signed_checkpoint;
+    BOOST_REQUIRE(CreateCheckpoint(block, &index, signed_checkpoint));
+    BOOST_CHECK(signed_checkpoint.signer_bitmap == std::vector<unsigned char>{0b1011});
+    BOOST_CHECK_EQUAL(GetCheckpointSigners(signed_checkpoint, state).size(), 3U);
+    BOOST_CHECK(ValidateCheckpointSignatures(signed_checkpoint, state));
+}
+
+BOOST_AUTO_TEST_CASE(checkpoint_finality)
+{
+    InitializeHybridConsensus(Params().GetConsensus());
+    ValidatorNetworkState state;
+    const fs::path path{m_path_root / "checkpoints"};
+    SetCheckpointStore(OpenCheckpointDB(path, /*wipe=*/true), nullptr);
+    auto restart = [&](const CBlockIndex* tip) {
+        SetCheckpointStore(nullptr, nullptr);
+        SetCheckpointStore(OpenCheckpointDB(path, /*wipe=*/false), tip);
+    };
+
+    TestChain chain{m_rng, 450};
+    TestChain fork{m_rng, 350, chain[150]};
+    BOOST_CHECK(!IsBlockFinalized(chain[0]->GetBlockHash(), chain[0]));
+
+    CheckpointInfo first = MakeCheckpoint(chain[100]), second = MakeCheckpoint(chain[300]);
+    BOOST_REQUIRE(FinalizeCheckpoint(first, chain[100], state));
+    BOOST_REQUIRE(FinalizeCheckpoint(second, chain[300], state));
+    BOOST_CHECK(GetFinalizedBlock() == chain[300]);
+    for (int height : {0, 100, 299, 300}) {
+        BOOST_CHECK(IsBlockFinalized(chain[height]->GetBlockHash(), chain[height]));
+    }
+    BOOST_CHECK(!IsBlockFinalized(chain[301]->GetBlockHash(), chain[301]));
+    BOOST_CHECK(!IsBlockFinalized(fork[200]->GetBlockHash(), fork[200]));
+    BOOST_CHECK_EQUAL(GetFinalityStatus(chain[250]->GetBlockHash(), chain[250]), FINALITY_CONFIRMED);
+
+    // Finality never forks, and a checkpoint must match its block
+    CheckpointInfo conflicting = MakeCheckpoint(fork[200]);
+    BOOST_CHECK(!FinalizeCheckpoint(conflicting, fork[200], state));
+    CheckpointInfo mismatched = MakeCheckpoint(chain[200]);
+    BOOST_CHECK(!FinalizeCheckpoint(mismatched, chain[400], state));
+
+    // A restart resumes from the stored watermark, or from the highest
+    // finalized checkpoint the chain has reached
+    restart(chain[450]);
+    BOOST_CHECK(GetFinalizedBlock() == chain[300]);
+    BOOST_REQUIRE(GetCheckpoint(300));
+    BOOST_CHECK(GetCheckpoint(300)->is_finalized);
+    BOOST_CHECK(GetCheckpoint(300)->block_hash == chain[300]->GetBlockHash());
+    restart(chain[250]);
+    BOOST_CHECK(GetFinalizedBlock() == chain[100]);
+    restart(fork[350]);
+    BOOST_CHECK(GetFinalizedBlock() == chain[100]);
+
+    // Disconnecting finalized blocks moves the watermark back, after which
+    // the other branch can be finalized
+    restart(chain[450]);
+    DisconnectCheckpoints(chain[150]);
+    BOOST_CHECK(GetFinalizedBlock() == chain[100]);
+    BOOST_CHECK(!GetCheckpoint(300));
+    BOOST_CHECK(!IsBlockFinalized(chain[300]->GetBlockHash(), chain[300]));
+    BOOST_REQUIRE(FinalizeCheckpoint(conflicting, fork[200], state));
+    BOOST_CHECK(IsBlockFinalized(fork[180]->GetBlockHash(), fork[180]));
+    restart(fork[350]);
+    BOOST_CHECK(GetFinalizedBlock() == fork[200]);
+
+    SetCheckpointStore(nullptr, nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(validator_state_snapshots)
+{
+    InitializeHybridConsensus(Params().GetConsensus());
+
+    // Readers share one snapshot until the state is updated
+    const auto before = GetValidatorNetworkState();
+    BOOST_CHECK(GetValidatorNetworkState() == before);
+    BOOST_CHECK(before->active_validators.empty());
+
+    ValidatorNetworkState next = *before;
+    const uint256 validator_id = m_rng.rand256();
+    BOOST_REQUIRE(RegisterValidator(validator_id, m_rng.rand256(), params::MIN_VALIDATOR_STAKE, next));
+    BOOST_REQUIRE(ActivateValidator(validator_id, next));
+    next.current_epoch = 1;
+    BOOST_REQUIRE(UpdateValidatorNetworkState(std::move(next)));
+
+    // Earlier readers keep their snapshot
+    const auto after = GetValidatorNetworkState();
+    BOOST_CHECK(after != before);
+    BOOST_CHECK(before->active_validators.empty());
+    BOOST_CHECK_EQUAL(after->active_validators.count(validator_id), 1U);
+    BOOST_CHECK_EQUAL(after->current_epoch, 1U);
+    BOOST_CHECK_EQUAL(GetConsensusStatistics().active_validators, 1U);
+
+    // Maintenance publishes a new snapshot too
+    PerformHybridConsensusMaintenance();
+    BOOST_CHECK(GetValidatorNetworkState() != after);
+    BOOST_CHECK_EQUAL(GetValidatorNetworkState()->active_validators.count(validator_id), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(validator_sampler)
+{
+    ValidatorNetworkState state;
+    std::vector<uint256> ids;
+    uint64_t total_stake{0};
+    for (int i = 0; i < params::MAX_ACTIVE_VALIDATORS; ++i) {
+        total_stake += params::MIN_VALIDATOR_STAKE * (1 + i % 4);
+        ids.push_back(m_rng.rand256());
+        BOOST_REQUIRE(RegisterValidator(ids.back(), m_rng.rand256(), params::MIN_VALIDATOR_STAKE * (1 + i % 4), state));
+        BOOST_REQUIRE(ActivateValidator(ids.back(), state));
+    }
+
+    ValidatorSampler sampler{state};
+    BOOST_CHECK_EQUAL(sampler.size(), ids.size());
+    BOOST_CHECK_EQUAL(sampler.GetTotalWeight(), total_stake);
+
+    // Draws are distinct and determined by the seed
+    const uint256 seed = m_rng.rand256();
+    const auto selected = sampler.Select(seed, 67);
+    BOOST_CHECK_EQUAL(selected.size(), 67U);
+    BOOST_CHECK_EQUAL(std::set<uint256>(selected.begin(), selected.end()).size(), 67U);
+    BOOST_CHECK(sampler.Select(seed, 67) == selected);
+    BOOST_CHECK(ValidatorSampler{state}.Select(seed, 67) == selected);
+    BOOST_CHECK(sampler.Select(m_rng.rand256(), 67) != selected);
+    BOOST_CHECK_EQUAL(sampler.Select(seed, 1000).size(), ids.size());
+
+    // Validators without weight are never drawn
+    for (size_t i = 1; i < ids.size(); ++i) {
+        BOOST_REQUIRE(sampler.Update(ids[i], 0));
+    }
+    BOOST_CHECK(!sampler.Update(m_rng.rand256(), 1));
+    BOOST_CHECK(sampler.Select(seed, 67) == std::vector<uint256>{ids[0]});
+
+    // Draws follow weight: one validator with three quarters of the weight
+    // is drawn first about three times in four
+    for (size_t i = 1; i < ids.size(); ++i) {
+        BOOST_REQUIRE(sampler.Update(ids[i], 1));
+    }
+    BOOST_REQUIRE(sampler.Update(ids[0], 3 * (ids.size() - 1)));
+    int first = 0;
+    for (int i = 0; i < 1000; ++i) {
+        first += sampler.Select(m_rng.rand256(), 1) == std::vector<uint256>{ids[0]};
+    }
+    BOOST_CHECK(first > 700 && first < 800);
+
+    // Checkpoint selection is seeded by the block hash
+    const uint256 block_hash = m_rng.rand256();
+    const auto checkpoint_validators = SelectValidatorsForCheckpoint(state, params::CHECKPOINT_INTERVAL, block_hash);
+    BOOST_CHECK_EQUAL(checkpoint_validators.size(), static_cast<size_t>(params::MIN_VALIDATORS_FOR_CONSENSUS));
+    BOOST_CHECK(SelectValidatorsForCheckpoint(state, params::CHECKPOINT_INTERVAL, block_hash) == checkpoint_validators);
+    BOOST_REQUIRE(UpdateValidatorNetworkState(state));
+    BOOST_CHECK(SelectValidatorsForCheckpoint(*GetValidatorNetworkState(), params::CHECKPOINT_INTERVAL, block_hash) == checkpoint_validators);
+    BOOST_CHECK(SelectValidatorsForCheckpoint(*GetValidatorNetworkState(), params::CHECKPOINT_INTERVAL, block_hash) == checkpoint_validators);
+}
+
+BOOST_AUTO_TEST_CASE(block_transaction_classification)
+{
+    InitializeHybridConsensus(Params().GetConsensus());
+
+    // Every seventh transaction stakes and every eleventh votes, each in a
+    // tagged output after a payment
+    CBlock block;
+    std::vector<Txid> staking, governance;
+    for (int i = 0; i < 2000; ++i) {
+        CMutableTransaction tx;
+        tx.vin.emplace_back(COutPoint{Txid::FromUint256(m_rng.rand256()), 0});
+        tx.vout.emplace_back(1000, CScript() << OP_TRUE);
+        const auto& tag = i % 7 == 3 ? STAKING_OUTPUT_TAG : GOVERNANCE_OUTPUT_TAG;
+        if (i % 7 == 3 || i % 11 == 5) {
+            tx.vout.emplace_back(0, CScript() << OP_RETURN << std::vector<unsigned char>(tag.begin(), tag.end()) << m_rng.randbytes(32));
+            (i % 7 == 3 ? staking : governance).push_back(tx.GetHash());
+        } else if (i % 13 == 0) {
+            // Near misses: another tag, and the tag not as first push
+            tx.vout.emplace_back(0, CScript() << OP_RETURN << std::vector<unsigned char>{'B', 'D', 'X', 'X'});
+            tx.vout.emplace_back(0, CScript() << OP_RETURN << OP_0 << std::vector<unsigned char>(tag.begin(), tag.end()));
+        }
+        block.vtx.push_back(MakeTransactionRef(std::move(tx)));
+    }
+
+    auto hashes = [](const std::vector<std::shared_ptr<const CTransaction>>& txs) {
+        std::vector<Txid> result;
+        for (const auto& tx : txs) result.push_back(tx->GetHash());
+        return result;
+    };
+
+    const auto classified = GetBlockHybridTransactions(block);
+    BOOST_CHECK(hashes(classified->staking) == staking);
+    BOOST_CHECK(hashes(classified->governance) == governance);
+
+    // The block's result is kept, for disconnecting it later
+    BOOST_CHECK_EQUAL(GetBlockHybridTransactions(block), classified);
+
+    // Another block is classified afresh
+    block.nTime = 1;
+    const auto other = GetBlockHybridTransactions(block);
+    BOOST_CHECK(other != classified);
+    BOOST_CHECK(hashes(other->staking) == staking);
+    BOOST_CHECK(hashes(other->governance) == governance);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
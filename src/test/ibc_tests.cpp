@@ -0,0 +1,419 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <interop/ibc.h>
+#include <interop/mmr.h>
+#include <key.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <util/time.h>
+
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace interop::ibc;
+
+namespace {
+
+ChannelHandle OpenTestChannel(const std::string& channel_id, const std::string& counterparty_channel_id,
+                              Channel::Order ordering)
+{
+    BOOST_REQUIRE(InitializeChannel(channel_id, params::SMART_CONTRACT_PORT, "connection-0", counterparty_channel_id,
+                                    params::SMART_CONTRACT_PORT, ordering));
+    BOOST_REQUIRE(OpenChannel(channel_id, Proof{}));
+    const auto handle = GetChannelHandle(channel_id);
+    BOOST_REQUIRE(handle);
+    return *handle;
+}
+
+Packet MakePacket(uint64_t sequence, const std::string& source_channel, const std::string& dest_channel,
+                  const std::vector<uint8_t>& data)
+{
+    Packet packet;
+    packet.sequence = sequence;
+    packet.source_port = params::SMART_CONTRACT_PORT;
+    packet.source_channel = source_channel;
+    packet.dest_port = params::SMART_CONTRACT_PORT;
+    packet.dest_channel = dest_channel;
+    packet.data = data;
+    return packet;
+}
+
+constexpr uint64_t CLIENT_GENESIS_TIME{1700000000};
+constexpr uint64_t CLIENT_TRUSTING_PERIOD{14 * 24 * 60 * 60};
+
+std::vector<CKey> MakeValidatorKeys(size_t count)
+{
+    std::vector<CKey> keys(count);
+    for (CKey& key : keys) key.MakeNewKey(true);
+    return keys;
+}
+
+std::vector<XOnlyPubKey> GetValidators(const std::vector<CKey>& keys)
+{
+    std::vector<XOnlyPubKey> validators;
+    for (const CKey& key : keys) validators.emplace_back(key.GetPubKey());
+    return validators;
+}
+
+/** Client of a counterparty whose genesis validators are keys */
+void CreateTestClient(const std::string& client_id, const std::vector<CKey>& keys)
+{
+    ClientState state;
+    state.trusting_period = CLIENT_TRUSTING_PERIOD;
+    state.max_clock_drift = 10;
+    state.consensus_states[0] = ConsensusState{.timestamp = CLIENT_GENESIS_TIME, .commitment_root = {}, .validators = GetValidators(keys)};
+    BOOST_REQUIRE(CreateIBCClient(client_id, "counterparty", state));
+}
+
+/** Serialized header with the first signers of keys signing it */
+std::vector<uint8_t> SignHeader(ClientHeader header, const std::vector<CKey>& keys, size_t signers,
+                                const std::string& chain_id = "counterparty")
+{
+    const uint256 header_hash = GetClientHeaderHash(chain_id, header);
+    header.signatures.assign(keys.size(), {});
+    for (size_t i = 0; i < signers; ++i) {
+        header.signatures[i].resize(64);
+        BOOST_REQUIRE(keys[i].SignSchnorr(header_hash, header.signatures[i], nullptr, uint256::ONE));
+    }
+    DataStream stream{};
+    stream << header;
+    return {UCharCast(stream.data()), UCharCast(stream.data() + stream.size())};
+}
+
+ClientHeader MakeHeader(uint64_t height, const uint256& commitment_root, const std::vector<CKey>& next_validators)
+{
+    ClientHeader header;
+    header.height = height;
+    header.timestamp = CLIENT_GENESIS_TIME + height;
+    header.commitment_root = commitment_root;
+    header.next_validators = GetValidators(next_validators);
+    return header;
+}
+
+/** Commit to the channels at a block and pass the root to our own client */
+void CommitBlock(uint64_t height, const std::vector<CKey>& keys)
+{
+    const uint256 root = CommitIBCBlock(height);
+    BOOST_REQUIRE(UpdateIBCClient("client-0", height, SignHeader(MakeHeader(height, root, keys), keys, keys.size())));
+}
+
+Proof ProvePackets(ChannelHandle channel, CommitmentType type, const std::vector<Packet>& packets, uint64_t height)
+{
+    std::vector<uint64_t> sequences;
+    for (const Packet& packet : packets) sequences.push_back(packet.sequence);
+    const auto proof = GeneratePacketProof(channel, type, sequences, height);
+    BOOST_REQUIRE(proof);
+    return *proof;
+}
+
+Acknowledgment SuccessAck()
+{
+    Acknowledgment ack;
+    ack.result = {1};
+    ack.success = true;
+    return ack;
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(ibc_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(packet_commitment_queue)
+{
+    PacketCommitmentQueue queue;
+    BOOST_CHECK(!queue.Find(1));
+    std::vector<PacketCommitmentQueue::Entry> entries(1000);
+    for (uint64_t sequence = 1; sequence < entries.size(); ++sequence) {
+        entries[sequence].commitment = m_rng.rand256();
+        BOOST_REQUIRE(queue.Push(sequence, entries[sequence]));
+    }
+    BOOST_CHECK_EQUAL(queue.Size(), 999U);
+    BOOST_CHECK(!queue.Push(999, entries[1]));
+    BOOST_CHECK(!queue.Push(2000, PacketCommitmentQueue::Entry{}));
+
+    // Out of order removals leave the other packets in place
+    for (uint64_t sequence = 1; sequence < entries.size(); sequence += 3) {
+        BOOST_CHECK(queue.Erase(sequence));
+        BOOST_CHECK(!queue.Erase(sequence));
+    }
+    size_t erased = 0;
+    for (uint64_t sequence = 2; sequence < entries.size(); sequence += 2) {
+        erased += queue.Erase(sequence);
+    }
+    BOOST_CHECK_EQUAL(erased, 333U);
+    for (uint64_t sequence = 1; sequence < entries.size(); ++sequence) {
+        const PacketCommitmentQueue::Entry* entry = queue.Find(sequence);
+        if (sequence % 3 == 1 || sequence % 2 == 0) {
+            BOOST_CHECK(!entry);
+        } else {
+            BOOST_REQUIRE(entry);
+            BOOST_CHECK_EQUAL(entry->commitment, entries[sequence].commitment);
+        }
+    }
+    BOOST_CHECK_EQUAL(queue.Size(), 333U);
+
+    // An old packet still pending keeps its place as the window moves on
+    for (uint64_t sequence = 1000; sequence < 5000; ++sequence) {
+        BOOST_REQUIRE(queue.Push(sequence, entries[1 + sequence % 999]));
+        BOOST_REQUIRE(queue.Erase(sequence));
+    }
+    BOOST_CHECK_EQUAL(queue.Size(), 333U);
+    BOOST_REQUIRE(queue.Find(3));
+    BOOST_CHECK_EQUAL(queue.Find(3)->commitment, entries[3].commitment);
+}
+
+BOOST_AUTO_TEST_CASE(commitment_accumulator)
+{
+    interop::MerkleMountainRange mmr;
+    std::vector<uint256> leaves;
+    std::vector<uint256> roots{mmr.GetRoot()};
+    for (int i = 0; i < 300; ++i) {
+        leaves.push_back(m_rng.rand256());
+        BOOST_CHECK_EQUAL(mmr.Append(leaves.back()), uint64_t(i));
+        roots.push_back(mmr.GetRoot());
+    }
+    BOOST_CHECK(!mmr.Prove({0}, 301));
+    BOOST_CHECK(!mmr.Prove({5, 5}, 300));
+    BOOST_CHECK(!mmr.Prove({}, 300));
+
+    // Proofs of any subset, against the current root or an earlier one
+    for (uint64_t leaf_count = 1; leaf_count <= leaves.size(); ++leaf_count) {
+        std::vector<uint64_t> indices(leaf_count);
+        std::iota(indices.begin(), indices.end(), 0);
+        std::shuffle(indices.begin(), indices.end(), m_rng);
+        indices.resize(1 + m_rng.randrange(leaf_count));
+        std::vector<uint256> proven;
+        for (uint64_t index : indices) proven.push_back(leaves[index]);
+
+        const auto proof = mmr.Prove(indices, leaf_count);
+        BOOST_REQUIRE(proof);
+        BOOST_CHECK(VerifyMMRProof(roots[leaf_count], *proof, proven));
+        BOOST_CHECK(!VerifyMMRProof(roots[leaf_count - 1], *proof, proven));
+
+        auto tampered = proven;
+        tampered[m_rng.randrange(tampered.size())] = m_rng.rand256();
+        BOOST_CHECK(!VerifyMMRProof(roots[leaf_count], *proof, tampered));
+        if (proven.size() > 1) {
+            tampered = proven;
+            std::swap(tampered.front(), tampered.back());
+            BOOST_CHECK(!VerifyMMRProof(roots[leaf_count], *proof, tampered));
+        }
+        auto extended = *proof;
+        extended.nodes.push_back(uint256::ONE);
+        BOOST_CHECK(!VerifyMMRProof(roots[leaf_count], extended, proven));
+    }
+
+    // A proof of many leaves shares the nodes above them
+    std::vector<uint64_t> all(leaves.size());
+    std::iota(all.begin(), all.end(), 0);
+    BOOST_CHECK(mmr.Prove(all, leaves.size())->nodes.empty());
+    // 300 leaves are peaks of 256, 32, 8 and 4: a path of 8 and 3 other peaks
+    BOOST_CHECK_EQUAL(mmr.Prove({0}, leaves.size())->nodes.size(), 11U);
+}
+
+BOOST_AUTO_TEST_CASE(packet_batches)
+{
+    SetMockTime(CLIENT_GENESIS_TIME + 100);
+    const std::vector<CKey> keys = MakeValidatorKeys(4);
+    BOOST_REQUIRE(InitializeIBCProtocol());
+    CreateTestClient("client-0", keys);
+    BOOST_REQUIRE(InitializeConnection("connection-0", "client-0", "connection-1", "client-1"));
+    BOOST_REQUIRE(OpenConnection("connection-0", Proof{}));
+    // Both ends of the channels are local, so packets are relayed back here
+    const ChannelHandle source = OpenTestChannel("channel-0", "channel-1", Channel::ORDER_UNORDERED);
+    const ChannelHandle dest = OpenTestChannel("channel-1", "channel-0", Channel::ORDER_UNORDERED);
+    BOOST_CHECK(source != dest);
+    BOOST_CHECK(!GetChannelHandle("channel-2"));
+
+    std::vector<Packet> packets;
+    for (uint64_t sequence = 1; sequence <= 1000; ++sequence) {
+        const std::vector<uint8_t> data = m_rng.randbytes(32);
+        BOOST_REQUIRE(SendPacket(params::SMART_CONTRACT_PORT, "channel-0", params::SMART_CONTRACT_PORT, "channel-1",
+                                 data, 0, 0));
+        packets.push_back(MakePacket(sequence, "channel-0", "channel-1", data));
+    }
+    BOOST_CHECK_EQUAL(GetIBCNetworkState().packet_commitments[source].Size(), 1000U);
+
+    // Packets are received against the commitment root at a block
+    CommitBlock(1, keys);
+    BOOST_CHECK(!GeneratePacketProof(source, COMMITMENT_PACKET, {1001}, 1));
+    BOOST_CHECK(!GeneratePacketProof(source, COMMITMENT_PACKET, {1}, 2));
+    BOOST_CHECK(!ReceivePacket(packets[0], Proof{}));
+    BOOST_CHECK(!ReceivePacket(packets[1], ProvePackets(source, COMMITMENT_PACKET, {packets[0]}, 1)));
+    BOOST_CHECK(ReceivePacket(packets[0], ProvePackets(source, COMMITMENT_PACKET, {packets[0]}, 1)));
+    const Proof batch_proof = ProvePackets(source, COMMITMENT_PACKET, packets, 1);
+    BOOST_CHECK_EQUAL(ReceivePackets(source, packets, batch_proof), 0U);
+    BOOST_CHECK_EQUAL(ReceivePackets(dest, packets, batch_proof), 999U);
+    BOOST_CHECK_EQUAL(ReceivePackets(dest, packets, batch_proof), 0U);
+    BOOST_CHECK_EQUAL(GetIBCNetworkState().total_packets_received, 1000U);
+
+    // Acknowledgments must match the packets committed to and be proven
+    CommitBlock(2, keys);
+    std::vector<Acknowledgment> acks(packets.size(), SuccessAck());
+    const Proof single_ack_proof = ProvePackets(dest, COMMITMENT_ACK, {packets[10]}, 2);
+    Packet altered = packets[10];
+    altered.data.push_back(0);
+    BOOST_CHECK(!AcknowledgePacket(altered, acks[10], single_ack_proof));
+    BOOST_CHECK(!AcknowledgePacket(packets[10], Acknowledgment{}, single_ack_proof));
+    BOOST_CHECK(AcknowledgePacket(packets[10], acks[10], single_ack_proof));
+    const Proof ack_proof = ProvePackets(dest, COMMITMENT_ACK, packets, 2);
+    BOOST_CHECK_EQUAL(AcknowledgePackets(dest, packets, acks, ack_proof), 0U);
+    BOOST_CHECK_EQUAL(AcknowledgePackets(source, packets, acks, batch_proof), 0U);
+    BOOST_CHECK_EQUAL(AcknowledgePackets(source, packets, acks, ack_proof), 999U);
+    BOOST_CHECK_EQUAL(AcknowledgePackets(source, packets, acks, ack_proof), 0U);
+    BOOST_CHECK_EQUAL(GetIBCNetworkState().packet_commitments[source].Size(), 0U);
+    // Far smaller than a proof per packet
+    BOOST_CHECK_LT(ack_proof.proof_data.size(), single_ack_proof.proof_data.size() * packets.size() / 4);
+
+    // Ordered channels take acknowledgments in sequence
+    const ChannelHandle ordered = OpenTestChannel("channel-2", "channel-3", Channel::ORDER_ORDERED);
+    const ChannelHandle ordered_dest = OpenTestChannel("channel-3", "channel-2", Channel::ORDER_ORDERED);
+    std::vector<Packet> ordered_packets;
+    for (uint64_t sequence = 1; sequence <= 3; ++sequence) {
+        BOOST_REQUIRE(SendPacket(params::SMART_CONTRACT_PORT, "channel-2", params::SMART_CONTRACT_PORT, "channel-3",
+                                 {}, 0, 0));
+        ordered_packets.push_back(MakePacket(sequence, "channel-2", "channel-3", {}));
+    }
+    CommitBlock(3, keys);
+    BOOST_CHECK_EQUAL(ReceivePackets(ordered_dest, ordered_packets, ProvePackets(ordered, COMMITMENT_PACKET, ordered_packets, 3)), 3U);
+    CommitBlock(4, keys);
+    BOOST_CHECK(!AcknowledgePacket(ordered_packets[1], SuccessAck(), ProvePackets(ordered_dest, COMMITMENT_ACK, {ordered_packets[1]}, 4)));
+    BOOST_CHECK_EQUAL(AcknowledgePackets(ordered, ordered_packets, {3, SuccessAck()},
+                                         ProvePackets(ordered_dest, COMMITMENT_ACK, ordered_packets, 4)), 3U);
+    BOOST_CHECK_EQUAL(GetChannel(ordered)->next_sequence_ack, 4U);
+
+    // Proofs remain valid against a recent block after more commitments
+    BOOST_CHECK(VerifyPacketCommitment(packets[5], ProvePackets(source, COMMITMENT_PACKET, {packets[5]}, 1)));
+
+    // A packet times out with a proof that the counterparty recorded it as
+    // never received, at a height past its timeout
+    const std::vector<uint8_t> data{1, 2, 3};
+    BOOST_REQUIRE(SendPacket(params::SMART_CONTRACT_PORT, "channel-0", params::SMART_CONTRACT_PORT, "channel-1",
+                             data, 6, 0));
+    Packet timed_out = MakePacket(1001, "channel-0", "channel-1", data);
+    timed_out.timeout_height = 6;
+    CommitBlock(5, keys);
+    BOOST_CHECK(!RecordPacketNonReceipt(timed_out, ProvePackets(source, COMMITMENT_PACKET, {timed_out}, 5)));
+    BOOST_CHECK(!TimeoutPacket(timed_out, Proof{}));
+    BOOST_CHECK(!ProcessPacketTimeout("channel-0", 1001, ProvePackets(source, COMMITMENT_PACKET, {timed_out}, 5)));
+    CommitBlock(6, keys);
+    const Proof timed_out_proof = ProvePackets(source, COMMITMENT_PACKET, {timed_out}, 6);
+    BOOST_CHECK(!ReceivePacket(timed_out, timed_out_proof));
+    Packet forged = timed_out;
+    forged.timeout_height = 5;
+    BOOST_CHECK(!RecordPacketNonReceipt(forged, timed_out_proof));
+    BOOST_CHECK(!RecordPacketNonReceipt(packets[0], ProvePackets(source, COMMITMENT_PACKET, {packets[0]}, 6)));
+    BOOST_CHECK(RecordPacketNonReceipt(timed_out, timed_out_proof));
+    BOOST_CHECK(!RecordPacketNonReceipt(timed_out, timed_out_proof));
+    BOOST_CHECK(!GeneratePacketProof(dest, COMMITMENT_NON_RECEIPT, {1001}, 6));
+    CommitBlock(7, keys);
+    const Proof non_receipt_proof = ProvePackets(dest, COMMITMENT_NON_RECEIPT, {timed_out}, 7);
+    BOOST_CHECK(!TimeoutPacket(timed_out, ProvePackets(dest, COMMITMENT_RECEIPT, {packets[0]}, 7)));
+    BOOST_CHECK(TimeoutPacket(timed_out, non_receipt_proof));
+    BOOST_CHECK(!TimeoutPacket(timed_out, non_receipt_proof));
+    BOOST_CHECK(!ReceivePacket(timed_out, timed_out_proof));
+
+    // Or past its timeout time, by the counterparty's header; ordered
+    // channels close on both ends
+    BOOST_REQUIRE(SendPacket(params::SMART_CONTRACT_PORT, "channel-0", params::SMART_CONTRACT_PORT, "channel-1",
+                             {}, 0, CLIENT_GENESIS_TIME + 8));
+    Packet expired = MakePacket(1002, "channel-0", "channel-1", {});
+    expired.timeout_timestamp = CLIENT_GENESIS_TIME + 8;
+    BOOST_REQUIRE(SendPacket(params::SMART_CONTRACT_PORT, "channel-2", params::SMART_CONTRACT_PORT, "channel-3",
+                             {}, 8, 0));
+    Packet ordered_timed_out = MakePacket(4, "channel-2", "channel-3", {});
+    ordered_timed_out.timeout_height = 8;
+    CommitBlock(8, keys);
+    BOOST_CHECK(RecordPacketNonReceipt(expired, ProvePackets(source, COMMITMENT_PACKET, {expired}, 8)));
+    BOOST_CHECK(RecordPacketNonReceipt(ordered_timed_out, ProvePackets(ordered, COMMITMENT_PACKET, {ordered_timed_out}, 8)));
+    BOOST_CHECK(GetChannel(ordered_dest)->state == Channel::CHAN_CLOSED);
+    CommitBlock(9, keys);
+    BOOST_CHECK(ProcessPacketTimeout("channel-0", 1002, ProvePackets(dest, COMMITMENT_NON_RECEIPT, {expired}, 9)));
+    BOOST_CHECK(TimeoutPacket(ordered_timed_out, ProvePackets(ordered_dest, COMMITMENT_NON_RECEIPT, {ordered_timed_out}, 9)));
+    BOOST_CHECK(GetChannel(ordered)->state == Channel::CHAN_CLOSED);
+
+    // Maintenance leaves pending packets to their proofs, and expires the client
+    BOOST_REQUIRE(SendPacket(params::SMART_CONTRACT_PORT, "channel-0", params::SMART_CONTRACT_PORT, "channel-1",
+                             {}, 0, 1));
+    CleanupExpiredIBCOperations();
+    BOOST_CHECK_EQUAL(GetIBCNetworkState().packet_commitments[source].Size(), 1U);
+    BOOST_CHECK(GetClientState("client-0")->is_active);
+    SetMockTime(CLIENT_GENESIS_TIME + 9 + CLIENT_TRUSTING_PERIOD);
+    CleanupExpiredIBCOperations();
+    BOOST_CHECK(!GetClientState("client-0")->is_active);
+    BOOST_CHECK(!VerifyPacketCommitment(packets[5], ProvePackets(source, COMMITMENT_PACKET, {packets[5]}, 1)));
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_CASE(client_updates)
+{
+    SetMockTime(CLIENT_GENESIS_TIME + 100);
+    const std::vector<CKey> keys = MakeValidatorKeys(4);
+    BOOST_REQUIRE(InitializeIBCProtocol());
+
+    // A client starts from a trusted consensus state
+    BOOST_CHECK(!CreateIBCClient("client-0", "counterparty", ClientState{}));
+    ClientState untrusted;
+    untrusted.trusting_period = CLIENT_TRUSTING_PERIOD;
+    BOOST_CHECK(!CreateIBCClient("client-0", "counterparty", untrusted));
+    CreateTestClient("client-0", keys);
+
+    // Headers need more than two thirds of the trusted validators
+    const uint256 root = m_rng.rand256();
+    const ClientHeader header = MakeHeader(1, root, keys);
+    BOOST_CHECK(!UpdateIBCClient("client-0", 1, {root.begin(), root.end()}));
+    BOOST_CHECK(!UpdateIBCClient("client-0", 1, SignHeader(header, keys, 2)));
+    BOOST_CHECK(!UpdateIBCClient("client-0", 1, SignHeader(header, keys, 4, "other-chain")));
+    BOOST_CHECK(!UpdateIBCClient("client-0", 1, SignHeader(header, MakeValidatorKeys(4), 4)));
+    BOOST_CHECK(!UpdateIBCClient("client-0", 2, SignHeader(header, keys, 4)));
+    ClientHeader future = header;
+    future.timestamp = CLIENT_GENESIS_TIME + 111;
+    BOOST_CHECK(!UpdateIBCClient("client-0", 1, SignHeader(future, keys, 4)));
+    ClientHeader past = header;
+    past.timestamp = CLIENT_GENESIS_TIME;
+    BOOST_CHECK(!UpdateIBCClient("client-0", 1, SignHeader(past, keys, 4)));
+    BOOST_CHECK(UpdateIBCClient("client-0", 1, SignHeader(header, keys, 3)));
+    BOOST_CHECK(!UpdateIBCClient("client-0", 1, SignHeader(header, keys, 4)));
+    BOOST_CHECK_EQUAL(GetClientState("client-0")->consensus_states.at(1).commitment_root, root);
+
+    // Validators hand over to the next set they signed for
+    const std::vector<CKey> next_keys = MakeValidatorKeys(7);
+    BOOST_CHECK(UpdateIBCClient("client-0", 2, SignHeader(MakeHeader(2, root, next_keys), keys, 3)));
+    BOOST_CHECK(!UpdateIBCClient("client-0", 3, SignHeader(MakeHeader(3, root, next_keys), keys, 4)));
+    BOOST_CHECK(!UpdateIBCClient("client-0", 3, SignHeader(MakeHeader(3, root, next_keys), next_keys, 4)));
+    BOOST_CHECK(UpdateIBCClient("client-0", 3, SignHeader(MakeHeader(3, root, next_keys), next_keys, 5)));
+
+    // Proofs are checked against the root of the consensus state at their height
+    std::vector<uint256> leaves;
+    interop::MerkleMountainRange commitments;
+    for (int i = 0; i < 10; ++i) {
+        leaves.push_back(m_rng.rand256());
+        commitments.Append(leaves.back());
+    }
+    BOOST_REQUIRE(UpdateIBCClient("client-0", 4, SignHeader(MakeHeader(4, commitments.GetRoot(), next_keys), next_keys, 7)));
+    DataStream stream{};
+    stream << *commitments.Prove({6}, commitments.Size());
+    Proof proof;
+    proof.proof_data.assign(UCharCast(stream.data()), UCharCast(stream.data() + stream.size()));
+    proof.proof_height = 4;
+    proof.proof_type = params::COMMITMENT_PROOF_TYPE;
+    BOOST_CHECK(VerifyClientProof("client-0", proof, {leaves[6].begin(), leaves[6].end()}));
+    BOOST_CHECK(!VerifyClientProof("client-0", proof, {leaves[5].begin(), leaves[5].end()}));
+    BOOST_CHECK(!VerifyClientProof("client-1", proof, {leaves[6].begin(), leaves[6].end()}));
+    proof.proof_height = 3;
+    BOOST_CHECK(!VerifyClientProof("client-0", proof, {leaves[6].begin(), leaves[6].end()}));
+    BOOST_CHECK(!VerifyClientProof("client-0", Proof{}, {leaves[6].begin(), leaves[6].end()}));
+
+    // Nothing is accepted from a client whose trusted state is too old
+    SetMockTime(CLIENT_GENESIS_TIME + 4 + CLIENT_TRUSTING_PERIOD);
+    BOOST_CHECK(!UpdateIBCClient("client-0", 5, SignHeader(MakeHeader(5, root, next_keys), next_keys, 7)));
+    SetMockTime(0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
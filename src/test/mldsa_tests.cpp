@@ -0,0 +1,192 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <test/data/mldsa_vectors.json.h>
+
+#include <crypto/mldsa.h>
+#include <crypto/sha256.h>
+#include <test/util/json.h>
+#include <test/util/setup_common.h>
+#include <util/strencodings.h>
+
+#include <univalue.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+using mldsa::ParameterSet;
+
+namespace {
+
+const std::vector<ParameterSet> ALL_PARAMETER_SETS{ParameterSet::ML_DSA_44, ParameterSet::ML_DSA_65, ParameterSet::ML_DSA_87};
+
+ParameterSet ParseParameterSet(const std::string& name)
+{
+    if (name == "ML-DSA-44") return ParameterSet::ML_DSA_44;
+    if (name == "ML-DSA-65") return ParameterSet::ML_DSA_65;
+    BOOST_REQUIRE_EQUAL(name, "ML-DSA-87");
+    return ParameterSet::ML_DSA_87;
+}
+
+std::string SHA256Hex(const std::vector<unsigned char>& data)
+{
+    unsigned char hash[CSHA256::OUTPUT_SIZE];
+    CSHA256().Write(data.data(), data.size()).Finalize(hash);
+    return HexStr(hash);
+}
+
+struct MLDSAKey {
+    std::vector<unsigned char> public_key;
+    std::vector<unsigned char> secret_key;
+};
+
+MLDSAKey GenerateKey(ParameterSet params, const std::vector<unsigned char>& seed)
+{
+    MLDSAKey key{std::vector<unsigned char>(mldsa::PublicKeySize(params)), std::vector<unsigned char>(mldsa::SecretKeySize(params))};
+    BOOST_REQUIRE(mldsa::KeyGen(params, seed, key.public_key, key.secret_key));
+    return key;
+}
+
+std::vector<unsigned char> SignMessage(ParameterSet params, const MLDSAKey& key, const std::vector<unsigned char>& message,
+                                       const std::vector<unsigned char>& context, const std::vector<unsigned char>& rnd)
+{
+    std::vector<unsigned char> signature(mldsa::SignatureSize(params));
+    BOOST_REQUIRE(mldsa::Sign(params, key.secret_key, message, context, rnd, signature));
+    return signature;
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(mldsa_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(mldsa_sizes)
+{
+    BOOST_CHECK_EQUAL(mldsa::PublicKeySize(ParameterSet::ML_DSA_44), 1312U);
+    BOOST_CHECK_EQUAL(mldsa::SecretKeySize(ParameterSet::ML_DSA_44), 2560U);
+    BOOST_CHECK_EQUAL(mldsa::SignatureSize(ParameterSet::ML_DSA_44), 2420U);
+    BOOST_CHECK_EQUAL(mldsa::PublicKeySize(ParameterSet::ML_DSA_65), 1952U);
+    BOOST_CHECK_EQUAL(mldsa::SecretKeySize(ParameterSet::ML_DSA_65), 4032U);
+    BOOST_CHECK_EQUAL(mldsa::SignatureSize(ParameterSet::ML_DSA_65), 3309U);
+    BOOST_CHECK_EQUAL(mldsa::PublicKeySize(ParameterSet::ML_DSA_87), 2592U);
+    BOOST_CHECK_EQUAL(mldsa::SecretKeySize(ParameterSet::ML_DSA_87), 4896U);
+    BOOST_CHECK_EQUAL(mldsa::SignatureSize(ParameterSet::ML_DSA_87), 4627U);
+}
+
+BOOST_AUTO_TEST_CASE(mldsa_known_answers)
+{
+    // Public keys and the hedged signatures come from an independent
+    // implementation; the deterministic signatures were checked against it.
+    // Every implementation of the polynomial arithmetic must agree.
+    const UniValue tests = read_json(json_tests::mldsa_vectors);
+    for (const auto use_implementation : {mldsa_implementation::STANDARD, mldsa_implementation::USE_ALL}) {
+        const std::string implementation = MLDSAAutoDetect(use_implementation);
+        for (unsigned int idx = 0; idx < tests.size(); idx++) {
+            const UniValue& test = tests[idx];
+            if (test.size() == 1) continue; // comment
+            const std::string str_test = implementation + " " + test.write();
+            BOOST_REQUIRE_MESSAGE(test.size() == 8, str_test);
+
+            const ParameterSet params = ParseParameterSet(test[0].get_str());
+            const std::vector<unsigned char> seed = ParseHex(test[1].get_str());
+            const std::vector<unsigned char> message = ParseHex(test[2].get_str());
+            const std::vector<unsigned char> context = ParseHex(test[3].get_str());
+            const std::vector<unsigned char> reference_signature = ParseHex(test[7].get_str());
+
+            const MLDSAKey key = GenerateKey(params, seed);
+            BOOST_CHECK_MESSAGE(SHA256Hex(key.public_key) == test[4].get_str(), str_test);
+            BOOST_CHECK_MESSAGE(SHA256Hex(key.secret_key) == test[5].get_str(), str_test);
+
+            const std::vector<unsigned char> signature = SignMessage(params, key, message, context, std::vector<unsigned char>(mldsa::RND_SIZE));
+            BOOST_CHECK_MESSAGE(SHA256Hex(signature) == test[6].get_str(), str_test);
+            BOOST_CHECK_MESSAGE(mldsa::Verify(params, key.public_key, message, context, signature), str_test);
+
+            BOOST_CHECK_MESSAGE(mldsa::Verify(params, key.public_key, message, context, reference_signature), str_test);
+            std::vector<unsigned char> other_context{context};
+            other_context.push_back(0);
+            BOOST_CHECK_MESSAGE(!mldsa::Verify(params, key.public_key, message, other_context, reference_signature), str_test);
+        }
+    }
+    MLDSAAutoDetect();
+}
+
+BOOST_AUTO_TEST_CASE(mldsa_sign_verify)
+{
+    for (const ParameterSet params : ALL_PARAMETER_SETS) {
+        for (int i = 0; i < 4; ++i) {
+            const MLDSAKey key = GenerateKey(params, m_rng.randbytes(mldsa::SEED_SIZE));
+            const MLDSAKey other_key = GenerateKey(params, m_rng.randbytes(mldsa::SEED_SIZE));
+            const std::vector<unsigned char> message = m_rng.randbytes(m_rng.randrange(200));
+            const std::vector<unsigned char> context = m_rng.randbytes(m_rng.randrange(mldsa::MAX_CONTEXT_SIZE + 1));
+
+            // Hedged signatures differ but all verify
+            const std::vector<unsigned char> signature = SignMessage(params, key, message, context, m_rng.randbytes(mldsa::RND_SIZE));
+            const std::vector<unsigned char> other_signature = SignMessage(params, key, message, context, m_rng.randbytes(mldsa::RND_SIZE));
+            BOOST_CHECK(signature != other_signature);
+            BOOST_CHECK(mldsa::Verify(params, key.public_key, message, context, signature));
+            BOOST_CHECK(mldsa::Verify(params, key.public_key, message, context, other_signature));
+
+            BOOST_CHECK(!mldsa::Verify(params, other_key.public_key, message, context, signature));
+            std::vector<unsigned char> other_message{message};
+            other_message.push_back(1);
+            BOOST_CHECK(!mldsa::Verify(params, key.public_key, other_message, context, signature));
+            std::vector<unsigned char> other_context{context};
+            other_context.resize(context.size() + 1);
+            BOOST_CHECK(!mldsa::Verify(params, key.public_key, message, other_context, signature));
+
+            // Any bit of the challenge or the response, which take up more
+            // than the first 1000 bytes in every parameter set
+            std::vector<unsigned char> tampered{signature};
+            tampered[m_rng.randrange(1000)] ^= 1 << m_rng.randrange(8);
+            BOOST_CHECK(!mldsa::Verify(params, key.public_key, message, context, tampered));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(mldsa_invalid_encodings)
+{
+    const ParameterSet params = ParameterSet::ML_DSA_44;
+    constexpr size_t OMEGA = 80, K = 4;
+    const MLDSAKey key = GenerateKey(params, std::vector<unsigned char>(mldsa::SEED_SIZE, 7));
+    const std::vector<unsigned char> message{'m', 's', 'g'};
+    const std::vector<unsigned char> rnd(mldsa::RND_SIZE);
+    const std::vector<unsigned char> signature = SignMessage(params, key, message, {}, rnd);
+    BOOST_REQUIRE(mldsa::Verify(params, key.public_key, message, {}, signature));
+
+    // Sizes
+    std::vector<unsigned char> public_key(mldsa::PublicKeySize(params)), secret_key(mldsa::SecretKeySize(params)), out(mldsa::SignatureSize(params));
+    BOOST_CHECK(!mldsa::KeyGen(params, std::vector<unsigned char>(31), public_key, secret_key));
+    BOOST_CHECK(!mldsa::KeyGen(params, std::vector<unsigned char>(32), public_key, Span{secret_key}.first(100)));
+    BOOST_CHECK(!mldsa::Sign(params, key.secret_key, message, std::vector<unsigned char>(mldsa::MAX_CONTEXT_SIZE + 1), rnd, out));
+    BOOST_CHECK(!mldsa::Sign(params, key.secret_key, message, {}, std::vector<unsigned char>(16), out));
+    BOOST_CHECK(!mldsa::Verify(params, key.public_key, message, std::vector<unsigned char>(mldsa::MAX_CONTEXT_SIZE + 1), signature));
+    BOOST_CHECK(!mldsa::Verify(params, key.public_key, message, {}, Span{signature}.first(signature.size() - 1)));
+    BOOST_CHECK(!mldsa::Verify(ParameterSet::ML_DSA_65, key.public_key, message, {}, signature));
+
+    // A response coefficient out of range: all ones is -(2^17 - 1)
+    std::vector<unsigned char> tampered{signature};
+    tampered[32] = tampered[33] = 0xFF;
+    tampered[34] |= 0x03;
+    BOOST_CHECK(!mldsa::Verify(params, key.public_key, message, {}, tampered));
+
+    // Hint encodings other than the unique one
+    const size_t hints = signature.size() - OMEGA - K;
+    const unsigned hint_count = signature.back();
+    BOOST_REQUIRE(hint_count > 1);
+    tampered = signature;
+    tampered[signature.size() - 1] = OMEGA + 1;
+    BOOST_CHECK(!mldsa::Verify(params, key.public_key, message, {}, tampered));
+    tampered = signature;
+    tampered[signature.size() - K] = hint_count + 1;
+    BOOST_CHECK(!mldsa::Verify(params, key.public_key, message, {}, tampered));
+    tampered = signature;
+    tampered[hints + OMEGA - 1] = 1;
+    BOOST_CHECK(hint_count == OMEGA || !mldsa::Verify(params, key.public_key, message, {}, tampered));
+    tampered = signature;
+    std::swap(tampered[hints + hint_count - 2], tampered[hints + hint_count - 1]);
+    BOOST_CHECK(!mldsa::Verify(params, key.public_key, message, {}, tampered));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,153 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <test/data/mlkem_vectors.json.h>
+
+#include <crypto/mlkem.h>
+#include <crypto/sha256.h>
+#include <test/util/json.h>
+#include <test/util/setup_common.h>
+#include <util/strencodings.h>
+
+#include <univalue.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+using mlkem::ParameterSet;
+
+namespace {
+
+const std::vector<ParameterSet> ALL_PARAMETER_SETS{ParameterSet::ML_KEM_768, ParameterSet::ML_KEM_1024};
+
+ParameterSet ParseParameterSet(const std::string& name)
+{
+    if (name == "ML-KEM-768") return ParameterSet::ML_KEM_768;
+    BOOST_REQUIRE_EQUAL(name, "ML-KEM-1024");
+    return ParameterSet::ML_KEM_1024;
+}
+
+std::string SHA256Hex(const std::vector<unsigned char>& data)
+{
+    unsigned char hash[CSHA256::OUTPUT_SIZE];
+    CSHA256().Write(data.data(), data.size()).Finalize(hash);
+    return HexStr(hash);
+}
+
+struct MLKEMKey {
+    std::vector<unsigned char> encaps_key;
+    std::vector<unsigned char> decaps_key;
+};
+
+MLKEMKey GenerateKey(ParameterSet params, const std::vector<unsigned char>& seed)
+{
+    MLKEMKey key{std::vector<unsigned char>(mlkem::EncapsulationKeySize(params)), std::vector<unsigned char>(mlkem::DecapsulationKeySize(params))};
+    BOOST_REQUIRE(mlkem::KeyGen(params, seed, key.encaps_key, key.decaps_key));
+    return key;
+}
+
+std::vector<unsigned char> Decapsulate(ParameterSet params, const MLKEMKey& key, const std::vector<unsigned char>& ciphertext)
+{
+    std::vector<unsigned char> shared_secret(mlkem::SHARED_SECRET_SIZE);
+    BOOST_REQUIRE(mlkem::Decaps(params, key.decaps_key, ciphertext, shared_secret));
+    return shared_secret;
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(mlkem_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(mlkem_sizes)
+{
+    BOOST_CHECK_EQUAL(mlkem::EncapsulationKeySize(ParameterSet::ML_KEM_768), 1184U);
+    BOOST_CHECK_EQUAL(mlkem::DecapsulationKeySize(ParameterSet::ML_KEM_768), 2400U);
+    BOOST_CHECK_EQUAL(mlkem::CiphertextSize(ParameterSet::ML_KEM_768), 1088U);
+    BOOST_CHECK_EQUAL(mlkem::EncapsulationKeySize(ParameterSet::ML_KEM_1024), 1568U);
+    BOOST_CHECK_EQUAL(mlkem::DecapsulationKeySize(ParameterSet::ML_KEM_1024), 3168U);
+    BOOST_CHECK_EQUAL(mlkem::CiphertextSize(ParameterSet::ML_KEM_1024), 1568U);
+}
+
+BOOST_AUTO_TEST_CASE(mlkem_known_answers)
+{
+    // Encapsulation keys, the reference ciphertexts and the rejection secrets
+    // come from an independent implementation, which also decapsulated our
+    // ciphertexts to the same secrets.
+    const UniValue tests = read_json(json_tests::mlkem_vectors);
+    for (unsigned int idx = 0; idx < tests.size(); idx++) {
+        const UniValue& test = tests[idx];
+        if (test.size() == 1) continue; // comment
+        const std::string str_test = test.write();
+        BOOST_REQUIRE_MESSAGE(test.size() == 10, str_test);
+
+        const ParameterSet params = ParseParameterSet(test[0].get_str());
+        const MLKEMKey key = GenerateKey(params, ParseHex(test[1].get_str()));
+        BOOST_CHECK_MESSAGE(SHA256Hex(key.encaps_key) == test[2].get_str(), str_test);
+        BOOST_CHECK_MESSAGE(SHA256Hex(key.decaps_key) == test[3].get_str(), str_test);
+
+        std::vector<unsigned char> ciphertext(mlkem::CiphertextSize(params)), shared_secret(mlkem::SHARED_SECRET_SIZE);
+        BOOST_REQUIRE(mlkem::Encaps(params, key.encaps_key, ParseHex(test[4].get_str()), ciphertext, shared_secret));
+        BOOST_CHECK_MESSAGE(SHA256Hex(ciphertext) == test[5].get_str(), str_test);
+        BOOST_CHECK_MESSAGE(HexStr(shared_secret) == test[6].get_str(), str_test);
+        BOOST_CHECK_MESSAGE(Decapsulate(params, key, ciphertext) == shared_secret, str_test);
+
+        std::vector<unsigned char> reference_ciphertext = ParseHex(test[7].get_str());
+        BOOST_CHECK_MESSAGE(HexStr(Decapsulate(params, key, reference_ciphertext)) == test[8].get_str(), str_test);
+        reference_ciphertext[0] ^= 1;
+        BOOST_CHECK_MESSAGE(HexStr(Decapsulate(params, key, reference_ciphertext)) == test[9].get_str(), str_test);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(mlkem_encaps_decaps)
+{
+    for (const ParameterSet params : ALL_PARAMETER_SETS) {
+        for (int i = 0; i < 4; ++i) {
+            const MLKEMKey key = GenerateKey(params, m_rng.randbytes(mlkem::SEED_SIZE));
+            const MLKEMKey other_key = GenerateKey(params, m_rng.randbytes(mlkem::SEED_SIZE));
+
+            std::vector<unsigned char> ciphertext(mlkem::CiphertextSize(params)), shared_secret(mlkem::SHARED_SECRET_SIZE);
+            BOOST_REQUIRE(mlkem::Encaps(params, key.encaps_key, m_rng.randbytes(mlkem::ENCAPS_SEED_SIZE), ciphertext, shared_secret));
+            BOOST_CHECK(Decapsulate(params, key, ciphertext) == shared_secret);
+            BOOST_CHECK(Decapsulate(params, other_key, ciphertext) != shared_secret);
+
+            // Any modified bit gives an unrelated secret, the same one every time
+            std::vector<unsigned char> tampered{ciphertext};
+            tampered[m_rng.randrange(tampered.size())] ^= 1 << m_rng.randrange(8);
+            const std::vector<unsigned char> rejected = Decapsulate(params, key, tampered);
+            BOOST_CHECK(rejected != shared_secret);
+            BOOST_CHECK(Decapsulate(params, key, tampered) == rejected);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(mlkem_invalid_keys)
+{
+    const ParameterSet params = ParameterSet::ML_KEM_768;
+    const MLKEMKey key = GenerateKey(params, std::vector<unsigned char>(mlkem::SEED_SIZE, 7));
+    const std::vector<unsigned char> m(mlkem::ENCAPS_SEED_SIZE);
+    std::vector<unsigned char> ciphertext(mlkem::CiphertextSize(params)), shared_secret(mlkem::SHARED_SECRET_SIZE);
+    BOOST_REQUIRE(mlkem::Encaps(params, key.encaps_key, m, ciphertext, shared_secret));
+
+    // Sizes
+    std::vector<unsigned char> encaps_key(mlkem::EncapsulationKeySize(params)), decaps_key(mlkem::DecapsulationKeySize(params));
+    BOOST_CHECK(!mlkem::KeyGen(params, std::vector<unsigned char>(32), encaps_key, decaps_key));
+    BOOST_CHECK(!mlkem::KeyGen(params, std::vector<unsigned char>(mlkem::SEED_SIZE), encaps_key, Span{decaps_key}.first(100)));
+    BOOST_CHECK(!mlkem::Encaps(params, key.encaps_key, std::vector<unsigned char>(16), ciphertext, shared_secret));
+    BOOST_CHECK(!mlkem::Encaps(ParameterSet::ML_KEM_1024, key.encaps_key, m, ciphertext, shared_secret));
+    BOOST_CHECK(!mlkem::Decaps(params, key.decaps_key, Span{ciphertext}.first(ciphertext.size() - 1), shared_secret));
+
+    // A coefficient of 0xFFF is not reduced mod q and fails the modulus check
+    std::vector<unsigned char> unreduced{key.encaps_key};
+    unreduced[0] = 0xFF;
+    unreduced[1] |= 0x0F;
+    BOOST_CHECK(!mlkem::Encaps(params, unreduced, m, ciphertext, shared_secret));
+
+    // The hash of the encapsulation key inside the decapsulation key is checked
+    std::vector<unsigned char> tampered{key.decaps_key};
+    tampered[384 * 3] ^= 1;
+    BOOST_CHECK(!mlkem::Decaps(params, tampered, ciphertext, shared_secret));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1024,12 +1024,14 @@ class V2TransportTester
     std::vector<uint8_t> m_received; //!< Bytes we have received from m_transport.
     std::deque<CSerializedNetMsg> m_msg_to_send; //!< Messages to be sent *by* m_transport to us.
     bool m_sent_aad{false};
+    std::optional<BIP324KEMKey> m_kem_key; //!< The ML-KEM key pair we offered, if any.
 
 public:
-    /** Construct a tester object. test_initiator: whether the tested transport is initiator. */
-    explicit V2TransportTester(FastRandomContext& rng, bool test_initiator)
+    /** Construct a tester object. test_initiator: whether the tested transport is initiator.
+     *  hybrid: whether the tested transport attempts or offers the hybrid ML-KEM handshake. */
+    explicit V2TransportTester(FastRandomContext& rng, bool test_initiator, bool hybrid = false)
         : m_rng{rng},
-          m_transport{0, test_initiator},
+          m_transport{0, test_initiator, hybrid},
           m_cipher{GenerateRandomTestKey(m_rng), MakeByteSpan(m_rng.rand256())},
           m_test_initiator(test_initiator) {}
 
@@ -1141,6 +1143,17 @@ public:
          SendGarbage(m_rng.randrange(V2Transport::MAX_GARBAGE_LEN + 1));
     }
 
+    /** Schedule garbage starting with a fresh ML-KEM encapsulation key to be sent to the
+     *  transport, offering the hybrid handshake. */
+    void SendKEMGarbage(size_t garbage_len)
+    {
+        m_kem_key = BIP324KEMKey::Generate();
+        std::vector<uint8_t> garbage{m_kem_key->encaps_key};
+        const auto random_garbage = m_rng.randbytes<uint8_t>(garbage_len);
+        garbage.insert(garbage.end(), random_garbage.begin(), random_garbage.end());
+        SendGarbage(garbage);
+    }
+
     /** Schedule a message to be sent to us by the transport. */
     void AddMessage(std::string m_type, std::vector<uint8_t> payload)
     {
@@ -1259,6 +1272,35 @@ public:
         BOOST_CHECK(contents.empty());
     }
 
+    /** Expect version packet carrying an ML-KEM ciphertext for the key we offered to have been
+     *  received, and switch to the hybrid keys (only after SendKEMGarbage and ReceiveGarbage). */
+    void ReceiveKEMVersion()
+    {
+        auto contents = ReceivePacket(/*aad=*/MakeByteSpan(m_recv_garbage));
+        BOOST_REQUIRE(m_kem_key && contents.size() == BIP324Cipher::KEM_CIPHERTEXT_LEN);
+        m_cipher.Decapsulate(*m_kem_key, MakeByteSpan(contents), !m_test_initiator);
+        BOOST_CHECK(m_cipher.SwitchSendCipher());
+        BOOST_CHECK(m_cipher.SwitchRecvCipher());
+    }
+
+    /** Encapsulate to the ML-KEM key at the start of the received garbage, and schedule a version
+     *  packet carrying the ciphertext (optionally with a bit error) to be sent to the transport.
+     *  Packets sent afterwards use the hybrid keys (only after ReceiveGarbage). */
+    void SendKEMVersion(bool damage = false)
+    {
+        BOOST_REQUIRE(m_recv_garbage.size() >= BIP324Cipher::KEM_ENCAPS_KEY_LEN);
+        std::vector<uint8_t> kem_ciphertext(BIP324Cipher::KEM_CIPHERTEXT_LEN);
+        BOOST_REQUIRE(m_cipher.Encapsulate(MakeByteSpan(m_recv_garbage).first(BIP324Cipher::KEM_ENCAPS_KEY_LEN),
+                                           MakeWritableByteSpan(kem_ciphertext), !m_test_initiator));
+        if (damage) kem_ciphertext[m_rng.randrange(kem_ciphertext.size())] ^= uint8_t{1} << m_rng.randrange(8);
+        SendVersion(kem_ciphertext);
+        BOOST_CHECK(m_cipher.SwitchSendCipher());
+    }
+
+    /** Switch to the hybrid keys for received packets (only after SendKEMVersion, once the
+     *  version packet has been received). */
+    void SwitchRecvCipher() { BOOST_CHECK(m_cipher.SwitchRecvCipher()); }
+
     /** Expect application packet to have been received, with specified short id and payload.
      *  (only after ReceiveKey). */
     void ReceiveMessage(uint8_t short_id, Span<const uint8_t> payload)
@@ -1546,4 +1588,91 @@ BOOST_AUTO_TEST_CASE(v2transport_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(v2transport_hybrid_test)
+{
+    // A hybrid initiator, with a responder offering an ML-KEM key at the start of its garbage.
+    for (int i = 0; i < 5; ++i) {
+        V2TransportTester tester(m_rng, true, /*hybrid=*/true);
+        tester.SendKey();
+        tester.SendKEMGarbage(m_rng.randrange(V2Transport::MAX_GARBAGE_LEN - BIP324Cipher::KEM_ENCAPS_KEY_LEN + 1));
+        auto ret = tester.Interact();
+        BOOST_REQUIRE(ret && ret->empty());
+        tester.ReceiveKey();
+        // Our own version packet still uses the ECDH keys.
+        tester.SendGarbageTerm();
+        tester.SendVersion();
+        ret = tester.Interact();
+        BOOST_REQUIRE(ret && ret->empty());
+        tester.ReceiveGarbage();
+        tester.ReceiveKEMVersion();
+        tester.CompareSessionIDs();
+        auto msg_data_1 = m_rng.randbytes<uint8_t>(m_rng.randrange(100000));
+        auto msg_data_2 = m_rng.randbytes<uint8_t>(m_rng.randrange(1000));
+        tester.SendMessage(uint8_t(4), msg_data_1); // cmpctblock short id
+        tester.AddMessage("tx", msg_data_2);
+        ret = tester.Interact();
+        BOOST_REQUIRE(ret && ret->size() == 1);
+        BOOST_CHECK((*ret)[0] && (*ret)[0]->m_type == "cmpctblock" && std::ranges::equal((*ret)[0]->m_recv, MakeByteSpan(msg_data_1)));
+        tester.ReceiveMessage(uint8_t(21), msg_data_2); // "tx" short id
+    }
+
+    // A hybrid responder, with an initiator that encapsulates to its key. A bit error in the
+    // ciphertext leaves the two sides with different keys, so the first message fails.
+    for (int i = 0; i < 6; ++i) {
+        const bool damage = i == 5;
+        V2TransportTester tester(m_rng, false, /*hybrid=*/true);
+        tester.SendKey();
+        tester.SendGarbage();
+        auto ret = tester.Interact();
+        BOOST_REQUIRE(ret && ret->empty());
+        tester.ReceiveKey();
+        tester.ReceiveGarbage();
+        tester.ReceiveVersion();
+        tester.SendGarbageTerm();
+        tester.SendKEMVersion(damage);
+        tester.SwitchRecvCipher();
+        tester.AddMessage("pong", {});
+        ret = tester.Interact();
+        BOOST_REQUIRE(ret && ret->empty());
+        tester.CompareSessionIDs();
+        auto msg_data = m_rng.randbytes<uint8_t>(m_rng.randrange(100000));
+        tester.SendMessage(uint8_t(14), msg_data); // inv short id
+        ret = tester.Interact();
+        if (damage) {
+            BOOST_CHECK(!ret);
+        } else {
+            BOOST_REQUIRE(ret && ret->size() == 1);
+            BOOST_CHECK((*ret)[0] && (*ret)[0]->m_type == "inv" && std::ranges::equal((*ret)[0]->m_recv, MakeByteSpan(msg_data)));
+            tester.ReceiveMessage(uint8_t(19), {}); // "pong" short id
+        }
+    }
+
+    // Either side falls back to the plain handshake with a peer that does not take part: a
+    // hybrid initiator given random garbage of any length, or a hybrid responder whose key goes
+    // unused.
+    for (int i = 0; i < 10; ++i) {
+        const bool initiator = m_rng.randbool();
+        V2TransportTester tester(m_rng, initiator, /*hybrid=*/true);
+        tester.SendKey();
+        tester.SendGarbage(m_rng.randbool() ? m_rng.randrange(BIP324Cipher::KEM_ENCAPS_KEY_LEN) : V2Transport::MAX_GARBAGE_LEN);
+        auto ret = tester.Interact();
+        BOOST_REQUIRE(ret && ret->empty());
+        tester.ReceiveKey();
+        tester.SendGarbageTerm();
+        tester.SendVersion();
+        tester.AddMessage("pong", {});
+        ret = tester.Interact();
+        BOOST_REQUIRE(ret && ret->empty());
+        tester.ReceiveGarbage();
+        tester.ReceiveVersion();
+        tester.CompareSessionIDs();
+        auto msg_data = m_rng.randbytes<uint8_t>(m_rng.randrange(100000));
+        tester.SendMessage(uint8_t(14), msg_data); // inv short id
+        ret = tester.Interact();
+        BOOST_REQUIRE(ret && ret->size() == 1);
+        BOOST_CHECK((*ret)[0] && (*ret)[0]->m_type == "inv" && std::ranges::equal((*ret)[0]->m_recv, MakeByteSpan(msg_data)));
+        tester.ReceiveMessage(uint8_t(19), {}); // "pong" short id
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,229 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <addresstype.h>
+#include <coins.h>
+#include <crypto/mldsa.h>
+#include <crypto/sha256.h>
+#include <policy/policy.h>
+#include <primitives/transaction.h>
+#include <script/interpreter.h>
+#include <script/script.h>
+#include <script/sigcache.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+using mldsa::ParameterSet;
+
+namespace {
+
+const std::vector<ParameterSet> ALL_PARAMETER_SETS{ParameterSet::ML_DSA_44, ParameterSet::ML_DSA_65, ParameterSet::ML_DSA_87};
+
+constexpr unsigned int QUANTUM_FLAGS{SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_WITNESS | SCRIPT_VERIFY_TAPROOT | SCRIPT_VERIFY_QUANTUM};
+
+std::vector<unsigned char> SHA256Program(const std::vector<unsigned char>& pubkey)
+{
+    std::vector<unsigned char> program(CSHA256::OUTPUT_SIZE);
+    CSHA256().Write(pubkey.data(), pubkey.size()).Finalize(program.data());
+    return program;
+}
+
+/** A transaction spending a witness v2 output to an ML-DSA key. */
+struct QuantumSpend {
+    ParameterSet params;
+    std::vector<unsigned char> pubkey;
+    std::vector<unsigned char> secret_key;
+    CMutableTransaction tx;
+    std::vector<CTxOut> spent_outputs;
+
+    QuantumSpend(FastRandomContext& rng, ParameterSet params_in)
+        : params{params_in}, pubkey(mldsa::PublicKeySize(params)), secret_key(mldsa::SecretKeySize(params))
+    {
+        BOOST_REQUIRE(mldsa::KeyGen(params, rng.randbytes(mldsa::SEED_SIZE), pubkey, secret_key));
+        tx.vin.emplace_back(COutPoint{Txid::FromUint256(rng.rand256()), 0});
+        tx.vout.emplace_back(40000, CScript() << OP_TRUE);
+        spent_outputs.emplace_back(50000, CScript() << OP_2 << SHA256Program(pubkey));
+    }
+
+    uint256 SignatureHash(uint8_t hashtype, SigVersion sigversion = SigVersion::QUANTUM) const
+    {
+        PrecomputedTransactionData txdata;
+        txdata.Init(tx, std::vector<CTxOut>{spent_outputs}, /*force=*/true);
+        ScriptExecutionData execdata;
+        execdata.m_annex_init = true;
+        execdata.m_annex_present = false;
+        uint256 sighash;
+        BOOST_REQUIRE(SignatureHashSchnorr(sighash, execdata, tx, 0, hashtype, sigversion, txdata, MissingDataBehavior::FAIL));
+        return sighash;
+    }
+
+    /** Sign the transaction as it is now, appending hashtype unless it is SIGHASH_DEFAULT. */
+    std::vector<unsigned char> Sign(FastRandomContext& rng, uint8_t hashtype = SIGHASH_DEFAULT) const
+    {
+        std::vector<unsigned char> sig(mldsa::SignatureSize(params));
+        BOOST_REQUIRE(mldsa::Sign(params, secret_key, SignatureHash(hashtype), {}, rng.randbytes(mldsa::RND_SIZE), sig));
+        if (hashtype != SIGHASH_DEFAULT) sig.push_back(hashtype);
+        return sig;
+    }
+
+    void SetWitness(std::vector<std::vector<unsigned char>> stack) { tx.vin[0].scriptWitness.stack = std::move(stack); }
+
+    ScriptError Verify(unsigned int flags) const
+    {
+        const CTransaction tx_to{tx};
+        PrecomputedTransactionData txdata;
+        txdata.Init(tx_to, std::vector<CTxOut>{spent_outputs});
+        ScriptError serror;
+        const TransactionSignatureChecker checker{&tx_to, 0, spent_outputs[0].nValue, txdata, MissingDataBehavior::ASSERT_FAIL};
+        VerifyScript(tx_to.vin[0].scriptSig, spent_outputs[0].scriptPubKey, &tx_to.vin[0].scriptWitness, flags, checker, &serror);
+        return serror;
+    }
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(script_quantum_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(quantum_spend)
+{
+    for (const ParameterSet params : ALL_PARAMETER_SETS) {
+        QuantumSpend spend{m_rng, params};
+        spend.SetWitness({spend.Sign(m_rng), spend.pubkey});
+        BOOST_CHECK_EQUAL(spend.Verify(QUANTUM_FLAGS), SCRIPT_ERR_OK);
+
+        // An explicit hash type is committed to
+        spend.SetWitness({spend.Sign(m_rng, SIGHASH_ALL | SIGHASH_ANYONECANPAY), spend.pubkey});
+        BOOST_CHECK_EQUAL(spend.Verify(QUANTUM_FLAGS), SCRIPT_ERR_OK);
+        spend.tx.vin[0].scriptWitness.stack[0].back() = SIGHASH_ALL;
+        BOOST_CHECK_EQUAL(spend.Verify(QUANTUM_FLAGS), SCRIPT_ERR_QUANTUM_SIG);
+
+        // So is the transaction
+        spend.SetWitness({spend.Sign(m_rng), spend.pubkey});
+        spend.tx.vout[0].nValue -= 1;
+        BOOST_CHECK_EQUAL(spend.Verify(QUANTUM_FLAGS), SCRIPT_ERR_QUANTUM_SIG);
+
+        // Before activation, witness v2 outputs are anyone-can-spend
+        BOOST_CHECK_EQUAL(spend.Verify(QUANTUM_FLAGS & ~SCRIPT_VERIFY_QUANTUM), SCRIPT_ERR_OK);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(quantum_spend_invalid)
+{
+    QuantumSpend spend{m_rng, ParameterSet::ML_DSA_44};
+    const std::vector<unsigned char> sig = spend.Sign(m_rng);
+
+    std::vector<unsigned char> bad_sig{sig};
+    bad_sig[m_rng.randrange(bad_sig.size())] ^= 1 << m_rng.randrange(8);
+    spend.SetWitness({bad_sig, spend.pubkey});
+    BOOST_CHECK_EQUAL(spend.Verify(QUANTUM_FLAGS), SCRIPT_ERR_QUANTUM_SIG);
+
+    spend.SetWitness({std::vector<unsigned char>(sig.begin(), sig.end() - 1), spend.pubkey});
+    BOOST_CHECK_EQUAL(spend.Verify(QUANTUM_FLAGS), SCRIPT_ERR_QUANTUM_SIG_SIZE);
+    spend.SetWitness({{}, spend.pubkey});
+    BOOST_CHECK_EQUAL(spend.Verify(QUANTUM_FLAGS), SCRIPT_ERR_QUANTUM_SIG_SIZE);
+
+    // SIGHASH_DEFAULT must not be explicit, and undefined hash types are invalid
+    for (const uint8_t hashtype : {uint8_t{SIGHASH_DEFAULT}, uint8_t{0x04}, uint8_t{0x84}}) {
+        std::vector<unsigned char> hashtype_sig{sig};
+        hashtype_sig.push_back(hashtype);
+        spend.SetWitness({hashtype_sig, spend.pubkey});
+        BOOST_CHECK_EQUAL(spend.Verify(QUANTUM_FLAGS), SCRIPT_ERR_QUANTUM_SIG_HASHTYPE);
+    }
+
+    // The witness is exactly a signature and the committed public key
+    const QuantumSpend other{m_rng, ParameterSet::ML_DSA_44};
+    spend.SetWitness({sig, other.pubkey});
+    BOOST_CHECK_EQUAL(spend.Verify(QUANTUM_FLAGS), SCRIPT_ERR_WITNESS_PROGRAM_MISMATCH);
+    spend.SetWitness({sig});
+    BOOST_CHECK_EQUAL(spend.Verify(QUANTUM_FLAGS), SCRIPT_ERR_WITNESS_PROGRAM_MISMATCH);
+    spend.SetWitness({sig, spend.pubkey, {}});
+    BOOST_CHECK_EQUAL(spend.Verify(QUANTUM_FLAGS), SCRIPT_ERR_WITNESS_PROGRAM_MISMATCH);
+    spend.SetWitness({});
+    BOOST_CHECK_EQUAL(spend.Verify(QUANTUM_FLAGS), SCRIPT_ERR_WITNESS_PROGRAM_WITNESS_EMPTY);
+
+    // A P2SH-wrapped witness v2 program is left for a future upgrade
+    const CScript redeem_script{spend.spent_outputs[0].scriptPubKey};
+    spend.spent_outputs[0].scriptPubKey = GetScriptForDestination(ScriptHash(redeem_script));
+    spend.tx.vin[0].scriptSig = CScript() << std::vector<unsigned char>(redeem_script.begin(), redeem_script.end());
+    spend.SetWitness({bad_sig, spend.pubkey});
+    BOOST_CHECK_EQUAL(spend.Verify(QUANTUM_FLAGS), SCRIPT_ERR_OK);
+    BOOST_CHECK_EQUAL(spend.Verify(QUANTUM_FLAGS | SCRIPT_VERIFY_DISCOURAGE_UPGRADABLE_WITNESS_PROGRAM), SCRIPT_ERR_DISCOURAGE_UPGRADABLE_WITNESS_PROGRAM);
+}
+
+BOOST_AUTO_TEST_CASE(quantum_spend_standard)
+{
+    QuantumSpend spend{m_rng, ParameterSet::ML_DSA_44};
+    spend.SetWitness({spend.Sign(m_rng), spend.pubkey});
+    CCoinsView coins_dummy;
+    CCoinsViewCache coins{&coins_dummy};
+    coins.AddCoin(spend.tx.vin[0].prevout, Coin{spend.spent_outputs[0], /*nHeightIn=*/1, /*fCoinBaseIn=*/false}, /*possible_overwrite=*/false);
+
+    // Until the deployment is active, nothing but policy keeps others from taking the coins
+    const CTransaction tx{spend.tx};
+    BOOST_CHECK(!IsWitnessStandard(tx, coins, /*quantum_active=*/false));
+    BOOST_CHECK(IsWitnessStandard(tx, coins, /*quantum_active=*/true));
+}
+
+BOOST_AUTO_TEST_CASE(quantum_unknown_pubkey_size)
+{
+    QuantumSpend spend{m_rng, ParameterSet::ML_DSA_44};
+    const std::vector<unsigned char> pubkey{m_rng.randbytes(mldsa::PublicKeySize(ParameterSet::ML_DSA_44) + 1)};
+    spend.spent_outputs[0].scriptPubKey = CScript() << OP_2 << SHA256Program(pubkey);
+    spend.SetWitness({{}, pubkey});
+    BOOST_CHECK_EQUAL(spend.Verify(QUANTUM_FLAGS), SCRIPT_ERR_OK);
+    BOOST_CHECK_EQUAL(spend.Verify(QUANTUM_FLAGS | SCRIPT_VERIFY_DISCOURAGE_UPGRADABLE_PUBKEYTYPE), SCRIPT_ERR_DISCOURAGE_UPGRADABLE_PUBKEYTYPE);
+    BOOST_CHECK_EQUAL(CountWitnessSigOps(spend.tx.vin[0].scriptSig, spend.spent_outputs[0].scriptPubKey, &spend.tx.vin[0].scriptWitness, QUANTUM_FLAGS), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(quantum_sighash)
+{
+    // A witness v2 signature can't be replayed as a Taproot key path signature of the same transaction
+    const QuantumSpend spend{m_rng, ParameterSet::ML_DSA_44};
+    BOOST_CHECK(spend.SignatureHash(SIGHASH_DEFAULT) != spend.SignatureHash(SIGHASH_DEFAULT, SigVersion::TAPROOT));
+    BOOST_CHECK(spend.SignatureHash(SIGHASH_DEFAULT) != spend.SignatureHash(SIGHASH_ALL));
+}
+
+BOOST_AUTO_TEST_CASE(quantum_sigops)
+{
+    const std::vector<size_t> expected_sigops{3, 5, 9};
+    for (size_t i = 0; i < ALL_PARAMETER_SETS.size(); ++i) {
+        QuantumSpend spend{m_rng, ALL_PARAMETER_SETS[i]};
+        spend.SetWitness({{}, spend.pubkey});
+        const CScript& script_pubkey{spend.spent_outputs[0].scriptPubKey};
+        const CScriptWitness& witness{spend.tx.vin[0].scriptWitness};
+        BOOST_CHECK_EQUAL(GetQuantumSigOpCost(ALL_PARAMETER_SETS[i]), expected_sigops[i]);
+        BOOST_CHECK_EQUAL(CountWitnessSigOps(CScript(), script_pubkey, &witness, QUANTUM_FLAGS), expected_sigops[i]);
+        BOOST_CHECK_EQUAL(CountWitnessSigOps(CScript(), script_pubkey, &witness, QUANTUM_FLAGS & ~SCRIPT_VERIFY_QUANTUM), 0U);
+
+        spend.SetWitness({{}, spend.pubkey, {}});
+        BOOST_CHECK_EQUAL(CountWitnessSigOps(CScript(), script_pubkey, &spend.tx.vin[0].scriptWitness, QUANTUM_FLAGS), 0U);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(quantum_signature_cache)
+{
+    SignatureCache cache{1 << 20};
+    QuantumSpend spend{m_rng, ParameterSet::ML_DSA_65};
+    const std::vector<unsigned char> sig = spend.Sign(m_rng);
+    spend.SetWitness({sig, spend.pubkey});
+    uint256 entry;
+    cache.ComputeEntryQuantum(entry, spend.SignatureHash(SIGHASH_DEFAULT), spend.params, spend.pubkey, sig);
+
+    const CTransaction tx{spend.tx};
+    PrecomputedTransactionData txdata;
+    txdata.Init(tx, std::vector<CTxOut>{spend.spent_outputs});
+    for (const bool store : {false, true}) {
+        ScriptError serror;
+        const CachingTransactionSignatureChecker checker{&tx, 0, spend.spent_outputs[0].nValue, store, cache, txdata};
+        BOOST_CHECK(VerifyScript(tx.vin[0].scriptSig, spend.spent_outputs[0].scriptPubKey, &tx.vin[0].scriptWitness, QUANTUM_FLAGS, checker, &serror));
+        BOOST_CHECK_EQUAL(serror, SCRIPT_ERR_OK);
+        BOOST_CHECK_EQUAL(cache.Get(entry, /*erase=*/false), store);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
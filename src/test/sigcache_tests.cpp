@@ -0,0 +1,71 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/mldsa.h>
+#include <script/sigcache.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+using mldsa::ParameterSet;
+
+namespace {
+
+struct QuantumSignature {
+    ParameterSet params;
+    std::vector<unsigned char> pubkey;
+    uint256 hash;
+    std::vector<unsigned char> sig;
+};
+
+QuantumSignature MakeQuantumSignature(FastRandomContext& rng, ParameterSet params)
+{
+    QuantumSignature signature{params, std::vector<unsigned char>(mldsa::PublicKeySize(params)), rng.rand256(),
+                               std::vector<unsigned char>(mldsa::SignatureSize(params))};
+    std::vector<unsigned char> secret_key(mldsa::SecretKeySize(params));
+    BOOST_REQUIRE(mldsa::KeyGen(params, rng.randbytes(mldsa::SEED_SIZE), signature.pubkey, secret_key));
+    BOOST_REQUIRE(mldsa::Sign(params, secret_key, signature.hash, {}, rng.randbytes(mldsa::RND_SIZE), signature.sig));
+    return signature;
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(sigcache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(quantum_signature_cache)
+{
+    SignatureCache cache{1 << 20};
+    const QuantumSignature valid = MakeQuantumSignature(m_rng, ParameterSet::ML_DSA_44);
+
+    // Every part of the check goes into the entry
+    uint256 entry;
+    cache.ComputeEntryQuantum(entry, valid.hash, valid.params, valid.pubkey, valid.sig);
+    std::vector<uint256> others(4);
+    cache.ComputeEntryQuantum(others[0], m_rng.rand256(), valid.params, valid.pubkey, valid.sig);
+    cache.ComputeEntryQuantum(others[1], valid.hash, ParameterSet::ML_DSA_65, valid.pubkey, valid.sig);
+    std::vector<unsigned char> other_pubkey{valid.pubkey};
+    other_pubkey.back() ^= 1;
+    cache.ComputeEntryQuantum(others[2], valid.hash, valid.params, other_pubkey, valid.sig);
+    std::vector<unsigned char> other_sig{valid.sig};
+    other_sig.front() ^= 1;
+    cache.ComputeEntryQuantum(others[3], valid.hash, valid.params, valid.pubkey, other_sig);
+    for (const uint256& other : others) BOOST_CHECK(other != entry);
+
+    // Only valid signatures are stored, and only when asked to
+    BOOST_CHECK(!VerifyQuantumSignatureCached(cache, valid.params, valid.pubkey, valid.hash, other_sig, /*store=*/true));
+    BOOST_CHECK(!cache.Get(others[3], /*erase=*/false));
+    BOOST_CHECK(VerifyQuantumSignatureCached(cache, valid.params, valid.pubkey, valid.hash, valid.sig, /*store=*/false));
+    BOOST_CHECK(!cache.Get(entry, /*erase=*/false));
+    BOOST_CHECK(VerifyQuantumSignatureCached(cache, valid.params, valid.pubkey, valid.hash, valid.sig, /*store=*/true));
+    BOOST_CHECK(cache.Get(entry, /*erase=*/false));
+
+    // A cached entry is trusted without verifying again
+    cache.Set(others[3]);
+    BOOST_CHECK(VerifyQuantumSignatureCached(cache, valid.params, valid.pubkey, valid.hash, other_sig, /*store=*/false));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,568 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <arith_uint256.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <primitives/block.h>
+#include <smartcontracts/analysis.h>
+#include <smartcontracts/snapshot.h>
+#include <smartcontracts/vm.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <test/util/smartcontracts.h>
+#include <uint256.h>
+#include <util/translation.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace smartcontracts;
+
+static uint256 Word(uint64_t n)
+{
+    return ArithToUint256(arith_uint256(n));
+}
+
+BOOST_FIXTURE_TEST_SUITE(smartcontract_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(script_analysis)
+{
+    // PUSH 5, SLOAD, PUSH 7, KECCAK256, SLOAD, SSTORE
+    const std::vector<uint8_t> code{0x01, 0x05, OP_SLOAD, 0x01, 0x07, OP_KECCAK256, OP_SLOAD, OP_SSTORE};
+    const auto analysis = AnalyzeContractCode(code, vm::VM_TYPE_BITCOIN_SCRIPT);
+    BOOST_REQUIRE(analysis->valid);
+    BOOST_CHECK(analysis->code_hash == ComputeCodeHash(code));
+
+    // Both SLOADs are fused into the instruction before them
+    BOOST_REQUIRE_EQUAL(analysis->instructions.size(), 4U);
+    BOOST_CHECK(analysis->instructions[0].fused == SuperInstruction::PUSH_SLOAD);
+    BOOST_CHECK(analysis->immediates[analysis->instructions[0].immediate] == Word(5));
+    BOOST_CHECK(analysis->instructions[1].fused == SuperInstruction::NONE);
+    BOOST_CHECK(analysis->instructions[2].fused == SuperInstruction::KECCAK256_SLOAD);
+    BOOST_CHECK_EQUAL(analysis->instructions[3].opcode, OP_SSTORE);
+
+    BOOST_REQUIRE_EQUAL(analysis->blocks.size(), 1U);
+    const BasicBlock& block = analysis->blocks[0];
+    BOOST_CHECK_EQUAL(block.stack_required, 0U);
+    BOOST_CHECK_EQUAL(block.stack_max_growth, 2U);
+    uint64_t gas = 0;
+    for (uint8_t opcode : std::vector<uint8_t>{0x01, OP_SLOAD, 0x01, OP_KECCAK256, OP_SLOAD, OP_SSTORE}) {
+        gas += CalculateGasCost(opcode, {});
+    }
+    BOOST_CHECK_EQUAL(block.static_gas, gas);
+
+    BOOST_CHECK_EQUAL(AnalyzeContractCode(std::vector<uint8_t>{OP_SSTORE}, vm::VM_TYPE_BITCOIN_SCRIPT)->blocks[0].stack_required, 2U);
+
+    // Push data must be complete and fit in a stack word
+    BOOST_CHECK(AnalyzeContractCode(std::vector<uint8_t>{0x4c, 0x02, 0xaa, 0xbb}, vm::VM_TYPE_BITCOIN_SCRIPT)->valid);
+    BOOST_CHECK(!AnalyzeContractCode(std::vector<uint8_t>{0x02, 0xaa}, vm::VM_TYPE_BITCOIN_SCRIPT)->valid);
+    BOOST_CHECK(!AnalyzeContractCode(std::vector<uint8_t>{0x4d, 0x01}, vm::VM_TYPE_BITCOIN_SCRIPT)->valid);
+    std::vector<uint8_t> long_push(34, 0xaa);
+    long_push[0] = 33;
+    BOOST_CHECK(!AnalyzeContractCode(long_push, vm::VM_TYPE_BITCOIN_SCRIPT)->valid);
+    BOOST_CHECK(!AnalyzeContractCode(std::vector<uint8_t>{}, vm::VM_TYPE_BITCOIN_SCRIPT)->valid);
+}
+
+BOOST_AUTO_TEST_CASE(evm_jump_destinations)
+{
+    // PUSH1 4, JUMP, STOP, JUMPDEST, STOP
+    const auto analysis = AnalyzeContractCode(std::vector<uint8_t>{0x60, 0x04, 0x56, 0x00, 0x5b, 0x00}, vm::VM_TYPE_EVM_COMPATIBLE);
+    BOOST_REQUIRE(analysis->valid);
+    BOOST_CHECK(analysis->jump_destinations[4]);
+    BOOST_REQUIRE_EQUAL(analysis->blocks.size(), 3U);
+    BOOST_CHECK_EQUAL(analysis->blocks[0].end, 2U);
+    BOOST_CHECK_EQUAL(analysis->blocks[0].stack_required, 0U);
+    BOOST_CHECK_EQUAL(analysis->blocks[0].stack_max_growth, 1U);
+    BOOST_CHECK_EQUAL(analysis->blocks[2].begin, 3U);
+
+    // Static jump to an instruction that is not a JUMPDEST
+    BOOST_CHECK(!AnalyzeContractCode(std::vector<uint8_t>{0x60, 0x03, 0x56, 0x00, 0x5b}, vm::VM_TYPE_EVM_COMPATIBLE)->valid);
+    // 0x5b inside PUSH2 data is not a jump destination
+    BOOST_CHECK(!AnalyzeContractCode(std::vector<uint8_t>{0x61, 0x5b, 0x00, 0x60, 0x01, 0x57}, vm::VM_TYPE_EVM_COMPATIBLE)->valid);
+    // Jump past the end of the code
+    BOOST_CHECK(!AnalyzeContractCode(std::vector<uint8_t>{0x61, 0x01, 0x00, 0x56}, vm::VM_TYPE_EVM_COMPATIBLE)->valid);
+}
+
+BOOST_AUTO_TEST_CASE(analysis_cache_lru)
+{
+    const std::vector<uint8_t> code_a{0x01, 0x0a}, code_b{0x01, 0x0b}, code_c{0x01, 0x0c};
+    const auto a = AnalyzeContractCode(code_a, vm::VM_TYPE_BITCOIN_SCRIPT);
+    const auto b = AnalyzeContractCode(code_b, vm::VM_TYPE_BITCOIN_SCRIPT);
+    const auto c = AnalyzeContractCode(code_c, vm::VM_TYPE_BITCOIN_SCRIPT);
+
+    // Room for two entries
+    CodeAnalysisCache cache(a->MemoryUsage() + b->MemoryUsage() + c->MemoryUsage() / 2);
+    cache.Insert(a);
+    cache.Insert(b);
+    BOOST_CHECK(cache.Get(a->code_hash, vm::VM_TYPE_BITCOIN_SCRIPT) == a);
+    BOOST_CHECK(!cache.Get(a->code_hash, vm::VM_TYPE_EVM_COMPATIBLE));
+
+    // b is now least recently used
+    cache.Insert(c);
+    BOOST_CHECK_EQUAL(cache.Size(), 2U);
+    BOOST_CHECK(!cache.Get(b->code_hash, vm::VM_TYPE_BITCOIN_SCRIPT));
+    BOOST_CHECK(cache.Get(a->code_hash, vm::VM_TYPE_BITCOIN_SCRIPT) == a);
+    BOOST_CHECK(cache.Get(c->code_hash, vm::VM_TYPE_BITCOIN_SCRIPT) == c);
+
+    // A miss analyses once, later lookups share the result
+    const auto b2 = cache.GetOrAnalyze(b->code_hash, code_b, vm::VM_TYPE_BITCOIN_SCRIPT);
+    BOOST_CHECK(b2->valid);
+    BOOST_CHECK(cache.GetOrAnalyze(b->code_hash, code_b, vm::VM_TYPE_BITCOIN_SCRIPT) == b2);
+    BOOST_CHECK_LE(cache.MemoryUsage(), a->MemoryUsage() + b->MemoryUsage() + c->MemoryUsage() / 2);
+}
+
+BOOST_AUTO_TEST_CASE(execute_analyzed_script)
+{
+    InitializeSmartContractVM(Params().GetConsensus());
+
+    // SSTORE(1, 42); SSTORE(2, SLOAD(1))
+    ContractState state;
+    state.contract_address = Word(0xc0de);
+    state.vm_type = vm::VM_TYPE_BITCOIN_SCRIPT;
+    state.code = {0x01, 0x01, 0x01, 0x2a, OP_SSTORE, 0x01, 0x02, 0x01, 0x01, OP_SLOAD, OP_SSTORE};
+    BOOST_REQUIRE(UpdateContractState(state.contract_address, state));
+
+    ExecutionContext context;
+    context.contract_address = state.contract_address;
+    context.gas_limit = vm::MAX_GAS_LIMIT;
+    ExecutionResult result = ExecuteContract(state.contract_address, context);
+    BOOST_CHECK_EQUAL(result.result_code, CONTRACT_SUCCESS);
+    BOOST_CHECK_EQUAL(result.gas_used, GetCodeAnalysisCache().Get(ComputeCodeHash(state.code), vm::VM_TYPE_BITCOIN_SCRIPT)->blocks[0].static_gas);
+    BOOST_CHECK(GetContractState(state.contract_address).storage[Word(2)] == Word(42));
+
+    // Gas is charged for a whole block on entry
+    context.gas_limit = result.gas_used;
+    BOOST_CHECK_EQUAL(ExecuteContract(state.contract_address, context).result_code, CONTRACT_SUCCESS);
+    context.gas_limit = result.gas_used - 1;
+    BOOST_CHECK_EQUAL(ExecuteContract(state.contract_address, context).result_code, CONTRACT_OUT_OF_GAS);
+
+    // Stack underflow is caught on block entry
+    context.gas_limit = vm::MAX_GAS_LIMIT;
+    state.code = {0x01, 0x01, OP_SSTORE};
+    BOOST_REQUIRE(UpdateContractState(state.contract_address, state));
+    BOOST_CHECK_EQUAL(ExecuteContract(state.contract_address, context).result_code, CONTRACT_EXECUTION_ERROR);
+}
+
+BOOST_AUTO_TEST_CASE(script_events)
+{
+    InitializeSmartContractVM(Params().GetConsensus());
+    BOOST_CHECK_EQUAL(AnalyzeContractCode(std::vector<uint8_t>{OP_LOG2}, vm::VM_TYPE_BITCOIN_SCRIPT)->blocks[0].stack_required, 3U);
+    BOOST_CHECK_LT(CalculateGasCost(OP_LOG0, {}), CalculateGasCost(OP_LOG4, {}));
+
+    // LOG2(7, topics 1 and 2); LOG0(9)
+    ContractState state;
+    state.contract_address = Word(0xe7e7);
+    state.vm_type = vm::VM_TYPE_BITCOIN_SCRIPT;
+    state.code = {0x01, 0x07, 0x01, 0x01, 0x01, 0x02, OP_LOG2, 0x01, 0x09, OP_LOG0};
+    BOOST_REQUIRE(UpdateContractState(state.contract_address, state));
+
+    ExecutionContext context;
+    context.contract_address = state.contract_address;
+    context.tx_hash = Word(0x7e);
+    context.gas_limit = vm::MAX_GAS_LIMIT;
+    const ExecutionResult result = ExecuteContract(state.contract_address, context);
+    BOOST_CHECK_EQUAL(result.result_code, CONTRACT_SUCCESS);
+    BOOST_REQUIRE_EQUAL(result.logs.size(), 2U);
+    BOOST_CHECK(result.logs[0].contract_address == state.contract_address);
+    BOOST_CHECK(result.logs[0].tx_hash == context.tx_hash);
+    BOOST_CHECK(result.logs[0].topics == std::vector<uint256>({Word(1), Word(2)}));
+    BOOST_CHECK(result.logs[0].data == ToByteVector(Word(7)));
+    BOOST_CHECK(result.logs[1].topics.empty());
+    BOOST_CHECK(result.logs[1].data == ToByteVector(Word(9)));
+
+    // Events of a failed execution are dropped
+    context.gas_limit = result.gas_used - 1;
+    const ExecutionResult failed = ExecuteContract(state.contract_address, context);
+    BOOST_CHECK_EQUAL(failed.result_code, CONTRACT_OUT_OF_GAS);
+    BOOST_CHECK(failed.logs.empty());
+}
+
+static CTransactionRef MakeContractCallTx(const ContractCall& call, uint64_t nonce)
+{
+    CMutableTransaction tx;
+    tx.vin.emplace_back(COutPoint(Txid::FromUint256(Word(nonce)), 0));
+    tx.vout.emplace_back(0, BuildContractCallScript(call));
+    return MakeTransactionRef(std::move(tx));
+}
+
+BOOST_AUTO_TEST_CASE(block_contract_calls)
+{
+    InitializeSmartContractVM(Params().GetConsensus());
+    MemoryContractReceiptStore::ReceiptMap stored;
+    SetContractReceiptStore(std::make_unique<MemoryContractReceiptStore>(stored));
+    PublishContractStateSnapshot(0, Word(0));
+    const uint256 genesis_root = GetContractStateRoot();
+
+    // Calls longer than a script push are split across pushes
+    ContractCall deploy;
+    deploy.kind = ContractCall::DEPLOY;
+    deploy.gas_limit = vm::MAX_GAS_LIMIT;
+    deploy.data = std::vector<uint8_t>(600, 0x5b);
+    const CTransactionRef deploy_tx = MakeContractCallTx(deploy, 1);
+    ContractCall decoded;
+    BOOST_REQUIRE(DecodeContractCall(*deploy_tx, decoded));
+    BOOST_CHECK(decoded.data == deploy.data);
+    CMutableTransaction truncated{*deploy_tx};
+    truncated.vout[0].scriptPubKey.resize(truncated.vout[0].scriptPubKey.size() - 1);
+    BOOST_CHECK(!DecodeContractCall(CTransaction{truncated}, decoded));
+
+    CMutableTransaction plain_tx;
+    plain_tx.vin.emplace_back(COutPoint(Txid::FromUint256(Word(2)), 0));
+    plain_tx.vout.emplace_back(1, CScript() << OP_TRUE);
+
+    // Only transactions that carry a call get a receipt
+    CBlock block;
+    block.vtx = {MakeTransactionRef(plain_tx), deploy_tx};
+    BOOST_REQUIRE(ConnectBlockContracts(block, 1, Word(1)));
+    auto receipts = GetBlockContractReceipts(Word(1));
+    BOOST_REQUIRE(receipts && receipts->size() == 1);
+    BOOST_CHECK_EQUAL((*receipts)[0].result_code, CONTRACT_SUCCESS);
+    BOOST_CHECK((*receipts)[0].tx_hash == deploy_tx->GetHash().ToUint256());
+    const uint256 address = (*receipts)[0].contract_address;
+    BOOST_CHECK(GetContractState(address).code == deploy.data);
+
+    ContractCall call;
+    call.contract_address = address;
+    call.gas_limit = vm::MAX_GAS_LIMIT;
+    call.data = {0x01};
+    ContractCall missing_call{call};
+    missing_call.contract_address = Word(0xdead);
+    block.vtx = {MakeContractCallTx(call, 3), MakeContractCallTx(missing_call, 4)};
+    BOOST_REQUIRE(ConnectBlockContracts(block, 2, Word(2)));
+    receipts = GetBlockContractReceipts(Word(2));
+    BOOST_REQUIRE(receipts && receipts->size() == 2);
+    for (const auto& receipt : *receipts) {
+        BOOST_CHECK_EQUAL(receipt.result_code, receipt.contract_address == address ? CONTRACT_SUCCESS : CONTRACT_EXECUTION_ERROR);
+    }
+
+    // Blocks without calls store nothing, but still get a snapshot
+    block.vtx = {MakeTransactionRef(plain_tx)};
+    BOOST_REQUIRE(ConnectBlockContracts(block, 3, Word(3)));
+    BOOST_CHECK(!GetBlockContractReceipts(Word(3)));
+    BOOST_CHECK(GetContractStateSnapshot(3));
+
+    // Disconnecting restores the state at the parent block
+    BOOST_CHECK(!DisconnectBlockContracts(3, Word(20)));
+    BOOST_CHECK(DisconnectBlockContracts(2, Word(1)));
+    BOOST_CHECK(!GetContractStateSnapshot(2));
+    BOOST_CHECK(DisconnectBlockContracts(1, Word(0)));
+    BOOST_CHECK(GetContractState(address).code.empty());
+    BOOST_CHECK(GetContractStateRoot() == genesis_root);
+
+    SetContractReceiptStore(nullptr);
+}
+
+/** Mine a block with a transaction that deploys a contract, spending coinbase i */
+static void MineContractDeploy(TestChain100Setup& setup, int i)
+{
+    const CScript coinbase_script = CScript() << ToByteVector(setup.coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    ContractCall call;
+    call.kind = ContractCall::DEPLOY;
+    call.gas_limit = vm::MAX_GAS_LIMIT;
+    call.data = {0x5b, uint8_t(i)};
+    const CTransactionRef& coinbase = setup.m_coinbase_txns[i];
+    const CMutableTransaction tx = setup.CreateValidMempoolTransaction(
+        {coinbase}, {COutPoint(coinbase->GetHash(), 0)}, /*input_height=*/i + 1, {setup.coinbaseKey},
+        {CTxOut(0, BuildContractCallScript(call)), CTxOut(coinbase->vout[0].nValue - 10000, coinbase_script)}, /*submit=*/false);
+    setup.CreateAndProcessBlock({tx}, coinbase_script);
+}
+
+BOOST_FIXTURE_TEST_CASE(contract_state_replay, TestChain100Setup)
+{
+    InitializeSmartContractVM(Params().GetConsensus());
+    MemoryContractReceiptStore::ReceiptMap stored;
+    SetContractReceiptStore(std::make_unique<MemoryContractReceiptStore>(stored));
+    ChainstateManager& chainman{*Assert(m_node.chainman)};
+
+    // Blocks 101 and 102 each deploy a contract
+    std::vector<uint256> roots;
+    for (int i = 0; i < 2; ++i) {
+        MineContractDeploy(*this, i);
+        roots.push_back(GetContractStateRoot());
+    }
+    BOOST_CHECK_EQUAL(GetAllContractStates().size(), 2U);
+
+    // The state is kept in memory only, and startup rebuilds it from the blocks
+    InitializeSmartContractVM(Params().GetConsensus());
+    BOOST_CHECK(GetAllContractStates().empty());
+    {
+        LOCK(cs_main);
+        BOOST_REQUIRE(chainman.ActiveChainstate().ReplayContractBlocks(/*base=*/nullptr, *chainman.ActiveTip()));
+    }
+    BOOST_CHECK(GetContractStateRoot() == roots[1]);
+    BOOST_CHECK(GetContractStateSnapshot(102));
+
+    // Disconnecting a block whose parent has no snapshot rebuilds the state too
+    InitializeSmartContractVM(Params().GetConsensus());
+    CBlockIndex* tip{WITH_LOCK(cs_main, return chainman.ActiveTip())};
+    BlockValidationState state;
+    BOOST_REQUIRE(chainman.ActiveChainstate().InvalidateBlock(state, tip));
+    BOOST_CHECK_EQUAL(GetAllContractStates().size(), 1U);
+    BOOST_CHECK(GetContractStateRoot() == roots[0]);
+
+    SetContractReceiptStore(nullptr);
+}
+
+BOOST_FIXTURE_TEST_CASE(contract_snapshot_startup_load, TestChain100Setup)
+{
+    InitializeSmartContractVM(Params().GetConsensus());
+    MemoryContractReceiptStore::ReceiptMap stored;
+    SetContractReceiptStore(std::make_unique<MemoryContractReceiptStore>(stored));
+    ChainstateManager& chainman{*Assert(m_node.chainman)};
+
+    // Blocks 101 and 102 each deploy a contract, up to the regtest contract
+    // snapshot at height 110
+    MineContractDeploy(*this, 0);
+    MineContractDeploy(*this, 1);
+    while (WITH_LOCK(cs_main, return chainman.ActiveHeight()) < 110) {
+        CreateAndProcessBlock({}, CScript() << OP_TRUE);
+    }
+    const uint256 base_hash{WITH_LOCK(cs_main, return chainman.ActiveTip()->GetBlockHash())};
+    const auto trusted{Params().ContractSnapshotForBlockhash(base_hash)};
+    BOOST_REQUIRE(trusted);
+    BOOST_CHECK_EQUAL(trusted->height, 110);
+
+    const auto write = [&](const fs::path& path, int height, const uint256& block_hash) {
+        AutoFile file{fsbridge::fopen(path, "wb")};
+        const ContractSnapshotMetadata metadata = WriteContractSnapshot(file, *Assert(GetContractStateSnapshot(height)), block_hash);
+        BOOST_REQUIRE_EQUAL(file.fclose(), 0);
+        return metadata;
+    };
+    const fs::path path = m_path_root / "contracts.dat";
+    BOOST_CHECK(write(path, 110, base_hash).m_state_commitment == trusted->state_commitment);
+
+    // A block after the snapshot deploys a third contract
+    MineContractDeploy(*this, 2);
+    const uint256 root = GetContractStateRoot();
+    BOOST_CHECK_EQUAL(GetAllContractStates().size(), 3U);
+
+    // Loading at startup restores the snapshot and executes the later block
+    InitializeSmartContractVM(Params().GetConsensus());
+    {
+        AutoFile file{fsbridge::fopen(path, "rb")};
+        const auto result{chainman.ActivateContractSnapshot(file, /*num_threads=*/2)};
+        BOOST_REQUIRE_MESSAGE(result, util::ErrorString(result).original);
+    }
+    BOOST_CHECK_EQUAL(GetAllContractStates().size(), 3U);
+    BOOST_CHECK(GetContractStateRoot() == root);
+    BOOST_CHECK(GetContractStateSnapshot(110));
+
+    // Snapshots at other blocks are not recognized
+    const fs::path tip_path = m_path_root / "contracts_tip.dat";
+    write(tip_path, 111, WITH_LOCK(cs_main, return chainman.ActiveTip()->GetBlockHash()));
+    {
+        AutoFile file{fsbridge::fopen(tip_path, "rb")};
+        const auto result{chainman.ActivateContractSnapshot(file, /*num_threads=*/2)};
+        BOOST_REQUIRE(!result);
+        BOOST_CHECK(util::ErrorString(result).original.find("not recognized") != std::string::npos);
+    }
+    BOOST_CHECK(GetContractStateRoot() == root);
+
+    SetContractReceiptStore(nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(simulate_on_snapshot)
+{
+    InitializeSmartContractVM(Params().GetConsensus());
+
+    // SSTORE(1, 42); SSTORE(2, SLOAD(1))
+    ContractState state;
+    state.contract_address = Word(0xc0de);
+    state.code = {0x01, 0x01, 0x01, 0x2a, OP_SSTORE, 0x01, 0x02, 0x01, 0x01, OP_SLOAD, OP_SSTORE};
+    state.storage[Word(1)] = Word(7);
+    BOOST_REQUIRE(UpdateContractState(state.contract_address, state));
+
+    const auto snapshot = GetContractStateSnapshot();
+    BOOST_CHECK(GetContractStateSnapshot() == snapshot);
+    PublishContractStateSnapshot(10, Word(10));
+
+    ExecutionContext context;
+    context.contract_address = state.contract_address;
+    context.gas_limit = vm::MAX_GAS_LIMIT;
+
+    // The call sees its own writes, which are then discarded
+    const ExecutionResult result = SimulateContractCall(*snapshot, state.contract_address, context);
+    BOOST_CHECK_EQUAL(result.result_code, CONTRACT_SUCCESS);
+    BOOST_CHECK_GT(result.gas_used, 0U);
+    BOOST_CHECK(GetContractState(state.contract_address).storage[Word(1)] == Word(7));
+    BOOST_CHECK(!GetContractState(state.contract_address).storage.count(Word(2)));
+    BOOST_CHECK_EQUAL(GetContractExecutionStats().total_executions, 0U);
+
+    // Executing for real copies the contract instead of changing the snapshot
+    BOOST_CHECK_EQUAL(ExecuteContract(state.contract_address, context).result_code, CONTRACT_SUCCESS);
+    BOOST_CHECK(GetContractState(state.contract_address).storage[Word(2)] == Word(42));
+    BOOST_CHECK(snapshot->Find(state.contract_address)->storage.at(Word(1)) == Word(7));
+    BOOST_CHECK(snapshot->Find(state.contract_address)->storage.IsPageShared(Word(1)));
+    BOOST_CHECK(GetContractStateSnapshot() != snapshot);
+
+    const auto block_snapshot = GetContractStateSnapshot(10);
+    BOOST_REQUIRE(block_snapshot);
+    BOOST_CHECK(block_snapshot->block_hash == Word(10));
+    BOOST_CHECK(!block_snapshot->Find(state.contract_address)->storage.count(Word(2)));
+    BOOST_CHECK(!GetContractStateSnapshot(11));
+
+    // A reorg replaces the snapshots from the fork height
+    PublishContractStateSnapshot(11, Word(11));
+    PublishContractStateSnapshot(10, Word(100));
+    BOOST_CHECK(GetContractStateSnapshot(10)->block_hash == Word(100));
+    BOOST_CHECK(!GetContractStateSnapshot(11));
+
+    // Calls on other threads run alongside state changes
+    std::atomic<int> successes{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&] {
+            for (int j = 0; j < 100; ++j) {
+                if (SimulateContractCall(*snapshot, state.contract_address, context).result_code == CONTRACT_SUCCESS) ++successes;
+            }
+        });
+    }
+    for (uint64_t i = 0; i < 100; ++i) {
+        StoreContractStorage(state.contract_address, Word(i), Word(i));
+    }
+    for (auto& thread : threads) thread.join();
+    BOOST_CHECK_EQUAL(successes, 400);
+    BOOST_CHECK(snapshot->Find(state.contract_address)->storage.size() == 1);
+
+    BOOST_CHECK_EQUAL(SimulateContractCall(*snapshot, Word(1), context).result_code, CONTRACT_EXECUTION_ERROR);
+}
+
+BOOST_AUTO_TEST_CASE(contract_storage_pages)
+{
+    ContractStorage storage;
+    std::map<uint256, uint256> expected;
+    for (uint64_t i = 0; i < 1000; ++i) {
+        storage[Word(i * 7)] = Word(i);
+        expected[Word(i * 7)] = Word(i);
+    }
+    BOOST_CHECK_EQUAL(storage.size(), expected.size());
+    BOOST_CHECK(std::equal(storage.begin(), storage.end(), expected.begin(), expected.end()));
+
+    // A copy shares every page until one is written
+    ContractStorage copy{storage};
+    BOOST_CHECK(copy == storage);
+    BOOST_CHECK(copy.IsPageShared(Word(1)) && copy.IsPageShared(Word(2)));
+    copy[Word(1)] = Word(42);
+    BOOST_CHECK(!copy.IsPageShared(Word(1)));
+    BOOST_CHECK(copy.IsPageShared(Word(2)));
+    BOOST_CHECK(!storage.count(Word(1)));
+    BOOST_CHECK(copy.at(Word(1)) == Word(42));
+    BOOST_CHECK_EQUAL(copy.size(), storage.size() + 1);
+
+    // Erasing an absent key leaves the page shared, and emptied pages are dropped
+    BOOST_CHECK_EQUAL(copy.erase(Word(2)), 0U);
+    BOOST_CHECK(copy.IsPageShared(Word(2)));
+    BOOST_CHECK_EQUAL(copy.erase(Word(1)), 1U);
+    BOOST_CHECK(copy == storage);
+    BOOST_CHECK_EQUAL(copy.erase(Word(0)), 1U);
+    BOOST_CHECK(copy.find(Word(0)) == copy.end());
+    BOOST_CHECK(storage.at(Word(0)) == Word(0));
+    BOOST_CHECK_THROW(copy.at(Word(0)), std::out_of_range);
+
+    copy.clear();
+    BOOST_CHECK(copy.empty() && copy.begin() == copy.end());
+    BOOST_CHECK(!storage.IsPageShared(Word(2)));
+}
+
+BOOST_AUTO_TEST_CASE(contract_state_compression)
+{
+    ContractState state;
+    state.contract_address = Word(0xc0de);
+    state.code = {0x01, 0x2a, OP_SLOAD};
+    state.storage[Word(1)] = Word(0x1234);
+    state.storage[ArithToUint256(~arith_uint256())] = ArithToUint256(~arith_uint256());
+    state.balance = 0x123456789;
+    state.nonce = 300;
+    state.vm_type = vm::VM_TYPE_EVM_COMPATIBLE;
+    state.is_active = false;
+
+    const ContractState decompressed = DecompressContractState(CompressContractState(state));
+    BOOST_CHECK(decompressed.contract_address == state.contract_address);
+    BOOST_CHECK(decompressed.code == state.code);
+    BOOST_CHECK(decompressed.code_hash == ComputeCodeHash(state.code));
+    BOOST_CHECK(decompressed.storage == state.storage);
+    BOOST_CHECK_EQUAL(decompressed.balance, state.balance);
+    BOOST_CHECK_EQUAL(decompressed.nonce, state.nonce);
+    BOOST_CHECK_EQUAL(decompressed.vm_type, state.vm_type);
+    BOOST_CHECK_EQUAL(decompressed.is_active, state.is_active);
+
+    // Small storage words take two bytes each
+    state.storage.erase(ArithToUint256(~arith_uint256()));
+    BOOST_CHECK_EQUAL(CompressContractState(state).size(), 32U + 4 + 5 + 2 + 1 + 1 + 1 + 2 + 3);
+}
+
+BOOST_AUTO_TEST_CASE(contract_state_snapshot)
+{
+    InitializeSmartContractVM(Params().GetConsensus());
+
+    // Enough contracts for several record batches, sharing two codes
+    const uint64_t contract_count = 2 * CONTRACT_SNAPSHOT_BATCH_SIZE + 3;
+    for (uint64_t i = 1; i <= contract_count; ++i) {
+        ContractState state;
+        state.contract_address = Word(i);
+        state.code = {0x01, uint8_t(i % 2), OP_SLOAD};
+        state.balance = i * 1000;
+        state.storage[Word(i)] = Word(i * i);
+        BOOST_REQUIRE(UpdateContractState(state.contract_address, state));
+    }
+    const auto states = GetAllContractStates();
+    const uint256 commitment = ComputeContractStateCommitment(states);
+
+    const fs::path path = m_path_root / "contracts.dat";
+    {
+        AutoFile file{fsbridge::fopen(path, "wb")};
+        const ContractSnapshotMetadata metadata = WriteContractSnapshot(file, *GetContractStateSnapshot(), Word(42));
+        BOOST_CHECK_EQUAL(metadata.m_code_count, 2U);
+        BOOST_CHECK_EQUAL(metadata.m_contract_count, contract_count);
+        BOOST_CHECK(metadata.m_state_commitment == commitment);
+        BOOST_REQUIRE_EQUAL(file.fclose(), 0);
+    }
+
+    const auto load = [&](const uint256& trusted_commitment) {
+        AutoFile file{fsbridge::fopen(path, "rb")};
+        ContractSnapshotMetadata metadata;
+        file >> metadata;
+        BOOST_CHECK(metadata.m_base_blockhash == Word(42));
+        return bool{LoadContractSnapshot(file, metadata, trusted_commitment, /*num_threads=*/2)};
+    };
+
+    // Only a snapshot with the trusted commitment is loaded
+    InitializeSmartContractVM(Params().GetConsensus());
+    BOOST_CHECK(!load(Word(1)));
+    BOOST_CHECK(GetAllContractStates().empty());
+    BOOST_REQUIRE(load(commitment));
+    const auto loaded = GetAllContractStates();
+    BOOST_CHECK(ComputeContractStateCommitment(loaded) == commitment);
+    BOOST_REQUIRE_EQUAL(loaded.size(), contract_count);
+    BOOST_CHECK(loaded.at(Word(3)).storage.at(Word(3)) == Word(9));
+    BOOST_CHECK(loaded.at(Word(3)).code == states.at(Word(3)).code);
+    BOOST_CHECK_EQUAL(GetContractExecutionStats().total_contracts, contract_count);
+
+    // A modified record no longer matches the commitment
+    std::vector<uint8_t> data;
+    {
+        AutoFile file{fsbridge::fopen(path, "rb")};
+        data.resize(fs::file_size(path));
+        file.read(MakeWritableByteSpan(data));
+    }
+    data.back() ^= 1;
+    {
+        AutoFile file{fsbridge::fopen(path, "wb")};
+        file.write(MakeByteSpan(data));
+    }
+    InitializeSmartContractVM(Params().GetConsensus());
+    BOOST_CHECK(!load(commitment));
+    BOOST_CHECK(GetAllContractStates().empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
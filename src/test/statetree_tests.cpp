@@ -0,0 +1,179 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <smartcontracts/statetree.h>
+#include <smartcontracts/vm.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+
+#include <map>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace smartcontracts;
+
+static uint256 BuildRoot(const std::map<uint256, uint256>& values)
+{
+    StateTree tree;
+    tree.Apply({values.begin(), values.end()});
+    return tree.GetRoot();
+}
+
+BOOST_FIXTURE_TEST_SUITE(statetree_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(incremental_updates)
+{
+    StateTree tree;
+    BOOST_CHECK(tree.GetRoot().IsNull());
+
+    // Random inserts, overwrites and removals in batches of varying size
+    std::map<uint256, uint256> values;
+    std::vector<uint256> keys;
+    for (int round = 0; round < 50; ++round) {
+        std::vector<StateTree::Update> updates;
+        const int count = m_rng.randrange(40);
+        for (int i = 0; i < count; ++i) {
+            uint256 key;
+            if (!keys.empty() && m_rng.randbool()) {
+                key = keys[m_rng.randrange(keys.size())];
+            } else {
+                key = m_rng.rand256();
+                keys.push_back(key);
+            }
+            const uint256 value = m_rng.randrange(3) == 0 ? uint256() : m_rng.rand256();
+            updates.emplace_back(key, value);
+            if (value.IsNull()) {
+                values.erase(key);
+            } else {
+                values[key] = value;
+            }
+        }
+        tree.Apply(updates);
+        BOOST_CHECK_EQUAL(tree.size(), values.size());
+        BOOST_CHECK(tree.GetRoot() == BuildRoot(values));
+    }
+    BOOST_CHECK(!tree.GetRoot().IsNull());
+
+    // Removing every key empties the tree
+    std::vector<StateTree::Update> removals;
+    for (const auto& [key, value] : values) {
+        removals.emplace_back(key, uint256());
+    }
+    tree.Apply(removals);
+    BOOST_CHECK_EQUAL(tree.size(), 0U);
+    BOOST_CHECK(tree.GetRoot().IsNull());
+}
+
+BOOST_AUTO_TEST_CASE(batched_trees)
+{
+    std::vector<StateTree::Update> first, second;
+    for (int i = 0; i < 100; ++i) {
+        first.emplace_back(m_rng.rand256(), m_rng.rand256());
+        second.emplace_back(m_rng.rand256(), m_rng.rand256());
+    }
+
+    StateTree a, b, c, d;
+    StateTree::ApplyAll({{&a, first}, {&b, second}});
+    c.Apply(first);
+    d.Apply(second);
+    BOOST_CHECK(a.GetRoot() == c.GetRoot());
+    BOOST_CHECK(b.GetRoot() == d.GetRoot());
+    BOOST_CHECK(a.GetRoot() != b.GetRoot());
+}
+
+BOOST_AUTO_TEST_CASE(proofs)
+{
+    StateTree tree;
+    const uint256 absent = m_rng.rand256();
+    BOOST_CHECK(VerifyStateTreeProof(tree.GetRoot(), absent, uint256(), tree.GetProof(absent)));
+
+    // A tree of one leaf
+    const uint256 first = m_rng.rand256();
+    tree.Apply({{first, uint256::ONE}});
+    BOOST_CHECK(VerifyStateTreeProof(tree.GetRoot(), first, uint256::ONE, tree.GetProof(first)));
+    BOOST_CHECK(VerifyStateTreeProof(tree.GetRoot(), absent, uint256(), tree.GetProof(absent)));
+
+    std::vector<StateTree::Update> updates;
+    for (int i = 0; i < 1000; ++i) {
+        updates.emplace_back(m_rng.rand256(), m_rng.rand256());
+    }
+    tree.Apply(updates);
+    const uint256 root = tree.GetRoot();
+
+    for (int i = 0; i < 100; ++i) {
+        const auto& [key, value] = updates[i];
+        const StateTreeProof proof = tree.GetProof(key);
+        BOOST_CHECK(VerifyStateTreeProof(root, key, value, proof));
+        BOOST_CHECK(!VerifyStateTreeProof(root, key, uint256::ONE, proof));
+        BOOST_CHECK(!VerifyStateTreeProof(root, key, uint256(), proof));
+
+        StateTreeProof tampered = proof;
+        tampered.siblings.back() = uint256::ONE;
+        BOOST_CHECK(!VerifyStateTreeProof(root, key, value, tampered));
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        const uint256 key = m_rng.rand256();
+        const StateTreeProof proof = tree.GetProof(key);
+        BOOST_CHECK(VerifyStateTreeProof(root, key, uint256(), proof));
+        BOOST_CHECK(!VerifyStateTreeProof(root, key, uint256::ONE, proof));
+    }
+
+    // An inner node cannot stand in for a leaf in a proof of absence
+    StateTreeProof forged;
+    forged.leaf_key = updates[0].first;
+    forged.leaf_value = updates[0].second;
+    BOOST_CHECK(!VerifyStateTreeProof(root, absent, uint256(), forged));
+}
+
+BOOST_AUTO_TEST_CASE(contract_state_root)
+{
+    InitializeSmartContractVM(Params().GetConsensus());
+    BOOST_CHECK(GetContractStateRoot().IsNull());
+
+    ContractState state;
+    state.contract_address = uint256::ONE;
+    state.code = {0x00};
+    for (int i = 0; i < 100; ++i) {
+        state.storage[m_rng.rand256()] = m_rng.rand256();
+    }
+    BOOST_REQUIRE(UpdateContractState(state.contract_address, state));
+    const uint256 root = GetContractStateRoot();
+    BOOST_CHECK(!root.IsNull());
+    BOOST_CHECK(GetContractStateRoot() == root);
+
+    // Writes move the root, and proofs follow them
+    const uint256 slot = m_rng.rand256();
+    BOOST_REQUIRE(StoreContractStorage(state.contract_address, slot, uint256::ONE));
+    uint256 state_root, value;
+    ContractStorageProof proof;
+    BOOST_REQUIRE(GetContractStorageProof(state.contract_address, slot, state_root, value, proof));
+    BOOST_CHECK(state_root != root);
+    BOOST_CHECK(value == uint256::ONE);
+    BOOST_CHECK(VerifyContractStorageProof(state_root, state.contract_address, slot, value, proof));
+    BOOST_CHECK(!VerifyContractStorageProof(state_root, state.contract_address, slot, uint256(), proof));
+    BOOST_CHECK(!VerifyContractStorageProof(root, state.contract_address, slot, value, proof));
+
+    ContractStorageProof tampered = proof;
+    tampered.balance = 1;
+    BOOST_CHECK(!VerifyContractStorageProof(state_root, state.contract_address, slot, value, tampered));
+
+    // Clearing the slot restores the earlier root
+    BOOST_REQUIRE(StoreContractStorage(state.contract_address, slot, uint256()));
+    BOOST_CHECK(GetContractStateRoot() == root);
+    BOOST_REQUIRE(GetContractStorageProof(state.contract_address, slot, state_root, value, proof));
+    BOOST_CHECK(value.IsNull());
+    BOOST_CHECK(VerifyContractStorageProof(state_root, state.contract_address, slot, value, proof));
+    BOOST_CHECK(!GetContractStorageProof(uint256(), slot, state_root, value, proof));
+
+    // Block snapshots carry the root, and rebuilding gives the same root
+    PublishContractStateSnapshot(1, uint256::ONE);
+    BOOST_CHECK(GetContractStateSnapshot(1)->state_root == root);
+    ReplaceAllContractStates(GetAllContractStates());
+    BOOST_CHECK(GetContractStateRoot() == root);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -355,7 +355,7 @@ TestChain100Setup::TestChain100Setup(
         LOCK(::cs_main);
         assert(
             m_node.chainman->ActiveChain().Tip()->GetBlockHash().ToString() ==
-            "571d80a9967ae599cec0448b0b0ba1cfb606f584d8069bd7166b86854ba7a191");
+            "2f3695ed710e998279fe61a96b0756a5ec40f06ed9f603034e97ecfbc7d9cff2");
     }
 }
 
@@ -0,0 +1,40 @@
+// Copyright (c) 2025 The BitcoinDecentral Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_TEST_UTIL_SMARTCONTRACTS_H
+#define BITCOIN_TEST_UTIL_SMARTCONTRACTS_H
+
+#include <smartcontracts/vm.h>
+#include <uint256.h>
+
+#include <map>
+#include <optional>
+#include <vector>
+
+/** Receipt store backed by a map owned by the test, which can inspect and change it */
+class MemoryContractReceiptStore final : public smartcontracts::ContractReceiptStore
+{
+public:
+    using ReceiptMap = std::map<uint256, std::vector<smartcontracts::ContractReceipt>>;
+
+    explicit MemoryContractReceiptStore(ReceiptMap& receipts) : m_receipts{receipts} {}
+
+    bool WriteReceipts(const uint256& block_hash, const std::vector<smartcontracts::ContractReceipt>& receipts) override
+    {
+        m_receipts[block_hash] = receipts;
+        return true;
+    }
+
+    std::optional<std::vector<smartcontracts::ContractReceipt>> ReadReceipts(const uint256& block_hash) const override
+    {
+        auto it = m_receipts.find(block_hash);
+        if (it == m_receipts.end()) return std::nullopt;
+        return it->second;
+    }
+
+private:
+    ReceiptMap& m_receipts;
+};
+
+#endif // BITCOIN_TEST_UTIL_SMARTCONTRACTS_H
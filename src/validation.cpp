@@ -49,6 +49,8 @@
 #include <script/script.h>
 #include <script/sigcache.h>
 #include <signet.h>
+#include <smartcontracts/snapshot.h>
+#include <smartcontracts/vm.h>
 #include <tinyformat.h>
 #include <txdb.h>
 #include <txmempool.h>
@@ -888,7 +890,8 @@ bool MemPoolAccept::PreChecks(ATMPArgs& args, Workspace& ws)
     }
 
     // Check for non-standard witnesses.
-    if (tx.HasWitness() && m_pool.m_opts.require_standard && !IsWitnessStandard(tx, m_view)) {
+    const bool quantum_active{DeploymentActiveAfter(m_active_chainstate.m_chain.Tip(), m_active_chainstate.m_chainman, Consensus::DEPLOYMENT_QUANTUM)};
+    if (tx.HasWitness() && m_pool.m_opts.require_standard && !IsWitnessStandard(tx, m_view, quantum_active)) {
         return state.Invalid(TxValidationResult::TX_WITNESS_MUTATED, "bad-witness-nonstandard");
     }
 
@@ -2435,6 +2438,11 @@ static unsigned int GetBlockScriptFlags(const CBlockIndex& block_index, const Ch
         flags |= SCRIPT_VERIFY_NULLDUMMY;
     }
 
+    // Enforce post-quantum (ML-DSA) witness v2 spends
+    if (DeploymentActiveAt(block_index, chainman, Consensus::DEPLOYMENT_QUANTUM)) {
+        flags |= SCRIPT_VERIFY_QUANTUM;
+    }
+
     return flags;
 }
 
@@ -3108,6 +3116,17 @@ bool Chainstate::DisconnectTip(BlockValidationState& state, DisconnectedBlockTra
         return false;
     }
 
+    // Roll the contract state back with the active chain. Reorgs deeper than
+    // the kept snapshots rebuild it from the blocks instead.
+    if (this == &m_chainman.ActiveChainstate() &&
+        smartcontracts::IsSmartContractActive(pindexDelete->nHeight, m_chainman.GetConsensus()) &&
+        !smartcontracts::DisconnectBlockContracts(pindexDelete->nHeight, pindexDelete->pprev->GetBlockHash())) {
+        smartcontracts::InitializeSmartContractVM(m_chainman.GetConsensus());
+        if (!ReplayContractBlocks(/*base=*/nullptr, *pindexDelete->pprev)) {
+            return FatalError(m_chainman.GetNotifications(), state, _("Failed to rebuild the contract state."));
+        }
+    }
+
     if (disconnectpool && m_mempool) {
         // Save transactions to re-add to mempool at end of reorg. If any entries are evicted for
         // exceeding memory limits, remove them and their descendants from the mempool.
@@ -3127,6 +3146,28 @@ bool Chainstate::DisconnectTip(BlockValidationState& state, DisconnectedBlockTra
     return true;
 }
 
+bool Chainstate::ReplayContractBlocks(const CBlockIndex* base, const CBlockIndex& tip)
+{
+    AssertLockHeld(cs_main);
+    const int start_height{std::max(base ? base->nHeight + 1 : 0,
+                                    smartcontracts::GetSmartContractActivationHeight(m_chainman.GetConsensus()))};
+    if (start_height <= tip.nHeight) {
+        LogPrintf("Executing the contract calls of blocks %d to %d\n", start_height, tip.nHeight);
+    }
+    for (int height{start_height}; height <= tip.nHeight; ++height) {
+        const CBlockIndex* pindex{tip.GetAncestor(height)};
+        CBlock block;
+        if (!m_blockman.ReadBlock(block, *pindex)) {
+            LogError("%s: failed to read block %s to execute its contract calls\n", __func__, pindex->GetBlockHash().ToString());
+            return false;
+        }
+        if (!smartcontracts::ConnectBlockContracts(block, height, pindex->GetBlockHash())) {
+            return false;
+        }
+    }
+    return true;
+}
+
 struct PerBlockConnectTrace {
     CBlockIndex* pindex = nullptr;
     std::shared_ptr<const CBlock> pblock;
@@ -3238,6 +3279,13 @@ bool Chainstate::ConnectTip(BlockValidationState& state, CBlockIndex* pindexNew,
              Ticks<MillisecondsDouble>(time_5 - time_4),
              Ticks<SecondsDouble>(m_chainman.time_chainstate),
              Ticks<MillisecondsDouble>(m_chainman.time_chainstate) / m_chainman.num_blocks_total);
+    // Execute the block's contract calls. Only the active chain has a contract
+    // state; a background chainstate revalidates blocks below its tip.
+    if (this == &m_chainman.ActiveChainstate() &&
+        smartcontracts::IsSmartContractActive(pindexNew->nHeight, m_chainman.GetConsensus()) &&
+        !smartcontracts::ConnectBlockContracts(blockConnecting, pindexNew->nHeight, pindexNew->GetBlockHash())) {
+        return FatalError(m_chainman.GetNotifications(), state, _("Failed to write contract receipts."));
+    }
     // Remove conflicting transactions from the mempool.;
     if (m_mempool) {
         m_mempool->removeForBlock(blockConnecting.vtx, pindexNew->nHeight);
@@ -5885,6 +5933,39 @@ util::Result<CBlockIndex*> ChainstateManager::ActivateSnapshot(
     return snapshot_start_block;
 }
 
+util::Result<void> ChainstateManager::ActivateContractSnapshot(AutoFile& file, int num_threads)
+{
+    smartcontracts::ContractSnapshotMetadata metadata;
+    try {
+        file >> metadata;
+    } catch (const std::ios_base::failure& e) {
+        return util::Error{strprintf(_("Unable to read contract state snapshot metadata: %s"), e.what())};
+    }
+
+    const auto trusted{GetParams().ContractSnapshotForBlockhash(metadata.m_base_blockhash)};
+    if (!trusted) {
+        return util::Error{strprintf(_("Contract state snapshot at block %s is not recognized"), metadata.m_base_blockhash.ToString())};
+    }
+
+    LOCK(::cs_main);
+    const CBlockIndex* base{m_blockman.LookupBlockIndex(metadata.m_base_blockhash)};
+    if (!base || !ActiveChain().Contains(base)) {
+        return util::Error{strprintf(_("The base block %s of the contract state snapshot is not in the active chain"), metadata.m_base_blockhash.ToString())};
+    }
+
+    smartcontracts::InitializeSmartContractVM(GetConsensus());
+    if (auto result{smartcontracts::LoadContractSnapshot(file, metadata, trusted->state_commitment, num_threads)}; !result) {
+        return util::Error{util::ErrorString(result)};
+    }
+    smartcontracts::PublishContractStateSnapshot(base->nHeight, base->GetBlockHash());
+
+    // Bring the state up to the tip
+    if (!ActiveChainstate().ReplayContractBlocks(base, *Assert(ActiveTip()))) {
+        return util::Error{_("Failed to execute the contract calls of the blocks after the contract state snapshot.")};
+    }
+    return {};
+}
+
 static void FlushSnapshotToDisk(CCoinsViewCache& coins_cache, bool snapshot_loaded)
 {
     LOG_TIME_MILLIS_WITH_CATEGORY_MSG_ONCE(
@@ -712,6 +712,14 @@ public:
     // Apply the effects of a block disconnection on the UTXO set.
     bool DisconnectTip(BlockValidationState& state, DisconnectedBlockTransactions* disconnectpool) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
 
+    /**
+     * Execute the contract calls of the blocks after base, or of all blocks if
+     * base is null, up to and including tip. The contract state is kept in
+     * memory only, so it is rebuilt this way at startup and after reorgs
+     * deeper than the state snapshots it keeps.
+     */
+    bool ReplayContractBlocks(const CBlockIndex* base, const CBlockIndex& tip) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
     // Manual block validity manipulation:
     /** Mark a block as precious and reorganize.
      *
@@ -1094,6 +1102,14 @@ public:
     [[nodiscard]] util::Result<CBlockIndex*> ActivateSnapshot(
         AutoFile& coins_file, const node::SnapshotMetadata& metadata, bool in_memory);
 
+    //! Replace the contract state with a snapshot written by the
+    //! dumpcontractstate RPC, then execute the contract calls of the blocks
+    //! connected since its base block. The snapshot's commitment must be
+    //! recognized by the chain parameters, and its base block must be in the
+    //! active chain.
+    [[nodiscard]] util::Result<void> ActivateContractSnapshot(AutoFile& file, int num_threads)
+        LOCKS_EXCLUDED(::cs_main);
+
     //! Once the background validation chainstate has reached the height which
     //! is the base of the UTXO snapshot in use, compare its coins to ensure
     //! they match those expected by the snapshot.
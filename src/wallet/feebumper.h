@@ -92,6 +92,7 @@ public:
             break;
         case SigVersion::TAPROOT:
         case SigVersion::TAPSCRIPT:
+        case SigVersion::QUANTUM:
             assert(false);
         }
     }